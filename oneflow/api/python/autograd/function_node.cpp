@@ -43,9 +43,15 @@ ONEFLOW_API_PYBIND11_MODULE("", m) {
       .def("__str__", &FunctionNodeUtil::ToString)
       .def("__repr__", &FunctionNodeUtil::ToString)
       .def("_register_hook_dict", []() { TODO(); })
-      .def_property_readonly(
-          "next_functions",
-          [](const one::FunctionNode& func_node) { return func_node.GetNextFunctions(); })
+      .def_property_readonly("next_functions",
+                             [](const one::FunctionNode& func_node) {
+                               py::list next_functions;
+                               for (const auto& next : func_node.GetNextFunctions()) {
+                                 next_functions.append(
+                                     std::const_pointer_cast<one::FunctionNode>(next));
+                               }
+                               return next_functions;
+                             })
       .def_property_readonly("metadata", []() { TODO(); })
       .def_property_readonly("requires_grad", []() { TODO(); })
       .def("register_hook", []() { TODO(); })
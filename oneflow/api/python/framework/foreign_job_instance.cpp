@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include <pybind11/pybind11.h>
+#include <pybind11/functional.h>
 #include <string>
 #include <memory>
 #include "oneflow/api/python/of_api_registry.h"
@@ -54,6 +55,14 @@ class PyForeignJobInstance : public ForeignJobInstance {
   }
 
   void Finish() const override { PYBIND11_OVERRIDE(void, ForeignJobInstance, Finish, ); }
+
+  uint64_t BorrowInputBuffer(uint64_t ofblob_ptr) const override {
+    PYBIND11_OVERRIDE(uint64_t, ForeignJobInstance, BorrowInputBuffer, ofblob_ptr);
+  }
+
+  bool LendOutputBlob(uint64_t ofblob_ptr, const std::function<void()>& Release) const override {
+    PYBIND11_OVERRIDE(bool, ForeignJobInstance, LendOutputBlob, ofblob_ptr, Release);
+  }
 };
 
 }  // namespace oneflow
@@ -69,5 +78,7 @@ ONEFLOW_API_PYBIND11_MODULE("", m) {
       .def("sole_output_op_name_in_user_job", &ForeignJobInstance::sole_output_op_name_in_user_job)
       .def("PushBlob", &ForeignJobInstance::PushBlob)
       .def("PullBlob", &ForeignJobInstance::PullBlob)
-      .def("Finish", &ForeignJobInstance::Finish);
+      .def("Finish", &ForeignJobInstance::Finish)
+      .def("BorrowInputBuffer", &ForeignJobInstance::BorrowInputBuffer)
+      .def("LendOutputBlob", &ForeignJobInstance::LendOutputBlob);
 }
@@ -26,6 +26,9 @@ ONEFLOW_API_PYBIND11_MODULE("", m) {
   m.def("Ofblob_GetDataType", &Ofblob_GetDataType);
   m.def("OfBlob_NumAxes", &OfBlob_NumAxes);
   m.def("OfBlob_IsDynamic", &OfBlob_IsDynamic);
+  m.def("OfBlob_IsHostMem", &OfBlob_IsHostMem);
+  m.def("OfBlob_ByteSizeOfBody", &OfBlob_ByteSizeOfBody);
+  m.def("OfBlob_HostDptr", &OfBlob_HostDptr);
 
   m.def("OfBlob_CopyShapeTo", &OfBlob_CopyShapeTo);
   m.def("OfBlob_CopyStaticShapeTo", &OfBlob_CopyStaticShapeTo);
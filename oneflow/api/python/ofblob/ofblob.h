@@ -41,6 +41,24 @@ inline bool OfBlob_IsDynamic(uint64_t of_blob_ptr) {
   return of_blob->is_dynamic();
 }
 
+inline bool OfBlob_IsHostMem(uint64_t of_blob_ptr) {
+  using namespace oneflow;
+  auto* of_blob = reinterpret_cast<OfBlob*>(of_blob_ptr);
+  return of_blob->is_host_mem();
+}
+
+inline size_t OfBlob_ByteSizeOfBody(uint64_t of_blob_ptr) {
+  using namespace oneflow;
+  auto* of_blob = reinterpret_cast<OfBlob*>(of_blob_ptr);
+  return of_blob->ByteSizeOfBody();
+}
+
+inline uint64_t OfBlob_HostDptr(uint64_t of_blob_ptr) {
+  using namespace oneflow;
+  auto* of_blob = reinterpret_cast<OfBlob*>(of_blob_ptr);
+  return reinterpret_cast<uint64_t>(of_blob->host_dptr());
+}
+
 inline void OfBlob_CopyShapeFrom(uint64_t of_blob_ptr, py::array_t<int64_t> array) {
   py::buffer_info buf = array.request();
   int64_t* buf_ptr = (int64_t*)buf.ptr;
@@ -0,0 +1,112 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+#include "oneflow/api/python/of_api_registry.h"
+#include "oneflow/core/serving/batching_inference_server.h"
+
+namespace py = pybind11;
+
+namespace oneflow {
+
+namespace {
+
+DataType NumpyDType2DataType(const py::dtype& dtype) {
+  if (dtype.is(py::dtype::of<float>())) { return DataType::kFloat; }
+  if (dtype.is(py::dtype::of<double>())) { return DataType::kDouble; }
+  if (dtype.is(py::dtype::of<int8_t>())) { return DataType::kInt8; }
+  if (dtype.is(py::dtype::of<uint8_t>())) { return DataType::kUInt8; }
+  if (dtype.is(py::dtype::of<int32_t>())) { return DataType::kInt32; }
+  if (dtype.is(py::dtype::of<int64_t>())) { return DataType::kInt64; }
+  UNIMPLEMENTED() << "unsupported numpy dtype " << py::str(dtype).cast<std::string>();
+  return DataType::kInvalidDataType;
+}
+
+py::dtype DataType2NumpyDType(DataType data_type) {
+  switch (data_type) {
+    case DataType::kFloat: return py::dtype::of<float>();
+    case DataType::kDouble: return py::dtype::of<double>();
+    case DataType::kInt8: return py::dtype::of<int8_t>();
+    case DataType::kUInt8: return py::dtype::of<uint8_t>();
+    case DataType::kInt32: return py::dtype::of<int32_t>();
+    case DataType::kInt64: return py::dtype::of<int64_t>();
+    default: UNIMPLEMENTED() << "unsupported data type " << data_type;
+  }
+  return py::dtype();
+}
+
+std::shared_ptr<TensorBuffer> NumpyToTensorBuffer(const py::array& array) {
+  py::array contiguous = py::array::ensure(array, py::array::c_style);
+  CHECK(contiguous) << "input is not convertible to a contiguous array";
+  auto tensor = std::make_shared<TensorBuffer>();
+  DimVector dim_vec(contiguous.shape(), contiguous.shape() + contiguous.ndim());
+  tensor->Resize(Shape(dim_vec), NumpyDType2DataType(contiguous.dtype()));
+  std::memcpy(tensor->mut_data(), contiguous.data(), tensor->nbytes());
+  return tensor;
+}
+
+py::array TensorBufferToNumpy(const TensorBuffer& tensor) {
+  const auto& shape = tensor.shape();
+  std::vector<ssize_t> dims(shape.dim_vec().begin(), shape.dim_vec().end());
+  py::array array(DataType2NumpyDType(tensor.data_type()), dims);
+  std::memcpy(array.mutable_data(), tensor.data(), tensor.nbytes());
+  return array;
+}
+
+}  // namespace
+
+ONEFLOW_API_PYBIND11_MODULE("", m) {
+  py::class_<BatchingInferenceServer, std::shared_ptr<BatchingInferenceServer>>(
+      m, "BatchingInferenceServer")
+      .def(py::init([](const std::string& job_name, int64_t max_batch_size,
+                       int64_t batch_timeout_us) {
+        BatchingInferenceServerConf conf;
+        conf.job_name = job_name;
+        conf.max_batch_size = max_batch_size;
+        conf.batch_timeout_us = batch_timeout_us;
+        return std::make_shared<BatchingInferenceServer>(conf);
+      }))
+      .def("infer",
+           [](BatchingInferenceServer* server, const py::dict& inputs) {
+             ServingTensorMap input_tensors;
+             for (const auto& pair : inputs) {
+               input_tensors.emplace(pair.first.cast<std::string>(),
+                                     NumpyToTensorBuffer(pair.second.cast<py::array>()));
+             }
+             ServingTensorMap output_tensors;
+             {
+               py::gil_scoped_release release;
+               output_tensors = server->Submit(input_tensors).GetOrThrow().get();
+             }
+             py::dict outputs;
+             for (const auto& pair : output_tensors) {
+               outputs[py::str(pair.first)] = TensorBufferToNumpy(*pair.second);
+             }
+             return outputs;
+           })
+      .def("close", &BatchingInferenceServer::Close, py::call_guard<py::gil_scoped_release>())
+      .def("stats", [](const BatchingInferenceServer* server) {
+        const auto stats = server->stats();
+        py::dict ret;
+        ret["num_requests"] = stats.num_requests;
+        ret["num_batches"] = stats.num_batches;
+        ret["num_batched_rows"] = stats.num_batched_rows;
+        return ret;
+      });
+}
+
+}  // namespace oneflow
@@ -678,6 +678,7 @@ int Actor::TryUpdtStateAsProducedRegst(Regst* regst) {
   reading_cnt_it->second -= 1;
   total_reading_cnt_ -= 1;
   if (reading_cnt_it->second != 0) { return 0; }
+  NormalProcessReturnedProducedRegst(regst);
 
   if (inplace_produced_rs_.TryPushBackRegst(regst) == 0) {
     int64_t in_regst_desc_id = inplace_regst_desc_id_out2in_.at(regst->regst_desc_id());
@@ -161,6 +161,8 @@ class Actor {
   // Process Msg
   virtual void NormalProcessNaiveReadableDataRegstMsg(const std::deque<Regst*>&) {}
   virtual bool NormalTryProcessReadableMsgFromOtherMachine(const ActorMsg&) { return false; }
+  // Called when all the consumers have returned a produced regst
+  virtual void NormalProcessReturnedProducedRegst(Regst* regst) {}
   int TryUpdtStateAsProducedRegst(Regst* regst);
 
   // Act
@@ -0,0 +1,111 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/actor/foreign_io_compute_actor.h"
+#include "oneflow/core/actor/actor_message_bus.h"
+
+namespace oneflow {
+
+void ForeignInputCompActor::VirtualCompActorInit(const TaskProto& task_proto) {
+  cur_piece_id_ = -1;
+  OF_SET_MSG_HANDLER(&ForeignInputCompActor::HandlerNormal);
+}
+
+void ForeignInputCompActor::Act() {
+  KernelCtx kernel_ctx = GenDefaultKernelCtx();
+  kernel_ctx.other = &foreign_input_status_;
+  cur_piece_id_ = GetPieceId4NaiveOrInplaceCurReadableDataRegst();
+  AsyncLaunchKernel(kernel_ctx, [&](int64_t regst_desc_id) -> Regst* { return nullptr; });
+}
+
+void ForeignInputCompActor::VirtualAsyncSendNaiveProducedRegstMsgToConsumer() {
+  HandleProducedNaiveDataRegstToConsumer([&](Regst* regst) {
+    regst->set_piece_id(cur_piece_id_);
+    return true;
+  });
+}
+
+void ForeignInputCompActor::VirtualAsyncSendInplaceProducedRegstMsgToConsumer() {
+  HandleProducedInplaceDataRegstToConsumer([&](Regst* regst) {
+    regst->set_piece_id(cur_piece_id_);
+    return true;
+  });
+}
+
+void ForeignInputCompActor::NormalProcessReturnedProducedRegst(Regst* regst) {
+  // The consumers are done with the borrowed buffers, let the blobs point to the regst again
+  auto* blob2regst_dptr = &foreign_input_status_.blob2regst_dptr;
+  FOR_RANGE(int64_t, i, 0, regst->GetBlobSize()) {
+    Blob* blob = regst->GetBlobByOrdinal(i);
+    auto it = blob2regst_dptr->find(blob);
+    if (it == blob2regst_dptr->end()) { continue; }
+    blob->reset_dptr(it->second);
+    blob2regst_dptr->erase(it);
+  }
+}
+
+void ForeignOutputCompActor::VirtualCompActorInit(const TaskProto& task_proto) {
+  CHECK_EQ(exec_kernel_vec().size(), 1);
+  in_regst_desc_id_ = exec_kernel_vec().front().bn_in_op2blob_info.at("in").regst_desc_id;
+  foreign_output_status_.is_in_blob_lent = false;
+  cur_piece_id_ = -1;
+  OF_SET_MSG_HANDLER(&ForeignOutputCompActor::HandlerNormal);
+}
+
+void ForeignOutputCompActor::Act() {
+  KernelCtx kernel_ctx = GenDefaultKernelCtx();
+  cur_piece_id_ = GetPieceId4NaiveOrInplaceCurReadableDataRegst();
+  Regst* in_regst = GetNaiveCurReadable(in_regst_desc_id_);
+  CHECK_NOTNULL(in_regst);
+  const int64_t consumer = actor_id();
+  foreign_output_status_.return_in_regst = [consumer, in_regst]() {
+    Global<ActorMsgBus>::Get()->SendMsg(
+        ActorMsg::BuildRegstMsgToProducer(consumer, in_regst->producer_actor_id(), in_regst));
+  };
+  foreign_output_status_.is_in_blob_lent = false;
+  kernel_ctx.other = &foreign_output_status_;
+  AsyncLaunchKernel(kernel_ctx, [&](int64_t regst_desc_id) -> Regst* { return nullptr; });
+}
+
+void ForeignOutputCompActor::VirtualAsyncSendNaiveProducedRegstMsgToConsumer() {
+  HandleProducedNaiveDataRegstToConsumer([&](Regst* regst) {
+    regst->set_piece_id(cur_piece_id_);
+    return true;
+  });
+}
+
+void ForeignOutputCompActor::VirtualAsyncSendInplaceProducedRegstMsgToConsumer() {
+  HandleProducedInplaceDataRegstToConsumer([&](Regst* regst) {
+    regst->set_piece_id(cur_piece_id_);
+    return true;
+  });
+}
+
+void ForeignOutputCompActor::VirtualAsyncSendNaiveConsumedRegstMsgToProducer() {
+  if (!foreign_output_status_.is_in_blob_lent) {
+    CompActor::VirtualAsyncSendNaiveConsumedRegstMsgToProducer();
+    return;
+  }
+  // The Release of the lent blob returns the "in" regst, which may happen after later acts
+  HandleConsumedNaiveDataRegstToProducer(
+      [&](Regst* regst) { return regst->regst_desc_id() != in_regst_desc_id_; });
+  CHECK_EQ(naive_consumed_rs_.TryPopFrontRegst(in_regst_desc_id_), 0);
+  foreign_output_status_.is_in_blob_lent = false;
+}
+
+REGISTER_ACTOR(TaskType::kForeignInput, ForeignInputCompActor);
+REGISTER_ACTOR(TaskType::kForeignOutput, ForeignOutputCompActor);
+
+}  // namespace oneflow
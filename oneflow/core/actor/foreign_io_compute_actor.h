@@ -0,0 +1,62 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_ACTOR_FOREIGN_IO_COMPUTE_ACTOR_H_
+#define ONEFLOW_CORE_ACTOR_FOREIGN_IO_COMPUTE_ACTOR_H_
+
+#include "oneflow/core/actor/compute_actor.h"
+#include "oneflow/core/kernel/foreign_input_kernel.h"
+#include "oneflow/core/kernel/foreign_output_kernel.h"
+
+namespace oneflow {
+
+class ForeignInputCompActor final : public CompActor {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ForeignInputCompActor);
+  ForeignInputCompActor() = default;
+  ~ForeignInputCompActor() override = default;
+
+ private:
+  void VirtualCompActorInit(const TaskProto&) override;
+  void Act() override;
+  void VirtualAsyncSendNaiveProducedRegstMsgToConsumer() override;
+  void VirtualAsyncSendInplaceProducedRegstMsgToConsumer() override;
+  void NormalProcessReturnedProducedRegst(Regst* regst) override;
+
+  ForeignInputStatus foreign_input_status_;
+  int64_t cur_piece_id_;
+};
+
+class ForeignOutputCompActor final : public CompActor {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ForeignOutputCompActor);
+  ForeignOutputCompActor() = default;
+  ~ForeignOutputCompActor() override = default;
+
+ private:
+  void VirtualCompActorInit(const TaskProto&) override;
+  void Act() override;
+  void VirtualAsyncSendNaiveProducedRegstMsgToConsumer() override;
+  void VirtualAsyncSendInplaceProducedRegstMsgToConsumer() override;
+  void VirtualAsyncSendNaiveConsumedRegstMsgToProducer() override;
+
+  ForeignOutputStatus foreign_output_status_;
+  int64_t in_regst_desc_id_;
+  int64_t cur_piece_id_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_ACTOR_FOREIGN_IO_COMPUTE_ACTOR_H_
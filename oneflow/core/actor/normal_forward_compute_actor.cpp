@@ -43,8 +43,6 @@ void NormalForwardCompActor::VirtualAsyncSendInplaceProducedRegstMsgToConsumer()
 }
 
 REGISTER_ACTOR(TaskType::kNormalForward, NormalForwardCompActor);
-REGISTER_ACTOR(TaskType::kForeignInput, NormalForwardCompActor);
-REGISTER_ACTOR(TaskType::kForeignOutput, NormalForwardCompActor);
 REGISTER_ACTOR(TaskType::kDistributeConcat, NormalForwardCompActor);
 REGISTER_ACTOR(TaskType::kDistributeSplit, NormalForwardCompActor);
 
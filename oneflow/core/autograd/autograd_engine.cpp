@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include <queue>
 #include "oneflow/core/autograd/autograd_engine.h"
 #include "oneflow/core/framework/tensor.h"
 #include "oneflow/core/framework/tensor_arg.h"
@@ -38,6 +39,7 @@ bool IsReadyToRun(const std::vector<std::shared_ptr<AutogradMeta>>& out_meta_dat
 
 Maybe<void> CopyOrAccGrad(AutogradMeta* autograd_meta, bool autograd_mode) {
   autograd::AutoGradMode mode(autograd_mode);
+  if (autograd_meta->now_grad_arg()->Empty()) { return Maybe<void>::Ok(); }
   const auto& now_grad = JUST(autograd_meta->now_grad_arg()->GetAccTensor());
   if (!now_grad) { return Maybe<void>::Ok(); }
   if (autograd_meta->acc_grad()) {
@@ -54,18 +56,18 @@ Maybe<void> CopyOrAccGrad(AutogradMeta* autograd_meta, bool autograd_mode) {
 
 }  // namespace
 
-StackFunctionNode::StackFunctionNode(
+FunctionNode::FunctionNode(
     const std::string& op_type_name,
     const std::shared_ptr<const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>&
         backward_fn,
     const TensorTuple& inputs, const TensorTuple& outputs)
-    : FunctionNode(op_type_name) {
+    : op_name_(op_type_name) {
   input_meta_datas_.resize(inputs.size());
-  next_functions_->reserve(inputs.size());
+  next_functions_.reserve(inputs.size());
   for (int i = 0; i < inputs.size(); ++i) {
     input_meta_datas_.at(i) = inputs.at(i)->mut_autograd_meta();
     if (input_meta_datas_.at(i)->requires_grad()) {
-      next_functions_->emplace_back(inputs.at(i)->grad_fn_node());
+      next_functions_.emplace_back(inputs.at(i)->grad_fn_node());
     }
   }
 
@@ -77,17 +79,16 @@ StackFunctionNode::StackFunctionNode(
   }
 
   backward_fn_ = backward_fn;
-  is_in_stack_ = false;
 }
 
-Maybe<void> StackFunctionNode::AccGrad4RetainGradTensor() {
+Maybe<void> FunctionNode::AccGrad4RetainGradTensor() {
   for (const std::shared_ptr<AutogradMeta>& out : output_meta_datas_) {
     if (out->retain_grad()) { JUST(CopyOrAccGrad(out.get(), /*autograd_mode=*/false)); }
   }
   return Maybe<void>::Ok();
 }
 
-Maybe<void> StackFunctionNode::AccGrad4LeafTensor(bool create_graph) {
+Maybe<void> FunctionNode::AccGrad4LeafTensor(bool create_graph) {
   for (const std::shared_ptr<AutogradMeta>& out : output_meta_datas_) {
     if (out->is_leaf() && out->requires_grad()) {
       JUST(CopyOrAccGrad(out.get(), /*autograd_mode=*/false));
@@ -96,20 +97,19 @@ Maybe<void> StackFunctionNode::AccGrad4LeafTensor(bool create_graph) {
   return Maybe<void>::Ok();
 }
 
-void StackFunctionNode::ReleaseOutTensorArgs() {
+void FunctionNode::ReleaseOutTensorArgs() {
   for (const std::shared_ptr<AutogradMeta>& meta_data : output_meta_datas_) {
     meta_data->now_grad_arg()->Release();
   }
 }
 
-void StackFunctionNode::ReleaseData() {
+void FunctionNode::ReleaseData() {
   // Releases backward function and makes useless tensors release as early as possible
   if (!input_meta_datas_.empty()) { backward_fn_.reset(); }
-  next_functions_->clear();
-  is_in_stack_ = false;
+  next_functions_.clear();
 }
 
-Maybe<bool> StackFunctionNode::Apply(bool create_graph) {
+Maybe<bool> FunctionNode::Apply(bool create_graph) {
   CHECK_NOTNULL_OR_RETURN(backward_fn_.get())
       << "This FunctionNode with name `" << GetOpTypeName() << "` has been released.";
   if (!IsReadyToRun(output_meta_datas_)) { return false; }
@@ -131,6 +131,27 @@ Maybe<bool> StackFunctionNode::Apply(bool create_graph) {
   return true;
 }
 
+void StackFunctionNode::ReleaseData() {
+  FunctionNode::ReleaseData();
+  is_in_stack_ = false;
+}
+
+template<typename FunctionNodeT>
+Maybe<void> AddAccumulateFunctionNode(const std::shared_ptr<Tensor>& tensor) {
+  auto backward_fn =
+      std::make_shared<std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>(
+          [=](const TensorTuple& out_grads, TensorTuple* in_grads,
+              bool create_graph) -> Maybe<void> { return Maybe<void>::Ok(); });
+  tensor->set_grad_fn_node(std::make_shared<FunctionNodeT>("accumulate_grad", backward_fn,
+                                                           TensorTuple(), TensorTuple({tensor})));
+  return Maybe<void>::Ok();
+}
+
+template Maybe<void> AddAccumulateFunctionNode<StackFunctionNode>(
+    const std::shared_ptr<Tensor>& tensor);
+template Maybe<void> AddAccumulateFunctionNode<GraphFunctionNode>(
+    const std::shared_ptr<Tensor>& tensor);
+
 void StackAutogradEngine::ClearEngine() {
   for (const auto& weak_func_node : node_list_) {
     const auto& func_node = weak_func_node.lock();
@@ -212,7 +233,7 @@ std::shared_ptr<FunctionNode> StackAutogradEngine::AddBackwardFuncPtr(
   // Firstly push function_node of tensor in stack which is leaf and requires_grad
   for (const std::shared_ptr<Tensor>& in_tensor : inputs) {
     if (in_tensor->is_leaf() && in_tensor->requires_grad()) {
-      if (!in_tensor->grad_fn_node()) { AddAccumulateFunctionNode(in_tensor); }
+      if (!in_tensor->grad_fn_node()) { AddAccumulateFunctionNode<StackFunctionNode>(in_tensor); }
       StackFunctionNode* stack_function_node =
           dynamic_cast<StackFunctionNode*>(in_tensor->mut_grad_fn_node().get());
       if (!stack_function_node->is_in_stack()) {
@@ -232,20 +253,200 @@ std::shared_ptr<FunctionNode> StackAutogradEngine::AddBackwardFuncPtr(
   return func_node;
 }
 
-AutogradEngine* GetThreadLocalAutogradEngine() {
-  thread_local static StackAutogradEngine autograd_engine;
-  return &autograd_engine;
+namespace {
+
+class GraphTask final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(GraphTask);
+  GraphTask(const TensorTuple& outputs, bool retain_graph, bool create_graph);
+  ~GraphTask() = default;
+
+  Maybe<void> ComputeDependencies();
+  // Only the nodes leading to the grad_fn_node of `inputs` compute their input gradients
+  Maybe<void> ComputeDependenciesAndPruneNode(const TensorTuple& inputs);
+  Maybe<void> Apply(bool save_grad_for_leaf);
+
+ private:
+  bool NeedApply(FunctionNode* node) const {
+    return !prune_ || need_apply_.find(node) != need_apply_.end();
+  }
+
+  bool retain_graph_;
+  bool create_graph_;
+  bool prune_;
+  std::vector<FunctionNode*> roots_;
+  HashMap<FunctionNode*, int64_t> dependencies_;
+  HashSet<FunctionNode*> need_apply_;
+};
+
+FunctionNode* MutFunctionNode(const std::shared_ptr<const FunctionNode>& node) {
+  // the engine is the only one applying the nodes, which are const to the tensors
+  return const_cast<FunctionNode*>(node.get());
 }
 
-Maybe<void> AddAccumulateFunctionNode(const std::shared_ptr<Tensor>& tensor) {
-  auto backward_fn =
-      std::make_shared<std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>(
-          [=](const TensorTuple& out_grads, TensorTuple* in_grads,
-              bool create_graph) -> Maybe<void> { return Maybe<void>::Ok(); });
-  tensor->set_grad_fn_node(std::make_shared<StackFunctionNode>(
-      "accumulate_grad", backward_fn, TensorTuple(), TensorTuple({tensor})));
+GraphTask::GraphTask(const TensorTuple& outputs, bool retain_graph, bool create_graph)
+    : retain_graph_(retain_graph), create_graph_(create_graph), prune_(false) {
+  roots_.reserve(outputs.size());
+  for (const auto& out_tensor : outputs) {
+    FunctionNode* node = MutFunctionNode(out_tensor->grad_fn_node());
+    if (node != nullptr && dependencies_.emplace(node, 0).second) { roots_.push_back(node); }
+  }
+}
+
+Maybe<void> GraphTask::ComputeDependencies() {
+  HashSet<FunctionNode*> visited;
+  std::vector<FunctionNode*> stack(roots_.begin(), roots_.end());
+  while (!stack.empty()) {
+    FunctionNode* node = stack.back();
+    stack.pop_back();
+    if (!visited.insert(node).second) { continue; }
+    for (const auto& next_node : node->GetNextFunctions()) {
+      FunctionNode* next = MutFunctionNode(next_node);
+      if (next == nullptr) { continue; }
+      dependencies_[next] += 1;
+      if (visited.find(next) == visited.end()) { stack.push_back(next); }
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> GraphTask::ComputeDependenciesAndPruneNode(const TensorTuple& inputs) {
+  JUST(ComputeDependencies());
+  HashSet<FunctionNode*> captured;
+  for (const auto& in_tensor : inputs) {
+    FunctionNode* node = MutFunctionNode(in_tensor->grad_fn_node());
+    if (node != nullptr) { captured.insert(node); }
+  }
+  // a node is applied if one of its next functions is captured or applied, which is decided in
+  // the reverse topological order
+  std::vector<FunctionNode*> topo_order;
+  HashMap<FunctionNode*, int64_t> dependencies = dependencies_;
+  std::vector<FunctionNode*> ready;
+  // an output may also be the ancestor of another output, which waits for its dependencies
+  for (FunctionNode* root : roots_) {
+    if (dependencies.at(root) == 0) { ready.push_back(root); }
+  }
+  while (!ready.empty()) {
+    FunctionNode* node = ready.back();
+    ready.pop_back();
+    topo_order.push_back(node);
+    for (const auto& next_node : node->GetNextFunctions()) {
+      FunctionNode* next = MutFunctionNode(next_node);
+      if (next != nullptr && --dependencies.at(next) == 0) { ready.push_back(next); }
+    }
+  }
+  for (auto iter = topo_order.rbegin(); iter != topo_order.rend(); ++iter) {
+    FunctionNode* node = *iter;
+    for (const auto& next_node : node->GetNextFunctions()) {
+      FunctionNode* next = MutFunctionNode(next_node);
+      if (captured.find(next) != captured.end() || need_apply_.find(next) != need_apply_.end()) {
+        need_apply_.insert(node);
+        break;
+      }
+    }
+  }
+  prune_ = true;
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> GraphTask::Apply(bool save_grad_for_leaf) {
+  std::queue<FunctionNode*> ready;
+  for (FunctionNode* root : roots_) {
+    if (dependencies_.at(root) == 0) { ready.push(root); }
+  }
+  while (!ready.empty()) {
+    FunctionNode* node = ready.front();
+    ready.pop();
+    // the next functions are released by the dependency counting whether or not this node is
+    // applied, they just get no gradient from it
+    if (NeedApply(node) && JUST(node->Apply(create_graph_))) {
+      if (save_grad_for_leaf) { JUST(node->AccGrad4LeafTensor(create_graph_)); }
+    }
+    JUST(node->AccGrad4RetainGradTensor());
+    // the gradients of the outputs and, without retain_graph, the tensors saved for backward are
+    // released as soon as the node has run
+    node->ReleaseOutTensorArgs();
+    for (const auto& next_node : node->GetNextFunctions()) {
+      FunctionNode* next = MutFunctionNode(next_node);
+      if (next != nullptr && --dependencies_.at(next) == 0) { ready.push(next); }
+    }
+    if (!retain_graph_) { node->ReleaseData(); }
+  }
   return Maybe<void>::Ok();
 }
 
+}  // namespace
+
+Maybe<void> GraphAutogradEngine::RunBackwardAndSaveGrads4LeafTensor(const TensorTuple& outputs,
+                                                                    const TensorTuple& out_grads,
+                                                                    bool retain_graph,
+                                                                    bool create_graph) {
+  for (int i = 0; i < outputs.size(); ++i) {
+    JUST(outputs.at(i)->now_grad_arg()->PushPartialTensor(out_grads.at(i)));
+  }
+  GraphTask graph_task(outputs, retain_graph, create_graph);
+  JUST(graph_task.ComputeDependencies());
+  JUST(graph_task.Apply(/*save_grad_for_leaf=*/true));
+  return Maybe<void>::Ok();
+}
+
+Maybe<TensorTuple> GraphAutogradEngine::RunBackwardAndReturnInputsTensorGrad(
+    const TensorTuple& outputs, const TensorTuple& inputs, const TensorTuple& out_grads,
+    bool retain_graph, bool create_graph) {
+  std::shared_ptr<TensorTuple> input_now_grads = std::make_shared<TensorTuple>(inputs.size());
+  std::vector<bool> ori_retain_grad(inputs.size());
+  for (int i = 0; i < inputs.size(); ++i) {
+    ori_retain_grad.at(i) = inputs.at(i)->retain_grad();
+    inputs.at(i)->set_retain_grad(true);
+  }
+  for (int i = 0; i < outputs.size(); ++i) {
+    JUST(outputs.at(i)->now_grad_arg()->PushPartialTensor(out_grads.at(i)));
+  }
+  GraphTask graph_task(outputs, retain_graph, create_graph);
+  JUST(graph_task.ComputeDependenciesAndPruneNode(inputs));
+  JUST(graph_task.Apply(/*save_grad_for_leaf=*/false));
+  for (int i = 0; i < inputs.size(); ++i) {
+    input_now_grads->at(i) = inputs.at(i)->acc_grad();
+    if (!ori_retain_grad.at(i)) {
+      inputs.at(i)->mut_acc_grad().reset();
+      inputs.at(i)->set_retain_grad(false);
+    }
+  }
+  return input_now_grads;
+}
+
+std::shared_ptr<FunctionNode> GraphAutogradEngine::AddBackwardFuncPtr(
+    const std::string& op_type_name,
+    const std::shared_ptr<const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>&
+        backward_fn,
+    const TensorTuple& inputs, TensorTuple* outputs) {
+  // The leaf tensors requiring grad get their accumulate node, which is the next function of
+  // `func_node`
+  for (const std::shared_ptr<Tensor>& in_tensor : inputs) {
+    if (in_tensor->is_leaf() && in_tensor->requires_grad() && !in_tensor->grad_fn_node()) {
+      AddAccumulateFunctionNode<GraphFunctionNode>(in_tensor);
+    }
+  }
+  std::shared_ptr<GraphFunctionNode> func_node =
+      std::make_shared<GraphFunctionNode>(op_type_name, backward_fn, inputs, *outputs);
+  for (const std::shared_ptr<Tensor>& out_tensor : *outputs) {
+    out_tensor->set_grad_fn_node(func_node);
+  }
+  return func_node;
+}
+
+AutogradEngine* GetThreadLocalAutogradEngine() {
+  static const bool use_graph_engine = [] {
+    const char* engine = std::getenv("ONEFLOW_AUTOGRAD_ENGINE");
+    return engine != nullptr && std::string(engine) == "graph";
+  }();
+  if (use_graph_engine) {
+    thread_local static GraphAutogradEngine autograd_engine;
+    return &autograd_engine;
+  }
+  thread_local static StackAutogradEngine autograd_engine;
+  return &autograd_engine;
+}
+
 }  // namespace one
 }  // namespace oneflow
@@ -37,28 +37,37 @@ class FunctionNode {
  public:
   virtual ~FunctionNode() = default;
 
-  virtual Maybe<bool> Apply(bool create_graph) = 0;
-  virtual Maybe<void> AccGrad4LeafTensor(bool create_graph) = 0;
-  virtual Maybe<void> AccGrad4RetainGradTensor() = 0;
-  virtual void ReleaseOutTensorArgs() = 0;
+  Maybe<bool> Apply(bool create_graph);
+  Maybe<void> AccGrad4LeafTensor(bool create_graph);
+  Maybe<void> AccGrad4RetainGradTensor();
+  void ReleaseOutTensorArgs();
   // Releases the eventual c++ std::function for backward if retain_graph=False to avoid calling
   // `Apply` in second time
-  virtual void ReleaseData() = 0;
+  virtual void ReleaseData();
 
   // Getters
-  const std::shared_ptr<std::vector<std::shared_ptr<const FunctionNode>>>& GetNextFunctions()
-      const {
+  const std::vector<std::shared_ptr<const FunctionNode>>& GetNextFunctions() const {
     return next_functions_;
   }
   const std::string& GetOpTypeName() const { return op_name_; }
 
  protected:
-  explicit FunctionNode(const std::string& op_type_name)
-      : op_name_(op_type_name),
-        next_functions_(new std::vector<std::shared_ptr<const FunctionNode>>{}) {}
+  FunctionNode(
+      const std::string& op_type_name,
+      const std::shared_ptr<
+          const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>& backward_fn,
+      const TensorTuple& inputs, const TensorTuple& outputs);
 
   const std::string op_name_;
-  std::shared_ptr<std::vector<std::shared_ptr<const FunctionNode>>> next_functions_;
+  std::vector<std::shared_ptr<const FunctionNode>> next_functions_;
+
+ private:
+  std::vector<std::shared_ptr<AutogradMeta>> input_meta_datas_;
+  std::vector<std::shared_ptr<AutogradMeta>> output_meta_datas_;
+  std::vector<TensorInfo> output_tensor_infos_;
+  // Actual backward function builds in `AutogradInterpreter` to calculate one backward op
+  std::shared_ptr<const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>
+      backward_fn_;
 };
 
 class AutogradEngine {
@@ -93,25 +102,16 @@ class StackFunctionNode final : public FunctionNode {
       const std::string& op_type_name,
       const std::shared_ptr<
           const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>& backward_fn,
-      const TensorTuple& inputs, const TensorTuple& outputs);
+      const TensorTuple& inputs, const TensorTuple& outputs)
+      : FunctionNode(op_type_name, backward_fn, inputs, outputs), is_in_stack_(false) {}
   StackFunctionNode() = delete;
   ~StackFunctionNode() override = default;
 
-  Maybe<void> AccGrad4LeafTensor(bool create_graph) override;
-  Maybe<void> AccGrad4RetainGradTensor() override;
-  void ReleaseOutTensorArgs() override;
   void ReleaseData() override;
-  Maybe<bool> Apply(bool create_graph) override;
   bool is_in_stack() const { return is_in_stack_; }
   void set_is_in_stack(bool in_stack) { is_in_stack_ = in_stack; }
 
  private:
-  std::vector<std::shared_ptr<AutogradMeta>> input_meta_datas_;
-  std::vector<std::shared_ptr<AutogradMeta>> output_meta_datas_;
-  std::vector<TensorInfo> output_tensor_infos_;
-  // Actual backward function builds in `AutogradInterpreter` to calculate one backward op
-  std::shared_ptr<const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>
-      backward_fn_;
   bool is_in_stack_;
 };
 
@@ -143,8 +143,49 @@ class StackAutogradEngine final : public AutogradEngine {
   void ClearReleasedFunctionNodes();
 };
 
+// Graph Autograd Node and Engine
+class GraphFunctionNode final : public FunctionNode {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(GraphFunctionNode);
+  GraphFunctionNode(
+      const std::string& op_type_name,
+      const std::shared_ptr<
+          const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>& backward_fn,
+      const TensorTuple& inputs, const TensorTuple& outputs)
+      : FunctionNode(op_type_name, backward_fn, inputs, outputs) {}
+  GraphFunctionNode() = delete;
+  ~GraphFunctionNode() override = default;
+};
+
+// Runs the nodes reachable from the outputs in a topological order by counting their
+// dependencies, so each node runs once, after all the gradients of its outputs are accumulated.
+// Nothing is saved in the engine, the graph is owned by the tensors through their grad_fn_node.
+class GraphAutogradEngine final : public AutogradEngine {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(GraphAutogradEngine);
+  GraphAutogradEngine() = default;
+  ~GraphAutogradEngine() override = default;
+
+  Maybe<void> RunBackwardAndSaveGrads4LeafTensor(const TensorTuple& outputs,
+                                                 const TensorTuple& out_grads, bool retain_graph,
+                                                 bool create_graph) override;
+  Maybe<TensorTuple> RunBackwardAndReturnInputsTensorGrad(const TensorTuple& outputs,
+                                                          const TensorTuple& inputs,
+                                                          const TensorTuple& out_grads,
+                                                          bool retain_graph,
+                                                          bool create_graph) override;
+  void ClearEngine() override {}
+  std::shared_ptr<FunctionNode> AddBackwardFuncPtr(
+      const std::string& op_type_name,
+      const std::shared_ptr<
+          const std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>& backward_fn,
+      const TensorTuple& inputs, TensorTuple* outputs) override;
+};
+
+// The stack engine unless the environment variable ONEFLOW_AUTOGRAD_ENGINE is "graph"
 AutogradEngine* GetThreadLocalAutogradEngine();
 
+template<typename FunctionNodeT>
 Maybe<void> AddAccumulateFunctionNode(const std::shared_ptr<Tensor>& tensor);
 
 }  // namespace one
@@ -87,7 +87,9 @@ EpollCommNet::~EpollCommNet() {
     LOG(INFO) << "CommNet Thread " << i << " finish";
     pollers_[i]->Stop();
   }
+  if (intra_host_helper_) { intra_host_helper_->Stop(); }
   OF_ENV_BARRIER();
+  intra_host_helper_.reset();
   for (IOEventPoller* poller : pollers_) { delete poller; }
   for (auto& pair : sockfd2helper_) { delete pair.second; }
 }
@@ -100,7 +102,7 @@ void EpollCommNet::SendActorMsg(int64_t dst_machine_id, const ActorMsg& actor_ms
   SocketMsg msg;
   msg.msg_type = SocketMsgType::kActor;
   msg.actor_msg = actor_msg;
-  GetSocketHelper(dst_machine_id)->AsyncWrite(msg);
+  SendSocketMsg(dst_machine_id, msg);
 }
 
 void EpollCommNet::SendTransportMsg(int64_t dst_machine_id, const TransportMsg& transport_msg) {
@@ -111,6 +113,10 @@ void EpollCommNet::SendTransportMsg(int64_t dst_machine_id, const TransportMsg&
 }
 
 void EpollCommNet::SendSocketMsg(int64_t dst_machine_id, const SocketMsg& msg) {
+  if (intra_host_helper_ && (msg.msg_type == SocketMsgType::kActor
+                             || msg.msg_type == SocketMsgType::kTransport)) {
+    if (intra_host_helper_->SendMsg(dst_machine_id, msg)) { return; }
+  }
   GetSocketHelper(dst_machine_id)->AsyncWrite(msg);
 }
 
@@ -125,6 +131,9 @@ EpollCommNet::EpollCommNet() : CommNetIf() {
   pollers_.resize(Global<ResourceDesc, ForSession>::Get()->CommNetWorkerNum(), nullptr);
   for (size_t i = 0; i < pollers_.size(); ++i) { pollers_[i] = new IOEventPoller; }
   InitSockets();
+  if (Global<ResourceDesc, ForSession>::Get()->enable_shm_comm_net()) {
+    intra_host_helper_.reset(new IntraHostCommHelper(peer_machine_id(), pollers_.size()));
+  }
   for (IOEventPoller* poller : pollers_) { poller->Start(); }
 }
 
@@ -205,6 +214,15 @@ SocketHelper* EpollCommNet::GetSocketHelper(int64_t machine_id) {
 }
 
 void EpollCommNet::DoRead(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token) {
+  if (intra_host_helper_
+      && intra_host_helper_->Read(read_id, src_machine_id, src_token, dst_token)) {
+    return;
+  }
+  ReadThroughSocket(read_id, src_machine_id, src_token, dst_token);
+}
+
+void EpollCommNet::ReadThroughSocket(void* read_id, int64_t src_machine_id, void* src_token,
+                                     void* dst_token) {
   SocketMsg msg;
   msg.msg_type = SocketMsgType::kRequestWrite;
   msg.request_write_msg.src_token = src_token;
@@ -19,6 +19,7 @@ limitations under the License.
 #ifdef __linux__
 
 #include "oneflow/core/comm_network/comm_network.h"
+#include "oneflow/core/comm_network/epoll/intra_host_comm_helper.h"
 #include "oneflow/core/comm_network/epoll/socket_helper.h"
 #include "oneflow/core/comm_network/epoll/socket_memory_desc.h"
 
@@ -35,6 +36,13 @@ class EpollCommNet final : public CommNetIf<SocketMemDesc> {
   void SendSocketMsg(int64_t dst_machine_id, const SocketMsg& msg);
   void SendTransportMsg(int64_t dst_machine_id, const TransportMsg& msg);
 
+  // Whether the messages to the machine go through shared memory instead of the socket.
+  bool IsIntraHostPeer(int64_t machine_id) const {
+    return intra_host_helper_ && intra_host_helper_->IsIntraHostPeer(machine_id);
+  }
+  // Asks the source machine to write the data into the socket.
+  void ReadThroughSocket(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token);
+
  private:
   SocketMemDesc* NewMemDesc(void* ptr, size_t byte_size) override;
 
@@ -47,6 +55,7 @@ class EpollCommNet final : public CommNetIf<SocketMemDesc> {
   std::vector<IOEventPoller*> pollers_;
   std::vector<int> machine_id2sockfd_;
   HashMap<int, SocketHelper*> sockfd2helper_;
+  std::unique_ptr<IntraHostCommHelper> intra_host_helper_;
 };
 
 }  // namespace oneflow
@@ -0,0 +1,289 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifdef __linux__
+
+#include "oneflow/core/comm_network/epoll/intra_host_comm_helper.h"
+#include "oneflow/core/actor/actor_message_bus.h"
+#include "oneflow/core/comm_network/epoll/epoll_comm_network.h"
+#include "oneflow/core/control/ctrl_client.h"
+#include "oneflow/core/control/global_process_ctx.h"
+#include "oneflow/core/transport/transport.h"
+
+#include <fstream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+namespace oneflow {
+
+namespace {
+
+constexpr uint64_t kShmMsgQueueCapacity = 1 << 14;
+constexpr int64_t kSendYieldRounds = 1024;
+constexpr int64_t kMaxSendSleepUs = 128;
+constexpr uint64_t kReadProbeValue = 0x0f1e2d3c4b5a6978ULL;
+// Read by the peers to find out whether process_vm_readv(2) is allowed on this process.
+volatile uint64_t read_probe = kReadProbeValue;
+
+std::string GetBootId() {
+  std::ifstream ifs("/proc/sys/kernel/random/boot_id");
+  std::string boot_id;
+  if (ifs) { ifs >> boot_id; }
+  return boot_id;
+}
+
+std::string GenHostKey(int64_t machine_id) {
+  return "EpollIntraHost/" + std::to_string(machine_id);
+}
+
+std::string GenShmNameKey(int64_t lo, int64_t hi) {
+  return "EpollIntraHostShm/" + std::to_string(lo) + "/" + std::to_string(hi);
+}
+
+std::string GenShmAckKey(int64_t lo, int64_t hi) {
+  return "EpollIntraHostShmAck/" + std::to_string(lo) + "/" + std::to_string(hi);
+}
+
+size_t AlignedQueueByteSize() {
+  return RoundUp(ShmMsgQueue::ByteSize(kShmMsgQueueCapacity), 64);
+}
+
+bool ReadFromProcess(int64_t pid, void* dst, const void* src, size_t size) {
+  while (size > 0) {
+    iovec local{dst, size};
+    iovec remote{const_cast<void*>(src), size};
+    const ssize_t n = process_vm_readv(static_cast<pid_t>(pid), &local, 1, &remote, 1, 0);
+    if (n <= 0) { return false; }
+    dst = static_cast<char*>(dst) + n;
+    src = static_cast<const char*>(src) + n;
+    size -= n;
+  }
+  return true;
+}
+
+}  // namespace
+
+IntraHostCommHelper::IntraHostCommHelper(const HashSet<int64_t>& peer_machine_ids,
+                                         size_t num_copy_threads)
+    : stopped_(false), next_copy_channel_(0) {
+  Connect(peer_machine_ids);
+  if (peers_.empty()) { return; }
+  poller_ = std::thread(&IntraHostCommHelper::PollRecvQueues, this);
+  FOR_RANGE(size_t, i, 0, std::max<size_t>(num_copy_threads, 1)) {
+    copy_channels_.emplace_back(std::make_unique<Channel<std::function<void()>>>());
+    Channel<std::function<void()>>* channel = copy_channels_.back().get();
+    copy_threads_.emplace_back([channel]() {
+      std::function<void()> copy;
+      while (channel->Receive(&copy) == kChannelStatusSuccess) { copy(); }
+    });
+  }
+}
+
+IntraHostCommHelper::~IntraHostCommHelper() {
+  Stop();
+  for (auto& pair : peers_) {
+    PCHECK(munmap(pair.second->shm_ptr, pair.second->shm_size) == 0);
+  }
+}
+
+void IntraHostCommHelper::Connect(const HashSet<int64_t>& peer_machine_ids) {
+  const int64_t this_machine_id = GlobalProcessCtx::Rank();
+  const std::string boot_id = GetBootId();
+  Global<CtrlClient>::Get()->PushKV(
+      GenHostKey(this_machine_id),
+      boot_id + " " + std::to_string(getpid()) + " "
+          + std::to_string(reinterpret_cast<uintptr_t>(&read_probe)));
+  const size_t queue_size = AlignedQueueByteSize();
+  const size_t shm_size = 2 * queue_size;
+  HashMap<int64_t, std::string> lo_peer2shm_name;
+  for (int64_t peer_id : peer_machine_ids) {
+    std::string peer_boot_id;
+    int64_t peer_pid = -1;
+    uintptr_t peer_probe_addr = 0;
+    Global<CtrlClient>::Get()->PullKV(GenHostKey(peer_id), [&](const std::string& v) {
+      std::istringstream iss(v);
+      iss >> peer_boot_id >> peer_pid >> peer_probe_addr;
+    });
+    if (boot_id.empty() || peer_boot_id != boot_id) { continue; }
+    std::unique_ptr<Peer> peer(new Peer());
+    peer->pid = peer_pid;
+    peer->shm_ptr = nullptr;
+    peer->shm_size = shm_size;
+    uint64_t probe = 0;
+    peer->enable_read =
+        ReadFromProcess(peer_pid, &probe, reinterpret_cast<const void*>(peer_probe_addr),
+                        sizeof(probe))
+        && probe == kReadProbeValue;
+    if (this_machine_id < peer_id) {
+      // The lower rank creates the segment, its first queue carries the messages to the higher.
+      const std::string name = "/oneflow-comm-net-" + std::to_string(getpid()) + "-"
+                               + std::to_string(this_machine_id) + "-" + std::to_string(peer_id);
+      const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+      if (fd != -1 && ftruncate(fd, shm_size) == 0) {
+        void* ptr = mmap(nullptr, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ptr != MAP_FAILED) {
+          peer->shm_ptr = ptr;
+          peer->send_queue = ShmMsgQueue::Init(ptr, kShmMsgQueueCapacity);
+          peer->recv_queue =
+              ShmMsgQueue::Init(static_cast<char*>(ptr) + queue_size, kShmMsgQueueCapacity);
+        }
+      }
+      if (fd != -1) { PCHECK(close(fd) == 0); }
+      Global<CtrlClient>::Get()->PushKV(GenShmNameKey(this_machine_id, peer_id),
+                                        peer->shm_ptr == nullptr ? "" : name);
+      if (peer->shm_ptr != nullptr) { lo_peer2shm_name.emplace(peer_id, name); }
+    } else {
+      std::string name;
+      Global<CtrlClient>::Get()->PullKV(GenShmNameKey(peer_id, this_machine_id),
+                                        [&](const std::string& v) { name = v; });
+      if (!name.empty()) {
+        const int fd = shm_open(name.c_str(), O_RDWR, 0600);
+        if (fd != -1) {
+          void* ptr = mmap(nullptr, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+          if (ptr != MAP_FAILED) {
+            peer->shm_ptr = ptr;
+            peer->recv_queue = ShmMsgQueue::At(ptr);
+            peer->send_queue = ShmMsgQueue::At(static_cast<char*>(ptr) + queue_size);
+          }
+          PCHECK(close(fd) == 0);
+        }
+        Global<CtrlClient>::Get()->PushKV(GenShmAckKey(peer_id, this_machine_id),
+                                          peer->shm_ptr == nullptr ? "0" : "1");
+      }
+    }
+    if (peer->shm_ptr != nullptr) { peers_.emplace(peer_id, std::move(peer)); }
+  }
+  for (const auto& pair : lo_peer2shm_name) {
+    const int64_t peer_id = pair.first;
+    bool attached = false;
+    Global<CtrlClient>::Get()->PullKV(GenShmAckKey(this_machine_id, peer_id),
+                                      [&](const std::string& v) { attached = v == "1"; });
+    PCHECK(shm_unlink(pair.second.c_str()) == 0);
+    Global<CtrlClient>::Get()->ClearKV(GenShmNameKey(this_machine_id, peer_id));
+    Global<CtrlClient>::Get()->ClearKV(GenShmAckKey(this_machine_id, peer_id));
+    if (!attached) {
+      auto it = peers_.find(peer_id);
+      PCHECK(munmap(it->second->shm_ptr, it->second->shm_size) == 0);
+      peers_.erase(it);
+    }
+  }
+  OF_ENV_BARRIER();
+  Global<CtrlClient>::Get()->ClearKV(GenHostKey(this_machine_id));
+  for (const auto& pair : peers_) {
+    LOG(INFO) << "CommNet:Epoll machine " << pair.first << " is on the same host, messages go "
+              << "through shared memory, reads through "
+              << (pair.second->enable_read ? "process_vm_readv" : "socket");
+  }
+}
+
+bool IntraHostCommHelper::SendMsg(int64_t dst_machine_id, const SocketMsg& msg) {
+  auto it = peers_.find(dst_machine_id);
+  if (it == peers_.end()) { return false; }
+  // The queue is only full while the poller of the peer is behind, yield for a while and then
+  // sleep a bit longer every time up to kMaxSendSleepUs.
+  int64_t rounds = 0;
+  int64_t sleep_us = 1;
+  while (!it->second->send_queue->TryPush(msg)) {
+    if (rounds < kSendYieldRounds) {
+      rounds += 1;
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
+      sleep_us = std::min(sleep_us * 2, kMaxSendSleepUs);
+    }
+  }
+  return true;
+}
+
+bool IntraHostCommHelper::Read(void* read_id, int64_t src_machine_id, void* src_token,
+                               void* dst_token) {
+  auto it = peers_.find(src_machine_id);
+  if (it == peers_.end() || !it->second->enable_read) { return false; }
+  Peer* peer = it->second.get();
+  const uint64_t channel_id = next_copy_channel_.fetch_add(1) % copy_channels_.size();
+  copy_channels_.at(channel_id)->Send([this, peer, read_id, src_machine_id, src_token,
+                                       dst_token]() {
+    if (CopyFromPeer(peer, src_token, dst_token)) {
+      Global<EpollCommNet>::Get()->ReadDone(read_id);
+    } else {
+      // The data is written again as a whole, so a partial copy does no harm.
+      if (peer->enable_read.exchange(false)) {
+        PLOG(WARNING) << "CommNet:Epoll process_vm_readv from machine " << src_machine_id
+                      << " failed, reads from it go through the socket from now on";
+      }
+      Global<EpollCommNet>::Get()->ReadThroughSocket(read_id, src_machine_id, src_token,
+                                                     dst_token);
+    }
+  });
+  return true;
+}
+
+bool IntraHostCommHelper::CopyFromPeer(Peer* peer, void* src_token, void* dst_token) {
+  // The tokens are SocketMemDesc of the two processes, the one of the peer has to be read first.
+  SocketMemDesc src_mem_desc;
+  if (!ReadFromProcess(peer->pid, &src_mem_desc, src_token, sizeof(src_mem_desc))) {
+    return false;
+  }
+  const SocketMemDesc* dst_mem_desc = static_cast<const SocketMemDesc*>(dst_token);
+  CHECK_LE(dst_mem_desc->byte_size, src_mem_desc.byte_size);
+  return ReadFromProcess(peer->pid, dst_mem_desc->mem_ptr, src_mem_desc.mem_ptr,
+                         dst_mem_desc->byte_size);
+}
+
+void IntraHostCommHelper::PollRecvQueues() {
+  // Spin while messages keep coming, then back off to yielding and finally to short sleeps.
+  constexpr int64_t kSpinRounds = 1024;
+  constexpr int64_t kYieldRounds = 1024 + 256;
+  int64_t idle_rounds = 0;
+  SocketMsg msg;
+  while (!stopped_.load(std::memory_order_relaxed)) {
+    bool received = false;
+    for (auto& pair : peers_) {
+      while (pair.second->recv_queue->TryPop(&msg)) {
+        received = true;
+        if (msg.msg_type == SocketMsgType::kActor) {
+          Global<ActorMsgBus>::Get()->SendMsgWithoutCommNet(msg.actor_msg);
+        } else if (msg.msg_type == SocketMsgType::kTransport) {
+          Global<Transport>::Get()->EnqueueTransportMsg(msg.transport_msg);
+        } else {
+          UNIMPLEMENTED();
+        }
+      }
+    }
+    if (received) {
+      idle_rounds = 0;
+    } else if (idle_rounds < kSpinRounds) {
+      idle_rounds += 1;
+    } else if (idle_rounds < kYieldRounds) {
+      idle_rounds += 1;
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+  }
+}
+
+void IntraHostCommHelper::Stop() {
+  if (stopped_.exchange(true)) { return; }
+  if (poller_.joinable()) { poller_.join(); }
+  for (auto& channel : copy_channels_) { channel->Close(); }
+  for (auto& thread : copy_threads_) { thread.join(); }
+}
+
+}  // namespace oneflow
+
+#endif  // __linux__
@@ -0,0 +1,81 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMM_NETWORK_EPOLL_INTRA_HOST_COMM_HELPER_H_
+#define ONEFLOW_CORE_COMM_NETWORK_EPOLL_INTRA_HOST_COMM_HELPER_H_
+
+#include "oneflow/core/common/channel.h"
+#include "oneflow/core/comm_network/epoll/shm_msg_queue.h"
+#include "oneflow/core/comm_network/epoll/socket_memory_desc.h"
+
+#ifdef __linux__
+
+namespace oneflow {
+
+// Fast path of EpollCommNet between the processes running on the same host.
+//
+// Actor and transport messages go through a pair of ShmMsgQueue in a POSIX shared memory
+// segment instead of the loopback socket, and a read is a single copy from the address space of
+// the peer with process_vm_readv(2) instead of a write into the socket and a read out of it.
+//
+// Peers on the same host are found by their boot id. The shared memory segment is created by
+// the lower rank and attached by the higher one, a pair falls back to the sockets if the segment
+// can't be attached, e.g. the processes are in containers with separate IPC namespaces. Reads
+// fall back to the sockets if the kernel refuses to access the peer, e.g. under the Yama ptrace
+// scope, and from the first read from the peer that fails.
+class IntraHostCommHelper final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(IntraHostCommHelper);
+  IntraHostCommHelper(const HashSet<int64_t>& peer_machine_ids, size_t num_copy_threads);
+  ~IntraHostCommHelper();
+
+  bool IsIntraHostPeer(int64_t machine_id) const { return peers_.count(machine_id) > 0; }
+
+  // Returns false if the message has to go through the socket, waits while the queue is full.
+  bool SendMsg(int64_t dst_machine_id, const SocketMsg& msg);
+
+  // Returns false if the read has to go through the socket, otherwise calls
+  // EpollCommNet::ReadDone once the data is in place.
+  bool Read(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token);
+
+  void Stop();
+
+ private:
+  struct Peer {
+    int64_t pid;
+    void* shm_ptr;
+    size_t shm_size;
+    ShmMsgQueue* send_queue;
+    ShmMsgQueue* recv_queue;
+    std::atomic<bool> enable_read;
+  };
+
+  void Connect(const HashSet<int64_t>& peer_machine_ids);
+  void PollRecvQueues();
+  bool CopyFromPeer(Peer* peer, void* src_token, void* dst_token);
+
+  HashMap<int64_t, std::unique_ptr<Peer>> peers_;
+  std::atomic<bool> stopped_;
+  std::thread poller_;
+  std::vector<std::unique_ptr<Channel<std::function<void()>>>> copy_channels_;
+  std::vector<std::thread> copy_threads_;
+  std::atomic<uint64_t> next_copy_channel_;
+};
+
+}  // namespace oneflow
+
+#endif  // __linux__
+
+#endif  // ONEFLOW_CORE_COMM_NETWORK_EPOLL_INTRA_HOST_COMM_HELPER_H_
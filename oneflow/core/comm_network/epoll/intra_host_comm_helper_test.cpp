@@ -0,0 +1,176 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/job/env.pb.h"
+#include "oneflow/core/control/ctrl_client.h"
+#include "oneflow/core/control/ctrl_server.h"
+#include "oneflow/core/control/ctrl_bootstrap.h"
+#include "oneflow/core/control/ctrl_util.h"
+#include "oneflow/core/control/global_process_ctx.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/comm_network/epoll/epoll_comm_network.h"
+#include "oneflow/core/transport/transport.h"
+
+#if defined(__linux__) && defined(RPC_BACKEND_GRPC)
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kWorldSize = 2;
+constexpr int32_t kMsgsPerSize = 32;
+
+EnvProto GetEnvProto(int64_t rank, int32_t ctrl_port) {
+  EnvProto ret;
+  auto* machine = ret.add_machine();
+  machine->set_id(0);
+  machine->set_addr("127.0.0.1");
+  ret.set_ctrl_port(ctrl_port);
+  BootstrapConf* bootstrap_conf = ret.mutable_ctrl_bootstrap_conf();
+  bootstrap_conf->mutable_master_addr()->set_host("127.0.0.1");
+  bootstrap_conf->mutable_master_addr()->set_port(ctrl_port);
+  bootstrap_conf->set_rank(rank);
+  bootstrap_conf->set_world_size(kWorldSize);
+  bootstrap_conf->set_host("127.0.0.1");
+  bootstrap_conf->set_node_size(1);
+  return ret;
+}
+
+Resource GetResource() {
+  Resource ret;
+  ret.set_machine_num(1);
+  ret.set_gpu_device_num(0);
+  ret.set_cpu_device_num(kWorldSize);
+  ret.set_comm_net_worker_num(1);
+  return ret;
+}
+
+char PayloadByte(uint64_t token, size_t i) {
+  return static_cast<char>((token * 131 + i * 7) & 0xff);
+}
+
+// The sender fills every message with bytes depending on its token, which the receiver checks.
+Maybe<void> SendAndCheckPayloads(int64_t sender_id, uint64_t first_token) {
+  const std::vector<size_t> sizes = {1, 7, 64, 4096, 1 << 20};
+  const int64_t this_machine_id = GlobalProcessCtx::Rank();
+  const bool is_sender = this_machine_id == sender_id;
+  const int64_t peer_id = 1 - this_machine_id;
+  std::vector<std::vector<char>> buffers;
+  std::vector<uint64_t> tokens;
+  for (size_t size : sizes) {
+    FOR_RANGE(int32_t, i, 0, kMsgsPerSize) {
+      tokens.push_back(first_token + tokens.size());
+      buffers.emplace_back(size, 0);
+      if (is_sender) {
+        FOR_RANGE(size_t, j, 0, size) { buffers.back().at(j) = PayloadByte(tokens.back(), j); }
+      }
+    }
+  }
+  BlockingCounter bc(buffers.size());
+  FOR_RANGE(size_t, i, 0, buffers.size()) {
+    void* ptr = buffers.at(i).data();
+    const size_t size = buffers.at(i).size();
+    if (is_sender) {
+      Global<Transport>::Get()->Send(tokens.at(i), peer_id, ptr, size, [&bc]() { bc.Decrease(); });
+    } else {
+      Global<Transport>::Get()->Receive(tokens.at(i), peer_id, ptr, size,
+                                        [&bc]() { bc.Decrease(); });
+    }
+  }
+  bc.WaitUntilCntEqualZero();
+  if (!is_sender) {
+    FOR_RANGE(size_t, i, 0, buffers.size()) {
+      FOR_RANGE(size_t, j, 0, buffers.at(i).size()) {
+        CHECK_EQ_OR_RETURN(buffers.at(i).at(j), PayloadByte(tokens.at(i), j))
+            << "byte " << j << " of message " << tokens.at(i);
+      }
+    }
+  }
+  OF_ENV_BARRIER();
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> RunRank(int64_t rank, int32_t ctrl_port, bool expect_shm) {
+  EnvProto env_proto = GetEnvProto(rank, ctrl_port);
+  Global<EnvDesc>::New(env_proto);
+  Global<CtrlServer>::New();
+  Global<ProcessCtx>::New();
+  JUST(RankInfoCtrlBootstrap(Global<EnvDesc>::Get()->bootstrap_conf())
+           .InitProcessCtx(Global<CtrlServer>::Get()->port(), Global<ProcessCtx>::Get()));
+  auto* client = new GrpcCtrlClient(*Global<ProcessCtx>::Get());
+  Global<CtrlClient>::SetAllocated(client);
+  Global<ResourceDesc, ForEnv>::New(GetResource(), GlobalProcessCtx::NumOfProcessPerNode());
+  Global<ResourceDesc, ForSession>::New(GetResource(), GlobalProcessCtx::NumOfProcessPerNode());
+  Global<EpollCommNet>::New();
+  Global<Transport>::New();
+  OF_ENV_BARRIER();
+
+  CHECK_EQ_OR_RETURN(Global<EpollCommNet>::Get()->IsIntraHostPeer(1 - rank), expect_shm);
+  // both directions, with the transport messages of the two ranks crossing in the queues
+  JUST(SendAndCheckPayloads(0, 1000));
+  JUST(SendAndCheckPayloads(1, 2000));
+
+  Global<Transport>::Delete();
+  Global<EpollCommNet>::Delete();
+  Global<ResourceDesc, ForSession>::Delete();
+  Global<ResourceDesc, ForEnv>::Delete();
+  Global<CtrlClient>::Delete();
+  Global<ProcessCtx>::Delete();
+  Global<CtrlServer>::Delete();
+  Global<EnvDesc>::Delete();
+  return Maybe<void>::Ok();
+}
+
+// Runs the ranks in processes of their own on this host, as the comm net is a global of the
+// process.
+void RunLocalProcesses(bool disable_shm) {
+  const int32_t ctrl_port = CtrlUtil().FindAvailablePort();
+  if (ctrl_port == -1) { return; }
+  std::vector<pid_t> pids;
+  FOR_RANGE(int64_t, rank, 0, kWorldSize) {
+    const pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+      if (disable_shm) { setenv("ONEFLOW_COMM_NET_DISABLE_SHM", "1", 1); }
+      const Maybe<void> ret = RunRank(rank, ctrl_port, !disable_shm);
+      if (!ret.IsOk()) { LOG(ERROR) << ret.GetSerializedError(); }
+      _exit(ret.IsOk() ? 0 : 1);
+    }
+    pids.push_back(pid);
+  }
+  for (pid_t pid : pids) {
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+  }
+}
+
+}  // namespace
+
+TEST(IntraHostCommHelper, send_through_shared_memory) { RunLocalProcesses(false); }
+
+TEST(IntraHostCommHelper, send_through_sockets_if_disabled) { RunLocalProcesses(true); }
+
+}  // namespace oneflow
+
+#endif  // defined(__linux__) && defined(RPC_BACKEND_GRPC)
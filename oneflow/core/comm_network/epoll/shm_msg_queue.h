@@ -0,0 +1,113 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMM_NETWORK_EPOLL_SHM_MSG_QUEUE_H_
+#define ONEFLOW_CORE_COMM_NETWORK_EPOLL_SHM_MSG_QUEUE_H_
+
+#include "oneflow/core/comm_network/epoll/socket_message.h"
+
+#ifdef __linux__
+
+#include <atomic>
+#include <new>
+
+namespace oneflow {
+
+// Bounded lock-free queue of SocketMsg living in memory shared by two processes. Every cell
+// carries a sequence number telling whether it is free for the producer of a given position or
+// filled for the consumer of it, so any number of threads of the sending process can push
+// while the receiving process pops.
+//
+// The queue only holds atomics and trivially copyable messages, it is placed into the shared
+// mapping with Init() by the process creating it and attached with At() by the other one.
+class ShmMsgQueue final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ShmMsgQueue);
+  ShmMsgQueue() = delete;
+  ~ShmMsgQueue() = default;
+
+  static size_t ByteSize(uint64_t capacity) {
+    return sizeof(ShmMsgQueue) + capacity * sizeof(Cell);
+  }
+
+  static ShmMsgQueue* Init(void* ptr, uint64_t capacity) {
+    CHECK_GT(capacity, 0);
+    CHECK_EQ(capacity & (capacity - 1), 0) << "capacity must be a power of 2";
+    ShmMsgQueue* queue = new (ptr) ShmMsgQueue(capacity);
+    for (uint64_t i = 0; i < capacity; ++i) { new (&queue->cells()[i]) Cell(i); }
+    std::atomic_thread_fence(std::memory_order_release);
+    return queue;
+  }
+
+  static ShmMsgQueue* At(void* ptr) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return static_cast<ShmMsgQueue*>(ptr);
+  }
+
+  bool TryPush(const SocketMsg& msg) {
+    uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell* cell = &cells()[pos & (capacity_ - 1)];
+      const uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+      const int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          cell->msg = msg;
+          cell->sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Only one thread pops from a queue.
+  bool TryPop(SocketMsg* msg) {
+    const uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Cell* cell = &cells()[pos & (capacity_ - 1)];
+    const uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+    if (static_cast<int64_t>(seq) - static_cast<int64_t>(pos + 1) < 0) { return false; }
+    *msg = cell->msg;
+    cell->sequence.store(pos + capacity_, std::memory_order_release);
+    dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+ private:
+  struct Cell {
+    explicit Cell(uint64_t seq) : sequence(seq) {}
+    std::atomic<uint64_t> sequence;
+    SocketMsg msg;
+  };
+
+  explicit ShmMsgQueue(uint64_t capacity)
+      : capacity_(capacity), enqueue_pos_(0), dequeue_pos_(0) {}
+
+  // The cells follow the queue, which is padded to a cache line by the alignment of its members.
+  Cell* cells() { return reinterpret_cast<Cell*>(this + 1); }
+
+  uint64_t capacity_;
+  alignas(64) std::atomic<uint64_t> enqueue_pos_;
+  alignas(64) std::atomic<uint64_t> dequeue_pos_;
+};
+
+}  // namespace oneflow
+
+#endif  // __linux__
+
+#endif  // ONEFLOW_CORE_COMM_NETWORK_EPOLL_SHM_MSG_QUEUE_H_
@@ -0,0 +1,68 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_BFLOAT16_H_
+#define ONEFLOW_CORE_COMMON_BFLOAT16_H_
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace oneflow {
+
+// The upper half of an IEEE float: the same exponent range with 8 bits of mantissa. The
+// arithmetic is done in float, the conversions from float round to nearest even.
+struct alignas(2) bfloat16 {
+  uint16_t x;
+
+  bfloat16() = default;
+  template<typename T, typename std::enable_if<std::is_arithmetic<T>::value>::type* = nullptr>
+  bfloat16(T value) : x(Float2Bits(static_cast<float>(value))) {}
+
+  operator float() const { return Bits2Float(x); }
+
+  static bfloat16 FromBits(uint16_t bits) {
+    bfloat16 ret;
+    ret.x = bits;
+    return ret;
+  }
+
+  static uint16_t Float2Bits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    // quiet the NaNs, whose mantissa could be rounded away
+    if ((bits & 0x7fffffffU) > 0x7f800000U) { return static_cast<uint16_t>((bits >> 16) | 0x40); }
+    bits += 0x7fffU + ((bits >> 16) & 1U);
+    return static_cast<uint16_t>(bits >> 16);
+  }
+
+  static float Bits2Float(uint16_t bits) {
+    const uint32_t value_bits = static_cast<uint32_t>(bits) << 16;
+    float value;
+    std::memcpy(&value, &value_bits, sizeof(value));
+    return value;
+  }
+
+  bfloat16& operator+=(float rhs) { return *this = static_cast<float>(*this) + rhs; }
+  bfloat16& operator-=(float rhs) { return *this = static_cast<float>(*this) - rhs; }
+  bfloat16& operator*=(float rhs) { return *this = static_cast<float>(*this) * rhs; }
+  bfloat16& operator/=(float rhs) { return *this = static_cast<float>(*this) / rhs; }
+};
+
+static_assert(sizeof(bfloat16) == 2, "sizeof(bfloat16) != 2");
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_BFLOAT16_H_
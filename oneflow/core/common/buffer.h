@@ -33,6 +33,7 @@ class Buffer final {
   BufferStatus Receive(T* item);
   BufferStatus TryReceive(T* item);
   void Close();
+  size_t Size() const;
 
  private:
   std::queue<T> queue_;
@@ -80,6 +81,12 @@ void Buffer<T>::Close() {
   cond_.notify_all();
 }
 
+template<typename T>
+size_t Buffer<T>::Size() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return queue_.size();
+}
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_CORE_COMMON_BUFFER_H_
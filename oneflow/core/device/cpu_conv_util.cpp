@@ -0,0 +1,158 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/device/cpu_conv_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// Winograd only pays off once the gemms of the transformed tiles dominate the transforms.
+constexpr int64_t kWinogradMinChannels = 8;
+// F(4x4, 3x3) wastes most of its tiles on small outputs.
+constexpr int64_t kWinograd4x4MinOutSize = 8;
+
+int32_t SpatialAxis(const CpuConvParams& params) { return params.channels_last ? 1 : 2; }
+
+int64_t InChannels(const CpuConvParams& params) {
+  return params.in_shape[params.channels_last ? 4 : 1];
+}
+
+int64_t OutChannels(const CpuConvParams& params) { return params.weight_shape[0]; }
+
+int64_t KernelSize(const CpuConvParams& params, int32_t dim) {
+  return params.weight_shape[(params.channels_last ? 1 : 2) + dim];
+}
+
+int64_t InSize(const CpuConvParams& params, int32_t dim) {
+  return params.in_shape[SpatialAxis(params) + dim];
+}
+
+int64_t OutSize(const CpuConvParams& params, int32_t dim) {
+  return params.out_shape[SpatialAxis(params) + dim];
+}
+
+bool IsWinogradApplicable(const CpuConvParams& params) {
+  if (params.channels_last) { return false; }
+  if (params.data_type != DataType::kFloat && params.data_type != DataType::kDouble) {
+    return false;
+  }
+  if (KernelSize(params, 0) != 1 || InSize(params, 0) != 1 || OutSize(params, 0) != 1
+      || params.padding_before[0] != 0) {
+    return false;
+  }
+  FOR_RANGE(int32_t, dim, 1, CpuConvParams::kConvDims) {
+    if (KernelSize(params, dim) != 3 || params.strides[dim] != 1
+        || params.dilation_rate[dim] != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int64_t GetWinogradWorkspaceElemCnt(const CpuConvParams& params, const int64_t tile_size) {
+  const int64_t alpha = tile_size + 2;
+  const int64_t num_tiles = RoundUp(OutSize(params, 1), tile_size) / tile_size
+                            * (RoundUp(OutSize(params, 2), tile_size) / tile_size);
+  const int64_t ci = InChannels(params);
+  const int64_t co = OutChannels(params);
+  // the transformed filters, input tiles and output tiles
+  return alpha * alpha * (co * ci + ci * num_tiles + co * num_tiles);
+}
+
+}  // namespace
+
+CpuConvParams MakeCpuConvParams(DataType data_type, bool channels_last, const int64_t* in_shape,
+                                const int64_t* out_shape, const int64_t* weight_shape,
+                                const int32_t* strides, const int32_t* dilation_rate,
+                                const int32_t* padding_before) {
+  CpuConvParams params;
+  std::memset(&params, 0, sizeof(CpuConvParams));
+  std::copy(in_shape, in_shape + CpuConvParams::kTensorDims, params.in_shape);
+  std::copy(out_shape, out_shape + CpuConvParams::kTensorDims, params.out_shape);
+  std::copy(weight_shape, weight_shape + CpuConvParams::kTensorDims, params.weight_shape);
+  std::copy(strides, strides + CpuConvParams::kConvDims, params.strides);
+  std::copy(dilation_rate, dilation_rate + CpuConvParams::kConvDims, params.dilation_rate);
+  std::copy(padding_before, padding_before + CpuConvParams::kConvDims, params.padding_before);
+  params.data_type = static_cast<int32_t>(data_type);
+  params.channels_last = channels_last;
+  return params;
+}
+
+bool IsCpuConv1x1(const CpuConvParams& params) {
+  FOR_RANGE(int32_t, dim, 0, CpuConvParams::kConvDims) {
+    if (KernelSize(params, dim) != 1 || params.strides[dim] != 1
+        || params.padding_before[dim] != 0 || InSize(params, dim) != OutSize(params, dim)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool operator==(const CpuConvParams& lhs, const CpuConvParams& rhs) {
+  return std::memcmp(&lhs, &rhs, sizeof(CpuConvParams)) == 0;
+}
+
+std::vector<CpuConvAlgo> GetCpuConvAlgoCandidates(const CpuConvParams& params) {
+  std::vector<CpuConvAlgo> candidates{CpuConvAlgo::kIm2ColGemm};
+  if (IsCpuConv1x1(params)) { candidates.push_back(CpuConvAlgo::kGemm1x1); }
+  if (IsWinogradApplicable(params)) {
+    candidates.push_back(CpuConvAlgo::kWinograd2x2);
+    candidates.push_back(CpuConvAlgo::kWinograd4x4);
+  }
+  return candidates;
+}
+
+CpuConvAlgo InferCpuConvAlgoHeuristically(const CpuConvParams& params) {
+  if (IsCpuConv1x1(params)) { return CpuConvAlgo::kGemm1x1; }
+  if (IsWinogradApplicable(params) && InChannels(params) >= kWinogradMinChannels
+      && OutChannels(params) >= kWinogradMinChannels) {
+    if (OutSize(params, 1) >= kWinograd4x4MinOutSize
+        && OutSize(params, 2) >= kWinograd4x4MinOutSize) {
+      return CpuConvAlgo::kWinograd4x4;
+    }
+    return CpuConvAlgo::kWinograd2x2;
+  }
+  return CpuConvAlgo::kIm2ColGemm;
+}
+
+int64_t GetCpuConvAlgoWorkspaceElemCnt(const CpuConvParams& params, CpuConvAlgo algo) {
+  switch (algo) {
+    case CpuConvAlgo::kIm2ColGemm: {
+      int64_t col_buf_elem_cnt = InChannels(params);
+      FOR_RANGE(int32_t, dim, 0, CpuConvParams::kConvDims) {
+        col_buf_elem_cnt *= KernelSize(params, dim) * OutSize(params, dim);
+      }
+      return col_buf_elem_cnt;
+    }
+    case CpuConvAlgo::kGemm1x1: return 0;
+    case CpuConvAlgo::kWinograd2x2: return GetWinogradWorkspaceElemCnt(params, 2);
+    case CpuConvAlgo::kWinograd4x4: return GetWinogradWorkspaceElemCnt(params, 4);
+    default: UNIMPLEMENTED();
+  }
+  return 0;
+}
+
+CpuConvAlgo CpuConvAlgoCache::Remember(
+    const CpuConvParams& params, const std::function<CpuConvAlgo(const CpuConvParams&)>& InferFn) {
+  std::unique_lock<std::mutex> lock(fwd_algo_store_mutex_);
+  const auto it = fwd_algo_store_.find(params);
+  if (it != fwd_algo_store_.end()) { return it->second; }
+  const CpuConvAlgo algo = InferFn(params);
+  fwd_algo_store_.emplace(params, algo);
+  return algo;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,109 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_DEVICE_CPU_CONV_UTIL_H_
+#define ONEFLOW_CORE_DEVICE_CPU_CONV_UTIL_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/data_type.pb.h"
+
+namespace oneflow {
+
+enum class CpuConvAlgo {
+  // im2col of every image followed by a gemm with the weight
+  kIm2ColGemm = 0,
+  // the input of a 1x1, stride 1, unpadded conv already is the im2col matrix
+  kGemm1x1 = 1,
+  // Winograd F(2x2, 3x3) and F(4x4, 3x3) for channels_first 3x3, stride 1 convs
+  kWinograd2x2 = 2,
+  kWinograd4x4 = 3,
+};
+
+// The shapes are 5d, (n, c, d, h, w) or (n, d, h, w, c), the weight is (co, ci, kd, kh, kw) or
+// (co, kd, kh, kw, ci), the conv attrs are 3d.
+struct CpuConvParams {
+  static constexpr size_t kTensorDims = 5;
+  static constexpr size_t kConvDims = 3;
+
+  int64_t in_shape[kTensorDims];
+  int64_t out_shape[kTensorDims];
+  int64_t weight_shape[kTensorDims];
+  int32_t strides[kConvDims];
+  int32_t dilation_rate[kConvDims];
+  int32_t padding_before[kConvDims];
+  int32_t data_type;
+  int32_t channels_last;
+};
+
+// Zeroes the padding of the struct, which is hashed and compared bytewise.
+CpuConvParams MakeCpuConvParams(DataType data_type, bool channels_last, const int64_t* in_shape,
+                                const int64_t* out_shape, const int64_t* weight_shape,
+                                const int32_t* strides, const int32_t* dilation_rate,
+                                const int32_t* padding_before);
+
+bool operator==(const CpuConvParams& lhs, const CpuConvParams& rhs);
+
+// The input of the conv already is its im2col matrix, or the transpose of it for channels_last.
+bool IsCpuConv1x1(const CpuConvParams& params);
+
+// The algorithms able to run the conv, im2col + gemm always is one of them.
+std::vector<CpuConvAlgo> GetCpuConvAlgoCandidates(const CpuConvParams& params);
+CpuConvAlgo InferCpuConvAlgoHeuristically(const CpuConvParams& params);
+// The number of elements of the data type the algorithm needs as workspace, besides the bias
+// multiplier.
+int64_t GetCpuConvAlgoWorkspaceElemCnt(const CpuConvParams& params, CpuConvAlgo algo);
+
+}  // namespace oneflow
+
+namespace std {
+
+template<>
+struct hash<oneflow::CpuConvParams> final {
+  static_assert(std::is_pod<oneflow::CpuConvParams>::value, "CpuConvParams is not POD");
+
+  size_t operator()(const oneflow::CpuConvParams& params) const {
+    const auto* ptr = reinterpret_cast<const uint8_t*>(&params);
+    uint32_t value = 0x811C9DC5;
+    for (int i = 0; i < (int)sizeof(oneflow::CpuConvParams); ++i) {
+      value ^= ptr[i];
+      value *= 0x01000193;
+    }
+    return (size_t)value;
+  }
+};
+
+}  // namespace std
+
+namespace oneflow {
+
+// The algorithm of every conv shape is inferred once, either by the heuristic or by timing the
+// candidates, and shared by the kernels of the process.
+class CpuConvAlgoCache final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuConvAlgoCache);
+  CpuConvAlgoCache() = default;
+  ~CpuConvAlgoCache() = default;
+
+  CpuConvAlgo Remember(const CpuConvParams& params,
+                       const std::function<CpuConvAlgo(const CpuConvParams&)>& InferFn);
+
+ private:
+  HashMap<CpuConvParams, CpuConvAlgo> fwd_algo_store_;
+  std::mutex fwd_algo_store_mutex_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_DEVICE_CPU_CONV_UTIL_H_
@@ -0,0 +1,294 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/embedding/cpu_embedding_table.h"
+#include <cmath>
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kShardBits = 6;
+static_assert(CpuEmbeddingTable::kNumShards == (int64_t(1) << kShardBits),
+              "the shard of an id is taken from the top bits of its hash");
+
+// The splitmix64 finalizer, sequential ids are spread over all the shards.
+uint64_t MixBits(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xBF58476D1CE4E5B9ULL;
+  x ^= x >> 27;
+  x *= 0x94D049BB133111EBULL;
+  x ^= x >> 31;
+  return x;
+}
+
+int64_t GetShardId(int64_t id) {
+  return static_cast<int64_t>(MixBits(static_cast<uint64_t>(id)) >> (64 - kShardBits));
+}
+
+int64_t GetNumOptimizerStates(CpuEmbeddingOptimizer optimizer) {
+  switch (optimizer) {
+    case CpuEmbeddingOptimizer::kSgd: return 0;
+    case CpuEmbeddingOptimizer::kAdagrad: return 1;
+    default: UNIMPLEMENTED();
+  }
+  return 0;
+}
+
+// The ranges of the thread pool to split the shards into for num_ids ids.
+int64_t GetNumShardRanges(int64_t num_ids, int64_t embedding_dim) {
+  const int64_t num_ids_per_shard = std::max<int64_t>(num_ids / CpuEmbeddingTable::kNumShards, 1);
+  return GetNumThreadRanges(CpuEmbeddingTable::kNumShards, num_ids_per_shard * embedding_dim);
+}
+
+}  // namespace
+
+bool operator==(const CpuEmbeddingTableConf& lhs, const CpuEmbeddingTableConf& rhs) {
+  return lhs.embedding_dim == rhs.embedding_dim && lhs.optimizer == rhs.optimizer
+         && lhs.epsilon == rhs.epsilon && lhs.init_min == rhs.init_min
+         && lhs.init_max == rhs.init_max && lhs.seed == rhs.seed && lhs.ttl == rhs.ttl;
+}
+
+CpuEmbeddingTable::CpuEmbeddingTable(const CpuEmbeddingTableConf& conf)
+    : conf_(conf),
+      row_size_(conf.embedding_dim * (1 + GetNumOptimizerStates(conf.optimizer))),
+      shards_(kNumShards),
+      num_steps_(0) {
+  CHECK_GT(conf_.embedding_dim, 0);
+  CHECK_LE(conf_.init_min, conf_.init_max);
+  CHECK_GE(conf_.ttl, 0);
+}
+
+int64_t CpuEmbeddingTable::Size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int64_t size = 0;
+  for (const Shard& shard : shards_) { size += shard.id2row.size(); }
+  return size;
+}
+
+int64_t CpuEmbeddingTable::num_steps() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_steps_;
+}
+
+template<typename K>
+void CpuEmbeddingTable::PartitionIds(int64_t num_ids, const K* ids, std::vector<int64_t>* offsets,
+                                     std::vector<int64_t>* positions) const {
+  std::vector<int64_t> shard_ids(num_ids);
+  offsets->assign(kNumShards + 1, 0);
+  FOR_RANGE(int64_t, i, 0, num_ids) {
+    shard_ids[i] = GetShardId(static_cast<int64_t>(ids[i]));
+    (*offsets)[shard_ids[i] + 1] += 1;
+  }
+  FOR_RANGE(int64_t, i, 0, kNumShards) { (*offsets)[i + 1] += (*offsets)[i]; }
+  std::vector<int64_t> cursors(offsets->begin(), offsets->end() - 1);
+  positions->resize(num_ids);
+  FOR_RANGE(int64_t, i, 0, num_ids) { (*positions)[cursors[shard_ids[i]]++] = i; }
+}
+
+int64_t CpuEmbeddingTable::FindOrInsertRow(Shard* shard, int64_t id) {
+  const auto it = shard->id2row.find(id);
+  if (it != shard->id2row.end()) { return it->second; }
+  int64_t row = 0;
+  if (shard->free_rows.empty()) {
+    row = static_cast<int64_t>(shard->row2step.size());
+    shard->rows.resize((row + 1) * row_size_);
+    shard->row2step.push_back(0);
+  } else {
+    row = shard->free_rows.back();
+    shard->free_rows.pop_back();
+  }
+  float* embedding = shard->rows.data() + row * row_size_;
+  const uint64_t id_seed = MixBits(MixBits(static_cast<uint64_t>(conf_.seed)) ^ id);
+  const float scale = conf_.init_max - conf_.init_min;
+  FOR_RANGE(int64_t, d, 0, conf_.embedding_dim) {
+    // 24 random bits make a float uniform in [0, 1)
+    const uint64_t bits = MixBits(id_seed + static_cast<uint64_t>(d) * 0x9E3779B97F4A7C15ULL);
+    const float uniform = static_cast<float>(bits >> 40) * (1.0f / (1 << 24));
+    embedding[d] = conf_.init_min + uniform * scale;
+  }
+  std::fill(embedding + conf_.embedding_dim, embedding + row_size_, 0.0f);
+  shard->id2row.emplace(id, row);
+  return row;
+}
+
+void CpuEmbeddingTable::EvictExpiredRows(Shard* shard) {
+  for (auto it = shard->id2row.begin(); it != shard->id2row.end();) {
+    if (num_steps_ - shard->row2step[it->second] > conf_.ttl) {
+      shard->free_rows.push_back(it->second);
+      it = shard->id2row.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+template<typename K>
+void CpuEmbeddingTable::Lookup(int64_t num_ids, const K* ids, int64_t bag_size,
+                               CpuEmbeddingCombiner combiner, float* out) {
+  const int64_t dim = conf_.embedding_dim;
+  if (combiner != CpuEmbeddingCombiner::kNone) {
+    CHECK_GT(bag_size, 0);
+    CHECK_EQ(num_ids % bag_size, 0);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<int64_t> offsets;
+  std::vector<int64_t> positions;
+  PartitionIds(num_ids, ids, &offsets, &positions);
+  std::vector<const float*> embeddings(num_ids);
+  MultiThreadLoopInRanges(
+      kNumShards, GetNumShardRanges(num_ids, dim),
+      [&](int64_t range_id, int64_t begin, int64_t end) {
+        std::vector<int64_t> rows;
+        FOR_RANGE(int64_t, shard_id, begin, end) {
+          Shard* shard = &shards_[shard_id];
+          const int64_t* shard_positions = positions.data() + offsets[shard_id];
+          const int64_t shard_num_ids = offsets[shard_id + 1] - offsets[shard_id];
+          rows.resize(shard_num_ids);
+          FOR_RANGE(int64_t, i, 0, shard_num_ids) {
+            rows[i] = FindOrInsertRow(shard, static_cast<int64_t>(ids[shard_positions[i]]));
+            shard->row2step[rows[i]] = num_steps_;
+          }
+          // the rows of the shard are not moved any more once all its ids are inserted
+          FOR_RANGE(int64_t, i, 0, shard_num_ids) {
+            embeddings[shard_positions[i]] = shard->rows.data() + rows[i] * row_size_;
+          }
+        }
+      });
+  if (combiner == CpuEmbeddingCombiner::kNone) {
+    MultiThreadLoopInRanges(num_ids, GetNumThreadRanges(num_ids, dim),
+                            [&](int64_t range_id, int64_t begin, int64_t end) {
+                              FOR_RANGE(int64_t, i, begin, end) {
+                                std::copy(embeddings[i], embeddings[i] + dim, out + i * dim);
+                              }
+                            });
+    return;
+  }
+  const int64_t num_bags = num_ids / bag_size;
+  const float bag_scale = combiner == CpuEmbeddingCombiner::kMean ? 1.0f / bag_size : 1.0f;
+  MultiThreadLoopInRanges(
+      num_bags, GetNumThreadRanges(num_bags, bag_size * dim),
+      [&](int64_t range_id, int64_t begin, int64_t end) {
+        FOR_RANGE(int64_t, bag, begin, end) {
+          float* bag_out = out + bag * dim;
+          std::fill(bag_out, bag_out + dim, 0.0f);
+          FOR_RANGE(int64_t, i, bag * bag_size, (bag + 1) * bag_size) {
+            const float* embedding = embeddings[i];
+            FOR_RANGE(int64_t, d, 0, dim) { bag_out[d] += embedding[d]; }
+          }
+          if (bag_scale != 1.0f) {
+            FOR_RANGE(int64_t, d, 0, dim) { bag_out[d] *= bag_scale; }
+          }
+        }
+      });
+}
+
+template<typename K>
+void CpuEmbeddingTable::Update(int64_t num_ids, const K* ids, int64_t bag_size,
+                               CpuEmbeddingCombiner combiner, const float* embedding_diff,
+                               float diff_scale, float learning_rate) {
+  const int64_t dim = conf_.embedding_dim;
+  // the diff of the i-th id is embedding_diff + (i / diff_stride) * dim times diff_scale
+  int64_t diff_stride = 1;
+  if (combiner != CpuEmbeddingCombiner::kNone) {
+    CHECK_GT(bag_size, 0);
+    CHECK_EQ(num_ids % bag_size, 0);
+    diff_stride = bag_size;
+    if (combiner == CpuEmbeddingCombiner::kMean) { diff_scale /= bag_size; }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<int64_t> offsets;
+  std::vector<int64_t> positions;
+  PartitionIds(num_ids, ids, &offsets, &positions);
+  MultiThreadLoopInRanges(
+      kNumShards, GetNumShardRanges(num_ids, dim),
+      [&](int64_t range_id, int64_t begin, int64_t end) {
+        std::vector<std::pair<int64_t, int64_t>> row_and_positions;
+        std::vector<float> diff_sum(dim);
+        FOR_RANGE(int64_t, shard_id, begin, end) {
+          Shard* shard = &shards_[shard_id];
+          row_and_positions.clear();
+          FOR_RANGE(int64_t, i, offsets[shard_id], offsets[shard_id + 1]) {
+            const int64_t pos = positions[i];
+            row_and_positions.emplace_back(
+                FindOrInsertRow(shard, static_cast<int64_t>(ids[pos])), pos);
+          }
+          // the duplicated ids are next to each other, their diffs are summed before the update
+          std::sort(row_and_positions.begin(), row_and_positions.end());
+          for (size_t i = 0; i < row_and_positions.size();) {
+            const int64_t row = row_and_positions[i].first;
+            std::fill(diff_sum.begin(), diff_sum.end(), 0.0f);
+            for (; i < row_and_positions.size() && row_and_positions[i].first == row; ++i) {
+              const float* diff = embedding_diff + row_and_positions[i].second / diff_stride * dim;
+              FOR_RANGE(int64_t, d, 0, dim) { diff_sum[d] += diff[d]; }
+            }
+            float* embedding = shard->rows.data() + row * row_size_;
+            if (conf_.optimizer == CpuEmbeddingOptimizer::kSgd) {
+              const float step = learning_rate * diff_scale;
+              FOR_RANGE(int64_t, d, 0, dim) { embedding[d] -= step * diff_sum[d]; }
+            } else if (conf_.optimizer == CpuEmbeddingOptimizer::kAdagrad) {
+              float* sum_of_squares = embedding + dim;
+              FOR_RANGE(int64_t, d, 0, dim) {
+                const float g = diff_sum[d] * diff_scale;
+                sum_of_squares[d] += g * g;
+                embedding[d] -= learning_rate * g / (std::sqrt(sum_of_squares[d]) + conf_.epsilon);
+              }
+            } else {
+              UNIMPLEMENTED();
+            }
+            shard->row2step[row] = num_steps_;
+          }
+        }
+      });
+  num_steps_ += 1;
+  if (conf_.ttl > 0 && num_steps_ % conf_.ttl == 0) {
+    int64_t size = 0;
+    for (const Shard& shard : shards_) { size += shard.id2row.size(); }
+    MultiThreadLoopInRanges(kNumShards, GetNumShardRanges(size, 1),
+                            [&](int64_t range_id, int64_t begin, int64_t end) {
+                              FOR_RANGE(int64_t, shard_id, begin, end) {
+                                EvictExpiredRows(&shards_[shard_id]);
+                              }
+                            });
+  }
+}
+
+#define INSTANTIATE_CPU_EMBEDDING_TABLE_FUNCS(K)                                                \
+  template void CpuEmbeddingTable::Lookup<K>(int64_t num_ids, const K* ids, int64_t bag_size,  \
+                                             CpuEmbeddingCombiner combiner, float* out);        \
+  template void CpuEmbeddingTable::Update<K>(int64_t num_ids, const K* ids, int64_t bag_size,  \
+                                             CpuEmbeddingCombiner combiner,                     \
+                                             const float* embedding_diff, float diff_scale,     \
+                                             float learning_rate);
+
+INSTANTIATE_CPU_EMBEDDING_TABLE_FUNCS(int32_t)
+INSTANTIATE_CPU_EMBEDDING_TABLE_FUNCS(int64_t)
+
+#undef INSTANTIATE_CPU_EMBEDDING_TABLE_FUNCS
+
+CpuEmbeddingTable* CpuEmbeddingTableManager::GetOrCreateTable(const std::string& name,
+                                                              const CpuEmbeddingTableConf& conf) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = name2table_.find(name);
+  if (it == name2table_.end()) {
+    it = name2table_.emplace(name, std::make_unique<CpuEmbeddingTable>(conf)).first;
+  } else {
+    CHECK(it->second->conf() == conf) << "embedding " << name << " is used with another conf";
+  }
+  return it->second.get();
+}
+
+}  // namespace oneflow
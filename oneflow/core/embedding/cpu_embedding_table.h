@@ -0,0 +1,123 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EMBEDDING_CPU_EMBEDDING_TABLE_H_
+#define ONEFLOW_CORE_EMBEDDING_CPU_EMBEDDING_TABLE_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+enum class CpuEmbeddingCombiner {
+  // every id has its own embedding
+  kNone = 0,
+  // the embeddings of the ids of a bag are summed, or averaged
+  kSum = 1,
+  kMean = 2,
+};
+
+enum class CpuEmbeddingOptimizer {
+  kSgd = 0,
+  // keeps the sum of the squared gradients of every element besides the embedding
+  kAdagrad = 1,
+};
+
+struct CpuEmbeddingTableConf {
+  int64_t embedding_dim;
+  CpuEmbeddingOptimizer optimizer;
+  float epsilon;
+  // the embedding of a new id is drawn uniformly from [init_min, init_max) by a generator seeded
+  // with the seed and the id, so that it does not depend on the order of the ids
+  float init_min;
+  float init_max;
+  int64_t seed;
+  // the rows neither looked up nor updated in the last ttl updates are evicted, 0 keeps them
+  int64_t ttl;
+};
+
+bool operator==(const CpuEmbeddingTableConf& lhs, const CpuEmbeddingTableConf& rhs);
+
+// Maps int64 ids to the embeddings of a vocabulary which is not known up front. The ids are split
+// into kNumShards shards by their hash, a shard has a hash map from its ids to its rows, which
+// grow as ids are inserted and are reused once evicted. A row holds the embedding followed by the
+// state of the optimizer. The shards are looked up and updated in the thread pool, a call holds
+// the lock of the table, so that the kernels of several devices of a process may share it.
+class CpuEmbeddingTable final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuEmbeddingTable);
+  explicit CpuEmbeddingTable(const CpuEmbeddingTableConf& conf);
+  ~CpuEmbeddingTable() = default;
+
+  static constexpr int64_t kNumShards = 64;
+
+  const CpuEmbeddingTableConf& conf() const { return conf_; }
+  // The number of ids in the table.
+  int64_t Size();
+  // The number of updates so far, which the ttl is counted in.
+  int64_t num_steps();
+
+  // Writes the embeddings of the num_ids ids to out, bags of bag_size ids are combined into a
+  // single embedding unless combiner is kNone. The missing ids are inserted.
+  template<typename K>
+  void Lookup(int64_t num_ids, const K* ids, int64_t bag_size, CpuEmbeddingCombiner combiner,
+              float* out);
+  // Applies the gradients of the embeddings written by Lookup with the same ids to the table,
+  // the gradients of the same id are summed first and multiplied by diff_scale, which undoes the
+  // loss scale. Evicts the expired rows every ttl updates.
+  template<typename K>
+  void Update(int64_t num_ids, const K* ids, int64_t bag_size, CpuEmbeddingCombiner combiner,
+              const float* embedding_diff, float diff_scale, float learning_rate);
+
+ private:
+  struct Shard {
+    HashMap<int64_t, int64_t> id2row;
+    std::vector<float> rows;
+    std::vector<int64_t> row2step;
+    std::vector<int64_t> free_rows;
+  };
+
+  // Splits the positions of the ids among the shards, the positions of the shard i are
+  // (*positions)[(*offsets)[i], (*offsets)[i + 1]) in the order of the ids.
+  template<typename K>
+  void PartitionIds(int64_t num_ids, const K* ids, std::vector<int64_t>* offsets,
+                    std::vector<int64_t>* positions) const;
+  int64_t FindOrInsertRow(Shard* shard, int64_t id);
+  void EvictExpiredRows(Shard* shard);
+
+  const CpuEmbeddingTableConf conf_;
+  const int64_t row_size_;
+  std::vector<Shard> shards_;
+  int64_t num_steps_;
+  std::mutex mutex_;
+};
+
+// The tables of a session by their names.
+class CpuEmbeddingTableManager final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuEmbeddingTableManager);
+  CpuEmbeddingTableManager() = default;
+  ~CpuEmbeddingTableManager() = default;
+
+  // Creates the table the first time it is asked for, the later calls must pass the same conf.
+  CpuEmbeddingTable* GetOrCreateTable(const std::string& name, const CpuEmbeddingTableConf& conf);
+
+ private:
+  HashMap<std::string, std::unique_ptr<CpuEmbeddingTable>> name2table_;
+  std::mutex mutex_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EMBEDDING_CPU_EMBEDDING_TABLE_H_
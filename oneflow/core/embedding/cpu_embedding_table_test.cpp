@@ -0,0 +1,125 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/embedding/cpu_embedding_table.h"
+#include <cmath>
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace {
+
+CpuEmbeddingTableConf GetConf(CpuEmbeddingOptimizer optimizer, int64_t ttl) {
+  CpuEmbeddingTableConf conf;
+  conf.embedding_dim = 4;
+  conf.optimizer = optimizer;
+  conf.epsilon = 1e-3;
+  conf.init_min = -0.5;
+  conf.init_max = 0.5;
+  conf.seed = 1;
+  conf.ttl = ttl;
+  return conf;
+}
+
+class CpuEmbeddingTableTest : public testing::Test {
+ protected:
+  void SetUp() override { Global<ThreadPool>::New(4); }
+  void TearDown() override { Global<ThreadPool>::Delete(); }
+};
+
+}  // namespace
+
+TEST_F(CpuEmbeddingTableTest, lookup_does_not_depend_on_order) {
+  const CpuEmbeddingTableConf conf = GetConf(CpuEmbeddingOptimizer::kSgd, 0);
+  CpuEmbeddingTable table(conf);
+  CpuEmbeddingTable reversed_table(conf);
+  std::vector<int64_t> ids(1000);
+  FOR_RANGE(int64_t, i, 0, 1000) { ids[i] = i * 7919 - 3000; }
+  std::vector<float> out(1000 * 4);
+  table.Lookup(1000, ids.data(), 1, CpuEmbeddingCombiner::kNone, out.data());
+  std::reverse(ids.begin(), ids.end());
+  std::vector<float> reversed_out(1000 * 4);
+  reversed_table.Lookup(1000, ids.data(), 1, CpuEmbeddingCombiner::kNone, reversed_out.data());
+  ASSERT_EQ(table.Size(), 1000);
+  FOR_RANGE(int64_t, i, 0, 1000) {
+    FOR_RANGE(int64_t, d, 0, 4) {
+      const float x = out[i * 4 + d];
+      ASSERT_EQ(x, reversed_out[(999 - i) * 4 + d]);
+      ASSERT_TRUE(x >= -0.5 && x < 0.5);
+    }
+  }
+}
+
+TEST_F(CpuEmbeddingTableTest, mean_lookup_and_sgd_update) {
+  CpuEmbeddingTable table(GetConf(CpuEmbeddingOptimizer::kSgd, 0));
+  const std::vector<int32_t> ids = {3, 5, 3, 3};
+  std::vector<float> embeddings(2 * 4);
+  table.Lookup<int32_t>(2, ids.data(), 1, CpuEmbeddingCombiner::kNone, embeddings.data());
+  std::vector<float> out(2 * 4);
+  table.Lookup<int32_t>(4, ids.data(), 2, CpuEmbeddingCombiner::kMean, out.data());
+  FOR_RANGE(int64_t, d, 0, 4) {
+    ASSERT_FLOAT_EQ(out[d], (embeddings[d] + embeddings[4 + d]) / 2);
+    ASSERT_FLOAT_EQ(out[4 + d], embeddings[d]);
+  }
+  const std::vector<float> out_diff = {1, 2, 3, 4, 2, 2, 2, 2};
+  table.Update<int32_t>(4, ids.data(), 2, CpuEmbeddingCombiner::kMean, out_diff.data(), 1.0,
+                        0.1);
+  std::vector<float> updated(2 * 4);
+  table.Lookup<int32_t>(2, ids.data(), 1, CpuEmbeddingCombiner::kNone, updated.data());
+  FOR_RANGE(int64_t, d, 0, 4) {
+    // id 3 is in both bags, its diff is the sum of the mean diffs of the two bags
+    ASSERT_FLOAT_EQ(updated[d], embeddings[d] - 0.1 * (out_diff[d] / 2 + out_diff[4 + d]));
+    ASSERT_FLOAT_EQ(updated[4 + d], embeddings[4 + d] - 0.1 * out_diff[d] / 2);
+  }
+  ASSERT_EQ(table.num_steps(), 1);
+}
+
+TEST_F(CpuEmbeddingTableTest, adagrad_update) {
+  CpuEmbeddingTable table(GetConf(CpuEmbeddingOptimizer::kAdagrad, 0));
+  const int64_t id = 42;
+  std::vector<float> embedding(4);
+  table.Lookup(1, &id, 1, CpuEmbeddingCombiner::kNone, embedding.data());
+  const std::vector<float> diff = {1, -2, 0.5, 0};
+  // the diffs of a loss scaled by 8 are scaled back before they are squared
+  const std::vector<float> scaled_diff = {8, -16, 4, 0};
+  std::vector<float> sum_of_squares(4, 0);
+  FOR_RANGE(int64_t, step, 0, 3) {
+    table.Update(1, &id, 1, CpuEmbeddingCombiner::kNone, scaled_diff.data(), 0.125, 0.1);
+    FOR_RANGE(int64_t, d, 0, 4) {
+      sum_of_squares[d] += diff[d] * diff[d];
+      embedding[d] -= 0.1 * diff[d] / (std::sqrt(sum_of_squares[d]) + 1e-3);
+    }
+  }
+  std::vector<float> out(4);
+  table.Lookup(1, &id, 1, CpuEmbeddingCombiner::kNone, out.data());
+  FOR_RANGE(int64_t, d, 0, 4) { ASSERT_NEAR(out[d], embedding[d], 1e-6); }
+}
+
+TEST_F(CpuEmbeddingTableTest, evict_expired_rows) {
+  CpuEmbeddingTable table(GetConf(CpuEmbeddingOptimizer::kSgd, 2));
+  const std::vector<int64_t> first_ids = {1, 2};
+  const std::vector<int64_t> later_ids = {1, 3};
+  std::vector<float> out(2 * 4);
+  const std::vector<float> diff(2 * 4, 1);
+  FOR_RANGE(int64_t, step, 0, 4) {
+    const std::vector<int64_t>& ids = step == 0 ? first_ids : later_ids;
+    table.Lookup(2, ids.data(), 1, CpuEmbeddingCombiner::kNone, out.data());
+    table.Update(2, ids.data(), 1, CpuEmbeddingCombiner::kNone, diff.data(), 1.0, 0.1);
+    // id 2 is only evicted once it has not been used for more than 2 steps
+    ASSERT_EQ(table.Size(), step < 3 ? std::min<int64_t>(step + 2, 3) : 2);
+  }
+}
+
+}  // namespace oneflow
@@ -38,15 +38,38 @@ limitations under the License.
 #include "oneflow/core/framework/vm_local_dep_object.h"
 #include "oneflow/core/framework/tensor.h"
 #include "oneflow/core/framework/device.h"
+#include "oneflow/core/vm/vm_util.h"
+#include "oneflow/core/vm/instruction_type.h"
 
 namespace oneflow {
 
 namespace {
 
+// Looks the instruction type of "<device_tag>.<instr_name>" up once per device tag, instead of
+// building and hashing the full name for every eager instruction.
+class DeviceInstrTypeIdCache final {
+ public:
+  explicit DeviceInstrTypeIdCache(const std::string& instr_name) : instr_name_(instr_name) {}
+  ~DeviceInstrTypeIdCache() = default;
+
+  const vm::InstrTypeId& Get(const std::string& device_tag) {
+    auto iter = device_tag2instr_type_id_.find(device_tag);
+    if (iter == device_tag2instr_type_id_.end()) {
+      const auto* instr_type_id = &vm::LookupInstrTypeId(device_tag + "." + instr_name_);
+      iter = device_tag2instr_type_id_.emplace(device_tag, instr_type_id).first;
+    }
+    return *iter->second;
+  }
+
+ private:
+  std::string instr_name_;
+  HashMap<std::string, const vm::InstrTypeId*> device_tag2instr_type_id_;
+};
+
 Maybe<int64_t> NewSymbolId(vm::IdGenerator* id_generator,
                            vm::InstructionMsgList* instruction_list) {
   int64_t symbol_id = JUST(id_generator->NewSymbolId());
-  ObjectMsgPtr<vm::InstructionMsg> instruction = ObjectMsgPtr<vm::InstructionMsg>::New("NewSymbol");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("NewSymbol");
   instruction->add_int64_operand(symbol_id);
   instruction_list->PushBack(instruction.Mutable());
   return symbol_id;
@@ -174,8 +197,7 @@ Maybe<int64_t> CreateSymbolIdHelper<T>::Call(vm::IdGenerator* id_generator,
                                              const T& conf) {
   int64_t symbol_id = JUST(NewSymbolId(id_generator, instruction_list));
   {
-    ObjectMsgPtr<vm::InstructionMsg> instruction =
-        ObjectMsgPtr<vm::InstructionMsg>::New(GetInstrTypeName<T>());
+    ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction(GetInstrTypeName<T>());
     instruction->add_init_symbol_operand(symbol_id);
     instruction_list->PushBack(instruction.Mutable());
   }
@@ -197,7 +219,7 @@ Maybe<int64_t> CreateSymbolIdHelper<cfg::ParallelConf>::Call(
   int64_t symbol_id = JUST(id_generator->NewSymbolId());
   {
     ObjectMsgPtr<vm::InstructionMsg> instruction =
-        ObjectMsgPtr<vm::InstructionMsg>::New(GetInstrTypeName<cfg::ParallelConf>());
+        vm::NewInstruction(GetInstrTypeName<cfg::ParallelConf>());
     instruction->add_int64_operand(symbol_id);
     instruction_list->PushBack(instruction.Mutable());
   }
@@ -212,7 +234,7 @@ Maybe<int64_t> CreateSymbolIdHelper<cfg::ParallelConf>::Call(
 }  // namespace detail
 
 Maybe<int64_t> InstructionsBuilder::NewSymbolId() {
-  ObjectMsgPtr<vm::InstructionMsg> instruction = ObjectMsgPtr<vm::InstructionMsg>::New("NewSymbol");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("NewSymbol");
   int64_t symbol_id = JUST(id_generator_->NewSymbolId());
   instruction->add_int64_operand(symbol_id);
   instruction_list_->PushBack(instruction.Mutable());
@@ -222,7 +244,7 @@ Maybe<int64_t> InstructionsBuilder::NewSymbolId() {
 Maybe<int64_t> InstructionsBuilder::NewObjectId(
     const std::shared_ptr<ParallelDesc>& parallel_desc_sym) {
   int64_t object_id = JUST(id_generator_->NewObjectId());
-  ObjectMsgPtr<vm::InstructionMsg> instruction = ObjectMsgPtr<vm::InstructionMsg>::New("NewObject");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("NewObject");
   instruction->add_parallel_desc(JUST(parallel_desc_sym->symbol_id()));
   instruction->add_int64_operand(object_id);
   instruction_list_->PushBack(instruction.Mutable());
@@ -460,8 +482,7 @@ Maybe<void> InstructionsBuilder::ReplaceMirrored(
     const std::shared_ptr<ParallelDesc>& parallel_desc_sym,
     const std::vector<std::shared_ptr<compatible_py::BlobObject>>& lhs_objects,
     const std::vector<std::shared_ptr<compatible_py::BlobObject>>& rhs_objects) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("ReplaceMirrored");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("ReplaceMirrored");
   instruction->set_parallel_desc_symbol_id(JUST(parallel_desc_sym->symbol_id()));
   for (const auto& lhs_object : lhs_objects) {
     instruction->add_int64_operand(lhs_object->object_id());
@@ -584,8 +605,7 @@ Maybe<int64_t> InstructionsBuilder::BroadcastObjectReference(
     const std::shared_ptr<compatible_py::BlobObject>& sole_mirrored_object,
     const std::shared_ptr<ParallelDesc>& parallel_desc_sym) {
   int64_t object_id = JUST(id_generator_->NewObjectId());
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("BroadcastObjectReference");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("BroadcastObjectReference");
   instruction->set_parallel_desc_symbol_id(JUST(parallel_desc_sym->symbol_id()));
   instruction->add_int64_operand(object_id);
   instruction->add_int64_operand(sole_mirrored_object->object_id());
@@ -613,7 +633,7 @@ Maybe<void> InstructionsBuilder::BuildSendInstruction(
     const std::shared_ptr<ParallelDesc>& dst_parallel_desc_symbol,
     const std::shared_ptr<compatible_py::BlobObject>& src_blob_object,
     const std::tuple<std::vector<uint64_t>, std::vector<uint64_t>>& token_ids) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction = ObjectMsgPtr<vm::InstructionMsg>::New("SendBlob");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("SendBlob");
   instruction->set_parallel_desc_symbol_id(
       JUST(src_blob_object->parallel_desc_symbol()->symbol_id()));
   instruction->add_symbol_operand(JUST(dst_parallel_desc_symbol->symbol_id()));
@@ -630,8 +650,7 @@ Maybe<void> InstructionsBuilder::BuildRecvInstruction(
     const std::shared_ptr<ParallelDesc>& src_parallel_desc_symbol,
     const std::shared_ptr<compatible_py::BlobObject>& dst_blob_object,
     const std::tuple<std::vector<uint64_t>, std::vector<uint64_t>>& token_ids) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("ReceiveBlob");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("ReceiveBlob");
   instruction->set_parallel_desc_symbol_id(
       JUST(dst_blob_object->parallel_desc_symbol()->symbol_id()));
   instruction->add_symbol_operand(JUST(src_parallel_desc_symbol->symbol_id()));
@@ -650,8 +669,7 @@ Maybe<void> InstructionsBuilder::LocalCallOpKernel(
     const one::EagerBlobObjectListPtr& output_eager_blob_objects, const AttrMap& attrs,
     const std::shared_ptr<const ParallelDesc>& parallel_desc_sym,
     const std::string& instr_type_name) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New(instr_type_name);
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction(instr_type_name);
   auto phy_instr_operand = std::make_shared<vm::LocalCallOpKernelPhyInstrOperand>(
       opkernel, input_eager_blob_objects, output_eager_blob_objects, attrs);
   *instruction->mut_parallel_desc() = parallel_desc_sym;
@@ -662,8 +680,7 @@ Maybe<void> InstructionsBuilder::LocalCallOpKernel(
 
 Maybe<void> InstructionsBuilder::CudaHostRegisterBlob(
     const std::shared_ptr<compatible_py::BlobObject>& blob_object) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("CudaHostRegisterBlob");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("CudaHostRegisterBlob");
   instruction->set_parallel_desc_symbol_id(JUST(blob_object->parallel_desc_symbol()->symbol_id()));
   instruction->add_mut_operand(blob_object->object_id());
   instruction_list_->PushBack(instruction.Mutable());
@@ -672,8 +689,7 @@ Maybe<void> InstructionsBuilder::CudaHostRegisterBlob(
 
 Maybe<void> InstructionsBuilder::CudaHostUnregisterBlob(
     const std::shared_ptr<compatible_py::BlobObject>& blob_object) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("CudaHostUnregisterBlob");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("CudaHostUnregisterBlob");
   instruction->set_parallel_desc_symbol_id(JUST(blob_object->parallel_desc_symbol()->symbol_id()));
   instruction->add_mut_operand(blob_object->object_id());
   instruction_list_->PushBack(instruction.Mutable());
@@ -701,8 +717,7 @@ Maybe<void> InstructionsBuilder::LazyReference(
     const std::shared_ptr<compatible_py::BlobObject>& blob_object,
     const std::string& interface_op_name) {
   std::string device_tag = blob_object->parallel_desc_symbol()->device_tag();
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New(device_tag + ".LazyReference");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction(device_tag + ".LazyReference");
   instruction->set_parallel_desc_symbol_id(JUST(blob_object->parallel_desc_symbol()->symbol_id()));
   instruction->add_mut_operand(blob_object->object_id());
   std::shared_ptr<StringSymbol> interface_op_name_sym =
@@ -743,8 +758,7 @@ Maybe<compatible_py::Object> InstructionsBuilder::GetSharedOpKernelObject4Parall
 }
 
 Maybe<void> InstructionsBuilder::InitStringSymbol(int64_t symbol_id, std::string str) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("InitStringSymbol");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("InitStringSymbol");
   instruction->add_init_symbol_operand(symbol_id);
   instruction_list_->PushBack(instruction.Mutable());
   vm::cfg::EagerSymbol eager_symbol;
@@ -756,8 +770,7 @@ Maybe<void> InstructionsBuilder::InitStringSymbol(int64_t symbol_id, std::string
 
 Maybe<void> InstructionsBuilder::InitJobConfSymbol(
     int64_t symbol_id, const std::shared_ptr<cfg::JobConfigProto>& job_conf) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("InitJobDescSymbol");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("InitJobDescSymbol");
   instruction->add_init_symbol_operand(symbol_id);
   instruction_list_->PushBack(instruction.Mutable());
   vm::cfg::EagerSymbol eager_symbol;
@@ -769,8 +782,7 @@ Maybe<void> InstructionsBuilder::InitJobConfSymbol(
 
 Maybe<void> InstructionsBuilder::NewParallelConfSymbol(
     int64_t symbol_id, const std::shared_ptr<cfg::ParallelConf>& parallel_conf) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("NewParallelDescSymbol");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("NewParallelDescSymbol");
   instruction->add_int64_operand(symbol_id);
   instruction_list_->PushBack(instruction.Mutable());
   vm::cfg::EagerSymbol eager_symbol;
@@ -782,8 +794,7 @@ Maybe<void> InstructionsBuilder::NewParallelConfSymbol(
 
 Maybe<void> InstructionsBuilder::NewScopeSymbol(
     int64_t symbol_id, const std::shared_ptr<cfg::ScopeProto>& scope_proto) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("InitScopeSymbol");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("InitScopeSymbol");
   instruction->add_init_symbol_operand(symbol_id);
   instruction_list_->PushBack(instruction.Mutable());
   vm::cfg::EagerSymbol eager_symbol;
@@ -798,8 +809,7 @@ Maybe<int64_t> InstructionsBuilder::_NewOpKernelObject(
     const std::shared_ptr<JobDesc>& job_desc_sym,
     const std::shared_ptr<OperatorConfSymbol>& op_conf_sym) {
   int64_t object_id = JUST(NewObjectId(parallel_desc_symbol));
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("InitOpKernelObject");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("InitOpKernelObject");
   instruction->set_parallel_desc_symbol_id(JUST(parallel_desc_symbol->symbol_id()));
   instruction->add_symbol_operand(JUST(job_desc_sym->symbol_id()));
   instruction->add_symbol_operand(JUST(op_conf_sym->symbol_id()));
@@ -811,7 +821,7 @@ Maybe<int64_t> InstructionsBuilder::_NewOpKernelObject(
 Maybe<void> InstructionsBuilder::InitOpNodeSignatureDescSymbol(
     int64_t symbol_id, const std::shared_ptr<cfg::OpNodeSignature>& op_node_signature_sym) {
   ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("InitOpNodeSignatureDescSymbol");
+      vm::NewInstruction("InitOpNodeSignatureDescSymbol");
   instruction->add_init_symbol_operand(symbol_id);
   instruction_list_->PushBack(instruction.Mutable());
   vm::cfg::EagerSymbol eager_symbol;
@@ -823,8 +833,7 @@ Maybe<void> InstructionsBuilder::InitOpNodeSignatureDescSymbol(
 
 Maybe<void> InstructionsBuilder::InitOpConfSymbol(
     int64_t symbol_id, const std::shared_ptr<cfg::OperatorConf>& op_conf) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("InitOperatorConfSymbol");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("InitOperatorConfSymbol");
   instruction->add_init_symbol_operand(symbol_id);
   instruction_list_->PushBack(instruction.Mutable());
   vm::cfg::EagerSymbol eager_symbol;
@@ -836,8 +845,7 @@ Maybe<void> InstructionsBuilder::InitOpConfSymbol(
 
 Maybe<void> InstructionsBuilder::InsertRemoveForeignCallbackInstruction(int64_t object_id,
                                                                         int64_t callback_id) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("RemoveForeignCallback");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("RemoveForeignCallback");
   instruction->add_mut_operand(object_id, vm::AllMirroredObject());
   instruction->add_int64_operand(callback_id);
   instruction_list_->PushBack(instruction.Mutable());
@@ -849,7 +857,7 @@ Maybe<void> InstructionsBuilder::_FetchBlob(
     const std::shared_ptr<compatible_py::BlobObject>& blob_object, int64_t callback_id) {
   const std::string& device_tag = blob_object->parallel_desc_symbol()->device_tag();
   ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New(device_tag + "." + instruction_name);
+      vm::NewInstruction(device_tag + "." + instruction_name);
   instruction->set_parallel_desc_symbol_id(JUST(blob_object->parallel_desc_symbol()->symbol_id()));
   instruction->add_const_operand(blob_object->object_id());
   instruction->add_int64_operand(callback_id);
@@ -860,8 +868,7 @@ Maybe<void> InstructionsBuilder::_FetchBlob(
 Maybe<void> InstructionsBuilder::FeedBlob(
     const std::shared_ptr<compatible_py::BlobObject>& blob_object, int64_t callback_id) {
   const std::string& device_tag = blob_object->parallel_desc_symbol()->device_tag();
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New(device_tag + "." + "FeedBlob");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction(device_tag + "." + "FeedBlob");
   instruction->set_parallel_desc_symbol_id(JUST(blob_object->parallel_desc_symbol()->symbol_id()));
   instruction->add_mut2_operand(blob_object->object_id());
   instruction->add_int64_operand(callback_id);
@@ -872,8 +879,9 @@ Maybe<void> InstructionsBuilder::FeedBlob(
 Maybe<void> InstructionsBuilder::ReleaseTensor(
     const std::shared_ptr<vm::EagerBlobObject>& eager_blob_object,
     const std::shared_ptr<const ParallelDesc>& parallel_desc) {
-  std::string instr_name = parallel_desc->device_tag() + ".ReleaseTensor";
-  ObjectMsgPtr<vm::InstructionMsg> instruction = ObjectMsgPtr<vm::InstructionMsg>::New(instr_name);
+  static thread_local DeviceInstrTypeIdCache instr_type_id_cache("ReleaseTensor");
+  ObjectMsgPtr<vm::InstructionMsg> instruction =
+      vm::NewInstruction(instr_type_id_cache.Get(parallel_desc->device_tag()));
   const std::shared_ptr<VmLocalDepObject>& compute_local_dep_object =
       JUST(eager_blob_object->compute_local_dep_object());
   *instruction->mutable_phy_instr_operand() = std::make_shared<vm::ReleaseTensorArgPhyInstrOperand>(
@@ -886,8 +894,9 @@ Maybe<void> InstructionsBuilder::ReleaseTensor(
 Maybe<void> InstructionsBuilder::SoftSyncStream(
     const std::shared_ptr<VmLocalDepObject> compute_local_dep_object, const std::string& modifier,
     const std::shared_ptr<const ParallelDesc>& parallel_desc) {
+  static thread_local DeviceInstrTypeIdCache instr_type_id_cache("SoftSyncStream");
   ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New(parallel_desc->device_tag() + ".SoftSyncStream");
+      vm::NewInstruction(instr_type_id_cache.Get(parallel_desc->device_tag()));
   *instruction->mutable_phy_instr_operand() =
       std::make_shared<vm::SoftSyncStreamPhyInstrOperand>(compute_local_dep_object, modifier);
   *instruction->mut_parallel_desc() = parallel_desc;
@@ -914,8 +923,9 @@ Maybe<void> InstructionsBuilder::AccessBlobByCallback(const T tensor,
                                                       const std::function<void(uint64_t)>& callback,
                                                       const std::string& modifier) {
   const auto& parallel_desc = GetParallelDesc(tensor);
-  std::string instr_name = parallel_desc->device_tag() + ".AccessBlobByCallback";
-  ObjectMsgPtr<vm::InstructionMsg> instruction = ObjectMsgPtr<vm::InstructionMsg>::New(instr_name);
+  static thread_local DeviceInstrTypeIdCache instr_type_id_cache("AccessBlobByCallback");
+  ObjectMsgPtr<vm::InstructionMsg> instruction =
+      vm::NewInstruction(instr_type_id_cache.Get(parallel_desc->device_tag()));
   const std::shared_ptr<vm::EagerBlobObject>& eager_blob_object = JUST(tensor->eager_blob_object());
   const std::shared_ptr<VmLocalDepObject>& compute_local_dep_object =
       JUST(tensor->compute_local_dep_object());
@@ -936,8 +946,7 @@ template Maybe<void> InstructionsBuilder::AccessBlobByCallback(
 
 Maybe<void> InstructionsBuilder::ComputeRankFrontSeqCallback(
     const std::function<void()>& callback) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("ComputeRankFrontSeqCallback");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("ComputeRankFrontSeqCallback");
   instruction->add_int64_operand(GlobalProcessCtx::Rank());
   *instruction->mutable_phy_instr_operand() =
       std::make_shared<vm::NoArgCbPhyInstrOperand>(callback);
@@ -946,8 +955,7 @@ Maybe<void> InstructionsBuilder::ComputeRankFrontSeqCallback(
 }
 
 Maybe<void> InstructionsBuilder::ComputeGlobalFrontSeqBarrier() {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("ComputeGlobalFrontSeqBarrier");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("ComputeGlobalFrontSeqBarrier");
   instruction_list_->PushBack(instruction.Mutable());
   return Maybe<void>::Ok();
 }
@@ -965,8 +973,7 @@ Maybe<void> InstructionsBuilder::FetchBlobBody(
 }
 
 Maybe<void> InstructionsBuilder::_TryClearObject(compatible_py::Object* blob_object) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("TryClearObject");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("TryClearObject");
   instruction->set_parallel_desc_symbol_id(JUST(blob_object->parallel_desc_symbol()->symbol_id()));
   instruction->add_mut_operand(blob_object->object_id());
   instruction_list_->PushBack(instruction.Mutable());
@@ -974,8 +981,7 @@ Maybe<void> InstructionsBuilder::_TryClearObject(compatible_py::Object* blob_obj
 }
 
 Maybe<void> InstructionsBuilder::_DeleteObject(compatible_py::Object* blob_object) {
-  ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New("DeleteObject");
+  ObjectMsgPtr<vm::InstructionMsg> instruction = vm::NewInstruction("DeleteObject");
   instruction->set_parallel_desc_symbol_id(JUST(blob_object->parallel_desc_symbol()->symbol_id()));
   instruction->add_del_operand(blob_object->object_id());
   instruction_list_->PushBack(instruction.Mutable());
@@ -999,7 +1005,7 @@ Maybe<void> InstructionsBuilder::_StatefulCallOpKernel(
         std::pair<std::shared_ptr<StringSymbol>, std::shared_ptr<compatible_py::BlobObject>>>&
         mut2_operand_blob_objects) {
   ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New(parallel_desc_sym->device_tag() + "." + instr_name);
+      vm::NewInstruction(parallel_desc_sym->device_tag() + "." + instr_name);
   instruction->set_parallel_desc_symbol_id(JUST(parallel_desc_sym->symbol_id()));
   instruction->add_mut_operand(opkernel_object->object_id());
   instruction->add_symbol_operand(JUST(op_node_signature_sym->symbol_id()));
@@ -1059,7 +1065,7 @@ Maybe<void> InstructionsBuilder::_StatelessCallOpKernel(
         std::pair<std::shared_ptr<StringSymbol>, std::shared_ptr<compatible_py::BlobObject>>>&
         mut2_operand_blob_objects) {
   ObjectMsgPtr<vm::InstructionMsg> instruction =
-      ObjectMsgPtr<vm::InstructionMsg>::New(parallel_desc_sym->device_tag() + "." + instr_name);
+      vm::NewInstruction(parallel_desc_sym->device_tag() + "." + instr_name);
   instruction->set_parallel_desc_symbol_id(JUST(parallel_desc_sym->symbol_id()));
   instruction->add_symbol_operand(JUST(job_desc_sym->symbol_id()));
   instruction->add_symbol_operand(JUST(op_conf_sym->symbol_id()));
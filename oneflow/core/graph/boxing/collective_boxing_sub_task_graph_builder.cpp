@@ -35,13 +35,13 @@ using namespace boxing::collective;
 
 namespace {
 
-void NcclInitCollectiveNode(CollectiveBoxingGenericTaskNode* node,
-                            const ParallelDesc& parallel_desc, int64_t parallel_id,
-                            const std::string& name, const LogicalBlobId& lbi,
-                            const BlobDesc& logical_blob_desc, OpType op_type, int64_t root) {
+OperatorConf GenCollectiveBoxingOpConf(const ParallelDesc& parallel_desc, int64_t parallel_id,
+                                       const std::string& name, const LogicalBlobId& lbi,
+                                       const BlobDesc& logical_blob_desc, OpType op_type,
+                                       int64_t root, DeviceType device_type, Backend backend) {
   OperatorConf op_conf;
   op_conf.set_name(name);
-  op_conf.set_device_tag(*CHECK_JUST(DeviceTag4DeviceType(DeviceType::kGPU)));
+  op_conf.set_device_tag(*CHECK_JUST(DeviceTag4DeviceType(device_type)));
   CollectiveBoxingGenericOpConf* conf = op_conf.mutable_collective_boxing_generic_conf();
   *conf->mutable_lbi() = lbi;
   RankDesc* rank_desc = conf->mutable_rank_desc();
@@ -62,9 +62,18 @@ void NcclInitCollectiveNode(CollectiveBoxingGenericTaskNode* node,
   } else {
     CHECK_EQ(root, -1);
   }
-  op_desc->set_backend(Backend::kBackendNCCL);
+  op_desc->set_backend(backend);
   rank_desc->set_rank(parallel_id);
+  return op_conf;
+}
 
+void NcclInitCollectiveNode(CollectiveBoxingGenericTaskNode* node,
+                            const ParallelDesc& parallel_desc, int64_t parallel_id,
+                            const std::string& name, const LogicalBlobId& lbi,
+                            const BlobDesc& logical_blob_desc, OpType op_type, int64_t root) {
+  const OperatorConf op_conf =
+      GenCollectiveBoxingOpConf(parallel_desc, parallel_id, name, lbi, logical_blob_desc, op_type,
+                                root, DeviceType::kGPU, Backend::kBackendNCCL);
   const int64_t machine_id = CHECK_JUST(parallel_desc.MachineId4ParallelId(parallel_id));
   const int64_t device_index = CHECK_JUST(parallel_desc.DeviceId4ParallelId(parallel_id));
   DeviceId device_id{static_cast<DeviceId::rank_t>(machine_id), DeviceType::kGPU,
@@ -77,6 +86,31 @@ void NcclInitCollectiveNode(CollectiveBoxingGenericTaskNode* node,
   node->Init(machine_id, thrd_id, lbi, op_conf);
 }
 
+void CpuInitCollectiveNode(CollectiveBoxingGenericTaskNode* node,
+                           const ParallelDesc& parallel_desc, int64_t parallel_id,
+                           const std::string& name, const LogicalBlobId& lbi,
+                           const BlobDesc& logical_blob_desc, OpType op_type, int64_t root) {
+  const OperatorConf op_conf =
+      GenCollectiveBoxingOpConf(parallel_desc, parallel_id, name, lbi, logical_blob_desc, op_type,
+                                root, DeviceType::kCPU, Backend::kBackendCPU);
+  const int64_t machine_id = CHECK_JUST(parallel_desc.MachineId4ParallelId(parallel_id));
+  const int64_t thrd_id = Global<IDMgr>::Get()->PickCpuThrdIdEvenly(machine_id);
+  node->Init(machine_id, thrd_id, lbi, op_conf);
+}
+
+bool IsCpuCollectiveBoxingSupported(const ParallelDesc& in_parallel_desc,
+                                    const ParallelDesc& out_parallel_desc,
+                                    const BlobDesc& logical_blob_desc) {
+  const DataType data_type = logical_blob_desc.data_type();
+  return in_parallel_desc.device_type() == DeviceType::kCPU
+         && out_parallel_desc.device_type() == DeviceType::kCPU
+         && out_parallel_desc.parallel_num() > 1
+         && !SubTskGphBuilderUtil::BlobHasDynamicShape(logical_blob_desc)
+         && (data_type == DataType::kFloat || data_type == DataType::kDouble
+             || data_type == DataType::kInt8 || data_type == DataType::kInt32
+             || data_type == DataType::kInt64);
+}
+
 int64_t FindRootParallelId(const ParallelDesc& multi_device, const ParallelDesc& sole_device) {
   CHECK_EQ(sole_device.parallel_num(), 1);
   const int64_t root_machine_id = CHECK_JUST(sole_device.MachineId4ParallelId(0));
@@ -551,6 +585,152 @@ class NcclCollectiveBoxingAll2AllSubTskGphBuilder final : public SubTskGphBuilde
   }
 };
 
+class CpuCollectiveBoxingAllReduceSubTskGphBuilder final : public SubTskGphBuilder {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuCollectiveBoxingAllReduceSubTskGphBuilder);
+  CpuCollectiveBoxingAllReduceSubTskGphBuilder() = default;
+  ~CpuCollectiveBoxingAllReduceSubTskGphBuilder() override = default;
+
+  Maybe<SubTskGphBuilderStatus> Build(
+      SubTskGphBuilderCtx* ctx, const std::vector<TaskNode*>& sorted_in_tasks,
+      std::vector<TaskNode*>* sorted_out_tasks,
+      std::vector<std::vector<TaskNode*>>* sorted_ctrl_tasks, const ParallelDesc& in_parallel_desc,
+      const ParallelDesc& out_parallel_desc, const LogicalBlobId& lbi,
+      const BlobDesc& logical_blob_desc, const SbpParallel& in_sbp_parallel,
+      const SbpParallel& out_sbp_parallel, const Shape& time_shape) const override {
+    if (out_parallel_desc.Equals(in_parallel_desc)
+        && IsCpuCollectiveBoxingSupported(in_parallel_desc, out_parallel_desc, logical_blob_desc)
+        && SubTskGphBuilderUtil::IsBoxingP2B(in_sbp_parallel, out_sbp_parallel)) {
+      const std::string op_name = "System-Boxing-CpuCollectiveBoxingAllReduce-" + NewUniqueId();
+      FOR_RANGE(int64_t, i, 0, in_parallel_desc.parallel_num()) {
+        TaskNode* in_node = sorted_in_tasks.at(i);
+        auto* collective_node = ctx->task_graph()->NewNode<CollectiveBoxingGenericTaskNode>();
+        CpuInitCollectiveNode(collective_node, in_parallel_desc, i, op_name, lbi,
+                              logical_blob_desc, OpType::kOpTypeAllReduce, -1);
+        ctx->task_graph()->ConnectWithLbi(in_node, collective_node, lbi);
+        sorted_out_tasks->push_back(collective_node);
+      }
+      return TRY(BuildSubTskGphBuilderStatus("CpuCollectiveBoxingAllReduceSubTskGphBuilder", ""));
+    } else {
+      return Error::BoxingNotSupportedError();
+    }
+  }
+};
+
+class CpuCollectiveBoxingReduceScatterSubTskGphBuilder final : public SubTskGphBuilder {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuCollectiveBoxingReduceScatterSubTskGphBuilder);
+  CpuCollectiveBoxingReduceScatterSubTskGphBuilder() = default;
+  ~CpuCollectiveBoxingReduceScatterSubTskGphBuilder() override = default;
+
+  Maybe<SubTskGphBuilderStatus> Build(
+      SubTskGphBuilderCtx* ctx, const std::vector<TaskNode*>& sorted_in_tasks,
+      std::vector<TaskNode*>* sorted_out_tasks,
+      std::vector<std::vector<TaskNode*>>* sorted_ctrl_tasks, const ParallelDesc& in_parallel_desc,
+      const ParallelDesc& out_parallel_desc, const LogicalBlobId& lbi,
+      const BlobDesc& logical_blob_desc, const SbpParallel& in_sbp_parallel,
+      const SbpParallel& out_sbp_parallel, const Shape& time_shape) const override {
+    if (out_parallel_desc.Equals(in_parallel_desc)
+        && IsCpuCollectiveBoxingSupported(in_parallel_desc, out_parallel_desc, logical_blob_desc)
+        && logical_blob_desc.shape().At(0) % out_parallel_desc.parallel_num() == 0
+        && SubTskGphBuilderUtil::IsBoxingP2S(in_sbp_parallel, out_sbp_parallel)
+        && out_sbp_parallel.split_parallel().axis() == 0) {
+      const std::string op_name =
+          "System-Boxing-CpuCollectiveBoxingReduceScatter-" + NewUniqueId();
+      FOR_RANGE(int64_t, i, 0, in_parallel_desc.parallel_num()) {
+        TaskNode* in_node = sorted_in_tasks.at(i);
+        auto* collective_node = ctx->task_graph()->NewNode<CollectiveBoxingGenericTaskNode>();
+        CpuInitCollectiveNode(collective_node, in_parallel_desc, i, op_name, lbi,
+                              logical_blob_desc, OpType::kOpTypeReduceScatter, -1);
+        ctx->task_graph()->ConnectWithLbi(in_node, collective_node, lbi);
+        sorted_out_tasks->push_back(collective_node);
+      }
+      return TRY(
+          BuildSubTskGphBuilderStatus("CpuCollectiveBoxingReduceScatterSubTskGphBuilder", ""));
+    } else {
+      return Error::BoxingNotSupportedError();
+    }
+  }
+};
+
+class CpuCollectiveBoxingAllGatherSubTskGphBuilder final : public SubTskGphBuilder {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuCollectiveBoxingAllGatherSubTskGphBuilder);
+  CpuCollectiveBoxingAllGatherSubTskGphBuilder() = default;
+  ~CpuCollectiveBoxingAllGatherSubTskGphBuilder() override = default;
+
+  Maybe<SubTskGphBuilderStatus> Build(
+      SubTskGphBuilderCtx* ctx, const std::vector<TaskNode*>& sorted_in_tasks,
+      std::vector<TaskNode*>* sorted_out_tasks,
+      std::vector<std::vector<TaskNode*>>* sorted_ctrl_tasks, const ParallelDesc& in_parallel_desc,
+      const ParallelDesc& out_parallel_desc, const LogicalBlobId& lbi,
+      const BlobDesc& logical_blob_desc, const SbpParallel& in_sbp_parallel,
+      const SbpParallel& out_sbp_parallel, const Shape& time_shape) const override {
+    if (out_parallel_desc.Equals(in_parallel_desc)
+        && IsCpuCollectiveBoxingSupported(in_parallel_desc, out_parallel_desc, logical_blob_desc)
+        && logical_blob_desc.shape().At(0) % out_parallel_desc.parallel_num() == 0
+        && SubTskGphBuilderUtil::IsBoxingS2B(in_sbp_parallel, out_sbp_parallel)
+        && in_sbp_parallel.split_parallel().axis() == 0) {
+      const std::string op_name = "System-Boxing-CpuCollectiveBoxingAllGather-" + NewUniqueId();
+      FOR_RANGE(int64_t, i, 0, in_parallel_desc.parallel_num()) {
+        TaskNode* in_node = sorted_in_tasks.at(i);
+        auto* collective_node = ctx->task_graph()->NewNode<CollectiveBoxingGenericTaskNode>();
+        CpuInitCollectiveNode(collective_node, in_parallel_desc, i, op_name, lbi,
+                              logical_blob_desc, OpType::kOpTypeAllGather, -1);
+        ctx->task_graph()->ConnectWithLbi(in_node, collective_node, lbi);
+        sorted_out_tasks->push_back(collective_node);
+      }
+      return TRY(BuildSubTskGphBuilderStatus("CpuCollectiveBoxingAllGatherSubTskGphBuilder", ""));
+    } else {
+      return Error::BoxingNotSupportedError();
+    }
+  }
+};
+
+class CpuCollectiveBoxingBroadcastSubTskGphBuilder final : public SubTskGphBuilder {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuCollectiveBoxingBroadcastSubTskGphBuilder);
+  CpuCollectiveBoxingBroadcastSubTskGphBuilder() = default;
+  ~CpuCollectiveBoxingBroadcastSubTskGphBuilder() override = default;
+
+  Maybe<SubTskGphBuilderStatus> Build(
+      SubTskGphBuilderCtx* ctx, const std::vector<TaskNode*>& sorted_in_tasks,
+      std::vector<TaskNode*>* sorted_out_tasks,
+      std::vector<std::vector<TaskNode*>>* sorted_ctrl_tasks, const ParallelDesc& in_parallel_desc,
+      const ParallelDesc& out_parallel_desc, const LogicalBlobId& lbi,
+      const BlobDesc& logical_blob_desc, const SbpParallel& in_sbp_parallel,
+      const SbpParallel& out_sbp_parallel, const Shape& time_shape) const override {
+    if (in_parallel_desc.parallel_num() == 1
+        && IsCpuCollectiveBoxingSupported(in_parallel_desc, out_parallel_desc, logical_blob_desc)
+        && out_sbp_parallel.has_broadcast_parallel()) {
+      const int64_t root_parallel_id =
+          SubTskGphBuilderUtil::FindNearestSrcParallelId(out_parallel_desc, in_parallel_desc, 0);
+      if (root_parallel_id == -1) { return Error::BoxingNotSupportedError(); }
+      TaskNode* in_node = ctx->task_graph()->GetProxyNode(sorted_in_tasks.front(), lbi,
+                                                          out_parallel_desc, root_parallel_id);
+      const std::string op_name = "System-Boxing-CpuCollectiveBoxingBroadcast-" + NewUniqueId();
+      FOR_RANGE(int64_t, i, 0, out_parallel_desc.parallel_num()) {
+        auto* collective_node = ctx->task_graph()->NewNode<CollectiveBoxingGenericTaskNode>();
+        CpuInitCollectiveNode(collective_node, out_parallel_desc, i, op_name, lbi,
+                              logical_blob_desc, OpType::kOpTypeBroadcast, root_parallel_id);
+        if (i == root_parallel_id) {
+          ctx->task_graph()->ConnectWithLbi(in_node, collective_node, lbi);
+        } else {
+          std::string regst_desc_name;
+          in_node->BuildCtrlRegstDesc(collective_node, &regst_desc_name);
+          TaskEdge* edge = ctx->task_graph()->NewEdge();
+          Connect<TaskNode>(in_node, edge, collective_node);
+          in_node->BindEdgeWithProducedRegst(edge, regst_desc_name);
+        }
+        sorted_out_tasks->push_back(collective_node);
+      }
+      return TRY(BuildSubTskGphBuilderStatus("CpuCollectiveBoxingBroadcastSubTskGphBuilder", ""));
+    } else {
+      return Error::BoxingNotSupportedError();
+    }
+  }
+};
+
 }  // namespace
 
 CollectiveBoxingSubTskGphBuilder::CollectiveBoxingSubTskGphBuilder() {
@@ -570,6 +750,16 @@ CollectiveBoxingSubTskGphBuilder::CollectiveBoxingSubTskGphBuilder() {
     builders.emplace_back(new NcclCollectiveBoxingAll2AllSubTskGphBuilder());
 #else
     LOG(WARNING) << "nccl_enable_all_to_all is unavailable unless NCCL_VERSION > 2.7.0";
+#endif
+  }
+  if (collective_boxing_conf.cpu_enable_collective_boxing()) {
+#ifdef __linux__
+    builders.emplace_back(new CpuCollectiveBoxingAllReduceSubTskGphBuilder());
+    builders.emplace_back(new CpuCollectiveBoxingReduceScatterSubTskGphBuilder());
+    builders.emplace_back(new CpuCollectiveBoxingAllGatherSubTskGphBuilder());
+    builders.emplace_back(new CpuCollectiveBoxingBroadcastSubTskGphBuilder());
+#else
+    LOG(WARNING) << "cpu_enable_collective_boxing is only available on linux";
 #endif
   }
   chain_builder_.reset(new ChainSubTskGphBuilder(builders));
@@ -32,6 +32,7 @@ class NormalForwardCompTaskNode final : public CompTaskNode {
   TaskType GetTaskType() const override { return TaskType::kNormalForward; }
 
  private:
+  void InitProducedRegstMemCase(MemoryCase*) override;
   void ProduceOutRegstByNameAndBlockNum(const std::string& name, size_t mem_block_num);
   void BuildExecGphAndRegst() override;
   void BuildExecGphStructAndBindInRegst();
@@ -36,6 +36,20 @@ std::string GetOutRegstNameByObn(const std::string& obn) { return "__" + obn; }
 
 }  // namespace
 
+void NormalForwardCompTaskNode::InitProducedRegstMemCase(MemoryCase* mem_case) {
+  const OperatorConf& op_conf = op()->op_conf();
+  if (op_conf.has_variable_conf() && op_conf.variable_conf().offload()) {
+    if (device_type() == DeviceType::kGPU) {
+      // the kernels on gpu access the pinned host memory directly
+      mem_case->mutable_host_mem()->mutable_cuda_pinned_mem()->set_device_id(GpuPhyId());
+    } else {
+      mem_case->mutable_host_mem()->set_file_backed(true);
+    }
+  } else {
+    CompTaskNode::InitProducedRegstMemCase(mem_case);
+  }
+}
+
 void NormalForwardCompTaskNode::ProduceOutRegstByNameAndBlockNum(const std::string& name,
                                                                  size_t mem_block_num) {
   if (mem_block_num != -1) {
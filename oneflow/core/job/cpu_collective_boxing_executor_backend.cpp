@@ -0,0 +1,482 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifdef __linux__
+
+#include "oneflow/core/job/cpu_collective_boxing_executor_backend.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/control/global_process_ctx.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/transport/transport.h"
+
+namespace oneflow {
+
+namespace boxing {
+
+namespace collective {
+
+namespace {
+
+constexpr uint64_t kCpuCollectiveTokenTag = 0xCULL;
+constexpr int64_t kMaxNumRequests = 1 << 16;
+constexpr int64_t kMaxNumRanks = 1 << 10;
+
+int64_t Mod(int64_t a, int64_t n) { return ((a % n) + n) % n; }
+
+bool IsPowerOfTwo(int64_t n) { return n > 0 && (n & (n - 1)) == 0; }
+
+template<typename T>
+void SumInto(T* dst, const T* src, int64_t n) {
+  for (int64_t i = 0; i < n; ++i) { dst[i] += src[i]; }
+}
+
+void SumInto(DataType data_type, void* dst, const void* src, int64_t n) {
+  switch (data_type) {
+#define MAKE_SUM_INTO_CASE(type_cpp, type_proto)                                         \
+  case type_proto:                                                                       \
+    SumInto<type_cpp>(static_cast<type_cpp*>(dst), static_cast<const type_cpp*>(src), n); \
+    break;
+    OF_PP_FOR_EACH_TUPLE(MAKE_SUM_INTO_CASE, FLOATING_DATA_TYPE_SEQ INT_DATA_TYPE_SEQ)
+#undef MAKE_SUM_INTO_CASE
+    default: UNIMPLEMENTED() << "cpu collective boxing does not support " << data_type;
+  }
+}
+
+// The send and receive side of one execution of a request on one rank. Transfers are matched by
+// token, which is made of the request id, the two ranks and the number of earlier transfers
+// between them in this direction.
+class CpuCollectiveComm final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuCollectiveComm);
+  CpuCollectiveComm(const RequestDesc* request, int64_t request_id, int64_t rank,
+                    HashMap<int64_t, int64_t>* peer2send_cnt,
+                    HashMap<int64_t, int64_t>* peer2recv_cnt)
+      : request_(request),
+        request_id_(request_id),
+        rank_(rank),
+        peer2send_cnt_(peer2send_cnt),
+        peer2recv_cnt_(peer2recv_cnt),
+        num_pending_(0) {}
+  ~CpuCollectiveComm() { WaitAll(); }
+
+  void Send(int64_t peer, const void* ptr, int64_t size) {
+    if (size == 0) { return; }
+    const uint64_t token = Token(rank_, peer, (*peer2send_cnt_)[peer]++);
+    AddPending();
+    Global<Transport>::Get()->Send(token, MachineId(peer), ptr, size, [this]() { Done(-1); });
+  }
+
+  // `slot` identifies the receive in WaitRecv.
+  void Recv(int64_t peer, void* ptr, int64_t size, int64_t slot) {
+    if (size == 0) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      CHECK(done_slots_.emplace(slot).second);
+      return;
+    }
+    const uint64_t token = Token(peer, rank_, (*peer2recv_cnt_)[peer]++);
+    AddPending();
+    Global<Transport>::Get()->Receive(token, MachineId(peer), ptr, size,
+                                      [this, slot]() { Done(slot); });
+  }
+
+  void WaitRecv(int64_t slot) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this, slot]() { return done_slots_.count(slot) > 0; });
+    done_slots_.erase(slot);
+  }
+
+  void WaitAll() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]() { return num_pending_ == 0; });
+  }
+
+ private:
+  uint64_t Token(int64_t src, int64_t dst, int64_t cnt) const {
+    return (kCpuCollectiveTokenTag << 60) | (static_cast<uint64_t>(request_id_ & 0xFFFF) << 44)
+           | (static_cast<uint64_t>(src & 0x3FF) << 34) | (static_cast<uint64_t>(dst & 0x3FF) << 24)
+           | static_cast<uint64_t>(cnt & 0xFFFFFF);
+  }
+
+  int64_t MachineId(int64_t peer) const {
+    return request_->device_set().device(peer).machine_id();
+  }
+
+  void AddPending() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    num_pending_ += 1;
+  }
+
+  void Done(int64_t slot) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (slot >= 0) { CHECK(done_slots_.emplace(slot).second); }
+    num_pending_ -= 1;
+    cond_.notify_all();
+  }
+
+  const RequestDesc* request_;
+  const int64_t request_id_;
+  const int64_t rank_;
+  HashMap<int64_t, int64_t>* peer2send_cnt_;
+  HashMap<int64_t, int64_t>* peer2recv_cnt_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  HashSet<int64_t> done_slots_;
+  int64_t num_pending_;
+};
+
+// Element ranges of the segments of a buffer, and of the chunks of every segment.
+class SegmentChunks final {
+ public:
+  SegmentChunks(int64_t elem_cnt, int64_t num_segments, int64_t chunk_elem_cnt)
+      : splitter_(elem_cnt, num_segments), chunk_elem_cnt_(chunk_elem_cnt) {
+    max_segment_elem_cnt_ = 0;
+    FOR_RANGE(int64_t, i, 0, num_segments) {
+      max_segment_elem_cnt_ = std::max(max_segment_elem_cnt_, splitter_.At(i).size());
+    }
+    max_num_chunks_ = NumChunks(max_segment_elem_cnt_);
+  }
+
+  Range Segment(int64_t i) const { return splitter_.At(i); }
+  int64_t NumChunks(int64_t segment_elem_cnt) const {
+    return (segment_elem_cnt + chunk_elem_cnt_ - 1) / chunk_elem_cnt_;
+  }
+  int64_t NumChunksOf(int64_t segment) const { return NumChunks(Segment(segment).size()); }
+  // Range of the chunk relative to the begin of the segment.
+  Range Chunk(int64_t segment, int64_t chunk) const {
+    const int64_t begin = chunk * chunk_elem_cnt_;
+    return Range(begin, std::min(begin + chunk_elem_cnt_, Segment(segment).size()));
+  }
+  int64_t max_segment_elem_cnt() const { return max_segment_elem_cnt_; }
+  int64_t max_num_chunks() const { return max_num_chunks_; }
+
+ private:
+  BalancedSplitter splitter_;
+  int64_t chunk_elem_cnt_;
+  int64_t max_segment_elem_cnt_;
+  int64_t max_num_chunks_;
+};
+
+struct CollectiveArgs {
+  CollectiveArgs(CpuCollectiveComm* p_comm, DataType p_data_type, int64_t p_rank,
+                 int64_t p_num_ranks, int64_t p_chunk_elem_cnt)
+      : comm(p_comm),
+        data_type(p_data_type),
+        elem_size(GetSizeOfDataType(p_data_type)),
+        rank(p_rank),
+        num_ranks(p_num_ranks),
+        chunk_elem_cnt(p_chunk_elem_cnt) {}
+  CpuCollectiveComm* comm;
+  DataType data_type;
+  int64_t elem_size;
+  int64_t rank;
+  int64_t num_ranks;
+  int64_t chunk_elem_cnt;
+};
+
+char* ElemPtr(const CollectiveArgs& args, void* buf, int64_t offset) {
+  return static_cast<char*>(buf) + offset * args.elem_size;
+}
+
+// After the ring reduce-scatter, segment r of `buf` on rank r is the sum of segment r over all
+// ranks. At step s, rank r sends segment (r - s - 1) to the next rank and reduces segment
+// (r - s - 2) received from the previous one, which it sends on at step s + 1. `tmp` holds
+// 2 * max_segment_elem_cnt elements so that the receives of step s + 1 can be posted while
+// step s is being reduced.
+void RingReduceScatter(const CollectiveArgs& args, int64_t elem_cnt, void* buf, void* tmp) {
+  const int64_t n = args.num_ranks;
+  const int64_t r = args.rank;
+  const int64_t next = Mod(r + 1, n);
+  const int64_t prev = Mod(r - 1, n);
+  const SegmentChunks seg(elem_cnt, n, args.chunk_elem_cnt);
+  const int64_t num_steps = n - 1;
+  auto TmpPtr = [&](int64_t step, int64_t offset) {
+    return ElemPtr(args, tmp, (step % 2) * seg.max_segment_elem_cnt() + offset);
+  };
+  auto Slot = [&](int64_t step, int64_t chunk) { return step * seg.max_num_chunks() + chunk; };
+  auto PostRecvs = [&](int64_t step) {
+    const int64_t segment = Mod(r - step - 2, n);
+    FOR_RANGE(int64_t, c, 0, seg.NumChunksOf(segment)) {
+      const Range chunk = seg.Chunk(segment, c);
+      args.comm->Recv(prev, TmpPtr(step, chunk.begin()), chunk.size() * args.elem_size,
+                      Slot(step, c));
+    }
+  };
+  auto PostSend = [&](int64_t step, int64_t c) {
+    const int64_t segment = Mod(r - step - 1, n);
+    const Range chunk = seg.Chunk(segment, c);
+    args.comm->Send(next, ElemPtr(args, buf, seg.Segment(segment).begin() + chunk.begin()),
+                    chunk.size() * args.elem_size);
+  };
+  PostRecvs(0);
+  FOR_RANGE(int64_t, c, 0, seg.NumChunksOf(Mod(r - 1, n))) { PostSend(0, c); }
+  FOR_RANGE(int64_t, s, 0, num_steps) {
+    if (s + 1 < num_steps) { PostRecvs(s + 1); }
+    const int64_t segment = Mod(r - s - 2, n);
+    FOR_RANGE(int64_t, c, 0, seg.NumChunksOf(segment)) {
+      const Range chunk = seg.Chunk(segment, c);
+      args.comm->WaitRecv(Slot(s, c));
+      SumInto(args.data_type, ElemPtr(args, buf, seg.Segment(segment).begin() + chunk.begin()),
+              TmpPtr(s, chunk.begin()), chunk.size());
+      if (s + 1 < num_steps) { PostSend(s + 1, c); }
+    }
+  }
+  args.comm->WaitAll();
+}
+
+// Segment r of `buf` on rank r is gathered to every rank. At step s, rank r sends segment
+// (r - s) to the next rank and receives segment (r - s - 1) from the previous one, every chunk
+// is forwarded as soon as it arrives.
+void RingAllGather(const CollectiveArgs& args, int64_t elem_cnt, void* buf) {
+  const int64_t n = args.num_ranks;
+  const int64_t r = args.rank;
+  const int64_t next = Mod(r + 1, n);
+  const int64_t prev = Mod(r - 1, n);
+  const SegmentChunks seg(elem_cnt, n, args.chunk_elem_cnt);
+  const int64_t num_steps = n - 1;
+  auto ChunkPtr = [&](int64_t segment, const Range& chunk) {
+    return ElemPtr(args, buf, seg.Segment(segment).begin() + chunk.begin());
+  };
+  auto Slot = [&](int64_t step, int64_t chunk) { return step * seg.max_num_chunks() + chunk; };
+  FOR_RANGE(int64_t, s, 0, num_steps) {
+    const int64_t segment = Mod(r - s - 1, n);
+    FOR_RANGE(int64_t, c, 0, seg.NumChunksOf(segment)) {
+      const Range chunk = seg.Chunk(segment, c);
+      args.comm->Recv(prev, ChunkPtr(segment, chunk), chunk.size() * args.elem_size, Slot(s, c));
+    }
+  }
+  FOR_RANGE(int64_t, c, 0, seg.NumChunksOf(r)) {
+    const Range chunk = seg.Chunk(r, c);
+    args.comm->Send(next, ChunkPtr(r, chunk), chunk.size() * args.elem_size);
+  }
+  FOR_RANGE(int64_t, s, 0, num_steps) {
+    const int64_t segment = Mod(r - s - 1, n);
+    FOR_RANGE(int64_t, c, 0, seg.NumChunksOf(segment)) {
+      args.comm->WaitRecv(Slot(s, c));
+      if (s + 1 < num_steps) {
+        const Range chunk = seg.Chunk(segment, c);
+        args.comm->Send(next, ChunkPtr(segment, chunk), chunk.size() * args.elem_size);
+      }
+    }
+  }
+  args.comm->WaitAll();
+}
+
+// Recursive halving reduce-scatter followed by recursive doubling all-gather, log2(n) exchanges
+// each way instead of 2 * (n - 1), which pays off when the latency dominates. `tmp` holds
+// elem_cnt / 2 elements.
+void HalvingDoublingAllReduce(const CollectiveArgs& args, int64_t elem_cnt, void* buf, void* tmp) {
+  const int64_t n = args.num_ranks;
+  const int64_t r = args.rank;
+  CHECK(IsPowerOfTwo(n));
+  struct Exchange {
+    int64_t peer;
+    Range keep;
+    Range give;
+  };
+  std::vector<Exchange> exchanges;
+  Range range(0, elem_cnt);
+  int64_t slot = 0;
+  for (int64_t mask = 1; mask < n; mask <<= 1) {
+    const int64_t peer = r ^ mask;
+    const int64_t mid = range.begin() + range.size() / 2;
+    const Range lower(range.begin(), mid);
+    const Range upper(mid, range.end());
+    const bool keep_lower = (r & mask) == 0;
+    Exchange exchange{peer, keep_lower ? lower : upper, keep_lower ? upper : lower};
+    args.comm->Recv(peer, tmp, exchange.keep.size() * args.elem_size, slot);
+    args.comm->Send(peer, ElemPtr(args, buf, exchange.give.begin()),
+                    exchange.give.size() * args.elem_size);
+    args.comm->WaitRecv(slot);
+    SumInto(args.data_type, ElemPtr(args, buf, exchange.keep.begin()), tmp,
+            exchange.keep.size());
+    args.comm->WaitAll();
+    exchanges.push_back(exchange);
+    range = exchange.keep;
+    slot += 1;
+  }
+  for (auto it = exchanges.rbegin(); it != exchanges.rend(); ++it) {
+    args.comm->Recv(it->peer, ElemPtr(args, buf, it->give.begin()),
+                    it->give.size() * args.elem_size, slot);
+    args.comm->Send(it->peer, ElemPtr(args, buf, it->keep.begin()),
+                    it->keep.size() * args.elem_size);
+    args.comm->WaitRecv(slot);
+    args.comm->WaitAll();
+    slot += 1;
+  }
+}
+
+// Pipelined chain from the root along the ring.
+void ChainBroadcast(const CollectiveArgs& args, int64_t elem_cnt, int64_t root, const void* src,
+                    void* buf) {
+  const int64_t n = args.num_ranks;
+  const int64_t pos = Mod(args.rank - root, n);
+  const int64_t next = Mod(args.rank + 1, n);
+  const int64_t prev = Mod(args.rank - 1, n);
+  const SegmentChunks seg(elem_cnt, 1, args.chunk_elem_cnt);
+  const int64_t num_chunks = seg.NumChunksOf(0);
+  auto ChunkSize = [&](int64_t c) { return seg.Chunk(0, c).size() * args.elem_size; };
+  if (pos == 0) {
+    FOR_RANGE(int64_t, c, 0, num_chunks) {
+      args.comm->Send(next, ElemPtr(args, const_cast<void*>(src), seg.Chunk(0, c).begin()),
+                      ChunkSize(c));
+    }
+  } else {
+    FOR_RANGE(int64_t, c, 0, num_chunks) {
+      args.comm->Recv(prev, ElemPtr(args, buf, seg.Chunk(0, c).begin()), ChunkSize(c), c);
+    }
+    FOR_RANGE(int64_t, c, 0, num_chunks) {
+      args.comm->WaitRecv(c);
+      if (pos + 1 < n) {
+        args.comm->Send(next, ElemPtr(args, buf, seg.Chunk(0, c).begin()), ChunkSize(c));
+      }
+    }
+  }
+  args.comm->WaitAll();
+}
+
+}  // namespace
+
+CpuCollectiveBoxingExecutorBackend::CpuCollectiveBoxingExecutorBackend() {
+  const CollectiveBoxingConf& conf =
+      Global<ResourceDesc, ForSession>::Get()->collective_boxing_conf();
+  CHECK_GT(conf.cpu_chunk_size_kb(), 0);
+  CHECK_GE(conf.cpu_halving_doubling_threshold_kb(), 0);
+  chunk_size_ = conf.cpu_chunk_size_kb() * 1024;
+  halving_doubling_threshold_ = conf.cpu_halving_doubling_threshold_kb() * 1024;
+}
+
+CpuCollectiveBoxingExecutorBackend::~CpuCollectiveBoxingExecutorBackend() {
+  for (auto& channel : worker_channels_) { channel->Close(); }
+  for (auto& worker : workers_) { worker.join(); }
+}
+
+void CpuCollectiveBoxingExecutorBackend::Init(const CollectiveBoxingPlan& collective_boxing_plan) {
+  CHECK(Global<Transport>::Get() != nullptr);
+  // Request ids are part of the tokens, so they have to agree between machines.
+  std::vector<const RequestDesc*> requests;
+  for (const auto& job_id7request_set : collective_boxing_plan.job_id2request_set()) {
+    for (const RequestDesc& request : job_id7request_set.second.request()) {
+      if (request.op_desc().backend() == Backend::kBackendCPU) { requests.push_back(&request); }
+    }
+  }
+  std::sort(requests.begin(), requests.end(), [](const RequestDesc* a, const RequestDesc* b) {
+    return a->op_desc().name() < b->op_desc().name();
+  });
+  CHECK_LE(static_cast<int64_t>(requests.size()), kMaxNumRequests);
+  int64_t num_workers = 0;
+  FOR_RANGE(int64_t, request_id, 0, requests.size()) {
+    const RequestDesc* request = requests.at(request_id);
+    const int64_t num_ranks = request->device_set().device_size();
+    CHECK_EQ(request->op_desc().num_ranks(), num_ranks);
+    CHECK_LE(num_ranks, kMaxNumRanks);
+    auto& rank2state = name2rank2state_[request->op_desc().name()];
+    int64_t worker_id = 0;
+    FOR_RANGE(int64_t, rank, 0, num_ranks) {
+      if (request->device_set().device(rank).machine_id() != GlobalProcessCtx::Rank()) {
+        continue;
+      }
+      rank2state.emplace(rank, std::make_unique<RankState>(request, request_id, rank, worker_id));
+      worker_id += 1;
+    }
+    num_workers = std::max(num_workers, worker_id);
+  }
+  FOR_RANGE(int64_t, i, 0, num_workers) {
+    worker_channels_.emplace_back(std::make_unique<Channel<std::function<void()>>>());
+    Channel<std::function<void()>>* channel = worker_channels_.back().get();
+    workers_.emplace_back([channel]() {
+      std::function<void()> work;
+      while (channel->Receive(&work) == kChannelStatusSuccess) { work(); }
+    });
+  }
+}
+
+void CpuCollectiveBoxingExecutorBackend::ExecuteGroup(
+    const std::vector<const RequestDesc*>& group,
+    const std::vector<std::map<int64_t, RuntimeRequestInfo>>& ranks) {
+  CHECK_EQ(group.size(), ranks.size());
+  FOR_RANGE(int64_t, i, 0, group.size()) {
+    auto& rank2state = name2rank2state_.at(group.at(i)->op_desc().name());
+    for (const auto& rank7info : ranks.at(i)) {
+      RankState* state = rank2state.at(rank7info.first).get();
+      const RuntimeRequestInfo info = rank7info.second;
+      worker_channels_.at(state->worker_id)->Send([this, state, info]() {
+        Execute(state, info);
+        (*info.callback)(Maybe<void>::Ok());
+      });
+    }
+  }
+}
+
+void CpuCollectiveBoxingExecutorBackend::Execute(RankState* state,
+                                                 const RuntimeRequestInfo& info) const {
+  const OpDesc& op_desc = state->request->op_desc();
+  const int64_t num_ranks = op_desc.num_ranks();
+  const int64_t elem_cnt = Shape(op_desc.shape()).elem_cnt();
+  const int64_t elem_size = GetSizeOfDataType(op_desc.data_type());
+  const int64_t size = elem_cnt * elem_size;
+  const int64_t chunk_elem_cnt = std::max<int64_t>(chunk_size_ / elem_size, 1);
+  CpuCollectiveComm comm(state->request, state->request_id, state->rank, &state->peer2send_cnt,
+                         &state->peer2recv_cnt);
+  const CollectiveArgs args(&comm, op_desc.data_type(), state->rank, num_ranks, chunk_elem_cnt);
+  const int64_t max_segment_size = (elem_cnt + num_ranks - 1) / num_ranks * elem_size;
+  auto Scratch = [&](int64_t scratch_size) {
+    if (static_cast<int64_t>(state->scratch.size()) < scratch_size) {
+      state->scratch.resize(scratch_size);
+    }
+    return state->scratch.data();
+  };
+  if (op_desc.op_type() == OpType::kOpTypeAllReduce) {
+    CHECK_EQ(op_desc.reduce_method(), kReduceMethodSum);
+    if (info.recv_buff != info.send_buff) { std::memcpy(info.recv_buff, info.send_buff, size); }
+    if (IsPowerOfTwo(num_ranks) && size <= halving_doubling_threshold_) {
+      HalvingDoublingAllReduce(args, elem_cnt, info.recv_buff, Scratch(size / 2 + elem_size));
+    } else {
+      RingReduceScatter(args, elem_cnt, info.recv_buff, Scratch(2 * max_segment_size));
+      RingAllGather(args, elem_cnt, info.recv_buff);
+    }
+  } else if (op_desc.op_type() == OpType::kOpTypeReduceScatter) {
+    CHECK_EQ(op_desc.reduce_method(), kReduceMethodSum);
+    CHECK_EQ(elem_cnt % num_ranks, 0);
+    char* buf = Scratch(size + 2 * max_segment_size);
+    std::memcpy(buf, info.send_buff, size);
+    RingReduceScatter(args, elem_cnt, buf, buf + size);
+    const Range segment = BalancedSplitter(elem_cnt, num_ranks).At(state->rank);
+    std::memcpy(info.recv_buff, buf + segment.begin() * elem_size, segment.size() * elem_size);
+  } else if (op_desc.op_type() == OpType::kOpTypeAllGather) {
+    CHECK_EQ(elem_cnt % num_ranks, 0);
+    const Range segment = BalancedSplitter(elem_cnt, num_ranks).At(state->rank);
+    char* own = static_cast<char*>(info.recv_buff) + segment.begin() * elem_size;
+    if (own != info.send_buff) { std::memcpy(own, info.send_buff, segment.size() * elem_size); }
+    RingAllGather(args, elem_cnt, info.recv_buff);
+  } else if (op_desc.op_type() == OpType::kOpTypeBroadcast) {
+    const bool is_root = state->rank == op_desc.root();
+    ChainBroadcast(args, elem_cnt, op_desc.root(), info.send_buff, info.recv_buff);
+    if (is_root && info.recv_buff != nullptr && info.recv_buff != info.send_buff) {
+      std::memcpy(info.recv_buff, info.send_buff, size);
+    }
+  } else {
+    UNIMPLEMENTED() << "cpu collective boxing does not support op type " << op_desc.op_type();
+  }
+}
+
+}  // namespace collective
+
+}  // namespace boxing
+
+}  // namespace oneflow
+
+#endif  // __linux__
@@ -0,0 +1,84 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_CPU_COLLECTIVE_BOXING_EXECUTOR_BACKEND_H_
+#define ONEFLOW_CORE_JOB_CPU_COLLECTIVE_BOXING_EXECUTOR_BACKEND_H_
+
+#include "oneflow/core/job/collective_boxing_executor.h"
+#include "oneflow/core/common/channel.h"
+
+#ifdef __linux__
+
+namespace oneflow {
+
+namespace boxing {
+
+namespace collective {
+
+// Runs the collective boxing requests placed on cpu over Global<Transport>, which covers both
+// the ranks on this machine and the ranks on the other machines.
+//
+// AllReduce uses recursive halving-doubling for small power-of-two groups and a ring
+// reduce-scatter followed by a ring all-gather otherwise. ReduceScatter, AllGather and Broadcast
+// use the ring (the chain for Broadcast). Every segment is split into chunks of
+// cpu_chunk_size_kb, so that a rank forwards a chunk as soon as it has got it.
+//
+// The k-th local rank of every request is executed by the k-th worker thread. Groups are
+// executed in the same order on every machine, so a worker never waits for a request which is
+// queued behind the one it is running on another worker.
+class CpuCollectiveBoxingExecutorBackend : public CollectiveBoxingExecutorBackend {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuCollectiveBoxingExecutorBackend);
+  CpuCollectiveBoxingExecutorBackend();
+  ~CpuCollectiveBoxingExecutorBackend() override;
+
+  void Init(const CollectiveBoxingPlan& collective_boxing_plan) override;
+  void ExecuteGroup(const std::vector<const RequestDesc*>& group,
+                    const std::vector<std::map<int64_t, RuntimeRequestInfo>>& ranks) override;
+
+ private:
+  struct RankState {
+    RankState(const RequestDesc* p_request, int64_t p_request_id, int64_t p_rank,
+              int64_t p_worker_id)
+        : request(p_request), request_id(p_request_id), rank(p_rank), worker_id(p_worker_id) {}
+    const RequestDesc* const request;
+    const int64_t request_id;
+    const int64_t rank;
+    const int64_t worker_id;
+    // Number of transfers with each peer so far, the two ends of a transfer derive the same token
+    // from them.
+    HashMap<int64_t, int64_t> peer2send_cnt;
+    HashMap<int64_t, int64_t> peer2recv_cnt;
+    std::vector<char> scratch;
+  };
+
+  void Execute(RankState* state, const RuntimeRequestInfo& info) const;
+
+  int64_t chunk_size_;
+  int64_t halving_doubling_threshold_;
+  HashMap<std::string, HashMap<int64_t, std::unique_ptr<RankState>>> name2rank2state_;
+  std::vector<std::unique_ptr<Channel<std::function<void()>>>> worker_channels_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace collective
+
+}  // namespace boxing
+
+}  // namespace oneflow
+
+#endif  // __linux__
+
+#endif  // ONEFLOW_CORE_JOB_CPU_COLLECTIVE_BOXING_EXECUTOR_BACKEND_H_
@@ -20,6 +20,9 @@ limitations under the License.
 
 namespace oneflow {
 
+// Caller-owned host buffers lent to ForeignInputKernel must be aligned to this.
+const size_t kForeignHostBufferAlignSize = 64;
+
 class ForeignJobInstance {
  public:
   ForeignJobInstance() = default;
@@ -32,6 +35,22 @@ class ForeignJobInstance {
   virtual void PushBlob(uint64_t ofblob_ptr) const { UNIMPLEMENTED(); }
   virtual void PullBlob(uint64_t ofblob_ptr) const { UNIMPLEMENTED(); }
   virtual void Finish() const { UNIMPLEMENTED(); }
+
+  // Zero-copy variants of PushBlob/PullBlob for blobs in host memory.
+  //
+  // BorrowInputBuffer may set the shape of the input blob and return the address of a caller-owned
+  // buffer of at least ByteSizeOfBody() bytes, aligned to kForeignHostBufferAlignSize. The blob
+  // aliases that buffer until the consumers of the blob are done with it, so the buffer must stay
+  // valid until Finish() is called and its content may be overwritten by in-place consumers.
+  // Returning 0 falls back to PushBlob.
+  virtual uint64_t BorrowInputBuffer(uint64_t ofblob_ptr) const { return 0; }
+  // LendOutputBlob may keep a view of the output blob (see OfBlob::host_dptr) instead of copying
+  // it. The regst holding the blob is not reused until Release is called, which must happen
+  // exactly once and may happen on any thread, the job does not wait for it. Returning false falls
+  // back to PullBlob.
+  virtual bool LendOutputBlob(uint64_t ofblob_ptr, const std::function<void()>& Release) const {
+    return false;
+  }
 };
 
 }  // namespace oneflow
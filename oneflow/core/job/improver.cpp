@@ -371,6 +371,8 @@ void Improver::MakeMemZoneRegstDescs(const Plan& plan, MemZoneRegstDescs* mz2reg
   }
   for (const auto& task : plan.task()) {
     for (const auto& pair : task.produced_regst_desc()) {
+      // the host memory backed by a file is bounded by the disk instead
+      if (pair.second.mem_case().host_mem().file_backed()) { continue; }
       int64_t mem_zone_id = GetMemoryZoneId(pair.second.mem_case());
       mz2regst_desc->at(task.machine_id()).at(mem_zone_id).push_back(&pair.second);
     }
@@ -56,6 +56,9 @@ class JobDesc final {
   bool enable_reuse_mem() const { return job_conf_.enable_reuse_mem(); }
   bool enable_inplace() const { return job_conf_.enable_inplace(); }
   bool enable_auto_mixed_precision() const { return job_conf_.enable_auto_mixed_precision(); }
+  bool enable_cpu_auto_mixed_precision() const {
+    return job_conf_.enable_cpu_auto_mixed_precision();
+  }
   bool do_parallel_cast_before_widening_type_cast() const {
     return job_conf_.do_parallel_cast_before_widening_type_cast();
   };
@@ -67,6 +70,13 @@ class JobDesc final {
   bool has_xrt_config() const { return job_conf_.has_xrt_config(); }
   const XrtConfig& xrt_config() const { return job_conf_.xrt_config(); }
 
+  bool has_offload_conf() const { return job_conf_.has_offload_conf(); }
+  const OffloadConf& offload_conf() const { return job_conf_.offload_conf(); }
+  bool has_auto_checkpointing_conf() const { return job_conf_.has_auto_checkpointing_conf(); }
+  const AutoCheckpointingConf& auto_checkpointing_conf() const {
+    return job_conf_.auto_checkpointing_conf();
+  }
+
 #define DEFINE_FUNCTION_CONFIG_GETTER(T, func_name, field_name) \
   T func_name(const std::string& field_name) const {            \
     const AttrValue& attr_val = GetFunctionFlagVal(field_name); \
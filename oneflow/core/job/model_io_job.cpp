@@ -33,6 +33,8 @@ bool CompareVariableOpConf(const VariableOpConf& lhs, const VariableOpConf& rhs)
   var_conf_b.clear_out();
   var_conf_a.clear_trainable();
   var_conf_b.clear_trainable();
+  var_conf_a.clear_offload();
+  var_conf_b.clear_offload();
   return PbMd::Equals(var_conf_a, var_conf_b);
 }
 
@@ -92,6 +94,10 @@ void FilterVariableOps(const std::vector<std::shared_ptr<Job>>& jobs,
         } else {
           CHECK(CompareVariableOpConf(var_op_name2op_conf->at(op_conf.name()).variable_conf(),
                                       op_conf.variable_conf()));
+          // the model io jobs share the memory of the variable offloaded by any job
+          if (op_conf.variable_conf().offload()) {
+            var_op_name2op_conf->at(op_conf.name()).mutable_variable_conf()->set_offload(true);
+          }
         }
       }
     }
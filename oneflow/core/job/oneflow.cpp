@@ -246,6 +246,9 @@ void GetDeviceDesc(const TaskProto* task_proto, boxing::collective::DeviceDesc*
   device_desc->set_device_type(Global<IDMgr>::Get()->GetDeviceTypeFromThrdId(thrd_id));
   if (device_desc->device_type() == DeviceType::kGPU) {
     device_desc->set_device_id(Global<IDMgr>::Get()->GetGpuPhyIdFromThrdId(thrd_id));
+  } else if (device_desc->device_type() == DeviceType::kCPU) {
+    // All the cpu ranks of a machine share its only cpu device.
+    device_desc->set_device_id(0);
   } else {
     UNIMPLEMENTED();
   }
@@ -1108,12 +1111,36 @@ void MakePushJob(const std::string& job_name, const std::string& op_name,
   job_conf->set_default_data_type(data_type);
 }
 
+// The jobs share the memory of a variable, which is in the same memory case in all of them, so a
+// variable offloaded by a job is offloaded by the other jobs too.
+void PropagateVariableOffload(const std::vector<std::shared_ptr<Job>>& jobs) {
+  HashSet<std::string> offloaded_var_op_names;
+  for (const auto& job : jobs) {
+    for (const OperatorConf& op_conf : job->net().op()) {
+      if (op_conf.has_variable_conf() && op_conf.variable_conf().offload()) {
+        offloaded_var_op_names.insert(op_conf.name());
+      }
+    }
+  }
+  if (offloaded_var_op_names.empty()) { return; }
+  for (const auto& job : jobs) {
+    for (OperatorConf& op_conf : *job->mutable_net()->mutable_op()) {
+      if (!op_conf.has_variable_conf()) { continue; }
+      if (offloaded_var_op_names.find(op_conf.name()) == offloaded_var_op_names.end()) {
+        continue;
+      }
+      op_conf.mutable_variable_conf()->set_offload(true);
+    }
+  }
+}
+
 REGISTER_FUNCTION_CONFIG_DEF().Bool("__is_user_function__", true, "is user defined function");
 
 Maybe<void> CompileJobsAndMergePlans(const PbRpf<Job>& job_confs, Plan& plan) {
   std::vector<std::shared_ptr<Job>> jobs(job_confs.size());
   FOR_RANGE(int, i, 0, jobs.size()) { jobs.at(i).reset(new Job(job_confs.Get(i))); }
   if (jobs.size() > 1) { CheckNonDistributeOptimizerAvailable(jobs); }
+  PropagateVariableOffload(jobs);
   HashMap<std::string, ParallelBlobConf> var_op_name2parallel_blob_conf;
   FilterOpName2ParallelBlobConf({OperatorConf::kVariableConf}, jobs,
                                 &var_op_name2parallel_blob_conf);
@@ -67,6 +67,10 @@ bool ResourceDesc::enable_debug_mode() const {
 
 bool ResourceDesc::enable_dry_run() const { return std::getenv("ONEFLOW_DRY_RUN") != nullptr; }
 
+bool ResourceDesc::enable_shm_comm_net() const {
+  return std::getenv("ONEFLOW_COMM_NET_DISABLE_SHM") == nullptr;
+}
+
 CollectiveBoxingConf ResourceDesc::collective_boxing_conf() const {
   if (resource_.has_collective_boxing_conf()) {
     return resource_.collective_boxing_conf();
@@ -113,6 +117,9 @@ void ResourceDesc::DumpCudnnConf(const JobConfigProto& job_conf) {
   if (job_conf.has_cudnn_conv_enable_pseudo_half()) {
     cudnn_conf->set_cudnn_conv_enable_pseudo_half(job_conf.cudnn_conv_enable_pseudo_half());
   }
+  if (job_conf.has_cpu_conv_heuristic_search_algo()) {
+    resource_.set_cpu_conv_heuristic_search_algo(job_conf.cpu_conv_heuristic_search_algo());
+  }
 }
 
 }  // namespace oneflow
@@ -54,9 +54,14 @@ class ResourceDesc final {
   }
   bool enable_thread_local_cache() const { return resource_.enable_thread_local_cache(); }
   size_t thread_local_cache_max_size() const { return resource_.thread_local_cache_max_size(); }
+  const std::string& offload_file_dir() const { return resource_.offload_file_dir(); }
+  bool cpu_conv_heuristic_search_algo() const {
+    return resource_.cpu_conv_heuristic_search_algo();
+  }
   int32_t ComputeThreadPoolSize() const;
   bool enable_debug_mode() const;
   bool enable_dry_run() const;
+  bool enable_shm_comm_net() const;
   CollectiveBoxingConf collective_boxing_conf() const;
   bool nccl_use_compute_stream() const;
 
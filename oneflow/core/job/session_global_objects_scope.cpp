@@ -31,6 +31,7 @@ limitations under the License.
 #include "oneflow/core/framework/load_library.h"
 #include "oneflow/core/job/version.h"
 #include "oneflow/core/device/node_device_descriptor_manager.h"
+#include "oneflow/core/embedding/cpu_embedding_table.h"
 
 #ifdef WITH_CUDA
 #include "oneflow/core/device/cuda_device_descriptor.h"
@@ -103,6 +104,7 @@ Maybe<void> SessionGlobalObjectsScope::Init(const ConfigProto& config_proto) {
   Global<const IOConf>::SessionNew(config_proto.session_id(), config_proto.io_conf());
   Global<const ProfilerConf>::New(config_proto.profiler_conf());
   Global<IDMgr>::New();
+  Global<CpuEmbeddingTableManager>::New();
   if (GlobalProcessCtx::IsThisProcessMaster()
       && Global<const ProfilerConf>::Get()->collect_act_event()) {
     Global<Profiler>::New();
@@ -151,6 +153,9 @@ SessionGlobalObjectsScope::~SessionGlobalObjectsScope() {
     Global<AvailableMemDesc>::Delete();
   }
   if (Global<Profiler>::Get() != nullptr) { Global<Profiler>::Delete(); }
+  if (Global<CpuEmbeddingTableManager>::Get() != nullptr) {
+    Global<CpuEmbeddingTableManager>::Delete();
+  }
   Global<IDMgr>::Delete();
   Global<const ProfilerConf>::Delete();
   Global<const IOConf>::Delete();
@@ -13,14 +13,13 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
-
-#ifdef WITH_CUDA
-
 #include "oneflow/core/job_rewriter/auto_mixed_precision_lists.h"
 
 #include <algorithm>
 
+#ifdef WITH_CUDA
 #include "oneflow/core/device/cuda_util.h"
+#endif
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/job_rewriter/job_pass.h"
 #include "oneflow/core/job_rewriter/pass_util.h"
@@ -53,15 +52,27 @@ bool FindInNoCastRegisry(const std::string& op_type, const OpArg& op_arg) {
   return false;
 }
 
+// The gpu ops run with float16, the cpu ops having bfloat16 kernels run with bfloat16.
 std::function<bool(OpNode*)> MakePredicatorIsAllowedToRunWithHalf(const OpGraph& op_graph) {
   auto allowed_set = std::make_shared<HashSet<OpNode*>>();
+  const JobDesc& job_desc = GlobalJobDesc();
   op_graph.ForEachNode([&](OpNode* node) {
-    if (node->parallel_desc().device_type() != DeviceType::kGPU) { return; }
-    if (node->op().output_bns().size() > 0) { INSERT_CHECK(allowed_set->insert(node)); }
+    if (node->op().output_bns().empty()) { return; }
+    const DeviceType device_type = node->parallel_desc().device_type();
+    if ((device_type == DeviceType::kGPU && job_desc.enable_auto_mixed_precision())
+        || (device_type == DeviceType::kCPU && job_desc.enable_cpu_auto_mixed_precision()
+            && IsNodeInList(AutoMixedPrecisionLists::CpuBFloat16List(), node))) {
+      INSERT_CHECK(allowed_set->insert(node));
+    }
   });
   return [allowed_set](OpNode* node) -> bool { return IsKeyFound(*allowed_set, node); };
 }
 
+DataType HalfDataType4Node(const OpNode* node) {
+  return node->parallel_desc().device_type() == DeviceType::kCPU ? DataType::kBFloat16
+                                                                 : DataType::kFloat16;
+}
+
 void InsertCastOpImpl(bool f2h, const OpGraph& op_graph, const HashSet<OpNode*>& white_set,
                       JobBuilder* job_builder) {
   HashSet<OpEdge*> white_set_edges;
@@ -86,25 +97,29 @@ void InsertCastOpImpl(bool f2h, const OpGraph& op_graph, const HashSet<OpNode*>&
             << Container2Str<HashSet<OpEdge*>, OpEdge*>(white_set_edges, EdgeName4Edge);
   }
 
-  HashMap<std::string, std::vector<OpEdge*>> edges_group_by_lbn;
+  // grouped by the half data type as well, a blob may feed white nodes on both cpu and gpu
+  std::map<std::pair<std::string, DataType>, std::vector<OpEdge*>> edges_group_by_lbn;
   {
     for (OpEdge* edge : white_set_edges) {
       CHECK_EQ(1, edge->lbis().size());
       std::string lbn = GenLogicalBlobName(edge->lbis().front());
-      edges_group_by_lbn[lbn].push_back(edge);
+      const DataType half_data_type = HalfDataType4Node(f2h ? edge->dst_node() : edge->src_node());
+      edges_group_by_lbn[std::make_pair(lbn, half_data_type)].push_back(edge);
     }
   }
 
   HashMap<std::string, OperatorConf> dst_op_name2dst_op_confs;
   for (auto& pair : edges_group_by_lbn) {
-    const std::string& lbn = pair.first;
+    const std::string& lbn = pair.first.first;
+    const bool is_bfloat16 = pair.first.second == DataType::kBFloat16;
     OpNode* src_node = pair.second.front()->src_node();
 
     const BlobDesc& blob_desc = src_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(lbn));
     if (blob_desc.data_type() != DataType::kFloat) { continue; }
 
-    std::string cast_suffix = f2h ? "-cast_f2h" : "-cast_h2f";
-    DataType cast_data_type = f2h ? DataType::kFloat16 : DataType::kFloat;
+    std::string cast_suffix = f2h ? (is_bfloat16 ? "-cast_f2bf16" : "-cast_f2h")
+                                  : (is_bfloat16 ? "-cast_bf162f" : "-cast_h2f");
+    DataType cast_data_type = f2h ? pair.first.second : DataType::kFloat;
     auto cast_op = user_op::UserOpConfWrapperBuilder(ReplaceSlashToDash4Lbn(lbn) + cast_suffix)
                        .Op("cast")
                        .Input("in", lbn)
@@ -164,7 +179,8 @@ class AutoMixedPrecision final : public JobPass {
   ~AutoMixedPrecision() = default;
 
   bool IsEnabled(const JobPassCtx& ctx) const {
-    return ctx.job_desc().enable_auto_mixed_precision();
+    return ctx.job_desc().enable_auto_mixed_precision()
+           || ctx.job_desc().enable_cpu_auto_mixed_precision();
   }
 
   Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
@@ -194,7 +210,9 @@ class AutoMixedPrecision final : public JobPass {
 };
 
 Maybe<void> AutoMixedPrecision::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
-  CHECK_GE(CUDA_VERSION, 10000);
+#ifdef WITH_CUDA
+  if (GlobalJobDesc().enable_auto_mixed_precision()) { CHECK_GE(CUDA_VERSION, 10000); }
+#endif
   CHECK(GlobalJobDesc().DefaultDataType() == DataType::kFloat);
 
   VerifyAMPList(white_list_);
@@ -342,5 +360,3 @@ REGISTER_NO_CAST_REGISTRY("normalization_add_relu", "beta", 0)
 }  // namespace
 
 }  // namespace oneflow
-
-#endif  // WITH_CUDA
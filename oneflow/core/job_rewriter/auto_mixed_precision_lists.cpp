@@ -93,4 +93,21 @@ const AMPList& AutoMixedPrecisionLists::ClearList() {
   return clear_list;
 }
 
+const AMPList& AutoMixedPrecisionLists::CpuBFloat16List() {
+  static AMPList cpu_bfloat16_list = {"matmul",
+                                      "batch_matmul",
+                                      "broadcast_matmul",
+                                      "conv2d",
+                                      "amp_white_identity",
+                                      "add_n",
+                                      "bias_add",
+                                      "scalar_mul",
+                                      "relu",
+                                      "reshape",
+                                      "identity",
+                                      "parallel_cast",
+                                      "hierarchical_parallel_cast"};
+  return cpu_bfloat16_list;
+}
+
 }  // namespace oneflow
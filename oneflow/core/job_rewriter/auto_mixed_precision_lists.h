@@ -30,6 +30,8 @@ class AutoMixedPrecisionLists final {
   static const AMPList& BlackList();
   static const AMPList& GrayList();
   static const AMPList& ClearList();
+  // the ops with cpu bfloat16 kernels, for both the forward and the backward
+  static const AMPList& CpuBFloat16List();
 };
 
 }  // namespace oneflow
@@ -18,6 +18,7 @@ limitations under the License.
 #include "oneflow/core/job/scope.h"
 #include "oneflow/core/job/scope.cfg.h"
 #include "oneflow/core/job_rewriter/calculation_pass.h"
+#include "oneflow/core/job_rewriter/checkpointing_planner.h"
 #include "oneflow/core/vm/symbol_storage.h"
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/operator/operator.h"
@@ -27,22 +28,21 @@ namespace oneflow {
 namespace {
 
 // Do CheckpointingPass will use backward recomputation for sublinear memory cost.
+// The forward ops recomputed are those in a checkpointing scope, or those chosen to fit the
+// memory budget of auto_checkpointing_conf if it is set.
 class CheckpointingPass final : public JobPass {
  public:
   OF_DISALLOW_COPY_AND_MOVE(CheckpointingPass);
   CheckpointingPass() = default;
   ~CheckpointingPass() = default;
 
-  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
-    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
-    const OpGraph op_graph(*job);
-    JobBuilder job_builder(job);
-    return Apply(op_graph, &job_builder);
-  }
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override;
 
   bool IsEnabled(const JobPassCtx& ctx) const { return ctx.job_desc().IsTrain(); }
 
-  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+  Maybe<void> Apply(const OpGraph& op_graph,
+                    const HashMap<std::string, const OpNode*>& checkpointing_op_name2op_node,
+                    JobBuilder* job_builder) const;
 };
 
 const std::string kCheckpointingFakeOpNamePrefix = "OneFlow-System-Checkpointing-Fake-Fw-Op_";
@@ -62,28 +62,132 @@ bool IsForwardPass7CheckpointingScope(const Scope& scope) {
   return IsForwardPassScope(scope) && scope.Bool("checkpointing");
 }
 
-void CollectAllCheckpointingOpsInForwardPass(
-    const OpGraph& op_graph, HashMap<std::string, const OpNode*>* checkpointing_op_name2op_node) {
+bool IsRecomputable(const OperatorConf& op_conf) {
   // NOTE(chengcheng):
   //   ignore batch_norm ops because of recompute bn will repeat the calculation of 'm' and 'v'.
   //   in the future, we need to support the recomputation version of batch_norm which do NOT
   //   update forward variables.
-  HashSet<std::string> ignore_op_type_names = {"normalization", "normalization_add_relu",
-                                               "cudnn_fused_normalization_add_relu", "repeat",
-                                               "unpack"};
+  static const HashSet<std::string> ignore_op_type_names = {
+      "normalization", "normalization_add_relu", "cudnn_fused_normalization_add_relu", "repeat",
+      "unpack"};
+  if (!op_conf.has_user_conf()) { return false; }
+  // the ops drawing random numbers, which all take a seed, would not reproduce their outputs
+  if (op_conf.user_conf().attr().count("seed") > 0) { return false; }
+  return ignore_op_type_names.find(op_conf.user_conf().op_type_name())
+         == ignore_op_type_names.end();
+}
+
+void CollectAllCheckpointingOpsInForwardPass(
+    const OpGraph& op_graph, HashMap<std::string, const OpNode*>* checkpointing_op_name2op_node) {
   op_graph.ForEachNode([&](const OpNode* op_node) {
     const OperatorConf& op_conf = op_node->op().op_conf();
-    if (!op_conf.has_user_conf()) { return; }
-    if (ignore_op_type_names.find(op_conf.user_conf().op_type_name())
-        != ignore_op_type_names.end()) {
-      return;
-    }
+    if (!IsRecomputable(op_conf)) { return; }
     if (IsForwardPass7CheckpointingScope(Scope4OpNode(op_node))) {
       CHECK(checkpointing_op_name2op_node->emplace(op_conf.name(), op_node).second);
     }
   });
 }
 
+bool IsAutoCheckpointingCandidate(const OpNode* op_node) {
+  const OperatorConf& op_conf = op_node->op().op_conf();
+  if (!IsRecomputable(op_conf) || !IsForwardPassScope(Scope4OpNode(op_node))) { return false; }
+  // the source ops would not reproduce their outputs
+  return !op_node->in_edges().empty();
+}
+
+int64_t PhysicalBlobBytes(const OpNode* op_node, const LogicalBlobId& lbi) {
+  const BlobDesc& logical_blob_desc = op_node->LogicalBlobDesc4Lbi(lbi);
+  const Shape physical_shape = *CHECK_JUST(
+      GetPhysicalShape(logical_blob_desc.shape(), op_node->ParallelDistribution4Lbi(lbi),
+                       op_node->parallel_desc(), 0));
+  return physical_shape.elem_cnt() * GetSizeOfDataType(logical_blob_desc.data_type());
+}
+
+// A rough estimate on one device, which is the multiply-adds of the matmuls and the
+// convolutions, and the elements read and written by the other ops
+double EstimateRecomputeCost(const OpNode* op_node) {
+  const Operator& op = op_node->op();
+  const std::string& op_type_name = op.op_conf().user_conf().op_type_name();
+  auto LogicalShape4Bn = [&](const std::string& bn) -> const Shape& {
+    return op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(bn)).shape();
+  };
+  double out_elem_cnt = 0;
+  for (const std::string& obn : op.output_bns()) {
+    out_elem_cnt += LogicalShape4Bn(obn).elem_cnt();
+  }
+  double cost = 0;
+  if (op_type_name == "matmul" || op_type_name == "batch_matmul"
+      || op_type_name == "broadcast_matmul") {
+    const Shape& a_shape = LogicalShape4Bn("a_0");
+    const bool transpose_a = user_op::UserOpConfWrapper(op.op_conf()).attr<bool>("transpose_a");
+    cost = out_elem_cnt * a_shape.At(a_shape.NumAxes() - (transpose_a ? 2 : 1));
+  } else if (op_type_name == "conv1d" || op_type_name == "conv2d" || op_type_name == "conv3d") {
+    const Shape& weight_shape = LogicalShape4Bn("weight_0");
+    cost = out_elem_cnt * weight_shape.elem_cnt() / weight_shape.At(0);
+  } else {
+    cost = out_elem_cnt;
+    for (const std::string& ibn : op.input_bns()) { cost += LogicalShape4Bn(ibn).elem_cnt(); }
+  }
+  return cost / op_node->parallel_desc().parallel_num();
+}
+
+Maybe<void> CollectCheckpointingOpsByMemoryBudget(
+    const OpGraph& op_graph, const AutoCheckpointingConf& conf,
+    HashMap<std::string, const OpNode*>* checkpointing_op_name2op_node) {
+  // the forward ops of each placement in the topological order, which are planned as a chain
+  HashMap<ParallelDesc, std::vector<const OpNode*>> parallel_desc2candidate_nodes;
+  op_graph.TopoForEachNode([&](const OpNode* op_node) {
+    if (IsAutoCheckpointingCandidate(op_node)) {
+      parallel_desc2candidate_nodes[op_node->parallel_desc()].push_back(op_node);
+    }
+  });
+  const int64_t memory_budget = conf.memory_budget_mbyte() * 1024 * 1024;
+  for (const auto& pair : parallel_desc2candidate_nodes) {
+    const std::vector<const OpNode*>& nodes = pair.second;
+    std::vector<CheckpointingCandidate> candidates;
+    candidates.reserve(nodes.size());
+    double total_cost = 0;
+    for (const OpNode* op_node : nodes) {
+      HashSet<LogicalBlobId> saved_lbis;
+      for (const OpEdge* out_edge : op_node->out_edges()) {
+        if (IsForwardPassScope(Scope4OpNode(out_edge->dst_node()))) { continue; }
+        saved_lbis.insert(out_edge->lbis().begin(), out_edge->lbis().end());
+      }
+      CheckpointingCandidate candidate{0, 0, EstimateRecomputeCost(op_node)};
+      for (const std::string& obn : op_node->op().output_bns()) {
+        const LogicalBlobId& lbi = op_node->op().BnInOp2Lbi(obn);
+        const int64_t bytes = PhysicalBlobBytes(op_node, lbi);
+        candidate.output_bytes += bytes;
+        if (saved_lbis.find(lbi) != saved_lbis.end()) { candidate.saved_bytes += bytes; }
+      }
+      total_cost += candidate.recompute_cost;
+      candidates.push_back(candidate);
+    }
+    const CheckpointingPlan plan = PlanCheckpointing(candidates, memory_budget);
+    int64_t total_saved_bytes = 0;
+    int64_t recompute_cnt = 0;
+    for (int64_t i = 0; i < nodes.size(); ++i) {
+      total_saved_bytes += candidates.at(i).saved_bytes;
+      if (!plan.recompute.at(i)) { continue; }
+      ++recompute_cnt;
+      CHECK_OR_RETURN(
+          checkpointing_op_name2op_node->emplace(nodes.at(i)->op().op_name(), nodes.at(i)).second);
+    }
+    LOG(INFO) << "CheckpointingPass recomputes " << recompute_cnt << " of " << nodes.size()
+              << " forward ops on " << pair.first.parallel_num() << " "
+              << pair.first.device_tag() << " devices, kept activations per device: "
+              << total_saved_bytes / 1024 / 1024 << "MB -> " << plan.peak_bytes / 1024 / 1024
+              << "MB with a budget of " << conf.memory_budget_mbyte() << "MB, recompute cost: "
+              << (total_cost > 0 ? plan.recompute_cost / total_cost : 0) * 100
+              << "% of the forward pass";
+    if (plan.peak_bytes > memory_budget) {
+      LOG(WARNING) << "CheckpointingPass can not fit the activations in "
+                   << conf.memory_budget_mbyte() << "MB";
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
 void GenConnectedCheckpointingSubgraphs(
     const HashMap<std::string, const OpNode*>& checkpointing_op_name2op_node,
     std::vector<HashSet<const OpNode*>>* checkpointing_subgraphs) {
@@ -121,12 +225,26 @@ void GenConnectedCheckpointingSubgraphs(
   }
 }
 
-Maybe<void> CheckpointingPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+Maybe<void> CheckpointingPass::Apply(Job* job, JobPassCtx* ctx) const {
+  if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+  const OpGraph op_graph(*job);
   // step 1. collect all checkpointing ops in forwardpass.
   HashMap<std::string, const OpNode*> checkpointing_op_name2op_node;
-  CollectAllCheckpointingOpsInForwardPass(op_graph, &checkpointing_op_name2op_node);
+  if (ctx->job_desc().has_auto_checkpointing_conf()) {
+    JUST(CollectCheckpointingOpsByMemoryBudget(op_graph, ctx->job_desc().auto_checkpointing_conf(),
+                                               &checkpointing_op_name2op_node));
+  } else {
+    CollectAllCheckpointingOpsInForwardPass(op_graph, &checkpointing_op_name2op_node);
+  }
   if (checkpointing_op_name2op_node.empty()) { return Maybe<void>::Ok(); }
+  JobBuilder job_builder(job);
+  return Apply(op_graph, checkpointing_op_name2op_node, &job_builder);
+}
 
+Maybe<void> CheckpointingPass::Apply(
+    const OpGraph& op_graph,
+    const HashMap<std::string, const OpNode*>& checkpointing_op_name2op_node,
+    JobBuilder* job_builder) const {
   // step 2. get all connected subgraphs in checkpointing ops.
   std::vector<HashSet<const OpNode*>> checkpointing_subgraphs;
   GenConnectedCheckpointingSubgraphs(checkpointing_op_name2op_node, &checkpointing_subgraphs);
@@ -0,0 +1,156 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/checkpointing_planner.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int kNumSegmentCaps = 16;
+constexpr int kNumMultiplierIters = 32;
+
+class CheckpointingPlanner final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CheckpointingPlanner);
+  explicit CheckpointingPlanner(const std::vector<CheckpointingCandidate>& candidates)
+      : candidates_(candidates) {
+    const int64_t n = candidates.size();
+    saved_prefix_.resize(n + 1, 0);
+    cost_prefix_.resize(n + 1, 0);
+    for (int64_t i = 0; i < n; ++i) {
+      saved_prefix_.at(i + 1) = saved_prefix_.at(i) + candidates.at(i).saved_bytes;
+      cost_prefix_.at(i + 1) = cost_prefix_.at(i) + candidates.at(i).recompute_cost;
+    }
+  }
+  ~CheckpointingPlanner() = default;
+
+  int64_t total_saved_bytes() const { return saved_prefix_.back(); }
+
+  // Keeps the candidates minimizing recompute_cost + multiplier * kept bytes with no recomputed
+  // segment saving more than segment_cap bytes
+  CheckpointingPlan Plan(int64_t segment_cap, double multiplier) const;
+
+ private:
+  // kept bytes of candidate `kept` whose next segment ends before candidate `end`
+  int64_t KeptBytes(int64_t kept, int64_t end) const {
+    if (kept < 0) { return 0; }
+    const auto& candidate = candidates_.at(kept);
+    return end > kept + 1 ? std::max(candidate.output_bytes, candidate.saved_bytes)
+                          : candidate.saved_bytes;
+  }
+
+  const std::vector<CheckpointingCandidate>& candidates_;
+  std::vector<int64_t> saved_prefix_;
+  std::vector<double> cost_prefix_;
+};
+
+CheckpointingPlan CheckpointingPlanner::Plan(int64_t segment_cap, double multiplier) const {
+  const int64_t n = candidates_.size();
+  // dp.at(i + 1) is the least objective with candidate i kept, where candidate -1 and n are the
+  // virtual source and sink which are always kept
+  std::vector<double> dp(n + 2, std::numeric_limits<double>::infinity());
+  std::vector<int64_t> prev(n + 2, -1);
+  dp.at(0) = 0;
+  for (int64_t i = 0; i <= n; ++i) {
+    for (int64_t j = i - 1; j >= -1; --j) {
+      if (saved_prefix_.at(i) - saved_prefix_.at(j + 1) > segment_cap) { break; }
+      if (std::isinf(dp.at(j + 1))) { continue; }
+      const double objective = dp.at(j + 1) + multiplier * KeptBytes(j, i)
+                               + (cost_prefix_.at(i) - cost_prefix_.at(j + 1));
+      if (objective < dp.at(i + 1)) {
+        dp.at(i + 1) = objective;
+        prev.at(i + 1) = j;
+      }
+    }
+  }
+  CheckpointingPlan plan;
+  plan.recompute.assign(n, true);
+  plan.recompute_cost = 0;
+  int64_t kept_bytes = 0;
+  int64_t max_segment_bytes = 0;
+  for (int64_t i = n; i >= 0; i = prev.at(i + 1)) {
+    const int64_t j = prev.at(i + 1);
+    if (i < n) { plan.recompute.at(i) = false; }
+    kept_bytes += KeptBytes(j, i);
+    plan.recompute_cost += cost_prefix_.at(i) - cost_prefix_.at(j + 1);
+    max_segment_bytes = std::max(max_segment_bytes, saved_prefix_.at(i) - saved_prefix_.at(j + 1));
+    if (j < 0) { break; }
+  }
+  plan.peak_bytes = kept_bytes + max_segment_bytes;
+  return plan;
+}
+
+bool IsBetterPlan(const CheckpointingPlan& lhs, const CheckpointingPlan& rhs,
+                  int64_t memory_budget) {
+  const bool lhs_fits = lhs.peak_bytes <= memory_budget;
+  const bool rhs_fits = rhs.peak_bytes <= memory_budget;
+  if (lhs_fits != rhs_fits) { return lhs_fits; }
+  if (!lhs_fits) { return lhs.peak_bytes < rhs.peak_bytes; }
+  if (lhs.recompute_cost != rhs.recompute_cost) { return lhs.recompute_cost < rhs.recompute_cost; }
+  return lhs.peak_bytes < rhs.peak_bytes;
+}
+
+}  // namespace
+
+CheckpointingPlan PlanCheckpointing(const std::vector<CheckpointingCandidate>& candidates,
+                                    int64_t memory_budget) {
+  CheckpointingPlanner planner(candidates);
+  const int64_t total_saved_bytes = planner.total_saved_bytes();
+  CheckpointingPlan best;
+  best.recompute.assign(candidates.size(), false);
+  best.peak_bytes = total_saved_bytes;
+  best.recompute_cost = 0;
+  if (total_saved_bytes <= memory_budget) { return best; }
+
+  int64_t min_saved_bytes = total_saved_bytes;
+  double total_cost = 0;
+  for (const auto& candidate : candidates) {
+    if (candidate.saved_bytes > 0) {
+      min_saved_bytes = std::min(min_saved_bytes, candidate.saved_bytes);
+    }
+    total_cost += candidate.recompute_cost;
+  }
+  // the multiplier is the recompute cost paid for one kept byte, which is searched between
+  // the two extremes in the log space
+  const double min_multiplier = 1e-3 * std::max(total_cost, 1.0) / total_saved_bytes;
+  const double max_multiplier = 1e3 * std::max(total_cost, 1.0) / min_saved_bytes;
+  for (int k = 0; k < kNumSegmentCaps; ++k) {
+    // segment caps in a geometric sequence from the smallest activation to all of them
+    const int64_t segment_cap = static_cast<int64_t>(
+        min_saved_bytes
+        * std::pow(static_cast<double>(total_saved_bytes) / min_saved_bytes,
+                   static_cast<double>(k) / (kNumSegmentCaps - 1)));
+    double lo = std::log(min_multiplier);
+    double hi = std::log(max_multiplier);
+    CheckpointingPlan plan = planner.Plan(segment_cap, max_multiplier);
+    if (IsBetterPlan(plan, best, memory_budget)) { best = plan; }
+    if (plan.peak_bytes > memory_budget) { continue; }
+    // the smallest multiplier keeping the plan in the budget has the least recompute cost
+    for (int iter = 0; iter < kNumMultiplierIters; ++iter) {
+      const double mid = (lo + hi) / 2;
+      plan = planner.Plan(segment_cap, std::exp(mid));
+      if (plan.peak_bytes <= memory_budget) {
+        if (IsBetterPlan(plan, best, memory_budget)) { best = plan; }
+        hi = mid;
+      } else {
+        lo = mid;
+      }
+    }
+  }
+  return best;
+}
+
+}  // namespace oneflow
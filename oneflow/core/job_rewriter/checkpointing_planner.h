@@ -0,0 +1,51 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_REWRITER_CHECKPOINTING_PLANNER_H_
+#define ONEFLOW_CORE_JOB_REWRITER_CHECKPOINTING_PLANNER_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// A forward op which may be recomputed in the backward pass, with its sizes on one device
+struct CheckpointingCandidate {
+  // bytes of the outputs consumed by the backward pass, which are kept until backward unless the
+  // op is recomputed
+  int64_t saved_bytes;
+  // bytes of all the outputs, which are kept until backward if the next ops are recomputed from
+  // them
+  int64_t output_bytes;
+  double recompute_cost;
+};
+
+struct CheckpointingPlan {
+  std::vector<bool> recompute;
+  // activations kept from the forward pass plus the largest segment recomputed at a time
+  int64_t peak_bytes;
+  double recompute_cost;
+};
+
+// Splits the candidates, in topological order, into segments of recomputed ops between kept
+// ones and picks the plan with the least recompute cost whose estimated peak fits in the
+// budget, or the one with the least peak if none fits. The segments are searched by a dynamic
+// programming for each cap on the segment size, which trades the recompute cost against the
+// kept bytes with a Lagrange multiplier.
+CheckpointingPlan PlanCheckpointing(const std::vector<CheckpointingCandidate>& candidates,
+                                    int64_t memory_budget);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_REWRITER_CHECKPOINTING_PLANNER_H_
@@ -0,0 +1,72 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/checkpointing_planner.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+std::vector<CheckpointingCandidate> UniformChain(int64_t n, int64_t bytes, double cost) {
+  return std::vector<CheckpointingCandidate>(n, CheckpointingCandidate{bytes, bytes, cost});
+}
+
+int64_t CountRecomputed(const CheckpointingPlan& plan) {
+  return std::count(plan.recompute.begin(), plan.recompute.end(), true);
+}
+
+}  // namespace
+
+TEST(CheckpointingPlanner, no_recompute_within_budget) {
+  const auto candidates = UniformChain(16, 1 << 20, 1);
+  const CheckpointingPlan plan = PlanCheckpointing(candidates, 16 << 20);
+  EXPECT_EQ(CountRecomputed(plan), 0);
+  EXPECT_EQ(plan.peak_bytes, 16 << 20);
+  EXPECT_EQ(plan.recompute_cost, 0);
+}
+
+TEST(CheckpointingPlanner, sqrt_budget) {
+  const auto candidates = UniformChain(16, 1 << 20, 1);
+  const CheckpointingPlan plan = PlanCheckpointing(candidates, 8 << 20);
+  EXPECT_LE(plan.peak_bytes, 8 << 20);
+  EXPECT_GT(CountRecomputed(plan), 0);
+  EXPECT_LT(CountRecomputed(plan), 16);
+  EXPECT_EQ(plan.recompute_cost, CountRecomputed(plan));
+}
+
+TEST(CheckpointingPlanner, recompute_cheap_ops) {
+  // the ops at the odd positions are 100 times more expensive to recompute
+  std::vector<CheckpointingCandidate> candidates;
+  for (int i = 0; i < 8; ++i) {
+    candidates.push_back({1 << 20, 1 << 20, i % 2 == 0 ? 1.0 : 100.0});
+  }
+  const CheckpointingPlan plan = PlanCheckpointing(candidates, 5 << 20);
+  EXPECT_LE(plan.peak_bytes, 5 << 20);
+  for (int i = 1; i < 8; i += 2) { EXPECT_FALSE(plan.recompute.at(i)); }
+  EXPECT_EQ(plan.recompute_cost, 4);
+}
+
+TEST(CheckpointingPlanner, least_peak_over_budget) {
+  const auto candidates = UniformChain(16, 1 << 20, 1);
+  const CheckpointingPlan plan = PlanCheckpointing(candidates, 1 << 20);
+  EXPECT_GT(plan.peak_bytes, 1 << 20);
+  EXPECT_LT(plan.peak_bytes, 16 << 20);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
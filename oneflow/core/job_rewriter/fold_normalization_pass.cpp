@@ -0,0 +1,317 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+// An inference normalization computes y = x * scale + shift per channel, with
+// scale = gamma / sqrt(moving_variance + epsilon) and shift = beta - moving_mean * scale. When x is
+// the output of a conv or a matmul, the pass folds scale into the output channels of its weight
+// and shift into its bias, and deletes the normalization.
+//
+//   conv/matmul(w) [-> bias_add(b)] -> normalization
+//   => conv/matmul(w * scale) -> bias_add(b * scale + shift)
+//
+// The variables are not known when the job is compiled, so the folded weight and bias are
+// computed by ops reading the variables, which costs a pass over the weight instead of two over
+// the activations.
+
+bool IsUserOpWithTypeName(const OperatorConf& op_conf, const std::string& op_type_name) {
+  return op_conf.has_user_conf() && op_conf.user_conf().op_type_name() == op_type_name;
+}
+
+bool IsConvOp(const OperatorConf& op_conf) {
+  return IsUserOpWithTypeName(op_conf, "conv1d") || IsUserOpWithTypeName(op_conf, "conv2d")
+         || IsUserOpWithTypeName(op_conf, "conv3d");
+}
+
+int64_t GetConsumerCount(const OpNode* node, const LogicalBlobId& lbi) {
+  int64_t consumer_cnt = 0;
+  for (const OpEdge* out_edge : node->out_edges()) {
+    if (std::find(out_edge->lbis().cbegin(), out_edge->lbis().cend(), lbi)
+        != out_edge->lbis().cend()) {
+      consumer_cnt += 1;
+    }
+  }
+  return consumer_cnt;
+}
+
+// The conv or matmul whose weight gets the scale folded in, and the blob holding its bias if any.
+struct FoldTarget {
+  const OpNode* linear_node;
+  std::string weight_lbn;
+  int32_t weight_axis;
+  const OpNode* bias_add_node;
+  std::string bias_lbn;
+};
+
+class FoldNormalizationPass final : public JobPass {
+ public:
+  FoldNormalizationPass() = default;
+  ~FoldNormalizationPass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().job_conf().enable_fold_normalization() && !ctx.job_desc().IsTrain();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+Maybe<void> FoldNormalizationPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  auto IsFoldable = [&](const OpNode* node, const OpNode* bn_node) -> bool {
+    const OperatorConf& op_conf = node->op().op_conf();
+    if (!op_conf.ctrl_in_op_name().empty()) { return false; }
+    if (ctrl_in_op_names.find(op_conf.name()) != ctrl_in_op_names.end()) { return false; }
+    return node->parallel_desc() == bn_node->parallel_desc();
+  };
+  // The single consumer of the output of a foldable conv, matmul or bias_add.
+  auto IsSoleConsumedOutput = [&](const OpNode* node, const LogicalBlobId& lbi,
+                                  const OpNode* bn_node) -> bool {
+    return IsFoldable(node, bn_node) && node->out_edges().size() == 1
+           && GetConsumerCount(node, lbi) == 1;
+  };
+  auto GetFoldTarget = [&](const OpNode* bn_node, const std::string& x_lbn, int32_t axis,
+                           FoldTarget* target) -> bool {
+    const LogicalBlobId x_lbi = GenLogicalBlobId(x_lbn);
+    const OpNode* node = op_graph.OpNode4OpName(x_lbi.op_name());
+    if (!IsSoleConsumedOutput(node, x_lbi, bn_node)) { return false; }
+    target->bias_add_node = nullptr;
+    target->bias_lbn = "";
+    if (IsUserOpWithTypeName(node->op().op_conf(), "bias_add")) {
+      const user_op::UserOpConfWrapper bias_add_conf(node->op().op_conf());
+      if (bias_add_conf.attr<int32_t>("axis") != axis) { return false; }
+      target->bias_add_node = node;
+      target->bias_lbn = bias_add_conf.input("b", 0);
+      const LogicalBlobId a_lbi = GenLogicalBlobId(bias_add_conf.input("a", 0));
+      node = op_graph.OpNode4OpName(a_lbi.op_name());
+      if (!IsSoleConsumedOutput(node, a_lbi, bn_node)) { return false; }
+    }
+    const OperatorConf& linear_op_conf = node->op().op_conf();
+    const user_op::UserOpConfWrapper linear_conf(linear_op_conf);
+    const int64_t num_axes = bn_node->LogicalBlobDesc4Lbi(x_lbi).shape().NumAxes();
+    if (IsConvOp(linear_op_conf)) {
+      const std::string& data_format = linear_conf.attr<std::string>("data_format");
+      const int32_t channel_axis = data_format == "channels_first" ? 1 : num_axes - 1;
+      if (channel_axis != axis) { return false; }
+      if (linear_conf.has_input("bias", 0)) {
+        if (target->bias_add_node != nullptr) { return false; }
+        target->bias_lbn = linear_conf.input("bias", 0);
+      }
+      target->weight_lbn = linear_conf.input("weight", 0);
+      target->weight_axis = 0;
+    } else if (IsUserOpWithTypeName(linear_op_conf, "matmul")) {
+      if (num_axes != 2 || axis != 1) { return false; }
+      if (linear_conf.has_input("_add_to_output", 0)) { return false; }
+      target->weight_lbn = linear_conf.input("b", 0);
+      target->weight_axis = linear_conf.attr<bool>("transpose_b") ? 0 : 1;
+    } else {
+      return false;
+    }
+    // Only the constant weights are worth folding.
+    const LogicalBlobId weight_lbi = GenLogicalBlobId(target->weight_lbn);
+    if (!op_graph.OpNode4OpName(weight_lbi.op_name())->op().op_conf().has_variable_conf()) {
+      return false;
+    }
+    if (node->LogicalBlobDesc4Lbi(weight_lbi).data_type()
+        != bn_node->LogicalBlobDesc4Lbi(x_lbi).data_type()) {
+      return false;
+    }
+    target->linear_node = node;
+    return true;
+  };
+
+  HashMap<std::string, OperatorConf> op_name2op_conf;
+  auto MutOpConf4Node = [&](const OpNode* node) -> OperatorConf* {
+    const std::string& op_name = node->op().op_name();
+    if (op_name2op_conf.find(op_name) == op_name2op_conf.end()) {
+      op_name2op_conf[op_name] = node->op().op_conf();
+    }
+    return &op_name2op_conf.at(op_name);
+  };
+  std::vector<OperatorConf> delete_ops;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    if (!IsUserOpWithTypeName(op_conf, "normalization")) { return; }
+    if (!IsFoldable(op_node, op_node)) { return; }
+    const user_op::UserOpConfWrapper bn_conf(op_conf);
+    if (bn_conf.attr<bool>("training")) { return; }
+    if (bn_conf.has_output("mean", 0) || bn_conf.has_input("_add_to_output", 0)) { return; }
+    const DataType data_type =
+        op_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(bn_conf.input("x", 0))).data_type();
+    if (data_type != DataType::kFloat && data_type != DataType::kDouble) { return; }
+    const int32_t axis = bn_conf.attr<int32_t>("axis");
+    FoldTarget target{};
+    if (!GetFoldTarget(op_node, bn_conf.input("x", 0), axis, &target)) { return; }
+
+    const std::string op_name_prefix = "System-FoldNormalization-" + op_conf.name() + "-";
+    const int64_t scope_symbol_id = op_conf.scope_symbol_id();
+    std::vector<OperatorConf> new_ops;
+    auto AddOp = [&](const user_op::UserOpConfWrapper& op) { new_ops.push_back(op.op_conf()); };
+    auto var_add_eps_op =
+        user_op::UserOpConfWrapperBuilder(op_name_prefix + "VarianceAddEpsilon")
+            .Op("scalar_add")
+            .Input("in", bn_conf.input("moving_variance", 0))
+            .Output("out")
+            .Attr<bool>("has_float_operand", true)
+            .Attr<bool>("has_int_operand", false)
+            .Attr<int64_t>("int_operand", 0)
+            .Attr<double>("float_operand", static_cast<double>(bn_conf.attr<float>("epsilon")))
+            .ScopeSymbolId(scope_symbol_id)
+            .Build();
+    AddOp(var_add_eps_op);
+    auto var_rsqrt_op = user_op::UserOpConfWrapperBuilder(op_name_prefix + "VarianceRsqrt")
+                            .Op("rsqrt")
+                            .Input("x", var_add_eps_op.output("out", 0))
+                            .Output("y")
+                            .ScopeSymbolId(scope_symbol_id)
+                            .Build();
+    AddOp(var_rsqrt_op);
+    auto scale_op = user_op::UserOpConfWrapperBuilder(op_name_prefix + "Scale")
+                        .Op("multiply")
+                        .Input("x", bn_conf.input("gamma", 0))
+                        .Input("y", var_rsqrt_op.output("y", 0))
+                        .Output("out")
+                        .ScopeSymbolId(scope_symbol_id)
+                        .Build();
+    AddOp(scale_op);
+    const std::string& scale_lbn = scale_op.output("out", 0);
+
+    const LogicalBlobId weight_lbi = GenLogicalBlobId(target.weight_lbn);
+    const Shape& weight_shape = target.linear_node->LogicalBlobDesc4Lbi(weight_lbi).shape();
+    DimVector scale_dim_vec(weight_shape.NumAxes(), 1);
+    scale_dim_vec.at(target.weight_axis) = weight_shape.At(target.weight_axis);
+    auto scale_reshape_op = user_op::UserOpConfWrapperBuilder(op_name_prefix + "ScaleReshape")
+                                .Op("reshape")
+                                .Input("in", scale_lbn)
+                                .Output("out")
+                                .Attr<Shape>("shape", Shape(scale_dim_vec))
+                                .ScopeSymbolId(scope_symbol_id)
+                                .Build();
+    AddOp(scale_reshape_op);
+    auto weight_op = user_op::UserOpConfWrapperBuilder(op_name_prefix + "Weight")
+                         .Op("broadcast_mul")
+                         .Input("x", target.weight_lbn)
+                         .Input("y", scale_reshape_op.output("out", 0))
+                         .Output("z")
+                         .ScopeSymbolId(scope_symbol_id)
+                         .Build();
+    AddOp(weight_op);
+
+    auto mean_scale_op = user_op::UserOpConfWrapperBuilder(op_name_prefix + "MeanScale")
+                             .Op("multiply")
+                             .Input("x", bn_conf.input("moving_mean", 0))
+                             .Input("y", scale_lbn)
+                             .Output("out")
+                             .ScopeSymbolId(scope_symbol_id)
+                             .Build();
+    AddOp(mean_scale_op);
+    auto shift_op = user_op::UserOpConfWrapperBuilder(op_name_prefix + "Shift")
+                        .Op("broadcast_sub")
+                        .Input("x", bn_conf.input("beta", 0))
+                        .Input("y", mean_scale_op.output("out", 0))
+                        .Output("z")
+                        .ScopeSymbolId(scope_symbol_id)
+                        .Build();
+    AddOp(shift_op);
+    std::string bias_lbn = shift_op.output("z", 0);
+    if (!target.bias_lbn.empty()) {
+      auto bias_scale_op = user_op::UserOpConfWrapperBuilder(op_name_prefix + "BiasScale")
+                               .Op("multiply")
+                               .Input("x", target.bias_lbn)
+                               .Input("y", scale_lbn)
+                               .Output("out")
+                               .ScopeSymbolId(scope_symbol_id)
+                               .Build();
+      AddOp(bias_scale_op);
+      auto bias_op = user_op::UserOpConfWrapperBuilder(op_name_prefix + "Bias")
+                         .Op("add_n")
+                         .Input("in", bias_scale_op.output("out", 0))
+                         .Input("in", shift_op.output("z", 0))
+                         .Output("out")
+                         .ScopeSymbolId(scope_symbol_id)
+                         .Build();
+      AddOp(bias_op);
+      bias_lbn = bias_op.output("out", 0);
+    }
+
+    OperatorConf* linear_op_conf = MutOpConf4Node(target.linear_node);
+    const user_op::UserOpConfWrapper linear_conf(*linear_op_conf);
+    const std::string weight_ibn = IsConvOp(*linear_op_conf) ? "weight_0" : "b_0";
+    const auto& old_weight_lbn =
+        ReplaceInputLbnInOpCustomizedConf(linear_op_conf, weight_ibn, weight_op.output("z", 0));
+    CHECK_EQ(old_weight_lbn, target.weight_lbn);
+    std::string y_lbn;
+    if (target.bias_add_node != nullptr) {
+      OperatorConf* bias_add_op_conf = MutOpConf4Node(target.bias_add_node);
+      CHECK_EQ(ReplaceInputLbnInOpCustomizedConf(bias_add_op_conf, "b_0", bias_lbn),
+               target.bias_lbn);
+      y_lbn = user_op::UserOpConfWrapper(*bias_add_op_conf).output("out", 0);
+    } else if (!target.bias_lbn.empty()) {
+      CHECK_EQ(ReplaceInputLbnInOpCustomizedConf(linear_op_conf, "bias_0", bias_lbn),
+               target.bias_lbn);
+      y_lbn = linear_conf.output("out", 0);
+    } else {
+      auto bias_add_op = user_op::UserOpConfWrapperBuilder(op_name_prefix + "BiasAdd")
+                             .Op("bias_add")
+                             .Input("a", linear_conf.output("out", 0))
+                             .Input("b", bias_lbn)
+                             .Output("out")
+                             .Attr<int32_t>("axis", axis)
+                             .ScopeSymbolId(scope_symbol_id)
+                             .Build();
+      AddOp(bias_add_op);
+      y_lbn = bias_add_op.output("out", 0);
+    }
+    job_builder->AddOps(op_node->parallel_desc().parallel_conf(), new_ops);
+
+    const LogicalBlobId bn_y_lbi = GenLogicalBlobId(bn_conf.output("y", 0));
+    for (const OpEdge* out_edge : op_node->out_edges()) {
+      const OpNode* consumer = out_edge->dst_node();
+      for (const std::string& ibn : consumer->op().input_bns()) {
+        if (consumer->op().BnInOp2Lbi(ibn) == bn_y_lbi) {
+          const auto& old_val =
+              ReplaceInputLbnInOpCustomizedConf(MutOpConf4Node(consumer), ibn, y_lbn);
+          CHECK_EQ(GenLogicalBlobName(bn_y_lbi), old_val);
+        }
+      }
+    }
+    delete_ops.push_back(op_conf);
+  });
+  job_builder->DelOps(delete_ops);
+  for (const auto& pair : op_name2op_conf) { job_builder->MutOpsOnlyOnce({pair.second}); }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("FoldNormalizationPass", FoldNormalizationPass);
+
+}  // namespace oneflow
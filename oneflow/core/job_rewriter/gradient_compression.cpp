@@ -0,0 +1,217 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/gradient_compression.h"
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/job/job_builder.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+const GradientCompressionRule* FindRule(const GradientCompressionConf& conf,
+                                        const std::string& variable_op_name) {
+  for (const auto& rule : conf.rule()) {
+    if (rule.variable_op_names().empty()) { return &rule; }
+    for (const auto& op_name : rule.variable_op_names()) {
+      if (op_name == variable_op_name) { return &rule; }
+    }
+  }
+  return nullptr;
+}
+
+bool IsCompressible(const GradientCompressionConf& conf, const OpNode* model_op_node,
+                    const BlobDesc& model_blob_desc) {
+  const ParallelDesc& parallel_desc = model_op_node->parallel_desc();
+  if (parallel_desc.device_type() != DeviceType::kCPU) { return false; }
+  if (parallel_desc.parallel_num() <= 1) { return false; }
+  if (parallel_desc.hierarchy()->NumAxes() != 1) { return false; }
+  if (!conf.compress_intra_machine() && parallel_desc.sorted_machine_ids().size() <= 1) {
+    return false;
+  }
+  const ParallelDistribution& parallel_distribution =
+      model_op_node->ParallelDistribution4BnInOp("out");
+  if (!parallel_distribution.sbp_parallel(0).has_broadcast_parallel()) { return false; }
+  if (!IsFloatingDataType(model_blob_desc.data_type())) { return false; }
+  return model_blob_desc.shape().elem_cnt() >= conf.min_elem_cnt();
+}
+
+// Bytes a rank receives to sum up a gradient, the dense sum is a reduce-scatter followed by an
+// all-gather while the compressed pieces of all the other ranks are gathered.
+int64_t DenseWireBytes(int64_t elem_cnt, int64_t elem_size, int64_t parallel_num) {
+  return 2 * (parallel_num - 1) * elem_cnt * elem_size / parallel_num;
+}
+
+int64_t GatherWireBytes(int64_t piece_size, int64_t parallel_num) {
+  return (parallel_num - 1) * piece_size;
+}
+
+std::string AddHalfCompression(const OpNode* model_op_node, const std::string& diff_lbn,
+                               DataType data_type, JobBuilder* job_builder) {
+  const ParallelDesc& parallel_desc = model_op_node->parallel_desc();
+  const int64_t scope_symbol_id = model_op_node->op().op_conf().scope_symbol_id();
+  const std::string prefix = "System-GradientCompression-Half-";
+  const auto compress_op = user_op::UserOpConfWrapperBuilder(prefix + "Cast-" + NewUniqueId())
+                               .Op("cast")
+                               .Input("in", diff_lbn)
+                               .Output("out")
+                               .Attr<DataType>("dtype", DataType::kFloat16)
+                               .ScopeSymbolId(scope_symbol_id)
+                               .Build();
+  // The half gradient is summed up by the boxing in front of the cast back.
+  const auto parallel_cast_op =
+      user_op::UserOpConfWrapperBuilder(prefix + "ParallelCast-" + NewUniqueId())
+          .Op("hierarchical_parallel_cast")
+          .Input("in", compress_op.output("out", 0))
+          .Output("out")
+          .Attr<std::vector<std::string>>("parallel_distribution", {"B"})
+          .Attr<std::string>("grad_mode", "auto")
+          .Attr<std::vector<std::string>>("grad_parallel_distribution",
+                                          std::vector<std::string>())
+          .ScopeSymbolId(scope_symbol_id)
+          .Build();
+  const auto decompress_op = user_op::UserOpConfWrapperBuilder(prefix + "CastBack-" + NewUniqueId())
+                                 .Op("cast")
+                                 .Input("in", parallel_cast_op.output("out", 0))
+                                 .Output("out")
+                                 .Attr<DataType>("dtype", data_type)
+                                 .ScopeSymbolId(scope_symbol_id)
+                                 .Build();
+  job_builder->AddOps(parallel_desc.parallel_conf(), {compress_op.op_conf(),
+                                                      parallel_cast_op.op_conf(),
+                                                      decompress_op.op_conf()});
+  return decompress_op.output("out", 0);
+}
+
+std::string AddTopKCompression(const OpNode* model_op_node, const std::string& diff_lbn,
+                               const Shape& shape, int64_t k, JobBuilder* job_builder) {
+  const ParallelDesc& parallel_desc = model_op_node->parallel_desc();
+  const int64_t scope_symbol_id = model_op_node->op().op_conf().scope_symbol_id();
+  const std::string prefix = "System-GradientCompression-TopK-";
+  const auto compress_op = user_op::UserOpConfWrapperBuilder(prefix + "Compress-" + NewUniqueId())
+                               .Op("top_k_gradient_compress")
+                               .Input("in", diff_lbn)
+                               .Output("values")
+                               .Output("indices")
+                               .Attr<int64_t>("k", k)
+                               .ScopeSymbolId(scope_symbol_id)
+                               .Build();
+  const auto decompress_op =
+      user_op::UserOpConfWrapperBuilder(prefix + "Decompress-" + NewUniqueId())
+          .Op("top_k_gradient_decompress")
+          .Input("values", compress_op.output("values", 0))
+          .Input("indices", compress_op.output("indices", 0))
+          .Output("out")
+          .Attr<Shape>("shape", shape)
+          .ScopeSymbolId(scope_symbol_id)
+          .Build();
+  job_builder->AddOps(parallel_desc.parallel_conf(),
+                      {compress_op.op_conf(), decompress_op.op_conf()});
+  return decompress_op.output("out", 0);
+}
+
+std::string AddOneBitCompression(const OpNode* model_op_node, const std::string& diff_lbn,
+                                 const Shape& shape, JobBuilder* job_builder) {
+  const ParallelDesc& parallel_desc = model_op_node->parallel_desc();
+  const int64_t scope_symbol_id = model_op_node->op().op_conf().scope_symbol_id();
+  const std::string prefix = "System-GradientCompression-OneBit-";
+  const auto compress_op = user_op::UserOpConfWrapperBuilder(prefix + "Compress-" + NewUniqueId())
+                               .Op("one_bit_gradient_compress")
+                               .Input("in", diff_lbn)
+                               .Output("bits")
+                               .Output("scale")
+                               .ScopeSymbolId(scope_symbol_id)
+                               .Build();
+  const auto decompress_op =
+      user_op::UserOpConfWrapperBuilder(prefix + "Decompress-" + NewUniqueId())
+          .Op("one_bit_gradient_decompress")
+          .Input("bits", compress_op.output("bits", 0))
+          .Input("scale", compress_op.output("scale", 0))
+          .Output("out")
+          .Attr<Shape>("shape", shape)
+          .ScopeSymbolId(scope_symbol_id)
+          .Build();
+  job_builder->AddOps(parallel_desc.parallel_conf(),
+                      {compress_op.op_conf(), decompress_op.op_conf()});
+  return decompress_op.output("out", 0);
+}
+
+}  // namespace
+
+Maybe<void> CompressModelDiff(JobPassCtx* ctx, const OpGraph& op_graph, JobBuilder* job_builder,
+                              HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi) {
+  const JobConfigProto& job_conf = ctx->job_desc().job_conf();
+  if (!job_conf.has_gradient_compression_conf()) { return Maybe<void>::Ok(); }
+  const GradientCompressionConf& conf = job_conf.gradient_compression_conf();
+  int64_t total_dense_wire_bytes = 0;
+  int64_t total_wire_bytes = 0;
+  for (auto& pair : *lbi2diff_lbi) {
+    const LogicalBlobId& lbi = pair.first;
+    LogicalBlobId& diff_lbi = pair.second;
+    const GradientCompressionRule* rule = FindRule(conf, lbi.op_name());
+    if (rule == nullptr
+        || rule->scheme_conf_case() == GradientCompressionRule::SCHEME_CONF_NOT_SET) {
+      continue;
+    }
+    const OpNode* model_op_node = op_graph.OpNode4OpName(lbi.op_name());
+    const BlobDesc& model_blob_desc = op_graph.GetLogicalBlobDesc(lbi);
+    if (!IsCompressible(conf, model_op_node, model_blob_desc)) { continue; }
+    const Shape& shape = model_blob_desc.shape();
+    const DataType data_type = model_blob_desc.data_type();
+    const int64_t elem_cnt = shape.elem_cnt();
+    const int64_t elem_size = GetSizeOfDataType(data_type);
+    const int64_t parallel_num = model_op_node->parallel_desc().parallel_num();
+    const int64_t dense_wire_bytes = DenseWireBytes(elem_cnt, elem_size, parallel_num);
+    const std::string diff_lbn = GenLogicalBlobName(diff_lbi);
+    std::string compressed_diff_lbn;
+    int64_t wire_bytes = 0;
+    if (rule->has_half_conf()) {
+      if (data_type != DataType::kFloat) { continue; }
+      wire_bytes = DenseWireBytes(elem_cnt, GetSizeOfDataType(DataType::kFloat16), parallel_num);
+      compressed_diff_lbn = AddHalfCompression(model_op_node, diff_lbn, data_type, job_builder);
+    } else if (rule->has_top_k_conf()) {
+      const float ratio = rule->top_k_conf().ratio();
+      CHECK_GT_OR_RETURN(ratio, 0);
+      CHECK_LE_OR_RETURN(ratio, 1);
+      const int64_t k = std::max<int64_t>(static_cast<int64_t>(std::ceil(elem_cnt * ratio)), 1);
+      wire_bytes = GatherWireBytes(k * (elem_size + GetSizeOfDataType(DataType::kInt32)),
+                                   parallel_num);
+      if (wire_bytes >= dense_wire_bytes) { continue; }
+      compressed_diff_lbn = AddTopKCompression(model_op_node, diff_lbn, shape, k, job_builder);
+    } else if (rule->has_one_bit_conf()) {
+      wire_bytes = GatherWireBytes(RoundUp(elem_cnt, 8) / 8 + elem_size, parallel_num);
+      if (wire_bytes >= dense_wire_bytes) { continue; }
+      compressed_diff_lbn = AddOneBitCompression(model_op_node, diff_lbn, shape, job_builder);
+    } else {
+      UNIMPLEMENTED_THEN_RETURN();
+    }
+    LOG(INFO) << "GradientCompression: " << lbi.op_name() << " "
+              << GradientCompressionRule::descriptor()
+                     ->FindFieldByNumber(rule->scheme_conf_case())
+                     ->name()
+              << ", bytes received per rank " << dense_wire_bytes << " -> " << wire_bytes;
+    total_dense_wire_bytes += dense_wire_bytes;
+    total_wire_bytes += wire_bytes;
+    diff_lbi = GenLogicalBlobId(compressed_diff_lbn);
+  }
+  if (total_dense_wire_bytes > 0) {
+    LOG(INFO) << "GradientCompression: bytes received per rank per step "
+              << total_dense_wire_bytes << " -> " << total_wire_bytes;
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace oneflow
@@ -0,0 +1,34 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_REWRITER_GRADIENT_COMPRESSION_H_
+#define ONEFLOW_CORE_JOB_REWRITER_GRADIENT_COMPRESSION_H_
+
+#include "oneflow/core/graph/op_graph.h"
+
+namespace oneflow {
+
+class JobPassCtx;
+
+// Compresses the gradients of the variables matched by the gradient_compression_conf of the job
+// before the boxing that sums them up across the ranks and decompresses them after it, so that
+// lbi2diff_lbi maps the variables to the decompressed gradients. Must run before
+// AddDiffParallelCast.
+Maybe<void> CompressModelDiff(JobPassCtx* ctx, const OpGraph& op_graph, JobBuilder* job_builder,
+                              HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_REWRITER_GRADIENT_COMPRESSION_H_
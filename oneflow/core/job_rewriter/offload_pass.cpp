@@ -0,0 +1,100 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/job_rewriter/calculation_pass.h"
+#include "oneflow/core/job/scope.h"
+#include "oneflow/core/vm/symbol_storage.h"
+#include "oneflow/core/operator/operator.h"
+
+namespace oneflow {
+
+namespace {
+
+// Moves the variables selected by the offload_conf of the job out of the main memory zone of
+// their devices. Their out regsts are allocated in the pinned host memory on gpu, which the
+// kernels access over the bus, and in a memory-mapped file on cpu, which the variable kernel
+// prefetches each iteration.
+class OffloadPass final : public JobPass {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(OffloadPass);
+  OffloadPass() = default;
+  ~OffloadPass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const { return ctx.job_desc().has_offload_conf(); }
+  Maybe<void> Apply(const OpGraph& op_graph, const OffloadConf& offload_conf,
+                    JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, ctx->job_desc().offload_conf(), &job_builder);
+  }
+};
+
+bool IsOptimizerPassScope(const OpNode* op_node) {
+  int64_t scope_symbol_id = op_node->op().op_conf().scope_symbol_id();
+  CHECK(Global<symbol::Storage<Scope>>::Get()->Has(scope_symbol_id));
+  const Scope& scope = Global<symbol::Storage<Scope>>::Get()->Get(scope_symbol_id);
+  return scope.scope_proto().calculation_pass_name() == kOptimizerPass;
+}
+
+Maybe<int64_t> PhysicalByteSize4Variable(const OpNode* op_node) {
+  const LogicalBlobId& lbi = op_node->op().BnInOp2Lbi("out");
+  const BlobDesc& logical_blob_desc = op_node->LogicalBlobDesc4Lbi(lbi);
+  const Shape physical_shape =
+      *JUST(GetPhysicalShape(logical_blob_desc.shape(), op_node->ParallelDistribution4Lbi(lbi),
+                             op_node->parallel_desc(), 0));
+  return physical_shape.elem_cnt() * GetSizeOfDataType(logical_blob_desc.data_type());
+}
+
+Maybe<void> OffloadPass::Apply(const OpGraph& op_graph, const OffloadConf& offload_conf,
+                               JobBuilder* job_builder) const {
+  const HashSet<std::string> variable_op_names(offload_conf.variable_op_names().begin(),
+                                               offload_conf.variable_op_names().end());
+  std::vector<OperatorConf> offloaded_op_confs;
+  int64_t offloaded_byte_size = 0;
+  JUST(op_graph.MaybeForEachNode([&](OpNode* op_node) -> Maybe<void> {
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    if (!op_conf.has_variable_conf() || op_conf.variable_conf().offload()) {
+      return Maybe<void>::Ok();
+    }
+    const bool is_selected = variable_op_names.find(op_conf.name()) != variable_op_names.end();
+    // the optimizer states are the variables created in the scope of the optimizer pass
+    const bool is_optimizer_state =
+        offload_conf.offload_optimizer_states() && IsOptimizerPassScope(op_node);
+    if (!is_selected && !is_optimizer_state) { return Maybe<void>::Ok(); }
+    const int64_t byte_size = JUST(PhysicalByteSize4Variable(op_node));
+    if (!is_selected && byte_size < offload_conf.min_byte_size()) { return Maybe<void>::Ok(); }
+    OperatorConf offloaded_op_conf(op_conf);
+    offloaded_op_conf.mutable_variable_conf()->set_offload(true);
+    offloaded_op_confs.push_back(offloaded_op_conf);
+    offloaded_byte_size += byte_size;
+    return Maybe<void>::Ok();
+  }));
+  if (offloaded_op_confs.empty()) { return Maybe<void>::Ok(); }
+  LOG(INFO) << "OffloadPass offloads " << offloaded_op_confs.size() << " variables, "
+            << offloaded_byte_size / 1024 / 1024 << "MB per device";
+  job_builder->MutOpsOnlyOnce(offloaded_op_confs);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("OffloadPass", OffloadPass);
+
+}  // namespace oneflow
@@ -170,7 +170,7 @@ std::string QuantizationSchemeAttr4QatConfig(const QatConfig& qat_config) {
 // TODO: refactor the following 4 methods by registration
 std::string QuantizationFormulaAttr4QatConfig(const QatConfig& qat_config) {
   const auto target_backend = qat_config.target_backend();
-  if (target_backend == "" || target_backend == "tensorrt7") {
+  if (target_backend == "" || target_backend == "tensorrt7" || target_backend == "oneflow_int8") {
     return "google";
   } else if (target_backend == "cambricon") {
     return "cambricon";
@@ -187,6 +187,8 @@ OpTypeSet Int8List4QatConfig(const QatConfig& qat_config) {
     return {"conv2d", "matmul"};
   } else if (target_backend == "tensorrt7") {
     return {"conv2d"};
+  } else if (target_backend == "oneflow_int8") {
+    return {"conv2d", "matmul"};
   } else {
     UNIMPLEMENTED();
   }
@@ -194,7 +196,7 @@ OpTypeSet Int8List4QatConfig(const QatConfig& qat_config) {
 
 OpTypeSet TransparentList4QatConfig(const QatConfig& qat_config) {
   const auto target_backend = qat_config.target_backend();
-  if (target_backend == "" || target_backend == "tensorrt7") {
+  if (target_backend == "" || target_backend == "tensorrt7" || target_backend == "oneflow_int8") {
     return {"reshape"};
   } else if (target_backend == "cambricon") {
     return {};
@@ -207,7 +209,8 @@ bool InsertQuantOpAfterInt8Ops4QatConfig(const QatConfig& qat_config) {
   const auto target_backend = qat_config.target_backend();
   if (target_backend == "" || target_backend == "tensorrt7") {
     return true;
-  } else if (target_backend == "cambricon") {
+  } else if (target_backend == "cambricon" || target_backend == "oneflow_int8") {
+    // the inputs of the int8 ops are observed, see QuantizedInferenceConversion
     return false;
   } else {
     UNIMPLEMENTED();
@@ -0,0 +1,185 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/job/job_builder.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+// Replaces the cpu conv2d and matmul ops whose inputs are fake quantized by quantization aware
+// training with quantized_conv2d and quantized_matmul, which compute in int8 with the scales and
+// zero points of the observers. The fake quantization ops consumed only by them are removed.
+class QuantizedInferenceConversionPass final : public JobPass {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(QuantizedInferenceConversionPass);
+  QuantizedInferenceConversionPass() = default;
+  ~QuantizedInferenceConversionPass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    const JobConfigProto& job_conf = ctx.job_desc().job_conf();
+    return job_conf.enable_quantization_aware_training() && !ctx.job_desc().IsTrain()
+           && job_conf.qat_config().target_backend() == "oneflow_int8";
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+bool IsUserOpWithType(const OpNode* node, const std::string& op_type_name) {
+  const OperatorConf& op_conf = node->op().op_conf();
+  return op_conf.has_user_conf() && op_conf.user_conf().op_type_name() == op_type_name;
+}
+
+// The fake quantization op producing the input, which has to be of the google formula in 8 bits.
+const OpNode* FindFakeQuantNode(const OpGraph& op_graph, const std::string& lbn) {
+  const OpNode* producer = op_graph.OpNode4OpName(GenLogicalBlobId(lbn).op_name());
+  if (!IsUserOpWithType(producer, "fake_quantization")) { return nullptr; }
+  const user_op::UserOpConfWrapper conf(producer->op().op_conf());
+  if (conf.attr<std::string>("quantization_formula") != "google") { return nullptr; }
+  if (conf.attr<int32_t>("quantization_bit") != 8) { return nullptr; }
+  return producer;
+}
+
+bool IsConvertible(const OpGraph& op_graph, const OpNode* node) {
+  if (node->parallel_desc().device_type() != DeviceType::kCPU) { return false; }
+  const user_op::UserOpConfWrapper conf(node->op().op_conf());
+  const LogicalBlobId out_lbi = GenLogicalBlobId(conf.output("out", 0));
+  if (node->LogicalBlobDesc4Lbi(out_lbi).data_type() != DataType::kFloat) { return false; }
+  std::string data_lbn;
+  std::string weight_lbn;
+  if (conf.op_type_name() == "conv2d") {
+    if (conf.attr<int32_t>("groups") != 1) { return false; }
+    if (conf.has_input("bias_multiplier", 0)) { return false; }
+    data_lbn = conf.input("in", 0);
+    weight_lbn = conf.input("weight", 0);
+  } else if (conf.op_type_name() == "matmul") {
+    if (conf.has_input("_add_to_output", 0)) { return false; }
+    if (node->LogicalBlobDesc4Lbi(out_lbi).shape().NumAxes() != 2) { return false; }
+    data_lbn = conf.input("a", 0);
+    weight_lbn = conf.input("b", 0);
+  } else {
+    return false;
+  }
+  const OpNode* data_fake_quant = FindFakeQuantNode(op_graph, data_lbn);
+  const OpNode* weight_fake_quant = FindFakeQuantNode(op_graph, weight_lbn);
+  if (data_fake_quant == nullptr || weight_fake_quant == nullptr) { return false; }
+  const user_op::UserOpConfWrapper data_fake_quant_conf(data_fake_quant->op().op_conf());
+  const user_op::UserOpConfWrapper weight_fake_quant_conf(weight_fake_quant->op().op_conf());
+  const std::string& scheme = data_fake_quant_conf.attr<std::string>("quantization_scheme");
+  if (weight_fake_quant_conf.attr<std::string>("quantization_scheme") != scheme) { return false; }
+  // The per-channel scales of the weight are along its first axis, which only factors out of
+  // the dot products when it is the output channels.
+  const Shape& weight_scale_shape =
+      op_graph.GetLogicalBlobDesc(GenLogicalBlobId(weight_fake_quant_conf.input("scale", 0)))
+          .shape();
+  if (conf.op_type_name() == "matmul" && weight_scale_shape.elem_cnt() > 1
+      && !conf.attr<bool>("transpose_b")) {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+Maybe<void> QuantizedInferenceConversionPass::Apply(const OpGraph& op_graph,
+                                                    JobBuilder* job_builder) const {
+  HashSet<const OpNode*> converted_nodes;
+  std::vector<OperatorConf> quantized_op_confs;
+  HashSet<const OpNode*> fake_quant_nodes;
+  op_graph.ForEachNode([&](const OpNode* node) {
+    if (!IsUserOpWithType(node, "conv2d") && !IsUserOpWithType(node, "matmul")) { return; }
+    if (!IsConvertible(op_graph, node)) { return; }
+    const user_op::UserOpConfWrapper conf(node->op().op_conf());
+    const bool is_conv = conf.op_type_name() == "conv2d";
+    const std::string data_ibn = is_conv ? "in" : "a";
+    const std::string weight_ibn = is_conv ? "weight" : "b";
+    const OpNode* data_fake_quant = FindFakeQuantNode(op_graph, conf.input(data_ibn, 0));
+    const OpNode* weight_fake_quant = FindFakeQuantNode(op_graph, conf.input(weight_ibn, 0));
+    const user_op::UserOpConfWrapper data_fake_quant_conf(data_fake_quant->op().op_conf());
+    const user_op::UserOpConfWrapper weight_fake_quant_conf(weight_fake_quant->op().op_conf());
+    user_op::UserOpConfWrapperBuilder builder(conf.op_name());
+    builder.Op(is_conv ? "quantized_conv2d" : "quantized_matmul")
+        .Input(data_ibn, data_fake_quant_conf.input("in", 0))
+        .Input(weight_ibn, weight_fake_quant_conf.input("in", 0))
+        .Input("in_scale", data_fake_quant_conf.input("scale", 0))
+        .Input("in_zero_point", data_fake_quant_conf.input("zero_point", 0))
+        .Input("weight_scale", weight_fake_quant_conf.input("scale", 0))
+        .Input("weight_zero_point", weight_fake_quant_conf.input("zero_point", 0))
+        .Output("out")
+        .Attr<int32_t>("quantization_bit", 8)
+        .Attr<std::string>("quantization_scheme",
+                           data_fake_quant_conf.attr<std::string>("quantization_scheme"))
+        .ScopeSymbolId(node->op().op_conf().scope_symbol_id());
+    if (is_conv) {
+      if (conf.has_input("bias", 0)) {
+        // The bias is kept in float and added to the dequantized result.
+        const OpNode* bias_fake_quant = FindFakeQuantNode(op_graph, conf.input("bias", 0));
+        if (bias_fake_quant != nullptr) {
+          builder.Input("bias",
+                        user_op::UserOpConfWrapper(bias_fake_quant->op().op_conf()).input("in", 0));
+          fake_quant_nodes.insert(bias_fake_quant);
+        } else {
+          builder.Input("bias", conf.input("bias", 0));
+        }
+      }
+      builder.Attr<int32_t>("filters", conf.attr<int32_t>("filters"))
+          .Attr<std::vector<int32_t>>("padding_before",
+                                      conf.attr<std::vector<int32_t>>("padding_before"))
+          .Attr<std::string>("data_format", conf.attr<std::string>("data_format"))
+          .Attr<std::vector<int32_t>>("kernel_size", conf.attr<std::vector<int32_t>>("kernel_size"))
+          .Attr<std::vector<int32_t>>("strides", conf.attr<std::vector<int32_t>>("strides"))
+          .Attr<std::vector<int32_t>>("dilation_rate",
+                                      conf.attr<std::vector<int32_t>>("dilation_rate"));
+    } else {
+      builder.Attr<bool>("transpose_a", conf.attr<bool>("transpose_a"))
+          .Attr<bool>("transpose_b", conf.attr<bool>("transpose_b"))
+          .Attr<double>("alpha", conf.attr<double>("alpha"));
+    }
+    // Same op name and output, so the consumers are left untouched.
+    OperatorConf quantized_op_conf = builder.Build().op_conf();
+    *quantized_op_conf.mutable_ctrl_in_op_name() = node->op().op_conf().ctrl_in_op_name();
+    quantized_op_confs.push_back(quantized_op_conf);
+    converted_nodes.insert(node);
+    fake_quant_nodes.insert(data_fake_quant);
+    fake_quant_nodes.insert(weight_fake_quant);
+    LOG(INFO) << "QuantizedInferenceConversion: " << conf.op_name() << " " << conf.op_type_name()
+              << " -> " << quantized_op_conf.user_conf().op_type_name();
+  });
+  job_builder->MutOpsOnlyOnce(quantized_op_confs);
+  std::vector<std::string> deleted_op_names;
+  for (const OpNode* fake_quant_node : fake_quant_nodes) {
+    bool consumed_by_others = false;
+    for (const OpEdge* out_edge : fake_quant_node->out_edges()) {
+      if (converted_nodes.find(out_edge->dst_node()) == converted_nodes.end()) {
+        consumed_by_others = true;
+      }
+    }
+    if (!consumed_by_others) { deleted_op_names.push_back(fake_quant_node->op().op_name()); }
+  }
+  job_builder->DelOps(deleted_op_names);
+  return Maybe<void>::Ok();
+}
+
+REGISTER_JOB_PASS("QuantizedInferenceConversionPass", QuantizedInferenceConversionPass);
+
+}  // namespace oneflow
@@ -29,8 +29,25 @@ void ForeignInputKernel::ForwardDataContent(
                                    ->TryReceive(&foreign_job_instance);
   CHECK_NE(buffer_status, kBufferStatusEmpty);
   if (buffer_status == kBufferStatusSuccess) {
-    OfBlob ofblob(ctx.device_ctx, BnInOp2Blob("out"));
-    foreign_job_instance->PushBlob(reinterpret_cast<uint64_t>(&ofblob));
+    auto* status = static_cast<ForeignInputStatus*>(ctx.other);
+    CHECK_NOTNULL(status);
+    Blob* out_blob = BnInOp2Blob("out");
+    // The consumers of the previous instance have returned the regst, which restored its blob.
+    CHECK(status->blob2regst_dptr.find(out_blob) == status->blob2regst_dptr.end());
+    OfBlob ofblob(ctx.device_ctx, out_blob);
+    uint64_t borrowed_dptr = 0;
+    if (ofblob.is_host_mem()) {
+      borrowed_dptr = foreign_job_instance->BorrowInputBuffer(reinterpret_cast<uint64_t>(&ofblob));
+    }
+    if (borrowed_dptr != 0) {
+      // The consumers of this instance read the blob before the job instance finishes, and the
+      // actor restores the blob as soon as they return the regst.
+      CHECK_EQ(borrowed_dptr % kForeignHostBufferAlignSize, 0);
+      status->blob2regst_dptr.emplace(out_blob, out_blob->ForceMutDptr<char>());
+      out_blob->reset_dptr(reinterpret_cast<char*>(borrowed_dptr));
+    } else {
+      foreign_job_instance->PushBlob(reinterpret_cast<uint64_t>(&ofblob));
+    }
   }
 }
 
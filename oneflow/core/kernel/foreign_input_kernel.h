@@ -20,6 +20,12 @@ limitations under the License.
 
 namespace oneflow {
 
+struct ForeignInputStatus final {
+  // Body pointers of the regst blobs which alias a buffer borrowed from a foreign job instance.
+  // ForeignInputCompActor restores them once the consumers have returned the regst.
+  HashMap<Blob*, char*> blob2regst_dptr;
+};
+
 class ForeignInputKernel final : public KernelIf<DeviceType::kCPU> {
  public:
   OF_DISALLOW_COPY_AND_MOVE(ForeignInputKernel);
@@ -30,6 +30,23 @@ void ForeignOutputKernel::ForwardDataContent(
   CHECK_NE(buffer_status, kBufferStatusEmpty);
   if (buffer_status == kBufferStatusSuccess) {
     OfBlob ofblob(ctx.device_ctx, BnInOp2Blob("in"));
+    if (ofblob.is_host_mem()) {
+      // The actor does not wait for the view to be released, it keeps the "in" regst from its
+      // producer until then.
+      auto* status = static_cast<ForeignOutputStatus*>(ctx.other);
+      CHECK_NOTNULL(status);
+      auto released = std::make_shared<std::atomic<bool>>(false);
+      const std::function<void()> ReturnInRegst = status->return_in_regst;
+      const auto Release = [ReturnInRegst, released]() {
+        CHECK(!released->exchange(true)) << "output blob view released twice";
+        ReturnInRegst();
+      };
+      if (foreign_job_instance->LendOutputBlob(reinterpret_cast<uint64_t>(&ofblob), Release)) {
+        status->is_in_blob_lent = true;
+        return;
+      }
+      CHECK(!released->load()) << "output blob view released but not lent";
+    }
     foreign_job_instance->PullBlob(reinterpret_cast<uint64_t>(&ofblob));
   }
 }
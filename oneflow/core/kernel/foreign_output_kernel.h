@@ -20,6 +20,15 @@ limitations under the License.
 
 namespace oneflow {
 
+struct ForeignOutputStatus final {
+  // Returns the "in" regst of the current act to its producer, from any thread. It is set by
+  // ForeignOutputCompActor before each act.
+  std::function<void()> return_in_regst;
+  // Set by the kernel when the "in" blob is lent to the foreign job instance, the actor then leaves
+  // the return of the regst to the Release of the view.
+  bool is_in_blob_lent;
+};
+
 class ForeignOutputKernel final : public KernelIf<DeviceType::kCPU> {
  public:
   OF_DISALLOW_COPY_AND_MOVE(ForeignOutputKernel);
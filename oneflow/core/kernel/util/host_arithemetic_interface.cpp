@@ -198,6 +198,7 @@ MUL_BY_SCALAR(double);
 MUL_BY_SCALAR(int8_t);
 MUL_BY_SCALAR(int32_t);
 MUL_BY_SCALAR(int64_t);
+MUL_BY_SCALAR(bfloat16);
 
 #undef MUL_BY_SCALAR
 
@@ -17,6 +17,7 @@ limitations under the License.
 #define ONEFLOW_CORE_KERNEL_UTIL_CPU_ARITHEMETIC_INTERFACE_H_
 
 #include "oneflow/core/kernel/util/arithemetic_interface.h"
+#include "oneflow/core/common/bfloat16.h"
 #include "oneflow/core/common/shape_view.h"
 #include "oneflow/core/common/protobuf.h"
 
@@ -71,6 +72,8 @@ struct ArithemeticIf<DeviceType::kCPU> {
                           int32_t* z);
   static void MulByScalar(DeviceCtx* ctx, const int64_t n, const int64_t* x, const int64_t y,
                           int64_t* z);
+  static void MulByScalar(DeviceCtx* ctx, const int64_t n, const bfloat16* x, const bfloat16 y,
+                          bfloat16* z);
 
   static void AddByScalar(DeviceCtx* ctx, const int64_t n, const float* x, const float y, float* z);
   static void AddByScalar(DeviceCtx* ctx, const int64_t n, const double* x, const double y,
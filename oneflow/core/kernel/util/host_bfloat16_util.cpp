@@ -0,0 +1,200 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/util/host_bfloat16_util.h"
+
+#include <algorithm>
+
+#include "oneflow/core/kernel/util/host_isa_util.h"
+
+namespace oneflow {
+
+namespace host_bfloat16 {
+
+namespace {
+
+using host_isa::Isa;
+using host_isa::kDotNumCols;
+
+float Epilogue(float dot, float alpha, float beta, const bfloat16* c) {
+  return beta == 0 ? alpha * dot : alpha * dot + beta * static_cast<float>(*c);
+}
+
+void DotScalar(int64_t k, float alpha, const bfloat16* a, const bfloat16* b, int64_t ldb,
+               int64_t num_cols, float beta, bfloat16* c) {
+  for (int64_t j = 0; j < num_cols; ++j) {
+    const bfloat16* b_j = b + j * ldb;
+    float sum = 0;
+    for (int64_t p = 0; p < k; ++p) {
+      sum += static_cast<float>(a[p]) * static_cast<float>(b_j[p]);
+    }
+    c[j] = Epilogue(sum, alpha, beta, c + j);
+  }
+}
+
+#ifdef OF_HOST_ISA_WITH_AVX2
+
+__attribute__((target("avx2"))) __m256 LoadAsFloat(const bfloat16* p) {
+  const __m256i x = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+  return _mm256_castsi256_ps(_mm256_slli_epi32(x, 16));
+}
+
+__attribute__((target("avx2"))) float HorizontalSum(__m256 v) {
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+  return _mm_cvtss_f32(sum);
+}
+
+__attribute__((target("avx2,fma"))) void DotAvx2(int64_t k, float alpha, const bfloat16* a,
+                                                 const bfloat16* b, int64_t ldb, int64_t num_cols,
+                                                 float beta, bfloat16* c) {
+  if (num_cols != kDotNumCols) { return DotScalar(k, alpha, a, b, ldb, num_cols, beta, c); }
+  __m256 acc[kDotNumCols];
+  for (int64_t j = 0; j < kDotNumCols; ++j) { acc[j] = _mm256_setzero_ps(); }
+  int64_t p = 0;
+  for (; p + 8 <= k; p += 8) {
+    const __m256 a8 = LoadAsFloat(a + p);
+    for (int64_t j = 0; j < kDotNumCols; ++j) {
+      acc[j] = _mm256_fmadd_ps(a8, LoadAsFloat(b + j * ldb + p), acc[j]);
+    }
+  }
+  for (int64_t j = 0; j < kDotNumCols; ++j) {
+    float sum = HorizontalSum(acc[j]);
+    const bfloat16* b_j = b + j * ldb;
+    for (int64_t q = p; q < k; ++q) {
+      sum += static_cast<float>(a[q]) * static_cast<float>(b_j[q]);
+    }
+    c[j] = Epilogue(sum, alpha, beta, c + j);
+  }
+}
+
+// Rounds to nearest even the same way as bfloat16::Float2Bits, NaNs included.
+__attribute__((target("avx2"))) void FloatToBFloat16Avx2(const float* in, int64_t n,
+                                                         bfloat16* out) {
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i bias = _mm256_set1_epi32(0x7fff);
+  const __m256i abs_mask = _mm256_set1_epi32(0x7fffffff);
+  const __m256i inf = _mm256_set1_epi32(0x7f800000);
+  const __m256i quiet = _mm256_set1_epi32(0x00400000);
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i bits = _mm256_castps_si256(_mm256_loadu_ps(in + i));
+    const __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), one);
+    const __m256i rounded = _mm256_add_epi32(bits, _mm256_add_epi32(bias, lsb));
+    const __m256i is_nan = _mm256_cmpgt_epi32(_mm256_and_si256(bits, abs_mask), inf);
+    const __m256i x = _mm256_srli_epi32(
+        _mm256_blendv_epi8(rounded, _mm256_or_si256(bits, quiet), is_nan), 16);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_packus_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1)));
+  }
+  for (; i < n; ++i) { out[i] = in[i]; }
+}
+
+__attribute__((target("avx2"))) void BFloat16ToFloatAvx2(const bfloat16* in, int64_t n,
+                                                         float* out) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) { _mm256_storeu_ps(out + i, LoadAsFloat(in + i)); }
+  for (; i < n; ++i) { out[i] = in[i]; }
+}
+
+#endif  // OF_HOST_ISA_WITH_AVX2
+
+#ifdef OF_HOST_ISA_WITH_AVX512_BF16
+
+// dpbf16 multiplies the pairs of bfloat16 and accumulates them in float, 32 products at a time.
+__attribute__((target("avx512f,avx512bw,avx512bf16"))) void DotAvx512Bf16(
+    int64_t k, float alpha, const bfloat16* a, const bfloat16* b, int64_t ldb, int64_t num_cols,
+    float beta, bfloat16* c) {
+  if (num_cols != kDotNumCols) { return DotScalar(k, alpha, a, b, ldb, num_cols, beta, c); }
+  __m512 acc[kDotNumCols];
+  for (int64_t j = 0; j < kDotNumCols; ++j) { acc[j] = _mm512_setzero_ps(); }
+  int64_t p = 0;
+  for (; p + 32 <= k; p += 32) {
+    const __m512bh a32 = (__m512bh)_mm512_loadu_si512(a + p);
+    for (int64_t j = 0; j < kDotNumCols; ++j) {
+      acc[j] = _mm512_dpbf16_ps(acc[j], a32, (__m512bh)_mm512_loadu_si512(b + j * ldb + p));
+    }
+  }
+  if (p < k) {
+    const __mmask32 mask = (~0U) >> (32 - (k - p));
+    const __m512bh a32 = (__m512bh)_mm512_maskz_loadu_epi16(mask, a + p);
+    for (int64_t j = 0; j < kDotNumCols; ++j) {
+      acc[j] = _mm512_dpbf16_ps(acc[j], a32,
+                                (__m512bh)_mm512_maskz_loadu_epi16(mask, b + j * ldb + p));
+    }
+  }
+  for (int64_t j = 0; j < kDotNumCols; ++j) {
+    float lanes[16];
+    _mm512_storeu_ps(lanes, acc[j]);
+    float sum = 0;
+    for (int32_t lane = 0; lane < 16; ++lane) { sum += lanes[lane]; }
+    c[j] = Epilogue(sum, alpha, beta, c + j);
+  }
+}
+
+#endif  // OF_HOST_ISA_WITH_AVX512_BF16
+
+using DotFn = void (*)(int64_t, float, const bfloat16*, const bfloat16*, int64_t, int64_t, float,
+                       bfloat16*);
+
+std::pair<Isa, DotFn> GetDot() {
+  static const std::pair<Isa, DotFn> dot = host_isa::Dispatch<DotFn>({
+#ifdef OF_HOST_ISA_WITH_AVX512_BF16
+      {Isa::kAvx512Bf16, &DotAvx512Bf16},
+#endif
+#ifdef OF_HOST_ISA_WITH_AVX2
+      {Isa::kAvx2, &DotAvx2},
+#endif
+      {Isa::kScalar, &DotScalar},
+  });
+  return dot;
+}
+
+Isa GetIsa() { return GetDot().first; }
+
+}  // namespace
+
+void FloatToBFloat16(const float* in, int64_t n, bfloat16* out) {
+#ifdef OF_HOST_ISA_WITH_AVX2
+  if (GetIsa() != Isa::kScalar) { return FloatToBFloat16Avx2(in, n, out); }
+#endif
+  for (int64_t i = 0; i < n; ++i) { out[i] = in[i]; }
+}
+
+void BFloat16ToFloat(const bfloat16* in, int64_t n, float* out) {
+#ifdef OF_HOST_ISA_WITH_AVX2
+  if (GetIsa() != Isa::kScalar) { return BFloat16ToFloatAvx2(in, n, out); }
+#endif
+  for (int64_t i = 0; i < n; ++i) { out[i] = in[i]; }
+}
+
+bool HasNativeDot() { return GetIsa() == Isa::kAvx512Bf16; }
+
+void Gemm(int64_t row_begin, int64_t row_end, int64_t n, int64_t k, float alpha,
+          const bfloat16* a, const bfloat16* b, float beta, bfloat16* c) {
+  const DotFn Dot = GetDot().second;
+  for (int64_t i = row_begin; i < row_end; ++i) {
+    for (int64_t j = 0; j < n; j += kDotNumCols) {
+      Dot(k, alpha, a + i * k, b + j * k, k, std::min(kDotNumCols, n - j), beta, c + i * n + j);
+    }
+  }
+}
+
+const char* IsaName() { return host_isa::IsaName(GetIsa()); }
+
+}  // namespace host_bfloat16
+
+}  // namespace oneflow
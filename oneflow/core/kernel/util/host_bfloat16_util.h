@@ -0,0 +1,44 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_UTIL_HOST_BFLOAT16_UTIL_H_
+#define ONEFLOW_CORE_KERNEL_UTIL_HOST_BFLOAT16_UTIL_H_
+
+#include "oneflow/core/common/bfloat16.h"
+
+namespace oneflow {
+
+namespace host_bfloat16 {
+
+void FloatToBFloat16(const float* in, int64_t n, bfloat16* out);
+void BFloat16ToFloat(const bfloat16* in, int64_t n, float* out);
+
+// Whether the cpu has the bfloat16 dot products of avx512_bf16, without which Gemm is slower
+// than converting to float for sgemm.
+bool HasNativeDot();
+
+// c[i * n + j] = alpha * sum_p a[i * k + p] * b[j * k + p] + beta * c[i * n + j] for the rows i
+// in [row_begin, row_end), that is a (m, k) matrix times the transpose of a (n, k) matrix. The
+// products are accumulated in float and rounded once, c is not read when beta is 0.
+void Gemm(int64_t row_begin, int64_t row_end, int64_t n, int64_t k, float alpha,
+          const bfloat16* a, const bfloat16* b, float beta, bfloat16* c);
+
+const char* IsaName();
+
+}  // namespace host_bfloat16
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_UTIL_HOST_BFLOAT16_UTIL_H_
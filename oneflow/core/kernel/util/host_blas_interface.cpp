@@ -14,7 +14,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/util/host_blas_interface.h"
+#include "oneflow/core/kernel/util/host_bfloat16_util.h"
 #include "oneflow/core/register/blob.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
@@ -56,6 +58,52 @@ void BatchedGemmImpl(DeviceCtx* ctx, const enum CBLAS_ORDER order,
   }
 }
 
+// Copies the (rows, cols) matrix x transposed into y.
+void Transpose(int64_t rows, int64_t cols, const bfloat16* x, bfloat16* y) {
+  FOR_RANGE(int64_t, i, 0, rows) {
+    FOR_RANGE(int64_t, j, 0, cols) { y[j * rows + i] = x[i * cols + j]; }
+  }
+}
+
+void BFloat16Gemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a, enum CBLAS_TRANSPOSE trans_b,
+                  const int m, const int n, const int k, const double alpha, const bfloat16* a,
+                  const bfloat16* b, const double beta, bfloat16* c) {
+  if (!host_bfloat16::HasNativeDot()) {
+    // Without the bfloat16 dot products sgemm on float copies is the faster way.
+    std::vector<float> a_buf(static_cast<size_t>(m) * k);
+    std::vector<float> b_buf(static_cast<size_t>(k) * n);
+    std::vector<float> c_buf(static_cast<size_t>(m) * n);
+    host_bfloat16::BFloat16ToFloat(a, a_buf.size(), a_buf.data());
+    host_bfloat16::BFloat16ToFloat(b, b_buf.size(), b_buf.data());
+    if (beta != 0) { host_bfloat16::BFloat16ToFloat(c, c_buf.size(), c_buf.data()); }
+    Gemm<float>(ctx, CblasRowMajor, trans_a, trans_b, m, n, k, alpha, a_buf.data(), b_buf.data(),
+                beta, c_buf.data());
+    host_bfloat16::FloatToBFloat16(c_buf.data(), c_buf.size(), c);
+    return;
+  }
+  // The dot products want the rows of a and the columns of b contiguous.
+  std::vector<bfloat16> a_buf;
+  const bfloat16* a_rows = a;
+  if (trans_a == CblasTrans) {
+    a_buf.resize(static_cast<size_t>(m) * k);
+    Transpose(k, m, a, a_buf.data());
+    a_rows = a_buf.data();
+  }
+  std::vector<bfloat16> b_buf;
+  const bfloat16* b_cols = b;
+  if (trans_b == CblasNoTrans) {
+    b_buf.resize(static_cast<size_t>(k) * n);
+    Transpose(k, n, b, b_buf.data());
+    b_cols = b_buf.data();
+  }
+  const int64_t block_rows = 16;
+  MultiThreadLoop(RoundUp(m, block_rows) / block_rows, [&](size_t block) {
+    const int64_t row_begin = block * block_rows;
+    host_bfloat16::Gemm(row_begin, std::min<int64_t>(row_begin + block_rows, m), n, k, alpha,
+                        a_rows, b_cols, beta, c);
+  });
+}
+
 }  // namespace
 
 void BlasIf<DeviceType::kCPU>::OFGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
@@ -72,6 +120,13 @@ void BlasIf<DeviceType::kCPU>::OFGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans
   Gemm<double>(ctx, CblasRowMajor, trans_a, trans_b, m, n, k, alpha, a, b, beta, c);
 }
 
+void BlasIf<DeviceType::kCPU>::OFGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
+                                      enum CBLAS_TRANSPOSE trans_b, const int m, const int n,
+                                      const int k, const double alpha, const bfloat16* a,
+                                      const bfloat16* b, const double beta, bfloat16* c) {
+  BFloat16Gemm(ctx, trans_a, trans_b, m, n, k, alpha, a, b, beta, c);
+}
+
 void BlasIf<DeviceType::kCPU>::OFBatchedGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
                                              enum CBLAS_TRANSPOSE trans_b, const int batch_size,
                                              const int m, const int n, const int k,
@@ -90,6 +145,15 @@ void BlasIf<DeviceType::kCPU>::OFBatchedGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOS
                           beta, c);
 }
 
+void BlasIf<DeviceType::kCPU>::OFBatchedGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
+                                             enum CBLAS_TRANSPOSE trans_b, const int batch_size,
+                                             const int m, const int n, const int k,
+                                             const double alpha, const bfloat16* a,
+                                             const bfloat16* b, const double beta, bfloat16* c) {
+  BatchedGemmImpl<bfloat16>(ctx, CblasRowMajor, trans_a, trans_b, batch_size, m, n, k, alpha, a,
+                            b, beta, c);
+}
+
 void BlasIf<DeviceType::kCPU>::Axpy(DeviceCtx* ctx, const int n, const float alpha, const float* x,
                                     const int incx, float* y, const int incy) {
   AxpyImpl<float>(ctx, n, alpha, x, incx, y, incy);
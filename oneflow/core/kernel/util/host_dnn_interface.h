@@ -17,6 +17,7 @@ limitations under the License.
 #define ONEFLOW_CORE_KERNEL_UTIL_HOST_DNN_INTERFACE_H_
 
 #include "oneflow/core/kernel/util/dnn_interface.h"
+#include "oneflow/core/common/bfloat16.h"
 
 namespace oneflow {
 
@@ -24,10 +25,13 @@ template<>
 struct DnnIf<DeviceType::kCPU> {
   static void Relu(DeviceCtx* ctx, const int64_t n, const float* x, float* y);
   static void Relu(DeviceCtx* ctx, const int64_t n, const double* x, double* y);
+  static void Relu(DeviceCtx* ctx, const int64_t n, const bfloat16* x, bfloat16* y);
   static void ReluBackward(DeviceCtx* ctx, const int64_t n, const float* x, const float* y,
                            const float* dy, float* dx);
   static void ReluBackward(DeviceCtx* ctx, const int64_t n, const double* x, const double* y,
                            const double* dy, double* dx);
+  static void ReluBackward(DeviceCtx* ctx, const int64_t n, const bfloat16* x, const bfloat16* y,
+                           const bfloat16* dy, bfloat16* dx);
   static void Sigmoid(DeviceCtx* ctx, int64_t n, const float* x, float* y);
   static void Sigmoid(DeviceCtx* ctx, int64_t n, const double* x, double* y);
   static void SigmoidBackward(DeviceCtx* ctx, const int64_t n, const float* x, const float* y,
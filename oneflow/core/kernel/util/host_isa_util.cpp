@@ -0,0 +1,69 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/util/host_isa_util.h"
+
+namespace oneflow {
+
+namespace host_isa {
+
+namespace {
+
+struct CpuFeatures {
+  bool avx2 = false;
+  bool avx512_vnni = false;
+  bool avx512_bf16 = false;
+};
+
+CpuFeatures DetectCpuFeatures() {
+  CpuFeatures features;
+#ifdef OF_HOST_ISA_WITH_AVX2
+  features.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+#ifdef OF_HOST_ISA_WITH_AVX512_VNNI
+  features.avx512_vnni =
+      __builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512bw");
+#endif
+#ifdef OF_HOST_ISA_WITH_AVX512_BF16
+  features.avx512_bf16 =
+      __builtin_cpu_supports("avx512bf16") && __builtin_cpu_supports("avx512bw");
+#endif
+  return features;
+}
+
+}  // namespace
+
+bool CpuSupports(Isa isa) {
+  static const CpuFeatures features = DetectCpuFeatures();
+  switch (isa) {
+    case Isa::kAvx2: return features.avx2;
+    case Isa::kAvx512Vnni: return features.avx512_vnni;
+    case Isa::kAvx512Bf16: return features.avx512_bf16;
+    default: return true;
+  }
+}
+
+const char* IsaName(Isa isa) {
+  switch (isa) {
+    case Isa::kAvx2: return "avx2";
+    case Isa::kAvx512Vnni: return "avx512_vnni";
+    case Isa::kAvx512Bf16: return "avx512_bf16";
+    default: return "scalar";
+  }
+}
+
+}  // namespace host_isa
+
+}  // namespace oneflow
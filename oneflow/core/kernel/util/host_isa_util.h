@@ -0,0 +1,70 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_UTIL_HOST_ISA_UTIL_H_
+#define ONEFLOW_CORE_KERNEL_UTIL_HOST_ISA_UTIL_H_
+
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+
+// The x86 kernels are compiled with the target attribute instead of -m flags, so that the binary
+// still runs on the cpus without them and the one to use is picked at runtime.
+#if defined(__x86_64__) && defined(__GNUC__)
+#define OF_HOST_ISA_WITH_AVX2
+#if defined(__clang__) || __GNUC__ >= 8
+#define OF_HOST_ISA_WITH_AVX512_VNNI
+#endif
+#if defined(__clang__) || __GNUC__ >= 10
+#define OF_HOST_ISA_WITH_AVX512_BF16
+#endif
+#include <immintrin.h>
+#endif
+
+namespace oneflow {
+
+namespace host_isa {
+
+// Number of the columns of c computed together by the dot products of the cpu gemms, so that a
+// row of a is loaded once for them.
+constexpr int64_t kDotNumCols = 4;
+
+enum class Isa {
+  kScalar,
+  kAvx2,        // avx2 and fma
+  kAvx512Vnni,  // avx512_vnni and avx512bw
+  kAvx512Bf16,  // avx512_bf16 and avx512bw
+};
+
+// Whether the cpu supports isa, which is only detected once. kScalar is always supported.
+bool CpuSupports(Isa isa);
+
+const char* IsaName(Isa isa);
+
+// Returns the first of the (isa, kernel) candidates the cpu supports, the candidates are in order
+// of preference and end with a kScalar kernel.
+template<typename T>
+std::pair<Isa, T> Dispatch(std::initializer_list<std::pair<Isa, T>> candidates) {
+  for (const auto& candidate : candidates) {
+    if (CpuSupports(candidate.first)) { return candidate; }
+  }
+  return *(candidates.end() - 1);
+}
+
+}  // namespace host_isa
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_UTIL_HOST_ISA_UTIL_H_
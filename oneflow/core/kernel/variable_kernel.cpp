@@ -13,10 +13,25 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#include <sys/mman.h>
 #include "oneflow/core/kernel/variable_kernel.h"
 
 namespace oneflow {
 
+template<DeviceType device_type, typename T>
+void VariableKernel<device_type, T>::ForwardDataContent(
+    const KernelCtx&, std::function<Blob*(const std::string&)> BnInOp2Blob) const {
+  if (device_type != DeviceType::kCPU || !this->op_conf().variable_conf().offload()) { return; }
+  // the variable acts before its consumers in each iteration, so the pages of its file are read
+  // ahead asynchronously while the ops before the consumers run
+  const Blob* out = BnInOp2Blob("out");
+  const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(out->dptr()) / page_size * page_size;
+  const uintptr_t end = reinterpret_cast<uintptr_t>(out->dptr()) + out->ByteSizeOfBlobBody();
+  if (end == begin) { return; }
+  PCHECK(madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED) == 0);
+}
+
 ADD_DEFAULT_KERNEL_CREATOR(OperatorConf::kVariableConf, VariableKernel, ARITHMETIC_DATA_TYPE_SEQ);
 
 }  // namespace oneflow
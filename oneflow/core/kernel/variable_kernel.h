@@ -29,7 +29,7 @@ class VariableKernel final : public KernelIf<device_type> {
 
  private:
   void ForwardDataContent(const KernelCtx&,
-                          std::function<Blob*(const std::string&)>) const override {}
+                          std::function<Blob*(const std::string&)>) const override;
 };
 
 }  // namespace oneflow
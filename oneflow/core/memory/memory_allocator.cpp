@@ -13,6 +13,8 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#include <sys/mman.h>
+#include <unistd.h>
 #include "oneflow/core/memory/memory_allocator.h"
 #include "oneflow/core/comm_network/comm_network.h"
 #include "oneflow/core/device/cuda_util.h"
@@ -24,6 +26,41 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+std::mutex file_backed_mem_mutex;
+HashMap<void*, size_t> file_backed_mem_ptr2size;
+
+void* AllocateFileBackedHostMem(size_t size) {
+  std::string path =
+      Global<ResourceDesc, ForSession>::Get()->offload_file_dir() + "/oneflow-offload-XXXXXX";
+  const int fd = mkstemp(&path[0]);
+  PCHECK(fd != -1) << path;
+  // the mapping keeps the file until it is unmapped
+  PCHECK(unlink(path.c_str()) == 0) << path;
+  PCHECK(ftruncate(fd, size) == 0) << path;
+  void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  PCHECK(ptr != MAP_FAILED) << path;
+  PCHECK(close(fd) == 0);
+  std::lock_guard<std::mutex> lock(file_backed_mem_mutex);
+  CHECK(file_backed_mem_ptr2size.emplace(ptr, size).second);
+  return ptr;
+}
+
+void DeallocateFileBackedHostMem(void* ptr) {
+  size_t size = 0;
+  {
+    std::lock_guard<std::mutex> lock(file_backed_mem_mutex);
+    auto it = file_backed_mem_ptr2size.find(ptr);
+    CHECK(it != file_backed_mem_ptr2size.end());
+    size = it->second;
+    file_backed_mem_ptr2size.erase(it);
+  }
+  PCHECK(munmap(ptr, size) == 0);
+}
+
+}  // namespace
+
 void* MemoryAllocatorImpl::Allocate(MemoryCase mem_case, size_t size) {
   void* ptr = nullptr;
   if (mem_case.has_host_mem()) {
@@ -37,6 +74,8 @@ void* MemoryAllocatorImpl::Allocate(MemoryCase mem_case, size_t size) {
 #else
       UNIMPLEMENTED();
 #endif
+    } else if (mem_case.host_mem().file_backed()) {
+      ptr = AllocateFileBackedHostMem(size);
     } else {
       ptr = malloc(size);
       CHECK_NOTNULL(ptr);
@@ -62,6 +101,8 @@ void MemoryAllocatorImpl::Deallocate(void* ptr, MemoryCase mem_case) {
 #else
       UNIMPLEMENTED();
 #endif
+    } else if (mem_case.host_mem().file_backed()) {
+      DeallocateFileBackedHostMem(ptr);
     } else {
       free(ptr);
     }
@@ -93,7 +134,8 @@ char* MemoryAllocator::Allocate(MemoryCase mem_case, std::size_t size) {
   const int memset_val = 0;
   char* dptr = static_cast<char*>(MemoryAllocatorImpl::Allocate(mem_case, size));
   if (mem_case.has_host_mem()) {
-    memset(dptr, memset_val, size);
+    // a new file reads as zeros, which are not written until the pages are touched
+    if (!mem_case.host_mem().file_backed()) { memset(dptr, memset_val, size); }
   } else if (mem_case.has_device_cuda_mem()) {
 #ifdef WITH_CUDA
     CudaCurrentDeviceGuard guard(mem_case.device_cuda_mem().device_id());
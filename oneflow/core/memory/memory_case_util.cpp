@@ -34,6 +34,7 @@ bool MemoryCaseUtil::GetCommonMemoryCase(const MemoryCase& a, const MemoryCase&
     if (b.host_mem().has_used_by_network()) {
       common->mutable_host_mem()->set_used_by_network(true);
     }
+    if (!b.host_mem().file_backed()) { common->mutable_host_mem()->clear_file_backed(); }
     return true;
   } else {
     return false;
@@ -53,7 +54,8 @@ int64_t MemoryCaseUtil::GenMemZoneId(const MemoryCase& mem_case) {
   // [0, 127] = GPU device mem
   // [128] = CPU host mem
   // [129, 256] = CPU host mem used by CUDA with device id
-  // [257, ...] Other Device
+  // [257] = CPU host mem backed by a file
+  // [258, ...] Other Device
   if (mem_case.has_device_cuda_mem()) {
     return mem_case.device_cuda_mem().device_id();  // GPU device mem
   }
@@ -61,6 +63,7 @@ int64_t MemoryCaseUtil::GenMemZoneId(const MemoryCase& mem_case) {
     if (mem_case.host_mem().has_cuda_pinned_mem()) {
       return 129 + mem_case.host_mem().cuda_pinned_mem().device_id();  // Host mem used by GPU
     }
+    if (mem_case.host_mem().file_backed()) { return 257; }  // Host mem backed by a file
     return 128;  // CPU host mem
   }
   UNIMPLEMENTED();
@@ -30,7 +30,8 @@ inline bool operator==(const MemoryCase& lhs, const MemoryCase& rhs) {
       return lhs_host_mem.cuda_pinned_mem().device_id()
              == rhs_host_mem.cuda_pinned_mem().device_id();
     } else {
-      return (!lhs_host_mem.has_cuda_pinned_mem()) && (!rhs_host_mem.has_cuda_pinned_mem());
+      return (!lhs_host_mem.has_cuda_pinned_mem()) && (!rhs_host_mem.has_cuda_pinned_mem())
+             && lhs_host_mem.file_backed() == rhs_host_mem.file_backed();
     }
   }
   if (lhs.has_device_cuda_mem() && rhs.has_device_cuda_mem()) {
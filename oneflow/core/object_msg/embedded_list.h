@@ -21,6 +21,9 @@ limitations under the License.
 
 namespace oneflow {
 
+template<typename LinkField>
+class TrivialObjectMsgLockFreeList;
+
 struct EmbeddedListLink {
  public:
   EmbeddedListLink* prev() const { return prev_; }
@@ -55,6 +58,10 @@ struct EmbeddedListLink {
   }
 
  private:
+  // chains the pending elements through next_ only
+  template<typename LinkField>
+  friend class TrivialObjectMsgLockFreeList;
+
   void set_prev(EmbeddedListLink* prev) { prev_ = prev; }
   void set_next(EmbeddedListLink* next) { next_ = next; }
 
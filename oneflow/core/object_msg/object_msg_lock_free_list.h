@@ -0,0 +1,259 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_OBJECT_MSG_LOCK_FREE_LIST_H_
+#define ONEFLOW_CORE_OBJECT_MSG_LOCK_FREE_LIST_H_
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "oneflow/core/object_msg/object_msg_list.h"
+#include "oneflow/core/object_msg/object_msg_condition_list.h"
+
+namespace oneflow {
+
+#define OBJECT_MSG_DEFINE_LOCK_FREE_LIST_HEAD(elem_type, elem_field_name, field_name)           \
+  static_assert(__is_object_message_type__, "this struct is not a object message");             \
+  static_assert(!std::is_same<self_type, elem_type>::value, "self loop link is not supported"); \
+  OF_PRIVATE INCREASE_STATIC_COUNTER(field_counter);                                            \
+  _OBJECT_MSG_DEFINE_LOCK_FREE_LIST_HEAD(STATIC_COUNTER(field_counter), elem_type,              \
+                                         elem_field_name, field_name);
+
+#define OBJECT_MSG_LOCK_FREE_LIST(obj_msg_type, obj_msg_field)                              \
+  ObjectMsgLockFreeList<StructField<OBJECT_MSG_TYPE_CHECK(obj_msg_type), EmbeddedListLink, \
+                                    OBJECT_MSG_TYPE_CHECK(obj_msg_type)::OF_PP_CAT(        \
+                                        obj_msg_field, _kDssFieldOffset)>>
+
+// details
+
+#define _OBJECT_MSG_DEFINE_LOCK_FREE_LIST_HEAD(field_counter, elem_type, elem_field_name,      \
+                                               field_name)                                     \
+  _OBJECT_MSG_DEFINE_LOCK_FREE_LIST_HEAD_FIELD(elem_type, elem_field_name, field_name)         \
+  OBJECT_MSG_DEFINE_LOCK_FREE_LIST_ELEM_STRUCT(field_counter, elem_type, elem_field_name,      \
+                                               field_name);                                    \
+  OBJECT_MSG_DEFINE_LOCK_FREE_LIST_LINK_EDGES(field_counter, elem_type, elem_field_name,       \
+                                              field_name);                                     \
+  OBJECT_MSG_OVERLOAD_INIT(field_counter, ObjectMsgEmbeddedLockFreeListHeadInit);              \
+  OBJECT_MSG_OVERLOAD_DELETE(field_counter, ObjectMsgEmbeddedLockFreeListHeadDelete);          \
+  DSS_DEFINE_FIELD(field_counter, "object message", OF_PP_CAT(field_name, _ObjectMsgListType), \
+                   OF_PP_CAT(field_name, _));
+
+#define _OBJECT_MSG_DEFINE_LOCK_FREE_LIST_HEAD_FIELD(elem_type, elem_field_name, field_name)   \
+ public:                                                                                       \
+  using OF_PP_CAT(field_name, _ObjectMsgListType) = TrivialObjectMsgLockFreeList<StructField<  \
+      OBJECT_MSG_TYPE_CHECK(elem_type), EmbeddedListLink,                                      \
+      OBJECT_MSG_TYPE_CHECK(elem_type)::OF_PP_CAT(elem_field_name, _kDssFieldOffset)>>;        \
+  const OF_PP_CAT(field_name, _ObjectMsgListType) & field_name() const {                       \
+    return OF_PP_CAT(field_name, _);                                                           \
+  }                                                                                            \
+  OF_PP_CAT(field_name, _ObjectMsgListType) * OF_PP_CAT(mut_, field_name)() {                  \
+    return &OF_PP_CAT(field_name, _);                                                          \
+  }                                                                                            \
+  OF_PP_CAT(field_name, _ObjectMsgListType) * OF_PP_CAT(mutable_, field_name)() {              \
+    return &OF_PP_CAT(field_name, _);                                                          \
+  }                                                                                            \
+                                                                                               \
+ private:                                                                                      \
+  OF_PP_CAT(field_name, _ObjectMsgListType) OF_PP_CAT(field_name, _);
+
+#define OBJECT_MSG_DEFINE_LOCK_FREE_LIST_ELEM_STRUCT(field_counter, elem_type, elem_field_name, \
+                                                     field_name)                                \
+ public:                                                                                        \
+  template<typename Enabled>                                                                    \
+  struct ContainerElemStruct<field_counter, Enabled> final {                                    \
+    using type = elem_type;                                                                     \
+  };
+
+#define OBJECT_MSG_DEFINE_LOCK_FREE_LIST_LINK_EDGES(field_counter, elem_type, elem_field_name, \
+                                                    field_name)                                \
+ public:                                                                                       \
+  template<typename Enable>                                                                    \
+  struct LinkEdgesGetter<field_counter, Enable> final {                                        \
+    static void Call(std::set<ObjectMsgContainerLinkEdge>* edges) {                            \
+      ObjectMsgContainerLinkEdge edge;                                                         \
+      edge.container_type_name = typeid(self_type).name();                                     \
+      edge.container_field_name = OF_PP_STRINGIZE(field_name) "_";                             \
+      edge.elem_type_name = typeid(elem_type).name();                                          \
+      edge.elem_link_name = OF_PP_STRINGIZE(elem_field_name) "_";                              \
+      edges->insert(edge);                                                                     \
+    }                                                                                          \
+  };
+
+template<typename WalkCtxType, typename PtrFieldType>
+struct ObjectMsgEmbeddedLockFreeListHeadInit {
+  static void Call(WalkCtxType* ctx, PtrFieldType* field) { field->__Init__(); }
+};
+
+template<typename WalkCtxType, typename PtrFieldType>
+struct ObjectMsgEmbeddedLockFreeListHeadDelete {
+  static void Call(WalkCtxType* ctx, PtrFieldType* field) { field->__Delete__(); }
+};
+
+// A multi-producer single-consumer list with the interface of TrivialObjectMsgConditionList.
+// The producers push onto a stack with a compare-and-swap, chaining the pending elements through
+// the `next_` of their list links, and the consumer takes the whole stack with one exchange. The
+// mutex and the condition variable are only touched when the consumer has to sleep.
+template<typename LinkField>
+class TrivialObjectMsgLockFreeList {
+ public:
+  using value_type = typename LinkField::struct_type;
+  using ListType = TrivialObjectMsgList<kDisableSelfLoopLink, LinkField>;
+
+  void __Init__() {
+    head_.store(nullptr, std::memory_order_relaxed);
+    is_closed_.store(false, std::memory_order_relaxed);
+    is_waiting_.store(false, std::memory_order_relaxed);
+    new (mutex_buff_) std::mutex();
+    new (cond_buff_) std::condition_variable();
+  }
+
+  bool empty() const { return head_.load(std::memory_order_acquire) == nullptr; }
+
+  ObjectMsgConditionListStatus EmplaceBack(ObjectMsgPtr<value_type>&& ptr) {
+    if (is_closed_.load(std::memory_order_acquire)) {
+      return kObjectMsgConditionListStatusErrorClosed;
+    }
+    value_type* raw_ptr = nullptr;
+    ptr.__UnsafeMoveTo__(&raw_ptr);
+    EmbeddedListLink* link = LinkField::FieldPtr4StructPtr(raw_ptr);
+    link->set_prev(nullptr);
+    PushChain(link, link);
+    return kObjectMsgConditionListStatusSuccess;
+  }
+  ObjectMsgConditionListStatus PushBack(value_type* ptr) {
+    return EmplaceBack(ObjectMsgPtr<value_type>(ptr));
+  }
+
+  ObjectMsgConditionListStatus MoveFrom(ListType* src) {
+    if (is_closed_.load(std::memory_order_acquire)) {
+      return kObjectMsgConditionListStatusErrorClosed;
+    }
+    // the stack is newest first, so the back of src becomes the top
+    EmbeddedListLink* top = nullptr;
+    EmbeddedListLink* bottom = nullptr;
+    while (!src->empty()) {
+      value_type* raw_ptr = nullptr;
+      src->PopFront().__UnsafeMoveTo__(&raw_ptr);
+      EmbeddedListLink* link = LinkField::FieldPtr4StructPtr(raw_ptr);
+      link->set_prev(nullptr);
+      link->set_next(top);
+      if (bottom == nullptr) { bottom = link; }
+      top = link;
+    }
+    if (top != nullptr) { PushChain(top, bottom); }
+    return kObjectMsgConditionListStatusSuccess;
+  }
+
+  // Blocks until there are elements or the list is closed. Only one thread could consume.
+  ObjectMsgConditionListStatus MoveTo(ListType* dst) {
+    for (int i = 0; i < kSpinCount; ++i) {
+      if (TryPopAllTo(dst)) { return kObjectMsgConditionListStatusSuccess; }
+    }
+    {
+      std::unique_lock<std::mutex> lock(*mut_mutex());
+      is_waiting_.store(true);
+      mut_cond()->wait(lock, [this]() {
+        return head_.load() != nullptr || is_closed_.load(std::memory_order_acquire);
+      });
+      is_waiting_.store(false, std::memory_order_relaxed);
+    }
+    if (TryPopAllTo(dst)) { return kObjectMsgConditionListStatusSuccess; }
+    return kObjectMsgConditionListStatusErrorClosed;
+  }
+
+  ObjectMsgConditionListStatus TryMoveTo(ListType* dst) {
+    TryPopAllTo(dst);
+    return kObjectMsgConditionListStatusSuccess;
+  }
+
+  void Close() {
+    std::unique_lock<std::mutex> lock(*mut_mutex());
+    is_closed_.store(true, std::memory_order_release);
+    mut_cond()->notify_all();
+  }
+
+  void __Delete__() {
+    ListType list;
+    list.__Init__();
+    TryPopAllTo(&list);
+    list.Clear();
+    using namespace std;
+    mut_mutex()->mutex::~mutex();
+    mut_cond()->condition_variable::~condition_variable();
+  }
+
+ private:
+  static const int kSpinCount = 64;
+
+  void PushChain(EmbeddedListLink* top, EmbeddedListLink* bottom) {
+    EmbeddedListLink* head = head_.load(std::memory_order_relaxed);
+    do { bottom->set_next(head); } while (!head_.compare_exchange_weak(head, top));
+    // pairs with the store of is_waiting_ before the consumer checks head_ for the last time
+    if (is_waiting_.load()) {
+      std::unique_lock<std::mutex> lock(*mut_mutex());
+      mut_cond()->notify_one();
+    }
+  }
+
+  bool TryPopAllTo(ListType* dst) {
+    EmbeddedListLink* link = head_.exchange(nullptr, std::memory_order_acquire);
+    if (link == nullptr) { return false; }
+    EmbeddedListLink* reversed = nullptr;
+    while (link != nullptr) {
+      EmbeddedListLink* next = link->next();
+      link->set_next(reversed);
+      reversed = link;
+      link = next;
+    }
+    while (reversed != nullptr) {
+      EmbeddedListLink* next = reversed->next();
+      reversed->Clear();
+      value_type* raw_ptr = LinkField::StructPtr4FieldPtr(reversed);
+      dst->EmplaceBack(ObjectMsgPtr<value_type>::__UnsafeMove__(raw_ptr));
+      reversed = next;
+    }
+    return true;
+  }
+
+  std::mutex* mut_mutex() { return reinterpret_cast<std::mutex*>(&mutex_buff_[0]); }
+  std::condition_variable* mut_cond() {
+    return reinterpret_cast<std::condition_variable*>(&cond_buff_[0]);
+  }
+
+  std::atomic<EmbeddedListLink*> head_;
+  std::atomic<bool> is_closed_;
+  std::atomic<bool> is_waiting_;
+  union {
+    char mutex_buff_[sizeof(std::mutex)];
+    int64_t mutex_buff_align_;
+  };
+  union {
+    char cond_buff_[sizeof(std::condition_variable)];
+    int64_t cond_buff_align_;
+  };
+};
+
+template<typename LinkField>
+class ObjectMsgLockFreeList : public TrivialObjectMsgLockFreeList<LinkField> {
+ public:
+  ObjectMsgLockFreeList(const ObjectMsgLockFreeList&) = delete;
+  ObjectMsgLockFreeList(ObjectMsgLockFreeList&&) = delete;
+  ObjectMsgLockFreeList() { this->__Init__(); }
+  ~ObjectMsgLockFreeList() { this->__Delete__(); }
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_OBJECT_MSG_LOCK_FREE_LIST_H_
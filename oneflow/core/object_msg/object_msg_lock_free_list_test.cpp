@@ -0,0 +1,125 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/object_msg/object_msg.h"
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/range.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+// clang-format off
+OBJECT_MSG_BEGIN(Foo);
+  // fields
+  OBJECT_MSG_DEFINE_OPTIONAL(int, x);
+
+  // links
+  OBJECT_MSG_DEFINE_LIST_LINK(link);
+OBJECT_MSG_END(Foo);
+// clang-format on
+
+// clang-format off
+OBJECT_MSG_BEGIN(FooList);
+  // links
+  OBJECT_MSG_DEFINE_LOCK_FREE_LIST_HEAD(Foo, link, list);
+OBJECT_MSG_END(FooList);
+// clang-format on
+
+using LockFreeListFoo = OBJECT_MSG_LOCK_FREE_LIST(Foo, link);
+
+void CallFromSenderThread(LockFreeListFoo* lock_free_list, Range range) {
+  for (int i = range.begin(); i < range.end(); ++i) {
+    auto foo = ObjectMsgPtr<Foo>::New();
+    foo->set_x(i);
+    if (lock_free_list->EmplaceBack(std::move(foo)) != kObjectMsgConditionListStatusSuccess) {
+      break;
+    }
+  }
+}
+
+void CallFromSenderThreadByMoveFrom(LockFreeListFoo* lock_free_list, Range range) {
+  OBJECT_MSG_LIST(Foo, link) tmp_list;
+  for (int i = range.begin(); i < range.end(); ++i) {
+    auto foo = ObjectMsgPtr<Foo>::New();
+    foo->set_x(i);
+    tmp_list.EmplaceBack(std::move(foo));
+    if (tmp_list.size() == 3) { lock_free_list->MoveFrom(&tmp_list); }
+  }
+  lock_free_list->MoveFrom(&tmp_list);
+}
+
+typedef void (*ThreadHandlerType)(LockFreeListFoo* lock_free_list, Range range);
+
+void TestLockFreeList(ThreadHandlerType ThreadHandler) {
+  LockFreeListFoo lock_free_list;
+  std::vector<std::thread> senders;
+  int sender_num = 30;
+  int range_num = 200;
+  std::vector<int> visit(range_num, 0);
+  bool in_order = true;
+  std::thread receiver([&]() {
+    std::vector<int> last_x(sender_num, -1);
+    OBJECT_MSG_LIST(Foo, link) tmp_list;
+    while (lock_free_list.MoveTo(&tmp_list) == kObjectMsgConditionListStatusSuccess) {
+      OBJECT_MSG_LIST_FOR_EACH_PTR(&tmp_list, foo) {
+        int sender_id = foo->x() / range_num;
+        int x = foo->x() % range_num;
+        if (x <= last_x.at(sender_id)) { in_order = false; }
+        last_x.at(sender_id) = x;
+        ++visit.at(x);
+        tmp_list.Erase(foo);
+      }
+    }
+  });
+  for (int i = 0; i < sender_num; ++i) {
+    Range range(i * range_num, (i + 1) * range_num);
+    senders.push_back(std::thread(ThreadHandler, &lock_free_list, range));
+  }
+  for (std::thread& this_thread : senders) { this_thread.join(); }
+  lock_free_list.Close();
+  receiver.join();
+  ASSERT_TRUE(in_order);
+  for (int i = 0; i < range_num; ++i) { ASSERT_EQ(visit.at(i), sender_num); }
+}
+
+TEST(ObjectMsgLockFreeList, 30sender1receiver_emplace_back) {
+  TestLockFreeList(&CallFromSenderThread);
+}
+
+TEST(ObjectMsgLockFreeList, 30sender1receiver_move_from) {
+  TestLockFreeList(&CallFromSenderThreadByMoveFrom);
+}
+
+TEST(ObjectMsgLockFreeList, reject_after_close) {
+  LockFreeListFoo lock_free_list;
+  ASSERT_EQ(lock_free_list.EmplaceBack(ObjectMsgPtr<Foo>::New()),
+            kObjectMsgConditionListStatusSuccess);
+  lock_free_list.Close();
+  ASSERT_EQ(lock_free_list.EmplaceBack(ObjectMsgPtr<Foo>::New()),
+            kObjectMsgConditionListStatusErrorClosed);
+  OBJECT_MSG_LIST(Foo, link) tmp_list;
+  ASSERT_EQ(lock_free_list.MoveTo(&tmp_list), kObjectMsgConditionListStatusSuccess);
+  ASSERT_EQ(tmp_list.size(), 1);
+  ASSERT_EQ(lock_free_list.MoveTo(&tmp_list), kObjectMsgConditionListStatusErrorClosed);
+}
+
+}  // namespace
+
+}  // namespace test
+
+}  // namespace oneflow
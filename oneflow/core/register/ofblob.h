@@ -35,6 +35,12 @@ class OfBlob final {
   int data_type() const { return blob_->data_type(); }
   size_t NumAxes() const { return blob_->shape().NumAxes(); }
   bool is_dynamic() const { return blob_->blob_desc().is_dynamic(); }
+  bool is_host_mem() const { return blob_->mem_case().has_host_mem(); }
+  size_t ByteSizeOfBody() const { return blob_->ByteSizeOfBlobBody(); }
+  const char* host_dptr() const {
+    CHECK(is_host_mem());
+    return static_cast<const char*>(blob_->dptr());
+  }
   void CopyShapeTo(int64_t* ptr, int64_t num_axis) const;
   void CopyStaticShapeTo(int64_t* ptr, int64_t num_axis) const;
   void CopyShapeFrom(const int64_t* ptr, int64_t num_axis) const;
@@ -44,6 +50,9 @@ class OfBlob final {
   template<typename T>
   void AutoMemCopyFrom(const T* ptr, int64_t len) const;
   void AsyncAutoMemset(const char value) const;
+  // Raw copies of len bytes starting at byte offset of the body, for gathering/scattering rows.
+  void AutoMemCopyBodyTo(void* ptr, size_t offset, size_t len) const;
+  void AutoMemCopyBodyFrom(const void* ptr, size_t offset, size_t len) const;
 
  private:
   DeviceCtx* device_ctx_;
@@ -88,6 +97,19 @@ void OfBlob::AutoMemCopyFrom(const T* ptr, int64_t len) const {
                  mem_case_);
 }
 
+inline void OfBlob::AutoMemCopyBodyTo(void* ptr, size_t offset, size_t len) const {
+  CHECK_LE(offset + len, blob_->ByteSizeOfBlobBody());
+  SyncAutoMemcpy(device_ctx_, ptr, static_cast<const char*>(blob_->dptr()) + offset, len,
+                 mem_case_, blob_->mem_case());
+}
+
+inline void OfBlob::AutoMemCopyBodyFrom(const void* ptr, size_t offset, size_t len) const {
+  blob_->blob_access_checker()->CheckBodyMutable();
+  CHECK_LE(offset + len, blob_->ByteSizeOfBlobBody());
+  SyncAutoMemcpy(device_ctx_, static_cast<char*>(blob_->mut_dptr()) + offset, ptr, len,
+                 blob_->mem_case(), mem_case_);
+}
+
 inline void OfBlob::AsyncAutoMemset(const char value) const {
   ::oneflow::AutoMemset(device_ctx_, blob_->mut_dptr(), value,
                         blob_->shape().elem_cnt() * GetSizeOfDataType(blob_->data_type()),
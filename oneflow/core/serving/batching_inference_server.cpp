@@ -0,0 +1,323 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/serving/batching_inference_server.h"
+#include "oneflow/core/common/buffer_manager.h"
+#include "oneflow/core/control/global_process_ctx.h"
+#include "oneflow/core/job/foreign_job_instance.h"
+#include "oneflow/core/job/inter_user_job_info.pb.h"
+#include "oneflow/core/job/job_build_and_infer_ctx_mgr.h"
+#include "oneflow/core/job/job_desc.h"
+#include "oneflow/core/job/oneflow.h"
+#include "oneflow/core/register/ofblob.h"
+
+namespace oneflow {
+
+struct BatchingInferenceServer::Request {
+  ServingTensorMap inputs;
+  int64_t num_rows;
+  std::chrono::steady_clock::time_point enqueue_time;
+  std::promise<ServingTensorMap> promise;
+  // Set by the push or the pull jobs of the batch, guarded by the mutex of the batch
+  std::exception_ptr error;
+};
+
+struct BatchingInferenceServer::Batch {
+  std::vector<std::shared_ptr<Request>> requests;
+  int64_t num_rows;
+  std::mutex mutex;
+  std::vector<ServingTensorMap> outputs;
+  size_t num_pulled_outputs;
+};
+
+namespace {
+
+class ServingJobInstance final : public ForeignJobInstance {
+ public:
+  ServingJobInstance(const std::string& job_name, const std::string& op_name,
+                     const std::function<void(OfBlob*)>& Push,
+                     const std::function<void(OfBlob*)>& Pull)
+      : job_name_(job_name), op_name_(op_name), push_(Push), pull_(Pull) {}
+  ~ServingJobInstance() override = default;
+
+  std::string job_name() const override { return job_name_; }
+  std::string sole_input_op_name_in_user_job() const override { return op_name_; }
+  std::string sole_output_op_name_in_user_job() const override { return op_name_; }
+  void PushBlob(uint64_t ofblob_ptr) const override {
+    push_(reinterpret_cast<OfBlob*>(ofblob_ptr));
+  }
+  void PullBlob(uint64_t ofblob_ptr) const override {
+    pull_(reinterpret_cast<OfBlob*>(ofblob_ptr));
+  }
+  void Finish() const override {}
+
+ private:
+  std::string job_name_;
+  std::string op_name_;
+  std::function<void(OfBlob*)> push_;
+  std::function<void(OfBlob*)> pull_;
+};
+
+void LaunchJob(const std::shared_ptr<ForeignJobInstance>& job_instance) {
+  const std::string& job_name = job_instance->job_name();
+  const auto& inter_user_job_info = *Global<InterUserJobInfo>::Get();
+  auto* buffer_mgr = Global<BufferMgr<std::shared_ptr<ForeignJobInstance>>>::Get();
+  const int64_t job_id = Global<JobName2JobId>::Get()->at(job_name);
+  if (IsPullJob(job_name, inter_user_job_info)) {
+    buffer_mgr->Get(GetForeignOutputBufferName(job_name))->Send(job_instance);
+  }
+  if (IsPushJob(job_name, inter_user_job_info)) {
+    buffer_mgr->Get(GetForeignInputBufferName(job_name))->Send(job_instance);
+  }
+  buffer_mgr->Get(GetCallbackNotifierBufferName(job_name))->Send(job_instance);
+  Global<BufferMgr<int64_t>>::Get()->Get(kBufferNameGlobalWaitJobId)->Send(job_id);
+}
+
+DimVector GetStaticShape(const OfBlob* ofblob) {
+  DimVector dim_vec(ofblob->NumAxes());
+  ofblob->CopyStaticShapeTo(dim_vec.data(), dim_vec.size());
+  return dim_vec;
+}
+
+DimVector GetShape(const OfBlob* ofblob) {
+  DimVector dim_vec(ofblob->NumAxes());
+  ofblob->CopyShapeTo(dim_vec.data(), dim_vec.size());
+  return dim_vec;
+}
+
+size_t GetRowByteSize(const DimVector& dim_vec, DataType data_type) {
+  CHECK_GE(dim_vec.size(), 1);
+  size_t row_size = GetSizeOfDataType(data_type);
+  FOR_RANGE(size_t, i, 1, dim_vec.size()) { row_size *= dim_vec.at(i); }
+  return row_size;
+}
+
+}  // namespace
+
+BatchingInferenceServer::BatchingInferenceServer(const BatchingInferenceServerConf& conf)
+    : conf_(conf), num_pending_rows_(0), is_closed_(false) {
+  CHECK(GlobalProcessCtx::IsThisProcessMaster());
+  CHECK_NOTNULL(Global<Oneflow>::Get());
+  CHECK_GT(conf_.max_batch_size, 0);
+  CHECK_GE(conf_.batch_timeout_us, 0);
+  const auto* job_name2job_id = Global<JobName2JobId>::Get();
+  CHECK(job_name2job_id->find(conf_.job_name) != job_name2job_id->end())
+      << "job " << conf_.job_name << " not found";
+  // The push and pull jobs are those of all the jobs of the session, only the ones of the inputs
+  // and the outputs of this job are run
+  HashMap<std::string, const OperatorConf*> op_name2op_conf;
+  for (const Job& job : Global<LazyJobBuildAndInferCtxMgr>::Get()->job_set().job()) {
+    if (job.job_conf().job_name() != conf_.job_name) { continue; }
+    for (const OperatorConf& op_conf : job.net().op()) {
+      op_name2op_conf.emplace(op_conf.name(), &op_conf);
+    }
+  }
+  const auto& inter_user_job_info = *Global<InterUserJobInfo>::Get();
+  for (const auto& pair : inter_user_job_info.input_or_var_op_name2push_job_name()) {
+    const auto it = op_name2op_conf.find(pair.first);
+    if (it == op_name2op_conf.end() || !it->second->has_input_conf()) { continue; }
+    const InterfaceBlobConf& blob_conf = it->second->input_conf().blob_conf();
+    CHECK_GE(blob_conf.shape().dim_size(), 1);
+    CHECK_LE(conf_.max_batch_size, blob_conf.shape().dim(0))
+        << "max_batch_size is larger than the batch size of input " << pair.first;
+    InputDesc desc;
+    desc.data_type = blob_conf.data_type();
+    desc.row_dims.assign(blob_conf.shape().dim().begin() + 1, blob_conf.shape().dim().end());
+    input_name2desc_.emplace(pair.first, desc);
+    input_name2push_job_name_.emplace(pair.first, pair.second);
+  }
+  for (const auto& pair : inter_user_job_info.output_or_var_op_name2pull_job_name()) {
+    if (op_name2op_conf.count(pair.first) == 0) { continue; }
+    output_name2pull_job_name_.emplace(pair.first, pair.second);
+  }
+  schedule_thread_ = std::thread(&BatchingInferenceServer::ScheduleLoop, this);
+}
+
+BatchingInferenceServer::~BatchingInferenceServer() { Close(); }
+
+Maybe<std::shared_future<ServingTensorMap>> BatchingInferenceServer::Submit(
+    const ServingTensorMap& inputs) {
+  CHECK_EQ_OR_RETURN(inputs.size(), input_name2push_job_name_.size());
+  auto request = std::make_shared<Request>();
+  request->num_rows = -1;
+  for (const auto& pair : input_name2push_job_name_) {
+    const auto it = inputs.find(pair.first);
+    CHECK_OR_RETURN(it != inputs.end()) << "input " << pair.first << " is absent";
+    const TensorBuffer* tensor = it->second.get();
+    CHECK_NOTNULL_OR_RETURN(tensor);
+    const InputDesc& desc = input_name2desc_.at(pair.first);
+    CHECK_EQ_OR_RETURN(tensor->data_type(), desc.data_type) << "input " << pair.first;
+    CHECK_EQ_OR_RETURN(tensor->shape().NumAxes(), desc.row_dims.size() + 1)
+        << "input " << pair.first;
+    FOR_RANGE(int64_t, i, 1, tensor->shape().NumAxes()) {
+      CHECK_EQ_OR_RETURN(tensor->shape().At(i), desc.row_dims.at(i - 1))
+          << "axis " << i << " of input " << pair.first;
+    }
+    if (request->num_rows == -1) { request->num_rows = tensor->shape().At(0); }
+    CHECK_EQ_OR_RETURN(tensor->shape().At(0), request->num_rows)
+        << "inputs of a request must have the same batch size";
+    CHECK_EQ_OR_RETURN(tensor->nbytes(),
+                       request->num_rows * GetRowByteSize(tensor->shape().dim_vec(),
+                                                          desc.data_type))
+        << "input " << pair.first;
+  }
+  CHECK_GT_OR_RETURN(request->num_rows, 0);
+  CHECK_LE_OR_RETURN(request->num_rows, conf_.max_batch_size);
+  request->inputs = inputs;
+  request->enqueue_time = std::chrono::steady_clock::now();
+  std::shared_future<ServingTensorMap> future = request->promise.get_future().share();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    CHECK_OR_RETURN(!is_closed_) << "server closed";
+    num_pending_rows_ += request->num_rows;
+    pending_requests_.push_back(std::move(request));
+    stats_.num_requests += 1;
+  }
+  cond_.notify_all();
+  return future;
+}
+
+void BatchingInferenceServer::Close() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (is_closed_) { return; }
+    is_closed_ = true;
+  }
+  cond_.notify_all();
+  schedule_thread_.join();
+}
+
+BatchingInferenceServerStats BatchingInferenceServer::stats() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void BatchingInferenceServer::ScheduleLoop() {
+  const auto batch_timeout = std::chrono::microseconds(conf_.batch_timeout_us);
+  while (true) {
+    auto batch = std::make_shared<Batch>();
+    batch->num_rows = 0;
+    batch->num_pulled_outputs = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this]() { return is_closed_ || !pending_requests_.empty(); });
+      // Pending requests are still served after Close
+      if (pending_requests_.empty()) { break; }
+      const auto deadline = pending_requests_.front()->enqueue_time + batch_timeout;
+      cond_.wait_until(lock, deadline, [this]() {
+        return is_closed_ || num_pending_rows_ >= conf_.max_batch_size;
+      });
+      while (!pending_requests_.empty()
+             && batch->num_rows + pending_requests_.front()->num_rows <= conf_.max_batch_size) {
+        batch->num_rows += pending_requests_.front()->num_rows;
+        batch->requests.push_back(std::move(pending_requests_.front()));
+        pending_requests_.pop_front();
+      }
+      num_pending_rows_ -= batch->num_rows;
+      stats_.num_batches += 1;
+      stats_.num_batched_rows += batch->num_rows;
+    }
+    LaunchBatch(batch);
+  }
+}
+
+void BatchingInferenceServer::LaunchBatch(const std::shared_ptr<Batch>& batch) {
+  batch->outputs.resize(batch->requests.size());
+  const std::function<void(OfBlob*)> Undefined = [](OfBlob*) { UNIMPLEMENTED(); };
+  // The first error of a request is the one its future gets once the outputs are pulled
+  const auto SetRequestError = [](Batch* owner, Request* request, const std::string& message) {
+    std::unique_lock<std::mutex> lock(owner->mutex);
+    if (!request->error) { request->error = std::make_exception_ptr(std::runtime_error(message)); }
+  };
+  for (const auto& pair : input_name2push_job_name_) {
+    const std::string& input_name = pair.first;
+    const auto Push = [batch, input_name, SetRequestError](OfBlob* ofblob) {
+      DimVector shape = GetStaticShape(ofblob);
+      const DataType data_type = static_cast<DataType>(ofblob->data_type());
+      const size_t row_size = GetRowByteSize(shape, data_type);
+      CHECK_LE(batch->num_rows, shape.at(0)) << "checked against max_batch_size";
+      if (ofblob->is_dynamic()) {
+        shape.at(0) = batch->num_rows;
+        ofblob->CopyShapeFrom(shape.data(), shape.size());
+      } else if (batch->num_rows < shape.at(0)) {
+        // Static batch dims are padded with zeros, the padded rows of the outputs are dropped
+        ofblob->AsyncAutoMemset(0);
+      }
+      size_t offset = 0;
+      for (const auto& request : batch->requests) {
+        const TensorBuffer* tensor = request->inputs.at(input_name).get();
+        // Submit checked the request against the input op, the blob may still differ from it
+        if (tensor->data_type() != data_type || tensor->nbytes() != request->num_rows * row_size) {
+          SetRequestError(batch.get(), request.get(),
+                          "input " + input_name + " does not match the blob of the job");
+        } else {
+          ofblob->AutoMemCopyBodyFrom(tensor->data(), offset, tensor->nbytes());
+        }
+        offset += request->num_rows * row_size;
+      }
+    };
+    LaunchJob(std::make_shared<ServingJobInstance>(pair.second, input_name, Push, Undefined));
+  }
+  LaunchJob(std::make_shared<ServingJobInstance>(conf_.job_name, "", Undefined, Undefined));
+  const size_t num_outputs = output_name2pull_job_name_.size();
+  for (const auto& pair : output_name2pull_job_name_) {
+    const std::string& output_name = pair.first;
+    const auto Pull = [batch, output_name, num_outputs, SetRequestError](OfBlob* ofblob) {
+      const DimVector shape = GetShape(ofblob);
+      const DataType data_type = static_cast<DataType>(ofblob->data_type());
+      const size_t row_size = GetRowByteSize(shape, data_type);
+      // An output which is not a row per row of the inputs can't be scattered to the requests
+      const bool has_all_rows = shape.at(0) >= batch->num_rows;
+      std::vector<std::shared_ptr<TensorBuffer>> request_outputs;
+      size_t offset = 0;
+      for (const auto& request : batch->requests) {
+        if (!has_all_rows) {
+          SetRequestError(batch.get(), request.get(),
+                          "output " + output_name + " has fewer rows than the batch");
+          request_outputs.emplace_back();
+          continue;
+        }
+        DimVector request_shape = shape;
+        request_shape.at(0) = request->num_rows;
+        auto tensor = std::make_shared<TensorBuffer>();
+        tensor->Resize(Shape(request_shape), data_type);
+        ofblob->AutoMemCopyBodyTo(tensor->mut_data(), offset, request->num_rows * row_size);
+        offset += request->num_rows * row_size;
+        request_outputs.push_back(std::move(tensor));
+      }
+      std::unique_lock<std::mutex> lock(batch->mutex);
+      FOR_RANGE(size_t, i, 0, batch->requests.size()) {
+        batch->outputs.at(i).emplace(output_name, request_outputs.at(i));
+      }
+      batch->num_pulled_outputs += 1;
+      if (batch->num_pulled_outputs == num_outputs) {
+        FOR_RANGE(size_t, i, 0, batch->requests.size()) {
+          Request* request = batch->requests.at(i).get();
+          if (request->error) {
+            request->promise.set_exception(request->error);
+          } else {
+            request->promise.set_value(std::move(batch->outputs.at(i)));
+          }
+        }
+      }
+    };
+    LaunchJob(std::make_shared<ServingJobInstance>(pair.second, output_name, Undefined, Pull));
+  }
+  if (num_outputs == 0) {
+    for (const auto& request : batch->requests) { request->promise.set_value(ServingTensorMap()); }
+  }
+}
+
+}  // namespace oneflow
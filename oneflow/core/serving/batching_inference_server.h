@@ -0,0 +1,91 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_SERVING_BATCHING_INFERENCE_SERVER_H_
+#define ONEFLOW_CORE_SERVING_BATCHING_INFERENCE_SERVER_H_
+
+#include <deque>
+#include <future>
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+using ServingTensorMap = HashMap<std::string, std::shared_ptr<TensorBuffer>>;
+
+struct BatchingInferenceServerConf {
+  // The user job to serve, it must have been compiled by an InferenceSession.
+  std::string job_name;
+  // Upper bound of the sum of the batch dims of the requests coalesced into one job instance.
+  // Usually the static batch dim of the job inputs.
+  int64_t max_batch_size = 1;
+  // How long the oldest queued request may wait for more requests to batch with.
+  int64_t batch_timeout_us = 1000;
+};
+
+struct BatchingInferenceServerStats {
+  int64_t num_requests = 0;
+  int64_t num_batches = 0;
+  int64_t num_batched_rows = 0;
+};
+
+// Native serving frontend of a running session. Concurrent requests are queued and coalesced
+// along axis 0 into batches of up to max_batch_size rows, each batch runs as one instance of the
+// push jobs, the user job and the pull jobs, then the output rows are scattered back to the
+// requests. A request is never split across batches.
+class BatchingInferenceServer final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(BatchingInferenceServer);
+  explicit BatchingInferenceServer(const BatchingInferenceServerConf& conf);
+  ~BatchingInferenceServer();
+
+  // All inputs of the job must be given, with the data types and the row shapes of the inputs of
+  // the job and the same size of axis 0 which is at most max_batch_size. The future gets every
+  // output of the job, or the error of the batch of the request.
+  Maybe<std::shared_future<ServingTensorMap>> Submit(const ServingTensorMap& inputs);
+  void Close();
+
+  BatchingInferenceServerStats stats() const;
+
+ private:
+  struct Request;
+  struct Batch;
+  struct InputDesc {
+    DataType data_type;
+    // Sizes of the axes after axis 0
+    DimVector row_dims;
+  };
+
+  void ScheduleLoop();
+  void LaunchBatch(const std::shared_ptr<Batch>& batch);
+
+  BatchingInferenceServerConf conf_;
+  HashMap<std::string, std::string> input_name2push_job_name_;
+  HashMap<std::string, InputDesc> input_name2desc_;
+  HashMap<std::string, std::string> output_name2pull_job_name_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<std::shared_ptr<Request>> pending_requests_;
+  int64_t num_pending_rows_;
+  bool is_closed_;
+  BatchingInferenceServerStats stats_;
+  std::thread schedule_thread_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_SERVING_BATCHING_INFERENCE_SERVER_H_
@@ -75,4 +75,29 @@ void MultiThreadLoop(size_t num, std::function<void(size_t i)> Callback) {
   bc.WaitUntilCntEqualZero();
 }
 
+int64_t GetNumThreadRanges(int64_t num, int64_t item_size) {
+  const int64_t max_num_ranges = std::max<int64_t>(num * item_size / kMinElemCntPerThreadRange, 1);
+  const int64_t thread_num = Global<ThreadPool>::Get()->thread_num();
+  return std::max<int64_t>(std::min({num, max_num_ranges, thread_num}), 1);
+}
+
+void MultiThreadLoopInRanges(
+    int64_t num, int64_t num_ranges,
+    std::function<void(int64_t range_id, int64_t begin, int64_t end)> Callback) {
+  if (num_ranges <= 1) {
+    Callback(0, 0, num);
+    return;
+  }
+  const BalancedSplitter bs(num, num_ranges);
+  BlockingCounter bc(num_ranges);
+  FOR_RANGE(int64_t, range_id, 0, num_ranges) {
+    const Range range = bs.At(range_id);
+    Global<ThreadPool>::Get()->AddWork([&bc, &Callback, range_id, range] {
+      Callback(range_id, range.begin(), range.end());
+      bc.Decrease();
+    });
+  }
+  bc.WaitUntilCntEqualZero();
+}
+
 }  // namespace oneflow
@@ -44,6 +44,16 @@ class ThreadMgr final {
 void SingleThreadLoop(size_t num, std::function<void(size_t i)> Callback);
 void MultiThreadLoop(size_t num, std::function<void(size_t i)> Callback);
 
+// The number of ranges of the thread pool to split num items of item_size elements each into,
+// a range gets at least kMinElemCntPerThreadRange elements.
+constexpr int64_t kMinElemCntPerThreadRange = 32768;
+int64_t GetNumThreadRanges(int64_t num, int64_t item_size);
+// Calls Callback(range_id, begin, end) for num_ranges balanced ranges of [0, num), in the thread
+// pool if there are several of them.
+void MultiThreadLoopInRanges(
+    int64_t num, int64_t num_ranges,
+    std::function<void(int64_t range_id, int64_t begin, int64_t end)> Callback);
+
 #define REGISTER_DEVICE_THREAD_CREATOR_WITH_STREAM_ID(device, creator) \
   REGISTER_CLASS_CREATOR(int, device, Thread, creator, const StreamId&)
 
@@ -0,0 +1,212 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/control/global_process_ctx.h"
+#include "oneflow/core/job/env.pb.h"
+#include "oneflow/core/job/env_desc.h"
+#include "oneflow/core/control/ctrl_client.h"
+#include "oneflow/core/control/ctrl_server.h"
+#include "oneflow/core/control/ctrl_bootstrap.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/comm_network/epoll/epoll_comm_network.h"
+#include "oneflow/core/transport/transport.h"
+
+#include <chrono>
+#include <iomanip>
+
+namespace oneflow {
+
+namespace {
+
+EnvProto GetEnvProto(int64_t rank, int64_t world_size, int32_t ctrl_port) {
+  EnvProto ret;
+  auto* machine = ret.add_machine();
+  machine->set_id(0);
+  machine->set_addr("127.0.0.1");
+  ret.set_ctrl_port(ctrl_port);
+  BootstrapConf* bootstrap_conf = ret.mutable_ctrl_bootstrap_conf();
+  bootstrap_conf->mutable_master_addr()->set_host("127.0.0.1");
+  bootstrap_conf->mutable_master_addr()->set_port(ctrl_port);
+  bootstrap_conf->set_rank(rank);
+  bootstrap_conf->set_world_size(world_size);
+  bootstrap_conf->set_host("127.0.0.1");
+  bootstrap_conf->set_node_size(1);
+  return ret;
+}
+
+Resource GetResource(int64_t world_size) {
+  Resource ret;
+  ret.set_machine_num(1);
+  ret.set_gpu_device_num(0);
+  ret.set_cpu_device_num(world_size);
+  ret.set_comm_net_worker_num(1);
+  return ret;
+}
+
+double MicroSecondsSince(const std::chrono::steady_clock::time_point& begin) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()
+                                                               - begin)
+             .count()
+         / 1000.0;
+}
+
+// Every even rank pings the next odd one, so all the pairs of the host share the memory bandwidth.
+double PingPongLatency(uint64_t bytes, int32_t iteration, uint64_t first_token) {
+  const int64_t this_machine_id = GlobalProcessCtx::Rank();
+  const bool is_ping = this_machine_id % 2 == 0;
+  const int64_t peer_id = is_ping ? this_machine_id + 1 : this_machine_id - 1;
+  std::vector<char> buffer(bytes);
+  void* ptr = buffer.data();
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for (int32_t i = 0; i < iteration; ++i) {
+    const uint64_t ping_token = first_token + 2 * i;
+    const uint64_t pong_token = ping_token + 1;
+    BlockingCounter first_done(1);
+    BlockingCounter second_done(1);
+    if (is_ping) {
+      Global<Transport>::Get()->Send(ping_token, peer_id, ptr, bytes,
+                                     [&first_done]() { first_done.Decrease(); });
+      Global<Transport>::Get()->Receive(pong_token, peer_id, ptr, bytes,
+                                        [&second_done]() { second_done.Decrease(); });
+    } else {
+      Global<Transport>::Get()->Receive(ping_token, peer_id, ptr, bytes,
+                                        [&first_done]() { first_done.Decrease(); });
+      first_done.WaitUntilCntEqualZero();
+      Global<Transport>::Get()->Send(pong_token, peer_id, ptr, bytes,
+                                     [&second_done]() { second_done.Decrease(); });
+    }
+    first_done.WaitUntilCntEqualZero();
+    second_done.WaitUntilCntEqualZero();
+  }
+  return MicroSecondsSince(begin) / iteration / 2;
+}
+
+double Bandwidth(uint64_t bytes, int32_t iteration, uint64_t first_token) {
+  const int64_t this_machine_id = GlobalProcessCtx::Rank();
+  const bool is_sender = this_machine_id % 2 == 0;
+  const int64_t peer_id = is_sender ? this_machine_id + 1 : this_machine_id - 1;
+  std::vector<std::vector<char>> buffers(iteration, std::vector<char>(bytes));
+  BlockingCounter bc(iteration);
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for (int32_t i = 0; i < iteration; ++i) {
+    void* ptr = buffers.at(i).data();
+    if (is_sender) {
+      Global<Transport>::Get()->Send(first_token + i, peer_id, ptr, bytes,
+                                     [&bc]() { bc.Decrease(); });
+    } else {
+      Global<Transport>::Get()->Receive(first_token + i, peer_id, ptr, bytes,
+                                        [&bc]() { bc.Decrease(); });
+    }
+  }
+  bc.WaitUntilCntEqualZero();
+  return bytes * iteration / MicroSecondsSince(begin);  // MB/s
+}
+
+void BenchLatency() {
+  if (GlobalProcessCtx::Rank() == 0) {
+    std::cout << std::setw(20) << std::left << "#bytes" << std::setw(20) << std::left
+              << "#latency[us]" << std::endl;
+  }
+  for (int i = 0; i < 13; ++i) {
+    const uint64_t bytes = 8 << i;
+    PingPongLatency(bytes, 100, 100000 * (i + 1));
+    const double latency = PingPongLatency(bytes, 1000, 100000 * (i + 1) + 50000);
+    if (GlobalProcessCtx::Rank() == 0) {
+      std::cout << std::setw(20) << std::left << bytes << std::setw(20) << std::left << latency
+                << std::endl;
+    }
+    OF_ENV_BARRIER();
+  }
+}
+
+void BenchBandwidth() {
+  if (GlobalProcessCtx::Rank() == 0) {
+    std::cout << std::setw(20) << std::left << "#bytes" << std::setw(20) << std::left
+              << "#bandwidth[MB/s]" << std::endl;
+  }
+  for (int i = 0; i < 8; ++i) {
+    const uint64_t bytes = 64 << (2 * i);  // 64 B ... 1 MiB
+    const int32_t iteration = 256;
+    const double bandwidth = Bandwidth(bytes, iteration, 10000000 * (i + 1));
+    if (GlobalProcessCtx::Rank() == 0) {
+      std::cout << std::setw(20) << std::left << bytes << std::setw(20) << std::left << bandwidth
+                << std::endl;
+    }
+    OF_ENV_BARRIER();
+  }
+}
+
+Maybe<void> BenchTransportOnLocalHost(int64_t rank, int64_t world_size, int32_t ctrl_port) {
+  CHECK_GE_OR_RETURN(world_size, 2);
+  CHECK_LE_OR_RETURN(world_size, 8);
+  CHECK_EQ_OR_RETURN(world_size % 2, 0) << "the ranks are benchmarked in pairs";
+  EnvProto env_proto = GetEnvProto(rank, world_size, ctrl_port);
+  Global<EnvDesc>::New(env_proto);
+  Global<CtrlServer>::New();
+  Global<ProcessCtx>::New();
+  JUST(RankInfoCtrlBootstrap(Global<EnvDesc>::Get()->bootstrap_conf())
+           .InitProcessCtx(Global<CtrlServer>::Get()->port(), Global<ProcessCtx>::Get()));
+  auto* client = new GrpcCtrlClient(*Global<ProcessCtx>::Get());
+  Global<CtrlClient>::SetAllocated(client);
+  Global<ResourceDesc, ForEnv>::New(GetResource(world_size),
+                                    GlobalProcessCtx::NumOfProcessPerNode());
+  Global<ResourceDesc, ForSession>::New(GetResource(world_size),
+                                        GlobalProcessCtx::NumOfProcessPerNode());
+  Global<EpollCommNet>::New();
+  Global<Transport>::New();
+  OF_ENV_BARRIER();
+
+  if (rank == 0) {
+    std::cout << world_size << " processes, shared memory comm net "
+              << (Global<ResourceDesc, ForSession>::Get()->enable_shm_comm_net() ? "on" : "off")
+              << std::endl;
+  }
+  BenchLatency();
+  BenchBandwidth();
+
+  OF_ENV_BARRIER();
+  Global<Transport>::Delete();
+  Global<EpollCommNet>::Delete();
+  Global<ResourceDesc, ForSession>::Delete();
+  Global<ResourceDesc, ForEnv>::Delete();
+  Global<CtrlClient>::Delete();
+  Global<ProcessCtx>::Delete();
+  Global<CtrlServer>::Delete();
+  Global<EnvDesc>::Delete();
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+}  // namespace oneflow
+
+/*
+ * Run one process per rank on the same host, e.g. with 4 processes:
+ *     for i in 0 1 2 3; do ./transport_local_bench_main_exe -rank=$i -world_size=4 & done
+ * and once more with ONEFLOW_COMM_NET_DISABLE_SHM=1 to compare with the loopback sockets.
+ */
+DEFINE_int64(rank, 0, "rank of this process.");
+DEFINE_int64(world_size, 2, "number of processes, 2, 4, 6 or 8.");
+DEFINE_int32(ctrl_port, 12143, "the control port of rank 0.");
+
+int main(int argc, char* argv[]) {
+  using namespace oneflow;
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  CHECK_JUST(BenchTransportOnLocalHost(FLAGS_rank, FLAGS_world_size, FLAGS_ctrl_port));
+  return 0;
+}
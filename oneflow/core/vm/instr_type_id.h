@@ -50,18 +50,25 @@ class InstrTypeId final {
   void clear() {
     stream_type_id_.clear();
     instruction_type_ = nullptr;
+    instr_type_name_ = nullptr;
   }
   void CopyFrom(const InstrTypeId& rhs) {
     stream_type_id_.CopyFrom(rhs.stream_type_id_);
     instruction_type_ = &rhs.instruction_type();
+    instr_type_name_ = rhs.instr_type_name_;
   }
   // Getters
   const StreamTypeId& stream_type_id() const { return stream_type_id_; }
   const InstructionType& instruction_type() const { return *instruction_type_; }
+  bool has_instr_type_name() const { return instr_type_name_ != nullptr; }
+  const std::string& instr_type_name() const { return *instr_type_name_; }
 
   // Setters
   StreamTypeId* mut_stream_type_id() { return &stream_type_id_; }
   StreamTypeId* mutable_stream_type_id() { return &stream_type_id_; }
+  void set_instr_type_name(const std::string* instr_type_name) {
+    instr_type_name_ = instr_type_name;
+  }
 
   bool operator==(const InstrTypeId& rhs) const {
     return stream_type_id_ == rhs.stream_type_id_ && instruction_type_ == rhs.instruction_type_;
@@ -77,6 +84,8 @@ class InstrTypeId final {
 
  private:
   const InstructionType* instruction_type_;
+  // points to the key of the registry, so copying an InstrTypeId never copies the name
+  const std::string* instr_type_name_;
   StreamTypeId stream_type_id_;
 };
 
@@ -56,19 +56,21 @@ void InitFromProto(InstructionMsg* that, const T& proto) {
 
 InstructionOperand* InstructionMsg::add_instr_operand() {
   auto* operand_vec = mutable_operand();
+  // reserved on demand, the instructions with a phy_instr_operand never add operands
+  if (operand_vec->capacity() == 0) { operand_vec->reserve(kReservedOperandVecSize); }
   operand_vec->emplace_back();
   return operand_vec->back().Mutable();
 }
 
-void InstructionMsg::__Init__() {
-  *mutable_instr_type_name() = "";
-  mutable_operand_list()->mut_operand()->reserve(kReservedOperandVecSize);
-}
+void InstructionMsg::__Init__() { mutable_operand_list(); }
 
 void InstructionMsg::__Init__(const std::string& instr_type_name) {
+  __Init__(LookupInstrTypeId(instr_type_name));
+}
+
+void InstructionMsg::__Init__(const InstrTypeId& instr_type_id) {
   __Init__();
-  mutable_instr_type_id()->CopyFrom(LookupInstrTypeId(instr_type_name));
-  *mutable_instr_type_name() = instr_type_name;
+  mutable_instr_type_id()->CopyFrom(instr_type_id);
 }
 
 void InstructionMsg::__Init__(const InstructionProto& proto) { InitFromProto(this, proto); }
@@ -77,7 +79,6 @@ void InstructionMsg::__Init__(const cfg::InstructionProto& proto) { InitFromProt
 void InstructionMsg::__Init__(const InstructionMsg& instr_msg) {
   __Init__();
   mutable_instr_type_id()->CopyFrom(instr_msg.instr_type_id());
-  *mutable_instr_type_name() = instr_msg.instr_type_name();
   if (instr_msg.parallel_desc()) { *mut_parallel_desc() = instr_msg.parallel_desc(); }
   if (instr_msg.has_parallel_desc_symbol_id()) {
     set_parallel_desc_symbol_id(instr_msg.parallel_desc_symbol_id());
@@ -213,6 +214,12 @@ ObjectMsgPtr<InstructionMsg> InstructionMsg::add_del_operand(ObjectId logical_ob
   return this;
 }
 
+const std::string& InstructionMsg::instr_type_name() const {
+  static const std::string empty_name;
+  if (!instr_type_id().has_instr_type_name()) { return empty_name; }
+  return instr_type_id().instr_type_name();
+}
+
 ObjectMsgPtr<InstructionMsg> InstructionMsg::MakeInferInstrMsg() const {
   auto infer_instr_msg = ObjectMsgPtr<InstructionMsg>::NewFrom(mut_allocator(), *this);
   auto* stream_type_id = infer_instr_msg->mut_instr_type_id()->mut_stream_type_id();
@@ -43,6 +43,7 @@ OBJECT_MSG_BEGIN(InstructionMsg);
   // methods
   OF_PUBLIC void __Init__();
   OF_PUBLIC void __Init__(const std::string& instr_type_name);
+  OF_PUBLIC void __Init__(const InstrTypeId& instr_type_id);
   OF_PUBLIC void __Init__(const InstructionProto& proto);
   OF_PUBLIC void __Init__(const cfg::InstructionProto& proto); 
   OF_PUBLIC void __Init__(const InstructionMsg& instr_msg);
@@ -75,12 +76,12 @@ OBJECT_MSG_BEGIN(InstructionMsg);
   OF_PUBLIC std::vector<FlatMsg<InstructionOperand>>* mutable_operand() {
     return mutable_operand_list()->mut_operand();
   }
+  OF_PUBLIC const std::string& instr_type_name() const;
   OF_PUBLIC ObjectMsgPtr<InstructionMsg> MakeInferInstrMsg() const;
 
   // fields
+  // instr_type_id also carries the registered instruction name used by method ToProto
   OBJECT_MSG_DEFINE_STRUCT(InstrTypeId, instr_type_id);
-  // instr_type_name is a necessary reduandant field for method ToProto
-  OBJECT_MSG_DEFINE_STRUCT(std::string, instr_type_name);
   OBJECT_MSG_DEFINE_OPTIONAL(int64_t, parallel_desc_symbol_id);
   OBJECT_MSG_DEFINE_STRUCT(std::shared_ptr<const ParallelDesc>, parallel_desc);
   OBJECT_MSG_DEFINE_OPTIONAL(InstructionOperandList, operand_list);
@@ -0,0 +1,183 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "oneflow/core/control/ctrl_bootstrap.pb.h"
+#include "oneflow/core/vm/instruction_type.h"
+#include "oneflow/core/vm/vm_util.h"
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/vm/virtual_machine.msg.h"
+#include "oneflow/core/vm/vm_desc.msg.h"
+#include "oneflow/core/vm/test_util.h"
+#include "oneflow/core/vm/phy_instr_operand.h"
+#include "oneflow/core/common/cached_object_msg_allocator.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace test {
+
+namespace {
+
+class CountingObjectMsgAllocator final : public ObjectMsgAllocator {
+ public:
+  CountingObjectMsgAllocator() : allocate_cnt_(0) {}
+  ~CountingObjectMsgAllocator() override = default;
+
+  char* Allocate(std::size_t size) override {
+    ++allocate_cnt_;
+    return ObjectMsgDefaultAllocator::GlobalObjectMsgAllocator()->Allocate(size);
+  }
+  void Deallocate(char* ptr, std::size_t size) override {
+    ObjectMsgDefaultAllocator::GlobalObjectMsgAllocator()->Deallocate(ptr, size);
+  }
+
+  int64_t allocate_cnt() const { return allocate_cnt_; }
+
+ private:
+  int64_t allocate_cnt_;
+};
+
+void RunNopInstructions(VirtualMachine* vm, ObjectMsgAllocator* allocator, int64_t object_id,
+                        int64_t instr_num) {
+  const InstrTypeId& nop_instr_type_id = LookupInstrTypeId("Nop");
+  InstructionMsgList list;
+  for (int64_t i = 0; i < instr_num; ++i) {
+    auto nop_instr_msg = ObjectMsgPtr<InstructionMsg>::NewFrom(allocator, nop_instr_type_id);
+    nop_instr_msg->add_mut_operand(object_id);
+    list.EmplaceBack(std::move(nop_instr_msg));
+  }
+  vm->Receive(&list);
+  while (!vm->Empty()) {
+    vm->Schedule();
+    OBJECT_MSG_LIST_FOR_EACH_PTR(vm->mut_thread_ctx_list(), t) { t->TryReceiveAndRun(); }
+  }
+}
+
+TEST(InstructionPipeline, no_backend_allocation_after_warmup) {
+  Global<NumProcessPerNode>::New();
+  Global<NumProcessPerNode>::Get()->set_value(1);
+  {
+    TestResourceDescScope scope(1, 1);
+    CountingObjectMsgAllocator backend_allocator;
+    CachedObjectMsgAllocator allocator(&backend_allocator, 16, 32);
+    auto vm_desc = ObjectMsgPtr<VmDesc>::New(TestUtil::NewVmResourceDesc().Get());
+    TestUtil::AddStreamDescByInstrNames(vm_desc.Mutable(), {"Nop", "NewObject"});
+    auto vm = ObjectMsgPtr<VirtualMachine>::NewFrom(&allocator, vm_desc.Get());
+    InstructionMsgList list;
+    int64_t object_id = TestUtil::NewObject(&list, "cpu", "0:0");
+    vm->Receive(&list);
+    const int64_t kInstrNumPerRound = 16;
+    for (int i = 0; i < 8; ++i) {
+      RunNopInstructions(vm.Mutable(), &allocator, object_id, kInstrNumPerRound);
+    }
+    int64_t warmup_allocate_cnt = backend_allocator.allocate_cnt();
+    const int64_t kRoundNum = 10000;
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < kRoundNum; ++i) {
+      RunNopInstructions(vm.Mutable(), &allocator, object_id, kInstrNumPerRound);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_EQ(backend_allocator.allocate_cnt(), warmup_allocate_cnt);
+    LOG(INFO) << "nop instructions per second: "
+              << kRoundNum * kInstrNumPerRound / elapsed.count();
+  }
+  Global<NumProcessPerNode>::Delete();
+}
+
+// Stands for the tensors and callbacks released with an instruction, costing `release_us`.
+class ReleaseCostPhyInstrOperand final : public PhyInstrOperand {
+ public:
+  ReleaseCostPhyInstrOperand(int64_t release_us, std::atomic<int64_t>* release_cnt)
+      : release_us_(release_us), release_cnt_(release_cnt) {}
+  ~ReleaseCostPhyInstrOperand() override {
+    auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(release_us_);
+    while (std::chrono::steady_clock::now() < end) {}
+    ++*release_cnt_;
+  }
+
+  void ForEachConstMirroredObject(
+      const std::function<void(MirroredObject* infer, MirroredObject* compute)>&) const override {}
+  void ForEachMutMirroredObject(
+      const std::function<void(MirroredObject* infer, MirroredObject* compute)>&) const override {}
+  void ForEachMut2MirroredObject(
+      const std::function<void(MirroredObject* infer, MirroredObject* compute)>&) const override {}
+
+ private:
+  int64_t release_us_;
+  std::atomic<int64_t>* release_cnt_;
+};
+
+double RunReleaseCostInstructions(bool offload_release) {
+  const int64_t kInstrNum = 20000;
+  const int64_t kReleaseUs = 2;
+  std::atomic<int64_t> release_cnt(0);
+  ReleasedInstrMsgList released_instr_msg_list;
+  std::thread release_thread;
+  std::chrono::duration<double> elapsed;
+  {
+    auto vm_desc = ObjectMsgPtr<VmDesc>::New(TestUtil::NewVmResourceDesc().Get());
+    TestUtil::AddStreamDescByInstrNames(vm_desc.Mutable(), {"Nop"});
+    auto vm = ObjectMsgPtr<VirtualMachine>::New(vm_desc.Get());
+    if (offload_release) {
+      vm->set_released_instr_msg_list(&released_instr_msg_list);
+      release_thread = std::thread([&]() {
+        InstructionMsgList tmp_list;
+        while (released_instr_msg_list.MoveTo(&tmp_list) == kObjectMsgConditionListStatusSuccess) {
+          tmp_list.Clear();
+        }
+      });
+    }
+    const InstrTypeId& nop_instr_type_id = LookupInstrTypeId("Nop");
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < kInstrNum; ++i) {
+      auto nop_instr_msg = NewInstruction(nop_instr_type_id);
+      *nop_instr_msg->mutable_phy_instr_operand() =
+          std::make_shared<ReleaseCostPhyInstrOperand>(kReleaseUs, &release_cnt);
+      vm->Receive(std::move(nop_instr_msg));
+      vm->Schedule();
+    }
+    while (!vm->Empty()) { vm->Schedule(); }
+    elapsed = std::chrono::steady_clock::now() - start;
+  }
+  if (offload_release) {
+    released_instr_msg_list.Close();
+    release_thread.join();
+  }
+  CHECK_EQ(release_cnt, kInstrNum);
+  return kInstrNum / elapsed.count();
+}
+
+TEST(InstructionPipeline, release_offloading) {
+  Global<NumProcessPerNode>::New();
+  Global<NumProcessPerNode>::Get()->set_value(1);
+  {
+    TestResourceDescScope scope(1, 1);
+    double inline_rate = RunReleaseCostInstructions(false);
+    double offloaded_rate = RunReleaseCostInstructions(true);
+    LOG(INFO) << "scheduled instructions per second, released by the scheduler: " << inline_rate
+              << ", by a release thread: " << offloaded_rate;
+  }
+  Global<NumProcessPerNode>::Delete();
+}
+
+}  // namespace
+
+}  // namespace test
+
+}  // namespace vm
+}  // namespace oneflow
@@ -58,7 +58,9 @@ void RegisterInstrTypeId(const std::string& instruction_name, const StreamType*
                          const InstructionType* instruction_type, InterpretType interpret_type) {
   InstrTypeId instr_type_id;
   instr_type_id.__Init__(stream_type, instruction_type, interpret_type);
-  CHECK(InstrTypeId4InstructionName()->emplace(instruction_name, instr_type_id).second);
+  const auto& pair = InstrTypeId4InstructionName()->emplace(instruction_name, instr_type_id);
+  CHECK(pair.second);
+  pair.first->second.set_instr_type_name(&pair.first->first);
 }
 
 }  // namespace vm
@@ -24,7 +24,9 @@ limitations under the License.
 namespace oneflow {
 
 OneflowVM::OneflowVM(const Resource& resource, int64_t this_machine_id)
-    : vm_(ObjectMsgPtr<vm::VirtualMachine>::New(vm::MakeVmDesc(resource, this_machine_id).Get())) {
+    : vm_(ObjectMsgPtr<vm::VirtualMachine>::NewFrom(
+        vm::SchedulerObjectAllocator(), vm::MakeVmDesc(resource, this_machine_id).Get())) {
+  vm_->set_released_instr_msg_list(&released_instr_msg_list_);
   OBJECT_MSG_LIST_UNSAFE_FOR_EACH_PTR(vm_->mut_thread_ctx_list(), thread_ctx) {
     auto thread = std::make_unique<std::thread>(&vm::ThreadCtx::LoopRun, thread_ctx);
     worker_threads_.push_back(std::move(thread));
@@ -32,6 +34,7 @@ OneflowVM::OneflowVM(const Resource& resource, int64_t this_machine_id)
   exiting_ = false;
   scheduler_exited_ = false;
   schedule_thread_ = std::thread(&OneflowVM::Loop, this);
+  release_thread_ = std::thread(&OneflowVM::ReleaseLoop, this);
 }
 
 namespace {
@@ -64,6 +67,8 @@ OneflowVM::~OneflowVM() {
   for (const auto& worker_thread : worker_threads_) { worker_thread->join(); }
   schedule_thread_.join();
   CHECK(scheduler_exited_);
+  released_instr_msg_list_.Close();
+  release_thread_.join();
   CHECK(mut_vm()->Empty());
 }
 
@@ -73,4 +78,11 @@ void OneflowVM::Loop() {
   scheduler_exited_ = true;
 }
 
+void OneflowVM::ReleaseLoop() {
+  OBJECT_MSG_LIST(vm::InstructionMsg, instr_msg_link) tmp_list;
+  while (released_instr_msg_list_.MoveTo(&tmp_list) == kObjectMsgConditionListStatusSuccess) {
+    tmp_list.Clear();
+  }
+}
+
 }  // namespace oneflow
@@ -35,11 +35,15 @@ class OneflowVM final {
 
  private:
   void Loop();
+  void ReleaseLoop();
 
+  // declared before vm_, which refers to it until destructed
+  vm::ReleasedInstrMsgList released_instr_msg_list_;
   ObjectMsgPtr<vm::VirtualMachine> vm_;
   // for asynchronized execution
   std::list<std::unique_ptr<std::thread>> worker_threads_;
   std::thread schedule_thread_;
+  std::thread release_thread_;
   std::atomic<bool> exiting_;
   std::atomic<bool> scheduler_exited_;
 };
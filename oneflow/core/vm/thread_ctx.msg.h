@@ -35,7 +35,8 @@ OBJECT_MSG_BEGIN(ThreadCtx);
   // links
   OBJECT_MSG_DEFINE_LIST_LINK(thread_ctx_link);
   OBJECT_MSG_DEFINE_LIST_HEAD(Stream, thread_ctx_stream_link, stream_list);
-  OBJECT_MSG_DEFINE_CONDITION_LIST_HEAD(Instruction, pending_instruction_link,
+  // the scheduler is the only producer and this thread the only consumer
+  OBJECT_MSG_DEFINE_LOCK_FREE_LIST_HEAD(Instruction, pending_instruction_link,
                                         pending_instruction_list);
 
   OF_PRIVATE ObjectMsgConditionListStatus ReceiveAndRun();
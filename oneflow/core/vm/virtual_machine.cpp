@@ -64,9 +64,20 @@ void VirtualMachine::ReleaseInstruction(Instruction* instruction,
   TryMoveWaitingToReady(instruction, ready_instruction_list, [](Instruction*) { return true; });
 }
 
+void VirtualMachine::TryMoveInstrMsgToReleasedList(
+    Instruction* instruction, /*out*/ TmpReleasedInstrMsgList* released_instr_msg_list) {
+  // a worker is still holding `instruction`, Stream::DeleteInstruction keeps it as a zombie
+  if (instruction->ref_cnt() > 1) { return; }
+  ObjectMsgPtr<InstructionMsg> instr_msg = instruction->mut_instr_msg();
+  instruction->clear_instr_msg();
+  // only the last reference is worth handing over, the others are dropped by their holders
+  if (instr_msg->ref_cnt() == 1) { released_instr_msg_list->EmplaceBack(std::move(instr_msg)); }
+}
+
 void VirtualMachine::TryReleaseFinishedInstructions(
     Stream* stream,
-    /*out*/ ReadyInstructionList* ready_instruction_list) {
+    /*out*/ ReadyInstructionList* ready_instruction_list,
+    /*out*/ TmpReleasedInstrMsgList* released_instr_msg_list) {
   auto* running_instruction_list = stream->mut_running_instruction_list();
   auto* front_seq_compute_list = mutable_front_seq_compute_instr_list();
   auto* vm_stat_running_list = mut_vm_stat_running_instruction_list();
@@ -84,7 +95,11 @@ void VirtualMachine::TryReleaseFinishedInstructions(
       UNIMPLEMENTED();
     }
     vm_stat_running_list->Erase(instruction_ptr);
-    stream->DeleteInstruction(running_instruction_list->Erase(instruction_ptr));
+    ObjectMsgPtr<Instruction> instruction = running_instruction_list->Erase(instruction_ptr);
+    if (has_released_instr_msg_list()) {
+      TryMoveInstrMsgToReleasedList(instruction.Mutable(), released_instr_msg_list);
+    }
+    stream->DeleteInstruction(std::move(instruction));
   }
 }
 
@@ -638,10 +653,15 @@ void VirtualMachine::TryDeleteLogicalObjects() {
 void VirtualMachine::Schedule() {
   ReadyInstructionList* ready_instruction_list = mut_ready_instruction_list();
   auto* active_stream_list = mut_active_stream_list();
+  TmpReleasedInstrMsgList released_instr_msg_list;
   OBJECT_MSG_LIST_FOR_EACH_PTR(active_stream_list, stream) {
-    TryReleaseFinishedInstructions(stream, /*out*/ ready_instruction_list);
+    TryReleaseFinishedInstructions(stream, /*out*/ ready_instruction_list,
+                                   /*out*/ &released_instr_msg_list);
     if (stream->running_instruction_list().empty()) { active_stream_list->Erase(stream); }
   }
+  if (!released_instr_msg_list.empty()) {
+    mut_released_instr_msg_list()->MoveFrom(&released_instr_msg_list);
+  }
   TryDeleteLogicalObjects();
   TryRunFrontSeqInstruction(/*out*/ ready_instruction_list);
   auto* waiting_instruction_list = mut_waiting_instruction_list();
@@ -33,6 +33,9 @@ namespace oneflow {
 namespace vm {
 
 class VmDesc;
+
+using ReleasedInstrMsgList = OBJECT_MSG_LOCK_FREE_LIST(InstructionMsg, instr_msg_link);
+
 // clang-format off
 OBJECT_MSG_BEGIN(VirtualMachine);
   // methods
@@ -56,6 +59,9 @@ OBJECT_MSG_BEGIN(VirtualMachine);
   OBJECT_MSG_DEFINE_OPTIONAL(VmResourceDesc, vm_resource_desc);
   OBJECT_MSG_DEFINE_STRUCT(Range, machine_id_range);
   OBJECT_MSG_DEFINE_PTR(ObjectMsgAllocator, vm_thread_only_allocator);
+  // when set, the messages of the finished instructions are handed to this list so that they and
+  // their phy_instr_operand are destructed by the thread consuming it instead of the scheduler
+  OBJECT_MSG_DEFINE_PTR(ReleasedInstrMsgList, released_instr_msg_list);
 
   // heads
   OBJECT_MSG_DEFINE_LIST_HEAD(Stream, active_stream_link, active_stream_list);
@@ -74,6 +80,7 @@ OBJECT_MSG_BEGIN(VirtualMachine);
   // methods
  private:
   using TmpPendingInstrMsgList = OBJECT_MSG_LIST(InstructionMsg, instr_msg_link);
+  using TmpReleasedInstrMsgList = OBJECT_MSG_LIST(InstructionMsg, instr_msg_link);
   using NewInstructionList = OBJECT_MSG_LIST(Instruction, instruction_link);
   using PrescheduledInstructionList = OBJECT_MSG_LIST(Instruction, instruction_link);
   using WaitingInstructionList = VirtualMachine::waiting_instruction_list_ObjectMsgListType;
@@ -88,7 +95,10 @@ OBJECT_MSG_BEGIN(VirtualMachine);
   void ReleaseInstruction(Instruction* instruction,
                             /*out*/ ReadyInstructionList* ready_instruction_list);
   void TryReleaseFinishedInstructions(
-          Stream* stream, /*out*/ ReadyInstructionList* ready_instruction_list);
+          Stream* stream, /*out*/ ReadyInstructionList* ready_instruction_list,
+          /*out*/ TmpReleasedInstrMsgList* released_instr_msg_list);
+  void TryMoveInstrMsgToReleasedList(Instruction* instruction,
+                                     /*out*/ TmpReleasedInstrMsgList* released_instr_msg_list);
   void FilterAndRunInstructionsInAdvance(TmpPendingInstrMsgList* instr_msg_list);
   void MakeInstructions(TmpPendingInstrMsgList*, /*out*/ NewInstructionList* ret_instruction_list);
   template<int64_t (*TransformLogicalObjectId)(int64_t), typename DoEachT>
@@ -16,6 +16,7 @@ limitations under the License.
 #include "oneflow/core/common/blocking_counter.h"
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/common/protobuf.h"
+#include "oneflow/core/common/cached_object_msg_allocator.h"
 #include "oneflow/core/job/cluster_instruction.h"
 #include "oneflow/core/vm/vm_util.h"
 #include "oneflow/core/vm/oneflow_vm.h"
@@ -30,8 +31,22 @@ limitations under the License.
 namespace oneflow {
 namespace vm {
 
+ObjectMsgAllocator* InstructionMsgAllocator() {
+  static ObjectMsgAllocator* allocator = new CachedObjectMsgAllocator(16, 32);
+  return allocator;
+}
+
+ObjectMsgAllocator* SchedulerObjectAllocator() {
+  static ObjectMsgAllocator* allocator = new CachedObjectMsgAllocator(16, 32);
+  return allocator;
+}
+
 ObjectMsgPtr<InstructionMsg> NewInstruction(const std::string& instr_type_name) {
-  return ObjectMsgPtr<InstructionMsg>::New(instr_type_name);
+  return NewInstruction(LookupInstrTypeId(instr_type_name));
+}
+
+ObjectMsgPtr<InstructionMsg> NewInstruction(const InstrTypeId& instr_type_id) {
+  return ObjectMsgPtr<InstructionMsg>::NewFrom(InstructionMsgAllocator(), instr_type_id);
 }
 
 Maybe<void> Run(vm::InstructionMsgList* instr_msg_list) {
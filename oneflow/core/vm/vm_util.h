@@ -24,8 +24,17 @@ namespace oneflow {
 namespace vm {
 
 class InstructionMsg;
+class InstrTypeId;
+
+// Process-wide pools that are never destroyed, so the messages and the scheduler objects can be
+// released from any thread at any time, the exit included. InstructionMsgAllocator backs
+// NewInstruction, SchedulerObjectAllocator backs the VirtualMachine of OneflowVM and so its
+// streams, instructions and edges.
+ObjectMsgAllocator* InstructionMsgAllocator();
+ObjectMsgAllocator* SchedulerObjectAllocator();
 
 ObjectMsgPtr<InstructionMsg> NewInstruction(const std::string& instr_type_name);
+ObjectMsgPtr<InstructionMsg> NewInstruction(const InstrTypeId& instr_type_id);
 
 Maybe<void> Run(vm::InstructionMsgList* instr_msg_list);
 Maybe<void> SingleClientSync();
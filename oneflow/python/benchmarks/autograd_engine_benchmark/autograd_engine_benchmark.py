@@ -0,0 +1,118 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Compares the backward pass of an eager multi-branch model run by the graph autograd
+# engine and by the stack one:
+#
+#   python3 autograd_engine_benchmark.py --device cuda --num_branches 8 --depth 16
+#
+# Each engine runs in its own process since the engine is picked once per process from
+# the environment variable ONEFLOW_AUTOGRAD_ENGINE. The graph engine only visits the
+# nodes reachable from the loss and frees the tensors saved by a node as soon as it has
+# run, while the stack one walks every node recorded by the thread and frees them at the
+# end.
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+import numpy as np
+
+parser = argparse.ArgumentParser(description="eager autograd engine benchmark")
+parser.add_argument("--device", type=str, default="cpu")
+parser.add_argument("--batch_size", type=int, default=64)
+parser.add_argument("--hidden_size", type=int, default=256)
+parser.add_argument("--num_branches", type=int, default=8)
+parser.add_argument("--depth", type=int, default=16)
+parser.add_argument("--iters", type=int, default=20)
+parser.add_argument("--warmup_iters", type=int, default=3)
+parser.add_argument(
+    "--engine", type=str, default="", help="internal, the engine of a single run"
+)
+args = parser.parse_args()
+
+
+def run_engine():
+    import oneflow.experimental as flow
+
+    flow.enable_eager_execution()
+    device = flow.device(args.device)
+    x = flow.Tensor(
+        np.random.rand(args.batch_size, args.hidden_size),
+        dtype=flow.float32,
+        device=device,
+        requires_grad=True,
+    )
+    weights = [
+        flow.Tensor(
+            np.random.uniform(-0.05, 0.05, (args.hidden_size, args.hidden_size)),
+            dtype=flow.float32,
+            device=device,
+            requires_grad=True,
+        )
+        for _ in range(args.num_branches)
+    ]
+
+    def forward():
+        # the branches share their input and are summed, so the gradient of the trunk is
+        # accumulated from all of them before its node runs
+        trunk = x
+        for _ in range(args.depth):
+            outs = [flow.matmul(trunk, w).relu() for w in weights]
+            trunk = outs[0]
+            for out in outs[1:]:
+                trunk = trunk + out
+        return trunk.sum()
+
+    def step():
+        loss = forward()
+        start = time.perf_counter()
+        loss.backward()
+        x.grad.numpy()
+        return time.perf_counter() - start
+
+    for _ in range(args.warmup_iters):
+        step()
+    cost = sum(step() for _ in range(args.iters)) / args.iters
+    print("{} {:.6f}".format(args.engine, cost))
+
+
+def launch(engine):
+    env = dict(os.environ, ONEFLOW_AUTOGRAD_ENGINE=engine)
+    cmd = [sys.executable, os.path.abspath(__file__), "--engine", engine]
+    for key in ("device", "batch_size", "hidden_size", "num_branches", "depth"):
+        cmd += ["--" + key, str(getattr(args, key))]
+    cmd += ["--iters", str(args.iters), "--warmup_iters", str(args.warmup_iters)]
+    out = subprocess.check_output(cmd, env=env).decode()
+    return float(out.strip().splitlines()[-1].split()[1])
+
+
+if __name__ == "__main__":
+    if args.engine:
+        run_engine()
+    else:
+        stack_cost = launch("stack")
+        graph_cost = launch("graph")
+        print(
+            "branches {} depth {} on {}".format(
+                args.num_branches, args.depth, args.device
+            )
+        )
+        print("stack engine backward: {:.3f} ms".format(stack_cost * 1e3))
+        print("graph engine backward: {:.3f} ms".format(graph_cost * 1e3))
+        print("speedup: {:.2f}x".format(stack_cost / graph_cost))
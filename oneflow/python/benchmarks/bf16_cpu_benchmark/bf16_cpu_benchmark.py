@@ -0,0 +1,130 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Compares the cpu training of a multilayer perceptron in float and with the cpu auto mixed
+# precision, which runs the matmuls and the elementwise ops in bfloat16 and keeps the variables
+# in float:
+#
+#   python3 bf16_cpu_benchmark.py --batch_size 256 --hidden_size 1024 --num_layers 4
+#
+# The traffic is the bytes of the weights and the activations read by the forward pass, which
+# bfloat16 halves. The loss gap is the largest relative difference of the losses of the two jobs
+# trained from the same initial variables on the same batches.
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import sys
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from timing_util import BenchmarkTimer  # noqa: E402
+
+parser = argparse.ArgumentParser(description="bfloat16 cpu training benchmark")
+parser.add_argument("--batch_size", type=int, default=256)
+parser.add_argument("--hidden_size", type=int, default=1024)
+parser.add_argument("--num_layers", type=int, default=4)
+parser.add_argument("--train_iters", type=int, default=10)
+parser.add_argument("--iters", type=int, default=20)
+parser.add_argument("--warmup_iters", type=int, default=3)
+args = parser.parse_args()
+timer = BenchmarkTimer(args.iters, args.warmup_iters)
+
+INPUT_SHAPE = (args.batch_size, args.hidden_size)
+
+
+def mlp(x, prefix):
+    y = x
+    for i in range(args.num_layers):
+        y = flow.layers.dense(
+            y,
+            args.hidden_size,
+            activation=flow.nn.relu,
+            kernel_initializer=flow.random_uniform_initializer(-0.05, 0.05),
+            name="{}-fc{}".format(prefix, i),
+        )
+    return flow.math.reduce_mean(y)
+
+
+def make_train_job(name, enable_bf16):
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.enable_cpu_auto_mixed_precision(enable_bf16)
+
+    @flow.global_function(type="train", function_config=func_config)
+    def train_job(x: tp.Numpy.Placeholder(INPUT_SHAPE)) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            loss = mlp(x, name)
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [1e-3]), momentum=0
+            ).minimize(loss)
+        return loss
+
+    return train_job
+
+
+float_job = make_train_job("float", False)
+bf16_job = make_train_job("bf16", True)
+
+
+def forward_traffic(bytes_per_element):
+    weights = args.num_layers * (args.hidden_size + 1) * args.hidden_size
+    activations = (args.num_layers + 1) * args.batch_size * args.hidden_size
+    return (weights + activations) * bytes_per_element
+
+
+def main():
+    variables = flow.get_all_variables()
+    flow.load_variables(
+        {
+            name.replace("float-", "bf16-", 1): blob.numpy()
+            for name, blob in variables.items()
+            if name.startswith("float-")
+        }
+    )
+    rng = np.random.RandomState(0)
+    loss_gap = 0.0
+    for _ in range(args.train_iters):
+        x = rng.rand(*INPUT_SHAPE).astype(np.float32)
+        float_loss = float_job(x)
+        bf16_loss = bf16_job(x)
+        loss_gap = max(loss_gap, abs(bf16_loss - float_loss) / abs(float_loss))
+    x = rng.rand(*INPUT_SHAPE).astype(np.float32)
+    float_time = timer.time_fn(float_job, x)
+    bf16_time = timer.time_fn(bf16_job, x)
+    print("max relative loss gap {:.4f}".format(float(loss_gap)))
+    print(
+        "forward traffic: float {:.1f} MB, bf16 {:.1f} MB".format(
+            forward_traffic(4) / 2 ** 20, forward_traffic(2) / 2 ** 20
+        )
+    )
+    print(
+        "batch {} hidden {} layers {}: float {:.2f} ms, bf16 {:.2f} ms, "
+        "speedup {:.2f}x".format(
+            args.batch_size,
+            args.hidden_size,
+            args.num_layers,
+            float_time * 1000,
+            bf16_time * 1000,
+            float_time / bf16_time,
+        )
+    )
+
+
+if __name__ == "__main__":
+    main()
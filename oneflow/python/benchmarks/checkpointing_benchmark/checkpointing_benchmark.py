@@ -0,0 +1,161 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Reports the peak memory versus recompute time trade-off of the automatic checkpointing
+# on a transformer encoder trained on one gpu:
+#
+#   python3 checkpointing_benchmark.py --budgets 0,2048,1024,512,256
+#
+# Every budget in MByte, 0 for no checkpointing, is trained in its own process. The
+# memory is the one used on the gpu once the job is compiled, which is allocated up
+# front, and the CheckpointingPass logs its own estimate of the kept activations.
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+import numpy as np
+
+parser = argparse.ArgumentParser(description="automatic checkpointing benchmark")
+parser.add_argument("--budgets", type=str, default="0,2048,1024,512,256")
+parser.add_argument("--batch_size", type=int, default=32)
+parser.add_argument("--seq_length", type=int, default=256)
+parser.add_argument("--hidden_size", type=int, default=768)
+parser.add_argument("--num_heads", type=int, default=12)
+parser.add_argument("--num_layers", type=int, default=12)
+parser.add_argument("--iters", type=int, default=20)
+parser.add_argument("--warmup_iters", type=int, default=3)
+parser.add_argument(
+    "--budget", type=int, default=-1, help="internal, the budget of a single run"
+)
+args = parser.parse_args()
+
+
+def gpu_memory_used_mbyte():
+    out = subprocess.check_output(
+        ["nvidia-smi", "--query-gpu=memory.used", "--format=csv,noheader,nounits"]
+    )
+    return int(out.decode().splitlines()[0])
+
+
+def run_budget():
+    import oneflow as flow
+    import oneflow.typing as tp
+
+    hidden = args.hidden_size
+    head_size = hidden // args.num_heads
+    tokens = args.batch_size * args.seq_length
+
+    def dense(x, units, name, activation=None):
+        return flow.layers.dense(
+            x,
+            units,
+            activation=activation,
+            kernel_initializer=flow.random_normal_initializer(stddev=0.02),
+            name=name,
+        )
+
+    def to_heads(x):
+        x = flow.reshape(
+            x, (args.batch_size, args.seq_length, args.num_heads, head_size)
+        )
+        return flow.transpose(x, perm=[0, 2, 1, 3])
+
+    def encoder_layer(x, name):
+        q = to_heads(dense(x, hidden, name + "-q"))
+        k = to_heads(dense(x, hidden, name + "-k"))
+        v = to_heads(dense(x, hidden, name + "-v"))
+        scores = flow.matmul(q, k, transpose_b=True, alpha=head_size ** -0.5)
+        context = flow.matmul(flow.nn.softmax(scores), v)
+        context = flow.transpose(context, perm=[0, 2, 1, 3])
+        context = flow.reshape(context, (tokens, hidden))
+        x = flow.layers.layer_norm(
+            x + dense(context, hidden, name + "-out"), name=name + "-ln0"
+        )
+        ffn = dense(x, hidden * 4, name + "-ffn0", activation=flow.math.gelu)
+        return flow.layers.layer_norm(
+            x + dense(ffn, hidden, name + "-ffn1"), name=name + "-ln1"
+        )
+
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    if args.budget > 0:
+        func_config.checkpointing_memory_budget_mbyte(args.budget)
+
+    @flow.global_function(type="train", function_config=func_config)
+    def train_job(x: tp.Numpy.Placeholder((tokens, hidden))) -> tp.Numpy:
+        with flow.scope.placement("gpu", "0:0"):
+            y = x
+            for i in range(args.num_layers):
+                y = encoder_layer(y, "layer{}".format(i))
+            loss = flow.math.reduce_mean(y * y)
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [1e-4]), momentum=0
+            ).minimize(loss)
+        return loss
+
+    x = np.random.rand(tokens, hidden).astype(np.float32)
+    for _ in range(args.warmup_iters):
+        train_job(x)
+    memory = gpu_memory_used_mbyte()
+    start = time.perf_counter()
+    for _ in range(args.iters):
+        train_job(x)
+    cost = (time.perf_counter() - start) / args.iters
+    print("{} {} {:.6f}".format(args.budget, memory, cost))
+
+
+def launch(budget):
+    cmd = [sys.executable, os.path.abspath(__file__), "--budget", str(budget)]
+    for key in (
+        "batch_size",
+        "seq_length",
+        "hidden_size",
+        "num_heads",
+        "num_layers",
+        "iters",
+        "warmup_iters",
+    ):
+        cmd += ["--" + key, str(getattr(args, key))]
+    out = subprocess.check_output(cmd).decode()
+    _, memory, cost = out.strip().splitlines()[-1].split()
+    return int(memory), float(cost)
+
+
+if __name__ == "__main__":
+    if args.budget >= 0:
+        run_budget()
+    else:
+        results = [(int(b), launch(int(b))) for b in args.budgets.split(",")]
+        base_memory, base_cost = results[0][1]
+        print(
+            "transformer: layers {} hidden {} batch {} seq {}".format(
+                args.num_layers, args.hidden_size, args.batch_size, args.seq_length
+            )
+        )
+        for budget, (memory, cost) in results:
+            print(
+                "budget {:>6}: gpu memory {:>6} MB ({:.2f}x), "
+                "step {:.2f} ms ({:.2f}x)".format(
+                    budget if budget > 0 else "none",
+                    memory,
+                    memory / base_memory,
+                    cost * 1000,
+                    cost / base_cost,
+                )
+            )
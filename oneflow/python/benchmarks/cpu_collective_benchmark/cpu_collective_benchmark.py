@@ -0,0 +1,104 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Compares the P->B boxing of a cpu blob with and without the cpu collective boxing backend,
+# one local process per rank:
+#
+#   ONEFLOW_TEST_MULTI_PROCESS=1 ONEFLOW_TEST_DEVICE_NUM=4 \
+#       python3 cpu_collective_benchmark.py --sizes_kb 4,64,1024,16384
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import sys
+import time
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+
+parser = argparse.ArgumentParser(description="cpu collective boxing benchmark")
+parser.add_argument("--sizes_kb", type=str, default="4,64,1024,16384")
+parser.add_argument("--iters", type=int, default=50)
+parser.add_argument("--warmup_iters", type=int, default=5)
+parser.add_argument("--chunk_size_kb", type=int, default=1024)
+parser.add_argument("--halving_doubling_threshold_kb", type=int, default=256)
+args, unittest_args = parser.parse_known_args()
+
+
+def run(num_ranks, size_kb, use_collective_boxing):
+    flow.clear_default_session()
+    flow.config.cpu_device_num(num_ranks)
+    flow.config.collective_boxing.cpu_enable_collective_boxing(use_collective_boxing)
+    flow.config.collective_boxing.cpu_chunk_size_kb(args.chunk_size_kb)
+    flow.config.collective_boxing.cpu_halving_doubling_threshold_kb(
+        args.halving_doubling_threshold_kb
+    )
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float32)
+    func_config.default_logical_view(flow.scope.consistent_view())
+    # a (m, k) x (k, n) matmul split along k leaves a partial sum of (m, n) on every rank
+    k = num_ranks
+    n = 256
+    m = max(size_kb * 1024 // 4 // n, 1)
+
+    @flow.global_function(function_config=func_config)
+    def all_reduce_job(
+        a: tp.Numpy.Placeholder((m, k)), b: tp.Numpy.Placeholder((k, n))
+    ) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0-{}".format(num_ranks - 1)):
+            a = flow.hierarchical_parallel_cast(a, parallel_distribution=["S(1)"])
+            b = flow.hierarchical_parallel_cast(b, parallel_distribution=["S(0)"])
+            out = flow.matmul(a, b)
+            out = flow.hierarchical_parallel_cast(out, parallel_distribution=["B"])
+            return flow.math.reduce_sum(out, axis=[0, 1])
+
+    a = np.random.rand(m, k).astype(np.float32)
+    b = np.random.rand(k, n).astype(np.float32)
+    result = all_reduce_job(a, b)
+    assert np.allclose(result, np.matmul(a, b).sum(), rtol=1e-3)
+    for _ in range(args.warmup_iters):
+        all_reduce_job(a, b)
+    start = time.perf_counter()
+    for _ in range(args.iters):
+        all_reduce_job(a, b)
+    return (time.perf_counter() - start) / args.iters
+
+
+@unittest.skipIf(
+    os.getenv("ONEFLOW_TEST_MULTI_PROCESS") != "1",
+    "set ONEFLOW_TEST_MULTI_PROCESS=1 to run one process per rank",
+)
+class CpuCollectiveBenchmark(flow.unittest.TestCase):
+    def test_all_reduce(test_case):
+        num_ranks = flow.unittest.env.device_num()
+        for size_kb in [int(s) for s in args.sizes_kb.split(",")]:
+            baseline = run(num_ranks, size_kb, False)
+            collective = run(num_ranks, size_kb, True)
+            print(
+                "ranks {} size {} KB: boxing {:.3f} ms, cpu collective boxing {:.3f} ms, "
+                "speedup {:.2f}x".format(
+                    num_ranks,
+                    size_kb,
+                    baseline * 1000,
+                    collective * 1000,
+                    baseline / collective,
+                )
+            )
+
+
+if __name__ == "__main__":
+    unittest.main(argv=[sys.argv[0]] + unittest_args)
@@ -0,0 +1,141 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Times flow.nn.conv2d placed on the cpu for the 1x1, 3x3 and depthwise convs of a
+# ResNet / MobileNet style network:
+#
+#   python3 cpu_conv_benchmark.py --batch_size 8
+#
+# The algorithms are picked by the shape heuristic, or timed once per shape with
+# --autotune. The grouped convs are also timed split into one conv per group, which is
+# how they ran before the direct kernel.
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import sys
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from timing_util import BenchmarkTimer  # noqa: E402
+
+parser = argparse.ArgumentParser(description="cpu conv benchmark")
+parser.add_argument("--batch_size", type=int, default=8)
+parser.add_argument("--iters", type=int, default=20)
+parser.add_argument("--warmup_iters", type=int, default=3)
+parser.add_argument("--compute_thread_pool_size", type=int, default=0)
+parser.add_argument("--autotune", action="store_true")
+args = parser.parse_args()
+timer = BenchmarkTimer(args.iters, args.warmup_iters)
+
+# (name, in channels, size, out channels, kernel size, stride, groups)
+CONFIGS = [
+    ("1x1 256->64", 256, 56, 64, 1, 1, 1),
+    ("1x1 512->2048", 512, 7, 2048, 1, 1, 1),
+    ("3x3 64->64", 64, 56, 64, 3, 1, 1),
+    ("3x3 256->256", 256, 14, 256, 3, 1, 1),
+    ("3x3 s2 128->128", 128, 28, 128, 3, 2, 1),
+    ("dw3x3 144", 144, 56, 144, 3, 1, 144),
+    ("dw3x3 s2 384", 384, 14, 384, 3, 2, 384),
+]
+
+
+def split(x, axis, split_num):
+    split_len = x.shape[axis] // split_num
+    slice_begin = [0] * len(x.shape)
+    slice_size = [-1] * len(x.shape)
+    slice_size[axis] = split_len
+    result_list = []
+    for i in range(split_num):
+        slice_begin[axis] = i * split_len
+        result_list.append(flow.slice(x, slice_begin, slice_size))
+    return result_list
+
+
+def make_job(config, split_groups):
+    name, ci, size, co, kernel_size, stride, groups = config
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0"))
+    func_config.cpu_conv_heuristic_search_algo(not args.autotune)
+
+    def conv_job(
+        x: tp.Numpy.Placeholder((args.batch_size, ci, size, size)),
+        w: tp.Numpy.Placeholder((co, ci // groups, kernel_size, kernel_size)),
+    ) -> tp.Numpy:
+        if not split_groups:
+            return flow.nn.conv2d(
+                x, w, strides=stride, padding="SAME", data_format="NCHW", groups=groups
+            )
+        xs = split(x, 1, groups)
+        ws = split(w, 0, groups)
+        return flow.concat(
+            [
+                flow.nn.conv2d(
+                    xi, wi, strides=stride, padding="SAME", data_format="NCHW"
+                )
+                for xi, wi in zip(xs, ws)
+            ],
+            axis=1,
+        )
+
+    conv_job.__name__ += "_{}_{}".format(
+        name.replace(" ", "_").replace(">", ""), split_groups
+    )
+    return flow.global_function(type="predict", function_config=func_config)(conv_job)
+
+
+def gflops(config, cost):
+    _, ci, size, co, kernel_size, stride, groups = config
+    out_size = (size + stride - 1) // stride
+    flops = 2 * args.batch_size * co * out_size * out_size * ci // groups
+    return flops * kernel_size * kernel_size / cost / 1e9
+
+
+if __name__ == "__main__":
+    if args.compute_thread_pool_size > 0:
+        flow.config.compute_thread_pool_size(args.compute_thread_pool_size)
+    jobs = [
+        (
+            make_job(config, False),
+            make_job(config, True) if config[-1] > 1 else None,
+        )
+        for config in CONFIGS
+    ]
+    print(
+        "cpu conv2d NCHW: batch {}, {}".format(
+            args.batch_size, "autotune" if args.autotune else "heuristic"
+        )
+    )
+    for config, (conv_job, split_job) in zip(CONFIGS, jobs):
+        _, ci, size, co, kernel_size, _, groups = config
+        x = np.random.uniform(-1, 1, (args.batch_size, ci, size, size))
+        w = np.random.uniform(-1, 1, (co, ci // groups, kernel_size, kernel_size))
+        inputs = (x.astype(np.float32), w.astype(np.float32))
+        conv_cost = timer.time_fn(conv_job, *inputs)
+        line = "{:>16}: {:.2f} ms, {:.1f} GFLOP/s".format(
+            config[0], conv_cost * 1000, gflops(config, conv_cost)
+        )
+        if split_job is not None:
+            y = conv_job(*inputs)
+            assert np.allclose(y, split_job(*inputs), rtol=1e-3, atol=1e-3)
+            split_cost = timer.time_fn(split_job, *inputs)
+            line += ", split groups {:.2f} ms, {:.2f}x".format(
+                split_cost * 1000, split_cost / conv_cost
+            )
+        print(line)
@@ -0,0 +1,109 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Times a train step of a sparse embedding placed on the cpu, looked up with
+# flow.layers.hash_embedding against a dense variable of the whole vocabulary with
+# flow.gather and the sgd update of the variable:
+#
+#   python3 cpu_embedding_benchmark.py --batch_size 4096 --bag_size 8
+#
+# The ids are drawn from a zipf distribution over --vocab_size ids, the dense variable
+# has a row for each of them while the hash table only keeps the ids seen.
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import sys
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from timing_util import BenchmarkTimer  # noqa: E402
+
+parser = argparse.ArgumentParser(description="cpu embedding benchmark")
+parser.add_argument("--batch_size", type=int, default=4096)
+parser.add_argument("--bag_size", type=int, default=8)
+parser.add_argument("--embedding_dim", type=int, default=64)
+parser.add_argument("--vocab_size", type=int, default=1000000)
+parser.add_argument("--zipf_a", type=float, default=1.2)
+parser.add_argument("--iters", type=int, default=20)
+parser.add_argument("--warmup_iters", type=int, default=3)
+parser.add_argument("--compute_thread_pool_size", type=int, default=0)
+args = parser.parse_args()
+timer = BenchmarkTimer(args.iters, args.warmup_iters, sync=True)
+
+ids_shape = (args.batch_size, args.bag_size)
+
+
+def make_job(use_hash_embedding):
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0"))
+
+    def embedding_job(
+        ids: tp.Numpy.Placeholder(ids_shape, dtype=flow.int64)
+    ) -> tp.Numpy:
+        if use_hash_embedding:
+            embeddings = flow.layers.hash_embedding(
+                ids, args.embedding_dim, combiner="mean", learning_rate=0.1
+            )
+        else:
+            table = flow.get_variable(
+                name="DenseEmbedding",
+                shape=(args.vocab_size, args.embedding_dim),
+                dtype=flow.float32,
+                initializer=flow.random_uniform_initializer(-0.05, 0.05),
+            )
+            embeddings = flow.math.reduce_mean(flow.gather(table, ids), axis=1)
+        loss = flow.math.reduce_mean(flow.math.square(embeddings))
+        flow.optimizer.SGD(
+            flow.optimizer.PiecewiseConstantScheduler([], [0.1]), momentum=0
+        ).minimize(loss)
+        return loss
+
+    embedding_job.__name__ += "_hash" if use_hash_embedding else "_dense"
+    return flow.global_function(type="train", function_config=func_config)(
+        embedding_job
+    )
+
+
+if __name__ == "__main__":
+    if args.compute_thread_pool_size > 0:
+        flow.config.compute_thread_pool_size(args.compute_thread_pool_size)
+    hash_job = make_job(True)
+    dense_job = make_job(False)
+    ids_list = [
+        (np.random.zipf(args.zipf_a, ids_shape) % args.vocab_size).astype(np.int64)
+        for _ in range(8)
+    ]
+    num_unique = len(np.unique(np.concatenate([ids.flatten() for ids in ids_list])))
+    print(
+        "cpu embedding train step: batch {}, bag {}, dim {}, vocab {}, {} ids".format(
+            args.batch_size,
+            args.bag_size,
+            args.embedding_dim,
+            args.vocab_size,
+            num_unique,
+        )
+    )
+    hash_cost = timer.time_fn_over_batches(hash_job, ids_list)
+    dense_cost = timer.time_fn_over_batches(dense_job, ids_list)
+    print(
+        "hash embedding {:.2f} ms, dense variable and gather {:.2f} ms, {:.2f}x".format(
+            hash_cost * 1000, dense_cost * 1000, dense_cost / hash_cost
+        )
+    )
@@ -0,0 +1,128 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Times flow.nn.max_pool2d, avg_pool2d, max_pool3d and max_pool1d placed on the cpu, in
+# both data formats, forward only and forward with backward:
+#
+#   python3 cpu_pool_benchmark.py --batch_size 16
+#
+# The train jobs also update a variable as large as the input, which the gradient of
+# the pool flows into. The output rows and the planes of the backward are spread over
+# the compute thread pool, its size is set by --compute_thread_pool_size.
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import sys
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from timing_util import BenchmarkTimer  # noqa: E402
+
+parser = argparse.ArgumentParser(description="cpu pool benchmark")
+parser.add_argument("--batch_size", type=int, default=16)
+parser.add_argument("--iters", type=int, default=10)
+parser.add_argument("--warmup_iters", type=int, default=2)
+parser.add_argument("--compute_thread_pool_size", type=int, default=0)
+args = parser.parse_args()
+timer = BenchmarkTimer(args.iters, args.warmup_iters)
+
+# (name, pool, channels, spatial size, channels_last, kernel size, stride)
+CONFIGS = [
+    ("resnet stem max 3x3 s2", "max_pool2d", 64, (112, 112), False, 3, 2),
+    ("resnet stem max 3x3 s2", "max_pool2d", 64, (112, 112), True, 3, 2),
+    ("vgg max 2x2 s2", "max_pool2d", 256, (56, 56), False, 2, 2),
+    ("vgg max 2x2 s2", "max_pool2d", 256, (56, 56), True, 2, 2),
+    ("inception avg 3x3 s1", "avg_pool2d", 192, (35, 35), False, 3, 1),
+    ("inception avg 3x3 s1", "avg_pool2d", 192, (35, 35), True, 3, 1),
+    ("video max 2x2x2 s2", "max_pool3d", 64, (16, 56, 56), False, 2, 2),
+    ("video max 2x2x2 s2", "max_pool3d", 64, (16, 56, 56), True, 2, 2),
+    ("audio max 4 s4", "max_pool1d", 128, (4096,), False, 4, 4),
+    ("audio max 4 s4", "max_pool1d", 128, (4096,), True, 4, 4),
+]
+
+DATA_FORMATS = {
+    (1, False): "NCW",
+    (1, True): "NWC",
+    (2, False): "NCHW",
+    (2, True): "NHWC",
+    (3, False): "NCDHW",
+    (3, True): "NDHWC",
+}
+
+
+def x_shape(config):
+    _, _, channels, size, channels_last, _, _ = config
+    if channels_last:
+        return (args.batch_size,) + size + (channels,)
+    return (args.batch_size, channels) + size
+
+
+def make_job(config, train):
+    name, pool, _, size, channels_last, kernel_size, stride = config
+    shape = x_shape(config)
+    name = "{}_{}".format(name.replace(" ", "_"), "nhwc" if channels_last else "nchw")
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0"))
+
+    def pool_job(x: tp.Numpy.Placeholder(shape)) -> tp.Numpy:
+        if train:
+            v = flow.get_variable(
+                "x_" + name,
+                shape=shape,
+                dtype=flow.float32,
+                initializer=flow.constant_initializer(0),
+                trainable=True,
+            )
+            x = x + v
+        y = getattr(flow.nn, pool)(
+            x,
+            ksize=kernel_size,
+            strides=stride,
+            padding="SAME",
+            data_format=DATA_FORMATS[(len(size), channels_last)],
+        )
+        if train:
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [1e-4]), momentum=0
+            ).minimize(y)
+        return y
+
+    pool_job.__name__ += "_{}_{}".format(name, train)
+    job_type = "train" if train else "predict"
+    return flow.global_function(type=job_type, function_config=func_config)(pool_job)
+
+
+if __name__ == "__main__":
+    if args.compute_thread_pool_size > 0:
+        flow.config.compute_thread_pool_size(args.compute_thread_pool_size)
+    jobs = [(make_job(config, False), make_job(config, True)) for config in CONFIGS]
+    print("cpu pool: batch {}".format(args.batch_size))
+    for config, (predict_job, train_job) in zip(CONFIGS, jobs):
+        x = np.random.uniform(-1, 1, x_shape(config)).astype(np.float32)
+        forward_cost = timer.time_fn(predict_job, x)
+        train_cost = timer.time_fn(train_job, x)
+        print(
+            "{:>24} {:>5}: forward {:.2f} ms, forward + backward {:.2f} ms".format(
+                config[0],
+                DATA_FORMATS[(len(config[3]), config[4])],
+                forward_cost * 1000,
+                train_cost * 1000,
+            )
+        )
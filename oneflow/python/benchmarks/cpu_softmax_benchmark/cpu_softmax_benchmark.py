@@ -0,0 +1,133 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Times the softmax, the sparse and the dense softmax cross entropy placed on the cpu
+# over rows of a large vocabulary, the inference and the training step:
+#
+#   python3 cpu_softmax_benchmark.py --batch_size 32 --num_classes 50257
+#   python3 cpu_softmax_benchmark.py --batch_size 8 --num_classes 250000
+#
+# The rows are spread over the compute thread pool, its size is set by
+# --compute_thread_pool_size.
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import sys
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from timing_util import BenchmarkTimer  # noqa: E402
+
+parser = argparse.ArgumentParser(description="cpu softmax benchmark")
+parser.add_argument("--batch_size", type=int, default=32)
+parser.add_argument("--num_classes", type=int, default=50257)
+parser.add_argument("--iters", type=int, default=20)
+parser.add_argument("--warmup_iters", type=int, default=3)
+parser.add_argument("--compute_thread_pool_size", type=int, default=0)
+args = parser.parse_args()
+timer = BenchmarkTimer(args.iters, args.warmup_iters)
+
+shape = (args.batch_size, args.num_classes)
+
+
+def logits_variable(name, x):
+    v = flow.get_variable(
+        name, shape=shape, dtype=flow.float, initializer=flow.zeros_initializer(),
+    )
+    return x + v
+
+
+def minimize(loss):
+    flow.optimizer.SGD(
+        flow.optimizer.PiecewiseConstantScheduler([], [1e-4]), momentum=0
+    ).minimize(loss)
+
+
+def make_jobs():
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0"))
+
+    @flow.global_function(type="predict", function_config=func_config)
+    def softmax_job(
+        x: tp.Numpy.Placeholder(shape),
+        sparse_label: tp.Numpy.Placeholder((args.batch_size,), dtype=flow.int32),
+        label: tp.Numpy.Placeholder(shape),
+    ) -> tp.Numpy:
+        return flow.nn.softmax(x)
+
+    @flow.global_function(type="train", function_config=func_config)
+    def softmax_train_job(
+        x: tp.Numpy.Placeholder(shape),
+        sparse_label: tp.Numpy.Placeholder((args.batch_size,), dtype=flow.int32),
+        label: tp.Numpy.Placeholder(shape),
+    ) -> tp.Numpy:
+        y = flow.nn.softmax(logits_variable("softmax-logits", x))
+        loss = flow.math.reduce_mean(y * label)
+        minimize(loss)
+        return loss
+
+    @flow.global_function(type="train", function_config=func_config)
+    def sparse_cross_entropy_job(
+        x: tp.Numpy.Placeholder(shape),
+        sparse_label: tp.Numpy.Placeholder((args.batch_size,), dtype=flow.int32),
+        label: tp.Numpy.Placeholder(shape),
+    ) -> tp.Numpy:
+        loss = flow.nn.sparse_softmax_cross_entropy_with_logits(
+            sparse_label, logits_variable("sparse-logits", x)
+        )
+        loss = flow.math.reduce_mean(loss)
+        minimize(loss)
+        return loss
+
+    @flow.global_function(type="train", function_config=func_config)
+    def cross_entropy_job(
+        x: tp.Numpy.Placeholder(shape),
+        sparse_label: tp.Numpy.Placeholder((args.batch_size,), dtype=flow.int32),
+        label: tp.Numpy.Placeholder(shape),
+    ) -> tp.Numpy:
+        loss = flow.nn.softmax_cross_entropy_with_logits(
+            label, logits_variable("dense-logits", x)
+        )
+        loss = flow.math.reduce_mean(loss)
+        minimize(loss)
+        return loss
+
+    return softmax_job, softmax_train_job, sparse_cross_entropy_job, cross_entropy_job
+
+
+if __name__ == "__main__":
+    if args.compute_thread_pool_size > 0:
+        flow.config.compute_thread_pool_size(args.compute_thread_pool_size)
+    jobs = make_jobs()
+    x = np.random.normal(0, 4, shape).astype(np.float32)
+    sparse_label = np.random.randint(0, args.num_classes, (args.batch_size,)).astype(
+        np.int32
+    )
+    label = np.zeros(shape, dtype=np.float32)
+    label[np.arange(args.batch_size), sparse_label] = 1
+    print("cpu softmax: batch {} classes {}".format(args.batch_size, args.num_classes))
+    names = ("softmax", "softmax fwd+bwd", "sparse cross entropy", "cross entropy")
+    for name, job in zip(names, jobs):
+        cost = timer.time_fn(job, x, sparse_label, label)
+        print(
+            "{:>22}: {:.2f} ms, {:.0f} rows/s".format(
+                name, cost * 1000, args.batch_size / cost
+            )
+        )
@@ -0,0 +1,116 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Times flow.sort, flow.argsort and flow.math.top_k placed on the cpu against numpy,
+# on narrow rows left to std::sort, wide rows radix sorted, and the top k of retrieval
+# scores selected by a heap:
+#
+#   python3 cpu_sort_benchmark.py --dtype float32
+#
+# Rows of 256 stay below the radix sort thresholds (2048 values for sort, 512 for
+# argsort), so the first configs time the comparison sort that the radix sort replaces
+# on the wider rows. Ties are common with --dtype int8 and uint8, which only hold 256
+# distinct values.
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import sys
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from timing_util import BenchmarkTimer  # noqa: E402
+
+parser = argparse.ArgumentParser(description="cpu sort benchmark")
+parser.add_argument("--dtype", type=str, default="float32")
+parser.add_argument("--iters", type=int, default=10)
+parser.add_argument("--warmup_iters", type=int, default=2)
+parser.add_argument("--compute_thread_pool_size", type=int, default=0)
+args = parser.parse_args()
+timer = BenchmarkTimer(args.iters, args.warmup_iters)
+
+# (op, rows, row size, k)
+CONFIGS = [
+    ("sort", 1024, 256, None),
+    ("sort", 64, 65536, None),
+    ("argsort", 1024, 256, None),
+    ("argsort", 64, 65536, None),
+    ("top_k", 64, 65536, 1000),
+    ("top_k", 16, 1 << 20, 10),
+    ("top_k", 16, 1 << 20, 100),
+]
+
+
+def make_job(config, dtype):
+    op, rows, size, k = config
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0"))
+
+    def sort_job(x: tp.Numpy.Placeholder((rows, size), dtype=dtype)) -> tp.Numpy:
+        if op == "sort":
+            return flow.sort(x, direction="DESCENDING")
+        if op == "argsort":
+            return flow.argsort(x, direction="DESCENDING")
+        return flow.math.top_k(x, k=k)
+
+    sort_job.__name__ += "_{}_{}_{}".format(op, rows, size)
+    return flow.global_function(type="predict", function_config=func_config)(sort_job)
+
+
+def numpy_fn(config):
+    op, _, _, k = config
+    if op == "sort":
+        return lambda x: -np.sort(-x, axis=-1)
+    if op == "argsort":
+        return lambda x: np.argsort(-x, axis=-1, kind="stable")
+
+    def top_k(x):
+        part = np.argpartition(-x, k - 1, axis=-1)[:, :k]
+        order = np.argsort(-np.take_along_axis(x, part, -1), axis=-1, kind="stable")
+        return np.take_along_axis(part, order, -1)
+
+    return top_k
+
+
+if __name__ == "__main__":
+    if args.compute_thread_pool_size > 0:
+        flow.config.compute_thread_pool_size(args.compute_thread_pool_size)
+    np_dtype = np.dtype(args.dtype)
+    flow_dtype = {
+        "float32": flow.float32,
+        "float64": flow.float64,
+        "int8": flow.int8,
+        "uint8": flow.uint8,
+        "int32": flow.int32,
+        "int64": flow.int64,
+    }[args.dtype]
+    jobs = [make_job(config, flow_dtype) for config in CONFIGS]
+    print("cpu sort: {}".format(args.dtype))
+    for config, job in zip(CONFIGS, jobs):
+        op, rows, size, k = config
+        low = 0 if np_dtype.kind == "u" else -100
+        x = (np.random.uniform(low, 100, (rows, size))).astype(np_dtype)
+        flow_cost = timer.time_fn(job, x)
+        numpy_cost = timer.time_fn(numpy_fn(config), x)
+        name = "{} {}x{}".format(op, rows, size) + ("" if k is None else " k " + str(k))
+        print(
+            "{:>24}: {:.2f} ms, numpy {:.2f} ms, {:.2f}x".format(
+                name, flow_cost * 1000, numpy_cost * 1000, numpy_cost / flow_cost
+            )
+        )
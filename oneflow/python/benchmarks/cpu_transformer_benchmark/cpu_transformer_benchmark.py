@@ -0,0 +1,189 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Times a stack of transformer encoder blocks placed on the cpu, the inference and the
+# training step, next to a job running only the layer norms of the same size:
+#
+#   python3 cpu_transformer_benchmark.py --batch_size 8 --seq_length 128
+#
+# --fused builds the blocks from fused_self_attention_query_mul_key_and_value and
+# fused_bias_add_gelu, --num_layers 12 times a BERT-base encoder.
+# The cpu kernels run in the compute thread pool, its size is set by
+# --compute_thread_pool_size.
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import sys
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from timing_util import BenchmarkTimer  # noqa: E402
+
+parser = argparse.ArgumentParser(description="cpu transformer block benchmark")
+parser.add_argument("--batch_size", type=int, default=8)
+parser.add_argument("--seq_length", type=int, default=128)
+parser.add_argument("--hidden_size", type=int, default=768)
+parser.add_argument("--num_heads", type=int, default=12)
+parser.add_argument("--num_layers", type=int, default=2)
+parser.add_argument("--iters", type=int, default=20)
+parser.add_argument("--warmup_iters", type=int, default=3)
+parser.add_argument("--compute_thread_pool_size", type=int, default=0)
+parser.add_argument("--fused", action="store_true")
+args = parser.parse_args()
+timer = BenchmarkTimer(args.iters, args.warmup_iters)
+
+hidden = args.hidden_size
+head_size = hidden // args.num_heads
+tokens = args.batch_size * args.seq_length
+
+
+def dense(x, units, name, activation=None):
+    return flow.layers.dense(
+        x,
+        units,
+        activation=activation,
+        kernel_initializer=flow.random_normal_initializer(stddev=0.02),
+        name=name,
+    )
+
+
+def to_heads(x):
+    x = flow.reshape(x, (args.batch_size, args.seq_length, args.num_heads, head_size))
+    return flow.transpose(x, perm=[0, 2, 1, 3])
+
+
+def fused_encoder_layer(x, name):
+    # The rows of x are in (seq, batch) order, which the fused self attention expects.
+    h = dense(x, hidden * 3, name + "-qkv")
+    h = flow.reshape(h, (args.seq_length, args.batch_size, hidden * 3))
+    scores, v = flow.nn.fused_self_attention_query_mul_key_and_value(
+        h, head_size=head_size, alpha=head_size ** -0.5
+    )
+    context = flow.matmul(flow.nn.softmax(scores), v)
+    context = flow.transpose(context, perm=[2, 0, 1, 3])
+    context = flow.reshape(context, (tokens, hidden))
+    x = flow.layers.layer_norm(
+        x + dense(context, hidden, name + "-out"), name=name + "-ln0"
+    )
+    ffn = flow.layers.dense(
+        x,
+        hidden * 4,
+        use_bias=False,
+        kernel_initializer=flow.random_normal_initializer(stddev=0.02),
+        name=name + "-ffn0",
+    )
+    ffn_bias = flow.get_variable(
+        name + "-ffn0-bias",
+        shape=(hidden * 4,),
+        dtype=flow.float,
+        initializer=flow.zeros_initializer(),
+    )
+    ffn = flow.nn.fused_bias_add_gelu(ffn, ffn_bias, data_format="NC")
+    return flow.layers.layer_norm(
+        x + dense(ffn, hidden, name + "-ffn1"), name=name + "-ln1"
+    )
+
+
+def encoder_layer(x, name):
+    q = to_heads(dense(x, hidden, name + "-q"))
+    k = to_heads(dense(x, hidden, name + "-k"))
+    v = to_heads(dense(x, hidden, name + "-v"))
+    scores = flow.matmul(q, k, transpose_b=True, alpha=head_size ** -0.5)
+    context = flow.matmul(flow.nn.softmax(scores), v)
+    context = flow.transpose(context, perm=[0, 2, 1, 3])
+    context = flow.reshape(context, (tokens, hidden))
+    x = flow.layers.layer_norm(
+        x + dense(context, hidden, name + "-out"), name=name + "-ln0"
+    )
+    ffn = dense(x, hidden * 4, name + "-ffn0", activation=flow.math.gelu)
+    return flow.layers.layer_norm(
+        x + dense(ffn, hidden, name + "-ffn1"), name=name + "-ln1"
+    )
+
+
+def make_jobs():
+    layer = fused_encoder_layer if args.fused else encoder_layer
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0"))
+
+    @flow.global_function(type="predict", function_config=func_config)
+    def infer_job(x: tp.Numpy.Placeholder((tokens, hidden))) -> tp.Numpy:
+        y = x
+        for i in range(args.num_layers):
+            y = layer(y, "infer-layer{}".format(i))
+        return y
+
+    @flow.global_function(type="train", function_config=func_config)
+    def train_job(x: tp.Numpy.Placeholder((tokens, hidden))) -> tp.Numpy:
+        y = x
+        for i in range(args.num_layers):
+            y = layer(y, "train-layer{}".format(i))
+        loss = flow.math.reduce_mean(y * y)
+        flow.optimizer.SGD(
+            flow.optimizer.PiecewiseConstantScheduler([], [1e-4]), momentum=0
+        ).minimize(loss)
+        return loss
+
+    @flow.global_function(type="train", function_config=func_config)
+    def layer_norm_job(x: tp.Numpy.Placeholder((tokens, hidden))) -> tp.Numpy:
+        v = flow.get_variable(
+            "layer-norm-input",
+            shape=(tokens, hidden),
+            dtype=flow.float,
+            initializer=flow.zeros_initializer(),
+        )
+        y = x + v
+        for i in range(args.num_layers * 2):
+            y = flow.layers.layer_norm(y, name="ln{}".format(i))
+        loss = flow.math.reduce_mean(y * y)
+        flow.optimizer.SGD(
+            flow.optimizer.PiecewiseConstantScheduler([], [1e-4]), momentum=0
+        ).minimize(loss)
+        return loss
+
+    return infer_job, train_job, layer_norm_job
+
+
+if __name__ == "__main__":
+    if args.compute_thread_pool_size > 0:
+        flow.config.compute_thread_pool_size(args.compute_thread_pool_size)
+    infer_job, train_job, layer_norm_job = make_jobs()
+    x = np.random.uniform(-1, 1, (tokens, hidden)).astype(np.float32)
+    print(
+        "cpu transformer{}: layers {} hidden {} heads {} batch {} seq {}".format(
+            " (fused)" if args.fused else "",
+            args.num_layers,
+            args.hidden_size,
+            args.num_heads,
+            args.batch_size,
+            args.seq_length,
+        )
+    )
+    for name, job in (
+        ("inference", infer_job),
+        ("train step", train_job),
+        ("layer norms fwd+bwd", layer_norm_job),
+    ):
+        cost = timer.time_fn(job, x)
+        print(
+            "{:>20}: {:.2f} ms, {:.0f} tokens/s".format(
+                name, cost * 1000, tokens / cost
+            )
+        )
@@ -0,0 +1,101 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Times flow.experimental.unique_with_counts and flow.layers.categorical_ordinal_encoder
+# placed on the cpu on batches of Zipf distributed ids, like those of an embedding:
+#
+#   python3 cpu_unique_benchmark.py --num_ids 1048576 --zipf_a 1.2
+#
+# unique_with_counts is compared with np.unique. The batches of more than 65536 ids are
+# split into partitions over the compute thread pool, its size is set by
+# --compute_thread_pool_size.
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import sys
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from timing_util import BenchmarkTimer  # noqa: E402
+
+parser = argparse.ArgumentParser(description="cpu unique benchmark")
+parser.add_argument("--num_ids", type=int, default=1048576)
+parser.add_argument("--zipf_a", type=float, default=1.2)
+parser.add_argument("--vocab_size", type=int, default=10000000)
+parser.add_argument("--iters", type=int, default=20)
+parser.add_argument("--warmup_iters", type=int, default=3)
+parser.add_argument("--compute_thread_pool_size", type=int, default=0)
+args = parser.parse_args()
+timer = BenchmarkTimer(args.iters, args.warmup_iters)
+
+
+def make_config():
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0"))
+    return func_config
+
+
+@flow.global_function(type="predict", function_config=make_config())
+def unique_job(
+    x: tp.Numpy.Placeholder((args.num_ids,), dtype=flow.int64)
+) -> tp.Numpy:
+    y, idx, count, num_unique = flow.experimental.unique_with_counts(x)
+    return num_unique
+
+
+@flow.global_function(type="predict", function_config=make_config())
+def encode_job(
+    x: tp.Numpy.Placeholder((args.num_ids,), dtype=flow.int64)
+) -> tp.Numpy:
+    return flow.layers.categorical_ordinal_encoder(x, capacity=2 * args.vocab_size)
+
+
+def zipf_ids():
+    ids = np.random.zipf(args.zipf_a, args.num_ids) % args.vocab_size
+    # the hashes of the ids, 0 is reserved by the encoder
+    return (ids * 2654435761 + 1).astype(np.int64)
+
+
+if __name__ == "__main__":
+    if args.compute_thread_pool_size > 0:
+        flow.config.compute_thread_pool_size(args.compute_thread_pool_size)
+    batches = [zipf_ids() for _ in range(4)]
+    num_unique = unique_job(batches[0]).item()
+    assert num_unique == np.unique(batches[0]).size
+    print(
+        "cpu unique: {} ids, zipf a {}, {} unique".format(
+            args.num_ids, args.zipf_a, num_unique
+        )
+    )
+    unique_cost = timer.time_fn_over_batches(unique_job, batches)
+    numpy_cost = timer.time_fn_over_batches(
+        lambda x: np.unique(x, return_inverse=True, return_counts=True), batches
+    )
+    encode_cost = timer.time_fn_over_batches(encode_job, batches)
+    for name, cost in [
+        ("unique_with_counts", unique_cost),
+        ("np.unique", numpy_cost),
+        ("ordinal encode", encode_cost),
+    ]:
+        print(
+            "{:>18}: {:.2f} ms, {:.1f} M ids/s".format(
+                name, cost * 1000, args.num_ids / cost / 1e6
+            )
+        )
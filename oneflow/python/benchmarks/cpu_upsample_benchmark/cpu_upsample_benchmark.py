@@ -0,0 +1,191 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Times flow.layers.upsample_2d placed on the cpu against the same resize composed of
+# gathers along the height and the width, and of lerps for bilinear, for NCHW and NHWC:
+#
+#   python3 cpu_upsample_benchmark.py --batch_size 8 --channels 256 --height 64
+#
+# The images and the channels are spread over the compute thread pool, its size is set
+# by --compute_thread_pool_size.
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import sys
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from timing_util import BenchmarkTimer  # noqa: E402
+
+parser = argparse.ArgumentParser(description="cpu upsample benchmark")
+parser.add_argument("--batch_size", type=int, default=8)
+parser.add_argument("--channels", type=int, default=256)
+parser.add_argument("--height", type=int, default=64)
+parser.add_argument("--width", type=int, default=64)
+parser.add_argument("--scale", type=int, default=2)
+parser.add_argument("--iters", type=int, default=20)
+parser.add_argument("--warmup_iters", type=int, default=3)
+parser.add_argument("--compute_thread_pool_size", type=int, default=0)
+args = parser.parse_args()
+timer = BenchmarkTimer(args.iters, args.warmup_iters)
+
+out_height = args.height * args.scale
+out_width = args.width * args.scale
+
+
+def image_shape(data_format, height, width):
+    if data_format == "NCHW":
+        return (args.batch_size, args.channels, height, width)
+    return (args.batch_size, height, width, args.channels)
+
+
+def nearest_table(in_size, out_size):
+    index = np.floor((np.arange(out_size) + 0.5) * in_size / out_size).astype(np.int32)
+    return np.minimum(index, in_size - 1)
+
+
+def linear_table(in_size, out_size):
+    src = np.maximum((np.arange(out_size) + 0.5) * in_size / out_size - 0.5, 0)
+    lo = np.floor(src).astype(np.int32)
+    hi = np.minimum(lo + 1, in_size - 1).astype(np.int32)
+    return lo, hi, (src - lo).astype(np.float32)
+
+
+def lerp_shape(axis, size):
+    shape = [1, 1, 1, 1]
+    shape[axis] = size
+    return tuple(shape)
+
+
+def make_jobs(data_format, interpolation):
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0"))
+    h_axis, w_axis = (2, 3) if data_format == "NCHW" else (1, 2)
+    x_shape = image_shape(data_format, args.height, args.width)
+    h_lerp_shape = lerp_shape(h_axis, out_height)
+    w_lerp_shape = lerp_shape(w_axis, out_width)
+    index_spec = {
+        "h_lo": tp.Numpy.Placeholder((out_height,), dtype=flow.int32),
+        "h_hi": tp.Numpy.Placeholder((out_height,), dtype=flow.int32),
+        "w_lo": tp.Numpy.Placeholder((out_width,), dtype=flow.int32),
+        "w_hi": tp.Numpy.Placeholder((out_width,), dtype=flow.int32),
+        "h_lerp": tp.Numpy.Placeholder(h_lerp_shape),
+        "w_lerp": tp.Numpy.Placeholder(w_lerp_shape),
+    }
+
+    def upsample_job(
+        x: tp.Numpy.Placeholder(x_shape),
+        h_lo: index_spec["h_lo"],
+        h_hi: index_spec["h_hi"],
+        w_lo: index_spec["w_lo"],
+        w_hi: index_spec["w_hi"],
+        h_lerp: index_spec["h_lerp"],
+        w_lerp: index_spec["w_lerp"],
+    ) -> tp.Numpy:
+        return flow.layers.upsample_2d(
+            x,
+            size=args.scale,
+            data_format=data_format,
+            interpolation=interpolation,
+        )
+
+    def composed_job(
+        x: tp.Numpy.Placeholder(x_shape),
+        h_lo: index_spec["h_lo"],
+        h_hi: index_spec["h_hi"],
+        w_lo: index_spec["w_lo"],
+        w_hi: index_spec["w_hi"],
+        h_lerp: index_spec["h_lerp"],
+        w_lerp: index_spec["w_lerp"],
+    ) -> tp.Numpy:
+        if interpolation == "nearest":
+            y = flow.gather(x, h_lo, axis=h_axis)
+            return flow.gather(y, w_lo, axis=w_axis)
+        top = flow.gather(x, h_lo, axis=h_axis)
+        bottom = flow.gather(x, h_hi, axis=h_axis)
+        y = top + (bottom - top) * h_lerp
+        left = flow.gather(y, w_lo, axis=w_axis)
+        right = flow.gather(y, w_hi, axis=w_axis)
+        return left + (right - left) * w_lerp
+
+    suffix = "_{}_{}".format(data_format, interpolation)
+    upsample_job.__name__ += suffix
+    composed_job.__name__ += suffix
+    return (
+        flow.global_function(type="predict", function_config=func_config)(upsample_job),
+        flow.global_function(type="predict", function_config=func_config)(composed_job),
+    )
+
+
+def make_inputs(data_format, interpolation):
+    x = np.random.uniform(-1, 1, image_shape(data_format, args.height, args.width))
+    h_axis, w_axis = (2, 3) if data_format == "NCHW" else (1, 2)
+    if interpolation == "nearest":
+        h_lo = h_hi = nearest_table(args.height, out_height)
+        w_lo = w_hi = nearest_table(args.width, out_width)
+        h_lerp = np.zeros(out_height, dtype=np.float32)
+        w_lerp = np.zeros(out_width, dtype=np.float32)
+    else:
+        h_lo, h_hi, h_lerp = linear_table(args.height, out_height)
+        w_lo, w_hi, w_lerp = linear_table(args.width, out_width)
+    return (
+        x.astype(np.float32),
+        h_lo,
+        h_hi,
+        w_lo,
+        w_hi,
+        h_lerp.reshape(lerp_shape(h_axis, out_height)),
+        w_lerp.reshape(lerp_shape(w_axis, out_width)),
+    )
+
+
+if __name__ == "__main__":
+    if args.compute_thread_pool_size > 0:
+        flow.config.compute_thread_pool_size(args.compute_thread_pool_size)
+    configs = [
+        (data_format, interpolation)
+        for data_format in ("NCHW", "NHWC")
+        for interpolation in ("nearest", "bilinear")
+    ]
+    jobs = [make_jobs(*config) for config in configs]
+    print(
+        "cpu upsample: batch {} channels {} {}x{} -> {}x{}".format(
+            args.batch_size,
+            args.channels,
+            args.height,
+            args.width,
+            out_height,
+            out_width,
+        )
+    )
+    for config, (upsample_job, composed_job) in zip(configs, jobs):
+        inputs = make_inputs(*config)
+        y = upsample_job(*inputs)
+        assert np.allclose(y, composed_job(*inputs), rtol=1e-4, atol=1e-5)
+        upsample_cost = timer.time_fn(upsample_job, *inputs)
+        composed_cost = timer.time_fn(composed_job, *inputs)
+        print(
+            "{:>18}: upsample {:.2f} ms, gather {:.2f} ms, {:.2f}x".format(
+                " ".join(config),
+                upsample_cost * 1000,
+                composed_cost * 1000,
+                composed_cost / upsample_cost,
+            )
+        )
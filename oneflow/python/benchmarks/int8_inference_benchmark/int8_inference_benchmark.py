@@ -0,0 +1,146 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Compares the cpu inference of a ResNet style network in float and in int8, the int8 job being
+# converted from the observers of quantization aware training:
+#
+#   python3 int8_inference_benchmark.py --batch_size 16 --image_size 56 --channels 64
+#
+# The accuracy is the top-1 agreement of the int8 network with the float one on the evaluation
+# batches, along with the largest relative error of the logits.
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import sys
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from timing_util import BenchmarkTimer  # noqa: E402
+
+parser = argparse.ArgumentParser(description="int8 cpu inference benchmark")
+parser.add_argument("--batch_size", type=int, default=16)
+parser.add_argument("--image_size", type=int, default=56)
+parser.add_argument("--channels", type=int, default=64)
+parser.add_argument("--num_blocks", type=int, default=3)
+parser.add_argument("--num_classes", type=int, default=1000)
+parser.add_argument("--calibration_iters", type=int, default=20)
+parser.add_argument("--eval_iters", type=int, default=10)
+parser.add_argument("--iters", type=int, default=20)
+parser.add_argument("--warmup_iters", type=int, default=3)
+parser.add_argument("--symmetric", type=int, default=1)
+parser.add_argument("--per_channel", type=int, default=1)
+args = parser.parse_args()
+timer = BenchmarkTimer(args.iters, args.warmup_iters)
+
+INPUT_SHAPE = (args.batch_size, 3, args.image_size, args.image_size)
+
+
+def residual_block(x, name):
+    y = flow.layers.conv2d(
+        x, args.channels, 3, 1, "SAME", activation=flow.nn.relu, name=name + "-conv1"
+    )
+    y = flow.layers.conv2d(y, args.channels, 3, 1, "SAME", name=name + "-conv2")
+    return flow.nn.relu(x + y)
+
+
+def resnet(x):
+    y = flow.layers.conv2d(
+        x, args.channels, 3, 1, "SAME", activation=flow.nn.relu, name="stem"
+    )
+    for i in range(args.num_blocks):
+        y = residual_block(y, "block{}".format(i))
+    y = flow.nn.avg_pool2d(y, args.image_size, 1, "VALID")
+    y = flow.reshape(y, (args.batch_size, -1))
+    return flow.layers.dense(y, args.num_classes, name="fc")
+
+
+def qat_func_config():
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.enable_qat(True)
+    func_config.qat.symmetric(bool(args.symmetric))
+    func_config.qat.per_channel_weight_quantization(bool(args.per_channel))
+    func_config.qat.moving_min_max_stop_update_after_iters(args.calibration_iters)
+    func_config.qat.target_backend("oneflow_int8")
+    return func_config
+
+
+float_func_config = flow.FunctionConfig()
+float_func_config.default_logical_view(flow.scope.consistent_view())
+
+
+@flow.global_function(type="train", function_config=qat_func_config())
+def calibrate_job(x: tp.Numpy.Placeholder(INPUT_SHAPE)) -> tp.Numpy:
+    with flow.scope.placement("cpu", "0:0"):
+        y = resnet(x)
+        flow.optimizer.SGD(
+            flow.optimizer.PiecewiseConstantScheduler([], [0]), momentum=0
+        ).minimize(flow.math.reduce_mean(y))
+    return y
+
+
+@flow.global_function(function_config=qat_func_config())
+def int8_job(x: tp.Numpy.Placeholder(INPUT_SHAPE)) -> tp.Numpy:
+    with flow.scope.placement("cpu", "0:0"):
+        return resnet(x)
+
+
+@flow.global_function(function_config=float_func_config)
+def float_job(x: tp.Numpy.Placeholder(INPUT_SHAPE)) -> tp.Numpy:
+    with flow.scope.placement("cpu", "0:0"):
+        return resnet(x)
+
+
+def main():
+    rng = np.random.RandomState(0)
+    for _ in range(args.calibration_iters):
+        calibrate_job(rng.rand(*INPUT_SHAPE).astype(np.float32))
+    agreement = []
+    max_error = 0.0
+    for _ in range(args.eval_iters):
+        x = rng.rand(*INPUT_SHAPE).astype(np.float32)
+        float_out = float_job(x)
+        int8_out = int8_job(x)
+        agreement.append(np.mean(float_out.argmax(axis=1) == int8_out.argmax(axis=1)))
+        max_error = max(
+            max_error, np.abs(int8_out - float_out).max() / np.abs(float_out).max()
+        )
+    x = rng.rand(*INPUT_SHAPE).astype(np.float32)
+    float_time = timer.time_fn(float_job, x)
+    int8_time = timer.time_fn(int8_job, x)
+    print(
+        "top-1 agreement {:.2f}%, max relative error {:.4f}".format(
+            100 * np.mean(agreement), max_error
+        )
+    )
+    print(
+        "batch {} image {} channels {}: float {:.2f} ms, int8 {:.2f} ms, "
+        "speedup {:.2f}x".format(
+            args.batch_size,
+            args.image_size,
+            args.channels,
+            float_time * 1000,
+            int8_time * 1000,
+            float_time / int8_time,
+        )
+    )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,138 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Reports how the step time of a multilayer perceptron trained by adam grows with the
+# model size when the optimizer states are offloaded:
+#
+#   python3 offload_benchmark.py --device gpu --hidden_sizes 1024,2048,4096,8192
+#
+# On gpu the moments live in the pinned host memory and the memory is the one used on
+# the gpu. On cpu they live in files under --offload_file_dir and the memory is the peak
+# resident size of the process. Every run is a process of its own.
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import os
+import resource
+import subprocess
+import sys
+import time
+
+import numpy as np
+
+parser = argparse.ArgumentParser(description="optimizer state offload benchmark")
+parser.add_argument("--device", type=str, default="gpu")
+parser.add_argument("--hidden_sizes", type=str, default="1024,2048,4096,8192")
+parser.add_argument("--num_layers", type=int, default=8)
+parser.add_argument("--batch_size", type=int, default=64)
+parser.add_argument("--offload_file_dir", type=str, default="/tmp")
+parser.add_argument("--iters", type=int, default=20)
+parser.add_argument("--warmup_iters", type=int, default=3)
+parser.add_argument(
+    "--hidden_size", type=int, default=0, help="internal, the size of a single run"
+)
+parser.add_argument("--offload", action="store_true", help="internal")
+args = parser.parse_args()
+
+
+def memory_used_mbyte():
+    if args.device == "gpu":
+        out = subprocess.check_output(
+            ["nvidia-smi", "--query-gpu=memory.used", "--format=csv,noheader,nounits"]
+        )
+        return int(out.decode().splitlines()[0])
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss // 1024
+
+
+def run_one():
+    import oneflow as flow
+    import oneflow.typing as tp
+
+    flow.config.offload_file_dir(args.offload_file_dir)
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    if args.offload:
+        func_config.offload_conf({"offload_optimizer_states": True})
+
+    shape = (args.batch_size, args.hidden_size)
+
+    @flow.global_function(type="train", function_config=func_config)
+    def train_job(x: tp.Numpy.Placeholder(shape)) -> tp.Numpy:
+        with flow.scope.placement(args.device, "0:0"):
+            y = x
+            for i in range(args.num_layers):
+                y = flow.layers.dense(
+                    y,
+                    args.hidden_size,
+                    activation=flow.nn.relu,
+                    kernel_initializer=flow.random_uniform_initializer(-0.01, 0.01),
+                    name="fc{}".format(i),
+                )
+            loss = flow.math.reduce_mean(y)
+            flow.optimizer.Adam(
+                flow.optimizer.PiecewiseConstantScheduler([], [1e-4])
+            ).minimize(loss)
+        return loss
+
+    x = np.random.rand(*shape).astype(np.float32)
+    for _ in range(args.warmup_iters):
+        train_job(x)
+    start = time.perf_counter()
+    for _ in range(args.iters):
+        train_job(x)
+    cost = (time.perf_counter() - start) / args.iters
+    print("{} {:.6f}".format(memory_used_mbyte(), cost))
+
+
+def launch(hidden_size, offload):
+    cmd = [sys.executable, os.path.abspath(__file__), "--hidden_size", str(hidden_size)]
+    for key in (
+        "device",
+        "num_layers",
+        "batch_size",
+        "offload_file_dir",
+        "iters",
+        "warmup_iters",
+    ):
+        cmd += ["--" + key, str(getattr(args, key))]
+    if offload:
+        cmd.append("--offload")
+    out = subprocess.check_output(cmd).decode()
+    memory, cost = out.strip().splitlines()[-1].split()
+    return int(memory), float(cost)
+
+
+if __name__ == "__main__":
+    if args.hidden_size > 0:
+        run_one()
+    else:
+        print("adam on {}, {} layers".format(args.device, args.num_layers))
+        for hidden_size in [int(s) for s in args.hidden_sizes.split(",")]:
+            state_mbyte = 2 * 4 * args.num_layers * (hidden_size + 1) * hidden_size
+            state_mbyte /= 1024 * 1024
+            memory, cost = launch(hidden_size, False)
+            offload_memory, offload_cost = launch(hidden_size, True)
+            print(
+                "hidden {:>6}: optimizer states {:.0f} MB, memory {} MB -> {} MB, "
+                "step {:.2f} ms -> {:.2f} ms ({:.2f}x)".format(
+                    hidden_size,
+                    state_mbyte,
+                    memory,
+                    offload_memory,
+                    cost * 1000,
+                    offload_cost * 1000,
+                    offload_cost / cost,
+                )
+            )
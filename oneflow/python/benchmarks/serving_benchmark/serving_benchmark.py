@@ -0,0 +1,118 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import threading
+import time
+
+import numpy as np
+import oneflow as flow
+
+parser = argparse.ArgumentParser(
+    description="load generator for native batching serving"
+)
+parser.add_argument("--saved_model_dir", type=str, required=True)
+parser.add_argument("--job_name", type=str, default=None)
+parser.add_argument("--device_tag", type=str, default="cpu")
+parser.add_argument("--num_clients", type=int, default=16)
+parser.add_argument("--requests_per_client", type=int, default=200)
+parser.add_argument("--rows_per_request", type=int, default=1)
+parser.add_argument("--batch_timeout_us", type=int, default=1000)
+parser.add_argument(
+    "--skip_baseline",
+    action="store_true",
+    help="skip the one-job-instance-per-request InferenceSession.run baseline",
+)
+args = parser.parse_args()
+
+
+def make_inputs(sess, job_name):
+    inputs = {}
+    for input_name in sess.list_inputs():
+        info = sess.input_info(input_name, job_name)
+        shape = (args.rows_per_request,) + tuple(info["shape"][1:])
+        dtype = flow.convert_oneflow_dtype_to_numpy_dtype(info["dtype"])
+        inputs[input_name] = np.random.random_sample(shape).astype(dtype)
+    return inputs
+
+
+def run_clients(infer_fn, inputs):
+    latencies = [[] for _ in range(args.num_clients)]
+
+    def client(idx):
+        for _ in range(args.requests_per_client):
+            start = time.perf_counter()
+            infer_fn(inputs)
+            latencies[idx].append(time.perf_counter() - start)
+
+    threads = [
+        threading.Thread(target=client, args=(i,)) for i in range(args.num_clients)
+    ]
+    start = time.perf_counter()
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    elapsed = time.perf_counter() - start
+    return np.concatenate([np.array(l) for l in latencies]), elapsed
+
+
+def report(name, latencies, elapsed):
+    print(
+        "{}: requests {}, QPS {:.1f}, latency p50 {:.3f} ms, p99 {:.3f} ms".format(
+            name,
+            len(latencies),
+            len(latencies) / elapsed,
+            np.percentile(latencies, 50) * 1000,
+            np.percentile(latencies, 99) * 1000,
+        )
+    )
+
+
+def main():
+    option = flow.serving.SessionOption()
+    option.device_tag = args.device_tag
+    sess = flow.serving.InferenceSession(option)
+    sess.load_saved_model(args.saved_model_dir)
+    sess.launch()
+    job_name = args.job_name or sess.list_jobs()[0]
+    inputs = make_inputs(sess, job_name)
+
+    if not args.skip_baseline:
+        # InferenceSession.run is driven by one event loop, serialize the clients on it
+        lock = threading.Lock()
+
+        def baseline_infer(inputs):
+            with lock:
+                sess.run(job_name, **inputs)
+
+        report("InferenceSession.run", *run_clients(baseline_infer, inputs))
+
+    server = sess.make_batching_server(job_name, batch_timeout_us=args.batch_timeout_us)
+    report("BatchingInferenceServer", *run_clients(server.infer, inputs))
+    stats = server.stats()
+    print(
+        "mean batch size {:.2f} over {} batches".format(
+            stats["num_batched_rows"] / max(stats["num_batches"], 1),
+            stats["num_batches"],
+        )
+    )
+    sess.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,52 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Timing loop shared by the benchmark scripts in the directories next to this file,
+# which import it after putting this directory on sys.path.
+import time
+
+import oneflow as flow
+
+
+class BenchmarkTimer(object):
+    """Times a function over iters calls, after warmup_iters untimed calls.
+
+    Jobs returning futures or nothing are only finished once the session is synced,
+    which sync=True does before reading the clock.
+    """
+
+    def __init__(self, iters, warmup_iters, sync=False):
+        self.iters = iters
+        self.warmup_iters = warmup_iters
+        self.sync = sync
+
+    def time_fn(self, fn, *args):
+        """Returns the mean seconds of fn(*args)."""
+        return self.time_fn_over_batches(lambda batch: fn(*batch), [args])
+
+    def time_fn_over_batches(self, fn, batches):
+        """Returns the mean seconds of a call of fn, the i-th call takes the batch
+        batches[i % len(batches)].
+        """
+        for i in range(self.warmup_iters):
+            fn(batches[i % len(batches)])
+        if self.sync:
+            flow.sync_default_session()
+        start = time.perf_counter()
+        for i in range(self.iters):
+            fn(batches[i % len(batches)])
+        if self.sync:
+            flow.sync_default_session()
+        return (time.perf_counter() - start) / self.iters
@@ -167,6 +167,23 @@ def enable_numa_aware_cuda_malloc_host(val):
     sess.config_proto.resource.enable_numa_aware_cuda_malloc_host = val
 
 
+@oneflow_export("config.offload_file_dir")
+def api_offload_file_dir(val: str) -> None:
+    r"""Set the directory of the files backing the offloaded variables on cpu devices.
+
+    Args:
+        val (str): path of a directory on a local disk
+    """
+    return enable_if.unique([offload_file_dir, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def offload_file_dir(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is str
+    sess.config_proto.resource.offload_file_dir = val
+
+
 @oneflow_export("config.compute_thread_pool_size")
 def api_compute_thread_pool_size(val: int) -> None:
     r"""Set up the size of compute thread pool
@@ -687,6 +704,57 @@ def nccl_enable_mixed_fusion(val):
     sess.config_proto.resource.collective_boxing_conf.nccl_enable_mixed_fusion = val
 
 
+@oneflow_export("config.collective_boxing.cpu_enable_collective_boxing")
+def api_cpu_enable_collective_boxing(val: bool = True) -> None:
+    r"""Whether or not to boxing cpu blobs with the cpu collective boxing backend
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([cpu_enable_collective_boxing, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def cpu_enable_collective_boxing(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.collective_boxing_conf.cpu_enable_collective_boxing = val
+
+
+@oneflow_export("config.collective_boxing.cpu_chunk_size_kb")
+def api_cpu_chunk_size_kb(val: int) -> None:
+    r"""Set up the size of the chunks which the cpu collective boxing backend pipelines
+
+    Args:
+        val (int): chunk size in KB
+    """
+    return enable_if.unique([cpu_chunk_size_kb, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def cpu_chunk_size_kb(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.collective_boxing_conf.cpu_chunk_size_kb = val
+
+
+@oneflow_export("config.collective_boxing.cpu_halving_doubling_threshold_kb")
+def api_cpu_halving_doubling_threshold_kb(val: int) -> None:
+    r"""Set up the largest all-reduce which uses recursive halving-doubling instead of the ring
+
+    Args:
+        val (int): threshold in KB
+    """
+    return enable_if.unique([cpu_halving_doubling_threshold_kb, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def cpu_halving_doubling_threshold_kb(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.collective_boxing_conf.cpu_halving_doubling_threshold_kb = val
+
+
 @enable_if.condition(hob.in_normal_mode & hob.session_initialized)
 def do_nothing(*args, **kwargs):
     print("Nothing happened because the session is running")
@@ -29,6 +29,7 @@ _dtypes = [
     oneflow.double,
     oneflow.float64,
     oneflow.float16,
+    oneflow.bfloat16,
     oneflow.int8,
     oneflow.int32,
     oneflow.int64,
@@ -440,6 +440,18 @@ def set_cudnn_conv_heuristic_search_algo(func_desc, value):
     func_desc.job_config_proto.set_cudnn_conv_heuristic_search_algo(value)
 
 
+@oneflow_function_config("cpu_conv_heuristic_search_algo")
+def set_cpu_conv_heuristic_search_algo(func_desc, value):
+    r"""Whether to pick the algorithm of the cpu convs by their shapes. If False, the
+    algorithms able to run a conv shape are timed once and the fastest one is cached.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_cpu_conv_heuristic_search_algo(value)
+
+
 @oneflow_function_config("enable_cudnn_fused_normalization_add_relu")
 def set_enable_cudnn_fused_normalization_add_relu(func_desc, value):
     r"""Whether enable cudnn_fused_normalization_add_relu.
@@ -475,6 +487,19 @@ def set_enable_fuse_cast_scale(func_desc, value=True):
     func_desc.job_config_proto.set_enable_fuse_cast_scale(value)
 
 
+@oneflow_function_config("enable_fold_normalization")
+def set_enable_fold_normalization(func_desc, value=True):
+    r"""Whether enable fold_normalization.
+            If enabled, an inference job folds the scale and the shift of a batch
+            normalization into the weight and the bias of the conv or matmul before it.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_enable_fold_normalization(value)
+
+
 @oneflow_function_config("cudnn_conv_use_deterministic_algo_only")
 def set_cudnn_conv_use_deterministic_algo_only(func_desc, value):
     r"""Set value to cudnn conv_use_deterministic_only algorithm
@@ -759,6 +784,18 @@ def set_enable_auto_mixed_precision(func_desc, value=True):
     func_desc.job_config_proto.set_enable_auto_mixed_precision(value)
 
 
+@oneflow_function_config("enable_cpu_auto_mixed_precision")
+def set_enable_cpu_auto_mixed_precision(func_desc, value=True):
+    r"""If true, then the ops placed on cpu with bfloat16 kernels compute in bfloat16, while the
+    variables and their updates stay in float32.
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.set_enable_cpu_auto_mixed_precision(value)
+
+
 @oneflow_function_config("enable_keep_header_only")
 def set_enable_keep_header_only(func_desc, value=True):
     r"""deprecated api.
@@ -812,6 +849,73 @@ def set_indexed_slices_optimizer_conf(func_desc, value):
     pb_util.PythonDict2CFG(value, pb_msg)
 
 
+@oneflow_function_config("gradient_compression_conf")
+def set_gradient_compression_conf(func_desc, value):
+    r"""Compress the gradients of variables before they are summed up across machines.
+
+    For example:
+
+    .. code-block:: python
+
+        func_config.gradient_compression_conf(
+            {
+                "rule": [
+                    {"variable_op_names": ["embedding"], "top_k_conf": {"ratio": 0.01}},
+                    {"one_bit_conf": {}},
+                ]
+            }
+        )
+
+    Every variable takes the first rule naming it or the first rule without names.
+
+    Args:
+        func_desc ([type]): [description]
+        value (dict): a GradientCompressionConf as a dict
+    """
+    assert type(value) is dict
+    pb_msg = func_desc.job_config_proto.mutable_gradient_compression_conf()
+    pb_util.PythonDict2CFG(value, pb_msg)
+
+
+@oneflow_function_config("checkpointing_memory_budget_mbyte")
+def set_checkpointing_memory_budget_mbyte(func_desc, value):
+    r"""Recompute forward ops in the backward pass so that the activations kept for backward
+    fit in the memory budget of each device, e.g. 1024mb. The ops to recompute are planned
+    from the blob sizes and the estimated cost of the ops, ignoring the checkpointing scopes.
+
+    Args:
+        func_desc ([type]): [description]
+        value (int): the memory budget in MByte
+    """
+    conf = func_desc.job_config_proto.mutable_auto_checkpointing_conf()
+    conf.set_memory_budget_mbyte(value)
+
+
+@oneflow_function_config("offload_conf")
+def set_offload_conf(func_desc, value):
+    r"""Keep variables out of the device memory: in the pinned host memory for gpu devices
+    and in a memory-mapped file under config.offload_file_dir for cpu devices.
+
+    For example:
+
+    .. code-block:: python
+
+        func_config.offload_conf(
+            {"offload_optimizer_states": True, "variable_op_names": ["embedding"]}
+        )
+
+    The optimizer states, such as the moments of adam and lamb, are offloaded unless they
+    have fewer bytes than min_byte_size on one device.
+
+    Args:
+        func_desc ([type]): [description]
+        value (dict): an OffloadConf as a dict
+    """
+    assert type(value) is dict
+    pb_msg = func_desc.job_config_proto.mutable_offload_conf()
+    pb_util.PythonDict2CFG(value, pb_msg)
+
+
 @oneflow_function_config("enable_fuse_model_update_ops")
 def set_enable_fuse_model_update_ops(func_desc, value=True):
     r"""Whether enable fuse_model_update_ops.
@@ -923,6 +1027,19 @@ def set_use_tensorrt(func_desc, value=True):
     func_desc.job_config_proto.mutable_xrt_config().set_use_tensorrt(value)
 
 
+@oneflow_function_config("use_cpu_fusion")
+def set_use_cpu_fusion(func_desc, value=True):
+    r"""Whether use the native cpu fusion engine of XRT or not. It fuses the elementwise,
+    broadcast and reduce ops left over by XLA and TensorRT into single loops over the tensors.
+    The ops computing on integers are not fused, only the casts between them and floats.
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.mutable_xrt_config().set_use_cpu_fusion(value)
+
+
 @oneflow_function_config("tensorrt.use_fp16")
 def set_tensorrt_use_fp16(func_desc, value=True):
     r"""Whether use tensorrt fp16  or not
@@ -273,6 +273,9 @@ def ofrecord_reader(
     random_shuffle: bool = False,
     shuffle_buffer_size: int = 1024,
     shuffle_after_epoch: bool = False,
+    num_parse_threads: int = 0,
+    prefetch_buffer_size: int = 4,
+    stats_log_interval: int = 0,
     name: Optional[str] = None,
 ) -> oneflow._oneflow_internal.BlobDesc:
     r"""Get ofrecord object from ofrecord dataset.
@@ -286,6 +289,9 @@ def ofrecord_reader(
         random_shuffle (bool, optional): Determines records shuffled or not. Defaults to False.
         shuffle_buffer_size (int, optional): Shuffle buffer size. Defaults to 1024.
         shuffle_after_epoch (bool, optional): Shuffled or not after each epoch. Defaults to False.
+        num_parse_threads (int, optional): Number of threads deserializing batches ahead of the reader op, 0 means deserializing inside the op. Defaults to 0.
+        prefetch_buffer_size (int, optional): Number of batches buffered between two stages of the reading pipeline. Defaults to 4.
+        stats_log_interval (int, optional): Log how long each stage of the reading pipeline is busy, starved and blocked every this many batches, 0 means never. Defaults to 0.
         name (Optional[str], optional): Optional name. Defaults to None.
 
     Returns:
@@ -349,6 +355,9 @@ def ofrecord_reader(
         .Attr("shuffle_buffer_size", shuffle_buffer_size)
         .Attr("shuffle_after_epoch", shuffle_after_epoch)
         .Attr("part_name_suffix_length", part_name_suffix_length)
+        .Attr("num_parse_threads", num_parse_threads)
+        .Attr("prefetch_buffer_size", prefetch_buffer_size)
+        .Attr("stats_log_interval", stats_log_interval)
         .Build()
         .InferAndTryRun()
         .RemoteBlobList()[0]
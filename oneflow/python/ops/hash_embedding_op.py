@@ -0,0 +1,123 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+from __future__ import absolute_import
+
+from oneflow.python.oneflow_export import oneflow_export
+
+import oneflow as flow
+import oneflow.python.framework.id_util as id_util
+import oneflow._oneflow_internal
+
+
+@oneflow_export("layers.hash_embedding")
+def hash_embedding(
+    ids: oneflow._oneflow_internal.BlobDesc,
+    embedding_dim: int,
+    combiner: str = "none",
+    optimizer: str = "sgd",
+    learning_rate: float = 0.01,
+    epsilon: float = 1e-8,
+    initializer_range: float = 0.05,
+    seed: int = 0,
+    ttl: int = 0,
+    name: str = "HashEmbedding",
+) -> oneflow._oneflow_internal.BlobDesc:
+    r"""Looks int32 or int64 ids up in an embedding table which grows with the ids, so
+    the vocabulary does not have to be known up front. The table maps the ids to their
+    rows by hashing, only the rows of the ids seen are kept, and the embedding of a new
+    id is drawn uniformly from [-initializer_range, initializer_range).
+
+    The table is kept outside of the job and is updated in place by the backward of a
+    train job with `optimizer`, the gradients of the repeated ids are summed first. The
+    update undoes a static loss scale and skips the steps whose gradients are not
+    finite, a dynamic loss scale and gradient accumulation are not supported. The jobs
+    of a session using the same `name` share the table. Only the cpu is supported, and
+    a table does not span machines.
+
+    Args:
+        ids (oneflow._oneflow_internal.BlobDesc): The ids, of any shape.
+        embedding_dim (int): The size of an embedding.
+        combiner (str, optional): "none" returns an embedding for every id. "sum"
+            and "mean" combine the embeddings of the ids of the last axis into one.
+            Defaults to "none".
+        optimizer (str, optional): "sgd" or "adagrad". Defaults to "sgd".
+        learning_rate (float, optional): The learning rate of the optimizer. Defaults to
+            0.01.
+        epsilon (float, optional): The epsilon of adagrad. Defaults to 1e-8.
+        initializer_range (float, optional): The range of the initial embeddings.
+            Defaults to 0.05.
+        seed (int, optional): The seed of the initial embeddings. Defaults to 0.
+        ttl (int, optional): The ids neither looked up nor updated in the last `ttl`
+            updates are evicted, 0 keeps all of them. Defaults to 0.
+        name (str, optional): The name of the table. Defaults to "HashEmbedding".
+
+    Returns:
+        oneflow._oneflow_internal.BlobDesc: The embeddings of shape
+        ids.shape + (embedding_dim,), or ids.shape[:-1] + (embedding_dim,) if they are
+        combined.
+
+    For example:
+
+    .. code-block:: python
+
+        import oneflow as flow
+        import numpy as np
+        import oneflow.typing as tp
+
+        @flow.global_function()
+        def hash_embedding_Job(
+            x: tp.Numpy.Placeholder((2, 3), dtype=flow.int64)
+        ) -> tp.Numpy:
+            with flow.scope.placement("cpu", "0:0"):
+                return flow.layers.hash_embedding(x, 8, combiner="mean")
+
+        x = np.array([[7, 10 ** 12, 2], [-5, 7, 7]]).astype(np.int64)
+        out = hash_embedding_Job(x)
+
+        # out.shape (2, 8)
+
+    """
+    with flow.scope.namespace(name):
+        # The embeddings are not in the variable, it only orders the update of the table
+        # in an iteration before the lookup of the next one.
+        shadow = flow.get_variable(
+            name="Shadow",
+            shape=(1,),
+            dtype=flow.float32,
+            initializer=flow.constant_initializer(0),
+            trainable=True,
+            reuse=True,
+        )
+        return (
+            flow.user_op_builder(id_util.UniqueStr("Lookup_"))
+            .Op("hash_embedding_lookup")
+            .Input("ids", [ids])
+            .Input("shadow", [shadow])
+            .Output("embeddings")
+            .Attr("embedding_name", shadow.op_name)
+            .Attr("embedding_dim", embedding_dim)
+            .Attr("combiner", combiner)
+            .Attr("optimizer", optimizer)
+            .Attr("learning_rate", float(learning_rate))
+            .Attr("epsilon", float(epsilon))
+            .Attr("init_min", -float(initializer_range))
+            .Attr("init_max", float(initializer_range))
+            .Attr("seed", seed)
+            .Attr("ttl", ttl)
+            .Build()
+            .InferAndTryRun()
+            .RemoteBlobList()[0]
+        )
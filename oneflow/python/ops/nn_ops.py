@@ -512,8 +512,10 @@ def conv2d(
     assert inputs.shape[in_channel_axis] % groups == 0
     assert filters.shape[filter_in_axis] == inputs.shape[in_channel_axis] // groups
 
+    # the cpu kernels of grouped NCHW convs run all the groups at once
     if (
         groups > 1
+        and data_format.upper() == "NHWC"
         and flow.current_scope().device_parallel_desc_symbol.device_tag == "cpu"
     ):
         in_split_list = ConvUtil.split(inputs, axis=in_channel_axis, split_num=groups)
@@ -1248,37 +1250,7 @@ def layer_norm(
     if name is None:
         name = id_util.UniqueStr("LayerNorm_")
 
-    if flow.current_scope().device_parallel_desc_symbol.device_tag == "cpu":
-        if begin_norm_axis < 0:
-            begin_norm_axis = begin_norm_axis + len(inputs.shape)
-
-        reduce_axis = []
-        for dim in range(len(inputs.shape)):
-            if dim >= begin_norm_axis:
-                reduce_axis.append(dim)
-        mean, variance = flow.nn.moments(inputs, reduce_axis, keepdims=True)
-
-        axis = begin_norm_axis
-        normalized = flow.nn.batch_normalization(
-            x=inputs,
-            mean=mean,
-            variance=variance,
-            variance_epsilon=epsilon,
-            axis=axis,
-            name=name,
-        )
-        nd_params_shape = [1] * (len(inputs.shape) - len(param_shape)) + list(
-            param_shape
-        )
-        affined = normalized
-        if gamma:
-            gamma = flow.reshape(gamma, nd_params_shape)
-            affined *= gamma
-        if beta:
-            beta = flow.reshape(beta, nd_params_shape)
-            affined += beta
-        return affined
-    elif flow.current_scope().device_parallel_desc_symbol.device_tag == "gpu":
+    if flow.current_scope().device_parallel_desc_symbol.device_tag in ("cpu", "gpu"):
         op_builder = (
             flow.user_op_builder(name)
             .Op("layer_norm")
@@ -1662,14 +1634,21 @@ def max_pool1d(
         data_format (str, optional):  An optional string from: '`NWC'`, '`NCW'`. Defaults to '`NWC'`.
         name (Optional[str], optional): This operator's name(optional).Defaults to None.
 
-    Raises:
-        NotImplementedError: TODO: fix cuDNN bugs in pooling_1d
+    Note:
+        1d pooling runs on the cpu only, placing it on the gpu raises NotImplementedError.
 
     Returns:
         oneflow._oneflow_internal.BlobDesc: A `Blob` of format specified by data_format. The max pooled output `Blob`.
     """
-    # TODO: fix cuDNN bugs in pooling_1d
-    raise NotImplementedError
+    return _pool1d(
+        "max_pool_1d",
+        input,
+        ksize,
+        strides,
+        padding,
+        data_format,
+        name if name is not None else id_util.UniqueStr("MaxPool1D_"),
+    )
 
 
 @oneflow_export("nn.avg_pool1d")
@@ -1691,14 +1670,49 @@ def avg_pool1d(
         data_format (str, optional):  '`NWC'` or '`NCW'`. Defaults to '`NWC'`.
         name (Optional[str], optional):  This operator's name(optional). Defaults to None.
 
-    Raises:
-        NotImplementedError: TODO: fix cuDNN bugs in pooling_1d
+    Note:
+        1d pooling runs on the cpu only, placing it on the gpu raises NotImplementedError.
 
     Returns:
         oneflow._oneflow_internal.BlobDesc: A `Blob` of format specified by data_format. The max pooled output `Blob`.
     """
-    # TODO: fix cuDNN bugs in pooling_1d
-    raise NotImplementedError
+    return _pool1d(
+        "avg_pool_1d",
+        input,
+        ksize,
+        strides,
+        padding,
+        data_format,
+        name if name is not None else id_util.UniqueStr("AvgPool1D_"),
+    )
+
+
+def _max_pool_needs_indice():
+    # the cpu max pool grads scatter to the argmaxes of the forward instead of pooling x again
+    return (
+        flow.current_global_function_desc().IsTrainable()
+        and flow.current_scope().device_parallel_desc_symbol.device_tag == "cpu"
+    )
+
+
+def _pool1d(op_type_name, input, ksize, strides, padding, data_format, name):
+    if flow.current_scope().device_parallel_desc_symbol.device_tag != "cpu":
+        raise NotImplementedError("1d pooling runs on the cpu only")
+    op = flow.user_op_builder(name).Op(op_type_name).Input("x", [input]).Output("y")
+    if op_type_name == "max_pool_1d" and _max_pool_needs_indice():
+        op.Output("indice")
+    assert data_format in ["NWC", "NCW"]
+    channel_pos = "channels_last" if data_format == "NWC" else "channels_first"
+    op.Attr("data_format", channel_pos)
+    op.Attr("pool_size", _GetSequence(ksize, 1, "ksize"))
+    op.Attr("strides", _GetSequence(strides, 1, "strides"))
+    padding_type, pads_list = calc_pool_padding(padding, get_dhw_offset(channel_pos), 1)
+    assert len(pads_list) == len(input.shape) - 2
+    op.Attr("padding", padding_type)
+    op.Attr("padding_before", [pad[0] for pad in pads_list])
+    op.Attr("padding_after", [pad[1] for pad in pads_list])
+    op.Attr("ceil_mode", False)
+    return op.Build().InferAndTryRun().RemoteBlobList()[0]
 
 
 def calc_pool_padding(padding, dhw_offset, ndims):
@@ -1775,6 +1789,8 @@ def max_pool2d(
         .Input("x", [input])
         .Output("y")
     )
+    if _max_pool_needs_indice():
+        op.Output("indice")
     assert data_format in ["NHWC", "NCHW", "NCHW_VECT_C"]
     channel_pos = "channels_last" if data_format == "NHWC" else "channels_first"
     op.Attr("data_format", channel_pos)
@@ -1930,6 +1946,8 @@ def max_pool3d(
         .Input("x", [input])
         .Output("y")
     )
+    if _max_pool_needs_indice():
+        op.Output("indice")
     assert data_format in ["NDHWC", "NCDHW"]
     channel_pos = "channels_last" if data_format == "NDHWC" else "channels_first"
     op.Attr("data_format", channel_pos)
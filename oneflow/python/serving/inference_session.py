@@ -158,6 +158,7 @@ class InferenceSession(object):
         self.inferface_name2info_ = {}
         self.output_name2future_ = {}
         self.job_futures_ = []
+        self.batching_servers_ = []
         self.status_ = None
 
         self._init_event_loop()
@@ -187,6 +188,9 @@ class InferenceSession(object):
         self.status_ = self.SessionStatus.OPEN
 
     def close(self):
+        for server in self.batching_servers_:
+            server.close()
+        self.batching_servers_ = []
         self.event_loop_.run_until_complete(self.wait_for_all_jobs_finished())
         self.event_loop_.close()
 
@@ -419,6 +423,16 @@ class InferenceSession(object):
             output_names.append(output_name)
         return tuple(output_names)
 
+    def _list_job_inputs(self, job_name):
+        # the inputs of the session are those of all its jobs
+        op_names = set()
+        for job in c_api_util.GetJobSet().job:
+            if job.job_conf.job_name == job_name:
+                op_names.update(op_conf.name for op_conf in job.net.op)
+        return tuple(
+            input_name for input_name in self.list_inputs() if input_name in op_names
+        )
+
     def input_info(self, input_name, job_name=None):
         return self._get_op_blob_info(job_name, input_name, "out")
 
@@ -445,6 +459,31 @@ class InferenceSession(object):
         self.inferface_name2info_[op_name] = info
         return info
 
+    def make_batching_server(
+        self, job_name, max_batch_size=None, batch_timeout_us=1000
+    ):
+        r"""Make a native server which coalesces concurrent requests of job_name into batches.
+
+        Args:
+            job_name (str): The job to serve.
+            max_batch_size (int, optional): Max total batch size of the coalesced requests. Defaults to the static batch size of the first input of job_name.
+            batch_timeout_us (int, optional): How long a request may wait for others to batch with, in microseconds. Defaults to 1000.
+
+        The returned server is thread safe, ``server.infer({input_name: ndarray})`` blocks
+        until the outputs of the request are ready and returns them as a dict of ndarrays.
+        """
+        self._check_status(self.SessionStatus.RUNNING)
+        if max_batch_size is None:
+            input_names = self._list_job_inputs(job_name)
+            if len(input_names) == 0:
+                raise ValueError("max_batch_size is required for jobs without inputs")
+            max_batch_size = self.input_info(input_names[0], job_name)["shape"][0]
+        server = oneflow._oneflow_internal.BatchingInferenceServer(
+            job_name, max_batch_size, batch_timeout_us
+        )
+        self.batching_servers_.append(server)
+        return server
+
     def run(self, job_name, **kwargs):
         self._check_status(self.SessionStatus.RUNNING)
         return self.event_loop_.run_until_complete(self.async_run(job_name, **kwargs))
@@ -0,0 +1,108 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import subprocess
+import sys
+import unittest
+from collections import OrderedDict
+
+import numpy as np
+
+import oneflow.experimental as flow
+from test_util import GenArgList
+
+
+def _tensor(np_arr, device, requires_grad=False):
+    return flow.Tensor(
+        np_arr,
+        dtype=flow.float32,
+        device=flow.device(device),
+        requires_grad=requires_grad,
+    )
+
+
+def _test_shared_subgraph_backward(test_case, device):
+    # y feeds two branches joined again, so its node runs once after both of its users
+    np_x = np.random.rand(3, 4)
+    x = _tensor(np_x, device, requires_grad=True)
+    y = x * x
+    z = (y * 2 + y * y).sum()
+    z.backward()
+    np_x_grad = (2 + 2 * np_x * np_x) * 2 * np_x
+    test_case.assertTrue(np.allclose(x.grad.numpy(), np_x_grad, 1e-4, 1e-4))
+
+
+def _test_ancestor_output_backward(test_case, device):
+    # y is both an output of backward and an ancestor of the other output z
+    np_x = np.random.rand(2, 3)
+    x = _tensor(np_x, device, requires_grad=True)
+    y = x * 3
+    z = y * y
+    y_grad = _tensor(np.ones((2, 3)), device)
+    z_grad = _tensor(np.ones((2, 3)), device)
+    flow.autograd.backward((z, y), (z_grad, y_grad))
+    np_x_grad = 3 + 2 * (3 * np_x) * 3
+    test_case.assertTrue(np.allclose(x.grad.numpy(), np_x_grad, 1e-4, 1e-4))
+
+
+def _test_grad_of_intermediate(test_case, device):
+    np_x = np.random.rand(2, 3)
+    x = _tensor(np_x, device, requires_grad=True)
+    y = x * 2
+    z = y * y
+    z_grad = _tensor(np.ones((2, 3)), device)
+    (y_grad,) = flow.autograd.grad(z, y, z_grad, retain_graph=True)
+    test_case.assertTrue(np.allclose(y_grad.numpy(), 4 * np_x, 1e-4, 1e-4))
+    test_case.assertIsNone(x.grad)
+    # the graph is retained, so backward can run through it again
+    z.sum().backward()
+    test_case.assertTrue(np.allclose(x.grad.numpy(), 8 * np_x, 1e-4, 1e-4))
+
+
+@unittest.skipIf(
+    not flow.unittest.env.eager_execution_enabled(),
+    ".numpy() doesn't work in lazy mode",
+)
+class TestAutogradEngine(flow.unittest.TestCase):
+    def test_autograd_engine(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["test_fun"] = [
+            _test_shared_subgraph_backward,
+            _test_ancestor_output_backward,
+            _test_grad_of_intermediate,
+        ]
+        arg_dict["device"] = ["cpu", "cuda"]
+        for arg in GenArgList(arg_dict):
+            arg[0](test_case, *arg[1:])
+
+    @unittest.skipIf(
+        os.getenv("ONEFLOW_AUTOGRAD_ENGINE") is not None,
+        "the engine is already picked by the environment",
+    )
+    def test_both_autograd_engines(test_case):
+        # the engine is picked once per process, so each one runs the cases in its own
+        for engine in ["stack", "graph"]:
+            env = dict(os.environ, ONEFLOW_AUTOGRAD_ENGINE=engine)
+            cmd = [
+                sys.executable,
+                os.path.abspath(__file__),
+                "TestAutogradEngine.test_autograd_engine",
+            ]
+            test_case.assertEqual(subprocess.call(cmd, env=env), 0, engine)
+
+
+if __name__ == "__main__":
+    unittest.main()
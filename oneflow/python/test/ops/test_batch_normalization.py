@@ -340,11 +340,12 @@ def CompareBnWithTensorFlow(
         test_case.assertTrue(np.allclose(of_y, tf_y, rtol=y_rtol, atol=y_atol), msg)
 
 
-def _test_batchnorm_add_relu(test_case, input_shape, axis, data_type):
+def _test_batchnorm_add_relu(test_case, device_type, input_shape, axis, data_type):
     flow.clear_default_session()
     func_config = flow.FunctionConfig()
     func_config.default_logical_view(flow.scope.consistent_view())
     func_config.default_data_type(flow.float32)
+    func_config.default_placement_scope(flow.scope.placement(device_type, "0:0"))
 
     @flow.global_function(type="train", function_config=func_config)
     def test_job(
@@ -421,11 +422,12 @@ def _test_batchnorm_add_relu(test_case, input_shape, axis, data_type):
     test_case.assertTrue(np.allclose(addend1_diff, addend2_diff, rtol=tol, atol=tol))
 
 
-def _test_batchnorm_relu(test_case, input_shape, axis, data_type):
+def _test_batchnorm_relu(test_case, device_type, input_shape, axis, data_type):
     flow.clear_default_session()
     func_config = flow.FunctionConfig()
     func_config.default_logical_view(flow.scope.consistent_view())
     func_config.default_data_type(flow.float32)
+    func_config.default_placement_scope(flow.scope.placement(device_type, "0:0"))
 
     @flow.global_function(type="train", function_config=func_config)
     def test_job(x: oft.Numpy.Placeholder(input_shape, dtype=flow.float32),):
@@ -623,21 +625,41 @@ class TestBatchNormalization(flow.unittest.TestCase):
     @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
     def test_batchnorm_add_relu(test_case):
         arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["gpu"]
         arg_dict["input_shape"] = [(5, 7, 9, 11)]
         arg_dict["axis"] = [0, 1, 2, 3]
         arg_dict["data_type"] = [flow.float32, flow.float16]
         for arg in GenArgDict(arg_dict):
             _test_batchnorm_add_relu(test_case, **arg)
 
+    def test_batchnorm_add_relu_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["input_shape"] = [(5, 7, 9, 11)]
+        arg_dict["axis"] = [0, 1, 2, 3]
+        arg_dict["data_type"] = [flow.float32]
+        for arg in GenArgDict(arg_dict):
+            _test_batchnorm_add_relu(test_case, **arg)
+
     @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
     def test_batchnorm_relu(test_case):
         arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["gpu"]
         arg_dict["input_shape"] = [(12, 16, 24, 32)]
         arg_dict["axis"] = [0, 1, 2, 3]
         arg_dict["data_type"] = [flow.float32, flow.float16]
         for arg in GenArgDict(arg_dict):
             _test_batchnorm_relu(test_case, **arg)
 
+    def test_batchnorm_relu_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["input_shape"] = [(12, 16, 24, 32)]
+        arg_dict["axis"] = [0, 1, 2, 3]
+        arg_dict["data_type"] = [flow.float32]
+        for arg in GenArgDict(arg_dict):
+            _test_batchnorm_relu(test_case, **arg)
+
 
 if __name__ == "__main__":
     unittest.main()
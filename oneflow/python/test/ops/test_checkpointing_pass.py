@@ -0,0 +1,86 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+import test_global_storage
+
+SHAPE = (64, 256)
+FAKE_OP_NAME_PREFIX = "OneFlow-System-Checkpointing-Fake-Fw-Op_"
+
+
+def _get_op_confs(job_name):
+    for job in flow.experimental.get_job_set().job:
+        if job.job_conf.job_name == job_name:
+            return [op for op in job.net.op if op.HasField("user_conf")]
+    raise ValueError("no job named " + job_name)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestCheckpointingPass(flow.unittest.TestCase):
+    def test_random_op_is_not_recomputed(test_case):
+        flow.clear_default_session()
+        func_config = flow.FunctionConfig()
+        func_config.default_logical_view(flow.scope.consistent_view())
+        # recomputes as much as it can
+        func_config.checkpointing_memory_budget_mbyte(0)
+
+        @flow.global_function(type="train", function_config=func_config)
+        def bernoulli_job(
+            x: tp.Numpy.Placeholder(SHAPE), p: tp.Numpy.Placeholder(SHAPE)
+        ) -> tp.Numpy:
+            with flow.scope.placement("cpu", "0:0"):
+                w = flow.get_variable(
+                    "w",
+                    shape=SHAPE[1:],
+                    dtype=flow.float,
+                    initializer=flow.random_uniform_initializer(minval=-1, maxval=1),
+                )
+                h = flow.math.multiply(x, w)
+                mask = flow.random.bernoulli(p)
+                y = flow.math.tanh(flow.math.multiply(h, mask))
+                loss = flow.math.reduce_mean(flow.math.square(y))
+                flow.optimizer.SGD(
+                    flow.optimizer.PiecewiseConstantScheduler([], [0]), momentum=0
+                ).minimize(loss)
+                flow.watch(h, test_global_storage.Setter("h"))
+                flow.watch_diff(h, test_global_storage.Setter("h_diff"))
+                return mask
+
+        rng = np.random.RandomState(0)
+        x = rng.uniform(-1, 1, size=SHAPE).astype(np.float32)
+        p = np.full(SHAPE, 0.5, np.float32)
+        mask = bernoulli_job(x, p)
+        h = test_global_storage.Get("h")
+        y = np.tanh(h * mask)
+        # the backward pass sees the mask of the forward pass
+        expected_h_diff = 2 * y * (1 - y * y) * mask / np.prod(SHAPE)
+        test_case.assertTrue(
+            np.allclose(test_global_storage.Get("h_diff"), expected_h_diff, atol=1e-6)
+        )
+        fake_op_types = [
+            op.user_conf.op_type_name
+            for op in _get_op_confs("bernoulli_job")
+            if op.name.startswith(FAKE_OP_NAME_PREFIX)
+        ]
+        test_case.assertGreater(len(fake_op_types), 0)
+        test_case.assertNotIn("bernoulli", fake_op_types)
+
+
+if __name__ == "__main__":
+    unittest.main()
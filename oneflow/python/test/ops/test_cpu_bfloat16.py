@@ -0,0 +1,133 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+from collections import OrderedDict
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+import test_global_storage
+from test_util import GenArgList
+
+
+def _round_to_bfloat16(x):
+    # round to nearest even on the upper 16 bits of the float32
+    bits = x.astype(np.float32).view(np.uint32).astype(np.uint64)
+    bits = (bits + 0x7FFF + ((bits >> 16) & 1)) & 0xFFFF0000
+    return bits.astype(np.uint32).view(np.float32)
+
+
+def _test_cast(test_case, shape):
+    flow.clear_default_session()
+
+    @flow.global_function()
+    def cast_job(x: tp.Numpy.Placeholder(shape)) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            return flow.cast(flow.cast(x, dtype=flow.bfloat16), dtype=flow.float)
+
+    x = (np.random.randn(*shape) * 100).astype(np.float32)
+    test_case.assertTrue(np.array_equal(cast_job(x), _round_to_bfloat16(x)))
+
+
+def _test_matmul(test_case, transpose_a, transpose_b):
+    flow.clear_default_session()
+    m, n, k = 7, 9, 37
+    a_shape = (k, m) if transpose_a else (m, k)
+    b_shape = (n, k) if transpose_b else (k, n)
+
+    @flow.global_function()
+    def matmul_job(
+        a: tp.Numpy.Placeholder(a_shape), b: tp.Numpy.Placeholder(b_shape)
+    ) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            out = flow.matmul(
+                flow.cast(a, dtype=flow.bfloat16),
+                flow.cast(b, dtype=flow.bfloat16),
+                transpose_a=transpose_a,
+                transpose_b=transpose_b,
+            )
+            return flow.cast(out, dtype=flow.float)
+
+    a = np.random.randn(*a_shape).astype(np.float32)
+    b = np.random.randn(*b_shape).astype(np.float32)
+    a_rounded = _round_to_bfloat16(a)
+    b_rounded = _round_to_bfloat16(b)
+    ref = np.matmul(
+        a_rounded.T if transpose_a else a_rounded,
+        b_rounded.T if transpose_b else b_rounded,
+    )
+    # accumulated in float, only the result is rounded to bfloat16
+    test_case.assertTrue(np.allclose(matmul_job(a, b), ref, rtol=1e-2, atol=1e-2))
+
+
+def _test_auto_mixed_precision(test_case):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.enable_cpu_auto_mixed_precision(True)
+
+    @flow.global_function(type="train", function_config=func_config)
+    def train_job(x: tp.Numpy.Placeholder((8, 16))) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            w = flow.get_variable(
+                "w",
+                shape=(16, 4),
+                dtype=flow.float,
+                initializer=flow.random_uniform_initializer(minval=-1, maxval=1),
+                trainable=True,
+            )
+            flow.watch(w, test_global_storage.Setter("w"))
+            flow.watch_diff(w, test_global_storage.Setter("w_diff"))
+            y = flow.nn.relu(flow.matmul(x, w))
+            loss = flow.math.reduce_sum(y)
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [1e-3]), momentum=0
+            ).minimize(loss)
+            return loss
+
+    x = np.random.randn(8, 16).astype(np.float32)
+    loss = train_job(x)
+    w = test_global_storage.Get("w")
+    w_diff = test_global_storage.Get("w_diff")
+    # the variable and its gradient stay in float32
+    test_case.assertEqual(w.dtype, np.float32)
+    test_case.assertEqual(w_diff.dtype, np.float32)
+    x_rounded = _round_to_bfloat16(x)
+    z = np.matmul(x_rounded, _round_to_bfloat16(w))
+    test_case.assertTrue(np.allclose(loss, np.maximum(z, 0).sum(), rtol=2e-2))
+    ref_w_diff = np.matmul(x_rounded.T, (z > 0).astype(np.float32))
+    test_case.assertTrue(np.allclose(w_diff, ref_w_diff, rtol=2e-2, atol=2e-2))
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestCpuBFloat16(flow.unittest.TestCase):
+    def test_cast(test_case):
+        for shape in [(5, 4, 3), (1027,)]:
+            _test_cast(test_case, shape)
+
+    def test_matmul(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["transpose_a"] = [True, False]
+        arg_dict["transpose_b"] = [True, False]
+        for arg in GenArgList(arg_dict):
+            _test_matmul(test_case, *arg)
+
+    def test_auto_mixed_precision(test_case):
+        _test_auto_mixed_precision(test_case)
+
+
+if __name__ == "__main__":
+    unittest.main()
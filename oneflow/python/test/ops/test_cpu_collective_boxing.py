@@ -0,0 +1,99 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+
+def _make_job(device_num, chunk_size_kb, halving_doubling_threshold_kb, m, k, n):
+    flow.clear_default_session()
+    flow.config.cpu_device_num(device_num)
+    flow.config.collective_boxing.cpu_enable_collective_boxing(True)
+    flow.config.collective_boxing.cpu_chunk_size_kb(chunk_size_kb)
+    flow.config.collective_boxing.cpu_halving_doubling_threshold_kb(
+        halving_doubling_threshold_kb
+    )
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+
+    @flow.global_function(function_config=func_config)
+    def collective_job(
+        a: oft.Numpy.Placeholder((m, k)),
+        b: oft.Numpy.Placeholder((k, n)),
+        x: oft.Numpy.Placeholder((m, n)),
+    ):
+        placement = "0:0-" + str(device_num - 1)
+        with flow.scope.placement("cpu", placement):
+            a = flow.hierarchical_parallel_cast(a, parallel_distribution=["S(1)"])
+            b = flow.hierarchical_parallel_cast(b, parallel_distribution=["S(0)"])
+            # P -> B
+            all_reduce = flow.hierarchical_parallel_cast(
+                flow.matmul(a, b), parallel_distribution=["B"]
+            )
+            # P -> S(0)
+            reduce_scatter = flow.hierarchical_parallel_cast(
+                flow.matmul(a, b), parallel_distribution=["S(0)"]
+            )
+            # S(0) -> B
+            all_gather = flow.hierarchical_parallel_cast(
+                flow.identity(x.with_distribute(flow.distribute.split(0))),
+                parallel_distribution=["B"],
+            )
+        with flow.scope.placement("cpu", "0:0"):
+            src = flow.identity(x)
+        # 1 -> B
+        with flow.scope.placement("cpu", placement):
+            broadcast = flow.identity(src.with_distribute(flow.distribute.broadcast()))
+        return all_reduce, reduce_scatter, all_gather, broadcast
+
+    return collective_job
+
+
+def _test_cpu_collective_boxing(
+    test_case, chunk_size_kb, halving_doubling_threshold_kb, m
+):
+    device_num, k, n = 4, 4, 96
+    job = _make_job(device_num, chunk_size_kb, halving_doubling_threshold_kb, m, k, n)
+    a = np.random.rand(m, k).astype(np.float32)
+    b = np.random.rand(k, n).astype(np.float32)
+    x = np.random.rand(m, n).astype(np.float32)
+    all_reduce, reduce_scatter, all_gather, broadcast = job(a, b, x).get()
+    expected = np.matmul(a, b)
+    test_case.assertTrue(np.allclose(all_reduce.numpy(), expected, rtol=1e-4))
+    test_case.assertTrue(np.allclose(reduce_scatter.numpy(), expected, rtol=1e-4))
+    test_case.assertTrue(np.array_equal(all_gather.numpy(), x))
+    test_case.assertTrue(np.array_equal(broadcast.numpy(), x))
+
+
+@flow.unittest.skip_unless_1n4d()
+class TestCpuCollectiveBoxing(flow.unittest.TestCase):
+    def test_ring(test_case):
+        # segments of 1536 elements in 6 chunks of 1 KB
+        _test_cpu_collective_boxing(test_case, 1, 0, 64)
+
+    def test_halving_doubling(test_case):
+        _test_cpu_collective_boxing(test_case, 1024, 1024, 64)
+
+    def test_partial_chunk(test_case):
+        # segments of 288 elements, a full chunk of 256 and a partial one of 32
+        _test_cpu_collective_boxing(test_case, 1, 0, 12)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,129 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+import os
+from collections import OrderedDict
+
+import numpy as np
+import oneflow as flow
+from test_util import GenArgList
+import oneflow.typing as oft
+
+
+def _batch_normalization(x, axis, name):
+    return flow.layers.batch_normalization(
+        x,
+        axis=axis,
+        beta_initializer=flow.random_uniform_initializer(-1, 1),
+        gamma_initializer=flow.random_uniform_initializer(0.5, 1.5),
+        moving_mean_initializer=flow.random_uniform_initializer(-1, 1),
+        moving_variance_initializer=flow.random_uniform_initializer(0.5, 1.5),
+        training=False,
+        name=name,
+    )
+
+
+def _get_op_type_names(job_name):
+    for job in flow.experimental.get_job_set().job:
+        if job.job_conf.job_name == job_name:
+            return [
+                op.user_conf.op_type_name
+                for op in job.net.op
+                if op.HasField("user_conf")
+            ]
+    raise ValueError("no job named " + job_name)
+
+
+def _run_conv_dense_bn_job(device_type, data_format, use_bias, fold, x, variables):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.enable_fold_normalization(fold)
+
+    @flow.global_function(type="predict", function_config=func_config)
+    def ConvDenseBnJob(x: oft.Numpy.Placeholder(x.shape)):
+        with flow.scope.placement(device_type, "0:0"):
+            y = flow.layers.conv2d(
+                x,
+                8,
+                kernel_size=3,
+                padding="SAME",
+                data_format=data_format,
+                use_bias=use_bias,
+                kernel_initializer=flow.random_uniform_initializer(-1, 1),
+                bias_initializer=flow.random_uniform_initializer(-1, 1),
+                name="conv",
+            )
+            y = _batch_normalization(y, 1 if data_format == "NCHW" else -1, "bn0")
+            y = flow.reshape(flow.math.relu(y), (x.shape[0], -1))
+            y = flow.layers.dense(
+                y,
+                16,
+                use_bias=use_bias,
+                kernel_initializer=flow.random_uniform_initializer(-0.1, 0.1),
+                bias_initializer=flow.random_uniform_initializer(-1, 1),
+                name="dense",
+            )
+            return _batch_normalization(y, 1, "bn1")
+
+    if variables is not None:
+        flow.load_variables(variables)
+    y = ConvDenseBnJob(x).get().numpy()
+    if variables is None:
+        variables = {k: v.numpy() for k, v in flow.get_all_variables().items()}
+    return y, variables, _get_op_type_names("ConvDenseBnJob")
+
+
+def _test_fold_normalization(test_case, device_type, data_format, use_bias):
+    if data_format == "NCHW":
+        x = np.random.uniform(-1, 1, (4, 3, 10, 10)).astype(np.float32)
+    else:
+        x = np.random.uniform(-1, 1, (4, 10, 10, 3)).astype(np.float32)
+    y, variables, op_type_names = _run_conv_dense_bn_job(
+        device_type, data_format, use_bias, False, x, None
+    )
+    test_case.assertEqual(op_type_names.count("normalization"), 2)
+    folded_y, _, folded_op_type_names = _run_conv_dense_bn_job(
+        device_type, data_format, use_bias, True, x, variables
+    )
+    # both normalizations are folded into the weights and biases of conv and dense
+    test_case.assertNotIn("normalization", folded_op_type_names)
+    test_case.assertEqual(folded_op_type_names.count("broadcast_mul"), 2)
+    test_case.assertTrue(np.allclose(y, folded_y, rtol=1e-4, atol=1e-4))
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestFoldNormalization(flow.unittest.TestCase):
+    def test_fold_normalization_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["data_format"] = ["NCHW", "NHWC"]
+        arg_dict["use_bias"] = [True, False]
+        for arg in GenArgList(arg_dict):
+            _test_fold_normalization(test_case, *arg)
+
+    @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
+    def test_fold_normalization_gpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["gpu"]
+        arg_dict["data_format"] = ["NCHW", "NHWC"]
+        arg_dict["use_bias"] = [True, False]
+        for arg in GenArgList(arg_dict):
+            _test_fold_normalization(test_case, *arg)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -148,6 +148,15 @@ class TestFusedBiasAdd(flow.unittest.TestCase):
                 continue
             compare_with_not_fused(test_case, *arg)
 
+    def test_fused_bias_add_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["x_shape"] = [(10, 10), (10, 5), (2, 10, 10, 10), (8, 3072)]
+        arg_dict["data_type"] = ["float32", "double"]
+        arg_dict["data_format"] = ["NCHW"]
+        for arg in GenArgList(arg_dict):
+            compare_with_not_fused(test_case, *arg)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -124,6 +124,17 @@ class TestFusedScaleTril(flow.unittest.TestCase):
                 continue
             _test_fused_scale_tril_fw_bw(test_case, **arg)
 
+    def test_fused_scale_tril_fw_bw_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device"] = ["cpu"]
+        arg_dict["type_name"] = ["float32", "double", "int32", "int64"]
+        arg_dict["shape"] = [(3, 6, 8)]
+        arg_dict["diagonal"] = [-8, -1, 0, 8]
+        arg_dict["fill_value"] = [1.0, 0]
+        arg_dict["scale"] = [5.0, 3]
+        for arg in GenArgDict(arg_dict):
+            _test_fused_scale_tril_fw_bw(test_case, **arg)
+
 
 if __name__ == "__main__":
     unittest.main()
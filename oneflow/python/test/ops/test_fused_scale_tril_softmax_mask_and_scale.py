@@ -149,6 +149,19 @@ class TestFusedScaleTrilSoftmaxDropout(flow.unittest.TestCase):
                 continue
             compare_with_not_fused(test_case, *arg)
 
+    def test_fused_scale_tril_softmax_dropout_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["x_shape"] = [(2, 2, 5, 5), (10, 20), (32, 12, 128)]
+        arg_dict["data_type"] = ["float32", "double"]
+        arg_dict["diagonal"] = [-1, 0]
+        arg_dict["fill_value"] = [float("-inf"), 0]
+        arg_dict["scale"] = [0.125]
+        arg_dict["rate"] = [0.5]
+        arg_dict["seed"] = [12345]
+        for arg in GenArgList(arg_dict):
+            compare_with_not_fused(test_case, *arg)
+
 
 if __name__ == "__main__":
     unittest.main()
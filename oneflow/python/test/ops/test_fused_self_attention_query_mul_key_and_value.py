@@ -21,9 +21,9 @@ import oneflow as flow
 import test_global_storage
 
 
-def get_func_conf():
+def get_func_conf(device_type):
     func_conf = flow.FunctionConfig()
-    func_conf.default_placement_scope(flow.scope.placement("gpu", "0:0"))
+    func_conf.default_placement_scope(flow.scope.placement(device_type, "0:0"))
     return func_conf
 
 
@@ -36,11 +36,13 @@ def get_alpha(head_size):
     return 1.0
 
 
-def make_self_attn_qk_v_func(batch_size, seq_len, num_heads, head_size, fused, fp16):
+def make_self_attn_qk_v_func(
+    batch_size, seq_len, num_heads, head_size, fused, fp16, device_type="gpu"
+):
     flow.clear_default_session()
     hidden_size = num_heads * 3 * head_size
 
-    @flow.global_function(type="predict", function_config=get_func_conf())
+    @flow.global_function(type="predict", function_config=get_func_conf(device_type))
     def self_attn_qk_v_fw_bw(
         h: flow.typing.Numpy.Placeholder(
             shape=(seq_len, batch_size, hidden_size), dtype=flow.float32
@@ -101,7 +103,14 @@ def gen_random_input(shape):
 
 
 def compare_fused_with_no_fused(
-    test_case, batch_size, seq_len, num_heads, head_size, fp16, verbose=False
+    test_case,
+    batch_size,
+    seq_len,
+    num_heads,
+    head_size,
+    fp16,
+    verbose=False,
+    device_type="gpu",
 ):
     hidden_size = num_heads * 3 * head_size
 
@@ -109,13 +118,13 @@ def compare_fused_with_no_fused(
 
     # fused op
     func = make_self_attn_qk_v_func(
-        batch_size, seq_len, num_heads, head_size, True, fp16
+        batch_size, seq_len, num_heads, head_size, True, fp16, device_type
     )
     qmk, v = func(input)
 
     # unfused op
     func_ = make_self_attn_qk_v_func(
-        batch_size, seq_len, num_heads, head_size, False, fp16
+        batch_size, seq_len, num_heads, head_size, False, fp16, device_type
     )
     qmk_, v_ = func_(input)
 
@@ -183,8 +192,8 @@ def np_bgemm(a, b, alpha):
 
 
 @flow.unittest.skip_unless_1n1d()
-@unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
 class TestFusedSelfAttentionQueryMulKeyAndValue(flow.unittest.TestCase):
+    @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
     def test_fp32(self):
         if flow.eager_execution_enabled():
             print("\nSkip under erger mode!")
@@ -193,6 +202,7 @@ class TestFusedSelfAttentionQueryMulKeyAndValue(flow.unittest.TestCase):
         compare_fused_with_no_fused(self, 4, 1024, 12, 64, False)
         # compare_fused_with_no_fused(self, 1, 2, 1, 3, False)
 
+    @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
     def test_fp16(self):
         if flow.eager_execution_enabled():
             print("\nSkip under erger mode!")
@@ -200,6 +210,13 @@ class TestFusedSelfAttentionQueryMulKeyAndValue(flow.unittest.TestCase):
 
         compare_fused_with_no_fused(self, 4, 1024, 12, 64, True)
 
+    def test_fp32_cpu(self):
+        if flow.eager_execution_enabled():
+            print("\nSkip under erger mode!")
+            return
+
+        compare_fused_with_no_fused(self, 2, 128, 12, 64, False, device_type="cpu")
+
 
 if __name__ == "__main__":
     unittest.main()
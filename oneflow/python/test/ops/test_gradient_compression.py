@@ -0,0 +1,84 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+
+def _train_linear_regression(rule, steps=100, batch_size=32, num_features=64):
+    flow.clear_default_session()
+    flow.config.cpu_device_num(2)
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+    if rule is not None:
+        # the two ranks are on the same machine in the test
+        func_config.gradient_compression_conf(
+            {"rule": [rule], "compress_intra_machine": True, "min_elem_cnt": 0}
+        )
+
+    @flow.global_function(type="train", function_config=func_config)
+    def train_job(
+        x: oft.Numpy.Placeholder((batch_size, num_features)),
+        y: oft.Numpy.Placeholder((batch_size, 1)),
+    ) -> oft.Numpy:
+        with flow.scope.placement("cpu", "0:0-1"):
+            w = flow.get_variable(
+                "w", shape=(num_features, 1), initializer=flow.zeros_initializer()
+            )
+            loss = flow.math.reduce_mean(flow.math.square(flow.matmul(x, w) - y))
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [0.05]), momentum=0
+            ).minimize(loss)
+        return loss
+
+    rng = np.random.RandomState(0)
+    true_w = rng.randn(num_features, 1).astype(np.float32)
+    losses = []
+    for _ in range(steps):
+        x = rng.randn(batch_size, num_features).astype(np.float32)
+        losses.append(float(train_job(x, np.matmul(x, true_w))))
+    return np.array(losses)
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestGradientCompression(flow.unittest.TestCase):
+    def test_half(test_case):
+        baseline = _train_linear_regression(None)
+        losses = _train_linear_regression({"half_conf": {}})
+        test_case.assertTrue(np.allclose(losses, baseline, rtol=1e-2, atol=1e-3))
+
+    def test_top_k(test_case):
+        losses = _train_linear_regression({"top_k_conf": {"ratio": 0.25}})
+        test_case.assertLess(losses[-10:].mean(), 0.1 * losses[0])
+
+    def test_one_bit(test_case):
+        losses = _train_linear_regression({"one_bit_conf": {}})
+        test_case.assertLess(losses[-10:].mean(), 0.1 * losses[0])
+
+    def test_per_variable_rule(test_case):
+        # a rule naming another variable leaves the gradient of w uncompressed
+        baseline = _train_linear_regression(None, steps=10)
+        losses = _train_linear_regression(
+            {"variable_op_names": ["other"], "one_bit_conf": {}}, steps=10
+        )
+        test_case.assertTrue(np.allclose(losses, baseline))
+
+
+if __name__ == "__main__":
+    unittest.main()
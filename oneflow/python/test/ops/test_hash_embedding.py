@@ -0,0 +1,148 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+from collections import OrderedDict
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+from test_util import GenArgList
+
+ids_shape = (16, 4)
+embedding_dim = 8
+learning_rate = 0.1
+epsilon = 1e-3
+
+
+def _make_jobs(dtype, combiner, optimizer, loss_scale_factor):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+
+    def lookup(ids, combiner):
+        with flow.scope.placement("cpu", "0:0"):
+            return flow.layers.hash_embedding(
+                ids,
+                embedding_dim,
+                combiner=combiner,
+                optimizer=optimizer,
+                learning_rate=learning_rate,
+                epsilon=epsilon,
+                initializer_range=0.5,
+            )
+
+    out_shape = ids_shape if combiner == "none" else ids_shape[:-1]
+
+    @flow.global_function(type="train", function_config=func_config)
+    def train_job(
+        ids: oft.Numpy.Placeholder(ids_shape, dtype=dtype),
+        weight: oft.Numpy.Placeholder(out_shape + (embedding_dim,)),
+    ) -> oft.Numpy:
+        embeddings = lookup(ids, combiner)
+        loss = flow.math.reduce_sum(embeddings * weight)
+        flow.optimizer.SGD(
+            flow.optimizer.PiecewiseConstantScheduler([], [0.0]),
+            momentum=0,
+            loss_scale_factor=loss_scale_factor,
+        ).minimize(loss)
+        return embeddings
+
+    # shares the table of the train job, and reads the embeddings of all the ids
+    @flow.global_function(type="predict", function_config=func_config)
+    def predict_job(ids: oft.Numpy.Placeholder(ids_shape, dtype=dtype)) -> oft.Numpy:
+        return lookup(ids, "none")
+
+    return train_job, predict_job, out_shape
+
+
+def _compare_with_numpy(test_case, dtype, combiner, optimizer, loss_scale_factor=None):
+    train_job, predict_job, out_shape = _make_jobs(
+        dtype, combiner, optimizer, loss_scale_factor
+    )
+    np_dtype = flow.convert_oneflow_dtype_to_numpy_dtype(dtype)
+    table = {}
+    sum_of_squares = {}
+    for step in range(4):
+        ids = np.random.randint(-40, 40, size=ids_shape).astype(np_dtype)
+        ids[0, 0] = np.iinfo(np_dtype).max
+        ids[0, 1] = np.iinfo(np_dtype).min
+        embeddings = predict_job(ids)
+        for i, e in zip(ids.flatten(), embeddings.reshape(-1, embedding_dim)):
+            if i not in table:
+                test_case.assertTrue(np.all(np.abs(e) <= 0.5))
+                table[i] = e.copy()
+                sum_of_squares[i] = np.zeros(embedding_dim, np.float32)
+        expected = np.stack([table[i] for i in ids.flatten()])
+        test_case.assertTrue(
+            np.allclose(embeddings, expected.reshape(embeddings.shape), atol=1e-5)
+        )
+        weight = np.random.uniform(-1, 1, size=out_shape + (embedding_dim,))
+        weight = weight.astype(np.float32)
+        # the scaled diffs of the third step overflow, which must leave the table as is
+        overflow = loss_scale_factor is not None and step == 2
+        if overflow:
+            weight[0, 0] = 1e35
+        out = train_job(ids, weight)
+        # the table is updated after the embeddings are fetched
+        flow.sync_default_session()
+        if combiner == "none":
+            test_case.assertTrue(np.allclose(out, embeddings, atol=1e-5))
+            diff = weight
+        elif combiner == "sum":
+            test_case.assertTrue(np.allclose(out, embeddings.sum(axis=-2), atol=1e-5))
+            diff = np.repeat(weight[..., np.newaxis, :], ids_shape[-1], axis=-2)
+        else:
+            test_case.assertTrue(np.allclose(out, embeddings.mean(axis=-2), atol=1e-5))
+            diff = np.repeat(weight[..., np.newaxis, :], ids_shape[-1], axis=-2)
+            diff = diff / ids_shape[-1]
+        if overflow:
+            continue
+        grads = {}
+        for i, g in zip(ids.flatten(), diff.reshape(-1, embedding_dim)):
+            grads[i] = grads.get(i, 0) + g
+        for i, g in grads.items():
+            if optimizer == "sgd":
+                table[i] = table[i] - learning_rate * g
+            else:
+                sum_of_squares[i] = sum_of_squares[i] + g * g
+                table[i] = table[i] - learning_rate * g / (
+                    np.sqrt(sum_of_squares[i]) + epsilon
+                )
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestHashEmbedding(flow.unittest.TestCase):
+    def test_hash_embedding(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["dtype"] = [flow.int32, flow.int64]
+        arg_dict["combiner"] = ["none", "sum", "mean"]
+        arg_dict["optimizer"] = ["sgd", "adagrad"]
+        for arg in GenArgList(arg_dict):
+            _compare_with_numpy(test_case, *arg)
+
+    def test_hash_embedding_with_loss_scale(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["dtype"] = [flow.int64]
+        arg_dict["combiner"] = ["none", "mean"]
+        arg_dict["optimizer"] = ["sgd", "adagrad"]
+        arg_dict["loss_scale_factor"] = [1024.0]
+        for arg in GenArgList(arg_dict):
+            _compare_with_numpy(test_case, *arg)
+
+
+if __name__ == "__main__":
+    unittest.main()
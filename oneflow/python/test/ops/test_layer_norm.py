@@ -36,6 +36,7 @@ class TestLayerNorm(flow.unittest.TestCase):
     def test_layer_norm(_):
         confs = [
             {"x_shape": (40, 64), "begin_norm_axis": -1, "begin_params_axis": -1},
+            {"x_shape": (4, 5, 37), "begin_norm_axis": -1, "begin_params_axis": -1},
         ]
         arg_dict = OrderedDict()
         arg_dict["device_type"] = ["cpu", "gpu"]
@@ -60,8 +61,6 @@ class TestLayerNorm(flow.unittest.TestCase):
             ) = case
             if device_type == "cpu" and data_type == "float16":
                 continue
-            if device_type == "cpu" and fuse_add_to_output == True:
-                continue
             x_shape = confs["x_shape"]
             begin_norm_axis = confs["begin_norm_axis"]
             begin_params_axis = confs["begin_params_axis"]
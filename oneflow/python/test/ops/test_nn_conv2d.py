@@ -63,11 +63,13 @@ def compare_with_tensorflow(
     data_format="NCHW",
     padding="VALID",
     stride=1,
+    cpu_conv_heuristic_search_algo=True,
 ):
     assert device_type in ["gpu", "cpu"]
     flow.clear_default_session()
     func_config = flow.FunctionConfig()
     func_config.default_data_type(flow.float)
+    func_config.cpu_conv_heuristic_search_algo(cpu_conv_heuristic_search_algo)
     if data_format == "NCHW":
         xy_data_transpose = (0, 2, 3, 1)
         weight_data_transpose = (2, 3, 1, 0)
@@ -207,6 +209,55 @@ class TestNnConv2d(flow.unittest.TestCase):
         for arg in GenArgList(arg_dict):
             compare_with_tensorflow(*arg)
 
+    def test_cpu_1x1(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["x_shape"] = [(4, 32, 14, 14)]
+        arg_dict["filters"] = [64]
+        arg_dict["kernel_size"] = [1]
+        arg_dict["groups"] = [1]
+        arg_dict["data_format"] = ["NCHW", "NHWC"]
+        for arg in GenArgList(arg_dict):
+            compare_with_tensorflow(*arg)
+
+    def test_cpu_winograd(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        # F(4x4, 3x3) for the 20x20 input, F(2x2, 3x3) for the 6x6 one
+        arg_dict["x_shape"] = [(4, 16, 20, 20), (4, 16, 6, 6)]
+        arg_dict["filters"] = [32]
+        arg_dict["kernel_size"] = [3]
+        arg_dict["groups"] = [1]
+        arg_dict["data_format"] = ["NCHW"]
+        arg_dict["padding"] = ["VALID", "SAME"]
+        for arg in GenArgList(arg_dict):
+            compare_with_tensorflow(*arg)
+
+    def test_cpu_autotune(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["x_shape"] = [(4, 16, 20, 20)]
+        arg_dict["filters"] = [32]
+        arg_dict["kernel_size"] = [1, 3]
+        arg_dict["groups"] = [1]
+        arg_dict["data_format"] = ["NCHW"]
+        arg_dict["padding"] = ["SAME"]
+        arg_dict["stride"] = [1]
+        arg_dict["cpu_conv_heuristic_search_algo"] = [False]
+        for arg in GenArgList(arg_dict):
+            compare_with_tensorflow(*arg)
+
+    def test_cpu_depthwise(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["x_shape"] = [(4, 32, 20, 20)]
+        arg_dict["filters"] = [32, 64]
+        arg_dict["kernel_size"] = [3]
+        arg_dict["groups"] = [32]
+        arg_dict["data_format"] = ["NCHW"]
+        for arg in GenArgList(arg_dict):
+            compare_with_tensorflow(*arg)
+
     def test_conv1(test_case):
         arg_dict = OrderedDict()
         arg_dict["device_type"] = ["gpu"]
@@ -0,0 +1,95 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import shutil
+import tempfile
+import unittest
+from collections import OrderedDict
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+from test_util import GenArgList
+
+shape = (8, 4)
+learning_rate = 0.1
+
+
+def _make_func_config():
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+    return func_config
+
+
+def _make_jobs(device_type):
+    def scale(x):
+        with flow.scope.placement(device_type, "0:0"):
+            w = flow.get_variable(
+                "w",
+                shape=shape[1:],
+                dtype=flow.float32,
+                initializer=flow.constant_initializer(1),
+            )
+            return x * w
+
+    train_config = _make_func_config()
+    train_config.offload_conf({"variable_op_names": ["w"]})
+
+    @flow.global_function(type="train", function_config=train_config)
+    def train_job(x: oft.Numpy.Placeholder(shape)) -> oft.Numpy:
+        loss = flow.math.reduce_sum(scale(x))
+        flow.optimizer.SGD(
+            flow.optimizer.PiecewiseConstantScheduler([], [learning_rate]), momentum=0
+        ).minimize(loss)
+        return loss
+
+    # does not offload the variable it shares with the train job
+    @flow.global_function(type="predict", function_config=_make_func_config())
+    def eval_job(x: oft.Numpy.Placeholder(shape)) -> oft.Numpy:
+        return scale(x)
+
+    return train_job, eval_job
+
+
+def _test_offload_shared_variable(test_case, device_type):
+    flow.clear_default_session()
+    offload_file_dir = tempfile.mkdtemp()
+    flow.config.offload_file_dir(offload_file_dir)
+    train_job, eval_job = _make_jobs(device_type)
+    w = np.ones(shape[1:], np.float32)
+    for _ in range(4):
+        x = np.random.uniform(-1, 1, size=shape).astype(np.float32)
+        test_case.assertTrue(np.allclose(eval_job(x), x * w, atol=1e-5))
+        train_job(x)
+        w = w - learning_rate * x.sum(axis=0)
+    flow.sync_default_session()
+    x = np.random.uniform(-1, 1, size=shape).astype(np.float32)
+    test_case.assertTrue(np.allclose(eval_job(x), x * w, atol=1e-5))
+    flow.clear_default_session()
+    shutil.rmtree(offload_file_dir)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestOffload(flow.unittest.TestCase):
+    def test_offload_shared_variable(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu", "gpu"]
+        for arg in GenArgList(arg_dict):
+            _test_offload_shared_variable(test_case, *arg)
+
+
+if __name__ == "__main__":
+    unittest.main()
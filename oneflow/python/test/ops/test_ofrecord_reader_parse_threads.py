@@ -0,0 +1,82 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import struct
+import tempfile
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.core.record.record_pb2 as record_pb
+import oneflow.typing as tp
+
+num_records = 10
+value_size = 3
+batch_size = 4
+
+
+def _write_ofrecord_part(data_dir):
+    with open(os.path.join(data_dir, "part-0"), "wb") as f:
+        for i in range(num_records):
+            record = record_pb.OFRecord()
+            values = [i * value_size + j for j in range(value_size)]
+            record.feature["value"].int32_list.value.extend(values)
+            serialized = record.SerializeToString()
+            f.write(struct.pack("q", len(serialized)))
+            f.write(serialized)
+
+
+def _read_batches(data_dir, num_parse_threads, num_batches):
+    flow.clear_default_session()
+
+    @flow.global_function(type="predict")
+    def read_job() -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            ofrecord = flow.data.ofrecord_reader(
+                data_dir,
+                batch_size=batch_size,
+                data_part_num=1,
+                num_parse_threads=num_parse_threads,
+                prefetch_buffer_size=2,
+                stats_log_interval=2,
+            )
+            return flow.data.OFRecordRawDecoder(
+                ofrecord, "value", shape=(value_size,), dtype=flow.int32
+            )
+
+    return [read_job() for _ in range(num_batches)]
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestOFRecordReaderParseThreads(flow.unittest.TestCase):
+    def test_parse_threads_keep_order_and_contents(test_case):
+        # more batches than records, so the reads wrap around the epoch
+        num_batches = 6
+        with tempfile.TemporaryDirectory() as data_dir:
+            _write_ofrecord_part(data_dir)
+            inline_batches = _read_batches(data_dir, 0, num_batches)
+            for num_parse_threads in (1, 4):
+                batches = _read_batches(data_dir, num_parse_threads, num_batches)
+                for inline_batch, batch in zip(inline_batches, batches):
+                    test_case.assertTrue(np.array_equal(inline_batch, batch))
+        for i, batch in enumerate(inline_batches):
+            indices = np.arange(i * batch_size, (i + 1) * batch_size) % num_records
+            expected = indices[:, np.newaxis] * value_size + np.arange(value_size)
+            test_case.assertTrue(np.array_equal(batch, expected))
+
+
+if __name__ == "__main__":
+    unittest.main()
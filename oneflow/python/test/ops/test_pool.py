@@ -15,7 +15,6 @@ limitations under the License.
 """
 import unittest
 import collections
-import os
 from collections import OrderedDict
 
 import numpy as np
@@ -23,6 +22,7 @@ import oneflow as flow
 import tensorflow as tf
 from test_util import GenArgList, type_name_to_flow_type, type_name_to_np_type
 import oneflow.typing as oft
+from oneflow.python.ops.nn_ops import calc_pool_padding, get_dhw_offset
 
 gpus = tf.config.experimental.list_physical_devices("GPU")
 for gpu in gpus:
@@ -115,6 +115,48 @@ pool_confs = [
     },
 ]
 
+CHANNELS_LAST = ["NWC", "NHWC", "NDHWC"]
+
+# the 1d pools, the channels_last 3d pools and more channels than the cpu kernels
+# scatter to at once are only run on the cpu
+cpu_pool_confs = [
+    {
+        "x_shape": (2, 9, 5),
+        "ksize": 3,
+        "strides": 2,
+        "padding": "SAME",
+        "data_format": "NWC",
+    },
+    {
+        "x_shape": (2, 5, 9),
+        "ksize": 2,
+        "strides": 1,
+        "padding": "VALID",
+        "data_format": "NCW",
+    },
+    {
+        "x_shape": (2, 9, 9, 80),
+        "ksize": 3,
+        "strides": 2,
+        "padding": "SAME",
+        "data_format": "NHWC",
+    },
+    {
+        "x_shape": (3, 16, 10, 10),
+        "ksize": 3,
+        "strides": 1,
+        "padding": "SAME",
+        "data_format": "NCHW",
+    },
+    {
+        "x_shape": (1, 5, 6, 7, 3),
+        "ksize": (2, 3, 2),
+        "strides": (1, 2, 2),
+        "padding": "SAME",
+        "data_format": "NDHWC",
+    },
+]
+
 
 def _GetSequence(value, n, name):
     """Formats value from input"""
@@ -134,6 +176,202 @@ def _GetSequence(value, n, name):
         )
 
 
+def _max_pool_without_indice(x, ksize, strides, padding, data_format):
+    # the cpu max pools of train jobs output the argmaxes, without them the grad pools x
+    # again to find them
+    dim = len(x.shape) - 2
+    channel_pos = "channels_last" if data_format in CHANNELS_LAST else "channels_first"
+    padding_type, pads_list = calc_pool_padding(
+        padding, get_dhw_offset(channel_pos), dim
+    )
+    return (
+        flow.user_op_builder("MaxPoolWithoutIndice")
+        .Op("max_pool_{}d".format(dim))
+        .Input("x", [x])
+        .Output("y")
+        .Attr("data_format", channel_pos)
+        .Attr("pool_size", _GetSequence(ksize, dim, "ksize"))
+        .Attr("strides", _GetSequence(strides, dim, "strides"))
+        .Attr("padding", padding_type)
+        .Attr("padding_before", [pad[0] for pad in pads_list])
+        .Attr("padding_after", [pad[1] for pad in pads_list])
+        .Attr("ceil_mode", False)
+        .Build()
+        .InferAndTryRun()
+        .RemoteBlobList()[0]
+    )
+
+
+def compare_with_tensorflow(arg_dict, with_indice=True):
+    for case in GenArgList(arg_dict):
+        (device_type, pool_conf, data_type, pooling_type, is_dynamic) = case
+        x_shape = pool_conf["x_shape"]
+        ksize = pool_conf["ksize"]
+        strides = pool_conf["strides"]
+        padding = pool_conf["padding"]
+        data_format = pool_conf["data_format"]
+        flow.clear_default_session()
+
+        # Random inputs
+        x = np.random.randn(*x_shape).astype(type_name_to_np_type[data_type])
+        dim = len(x.shape) - 2
+
+        # TODO: these cases will fail in old implementation
+        if device_type == "gpu" and dim == 3 and data_format == "NDHWC":
+            continue
+        # TF results
+        with tf.GradientTape(persistent=True) as tape:
+            x_tf = tf.Variable(x)
+            strides = _GetSequence(strides, dim, "strides")
+            pooling_f = None
+            if pooling_type == "AVG":
+                pooling_f = getattr(tf.nn, "avg_pool{}d".format(dim))
+            elif pooling_type == "MAX":
+                pooling_f = getattr(tf.nn, "max_pool{}d".format(dim))
+            else:
+                raise ValueError("pooling_type must be AVG or MAX")
+            # tf pools the channels last on the cpu
+            if data_format in CHANNELS_LAST:
+                y_tf = pooling_f(x_tf, ksize, strides, padding, data_format=data_format)
+            else:
+                y_tf = pooling_f(
+                    tf.transpose(x_tf, [0] + list(range(2, dim + 2)) + [1]),
+                    ksize,
+                    strides,
+                    padding,
+                    data_format=CHANNELS_LAST[dim - 1],
+                )
+                y_tf = tf.transpose(y_tf, [0, dim + 1] + list(range(1, dim + 1)))
+
+        dx_tf = tape.gradient(y_tf, x_tf, tf.constant(1.0, shape=y_tf.shape))
+
+        def assert_grad(b):
+            # TODO(hanbinbin): In eager mode, cannot derive b's is_dynamic correctly, therefore, using if .. else ...
+            # Don't warry, is_dynamic will be removed in the next refactor and the problem will gone.
+            if b.is_dynamic:
+                b_ndarray = b.numpy_list()[0]
+            else:
+                b_ndarray = b.numpy()
+            assert np.allclose(dx_tf.numpy(), b_ndarray), (
+                case,
+                dx_tf.numpy(),
+                b_ndarray,
+            )
+
+        # 1F results
+        dtype = type_name_to_flow_type[data_type]
+
+        func_config = flow.FunctionConfig()
+        func_config.default_data_type(flow.float)
+
+        tensor_def = None
+        if is_dynamic:
+            func_config.default_logical_view(flow.scope.mirrored_view())
+            tensor_def = oft.ListNumpy.Placeholder
+        else:
+            tensor_def = oft.Numpy.Placeholder
+
+        @flow.global_function(type="train", function_config=func_config)
+        def pooling_job(x: tensor_def(x_shape, dtype=dtype)):
+            v = flow.get_variable(
+                "x",
+                shape=x_shape,
+                dtype=dtype,
+                initializer=flow.constant_initializer(0),
+                trainable=True,
+            )
+            v = flow.cast_to_current_logical_view(v)
+            flow.watch_diff(v, assert_grad)
+            x += v
+            with flow.scope.placement(device_type, "0:0"):
+                pooling_f = None
+                if pooling_type == "MAX" and not with_indice:
+                    pooling_f = _max_pool_without_indice
+                elif pooling_type == "AVG":
+                    pooling_f = getattr(flow.nn, "avg_pool{}d".format(dim))
+                elif pooling_type == "MAX":
+                    pooling_f = getattr(flow.nn, "max_pool{}d".format(dim))
+                else:
+                    raise ValueError("pooling_type must be AVG or MAX")
+                y = pooling_f(
+                    x,
+                    ksize=ksize,
+                    strides=strides,
+                    padding=padding,
+                    data_format=data_format,
+                )
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [1e-4]), momentum=0
+            ).minimize(y)
+            return y
+
+        if is_dynamic:
+            x = [x]
+        y = pooling_job(x).get()
+        y_ndarray = None
+        if is_dynamic:
+            y_ndarray = y.numpy_list()[0]
+        else:
+            y_ndarray = y.numpy()
+        assert y_ndarray.shape == y_tf.numpy().shape, (
+            y_ndarray.shape,
+            y_tf.numpy().shape,
+        )
+        assert np.allclose(y_ndarray, y_tf.numpy(), rtol=1e-5, atol=1e-5), (
+            case,
+            y_ndarray - y_tf.numpy(),
+        )
+
+
+def compare_int_max_pool_with_tensorflow(pool_conf, data_type):
+    x_shape = pool_conf["x_shape"]
+    ksize = pool_conf["ksize"]
+    strides = pool_conf["strides"]
+    padding = pool_conf["padding"]
+    data_format = pool_conf["data_format"]
+    dim = len(x_shape) - 2
+    flow.clear_default_session()
+    np_type = type_name_to_np_type[data_type]
+    # the lowest value of the type is pooled too, so that the padding must not be taken,
+    # and all the values are exact in double
+    x = np.random.randint(-100, 100, size=x_shape)
+    if data_type == "uint8":
+        x += 100
+    x.flat[0] = max(np.iinfo(np_type).min, -(2 ** 53))
+    x.flat[-1] = min(np.iinfo(np_type).max, 2 ** 53)
+    x = x.astype(np_type)
+    # tf pools the channels last on the cpu
+    x_tf = x.astype(np.float64)
+    if data_format not in CHANNELS_LAST:
+        x_tf = np.transpose(x_tf, [0] + list(range(2, dim + 2)) + [1])
+    y_tf = getattr(tf.nn, "max_pool{}d".format(dim))(
+        x_tf,
+        ksize,
+        _GetSequence(strides, dim, "strides"),
+        padding,
+        data_format=CHANNELS_LAST[dim - 1],
+    ).numpy()
+    if data_format not in CHANNELS_LAST:
+        y_tf = np.transpose(y_tf, [0, dim + 1] + list(range(1, dim + 1)))
+
+    @flow.global_function()
+    def int_max_pool_job(
+        x: oft.Numpy.Placeholder(x_shape, dtype=type_name_to_flow_type[data_type])
+    ):
+        with flow.scope.placement("cpu", "0:0"):
+            return getattr(flow.nn, "max_pool{}d".format(dim))(
+                x,
+                ksize=ksize,
+                strides=strides,
+                padding=padding,
+                data_format=data_format,
+            )
+
+    y = int_max_pool_job(x).get().numpy()
+    assert y.dtype == np_type, (data_type, y.dtype)
+    assert np.array_equal(y, y_tf.astype(np_type)), (pool_conf, data_type, y, y_tf)
+
+
 @flow.unittest.skip_unless_1n1d()
 class TestPool(flow.unittest.TestCase):
     def test_pool(_):
@@ -143,114 +381,34 @@ class TestPool(flow.unittest.TestCase):
         arg_dict["data_type"] = ["float32"]
         arg_dict["pooling_type"] = ["AVG", "MAX"]
         arg_dict["is_dynamic"] = [True, False]
+        compare_with_tensorflow(arg_dict)
 
-        for case in GenArgList(arg_dict):
-            (device_type, pool_conf, data_type, pooling_type, is_dynamic) = case
-            x_shape = pool_conf["x_shape"]
-            ksize = pool_conf["ksize"]
-            strides = pool_conf["strides"]
-            padding = pool_conf["padding"]
-            data_format = pool_conf["data_format"]
-            if os.getenv("ONEFLOW_TEST_CPU_ONLY") and data_format != "NHWC":
-                continue
-            flow.clear_default_session()
-
-            # Random inputs
-            x = np.random.randn(*x_shape).astype(type_name_to_np_type[data_type])
-            dim = len(x.shape) - 2
-
-            # TODO: these cases will fail in old implementation
-            if dim == 3 and data_format == "NDHWC":
-                continue
-            # TF results
-            with tf.GradientTape(persistent=True) as tape:
-                x_tf = tf.Variable(x)
-                strides = _GetSequence(strides, dim, "strides")
-                pooling_f = None
-                if pooling_type == "AVG":
-                    pooling_f = getattr(tf.nn, "avg_pool{}d".format(dim))
-                elif pooling_type == "MAX":
-                    pooling_f = getattr(tf.nn, "max_pool{}d".format(dim))
-                else:
-                    raise ValueError("pooling_type must be AVG or MAX")
-                y_tf = pooling_f(x_tf, ksize, strides, padding, data_format=data_format)
-
-            dx_tf = tape.gradient(y_tf, x_tf, tf.constant(1.0, shape=y_tf.shape))
-
-            def assert_grad(b):
-                # TODO(hanbinbin): In eager mode, cannot derive b's is_dynamic correctly, therefore, using if .. else ...
-                # Don't warry, is_dynamic will be removed in the next refactor and the problem will gone.
-                if b.is_dynamic:
-                    b_ndarray = b.numpy_list()[0]
-                else:
-                    b_ndarray = b.numpy()
-                assert np.allclose(dx_tf.numpy(), b_ndarray), (
-                    case,
-                    dx_tf.numpy(),
-                    b_ndarray,
-                )
-
-            # 1F results
-            dtype = type_name_to_flow_type[data_type]
+    def test_pool_cpu(_):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["pool_conf"] = cpu_pool_confs
+        arg_dict["data_type"] = ["float32"]
+        arg_dict["pooling_type"] = ["AVG", "MAX"]
+        arg_dict["is_dynamic"] = [False]
+        compare_with_tensorflow(arg_dict)
 
-            func_config = flow.FunctionConfig()
-            func_config.default_data_type(flow.float)
+    def test_max_pool_cpu_without_indice(_):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["pool_conf"] = [
+            conf for conf in pool_confs + cpu_pool_confs if len(conf["x_shape"]) == 4
+        ]
+        arg_dict["data_type"] = ["float32"]
+        arg_dict["pooling_type"] = ["MAX"]
+        arg_dict["is_dynamic"] = [False]
+        compare_with_tensorflow(arg_dict, with_indice=False)
 
-            tensor_def = None
-            if is_dynamic:
-                func_config.default_logical_view(flow.scope.mirrored_view())
-                tensor_def = oft.ListNumpy.Placeholder
-            else:
-                tensor_def = oft.Numpy.Placeholder
-
-            @flow.global_function(type="train", function_config=func_config)
-            def pooling_job(x: tensor_def(x_shape, dtype=dtype)):
-                v = flow.get_variable(
-                    "x",
-                    shape=x_shape,
-                    dtype=dtype,
-                    initializer=flow.constant_initializer(0),
-                    trainable=True,
-                )
-                v = flow.cast_to_current_logical_view(v)
-                flow.watch_diff(v, assert_grad)
-                x += v
-                with flow.scope.placement(device_type, "0:0"):
-                    pooling_f = None
-                    if pooling_type == "AVG":
-                        pooling_f = getattr(flow.nn, "avg_pool{}d".format(dim))
-                    elif pooling_type == "MAX":
-                        pooling_f = getattr(flow.nn, "max_pool{}d".format(dim))
-                    else:
-                        raise ValueError("pooling_type must be AVG or MAX")
-                    y = pooling_f(
-                        x,
-                        ksize=ksize,
-                        strides=strides,
-                        padding=padding,
-                        data_format=data_format,
-                    )
-                flow.optimizer.SGD(
-                    flow.optimizer.PiecewiseConstantScheduler([], [1e-4]), momentum=0
-                ).minimize(y)
-                return y
-
-            if is_dynamic:
-                x = [x]
-            y = pooling_job(x).get()
-            y_ndarray = None
-            if is_dynamic:
-                y_ndarray = y.numpy_list()[0]
-            else:
-                y_ndarray = y.numpy()
-            assert y_ndarray.shape == y_tf.numpy().shape, (
-                y_ndarray.shape,
-                y_tf.numpy().shape,
-            )
-            assert np.allclose(y_ndarray, y_tf.numpy(), rtol=1e-5, atol=1e-5), (
-                case,
-                y_ndarray - y_tf.numpy(),
-            )
+    def test_int_max_pool_cpu(_):
+        arg_dict = OrderedDict()
+        arg_dict["pool_conf"] = pool_confs + cpu_pool_confs
+        arg_dict["data_type"] = ["int8", "uint8", "int32", "int64"]
+        for arg in GenArgList(arg_dict):
+            compare_int_max_pool_with_tensorflow(*arg)
 
 
 if __name__ == "__main__":
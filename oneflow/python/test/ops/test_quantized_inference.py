@@ -0,0 +1,130 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+from collections import OrderedDict
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+from test_util import GenArgList
+
+INPUT_SHAPE = (4, 3, 12, 12)
+
+
+def _build_net(x, data_format):
+    if data_format == "NHWC":
+        x = flow.transpose(x, perm=[0, 2, 3, 1])
+    y = flow.layers.conv2d(
+        x, 8, 3, 1, "SAME", data_format=data_format, use_bias=True, name="conv1"
+    )
+    y = flow.nn.relu(y)
+    y = flow.layers.conv2d(
+        y, 8, 3, 2, "SAME", data_format=data_format, use_bias=True, name="conv2"
+    )
+    y = flow.nn.relu(y)
+    y = flow.reshape(y, (INPUT_SHAPE[0], -1))
+    return flow.layers.dense(y, 10, name="fc")
+
+
+def _get_op_type_names(job_name):
+    for job in flow.experimental.get_job_set().job:
+        if job.job_conf.job_name == job_name:
+            return [
+                op.user_conf.op_type_name
+                for op in job.net.op
+                if op.HasField("user_conf")
+            ]
+    raise ValueError("no job named " + job_name)
+
+
+def _run(test_case, per_channel, symmetric, data_format):
+    flow.clear_default_session()
+
+    def qat_func_config():
+        func_config = flow.FunctionConfig()
+        func_config.default_logical_view(flow.scope.consistent_view())
+        func_config.enable_qat(True)
+        func_config.qat.symmetric(symmetric)
+        func_config.qat.per_channel_weight_quantization(per_channel)
+        func_config.qat.moving_min_max_stop_update_after_iters(1000)
+        func_config.qat.target_backend("oneflow_int8")
+        return func_config
+
+    float_func_config = flow.FunctionConfig()
+    float_func_config.default_logical_view(flow.scope.consistent_view())
+
+    # calibrates the observers without changing the weights
+    @flow.global_function(type="train", function_config=qat_func_config())
+    def calibrate_job(x: tp.Numpy.Placeholder(INPUT_SHAPE)) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            y = _build_net(x, data_format)
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [0]), momentum=0
+            ).minimize(flow.math.reduce_mean(y))
+        return y
+
+    @flow.global_function(function_config=qat_func_config())
+    def int8_job(x: tp.Numpy.Placeholder(INPUT_SHAPE)) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            return _build_net(x, data_format)
+
+    @flow.global_function(function_config=float_func_config)
+    def float_job(x: tp.Numpy.Placeholder(INPUT_SHAPE)) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            return _build_net(x, data_format)
+
+    rng = np.random.RandomState(0)
+    for _ in range(10):
+        calibrate_job(rng.rand(*INPUT_SHAPE).astype(np.float32))
+    x = rng.rand(*INPUT_SHAPE).astype(np.float32)
+    int8_out = int8_job(x)
+    float_out = float_job(x)
+    error = np.abs(int8_out - float_out).max() / np.abs(float_out).max()
+    test_case.assertLess(error, 0.05)
+    # all of conv and dense are rewritten to compute in int8
+    op_type_names = _get_op_type_names("int8_job")
+    test_case.assertEqual(op_type_names.count("quantized_conv2d"), 2)
+    test_case.assertEqual(op_type_names.count("quantized_matmul"), 1)
+    test_case.assertNotIn("conv2d", op_type_names)
+    test_case.assertNotIn("matmul", op_type_names)
+
+    # a negated weight keeps its symmetric scales, the int8 kernels must still see it
+    flow.load_variables(
+        {
+            name: -var.numpy()
+            for name, var in flow.get_all_variables().items()
+            if name.endswith("weight")
+        }
+    )
+    int8_out = int8_job(x)
+    float_out = float_job(x)
+    error = np.abs(int8_out - float_out).max() / np.abs(float_out).max()
+    test_case.assertLess(error, 0.05)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestQuantizedInference(flow.unittest.TestCase):
+    def test_quantized_inference(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["per_channel"] = [True, False]
+        arg_dict["symmetric"] = [True, False]
+        arg_dict["data_format"] = ["NCHW", "NHWC"]
+        for arg in GenArgList(arg_dict):
+            _run(test_case, *arg)
+
+
+if __name__ == "__main__":
+    unittest.main()
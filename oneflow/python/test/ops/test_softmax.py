@@ -121,6 +121,15 @@ class TestSoftmax(flow.unittest.TestCase):
                 continue
             compare_with_tensorflow(*arg)
 
+    def test_softmax_shape_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["x_shape"] = [(10, 20), (10, 513), (12, 2001), (4, 50257)]
+        arg_dict["data_type"] = ["float32", "double"]
+        arg_dict["axis"] = [-1]
+        for arg in GenArgList(arg_dict):
+            compare_with_tensorflow(*arg)
+
     def test_softmax_axis(test_case):
         arg_dict = OrderedDict()
         arg_dict["device_type"] = ["gpu", "cpu"]
@@ -30,7 +30,7 @@ for gpu in gpus:
 
 def compare_with_tensorflow(device_type, in_shape, axis, direction, data_type):
     assert device_type in ["gpu", "cpu"]
-    assert data_type in ["float32", "double", "int8", "int32", "int64"]
+    assert data_type in ["float32", "double", "int8", "uint8", "int32", "int64"]
     flow.clear_default_session()
     func_config = flow.FunctionConfig()
     func_config.default_logical_view(flow.scope.mirrored_view())
@@ -49,6 +49,13 @@ def compare_with_tensorflow(device_type, in_shape, axis, direction, data_type):
     input = (np.random.random(in_shape) * 100).astype(type_name_to_np_type[data_type])
     # OneFlow
     of_out = SortJob([input]).get().numpy_list()[0]
+    if data_type == "uint8":
+        # tf.sort negates the values for an ascending sort, which wraps around for uint8
+        np_out = np.sort(input, axis)
+        if direction == "DESCENDING":
+            np_out = np.flip(np_out, axis)
+        assert np.array_equal(of_out, np_out)
+        return
     # TensorFlow
     tf_out = tf.sort(input, axis, direction)
 
@@ -77,6 +84,17 @@ def gen_arg_list_for_test_axis():
     return GenArgList(arg_dict)
 
 
+def gen_arg_list_for_cpu_radix_sort():
+    arg_dict = OrderedDict()
+    arg_dict["device_type"] = ["cpu"]
+    arg_dict["in_shape"] = [(4, 3000)]
+    arg_dict["axis"] = [-1]
+    arg_dict["direction"] = ["ASCENDING", "DESCENDING"]
+    arg_dict["data_type"] = ["float32", "double", "int8", "uint8", "int32", "int64"]
+
+    return GenArgList(arg_dict)
+
+
 @flow.unittest.skip_unless_1n1d()
 class TestSort(flow.unittest.TestCase):
     @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
@@ -86,6 +104,10 @@ class TestSort(flow.unittest.TestCase):
         for arg in gen_arg_list_for_test_axis():
             compare_with_tensorflow(*arg)
 
+    def test_sort_cpu_radix(test_case):
+        for arg in gen_arg_list_for_cpu_radix_sort():
+            compare_with_tensorflow(*arg)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -100,6 +100,16 @@ class TestSparseSoftmaxCrossEntropy(flow.unittest.TestCase):
         for arg in GenArgList(arg_dict):
             compare_with_tensorflow(*arg)
 
+    def test_sparse_softmax_cross_entropy_with_logits_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["data_type"] = ["float32", "double"]
+        arg_dict["label_type"] = ["int32"]
+        arg_dict["num_classes"] = [7, 50257]
+        arg_dict["batch_size"] = [8]
+        for arg in GenArgList(arg_dict):
+            compare_with_tensorflow(*arg)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -30,18 +30,22 @@ for gpu in gpus:
     tf.config.experimental.set_memory_growth(gpu, True)
 
 
-def compare_with_tensorflow(device_type, in_shape, axis, k, data_type, sorted):
+def compare_with_tensorflow(
+    device_type, in_shape, axis, k, data_type, sorted, static_shape=None
+):
     assert device_type in ["gpu", "cpu"]
-    assert data_type in ["float32", "double", "int8", "int32", "int64"]
+    assert data_type in ["float32", "double", "int8", "uint8", "int32", "int64"]
     flow.clear_default_session()
     func_config = flow.FunctionConfig()
     func_config.default_logical_view(flow.scope.mirrored_view())
     func_config.default_data_type(flow.float)
+    if static_shape is None:
+        static_shape = tuple([dim + 10 for dim in in_shape])
 
     @flow.global_function(function_config=func_config)
     def TopKJob(
         input: oft.ListNumpy.Placeholder(
-            tuple([dim + 10 for dim in in_shape]),
+            static_shape,
             dtype=type_name_to_flow_type[data_type],
         )
     ):
@@ -51,6 +55,13 @@ def compare_with_tensorflow(device_type, in_shape, axis, k, data_type, sorted):
     input = (np.random.random(in_shape) * 100).astype(type_name_to_np_type[data_type])
     # OneFlow
     of_out = TopKJob([input]).get().numpy_list()[0]
+    if data_type == "uint8":
+        # equal values are ordered by index, numpy sorts the negated values in int64
+        # since they would wrap around in uint8
+        assert axis == -1 and k <= in_shape[axis]
+        np_out = np.argsort(-input.astype(np.int64), axis, kind="stable")[..., :k]
+        assert np.array_equal(of_out, np_out)
+        return
     # TensorFlow
     if k <= in_shape[axis]:
         perm = get_perm_when_transpose_axis_to_last_dim(len(in_shape), axis)
@@ -88,6 +99,19 @@ def gen_arg_list_for_test_axis():
     return GenArgList(arg_dict)
 
 
+def gen_arg_list_for_cpu_heap():
+    arg_dict = OrderedDict()
+    arg_dict["device_type"] = ["cpu"]
+    arg_dict["in_shape"] = [(4, 5000)]
+    arg_dict["axis"] = [-1]
+    # the first two are selected by a heap
+    arg_dict["k"] = [5, 100, 1000]
+    arg_dict["data_type"] = ["float32", "uint8", "int32"]
+    arg_dict["sorted"] = [True]
+
+    return GenArgList(arg_dict)
+
+
 @flow.unittest.skip_unless_1n1d()
 class TestTopK(flow.unittest.TestCase):
     @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
@@ -97,6 +121,17 @@ class TestTopK(flow.unittest.TestCase):
         for arg in gen_arg_list_for_test_axis():
             compare_with_tensorflow(*arg)
 
+    def test_top_k_cpu_heap(test_case):
+        for arg in gen_arg_list_for_cpu_heap():
+            compare_with_tensorflow(*arg)
+
+    def test_top_k_cpu_dynamic_row_too_short_for_heap(test_case):
+        # the static rows are selected by a heap, the runtime ones by nth_element
+        for k in [50, 100]:
+            compare_with_tensorflow(
+                "cpu", (4, 1000), -1, k, "float32", True, static_shape=(4, 5000)
+            )
+
 
 if __name__ == "__main__":
     unittest.main()
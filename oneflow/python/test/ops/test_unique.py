@@ -75,6 +75,16 @@ class TestUnique(flow.unittest.TestCase):
         np.random.shuffle(x)
         _run_test(test_case, x, flow.int32, "cpu")
 
+    def test_unique_with_counts_float_cpu(test_case):
+        x = np.random.randint(-16, 16, 1024).astype(np.float32) / 2
+        x[0:2] = [0.0, -0.0]
+        _run_test(test_case, x, flow.float32, "cpu")
+
+    def test_unique_with_counts_large_cpu(test_case):
+        # large enough to be split into partitions over the thread pool
+        x = (np.random.zipf(1.2, 300000) % 100000).astype(np.int64)
+        _run_test(test_case, x, flow.int64, "cpu")
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -320,7 +320,7 @@ def compare_with_numpy(
     device_type, input_shape, dtype, size, data_format, interpolation, align_corners
 ):
     # TODO (shijie wang): numpy upsample2d backward implementation.
-    assert device_type in ["gpu"]
+    assert device_type in ["gpu", "cpu"]
     flow.clear_default_session()
 
     func_config = flow.FunctionConfig()
@@ -414,6 +414,30 @@ class TestUpsample(flow.unittest.TestCase):
         for arg in GenArgList(arg_dict):
             compare_with_numpy(*arg)
 
+    def test_upsample_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["input_shape"] = [(2, 11, 12, 13)]
+        arg_dict["dtype"] = ["float32", "double"]
+        arg_dict["size"] = [(2, 2), 3, (1, 2)]
+        arg_dict["data_format"] = ["NCHW", "NHWC"]
+        arg_dict["interpolation"] = ["nearest", "bilinear"]
+        arg_dict["align_corners"] = [False]
+        for arg in GenArgList(arg_dict):
+            compare_with_tensorflow(*arg)
+
+    def test_upsample_align_corners_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["input_shape"] = [(2, 5, 6, 7)]
+        arg_dict["dtype"] = ["float32", "double"]
+        arg_dict["size"] = [(2, 2), 3, (1, 2)]
+        arg_dict["data_format"] = ["NCHW", "NHWC"]
+        arg_dict["interpolation"] = ["bilinear"]
+        arg_dict["align_corners"] = [True, False]
+        for arg in GenArgList(arg_dict):
+            compare_with_numpy(*arg)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -0,0 +1,185 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import shutil
+import tempfile
+import threading
+import unittest
+
+import numpy as np
+import oneflow as flow
+
+BATCH_SIZE = 8
+NUM_CLIENTS = 8
+REQUESTS_PER_CLIENT = 4
+
+
+def make_scale_job(input_lbns, output_lbns):
+    @flow.global_function(type="predict")
+    def scale_job(
+        x: flow.typing.Numpy.Placeholder((BATCH_SIZE, 4), dtype=flow.float32)
+    ) -> flow.typing.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            input_lbns["x"] = x.logical_blob_name
+            w = flow.get_variable(
+                "w",
+                shape=(4,),
+                dtype=flow.float32,
+                initializer=flow.constant_initializer(0.5),
+            )
+            y = flow.math.multiply(x, w)
+            output_lbns["y"] = y.logical_blob_name
+            return y
+
+    return scale_job
+
+
+def make_add_job(input_lbns, output_lbns):
+    shape = (BATCH_SIZE // 2, 3)
+
+    @flow.global_function(type="predict")
+    def add_job(
+        u: flow.typing.Numpy.Placeholder(shape, dtype=flow.int32),
+        v: flow.typing.Numpy.Placeholder(shape, dtype=flow.int32),
+    ) -> flow.typing.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            input_lbns["u"] = u.logical_blob_name
+            input_lbns["v"] = v.logical_blob_name
+            z = u + v
+            output_lbns["z"] = z.logical_blob_name
+            return z
+
+    return add_job
+
+
+def save_model(saved_model_dir):
+    flow.clear_default_session()
+    jobs = []
+    for make_job in (make_scale_job, make_add_job):
+        input_lbns = {}
+        output_lbns = {}
+        jobs.append((make_job(input_lbns, output_lbns), input_lbns, output_lbns))
+    # running a job compiles the jobs and initializes the variable
+    jobs[0][0](np.zeros((BATCH_SIZE, 4), np.float32))
+    builder = flow.saved_model.ModelBuilder(saved_model_dir)
+    builder.ModelName("batching").Version(1)
+    for job, input_lbns, output_lbns in jobs:
+        signature_builder = builder.AddFunction(job).AddSignature("predict")
+        for input_name, lbn in input_lbns.items():
+            signature_builder.Input(input_name, lbn)
+        for output_name, lbn in output_lbns.items():
+            signature_builder.Output(output_name, lbn)
+    builder.Save()
+    flow.clear_default_session()
+
+
+def run_clients(server, make_inputs):
+    # every client submits its requests at once, so that they are coalesced
+    barrier = threading.Barrier(NUM_CLIENTS)
+    results = [[] for _ in range(NUM_CLIENTS)]
+
+    def client(idx):
+        rng = np.random.RandomState(idx)
+        barrier.wait()
+        for _ in range(REQUESTS_PER_CLIENT):
+            inputs = make_inputs(rng)
+            results[idx].append((inputs, server.infer(inputs)))
+
+    threads = [threading.Thread(target=client, args=(i,)) for i in range(NUM_CLIENTS)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    return [result for client_results in results for result in client_results]
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestBatchingInferenceServer(flow.unittest.TestCase):
+    def test_batching_inference_server(test_case):
+        saved_model_dir = tempfile.mkdtemp()
+        shutil.rmtree(saved_model_dir)
+        save_model(saved_model_dir)
+
+        option = flow.serving.SessionOption()
+        option.device_tag = "cpu"
+        sess = flow.serving.InferenceSession(option)
+        # the session has the inputs of both jobs
+        sess.load_saved_model(saved_model_dir, graph_name="scale_job")
+        sess.load_saved_model(saved_model_dir, graph_name="add_job")
+        sess.launch()
+
+        scale_server = sess.make_batching_server("scale_job", batch_timeout_us=20000)
+
+        def make_scale_inputs(rng):
+            rows = rng.randint(1, 4)
+            return {"x": rng.uniform(-1, 1, size=(rows, 4)).astype(np.float32)}
+
+        results = run_clients(scale_server, make_scale_inputs)
+        for inputs, outputs in results:
+            test_case.assertEqual(list(outputs.keys()), ["y"])
+            test_case.assertTrue(np.allclose(outputs["y"], inputs["x"] * 0.5))
+        stats = scale_server.stats()
+        test_case.assertEqual(stats["num_requests"], len(results))
+        test_case.assertEqual(
+            stats["num_batched_rows"],
+            sum(inputs["x"].shape[0] for inputs, _ in results),
+        )
+        test_case.assertLess(stats["num_batches"], stats["num_requests"])
+
+        # the default max batch size is the batch size of the inputs of add_job
+        add_server = sess.make_batching_server("add_job", batch_timeout_us=20000)
+
+        def make_add_inputs(rng):
+            rows = rng.randint(1, 3)
+            return {
+                "u": rng.randint(-100, 100, size=(rows, 3)).astype(np.int32),
+                "v": rng.randint(-100, 100, size=(rows, 3)).astype(np.int32),
+            }
+
+        for inputs, outputs in run_clients(add_server, make_add_inputs):
+            test_case.assertEqual(list(outputs.keys()), ["z"])
+            expected = inputs["u"] + inputs["v"]
+            test_case.assertTrue(np.array_equal(outputs["z"], expected))
+        too_large = {
+            "u": np.zeros((BATCH_SIZE // 2 + 1, 3), np.int32),
+            "v": np.zeros((BATCH_SIZE // 2 + 1, 3), np.int32),
+        }
+        with test_case.assertRaises(Exception):
+            add_server.infer(too_large)
+        # the inputs of the other job are not inputs of this one
+        inputs = make_add_inputs(np.random.RandomState(0))
+        inputs["x"] = np.zeros((1, 4), np.float32)
+        with test_case.assertRaises(Exception):
+            add_server.infer(inputs)
+        # the data type and the row shape are those of the inputs of the job
+        inputs = make_add_inputs(np.random.RandomState(0))
+        inputs["u"] = inputs["u"].astype(np.int64)
+        with test_case.assertRaises(Exception):
+            add_server.infer(inputs)
+        inputs = make_add_inputs(np.random.RandomState(0))
+        inputs["v"] = np.zeros((inputs["v"].shape[0], 4), np.int32)
+        with test_case.assertRaises(Exception):
+            add_server.infer(inputs)
+        # the rejected requests leave the server usable
+        inputs = make_add_inputs(np.random.RandomState(1))
+        outputs = add_server.infer(inputs)
+        test_case.assertTrue(np.array_equal(outputs["z"], inputs["u"] + inputs["v"]))
+
+        sess.close()
+        shutil.rmtree(saved_model_dir)
+
+
+if __name__ == "__main__":
+    unittest.main()
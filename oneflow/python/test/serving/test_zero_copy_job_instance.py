@@ -0,0 +1,169 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import ctypes
+import threading
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow._oneflow_internal
+import oneflow.python.framework.job_instance as job_instance_util
+import oneflow.python.framework.session_context as session_ctx
+
+SHAPE = (4, 8)
+ALIGN_SIZE = 64
+
+
+def aligned_empty(shape, dtype):
+    # the borrowed buffers must be aligned to kForeignHostBufferAlignSize
+    nbytes = int(np.prod(shape)) * np.dtype(dtype).itemsize
+    raw = np.empty(nbytes + ALIGN_SIZE, np.uint8)
+    offset = -raw.ctypes.data % ALIGN_SIZE
+    return raw[offset : offset + nbytes].view(dtype).reshape(shape)
+
+
+SENTINEL = -12345.0
+
+
+def host_view(of_blob_ptr):
+    nbytes = oneflow._oneflow_internal.OfBlob_ByteSizeOfBody(of_blob_ptr)
+    view = (ctypes.c_char * nbytes).from_address(
+        oneflow._oneflow_internal.OfBlob_HostDptr(of_blob_ptr)
+    )
+    return np.frombuffer(view, np.float32).reshape(SHAPE)
+
+
+class BorrowingJobInstance(job_instance_util.JobInstance):
+    def __init__(self, job_name, op_name, buffer):
+        job_instance_util.JobInstance.__init__(
+            self,
+            job_name,
+            sole_input_op_name_in_user_job=op_name,
+            finish_cb=lambda: None,
+        )
+        self.buffer_ = buffer
+        self.num_borrowed_ = 0
+        self.regst_body_ = None
+
+    def BorrowInputBuffer(self, of_blob_ptr):
+        assert oneflow._oneflow_internal.OfBlob_IsHostMem(of_blob_ptr)
+        assert (
+            oneflow._oneflow_internal.OfBlob_ByteSizeOfBody(of_blob_ptr)
+            <= self.buffer_.nbytes
+        )
+        self.num_borrowed_ += 1
+        # the body of the regst is free at this point, it must still hold the sentinel
+        # after the job if the buffer was not copied into it
+        self.regst_body_ = host_view(of_blob_ptr)
+        self.regst_body_[...] = SENTINEL
+        return self.buffer_.ctypes.data
+
+    def PushBlob(self, of_blob_ptr):
+        raise AssertionError("the input buffer is not borrowed")
+
+
+class LendingJobInstance(job_instance_util.JobInstance):
+    def __init__(self, job_name, op_name):
+        job_instance_util.JobInstance.__init__(
+            self,
+            job_name,
+            sole_output_op_name_in_user_job=op_name,
+            finish_cb=lambda: self.finished_.set(),
+        )
+        self.finished_ = threading.Event()
+        self.view_ = None
+        self.release_ = None
+
+    def LendOutputBlob(self, of_blob_ptr, release):
+        assert oneflow._oneflow_internal.OfBlob_IsHostMem(of_blob_ptr)
+        # keeps the view itself, it is valid until it is released
+        self.view_ = host_view(of_blob_ptr)
+        self.release_ = release
+        return True
+
+    def PullBlob(self, of_blob_ptr):
+        raise AssertionError("the output blob is not lent")
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestZeroCopyJobInstance(flow.unittest.TestCase):
+    def test_borrow_input_and_lend_output(test_case):
+        flow.clear_default_session()
+
+        @flow.global_function(type="predict")
+        def double_job(
+            x: flow.typing.Numpy.Placeholder(SHAPE, dtype=flow.float32)
+        ) -> flow.typing.Numpy:
+            with flow.scope.placement("cpu", "0:0"):
+                return x * 2
+
+        # launches the session
+        double_job(np.zeros(SHAPE, np.float32))
+        sess = session_ctx.GetDefaultSession()
+        push_job_names = sess.inter_user_job_info.input_or_var_op_name2push_job_name
+        pull_job_names = sess.inter_user_job_info.output_or_var_op_name2pull_job_name
+        test_case.assertEqual(len(push_job_names), 1)
+        test_case.assertEqual(len(pull_job_names), 1)
+        ((input_op_name, push_job_name),) = push_job_names.items()
+        ((output_op_name, pull_job_name),) = pull_job_names.items()
+
+        rng = np.random.RandomState(0)
+        # keeps the instances alive as the session does not own them
+        job_instances = []
+
+        def launch():
+            buffer = aligned_empty(SHAPE, np.float32)
+            buffer[...] = rng.uniform(-1, 1, size=SHAPE)
+            push_inst = BorrowingJobInstance(push_job_name, input_op_name, buffer)
+            pull_inst = LendingJobInstance(pull_job_name, output_op_name)
+            job_instances.extend([push_inst, pull_inst])
+            sess.LaunchJob(push_inst)
+            sess.LaunchJob(job_instance_util.MakeUserJobInstance("double_job"))
+            sess.LaunchJob(pull_inst)
+            return buffer * 2, push_inst, pull_inst
+
+        expected, push_inst, pull_inst = launch()
+        test_case.assertTrue(pull_inst.finished_.wait(60))
+        for _ in range(8):
+            test_case.assertEqual(push_inst.num_borrowed_, 1)
+            # the consumers read the borrowed buffer, not a copy of it in the regst
+            test_case.assertTrue(np.all(push_inst.regst_body_ == SENTINEL))
+            test_case.assertTrue(np.allclose(pull_inst.view_, expected))
+            # the next instance can't reuse the regst of the view which is still lent,
+            # if it finishes it has a regst of its own, else it waits for the release
+            next_expected, next_push_inst, next_pull_inst = launch()
+            if next_pull_inst.finished_.wait(1):
+                test_case.assertNotEqual(
+                    next_pull_inst.view_.ctypes.data, pull_inst.view_.ctypes.data
+                )
+            test_case.assertTrue(np.allclose(pull_inst.view_, expected))
+            # the job does not wait for the release, which may come from any thread
+            pull_inst.release_()
+            test_case.assertTrue(next_pull_inst.finished_.wait(60))
+            expected = next_expected
+            push_inst, pull_inst = next_push_inst, next_pull_inst
+        test_case.assertTrue(np.allclose(pull_inst.view_, expected))
+        pull_inst.release_()
+
+        # the regular path still copies
+        x = rng.uniform(-1, 1, size=SHAPE).astype(np.float32)
+        test_case.assertTrue(np.allclose(double_job(x), x * 2))
+        flow.sync_default_session()
+        flow.clear_default_session()
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,124 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+import oneflow as flow
+
+config = flow.function_config()
+
+
+def make_job(x_shape, b_shape, use_cpu_fusion, dtype=flow.float32):
+    config.use_xla_jit(False)
+    config.use_tensorrt(False)
+    config.use_cpu_fusion(use_cpu_fusion)
+
+    @flow.global_function(config)
+    def fused_job(
+        x=flow.FixedTensorDef(x_shape, dtype=dtype),
+        bias=flow.FixedTensorDef(b_shape, dtype=dtype),
+    ):
+        with flow.scope.placement("cpu", "0:0"):
+            out = flow.nn.bias_add(x, bias)
+            out = flow.math.gelu(out)
+            out = flow.math.multiply(out, 2.0)
+            out = flow.math.add(out, 1.0)
+            return out, flow.math.reduce_sum(out, axis=[1], keepdims=True)
+
+    return fused_job
+
+
+def make_int_job(x_shape, use_cpu_fusion):
+    config.use_xla_jit(False)
+    config.use_tensorrt(False)
+    config.use_cpu_fusion(use_cpu_fusion)
+
+    @flow.global_function(config)
+    def int_job(
+        x=flow.FixedTensorDef(x_shape, dtype=flow.int64),
+        y=flow.FixedTensorDef(x_shape, dtype=flow.int64),
+    ):
+        with flow.scope.placement("cpu", "0:0"):
+            out = flow.math.add(x, y)
+            out = flow.math.multiply(out, y)
+            return out, flow.math.sigmoid(flow.cast(out, dtype=flow.float32))
+
+    return int_job
+
+
+def make_int_cast_job(x_shape, use_cpu_fusion):
+    config.use_xla_jit(False)
+    config.use_tensorrt(False)
+    config.use_cpu_fusion(use_cpu_fusion)
+
+    @flow.global_function(config)
+    def int_cast_job(x=flow.FixedTensorDef(x_shape, dtype=flow.int64)):
+        with flow.scope.placement("cpu", "0:0"):
+            out = flow.cast(x, dtype=flow.int32)
+            return out, flow.math.relu(flow.cast(out, dtype=flow.float32))
+
+    return int_cast_job
+
+
+@unittest.skipIf(
+    not flow.sysconfig.with_xrt_fusion(), "not built with the cpu fusion engine"
+)
+class TestCpuFusion(unittest.TestCase):
+    def _test_body(self, x, bias, dtype=np.float32):
+        f1 = make_job(x.shape, bias.shape, False, dtype=flow.float32)
+        f2 = make_job(x.shape, bias.shape, True, dtype=flow.float32)
+        a, a_sum = f1(x, bias).get()
+        b, b_sum = f2(x, bias).get()
+        print("without cpu fusion: ", a, a_sum)
+        print("with cpu fusion", b, b_sum)
+        self.assertTrue(np.allclose(a.numpy(), b.numpy(), rtol=1e-03, atol=1e-05))
+        self.assertTrue(
+            np.allclose(a_sum.numpy(), b_sum.numpy(), rtol=1e-03, atol=1e-05)
+        )
+
+        flow.clear_default_session()
+
+    def _test_random_body(self, x_shape, dtype=np.float32):
+        x = np.random.random(x_shape).astype(dtype)
+        bias = np.random.random(x_shape[1:2]).astype(dtype)
+        self._test_body(x, bias, dtype=dtype)
+
+    def test_random_input(self):
+        self._test_random_body((1, 10))
+        self._test_random_body((2, 10, 2))
+        self._test_random_body((64, 128, 7, 7))
+
+    def test_int64_input(self):
+        # the integer arithmetic is not fused, as float is not exact above 2**24
+        x = np.random.randint(2 ** 24, 2 ** 30, size=(4, 16)).astype(np.int64)
+        y = np.random.randint(1, 2 ** 8, size=(4, 16)).astype(np.int64)
+        out, sigmoid = make_int_job(x.shape, True)(x, y).get()
+        self.assertTrue(np.array_equal(out.numpy(), (x + y) * y))
+        expected = 1 / (1 + np.exp(-((x + y) * y).astype(np.float32)))
+        self.assertTrue(np.allclose(sigmoid.numpy(), expected))
+        flow.clear_default_session()
+
+    def test_int64_to_int32_cast(self):
+        # a cast between integers would go through float, it is not fused either
+        x = np.random.randint(2 ** 24, 2 ** 30, size=(4, 16)).astype(np.int64)
+        out, relu = make_int_cast_job(x.shape, True)(x).get()
+        self.assertTrue(np.array_equal(out.numpy(), x.astype(np.int32)))
+        self.assertTrue(np.allclose(relu.numpy(), x.astype(np.float32)))
+        flow.clear_default_session()
+
+
+if __name__ == "__main__":
+    unittest.main()
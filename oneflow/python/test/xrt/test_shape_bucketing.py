@@ -0,0 +1,71 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import unittest
+
+# the flag is read when oneflow is loaded
+os.environ["FLAGS_xrt_shape_bucketing"] = "true"
+
+import numpy as np
+import oneflow as flow
+
+static_shape = (8, 16)
+
+
+def make_job():
+    config = flow.function_config()
+    config.default_logical_view(flow.scope.mirrored_view())
+    config.use_xla_jit(False)
+    config.use_tensorrt(False)
+    config.use_cpu_fusion(True)
+
+    @flow.global_function(config)
+    def bucketing_job(x=flow.MirroredTensorDef(static_shape, dtype=flow.float32)):
+        with flow.scope.placement("cpu", "0:0"):
+            # exp turns the padded zeros into ones, which the reductions would pick up
+            out = flow.math.multiply(flow.math.exp(x), 2.0)
+            out_sum = flow.math.reduce_sum(out, axis=[0])
+            out_max = flow.math.reduce_max(flow.math.negative(out), axis=[0])
+            return out, out_sum, out_max
+
+    return bucketing_job
+
+
+@unittest.skipIf(
+    not flow.sysconfig.with_xrt_fusion(), "not built with the cpu fusion engine"
+)
+class TestShapeBucketing(unittest.TestCase):
+    def test_reduce_over_bucketed_axis(self):
+        job = make_job()
+        # 5 and 3 rows are padded to the buckets of 8 and 4 rows
+        for rows in (5, 3, 8):
+            x = np.random.random((rows,) + static_shape[1:]).astype(np.float32)
+            out, out_sum, out_max = job([x]).get()
+            expected = np.exp(x) * 2.0
+            self.assertTrue(np.allclose(out.numpy_list()[0], expected, rtol=1e-05))
+            self.assertTrue(
+                np.allclose(out_sum.numpy_list()[0], expected.sum(axis=0), rtol=1e-05)
+            )
+            self.assertTrue(
+                np.allclose(
+                    out_max.numpy_list()[0], (-expected).max(axis=0), rtol=1e-05
+                )
+            )
+        flow.clear_default_session()
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -26,39 +26,132 @@ namespace data {
 
 static const int32_t kDataReaderBatchBufferSize = 4;
 
+struct DataReaderPipelineConf {
+  // Number of workers running Parser::Prepare ahead of Read. 0 parses on the actor thread.
+  int32_t num_parse_threads = 0;
+  // Capacity of every bounded queue between two stages of the pipeline.
+  int32_t buffer_size = kDataReaderBatchBufferSize;
+  // Log the stage statistics every stats_log_interval batches. 0 disables the log.
+  int64_t stats_log_interval = 0;
+};
+
+// Time spent by one pipeline stage doing its own work (busy), waiting for its producer (starved)
+// and waiting for room in the queue of its consumer (blocked).
+class DataReaderStageStats final {
+ public:
+  DataReaderStageStats() : num_batches_(0), busy_ns_(0), starved_ns_(0), blocked_ns_(0) {}
+  ~DataReaderStageStats() = default;
+
+  void AddBusy(double ns) { busy_ns_.fetch_add(static_cast<int64_t>(ns)); }
+  void AddStarved(double ns) { starved_ns_.fetch_add(static_cast<int64_t>(ns)); }
+  void AddBlocked(double ns) { blocked_ns_.fetch_add(static_cast<int64_t>(ns)); }
+  void IncreaseNumBatches() { num_batches_.fetch_add(1); }
+
+  int64_t num_batches() const { return num_batches_.load(); }
+  int64_t busy_ns() const { return busy_ns_.load(); }
+  int64_t starved_ns() const { return starved_ns_.load(); }
+  int64_t blocked_ns() const { return blocked_ns_.load(); }
+
+  std::string ToString() const {
+    const double busy = busy_ns_.load();
+    const double starved = starved_ns_.load();
+    const double blocked = blocked_ns_.load();
+    const double total = std::max(busy + starved + blocked, 1.0);
+    std::ostringstream ss;
+    ss << "batches " << num_batches_.load() << ", busy " << busy * 100 / total << "%, starved "
+       << starved * 100 / total << "%, blocked " << blocked * 100 / total << "%";
+    return ss.str();
+  }
+
+ private:
+  std::atomic<int64_t> num_batches_;
+  std::atomic<int64_t> busy_ns_;
+  std::atomic<int64_t> starved_ns_;
+  std::atomic<int64_t> blocked_ns_;
+};
+
+// The reader is a pipeline of
+//   load:  one thread pulling batches out of loader_ (datasets are not thread safe),
+//   parse: num_parse_threads workers calling parser_->Prepare on different batches,
+//   read:  Read on the actor thread handing the results over to the output tensors.
+// Batches are dispatched to and collected from the parse workers round-robin, so the order in
+// which the loader produces them is preserved.
 template<typename LoadTarget>
 class DataReader {
  public:
   using LoadTargetPtr = std::shared_ptr<LoadTarget>;
   using LoadTargetPtrList = std::vector<LoadTargetPtr>;
   DataReader(user_op::KernelInitContext* ctx)
-      : is_closed_(false), batch_buffer_(kDataReaderBatchBufferSize) {}
+      : is_closed_(false),
+        load_queue_idx_(0),
+        read_queue_idx_(0),
+        num_read_batches_(0),
+        sum_queue_occupancy_(0) {}
   virtual ~DataReader() {
     Close();
     if (load_thrd_.joinable()) { load_thrd_.join(); }
+    for (auto& parse_thrd : parse_thrds_) { parse_thrd.join(); }
   }
 
   void Read(user_op::KernelComputeContext* ctx) {
     CHECK(load_thrd_.joinable()) << "You should call StartLoadThread before read data";
-    auto batch_data = FetchBatchData();
-    parser_->Parse(batch_data, ctx);
+    const double start = GetCurTime();
+    auto batch = FetchBatch();
+    const double fetched = GetCurTime();
+    if (batch.prepared) {
+      parser_->ParsePrepared(batch.data, batch.prepared, ctx);
+    } else {
+      parser_->Parse(batch.data, ctx);
+    }
+    read_stats_.AddStarved(fetched - start);
+    read_stats_.AddBusy(GetCurTime() - fetched);
+    read_stats_.IncreaseNumBatches();
+    num_read_batches_ += 1;
+    if (conf_.stats_log_interval > 0 && num_read_batches_ % conf_.stats_log_interval == 0) {
+      LOG(INFO) << StatsToString();
+    }
   }
 
   void Close() {
     is_closed_.store(true);
-    bool buffer_drained = false;
-    while (!buffer_drained) {
-      std::shared_ptr<LoadTargetPtrList> abandoned_batch_data(nullptr);
-      auto status = batch_buffer_.TryReceive(&abandoned_batch_data);
-      CHECK_NE(status, BufferStatus::kBufferStatusErrorClosed);
-      buffer_drained = (status == BufferStatus::kBufferStatusEmpty);
+    for (auto& queue : load_queues_) { DrainAndClose(queue.get()); }
+    for (auto& queue : parse_queues_) { DrainAndClose(queue.get()); }
+  }
+
+  std::string StatsToString() const {
+    std::ostringstream ss;
+    ss << "DataReader pipeline stats:";
+    ss << "\n  load: " << load_stats_.ToString();
+    if (!parse_thrds_.empty()) { ss << "\n  parse: " << parse_stats_.ToString(); }
+    ss << "\n  read: " << read_stats_.ToString();
+    if (num_read_batches_ > 0) {
+      ss << "\n  mean queued batches: "
+         << static_cast<double>(sum_queue_occupancy_) / num_read_batches_;
     }
-    batch_buffer_.Close();
+    return ss.str();
   }
 
+  const DataReaderStageStats& load_stats() const { return load_stats_; }
+  const DataReaderStageStats& parse_stats() const { return parse_stats_; }
+  const DataReaderStageStats& read_stats() const { return read_stats_; }
+
  protected:
-  void StartLoadThread() {
+  void StartLoadThread() { StartLoadThread(DataReaderPipelineConf()); }
+  void StartLoadThread(const DataReaderPipelineConf& conf) {
     if (load_thrd_.joinable()) { return; }
+    CHECK_GE(conf.num_parse_threads, 0);
+    CHECK_GT(conf.buffer_size, 0);
+    conf_ = conf;
+    const int32_t num_load_queues = std::max<int32_t>(conf_.num_parse_threads, 1);
+    FOR_RANGE(int32_t, i, 0, num_load_queues) {
+      load_queues_.emplace_back(new Buffer<BatchData>(conf_.buffer_size));
+    }
+    FOR_RANGE(int32_t, i, 0, conf_.num_parse_threads) {
+      parse_queues_.emplace_back(new Buffer<BatchData>(conf_.buffer_size));
+    }
+    FOR_RANGE(int32_t, i, 0, conf_.num_parse_threads) {
+      parse_thrds_.emplace_back([this, i] { ParseLoop(i); });
+    }
     load_thrd_ = std::thread([this] {
       while (!is_closed_.load() && LoadBatch()) {}
     });
@@ -68,21 +161,76 @@ class DataReader {
   std::unique_ptr<Parser<LoadTarget>> parser_;
 
  private:
-  std::shared_ptr<LoadTargetPtrList> FetchBatchData() {
-    std::shared_ptr<LoadTargetPtrList> batch_data(nullptr);
-    CHECK_EQ(batch_buffer_.Receive(&batch_data), BufferStatus::kBufferStatusSuccess);
-    return batch_data;
+  struct BatchData {
+    std::shared_ptr<LoadTargetPtrList> data;
+    std::shared_ptr<PreparedBatch> prepared;
+  };
+
+  static void DrainAndClose(Buffer<BatchData>* queue) {
+    bool buffer_drained = false;
+    while (!buffer_drained) {
+      BatchData abandoned_batch;
+      auto status = queue->TryReceive(&abandoned_batch);
+      CHECK_NE(status, BufferStatus::kBufferStatusErrorClosed);
+      buffer_drained = (status == BufferStatus::kBufferStatusEmpty);
+    }
+    queue->Close();
+  }
+
+  BatchData FetchBatch() {
+    auto& queues = parse_queues_.empty() ? load_queues_ : parse_queues_;
+    for (const auto& queue : queues) { sum_queue_occupancy_ += queue->Size(); }
+    BatchData batch;
+    CHECK_EQ(queues.at(read_queue_idx_)->Receive(&batch), BufferStatus::kBufferStatusSuccess);
+    read_queue_idx_ = (read_queue_idx_ + 1) % queues.size();
+    return batch;
   }
 
   bool LoadBatch() {
-    std::shared_ptr<LoadTargetPtrList> batch_data =
-        std::make_shared<LoadTargetPtrList>(std::move(loader_->Next()));
-    return batch_buffer_.Send(batch_data) == BufferStatus::kBufferStatusSuccess;
+    const double start = GetCurTime();
+    BatchData batch;
+    batch.data = std::make_shared<LoadTargetPtrList>(std::move(loader_->Next()));
+    const double loaded = GetCurTime();
+    // Counted before it is handed over, so the consumer never sees more batches than counted.
+    load_stats_.AddBusy(loaded - start);
+    load_stats_.IncreaseNumBatches();
+    auto status = load_queues_.at(load_queue_idx_)->Send(batch);
+    load_queue_idx_ = (load_queue_idx_ + 1) % load_queues_.size();
+    load_stats_.AddBlocked(GetCurTime() - loaded);
+    return status == BufferStatus::kBufferStatusSuccess;
+  }
+
+  void ParseLoop(int32_t worker_idx) {
+    Buffer<BatchData>* in_queue = load_queues_.at(worker_idx).get();
+    Buffer<BatchData>* out_queue = parse_queues_.at(worker_idx).get();
+    while (true) {
+      const double start = GetCurTime();
+      BatchData batch;
+      if (in_queue->Receive(&batch) != BufferStatus::kBufferStatusSuccess) { break; }
+      const double received = GetCurTime();
+      batch.prepared = parser_->Prepare(*batch.data);
+      const double prepared = GetCurTime();
+      parse_stats_.AddStarved(received - start);
+      parse_stats_.AddBusy(prepared - received);
+      parse_stats_.IncreaseNumBatches();
+      if (out_queue->Send(batch) != BufferStatus::kBufferStatusSuccess) { break; }
+      parse_stats_.AddBlocked(GetCurTime() - prepared);
+    }
   }
 
   std::atomic<bool> is_closed_;
-  Buffer<std::shared_ptr<LoadTargetPtrList>> batch_buffer_;
+  DataReaderPipelineConf conf_;
+  std::vector<std::unique_ptr<Buffer<BatchData>>> load_queues_;
+  std::vector<std::unique_ptr<Buffer<BatchData>>> parse_queues_;
   std::thread load_thrd_;
+  std::vector<std::thread> parse_thrds_;
+  size_t load_queue_idx_;
+  size_t read_queue_idx_;
+  int64_t num_read_batches_;
+  int64_t sum_queue_occupancy_;
+  DataReaderStageStats load_stats_;
+  DataReaderStageStats parse_stats_;
+  DataReaderStageStats read_stats_;
 };
 
 }  // namespace data
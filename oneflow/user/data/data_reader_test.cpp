@@ -0,0 +1,123 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/data/data_reader.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+constexpr int64_t kBatchSize = 4;
+
+class CountingDataset final : public Dataset<int64_t> {
+ public:
+  CountingDataset() : next_value_(0) {}
+  ~CountingDataset() override = default;
+
+  LoadTargetPtrList Next() override {
+    LoadTargetPtrList batch;
+    FOR_RANGE(int64_t, i, 0, kBatchSize) { batch.emplace_back(new int64_t(next_value_++)); }
+    return batch;
+  }
+
+ private:
+  int64_t next_value_;
+};
+
+struct NegatedBatch final : public PreparedBatch {
+  std::vector<int64_t> values;
+};
+
+// Negates the values, in Prepare when the reader has parse workers and in Parse otherwise.
+class NegatingParser final : public Parser<int64_t> {
+ public:
+  NegatingParser() = default;
+  ~NegatingParser() override = default;
+
+  void Parse(std::shared_ptr<LoadTargetPtrList> batch_data,
+             user_op::KernelComputeContext* ctx) override {
+    for (const auto& value : *batch_data) { parsed_.push_back(-*value); }
+  }
+
+  std::shared_ptr<PreparedBatch> Prepare(const LoadTargetPtrList& batch_data) const override {
+    auto prepared = std::make_shared<NegatedBatch>();
+    for (const auto& value : batch_data) { prepared->values.push_back(-*value); }
+    // Uneven work, so that the workers finish their batches out of order.
+    std::this_thread::sleep_for(std::chrono::microseconds(*batch_data.front() % 7 * 50));
+    return prepared;
+  }
+
+  void ParsePrepared(std::shared_ptr<LoadTargetPtrList> batch_data,
+                     std::shared_ptr<PreparedBatch> prepared,
+                     user_op::KernelComputeContext* ctx) override {
+    const auto& values = dynamic_cast<const NegatedBatch&>(*prepared).values;
+    parsed_.insert(parsed_.end(), values.begin(), values.end());
+  }
+
+  const std::vector<int64_t>& parsed() const { return parsed_; }
+
+ private:
+  std::vector<int64_t> parsed_;
+};
+
+class CountingDataReader final : public DataReader<int64_t> {
+ public:
+  CountingDataReader(int32_t num_parse_threads) : DataReader<int64_t>(nullptr) {
+    loader_.reset(new CountingDataset());
+    parser_.reset(new NegatingParser());
+    DataReaderPipelineConf conf;
+    conf.num_parse_threads = num_parse_threads;
+    StartLoadThread(conf);
+  }
+  ~CountingDataReader() override = default;
+
+  const std::vector<int64_t>& parsed() const {
+    return dynamic_cast<const NegatingParser&>(*parser_).parsed();
+  }
+};
+
+void TestParseThreads(int32_t num_parse_threads) {
+  const int64_t num_batches = 64;
+  CountingDataReader reader(num_parse_threads);
+  FOR_RANGE(int64_t, i, 0, num_batches) { reader.Read(nullptr); }
+
+  std::vector<int64_t> expected;
+  FOR_RANGE(int64_t, i, 0, num_batches * kBatchSize) { expected.push_back(-i); }
+  ASSERT_EQ(reader.parsed(), expected);
+
+  ASSERT_EQ(reader.read_stats().num_batches(), num_batches);
+  ASSERT_GE(reader.load_stats().num_batches(), num_batches);
+  if (num_parse_threads > 0) {
+    ASSERT_GE(reader.parse_stats().num_batches(), num_batches);
+    ASSERT_GT(reader.parse_stats().busy_ns(), 0);
+    ASSERT_NE(reader.StatsToString().find("parse: batches"), std::string::npos);
+  } else {
+    ASSERT_EQ(reader.parse_stats().num_batches(), 0);
+    ASSERT_EQ(reader.StatsToString().find("parse: batches"), std::string::npos);
+  }
+}
+
+}  // namespace
+
+TEST(DataReader, parse_on_actor_thread) { TestParseThreads(0); }
+
+TEST(DataReader, parse_threads_keep_batch_order) {
+  TestParseThreads(1);
+  TestParseThreads(4);
+}
+
+}  // namespace data
+}  // namespace oneflow
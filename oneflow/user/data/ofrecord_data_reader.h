@@ -36,7 +36,11 @@ class OFRecordDataReader final : public DataReader<TensorBuffer> {
     }
     int32_t batch_size = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape().elem_cnt();
     loader_.reset(new BatchDataset<TensorBuffer>(batch_size, std::move(loader_)));
-    StartLoadThread();
+    DataReaderPipelineConf pipeline_conf;
+    pipeline_conf.num_parse_threads = ctx->Attr<int32_t>("num_parse_threads");
+    pipeline_conf.buffer_size = ctx->Attr<int32_t>("prefetch_buffer_size");
+    pipeline_conf.stats_log_interval = ctx->Attr<int64_t>("stats_log_interval");
+    StartLoadThread(pipeline_conf);
   }
   ~OFRecordDataReader() = default;
 
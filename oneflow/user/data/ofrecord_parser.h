@@ -24,6 +24,14 @@ limitations under the License.
 namespace oneflow {
 namespace data {
 
+class OFRecordPreparedBatch final : public PreparedBatch {
+ public:
+  explicit OFRecordPreparedBatch(size_t size) : records(size) {}
+  ~OFRecordPreparedBatch() override = default;
+
+  std::vector<OFRecord> records;
+};
+
 class OFRecordParser final : public Parser<TensorBuffer> {
  public:
   using LoadTargetPtr = std::shared_ptr<TensorBuffer>;
@@ -44,6 +52,31 @@ class OFRecordParser final : public Parser<TensorBuffer> {
       out_tensor->mut_shape()->Set(0, batch_data->size());
     }
   }
+
+  std::shared_ptr<PreparedBatch> Prepare(const LoadTargetPtrList& batch_data) const override {
+    std::shared_ptr<OFRecordPreparedBatch> prepared(new OFRecordPreparedBatch(batch_data.size()));
+    FOR_RANGE(size_t, i, 0, batch_data.size()) {
+      const TensorBuffer* buffer = batch_data.at(i).get();
+      CHECK(prepared->records.at(i).ParseFromArray(buffer->data<char>(),
+                                                   buffer->shape().elem_cnt()));
+    }
+    return prepared;
+  }
+
+  void ParsePrepared(std::shared_ptr<LoadTargetPtrList> batch_data,
+                     std::shared_ptr<PreparedBatch> prepared,
+                     user_op::KernelComputeContext* ctx) override {
+    auto* ofrecord_batch = dynamic_cast<OFRecordPreparedBatch*>(prepared.get());
+    CHECK_NOTNULL(ofrecord_batch);
+    CHECK_EQ(ofrecord_batch->records.size(), batch_data->size());
+    user_op::Tensor* out_tensor = ctx->Tensor4ArgNameAndIndex("out", 0);
+    OFRecord* dptr = out_tensor->mut_dptr<OFRecord>();
+    FOR_RANGE(size_t, i, 0, batch_data->size()) { dptr[i].Swap(&ofrecord_batch->records.at(i)); }
+    if (batch_data->size() != out_tensor->shape().elem_cnt()) {
+      CHECK_EQ(out_tensor->mut_shape()->NumAxes(), 1);
+      out_tensor->mut_shape()->Set(0, batch_data->size());
+    }
+  }
 };
 
 }  // namespace data
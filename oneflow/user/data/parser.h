@@ -22,6 +22,13 @@ limitations under the License.
 namespace oneflow {
 namespace data {
 
+// Result of the context-free part of parsing a batch, see Parser::Prepare.
+class PreparedBatch {
+ public:
+  PreparedBatch() = default;
+  virtual ~PreparedBatch() = default;
+};
+
 template<typename LoadTarget>
 class Parser {
  public:
@@ -32,6 +39,18 @@ class Parser {
 
   virtual void Parse(std::shared_ptr<LoadTargetPtrList> batch_data,
                      user_op::KernelComputeContext* ctx) = 0;
+
+  // Work that does not depend on the output tensors (deserialization, decoding, ...). DataReader
+  // calls it on its parse workers, concurrently for different batches, and hands the result to
+  // ParsePrepared on the actor thread. Returning nullptr means everything is done in Parse.
+  virtual std::shared_ptr<PreparedBatch> Prepare(const LoadTargetPtrList& batch_data) const {
+    return nullptr;
+  }
+  virtual void ParsePrepared(std::shared_ptr<LoadTargetPtrList> batch_data,
+                             std::shared_ptr<PreparedBatch> prepared,
+                             user_op::KernelComputeContext* ctx) {
+    Parse(batch_data, ctx);
+  }
 };
 
 }  // namespace data
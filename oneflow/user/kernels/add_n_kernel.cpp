@@ -27,6 +27,16 @@ void cpu_add(const int64_t n, T* out, const std::vector<const T*>& in) {
   }
 }
 
+// Accumulated in float and rounded once.
+template<>
+void cpu_add<bfloat16>(const int64_t n, bfloat16* out, const std::vector<const bfloat16*>& in) {
+  for (int64_t i = 0; i != n; ++i) {
+    float sum = in.at(0)[i];
+    for (int32_t j = 1; j < in.size(); ++j) { sum += in.at(j)[i]; }
+    out[i] = sum;
+  }
+}
+
 }  // namespace
 
 template<typename T>
@@ -65,6 +75,6 @@ class CpuAddNKernel : public user_op::OpKernel {
         return Maybe<void>::Ok();                                                               \
       });
 
-OF_PP_FOR_EACH_TUPLE(REGISTER_CPU_ADDN_KERNEL, ARITHMETIC_DATA_TYPE_SEQ);
+OF_PP_FOR_EACH_TUPLE(REGISTER_CPU_ADDN_KERNEL, ARITHMETIC_DATA_TYPE_SEQ BFLOAT16_DATA_TYPE_SEQ);
 
 }  // namespace oneflow
@@ -15,9 +15,58 @@ limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/kernel/new_kernel_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/kernels/cpu_sort_util.h"
 
 namespace oneflow {
 
+namespace {
+
+template<typename T>
+void ArgSortRowByComparison(const T* in_ptr, int32_t instance_size, bool is_ascending,
+                            int32_t* out_ptr) {
+  std::iota(out_ptr, out_ptr + instance_size, 0);
+  auto comp = [&](const int32_t lhs, const int32_t rhs) {
+    const T l = in_ptr[lhs];
+    const T r = in_ptr[rhs];
+    if (l == r) {
+      return lhs < rhs;
+    } else {
+      return is_ascending ? l < r : l > r;
+    }
+  };
+  std::sort(out_ptr, out_ptr + instance_size, comp);
+}
+
+// The radix sort is stable, so equal values keep the order of their indices as with the
+// comparison above. The keys of a descending sort are flipped, and -0.0 is keyed as 0.0 since
+// they compare equal.
+template<typename T>
+void ArgSortRowByRadix(const T* in_ptr, int32_t instance_size, bool is_ascending,
+                       typename RadixSortKey<T>::Key* keys,
+                       typename RadixSortKey<T>::Key* keys_tmp, int32_t* indices_tmp,
+                       int32_t* out_ptr) {
+  using Key = typename RadixSortKey<T>::Key;
+  const Key flip = is_ascending ? 0 : static_cast<Key>(~Key(0));
+  FOR_RANGE(int32_t, j, 0, instance_size) {
+    const T x = in_ptr[j] == static_cast<T>(0) ? static_cast<T>(0) : in_ptr[j];
+    keys[j] = static_cast<Key>(RadixSortKey<T>::Encode(x) ^ flip);
+  }
+  std::iota(out_ptr, out_ptr + instance_size, 0);
+  RadixSortPairs(instance_size, keys, keys_tmp, out_ptr, indices_tmp);
+}
+
+template<typename T>
+size_t InferArgSortTmpSize(user_op::InferContext* ctx) {
+  const Shape* in_shape = ctx->Shape4ArgNameAndIndex("in", 0);
+  if (in_shape->dim_vec().back() < kCpuRadixArgSortMinSize) { return 0; }
+  const int64_t elem_cnt = in_shape->elem_cnt();
+  return 2 * GetCudaAlignedSize(elem_cnt * sizeof(T))
+         + GetCudaAlignedSize(elem_cnt * sizeof(int32_t));
+}
+
+}  // namespace
+
 template<typename T>
 class CpuArgSortKernel final : public user_op::OpKernel {
  public:
@@ -26,47 +75,58 @@ class CpuArgSortKernel final : public user_op::OpKernel {
 
  private:
   void Compute(user_op::KernelComputeContext* ctx) const override {
+    using Key = typename RadixSortKey<T>::Key;
     const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
     user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
 
     const int32_t instance_size = in->shape().At(in->shape().NumAxes() - 1);
     const int32_t instance_num = in->shape().elem_cnt() / instance_size;
     const std::string& direction = ctx->Attr<std::string>("direction");
+    CHECK(direction == "ASCENDING" || direction == "DESCENDING");
     const bool is_ascending = direction == "ASCENDING";
-    const bool is_descending = direction == "DESCENDING";
-    FOR_RANGE(int32_t, i, 0, instance_num) {
-      const T* in_ptr_i = in->dptr<T>() + i * instance_size;
-      int32_t* out_ptr_i = out->mut_dptr<int32_t>() + i * instance_size;
-      std::iota(out_ptr_i, out_ptr_i + instance_size, 0);
-      auto comp = [&](const int32_t lhs, const int32_t rhs) {
-        const T l = in_ptr_i[lhs];
-        const T r = in_ptr_i[rhs];
-        if (l == r) {
-          return lhs < rhs;
-        } else {
-          if (is_ascending) {
-            return l < r;
-          } else if (is_descending) {
-            return l > r;
-          } else {
-            UNIMPLEMENTED();
-          }
-        }
-      };
-      std::sort(out_ptr_i, out_ptr_i + instance_size, comp);
+    const bool use_radix = instance_size >= kCpuRadixArgSortMinSize;
+    Key* keys = nullptr;
+    Key* keys_tmp = nullptr;
+    int32_t* indices_tmp = nullptr;
+    if (use_radix) {
+      const int64_t elem_cnt = in->shape().elem_cnt();
+      char* tmp_ptr = tmp_buffer->mut_dptr<char>();
+      keys = reinterpret_cast<Key*>(tmp_ptr);
+      keys_tmp = reinterpret_cast<Key*>(tmp_ptr + GetCudaAlignedSize(elem_cnt * sizeof(T)));
+      indices_tmp =
+          reinterpret_cast<int32_t*>(tmp_ptr + 2 * GetCudaAlignedSize(elem_cnt * sizeof(T)));
     }
+    MultiThreadLoopInRanges(
+        instance_num, GetNumThreadRanges(instance_num, instance_size),
+        [&](int64_t, int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, i, begin, end) {
+            const int64_t offset = i * instance_size;
+            const T* in_ptr_i = in->dptr<T>() + offset;
+            int32_t* out_ptr_i = out->mut_dptr<int32_t>() + offset;
+            if (use_radix) {
+              ArgSortRowByRadix(in_ptr_i, instance_size, is_ascending, keys + offset,
+                                keys_tmp + offset, indices_tmp + offset, out_ptr_i);
+            } else {
+              ArgSortRowByComparison(in_ptr_i, instance_size, is_ascending, out_ptr_i);
+            }
+          }
+        });
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
 
-#define REGISTER_CPU_ARG_SORT_KERNEL(dtype)               \
-  REGISTER_USER_KERNEL("arg_sort")                        \
-      .SetCreateFn<CpuArgSortKernel<dtype>>()             \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu") \
-                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value));
+#define REGISTER_CPU_ARG_SORT_KERNEL(dtype)                                            \
+  REGISTER_USER_KERNEL("arg_sort")                                                     \
+      .SetCreateFn<CpuArgSortKernel<dtype>>()                                          \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn(InferArgSortTmpSize<dtype>);
 
 REGISTER_CPU_ARG_SORT_KERNEL(float)
 REGISTER_CPU_ARG_SORT_KERNEL(double)
+REGISTER_CPU_ARG_SORT_KERNEL(int8_t)
+REGISTER_CPU_ARG_SORT_KERNEL(uint8_t)
 REGISTER_CPU_ARG_SORT_KERNEL(int32_t)
 REGISTER_CPU_ARG_SORT_KERNEL(int64_t)
 
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/core/kernel/util/host_bfloat16_util.h"
 
 namespace oneflow {
 
@@ -32,6 +33,22 @@ struct CopyTensor<DeviceType::kCPU, T, U> {
   }
 };
 
+template<>
+struct CopyTensor<DeviceType::kCPU, float, bfloat16> {
+  static void Call(DeviceCtx* ctx, const Tensor* src, Tensor* dst) {
+    host_bfloat16::FloatToBFloat16(src->dptr<float>(), src->shape().elem_cnt(),
+                                   dst->mut_dptr<bfloat16>());
+  }
+};
+
+template<>
+struct CopyTensor<DeviceType::kCPU, bfloat16, float> {
+  static void Call(DeviceCtx* ctx, const Tensor* src, Tensor* dst) {
+    host_bfloat16::BFloat16ToFloat(src->dptr<bfloat16>(), src->shape().elem_cnt(),
+                                   dst->mut_dptr<float>());
+  }
+};
+
 template<typename T, typename U>
 struct CopyTensor<DeviceType::kGPU, T, U> {
   static void Call(DeviceCtx* ctx, const Tensor* src, Tensor* dst) {
@@ -67,6 +84,26 @@ struct CastUtil final {
   }
 };
 
+namespace {
+
+// bfloat16 only has cpu kernels.
+void SwitchCopyBFloat16Tensor(const std::pair<DataType, DataType>& key, DeviceCtx* ctx,
+                              const Tensor* src, Tensor* dst) {
+  constexpr DeviceType device_type = DeviceType::kCPU;
+  static const std::map<std::pair<DataType, DataType>,
+                        std::function<void(DeviceCtx*, const Tensor*, Tensor*)>>
+      case_handler{
+          // clang-format off
+          OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(MAKE_CASE_HANDLER_ENTRY, POD_DATA_TYPE_SEQ, BFLOAT16_DATA_TYPE_SEQ)
+          OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(MAKE_CASE_HANDLER_ENTRY, BFLOAT16_DATA_TYPE_SEQ, POD_DATA_TYPE_SEQ)
+          MAKE_CASE_HANDLER_ENTRY((bfloat16, DataType::kBFloat16), (bfloat16, DataType::kBFloat16))
+          // clang-format on
+      };
+  case_handler.at(key)(ctx, src, dst);
+}
+
+}  // namespace
+
 template<DeviceType device_type>
 class CastKernel final : public OpKernel {
  public:
@@ -77,9 +114,13 @@ class CastKernel final : public OpKernel {
   void Compute(KernelComputeContext* ctx) const override {
     const Tensor* input_tensor = ctx->Tensor4ArgNameAndIndex("in", 0);
     Tensor* output_tenor = ctx->Tensor4ArgNameAndIndex("out", 0);
-    CastUtil<device_type>::SwitchCopyTensor(
-        std::make_pair(input_tensor->data_type(), output_tenor->data_type()), ctx->device_ctx(),
-        input_tensor, output_tenor);
+    const auto key = std::make_pair(input_tensor->data_type(), output_tenor->data_type());
+    if (key.first == DataType::kBFloat16 || key.second == DataType::kBFloat16) {
+      CHECK_EQ(device_type, DeviceType::kCPU);
+      SwitchCopyBFloat16Tensor(key, ctx->device_ctx(), input_tensor, output_tenor);
+    } else {
+      CastUtil<device_type>::SwitchCopyTensor(key, ctx->device_ctx(), input_tensor, output_tenor);
+    }
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
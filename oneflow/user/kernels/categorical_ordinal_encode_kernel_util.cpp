@@ -14,38 +14,58 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/user/kernels/categorical_ordinal_encode_kernel_util.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
+namespace {
+
+// The table is an array of (hash, ordinal) pairs shared with the gpu kernel, a hash of 0 marks an
+// empty pair. The probe starts from hash % capacity as on the gpu, and moves to the next pair
+// without taking the modulo again.
+template<typename T>
+int64_t FindPair(const int64_t capacity, const T* table, const T hash) {
+  size_t idx = static_cast<size_t>(hash) % static_cast<size_t>(capacity);
+  for (int64_t count = 0; count < capacity; ++count) {
+    const T key = table[idx * 2];
+    if (key == hash || key == 0) { return static_cast<int64_t>(idx); }
+    idx += 1;
+    if (idx == static_cast<size_t>(capacity)) { idx = 0; }
+  }
+  return -1;
+}
+
+}  // namespace
+
 template<typename T>
 struct CategoricalOrdinalEncodeKernelUtil<DeviceType::kCPU, T> {
   static void Encode(DeviceCtx* ctx, int64_t capacity, T* table, T* size, int64_t n, const T* hash,
                      T* out) {
-    for (int64_t i = 0; i < n; ++i) {
+    // Most of the hashes of a batch already are in the table, they are looked up in the thread
+    // pool without changing it, a miss leaves 0 in out. A hash of 0 is encoded as 0.
+    const int64_t num_ranges = GetNumThreadRanges(n, 1);
+    MultiThreadLoopInRanges(n, num_ranges, [&](int64_t, int64_t begin, int64_t end) {
+      FOR_RANGE(int64_t, i, begin, end) {
+        const T h = hash[i];
+        const int64_t idx = h == 0 ? -1 : FindPair<T>(capacity, table, h);
+        out[i] = (idx >= 0 && table[idx * 2] == h) ? table[idx * 2 + 1] : 0;
+      }
+    });
+    // The misses are inserted in the order of the input, so that the ordinals are the same as
+    // those of encoding the hashes one by one.
+    FOR_RANGE(int64_t, i, 0, n) {
       const T h = hash[i];
-      bool success = false;
-      for (int64_t count = 0; count < capacity; ++count) {
-        size_t idx =
-            (static_cast<size_t>(h) + static_cast<size_t>(count)) % static_cast<size_t>(capacity);
-        T* k_ptr = table + idx * 2;
-        T* v_ptr = k_ptr + 1;
-        if (*k_ptr == h) {
-          out[i] = *v_ptr;
-          success = true;
-          break;
-        } else if (*k_ptr == 0) {
-          T new_size = *size + 1;
-          *k_ptr = h;
-          *v_ptr = new_size;
-          out[i] = new_size;
-          *size = new_size;
-          success = true;
-          break;
-        } else {
-          continue;
-        }
+      if (out[i] != 0 || h == 0) { continue; }
+      const int64_t idx = FindPair<T>(capacity, table, h);
+      CHECK_GE(idx, 0);
+      T* pair = table + idx * 2;
+      if (pair[0] == 0) {
+        const T new_size = *size + 1;
+        pair[0] = h;
+        pair[1] = new_size;
+        *size = new_size;
       }
-      CHECK(success);
+      out[i] = pair[1];
     }
   }
 };
@@ -17,6 +17,10 @@ limitations under the License.
 #include "oneflow/user/ops/nn_util.h"
 #include "oneflow/core/kernel/new_kernel_util.h"
 #include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/core/device/cpu_conv_util.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
@@ -74,6 +78,56 @@ size_t CalcElemNumOfColBuf(const ShapeView& out_shape, const ShapeView& weight_s
   return col_buf_elem_cnt;
 }
 
+Shape Gen5DShape(const Shape& shape, int32_t idx_offset) {
+  DimVector ret_vec(shape.dim_vec());
+  int32_t ndims = ret_vec.size() - 2;
+  ret_vec.insert(ret_vec.begin() + idx_offset, 3 - ndims, 1);
+  return Shape(ret_vec);
+}
+
+std::vector<int32_t> Gen3DVec(const std::vector<int32_t>& origin_vec) {
+  std::vector<int32_t> ret_vec = origin_vec;
+  ret_vec.insert(ret_vec.begin(), 3 - ret_vec.size(), 1);
+  return ret_vec;
+}
+
+std::vector<int32_t> Gen3DPaddingBefore(const std::vector<int32_t>& padding_before) {
+  std::vector<int32_t> ret_vec;
+  FOR_RANGE(uint8_t, dim, 0, 3) {
+    int64_t index = static_cast<int64_t>(dim) - (3 - padding_before.size());
+    if (index < 0) {
+      ret_vec.push_back(0);
+    } else {
+      ret_vec.push_back(padding_before.at(index));
+    }
+  }
+  return ret_vec;
+}
+
+CpuConvParams GenCpuConvParams(DataType data_type, int32_t idx_offset, const Shape& in_5d_shape,
+                               const Shape& out_5d_shape, const Shape& weight_5d_shape,
+                               const std::vector<int32_t>& strides_3d,
+                               const std::vector<int32_t>& dilation_rate_3d,
+                               const std::vector<int32_t>& padding_before_3d) {
+  return MakeCpuConvParams(data_type, idx_offset == 1, in_5d_shape.dim_vec().data(),
+                           out_5d_shape.dim_vec().data(), weight_5d_shape.dim_vec().data(),
+                           strides_3d.data(), dilation_rate_3d.data(), padding_before_3d.data());
+}
+
+template<typename T>
+CpuConvParams InferCpuConvParams(user_op::InferContext* ctx, const std::string& in_name,
+                                 const std::string& out_name, const std::string& weight_name) {
+  const int32_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));
+  return GenCpuConvParams(
+      GetDataType<T>::value, idx_offset,
+      Gen5DShape(ctx->TensorDesc4ArgNameAndIndex(in_name, 0)->shape(), idx_offset),
+      Gen5DShape(ctx->TensorDesc4ArgNameAndIndex(out_name, 0)->shape(), idx_offset),
+      Gen5DShape(ctx->TensorDesc4ArgNameAndIndex(weight_name, 0)->shape(), idx_offset),
+      Gen3DVec(ctx->Attr<std::vector<int32_t>>("strides")),
+      Gen3DVec(ctx->Attr<std::vector<int32_t>>("dilation_rate")),
+      Gen3DPaddingBefore(ctx->Attr<std::vector<int32_t>>("padding_before")));
+}
+
 template<typename T>
 class ColBufWriter {
  public:
@@ -323,6 +377,11 @@ struct ConvOpKernelState final : public user_op::OpKernelState {
       out_5d_shape_ = Gen5DShape(out_shape, idx_offset_);
     }
   }
+
+  CpuConvParams GetCpuConvParams() const {
+    return GenCpuConvParams(GetDataType<T>::value, idx_offset_, in_5d_shape_, out_5d_shape_,
+                            weight_5d_shape_, strides_3d_, dilation_rate_3d_, padding_before_3d_);
+  }
 };
 
 template<typename T>
@@ -347,12 +406,6 @@ std::shared_ptr<user_op::OpKernelState> CreateConvOpKernelState(user_op::KernelI
     state->idx_offset_ = 1;
   }
 
-  auto Gen5DShape = [](const Shape& shape, int32_t idx_offset) -> Shape {
-    DimVector ret_vec(shape.dim_vec());
-    int32_t ndims = ret_vec.size() - 2;
-    ret_vec.insert(ret_vec.begin() + idx_offset, 3 - ndims, 1);
-    return Shape(ret_vec);
-  };
   state->in_5d_shape_ =
       Gen5DShape(ctx->TensorDesc4ArgNameAndIndex(in_name, 0)->shape(), state->idx_offset_);
   state->out_5d_shape_ =
@@ -360,23 +413,10 @@ std::shared_ptr<user_op::OpKernelState> CreateConvOpKernelState(user_op::KernelI
   state->weight_5d_shape_ =
       Gen5DShape(ctx->TensorDesc4ArgNameAndIndex(weight_name, 0)->shape(), state->idx_offset_);
 
-  auto Gen3DVec = [](const std::vector<int32_t>& origin_vec) -> std::vector<int32_t> {
-    std::vector<int32_t> ret_vec = origin_vec;
-    ret_vec.insert(ret_vec.begin(), 3 - ret_vec.size(), 1);
-    return ret_vec;
-  };
   state->strides_3d_ = Gen3DVec(ctx->Attr<std::vector<int32_t>>("strides"));
   state->dilation_rate_3d_ = Gen3DVec(ctx->Attr<std::vector<int32_t>>("dilation_rate"));
+  state->padding_before_3d_ = Gen3DPaddingBefore(ctx->Attr<std::vector<int32_t>>("padding_before"));
   state->is_dynamic_ = ctx->TensorDesc4ArgNameAndIndex(in_name, 0)->is_dynamic();
-  const auto& padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
-  FOR_RANGE(uint8_t, dim, 0, 3) {
-    int64_t index = static_cast<int64_t>(dim) - (3 - padding_before.size());
-    if (index < 0) {
-      state->padding_before_3d_.push_back(0);
-    } else {
-      state->padding_before_3d_.push_back(padding_before.at(index));
-    }
-  }
 
   return std::move(state);
 }
@@ -386,6 +426,273 @@ void InitBiasMulBuf(T* dptr, int64_t num) {
   for (int64_t i = 0; i < num; ++i) { dptr[i] = 1; }
 }
 
+// Winograd F(m x m, 3 x 3): y = AT * [(G * g * GT) . (BT * d * B)] * A on tiles d of alpha x alpha
+// inputs, alpha = m + 2, producing m x m outputs each.
+template<int32_t kTileSize>
+struct WinogradMatrices;
+
+template<>
+struct WinogradMatrices<2> {
+  static const int32_t kAlpha = 4;
+  static const double kBT[4][4];
+  static const double kG[4][3];
+  static const double kAT[2][4];
+};
+
+const double WinogradMatrices<2>::kBT[4][4] = {
+    {1, 0, -1, 0}, {0, 1, 1, 0}, {0, -1, 1, 0}, {0, 1, 0, -1}};
+const double WinogradMatrices<2>::kG[4][3] = {
+    {1, 0, 0}, {0.5, 0.5, 0.5}, {0.5, -0.5, 0.5}, {0, 0, 1}};
+const double WinogradMatrices<2>::kAT[2][4] = {{1, 1, 1, 0}, {0, 1, -1, -1}};
+
+template<>
+struct WinogradMatrices<4> {
+  static const int32_t kAlpha = 6;
+  static const double kBT[6][6];
+  static const double kG[6][3];
+  static const double kAT[4][6];
+};
+
+const double WinogradMatrices<4>::kBT[6][6] = {
+    {4, 0, -5, 0, 1, 0},  {0, -4, -4, 1, 1, 0}, {0, 4, -4, -1, 1, 0},
+    {0, -2, -1, 2, 1, 0}, {0, 2, -1, -2, 1, 0}, {0, 4, 0, -5, 0, 1}};
+const double WinogradMatrices<4>::kG[6][3] = {
+    {1.0 / 4, 0, 0},
+    {-1.0 / 6, -1.0 / 6, -1.0 / 6},
+    {-1.0 / 6, 1.0 / 6, -1.0 / 6},
+    {1.0 / 24, 1.0 / 12, 1.0 / 6},
+    {1.0 / 24, -1.0 / 12, 1.0 / 6},
+    {0, 0, 1}};
+const double WinogradMatrices<4>::kAT[4][6] = {
+    {1, 1, 1, 1, 1, 0}, {0, 1, -1, 2, -2, 0}, {0, 1, 1, 4, 4, 0}, {0, 1, -1, 8, -8, 1}};
+
+// y = l * x * lT
+template<typename T, int32_t R, int32_t C>
+void WinogradSandwich(const double (&l)[R][C], const T (&x)[C][C], T (&y)[R][R]) {
+  T tmp[R][C];
+  FOR_RANGE(int32_t, i, 0, R) {
+    FOR_RANGE(int32_t, j, 0, C) {
+      T sum = 0;
+      FOR_RANGE(int32_t, k, 0, C) { sum += static_cast<T>(l[i][k]) * x[k][j]; }
+      tmp[i][j] = sum;
+    }
+  }
+  FOR_RANGE(int32_t, i, 0, R) {
+    FOR_RANGE(int32_t, j, 0, R) {
+      T sum = 0;
+      FOR_RANGE(int32_t, k, 0, C) { sum += tmp[i][k] * static_cast<T>(l[j][k]); }
+      y[i][j] = sum;
+    }
+  }
+}
+
+// The workspace holds the transformed filters U[alpha * alpha][co][ci], input tiles
+// V[alpha * alpha][ci][tiles] and output tiles M[alpha * alpha][co][tiles], every one of the
+// alpha * alpha elements of the tiles is a gemm M = U * V.
+template<typename T, int32_t kTileSize>
+typename std::enable_if<std::is_floating_point<T>::value>::type WinogradConvForward(
+    const ConvOpKernelState<T>& state, const T* in_dptr, const T* weight_dptr,
+    int64_t num_images, T* workspace, T* out_dptr) {
+  using Matrices = WinogradMatrices<kTileSize>;
+  constexpr int32_t kAlpha = Matrices::kAlpha;
+  constexpr int32_t kNumTileElems = kAlpha * kAlpha;
+  const int64_t ci = state.in_5d_shape_.At(1);
+  const int64_t ih = state.in_5d_shape_.At(3);
+  const int64_t iw = state.in_5d_shape_.At(4);
+  const int64_t co = state.out_5d_shape_.At(1);
+  const int64_t oh = state.out_5d_shape_.At(3);
+  const int64_t ow = state.out_5d_shape_.At(4);
+  const int64_t pad_h = state.padding_before_3d_.at(1);
+  const int64_t pad_w = state.padding_before_3d_.at(2);
+  const int64_t tiles_w = RoundUp(ow, kTileSize) / kTileSize;
+  const int64_t num_tiles = RoundUp(oh, kTileSize) / kTileSize * tiles_w;
+  T* u = workspace;
+  T* v = u + kNumTileElems * co * ci;
+  T* m = v + kNumTileElems * ci * num_tiles;
+
+  MultiThreadLoopInRanges(
+      co, GetNumThreadRanges(co, ci * kNumTileElems),
+      [&](int64_t range_id, int64_t begin, int64_t end) {
+        T g[3][3];
+        T tile[kAlpha][kAlpha];
+        FOR_RANGE(int64_t, oc, begin, end) {
+          FOR_RANGE(int64_t, ic, 0, ci) {
+            const T* filter = weight_dptr + (oc * ci + ic) * 9;
+            FOR_RANGE(int32_t, i, 0, 9) { g[i / 3][i % 3] = filter[i]; }
+            WinogradSandwich(Matrices::kG, g, tile);
+            FOR_RANGE(int32_t, e, 0, kNumTileElems) {
+              u[(e * co + oc) * ci + ic] = tile[e / kAlpha][e % kAlpha];
+            }
+          }
+        }
+      });
+  FOR_RANGE(int64_t, n, 0, num_images) {
+    const T* x = in_dptr + n * state.in_5d_shape_.Count(1);
+    T* y = out_dptr + n * state.out_5d_shape_.Count(1);
+    MultiThreadLoopInRanges(
+        ci, GetNumThreadRanges(ci, num_tiles * kNumTileElems),
+        [&](int64_t range_id, int64_t begin, int64_t end) {
+          T d[kAlpha][kAlpha];
+          T tile[kAlpha][kAlpha];
+          FOR_RANGE(int64_t, ic, begin, end) {
+            const T* plane = x + ic * ih * iw;
+            FOR_RANGE(int64_t, t, 0, num_tiles) {
+              const int64_t h0 = t / tiles_w * kTileSize - pad_h;
+              const int64_t w0 = t % tiles_w * kTileSize - pad_w;
+              FOR_RANGE(int32_t, i, 0, kAlpha) {
+                const int64_t h = h0 + i;
+                FOR_RANGE(int32_t, j, 0, kAlpha) {
+                  const int64_t w = w0 + j;
+                  const bool is_valid = h >= 0 && h < ih && w >= 0 && w < iw;
+                  d[i][j] = is_valid ? plane[h * iw + w] : static_cast<T>(0);
+                }
+              }
+              WinogradSandwich(Matrices::kBT, d, tile);
+              FOR_RANGE(int32_t, e, 0, kNumTileElems) {
+                v[(e * ci + ic) * num_tiles + t] = tile[e / kAlpha][e % kAlpha];
+              }
+            }
+          }
+        });
+    FOR_RANGE(int32_t, e, 0, kNumTileElems) {
+      NewKernelUtil<DeviceType::kCPU>::OFGemm(nullptr, CblasNoTrans, CblasNoTrans, co, num_tiles,
+                                              ci, static_cast<T>(1), u + e * co * ci,
+                                              v + e * ci * num_tiles, static_cast<T>(0),
+                                              m + e * co * num_tiles);
+    }
+    MultiThreadLoopInRanges(
+        co, GetNumThreadRanges(co, num_tiles * kNumTileElems),
+        [&](int64_t range_id, int64_t begin, int64_t end) {
+          T tile[kAlpha][kAlpha];
+          T res[kTileSize][kTileSize];
+          FOR_RANGE(int64_t, oc, begin, end) {
+            T* plane = y + oc * oh * ow;
+            FOR_RANGE(int64_t, t, 0, num_tiles) {
+              FOR_RANGE(int32_t, e, 0, kNumTileElems) {
+                tile[e / kAlpha][e % kAlpha] = m[(e * co + oc) * num_tiles + t];
+              }
+              WinogradSandwich(Matrices::kAT, tile, res);
+              const int64_t h0 = t / tiles_w * kTileSize;
+              const int64_t w0 = t % tiles_w * kTileSize;
+              FOR_RANGE(int32_t, i, 0, kTileSize) {
+                if (h0 + i >= oh) { break; }
+                FOR_RANGE(int32_t, j, 0, kTileSize) {
+                  if (w0 + j >= ow) { break; }
+                  plane[(h0 + i) * ow + w0 + j] = res[i][j];
+                }
+              }
+            }
+          }
+        });
+  }
+}
+
+template<typename T, int32_t kTileSize>
+typename std::enable_if<!std::is_floating_point<T>::value>::type WinogradConvForward(
+    const ConvOpKernelState<T>& state, const T* in_dptr, const T* weight_dptr,
+    int64_t num_images, T* workspace, T* out_dptr) {
+  UNIMPLEMENTED();
+}
+
+template<typename T>
+void ConvForward(CpuConvAlgo algo, const ConvOpKernelState<T>& state, const T* in_dptr,
+                 const T* weight_dptr, int64_t num_images, T* workspace, T* out_dptr) {
+  const int32_t idx_offset = state.idx_offset_;
+  const int64_t in_img_size = state.in_5d_shape_.Count(1);
+  const int64_t out_img_size = state.out_5d_shape_.Count(1);
+  switch (algo) {
+    case CpuConvAlgo::kIm2ColGemm: {
+      FOR_RANGE(int64_t, i, 0, num_images) {
+        state.im2col_func_(in_dptr + i * in_img_size, ShapeView(state.in_5d_shape_),
+                           ShapeView(state.weight_5d_shape_), ShapeView(state.out_5d_shape_),
+                           state.strides_3d_.data(), state.dilation_rate_3d_.data(),
+                           state.padding_before_3d_.data(), workspace);
+
+        // channels first: out = weight * col_buf
+        // channels last:  out = (weight * col_buf)(T)
+        state.forward_func_(CblasNoTrans, CblasNoTrans,
+                            state.weight_5d_shape_.At(0),                           // filter
+                            state.out_5d_shape_.Count(idx_offset, idx_offset + 3),  // od * oh * ow
+                            state.weight_5d_shape_.Count(1),  // ci * kd * kh * kw
+                            static_cast<T>(1), weight_dptr, workspace, static_cast<T>(0),
+                            out_dptr + i * out_img_size);
+      }
+      break;
+    }
+    case CpuConvAlgo::kGemm1x1: {
+      FOR_RANGE(int64_t, i, 0, num_images) {
+        // channels first: out = weight * in
+        // channels last:  out = (weight * in(T))(T)
+        state.forward_func_(CblasNoTrans, state.is_out_diff_need_trans_,
+                            state.weight_5d_shape_.At(0),                           // filter
+                            state.out_5d_shape_.Count(idx_offset, idx_offset + 3),  // od * oh * ow
+                            state.weight_5d_shape_.Count(1),                        // ci
+                            static_cast<T>(1), weight_dptr, in_dptr + i * in_img_size,
+                            static_cast<T>(0), out_dptr + i * out_img_size);
+      }
+      break;
+    }
+    case CpuConvAlgo::kWinograd2x2: {
+      WinogradConvForward<T, 2>(state, in_dptr, weight_dptr, num_images, workspace, out_dptr);
+      break;
+    }
+    case CpuConvAlgo::kWinograd4x4: {
+      WinogradConvForward<T, 4>(state, in_dptr, weight_dptr, num_images, workspace, out_dptr);
+      break;
+    }
+    default: UNIMPLEMENTED();
+  }
+}
+
+// Times the candidates fitting the workspace on the first image, the output it writes is
+// overwritten by the chosen algorithm.
+template<typename T>
+CpuConvAlgo SearchCpuConvAlgo(const CpuConvParams& params, const ConvOpKernelState<T>& state,
+                              const T* in_dptr, const T* weight_dptr, T* workspace,
+                              int64_t workspace_elem_cnt, T* out_dptr) {
+  CpuConvAlgo best_algo = CpuConvAlgo::kIm2ColGemm;
+  double best_elapsed = std::numeric_limits<double>::max();
+  for (CpuConvAlgo algo : GetCpuConvAlgoCandidates(params)) {
+    if (GetCpuConvAlgoWorkspaceElemCnt(params, algo) > workspace_elem_cnt) { continue; }
+    // the first run warms up the workspace
+    ConvForward<T>(algo, state, in_dptr, weight_dptr, 1, workspace, out_dptr);
+    const auto start = std::chrono::steady_clock::now();
+    ConvForward<T>(algo, state, in_dptr, weight_dptr, 1, workspace, out_dptr);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (elapsed.count() < best_elapsed) {
+      best_algo = algo;
+      best_elapsed = elapsed.count();
+    }
+  }
+  return best_algo;
+}
+
+// The bias multiplier leads the buffer, the workspace of the algorithm follows. The workspace
+// fits the heuristic algorithm, or every candidate when the conv is autotuned or dynamic.
+template<typename T>
+size_t InferConvTmpSize(user_op::InferContext* ctx) {
+  const CpuConvParams params = InferCpuConvParams<T>(ctx, "in", "out", "weight");
+  std::vector<CpuConvAlgo> algos;
+  if (Global<ResourceDesc, ForSession>::Get()->cpu_conv_heuristic_search_algo()
+      && !ctx->TensorDesc4ArgNameAndIndex("in", 0)->is_dynamic()) {
+    algos.push_back(InferCpuConvAlgoHeuristically(params));
+  } else {
+    algos = GetCpuConvAlgoCandidates(params);
+  }
+  int64_t tmp_buffer_elem_cnt = 0;
+  for (CpuConvAlgo algo : algos) {
+    tmp_buffer_elem_cnt =
+        std::max(tmp_buffer_elem_cnt, GetCpuConvAlgoWorkspaceElemCnt(params, algo));
+  }
+  if (ctx->TensorDesc4ArgNameAndIndex("bias", 0) != nullptr) {
+    const int32_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));
+    tmp_buffer_elem_cnt += Gen5DShape(ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape(),
+                                      idx_offset)
+                               .Count(idx_offset, idx_offset + 3);
+  }
+  return tmp_buffer_elem_cnt * sizeof(T);
+}
+
 template<typename T, size_t NDims>
 class ConvCpuKernel final : public user_op::OpKernel {
  public:
@@ -403,81 +710,61 @@ class ConvCpuKernel final : public user_op::OpKernel {
   void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
     const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
     const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
     user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
     user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
 
-    T* col_buf_dptr = tmp_buffer->mut_dptr<T>();
-
     auto* conv_state = dynamic_cast<ConvOpKernelState<T>*>(state);
-    conv_state->Update(in->shape(), out->shape());
     CHECK_NOTNULL(conv_state);
-    bool is_bias_mul_inited = false;
-    for (int64_t i = 0; i < in->shape().At(0); ++i) {
-      conv_state->im2col_func_(GetImgDptr<T>(in, i), ShapeView(conv_state->in_5d_shape_),
-                               ShapeView(conv_state->weight_5d_shape_),
-                               ShapeView(conv_state->out_5d_shape_), conv_state->strides_3d_.data(),
-                               conv_state->dilation_rate_3d_.data(),
-                               conv_state->padding_before_3d_.data(), col_buf_dptr);
-
-      // channels first: out = weight * col_buf
-      // channels last:  out = (weight * col_buf)(T)
-      int32_t idx_offset = conv_state->idx_offset_;
-      conv_state->forward_func_(
-          CblasNoTrans, CblasNoTrans,
-          conv_state->weight_5d_shape_.At(0),                           // filter
-          conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  // od * oh * ow
-          conv_state->weight_5d_shape_.Count(1),                        // ci * kd * kh * kw
-          static_cast<T>(1), weight->dptr<T>(), col_buf_dptr, static_cast<T>(0),
-          GetImgMutDptr<T>(out, i));
-
-      const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
-      if (bias != nullptr) {
-        int64_t num_of_col_buf = CalcElemNumOfColBuf(out->shape(), weight->shape(), idx_offset);
-        int64_t num_of_bias_mul = tmp_buffer->shape().elem_cnt() - num_of_col_buf;
-        CHECK_GT(num_of_bias_mul, 0);
-        T* bias_mul_dptr = col_buf_dptr + num_of_col_buf * sizeof(T);
-        if (!is_bias_mul_inited) {
-          InitBiasMulBuf(bias_mul_dptr, num_of_bias_mul);
-          is_bias_mul_inited = true;
-        }
-
+    conv_state->Update(in->shape(), out->shape());
+    const int32_t idx_offset = conv_state->idx_offset_;
+    const int64_t bias_mul_elem_cnt =
+        bias == nullptr ? 0 : conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3);
+    T* bias_mul_dptr = tmp_buffer->mut_dptr<T>();
+    T* workspace = bias_mul_dptr + bias_mul_elem_cnt;
+    const int64_t workspace_elem_cnt =
+        tmp_buffer->shape().elem_cnt() / sizeof(T) - bias_mul_elem_cnt;
+
+    const CpuConvParams params = conv_state->GetCpuConvParams();
+    CpuConvAlgo algo;
+    if (Global<ResourceDesc, ForSession>::Get()->cpu_conv_heuristic_search_algo()) {
+      algo = InferCpuConvAlgoHeuristically(params);
+    } else {
+      auto SearchAlgo = [&](const CpuConvParams& conv_params) {
+        return SearchCpuConvAlgo<T>(conv_params, *conv_state, in->dptr<T>(), weight->dptr<T>(),
+                                    workspace, workspace_elem_cnt, out->mut_dptr<T>());
+      };
+      algo = Global<CpuConvAlgoCache>::Get()->Remember(params, SearchAlgo);
+    }
+    CHECK_LE(GetCpuConvAlgoWorkspaceElemCnt(params, algo), workspace_elem_cnt)
+        << "op (" << ctx->op_name() << ") cpu conv algorithm " << static_cast<int32_t>(algo)
+        << " needs a larger workspace";
+    ConvForward<T>(algo, *conv_state, in->dptr<T>(), weight->dptr<T>(), in->shape().At(0),
+                   workspace, out->mut_dptr<T>());
+
+    if (bias != nullptr) {
+      InitBiasMulBuf(bias_mul_dptr, bias_mul_elem_cnt);
+      FOR_RANGE(int64_t, i, 0, in->shape().At(0)) {
         // channels first:  out += bias * bias_mul
         // channels last:   out += (bias * bias_mul)(T)
-        conv_state->forward_func_(
-            CblasNoTrans, CblasNoTrans,
-            conv_state->weight_5d_shape_.At(0),                           // filter
-            conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  // od * oh * ow
-            1,                                                            // 1
-            static_cast<T>(1), bias->dptr<T>(), bias_mul_dptr, static_cast<T>(1),
-            GetImgMutDptr<T>(out, i));
+        conv_state->forward_func_(CblasNoTrans, CblasNoTrans,
+                                  conv_state->weight_5d_shape_.At(0),  // filter
+                                  bias_mul_elem_cnt,                   // od * oh * ow
+                                  1,                                   // 1
+                                  static_cast<T>(1), bias->dptr<T>(), bias_mul_dptr,
+                                  static_cast<T>(1), GetImgMutDptr<T>(out, i));
       }
     }
   }
 };
 
-#define REGISTER_CONV_KERNEL(op_name, dtype, ndims)                                         \
-  REGISTER_USER_KERNEL(#op_name)                                                            \
-      .SetCreateFn<ConvCpuKernel<dtype, ndims>>()                                           \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                   \
-                       & (user_op::HobAttr<int32_t>("groups") == 1)                         \
-                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value))      \
-      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                         \
-        size_t tmp_buffer_size = 0;                                                         \
-        const auto& out_shape = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape();         \
-        const auto& weight_shape = ctx->TensorDesc4ArgNameAndIndex("weight", 0)->shape();   \
-                                                                                            \
-        int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));              \
-        tmp_buffer_size +=                                                                  \
-            CalcElemNumOfColBuf(out_shape, weight_shape, idx_offset) * sizeof(dtype);       \
-                                                                                            \
-        const auto* bias = ctx->TensorDesc4ArgNameAndIndex("bias", 0);                      \
-        if (bias != nullptr) {                                                              \
-          int64_t bias_mul_cnt = 1;                                                         \
-          for (int i = 0; i < ndims; ++i) { bias_mul_cnt *= out_shape.At(idx_offset + i); } \
-          tmp_buffer_size += bias_mul_cnt * sizeof(dtype);                                  \
-        }                                                                                   \
-        return tmp_buffer_size;                                                             \
-      })
+#define REGISTER_CONV_KERNEL(op_name, dtype, ndims)                                    \
+  REGISTER_USER_KERNEL(#op_name)                                                       \
+      .SetCreateFn<ConvCpuKernel<dtype, ndims>>()                                      \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobAttr<int32_t>("groups") == 1)                    \
+                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn(InferConvTmpSize<dtype>)
 
 REGISTER_CONV_KERNEL(conv1d, float, 1);
 REGISTER_CONV_KERNEL(conv2d, float, 2);
@@ -485,6 +772,9 @@ REGISTER_CONV_KERNEL(conv3d, float, 3);
 REGISTER_CONV_KERNEL(conv1d, double, 1);
 REGISTER_CONV_KERNEL(conv2d, double, 2);
 REGISTER_CONV_KERNEL(conv3d, double, 3);
+REGISTER_CONV_KERNEL(conv1d, bfloat16, 1);
+REGISTER_CONV_KERNEL(conv2d, bfloat16, 2);
+REGISTER_CONV_KERNEL(conv3d, bfloat16, 3);
 
 template<typename T>
 class ConvDataGradCpuKernel final : public user_op::OpKernel {
@@ -513,7 +803,26 @@ class ConvDataGradCpuKernel final : public user_op::OpKernel {
                              dx->shape().elem_cnt() * sizeof(T));
 
     int32_t idx_offset = conv_state->idx_offset_;
+    const bool is_1x1 = IsCpuConv1x1(conv_state->GetCpuConvParams());
     FOR_RANGE(int64_t, i, 0, dy->shape().At(0)) {
+      if (is_1x1) {
+        // the gradient of the input of a 1x1 conv is its col_buf'
+        // channels first:  in[i]' = weight(T) * out[i]'
+        // channels last :  in[i]' = out[i]' * weight
+        const int64_t spatial = conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3);
+        if (idx_offset == 2) {
+          NewKernelUtil<DeviceType::kCPU>::OFGemm(
+              nullptr, CblasTrans, CblasNoTrans, conv_state->weight_5d_shape_.Count(1), spatial,
+              conv_state->weight_5d_shape_.At(0), static_cast<T>(1), filter->dptr<T>(),
+              GetImgDptr<T>(dy, i), static_cast<T>(0), GetImgMutDptr<T>(dx, i));
+        } else {
+          NewKernelUtil<DeviceType::kCPU>::OFGemm(
+              nullptr, CblasNoTrans, CblasNoTrans, spatial, conv_state->weight_5d_shape_.Count(1),
+              conv_state->weight_5d_shape_.At(0), static_cast<T>(1), GetImgDptr<T>(dy, i),
+              filter->dptr<T>(), static_cast<T>(0), GetImgMutDptr<T>(dx, i));
+        }
+        continue;
+      }
       // channels first:  col_buf' = weight(T) * out[i]'
       // channels last :  col_buf' = weight(T) * out[i]'(T)
       NewKernelUtil<DeviceType::kCPU>::OFGemm(
@@ -535,32 +844,36 @@ class ConvDataGradCpuKernel final : public user_op::OpKernel {
       const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
       CHECK_EQ(add_to_output->data_type(), dx->data_type());
       CHECK_EQ(add_to_output->shape(), dx->shape());
-      KernelUtil<DeviceType::kCPU, T>::Addition(
-          ctx->device_ctx(), add_to_output->shape().elem_cnt(), dx->mut_dptr<T>(), dx->dptr<T>(),
-          add_to_output->dptr<T>());
+      T* dx_dptr = dx->mut_dptr<T>();
+      const T* add_to_output_dptr = add_to_output->dptr<T>();
+      FOR_RANGE(int64_t, j, 0, add_to_output->shape().elem_cnt()) {
+        dx_dptr[j] += add_to_output_dptr[j];
+      }
     }
   }
 };
 
-#define REGISTER_CONV_DATA_GRAD_KERNEL(op_name, dtype)                                     \
-  REGISTER_USER_KERNEL(#op_name)                                                           \
-      .SetCreateFn<ConvDataGradCpuKernel<dtype>>()                                         \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                  \
-                       & (user_op::HobAttr<int32_t>("groups") == 1)                        \
-                       & (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value))     \
-      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                        \
-        size_t tmp_buffer_size = 0;                                                        \
-        const auto& out_diff_shape = ctx->TensorDesc4ArgNameAndIndex("dy", 0)->shape();    \
-        const auto& weight_shape = ctx->TensorDesc4ArgNameAndIndex("filter", 0)->shape();  \
-                                                                                           \
-        int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));             \
-        tmp_buffer_size +=                                                                 \
-            CalcElemNumOfColBuf(out_diff_shape, weight_shape, idx_offset) * sizeof(dtype); \
-        return tmp_buffer_size;                                                            \
+#define REGISTER_CONV_DATA_GRAD_KERNEL(op_name, dtype)                                        \
+  REGISTER_USER_KERNEL(#op_name)                                                              \
+      .SetCreateFn<ConvDataGradCpuKernel<dtype>>()                                            \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                     \
+                       & (user_op::HobAttr<int32_t>("groups") == 1)                           \
+                       & (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value))        \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                           \
+        size_t tmp_buffer_size = 0;                                                           \
+        const auto& out_diff_shape = ctx->TensorDesc4ArgNameAndIndex("dy", 0)->shape();       \
+        const auto& weight_shape = ctx->TensorDesc4ArgNameAndIndex("filter", 0)->shape();     \
+        if (IsCpuConv1x1(InferCpuConvParams<dtype>(ctx, "dx", "dy", "filter"))) { return 0; } \
+                                                                                              \
+        int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));                \
+        tmp_buffer_size +=                                                                    \
+            CalcElemNumOfColBuf(out_diff_shape, weight_shape, idx_offset) * sizeof(dtype);    \
+        return tmp_buffer_size;                                                               \
       })
 
 REGISTER_CONV_DATA_GRAD_KERNEL(conv_data_grad, float);
 REGISTER_CONV_DATA_GRAD_KERNEL(conv_data_grad, double);
+REGISTER_CONV_DATA_GRAD_KERNEL(conv_data_grad, bfloat16);
 
 template<typename T>
 class ConvFilterGradCpuKernel final : public user_op::OpKernel {
@@ -590,46 +903,57 @@ class ConvFilterGradCpuKernel final : public user_op::OpKernel {
     Memset<DeviceType::kCPU>(ctx->device_ctx(), filter_diff->mut_dptr<T>(), 0,
                              filter_diff->shape().elem_cnt() * sizeof(T));
     int32_t idx_offset = conv_state->idx_offset_;
+    const bool is_1x1 = IsCpuConv1x1(conv_state->GetCpuConvParams());
     FOR_RANGE(int64_t, i, 0, dy->shape().At(0)) {
-      conv_state->im2col_func_(GetImgDptr<T>(x, i), ShapeView(conv_state->in_5d_shape_),
-                               ShapeView(conv_state->weight_5d_shape_),
-                               ShapeView(conv_state->out_5d_shape_), conv_state->strides_3d_.data(),
-                               conv_state->dilation_rate_3d_.data(),
-                               conv_state->padding_before_3d_.data(), col_buf->mut_dptr<T>());
+      const T* col_buf_dptr = col_buf->dptr<T>();
+      enum CBLAS_TRANSPOSE col_buf_trans = CblasTrans;
+      if (is_1x1) {
+        // the input of a 1x1 conv is its col_buf, transposed for channels last
+        col_buf_dptr = GetImgDptr<T>(x, i);
+        if (idx_offset == 1) { col_buf_trans = CblasNoTrans; }
+      } else {
+        conv_state->im2col_func_(
+            GetImgDptr<T>(x, i), ShapeView(conv_state->in_5d_shape_),
+            ShapeView(conv_state->weight_5d_shape_), ShapeView(conv_state->out_5d_shape_),
+            conv_state->strides_3d_.data(), conv_state->dilation_rate_3d_.data(),
+            conv_state->padding_before_3d_.data(), col_buf->mut_dptr<T>());
+      }
 
       // channels first:  weight' += out[i]' * col_buf(T)
       // channels last :  weight' += out[i]'(T) * col_buf(T)
       NewKernelUtil<DeviceType::kCPU>::OFGemm(
-          nullptr, conv_state->is_out_diff_need_trans_, CblasTrans,
+          nullptr, conv_state->is_out_diff_need_trans_, col_buf_trans,
           conv_state->weight_5d_shape_.At(0),                           //  filter
           conv_state->weight_5d_shape_.Count(1),                        //  ci * kd * kh * kw
           conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  //  od * oh * ow
-          static_cast<T>(1), GetImgDptr<T>(dy, i), col_buf->dptr<T>(), static_cast<T>(1),
+          static_cast<T>(1), GetImgDptr<T>(dy, i), col_buf_dptr, static_cast<T>(1),
           filter_diff->mut_dptr<T>());
     }
   }
 };
 
-#define REGISTER_CONV_FILTER_GRAD_KERNEL(op_name, dtype)                                        \
-  REGISTER_USER_KERNEL(#op_name)                                                                \
-      .SetCreateFn<ConvFilterGradCpuKernel<dtype>>()                                            \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                       \
-                       & (user_op::HobAttr<int32_t>("groups") == 1)                             \
-                       & (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value))          \
-      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                             \
-        size_t tmp_buffer_size = 0;                                                             \
-        const auto& out_diff_shape = ctx->TensorDesc4ArgNameAndIndex("dy", 0)->shape();         \
-        const auto& weight_diff_shape =                                                         \
-            ctx->TensorDesc4ArgNameAndIndex("filter_diff", 0)->shape();                         \
-                                                                                                \
-        int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));                  \
-        tmp_buffer_size +=                                                                      \
-            CalcElemNumOfColBuf(out_diff_shape, weight_diff_shape, idx_offset) * sizeof(dtype); \
-        return tmp_buffer_size;                                                                 \
+#define REGISTER_CONV_FILTER_GRAD_KERNEL(op_name, dtype)                                          \
+  REGISTER_USER_KERNEL(#op_name)                                                                  \
+      .SetCreateFn<ConvFilterGradCpuKernel<dtype>>()                                              \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                         \
+                       & (user_op::HobAttr<int32_t>("groups") == 1)                               \
+                       & (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value))            \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                               \
+        size_t tmp_buffer_size = 0;                                                               \
+        const auto& out_diff_shape = ctx->TensorDesc4ArgNameAndIndex("dy", 0)->shape();           \
+        const auto& weight_diff_shape =                                                           \
+            ctx->TensorDesc4ArgNameAndIndex("filter_diff", 0)->shape();                           \
+        if (IsCpuConv1x1(InferCpuConvParams<dtype>(ctx, "x", "dy", "filter_diff"))) { return 0; } \
+                                                                                                  \
+        int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));                    \
+        tmp_buffer_size +=                                                                        \
+            CalcElemNumOfColBuf(out_diff_shape, weight_diff_shape, idx_offset) * sizeof(dtype);   \
+        return tmp_buffer_size;                                                                   \
       })
 
 REGISTER_CONV_FILTER_GRAD_KERNEL(conv_filter_grad, float);
 REGISTER_CONV_FILTER_GRAD_KERNEL(conv_filter_grad, double);
+REGISTER_CONV_FILTER_GRAD_KERNEL(conv_filter_grad, bfloat16);
 
 template<typename T>
 class ConvBiasGradCpuKernel final : public user_op::OpKernel {
@@ -694,6 +1018,7 @@ class ConvBiasGradCpuKernel final : public user_op::OpKernel {
 
 REGISTER_CONV_BIAS_GRAD_KERNEL(conv_bias_grad, float);
 REGISTER_CONV_BIAS_GRAD_KERNEL(conv_bias_grad, double);
+REGISTER_CONV_BIAS_GRAD_KERNEL(conv_bias_grad, bfloat16);
 }  // namespace
 
 }  // namespace oneflow
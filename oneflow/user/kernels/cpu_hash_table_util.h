@@ -0,0 +1,128 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_CPU_HASH_TABLE_UTIL_H_
+#define ONEFLOW_USER_KERNELS_CPU_HASH_TABLE_UTIL_H_
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#define OF_CPU_HASH_TABLE_WITH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace oneflow {
+
+// Mixes all the bits of the key into the hash with the splitmix64 finalizer, the sequential ids
+// common in the embeddings would otherwise fill the neighbouring groups of the table. -0.0 hashes
+// as 0.0 since they compare equal.
+template<typename K>
+inline uint64_t HashCpuTableKey(K key) {
+  static_assert(sizeof(K) <= sizeof(uint64_t), "the key does not fit in 64 bits");
+  if (key == static_cast<K>(0)) { key = static_cast<K>(0); }
+  uint64_t x = 0;
+  std::memcpy(&x, &key, sizeof(K));
+  x ^= x >> 30;
+  x *= 0xBF58476D1CE4E5B9ULL;
+  x ^= x >> 27;
+  x *= 0x94D049BB133111EBULL;
+  x ^= x >> 31;
+  return x;
+}
+
+// An insert-only open addressing table over memory owned by the caller, the kernel workspace.
+// The slots are split into groups of kGroupSize, each slot has a control byte holding 7 bits of
+// the hash of its key, or kEmpty. A probe compares the control bytes of a whole group at once,
+// with SSE2 where available, and only looks at the keys whose bits match, the groups are probed
+// linearly. The capacity is a power of two, so that the group of a hash is found with a mask.
+// Keys are compared with ==, a NaN never finds itself and is inserted every time.
+template<typename K, typename V>
+class CpuFlatHashTable final {
+ public:
+  static constexpr int64_t kGroupSize = 16;
+
+  CpuFlatHashTable(int64_t capacity, uint8_t* ctrl, K* keys, V* values)
+      : group_mask_(capacity / kGroupSize - 1), ctrl_(ctrl), keys_(keys), values_(values) {
+    std::memset(ctrl_, kEmpty, capacity);
+  }
+  ~CpuFlatHashTable() = default;
+
+  // The capacity keeping the table at most half full with num_keys keys.
+  static int64_t GetCapacity(int64_t num_keys) {
+    int64_t capacity = kGroupSize;
+    while (capacity < num_keys * 2) { capacity *= 2; }
+    return capacity;
+  }
+  // The number of bytes of the control bytes, keys and values of a slot.
+  static int64_t GetSlotSizeInBytes() { return 1 + sizeof(K) + sizeof(V); }
+
+  // Returns the value of key, the hash of which is hash. An absent key is inserted with the value
+  // new_value, and *inserted tells whether it was. The table must not be full.
+  V FindOrInsert(const K key, const uint64_t hash, const V new_value, bool* inserted) {
+    const uint8_t tag = static_cast<uint8_t>(hash & 0x7F);
+    uint64_t group = (hash >> 7) & group_mask_;
+    while (true) {
+      const int64_t offset = static_cast<int64_t>(group) * kGroupSize;
+      uint32_t match = MatchGroup(ctrl_ + offset, tag);
+      while (match != 0) {
+        const int64_t slot = offset + __builtin_ctz(match);
+        if (keys_[slot] == key) {
+          *inserted = false;
+          return values_[slot];
+        }
+        match &= match - 1;
+      }
+      const uint32_t empty = MatchGroup(ctrl_ + offset, kEmpty);
+      if (empty != 0) {
+        // Nothing is erased, so the key would have been in this group or an earlier one.
+        const int64_t slot = offset + __builtin_ctz(empty);
+        ctrl_[slot] = tag;
+        keys_[slot] = key;
+        values_[slot] = new_value;
+        *inserted = true;
+        return new_value;
+      }
+      group = (group + 1) & group_mask_;
+    }
+  }
+
+ private:
+  static constexpr uint8_t kEmpty = 0x80;
+
+  // The bit i of the result is set if the control byte i of the group equals tag.
+  static uint32_t MatchGroup(const uint8_t* group_ctrl, const uint8_t tag) {
+#ifdef OF_CPU_HASH_TABLE_WITH_SSE2
+    const __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group_ctrl));
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+    uint32_t match = 0;
+    for (int64_t i = 0; i < kGroupSize; ++i) {
+      match |= static_cast<uint32_t>(group_ctrl[i] == tag) << i;
+    }
+    return match;
+#endif
+  }
+
+  const uint64_t group_mask_;
+  uint8_t* ctrl_;
+  K* keys_;
+  V* values_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_CPU_HASH_TABLE_UTIL_H_
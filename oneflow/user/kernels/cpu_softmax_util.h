@@ -0,0 +1,170 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_CPU_SOFTMAX_UTIL_H_
+#define ONEFLOW_USER_KERNELS_CPU_SOFTMAX_UTIL_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace oneflow {
+
+// The max, the sum of the exps and the dot product of a row go kNumSoftmaxLanes elements at a
+// time into a lane each, the lanes are combined once at the end of the row.
+constexpr int64_t kNumSoftmaxLanes = 8;
+// The online max of a row is updated once per block, the sum of the block is accumulated against
+// the running max, which costs one exp per element.
+constexpr int64_t kSoftmaxBlockSize = 512;
+
+// Clamps x to [lo, hi] by selecting the bits with masks. A conditional would be turned into
+// branches by the compiler, which keep the loops calling ApproxExp from being vectorized.
+inline float ClampFloatBranchless(const float x, const float lo, const float hi) {
+  int32_t x_bits = 0;
+  int32_t lo_bits = 0;
+  int32_t hi_bits = 0;
+  std::memcpy(&x_bits, &x, sizeof(x));
+  std::memcpy(&lo_bits, &lo, sizeof(lo));
+  std::memcpy(&hi_bits, &hi, sizeof(hi));
+  const int32_t below_mask = -static_cast<int32_t>(x < lo);
+  const int32_t above_mask = -static_cast<int32_t>(x > hi);
+  x_bits = (x_bits & ~(below_mask | above_mask)) | (lo_bits & below_mask) | (hi_bits & above_mask);
+  float clamped = 0;
+  std::memcpy(&clamped, &x_bits, sizeof(clamped));
+  return clamped;
+}
+
+// exp(x) = 2^n * exp(r) with n = round(x * log2(e)) and |r| <= ln(2) / 2, exp(r) from its degree
+// 7 Taylor polynomial, branchless so that the loops calling it vectorize. The relative error is
+// below 2e-7, about 2 ulp, for x in [-87.3, 88.3]. Below the range it returns exp(-87.3), about
+// 1.2e-38, above it saturates at exp(88.3), NaN stays NaN.
+inline float ApproxExp(float x) {
+  x = ClampFloatBranchless(x, -87.3f, 88.3f);
+  // Adding and subtracting 1.5 * 2^23 rounds to the nearest integer.
+  const float n = (x * 1.44269504f + 12582912.f) - 12582912.f;
+  const float r = (x - n * 0.693145752f) - n * 1.42860677e-6f;
+  float p = 1.f / 5040.f;
+  p = p * r + 1.f / 720.f;
+  p = p * r + 1.f / 120.f;
+  p = p * r + 1.f / 24.f;
+  p = p * r + 1.f / 6.f;
+  p = p * r + 0.5f;
+  p = p * r + 1.f;
+  p = p * r + 1.f;
+  const int32_t scale_bits = (static_cast<int32_t>(n) + 127) << 23;
+  float scale = 0;
+  std::memcpy(&scale, &scale_bits, sizeof(scale));
+  return p * scale;
+}
+
+template<typename T>
+inline T SoftmaxExp(T x) {
+  return std::exp(x);
+}
+
+template<>
+inline float SoftmaxExp<float>(float x) {
+  return ApproxExp(x);
+}
+
+template<typename T>
+struct SoftmaxRowStat {
+  T max;
+  // The sum of exp(x - max).
+  T sum;
+};
+
+template<typename T>
+inline T RowBlockMax(const int64_t n, const T* x) {
+  T lane_max[kNumSoftmaxLanes];
+  std::fill(lane_max, lane_max + kNumSoftmaxLanes, x[0]);
+  const int64_t num_steps = n / kNumSoftmaxLanes;
+  for (int64_t step = 0; step < num_steps; ++step) {
+    const T* x_step = x + step * kNumSoftmaxLanes;
+    for (int64_t l = 0; l < kNumSoftmaxLanes; ++l) {
+      lane_max[l] = x_step[l] > lane_max[l] ? x_step[l] : lane_max[l];
+    }
+  }
+  T max = lane_max[0];
+  for (int64_t l = 1; l < kNumSoftmaxLanes; ++l) { max = std::max(max, lane_max[l]); }
+  for (int64_t i = num_steps * kNumSoftmaxLanes; i < n; ++i) { max = std::max(max, x[i]); }
+  return max;
+}
+
+template<typename T>
+inline T RowBlockSumExp(const int64_t n, const T* x, const T max) {
+  T lane_sum[kNumSoftmaxLanes] = {0};
+  const int64_t num_steps = n / kNumSoftmaxLanes;
+  for (int64_t step = 0; step < num_steps; ++step) {
+    const T* x_step = x + step * kNumSoftmaxLanes;
+    for (int64_t l = 0; l < kNumSoftmaxLanes; ++l) { lane_sum[l] += SoftmaxExp(x_step[l] - max); }
+  }
+  T sum = 0;
+  for (int64_t l = 0; l < kNumSoftmaxLanes; ++l) { sum += lane_sum[l]; }
+  for (int64_t i = num_steps * kNumSoftmaxLanes; i < n; ++i) { sum += SoftmaxExp(x[i] - max); }
+  return sum;
+}
+
+// The max and the sum of exp(x - max) of a row of n > 0 elements in a single pass over the row.
+template<typename T>
+inline SoftmaxRowStat<T> ComputeSoftmaxRowStat(const int64_t n, const T* x) {
+  SoftmaxRowStat<T> stat{x[0], 0};
+  for (int64_t begin = 0; begin < n; begin += kSoftmaxBlockSize) {
+    const int64_t len = std::min(kSoftmaxBlockSize, n - begin);
+    const T block_max = RowBlockMax(len, x + begin);
+    if (block_max > stat.max) {
+      stat.sum *= SoftmaxExp(stat.max - block_max);
+      stat.max = block_max;
+    }
+    stat.sum += RowBlockSumExp(len, x + begin, stat.max);
+  }
+  return stat;
+}
+
+template<typename T>
+inline T RowDot(const int64_t n, const T* x, const T* y) {
+  T lane_sum[kNumSoftmaxLanes] = {0};
+  const int64_t num_steps = n / kNumSoftmaxLanes;
+  for (int64_t step = 0; step < num_steps; ++step) {
+    const int64_t i = step * kNumSoftmaxLanes;
+    for (int64_t l = 0; l < kNumSoftmaxLanes; ++l) { lane_sum[l] += x[i + l] * y[i + l]; }
+  }
+  T sum = 0;
+  for (int64_t l = 0; l < kNumSoftmaxLanes; ++l) { sum += lane_sum[l]; }
+  for (int64_t i = num_steps * kNumSoftmaxLanes; i < n; ++i) { sum += x[i] * y[i]; }
+  return sum;
+}
+
+// Writes the softmax of a row of n > 0 elements to y, which may alias x, and returns the
+// statistics of the row, from which the callers derive the log-softmax x - max - log(sum).
+template<typename T>
+inline SoftmaxRowStat<T> ComputeSoftmaxRow(const int64_t n, const T* x, T* y) {
+  const SoftmaxRowStat<T> stat = ComputeSoftmaxRowStat(n, x);
+  const T inv_sum = static_cast<T>(1) / stat.sum;
+  for (int64_t i = 0; i < n; ++i) { y[i] = SoftmaxExp(x[i] - stat.max) * inv_sum; }
+  return stat;
+}
+
+// dx = (dy - dot(dy, y)) * y for a row of n elements, dx may alias dy.
+template<typename T>
+inline void ComputeSoftmaxGradRow(const int64_t n, const T* dy, const T* y, T* dx) {
+  const T dot = RowDot(n, dy, y);
+  for (int64_t i = 0; i < n; ++i) { dx[i] = (dy[i] - dot) * y[i]; }
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_CPU_SOFTMAX_UTIL_H_
@@ -0,0 +1,137 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_CPU_SORT_UTIL_H_
+#define ONEFLOW_USER_KERNELS_CPU_SORT_UTIL_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace oneflow {
+
+// Rows at least this long are radix sorted, shorter ones are left to std::sort. Sorting the
+// indices by comparison pays for the indirection to the values, so arg_sort switches earlier.
+constexpr int64_t kCpuRadixSortMinSize = 2048;
+constexpr int64_t kCpuRadixArgSortMinSize = 512;
+
+template<size_t size>
+struct RadixSortUnsigned;
+
+template<>
+struct RadixSortUnsigned<1> {
+  using type = uint8_t;
+};
+
+template<>
+struct RadixSortUnsigned<2> {
+  using type = uint16_t;
+};
+
+template<>
+struct RadixSortUnsigned<4> {
+  using type = uint32_t;
+};
+
+template<>
+struct RadixSortUnsigned<8> {
+  using type = uint64_t;
+};
+
+// Maps T to an unsigned key of the same size, the unsigned order of which is the order of T. The
+// sign bit of an integer is flipped. A float has its sign bit set if it is positive, and all its
+// bits flipped otherwise, a NaN with its sign bit clear sorts after +inf.
+template<typename T>
+struct RadixSortKey {
+  static_assert(std::is_arithmetic<T>::value, "the key is not a number");
+  using Key = typename RadixSortUnsigned<sizeof(T)>::type;
+  static constexpr Key kSignBit = static_cast<Key>(Key(1) << (sizeof(Key) * 8 - 1));
+
+  static Key Encode(const T x) {
+    Key key = 0;
+    std::memcpy(&key, &x, sizeof(T));
+    if (std::is_floating_point<T>::value) {
+      return (key & kSignBit) ? static_cast<Key>(~key) : static_cast<Key>(key | kSignBit);
+    }
+    return std::is_signed<T>::value ? static_cast<Key>(key ^ kSignBit) : key;
+  }
+  static T Decode(Key key) {
+    if (std::is_floating_point<T>::value) {
+      key = (key & kSignBit) ? static_cast<Key>(key & ~kSignBit) : static_cast<Key>(~key);
+    } else if (std::is_signed<T>::value) {
+      key = static_cast<Key>(key ^ kSignBit);
+    }
+    T x;
+    std::memcpy(&x, &key, sizeof(T));
+    return x;
+  }
+};
+
+// Stably sorts keys by least significant digit radix sort with 8 bit digits, values are moved
+// along with the keys unless they are nullptr. The histograms of all the digits are counted in a
+// single pass, and the digits shared by all the keys are skipped. keys_tmp and values_tmp are
+// scratch buffers of n elements, the result ends up in keys and values.
+template<typename K, typename V>
+void RadixSortPairs(int64_t n, K* keys, K* keys_tmp, V* values, V* values_tmp) {
+  static_assert(std::is_unsigned<K>::value, "the key is not unsigned");
+  constexpr int64_t kNumDigits = sizeof(K);
+  constexpr int64_t kRadix = 256;
+  if (n <= 1) { return; }
+  int64_t histogram[kNumDigits][kRadix];
+  std::memset(histogram, 0, sizeof(histogram));
+  for (int64_t i = 0; i < n; ++i) {
+    const K key = keys[i];
+    for (int64_t d = 0; d < kNumDigits; ++d) { histogram[d][(key >> (d * 8)) & 0xFF] += 1; }
+  }
+  K* src_keys = keys;
+  K* dst_keys = keys_tmp;
+  V* src_values = values;
+  V* dst_values = values_tmp;
+  for (int64_t d = 0; d < kNumDigits; ++d) {
+    const int64_t shift = d * 8;
+    int64_t* offset = histogram[d];
+    if (offset[(src_keys[0] >> shift) & 0xFF] == n) { continue; }
+    int64_t sum = 0;
+    for (int64_t digit = 0; digit < kRadix; ++digit) {
+      const int64_t cnt = offset[digit];
+      offset[digit] = sum;
+      sum += cnt;
+    }
+    if (values == nullptr) {
+      for (int64_t i = 0; i < n; ++i) {
+        const K key = src_keys[i];
+        dst_keys[offset[(key >> shift) & 0xFF]++] = key;
+      }
+    } else {
+      for (int64_t i = 0; i < n; ++i) {
+        const K key = src_keys[i];
+        const int64_t pos = offset[(key >> shift) & 0xFF]++;
+        dst_keys[pos] = key;
+        dst_values[pos] = src_values[i];
+      }
+    }
+    std::swap(src_keys, dst_keys);
+    std::swap(src_values, dst_values);
+  }
+  if (src_keys != keys) {
+    std::copy(src_keys, src_keys + n, keys);
+    if (values != nullptr) { std::copy(src_values, src_values + n, values); }
+  }
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_CPU_SORT_UTIL_H_
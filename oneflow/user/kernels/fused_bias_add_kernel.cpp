@@ -0,0 +1,247 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/kernels/cpu_softmax_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// erfc(x) = t * exp(-x^2 + P(t)) with t = 1 / (1 + |x| / 2) and P the Chebyshev fit of Numerical
+// Recipes, reflected by erfc(-x) = 2 - erfc(x). The relative error stays below 2.1e-6 for |x| <= 6,
+// it is dominated by the rounding of x^2, so gelu keeps its relative accuracy in the negative tail.
+inline float ApproxErfc(const float x) {
+  const float a = std::fabs(x);
+  const float t = 1.f / (1.f + 0.5f * a);
+  float p = 0.17087277f;
+  p = p * t - 0.82215223f;
+  p = p * t + 1.48851587f;
+  p = p * t - 1.13520398f;
+  p = p * t + 0.27886807f;
+  p = p * t - 0.18628806f;
+  p = p * t + 0.09678418f;
+  p = p * t + 0.37409196f;
+  p = p * t + 1.00002368f;
+  p = p * t - 1.26551223f;
+  const float e = t * ApproxExp(p - a * a);
+  // Selected arithmetically, a conditional would keep the loops from being vectorized.
+  const float negative = static_cast<float>(x < 0.f);
+  return e + negative * (2.f - 2.f * e);
+}
+
+template<typename T>
+struct GeluMath {
+  static T Erfc(T x) { return std::erfc(x); }
+  static T Exp(T x) { return std::exp(x); }
+};
+
+template<>
+struct GeluMath<float> {
+  static float Erfc(float x) { return ApproxErfc(x); }
+  static float Exp(float x) { return ApproxExp(x); }
+};
+
+// 1 + erf(x / sqrt(2)) is computed as erfc(-x / sqrt(2)).
+template<typename T>
+struct GeluFunctor {
+  T Compute(T x, int64_t i) const {
+    return static_cast<T>(0.5) * x * GeluMath<T>::Erfc(static_cast<T>(-M_SQRT1_2) * x);
+  }
+};
+
+template<typename T>
+struct GeluGradFunctor {
+  const T coef = std::sqrt(static_cast<T>(2.0) / std::acos(static_cast<T>(-1.0)));
+  T Compute(T x, T dy, int64_t i) const {
+    return static_cast<T>(0.5)
+           * (GeluMath<T>::Erfc(static_cast<T>(-M_SQRT1_2) * x)
+              + x * coef * GeluMath<T>::Exp(static_cast<T>(-0.5) * x * x))
+           * dy;
+  }
+};
+
+template<typename T>
+struct MaskAndScaleFunctor {
+  MaskAndScaleFunctor(const int8_t* mask, float scale) : mask(mask), scale(scale) {}
+  T Compute(T x, int64_t i) const { return x * static_cast<T>(mask[i]) * scale; }
+  const int8_t* mask;
+  float scale;
+};
+
+template<typename T>
+struct MaskAndScaleAddFunctor {
+  MaskAndScaleAddFunctor(const int8_t* mask, const T* addend, float scale)
+      : mask(mask), addend(addend), scale(scale) {}
+  T Compute(T x, int64_t i) const { return x * static_cast<T>(mask[i]) * scale + addend[i]; }
+  const int8_t* mask;
+  const T* addend;
+  float scale;
+};
+
+// Calls Visit(i, x[i] + bias[j]) for every element i of x viewed as (outer_size, bias_size,
+// inner_size), j being its index on the bias axis. The rows are split among the threads of the
+// compute thread pool, the innermost loop runs over contiguous elements.
+template<typename T, typename Visitor>
+void ForEachBiasAddElem(int64_t outer_size, int64_t bias_size, int64_t inner_size, const T* x,
+                        const T* bias, const Visitor& Visit) {
+  if (inner_size == 1) {
+    MultiThreadLoopInRanges(outer_size, GetNumThreadRanges(outer_size, bias_size),
+                            [&](int64_t range_id, int64_t begin, int64_t end) {
+                              FOR_RANGE(int64_t, i, begin, end) {
+                                const int64_t offset = i * bias_size;
+                                FOR_RANGE(int64_t, j, 0, bias_size) {
+                                  Visit(offset + j, x[offset + j] + bias[j]);
+                                }
+                              }
+                            });
+  } else {
+    const int64_t num_rows = outer_size * bias_size;
+    MultiThreadLoopInRanges(num_rows, GetNumThreadRanges(num_rows, inner_size),
+                            [&](int64_t range_id, int64_t begin, int64_t end) {
+                              FOR_RANGE(int64_t, i, begin, end) {
+                                const T bias_i = bias[i % bias_size];
+                                const int64_t offset = i * inner_size;
+                                FOR_RANGE(int64_t, j, offset, offset + inner_size) {
+                                  Visit(j, x[j] + bias_i);
+                                }
+                              }
+                            });
+  }
+}
+
+template<typename FUNCTOR, typename T>
+void FusedBiasAddForward(FUNCTOR functor, int64_t outer_size, int64_t bias_size,
+                         int64_t inner_size, const T* x, const T* bias, T* y) {
+  ForEachBiasAddElem(outer_size, bias_size, inner_size, x, bias,
+                     [&](int64_t i, T x_i) { y[i] = functor.Compute(x_i, i); });
+}
+
+template<typename FUNCTOR, typename T>
+void FusedBiasAddGrad(FUNCTOR grad_functor, int64_t outer_size, int64_t bias_size,
+                      int64_t inner_size, const T* x, const T* bias, const T* dy, T* dx) {
+  ForEachBiasAddElem(outer_size, bias_size, inner_size, x, bias,
+                     [&](int64_t i, T x_i) { dx[i] = grad_functor.Compute(x_i, dy[i], i); });
+}
+
+}  // namespace
+
+template<typename T>
+class FusedBiasAddGeluCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedBiasAddGeluCpuKernel() = default;
+  ~FusedBiasAddGeluCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const auto* a_tensor = ctx->Tensor4ArgNameAndIndex("a", 0);
+    const auto* b_tensor = ctx->Tensor4ArgNameAndIndex("b", 0);
+    auto* out_tensor = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int32_t bias_add_axis = ctx->Attr<int32_t>("axis");
+    const int64_t outer_size = a_tensor->shape().Count(0, bias_add_axis);
+    const int64_t bias_size = a_tensor->shape().At(bias_add_axis);
+    const int64_t inner_size = a_tensor->shape().Count(bias_add_axis + 1);
+    FusedBiasAddForward(GeluFunctor<T>(), outer_size, bias_size, inner_size, a_tensor->dptr<T>(),
+                        b_tensor->dptr<T>(), out_tensor->mut_dptr<T>());
+  };
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_BIAS_ADD_GELU_CPU_KERNEL(dtype)    \
+  REGISTER_USER_KERNEL("fused_bias_add_gelu")             \
+      .SetCreateFn<FusedBiasAddGeluCpuKernel<dtype>>()    \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu") \
+                       & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value));
+
+REGISTER_FUSED_BIAS_ADD_GELU_CPU_KERNEL(float)
+REGISTER_FUSED_BIAS_ADD_GELU_CPU_KERNEL(double)
+
+template<typename T>
+class FusedBiasAddMaskScaleCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedBiasAddMaskScaleCpuKernel() = default;
+  ~FusedBiasAddMaskScaleCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const auto* a_tensor = ctx->Tensor4ArgNameAndIndex("a", 0);
+    const auto* b_tensor = ctx->Tensor4ArgNameAndIndex("b", 0);
+    const auto* mask_tensor = ctx->Tensor4ArgNameAndIndex("mask", 0);
+    auto* out_tensor = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int32_t bias_add_axis = ctx->Attr<int32_t>("axis");
+    const float scale = ctx->Attr<float>("scale");
+    const int64_t outer_size = a_tensor->shape().Count(0, bias_add_axis);
+    const int64_t bias_size = a_tensor->shape().At(bias_add_axis);
+    const int64_t inner_size = a_tensor->shape().Count(bias_add_axis + 1);
+    if (ctx->has_input("_add_to_output", 0)) {
+      const user_op::Tensor* addend = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+      MaskAndScaleAddFunctor<T> mask_and_scale_add_functor(mask_tensor->dptr<int8_t>(),
+                                                           addend->dptr<T>(), scale);
+      FusedBiasAddForward(mask_and_scale_add_functor, outer_size, bias_size, inner_size,
+                          a_tensor->dptr<T>(), b_tensor->dptr<T>(), out_tensor->mut_dptr<T>());
+    } else {
+      MaskAndScaleFunctor<T> mask_and_scale_functor(mask_tensor->dptr<int8_t>(), scale);
+      FusedBiasAddForward(mask_and_scale_functor, outer_size, bias_size, inner_size,
+                          a_tensor->dptr<T>(), b_tensor->dptr<T>(), out_tensor->mut_dptr<T>());
+    }
+  };
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_BIAS_ADD_MASK_SCALE_CPU_KERNEL(dtype) \
+  REGISTER_USER_KERNEL("fused_bias_add_mask_scale")          \
+      .SetCreateFn<FusedBiasAddMaskScaleCpuKernel<dtype>>()  \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")    \
+                       & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value));
+
+REGISTER_FUSED_BIAS_ADD_MASK_SCALE_CPU_KERNEL(float)
+REGISTER_FUSED_BIAS_ADD_MASK_SCALE_CPU_KERNEL(double)
+
+template<typename T>
+class FusedBiasAddGeluGradCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedBiasAddGeluGradCpuKernel() = default;
+  ~FusedBiasAddGeluGradCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const auto* a_tensor = ctx->Tensor4ArgNameAndIndex("a", 0);
+    const auto* b_tensor = ctx->Tensor4ArgNameAndIndex("b", 0);
+    const auto* dy_tensor = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    auto* dx_tensor = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const int32_t bias_add_axis = ctx->Attr<int32_t>("axis");
+    const int64_t outer_size = a_tensor->shape().Count(0, bias_add_axis);
+    const int64_t bias_size = a_tensor->shape().At(bias_add_axis);
+    const int64_t inner_size = a_tensor->shape().Count(bias_add_axis + 1);
+    FusedBiasAddGrad(GeluGradFunctor<T>(), outer_size, bias_size, inner_size, a_tensor->dptr<T>(),
+                     b_tensor->dptr<T>(), dy_tensor->dptr<T>(), dx_tensor->mut_dptr<T>());
+  };
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_BIAS_ADD_GELU_GRAD_CPU_KERNEL(dtype) \
+  REGISTER_USER_KERNEL("fused_bias_add_gelu_grad")          \
+      .SetCreateFn<FusedBiasAddGeluGradCpuKernel<dtype>>()  \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")   \
+                       & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value));
+
+REGISTER_FUSED_BIAS_ADD_GELU_GRAD_CPU_KERNEL(float)
+REGISTER_FUSED_BIAS_ADD_GELU_GRAD_CPU_KERNEL(double)
+
+}  // namespace oneflow
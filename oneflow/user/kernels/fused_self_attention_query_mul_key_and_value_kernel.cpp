@@ -0,0 +1,165 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace {
+
+// hidden_states is laid out as (seq_len, batch_size, num_heads, 3, head_size), the query, the key
+// and the value of a head are strided matrices of seq_len rows with a leading dimension of
+// batch_size * hidden_size, which the gemms read and write in place without any slicing.
+struct SelfAttentionView {
+  SelfAttentionView(int64_t seq_len, int64_t batch_size, int64_t hidden_size, int64_t head_size)
+      : seq_len(seq_len),
+        batch_size(batch_size),
+        head_size(head_size),
+        num_heads(hidden_size / (3 * head_size)),
+        ld(batch_size * hidden_size),
+        hidden_size(hidden_size) {}
+
+  // The offset of the query of head (b, n), the key and the value follow at head_size and
+  // 2 * head_size.
+  int64_t QueryOffset(int64_t batch_head) const {
+    return (batch_head / num_heads) * hidden_size + (batch_head % num_heads) * 3 * head_size;
+  }
+
+  int64_t seq_len;
+  int64_t batch_size;
+  int64_t head_size;
+  int64_t num_heads;
+  int64_t ld;
+  int64_t hidden_size;
+};
+
+// Copies the value between hidden_states and the (batch_size, num_heads, seq_len, head_size)
+// value blob, one thread range per range of (b, n, s) rows.
+template<typename T, bool kToValue>
+void CopyValue(const SelfAttentionView& view, const T* from, T* to) {
+  const int64_t num_rows = view.batch_size * view.num_heads * view.seq_len;
+  MultiThreadLoopInRanges(
+      num_rows, GetNumThreadRanges(num_rows, view.head_size),
+      [&](int64_t range_id, int64_t begin, int64_t end) {
+        FOR_RANGE(int64_t, row, begin, end) {
+          const int64_t batch_head = row / view.seq_len;
+          const int64_t s = row % view.seq_len;
+          const int64_t hidden_offset =
+              s * view.ld + view.QueryOffset(batch_head) + 2 * view.head_size;
+          const int64_t value_offset = row * view.head_size;
+          if (kToValue) {
+            std::copy(from + hidden_offset, from + hidden_offset + view.head_size,
+                      to + value_offset);
+          } else {
+            std::copy(from + value_offset, from + value_offset + view.head_size,
+                      to + hidden_offset);
+          }
+        }
+      });
+}
+
+}  // namespace
+
+template<typename T>
+class FusedSelfAttentionQueryMulKeyAndValueCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedSelfAttentionQueryMulKeyAndValueCpuKernel() = default;
+  ~FusedSelfAttentionQueryMulKeyAndValueCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* h_tensor = ctx->Tensor4ArgNameAndIndex("hidden_states", 0);
+    user_op::Tensor* qmk_tensor = ctx->Tensor4ArgNameAndIndex("query_mul_key", 0);
+    user_op::Tensor* v_tensor = ctx->Tensor4ArgNameAndIndex("value", 0);
+    const SelfAttentionView view(h_tensor->shape().At(0), h_tensor->shape().At(1),
+                                 h_tensor->shape().At(2), ctx->Attr<int64_t>("head_size"));
+    const T alpha = static_cast<T>(ctx->Attr<float>("alpha"));
+    const int64_t s = view.seq_len;
+    const T* h_dptr = h_tensor->dptr<T>();
+    T* qmk_dptr = qmk_tensor->mut_dptr<T>();
+    // q * k: (sq, h) x (sk, h)^T -> (sq, sk) for every head (b, n)
+    FOR_RANGE(int64_t, batch_head, 0, view.batch_size * view.num_heads) {
+      const T* q_dptr = h_dptr + view.QueryOffset(batch_head);
+      KernelUtil<DeviceType::kCPU, T>::Gemm(ctx->device_ctx(), CblasRowMajor, CblasNoTrans,
+                                            CblasTrans, s, s, view.head_size, alpha, q_dptr,
+                                            view.ld, q_dptr + view.head_size, view.ld,
+                                            static_cast<T>(0), qmk_dptr + batch_head * s * s, s);
+    }
+    CopyValue<T, true>(view, h_dptr, v_tensor->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class FusedSelfAttentionQueryMulKeyAndValueGradCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedSelfAttentionQueryMulKeyAndValueGradCpuKernel() = default;
+  ~FusedSelfAttentionQueryMulKeyAndValueGradCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* v_grad_tensor = ctx->Tensor4ArgNameAndIndex("value_grad", 0);
+    const user_op::Tensor* qmk_grad_tensor = ctx->Tensor4ArgNameAndIndex("query_mul_key_grad", 0);
+    const user_op::Tensor* h_tensor = ctx->Tensor4ArgNameAndIndex("hidden_states", 0);
+    user_op::Tensor* h_grad_tensor = ctx->Tensor4ArgNameAndIndex("hidden_states_grad", 0);
+    const int64_t head_size = v_grad_tensor->shape().At(3);
+    const SelfAttentionView view(h_grad_tensor->shape().At(0), h_grad_tensor->shape().At(1),
+                                 h_grad_tensor->shape().At(2), head_size);
+    CHECK_EQ(view.num_heads, v_grad_tensor->shape().At(1));
+    const T alpha = static_cast<T>(ctx->Attr<float>("alpha"));
+    const int64_t s = view.seq_len;
+    const T* h_dptr = h_tensor->dptr<T>();
+    const T* qmk_grad_dptr = qmk_grad_tensor->dptr<T>();
+    T* h_grad_dptr = h_grad_tensor->mut_dptr<T>();
+    CopyValue<T, false>(view, v_grad_tensor->dptr<T>(), h_grad_dptr);
+    FOR_RANGE(int64_t, batch_head, 0, view.batch_size * view.num_heads) {
+      const int64_t q_offset = view.QueryOffset(batch_head);
+      const int64_t k_offset = q_offset + head_size;
+      const T* qmk_grad_head = qmk_grad_dptr + batch_head * s * s;
+      // grad_q = grad_qmk * k: (sq, sk) x (sk, h) -> (sq, h)
+      KernelUtil<DeviceType::kCPU, T>::Gemm(ctx->device_ctx(), CblasRowMajor, CblasNoTrans,
+                                            CblasNoTrans, s, head_size, s, alpha, qmk_grad_head, s,
+                                            h_dptr + k_offset, view.ld, static_cast<T>(0),
+                                            h_grad_dptr + q_offset, view.ld);
+      // grad_k = grad_qmk^T * q: (sk, sq) x (sq, h) -> (sk, h)
+      KernelUtil<DeviceType::kCPU, T>::Gemm(ctx->device_ctx(), CblasRowMajor, CblasTrans,
+                                            CblasNoTrans, s, head_size, s, alpha, qmk_grad_head, s,
+                                            h_dptr + q_offset, view.ld, static_cast<T>(0),
+                                            h_grad_dptr + k_offset, view.ld);
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_SELF_ATTENTION_QUERY_MUL_KEY_AND_VALUE_CPU_KERNEL(dtype)                   \
+  REGISTER_USER_KERNEL("fused_self_attention_query_mul_key_and_value")                            \
+      .SetCreateFn<FusedSelfAttentionQueryMulKeyAndValueCpuKernel<dtype>>()                       \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)                              \
+                       & (user_op::HobDataType("hidden_states", 0) == GetDataType<dtype>::value));
+
+#define REGISTER_FUSED_SELF_ATTENTION_QUERY_MUL_KEY_AND_VALUE_GRAD_CPU_KERNEL(dtype)              \
+  REGISTER_USER_KERNEL("fused_self_attention_query_mul_key_and_value_grad")                       \
+      .SetCreateFn<FusedSelfAttentionQueryMulKeyAndValueGradCpuKernel<dtype>>()                   \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)                              \
+                       & (user_op::HobDataType("hidden_states", 0) == GetDataType<dtype>::value));
+
+REGISTER_FUSED_SELF_ATTENTION_QUERY_MUL_KEY_AND_VALUE_CPU_KERNEL(float)
+REGISTER_FUSED_SELF_ATTENTION_QUERY_MUL_KEY_AND_VALUE_CPU_KERNEL(double)
+REGISTER_FUSED_SELF_ATTENTION_QUERY_MUL_KEY_AND_VALUE_GRAD_CPU_KERNEL(float)
+REGISTER_FUSED_SELF_ATTENTION_QUERY_MUL_KEY_AND_VALUE_GRAD_CPU_KERNEL(double)
+
+}  // namespace oneflow
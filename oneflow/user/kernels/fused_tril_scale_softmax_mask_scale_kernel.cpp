@@ -0,0 +1,146 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/kernels/cpu_softmax_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// The number of leading columns of a row that the tril keeps, the others are filled.
+int64_t GetNumTrilCols(int64_t row, int64_t tril_num_rows, int64_t num_cols, int64_t diagonal) {
+  return std::min(std::max<int64_t>(row % tril_num_rows + diagonal + 1, 0), num_cols);
+}
+
+}  // namespace
+
+// Each row is processed by one thread: the tril and the scale are written to softmax_y, which the
+// softmax then updates in place before the mask and its scale are applied to y.
+template<typename T>
+class FusedTrilScaleSoftmaxMaskScaleCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedTrilScaleSoftmaxMaskScaleCpuKernel() = default;
+  ~FusedTrilScaleSoftmaxMaskScaleCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    const user_op::Tensor* mask = ctx->Tensor4ArgNameAndIndex("mask", 0);
+    user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    user_op::Tensor* softmax_y = ctx->Tensor4ArgNameAndIndex("softmax_y", 0);
+    const ShapeView& x_shape = x->shape();
+    CHECK_GE(x_shape.NumAxes(), 2);
+    const int64_t cols = x_shape.At(x_shape.NumAxes() - 1);
+    const int64_t rows = x_shape.Count(0, x_shape.NumAxes() - 1);
+    const int64_t tril_num_rows = x_shape.At(x_shape.NumAxes() - 2);
+    const int64_t diagonal = ctx->Attr<int64_t>("diagonal");
+    const T fill = static_cast<T>(ctx->Attr<float>("tril_fill_value"));
+    const T tril_scale = static_cast<T>(ctx->Attr<float>("tril_scale_value"));
+    const T mask_scale = static_cast<T>(ctx->Attr<float>("mask_scale_value"));
+    const T* x_ptr = x->dptr<T>();
+    const int8_t* mask_ptr = mask->dptr<int8_t>();
+    T* y_ptr = y->mut_dptr<T>();
+    T* softmax_y_ptr = softmax_y->mut_dptr<T>();
+    MultiThreadLoopInRanges(
+        rows, GetNumThreadRanges(rows, cols), [&](int64_t range_id, int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, row, begin, end) {
+            const int64_t offset = row * cols;
+            const T* x_row = x_ptr + offset;
+            const int8_t* mask_row = mask_ptr + offset;
+            T* y_row = y_ptr + offset;
+            T* softmax_y_row = softmax_y_ptr + offset;
+            const int64_t num_tril_cols = GetNumTrilCols(row, tril_num_rows, cols, diagonal);
+            FOR_RANGE(int64_t, j, 0, num_tril_cols) { softmax_y_row[j] = x_row[j] * tril_scale; }
+            std::fill(softmax_y_row + num_tril_cols, softmax_y_row + cols, fill);
+            ComputeSoftmaxRow(cols, softmax_y_row, softmax_y_row);
+            FOR_RANGE(int64_t, j, 0, cols) {
+              y_row[j] = softmax_y_row[j] * static_cast<T>(mask_row[j]) * mask_scale;
+            }
+          }
+        });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_TRIL_SCALE_SOFTMAX_MASK_SCALE_CPU_KERNEL(dtype) \
+  REGISTER_USER_KERNEL("fused_tril_scale_softmax_mask_scale")          \
+      .SetCreateFn<FusedTrilScaleSoftmaxMaskScaleCpuKernel<dtype>>()   \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)   \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value));
+
+REGISTER_FUSED_TRIL_SCALE_SOFTMAX_MASK_SCALE_CPU_KERNEL(float)
+REGISTER_FUSED_TRIL_SCALE_SOFTMAX_MASK_SCALE_CPU_KERNEL(double)
+#undef REGISTER_FUSED_TRIL_SCALE_SOFTMAX_MASK_SCALE_CPU_KERNEL
+
+// dx is first the masked and scaled dy, the softmax grad updates it in place and the columns
+// filled by the tril get a zero grad.
+template<typename T>
+class FusedTrilScaleSoftmaxMaskScaleGradCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedTrilScaleSoftmaxMaskScaleGradCpuKernel() = default;
+  ~FusedTrilScaleSoftmaxMaskScaleGradCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* softmax_y = ctx->Tensor4ArgNameAndIndex("softmax_y", 0);
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const user_op::Tensor* mask = ctx->Tensor4ArgNameAndIndex("mask", 0);
+    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const ShapeView& dy_shape = dy->shape();
+    CHECK_GE(dy_shape.NumAxes(), 2);
+    const int64_t cols = dy_shape.At(dy_shape.NumAxes() - 1);
+    const int64_t rows = dy_shape.Count(0, dy_shape.NumAxes() - 1);
+    const int64_t tril_num_rows = dy_shape.At(dy_shape.NumAxes() - 2);
+    const int64_t diagonal = ctx->Attr<int64_t>("diagonal");
+    const T tril_scale = static_cast<T>(ctx->Attr<float>("tril_scale_value"));
+    const T mask_scale = static_cast<T>(ctx->Attr<float>("mask_scale_value"));
+    const T* softmax_y_ptr = softmax_y->dptr<T>();
+    const T* dy_ptr = dy->dptr<T>();
+    const int8_t* mask_ptr = mask->dptr<int8_t>();
+    T* dx_ptr = dx->mut_dptr<T>();
+    MultiThreadLoopInRanges(
+        rows, GetNumThreadRanges(rows, cols), [&](int64_t range_id, int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, row, begin, end) {
+            const int64_t offset = row * cols;
+            const T* softmax_y_row = softmax_y_ptr + offset;
+            const T* dy_row = dy_ptr + offset;
+            const int8_t* mask_row = mask_ptr + offset;
+            T* dx_row = dx_ptr + offset;
+            FOR_RANGE(int64_t, j, 0, cols) {
+              dx_row[j] = dy_row[j] * static_cast<T>(mask_row[j]) * mask_scale;
+            }
+            ComputeSoftmaxGradRow(cols, dx_row, softmax_y_row, dx_row);
+            const int64_t num_tril_cols = GetNumTrilCols(row, tril_num_rows, cols, diagonal);
+            FOR_RANGE(int64_t, j, 0, num_tril_cols) { dx_row[j] *= tril_scale; }
+            std::fill(dx_row + num_tril_cols, dx_row + cols, static_cast<T>(0));
+          }
+        });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_TRIL_SCALE_SOFTMAX_MASK_SCALE_GRAD_CPU_KERNEL(dtype) \
+  REGISTER_USER_KERNEL("fused_tril_scale_softmax_mask_scale_grad")          \
+      .SetCreateFn<FusedTrilScaleSoftmaxMaskScaleGradCpuKernel<dtype>>()    \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)        \
+                       & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value));
+
+REGISTER_FUSED_TRIL_SCALE_SOFTMAX_MASK_SCALE_GRAD_CPU_KERNEL(float)
+REGISTER_FUSED_TRIL_SCALE_SOFTMAX_MASK_SCALE_GRAD_CPU_KERNEL(double)
+#undef REGISTER_FUSED_TRIL_SCALE_SOFTMAX_MASK_SCALE_GRAD_CPU_KERNEL
+
+}  // namespace oneflow
@@ -0,0 +1,211 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+
+#include <numeric>
+
+namespace oneflow {
+
+namespace {
+
+// What the compression of a rank left out of the gradients sent so far, added to the next
+// gradient before compressing it.
+template<typename T>
+class ErrorFeedbackState final : public user_op::OpKernelState {
+ public:
+  explicit ErrorFeedbackState(int64_t elem_cnt) : residual_(elem_cnt, 0) {}
+  ~ErrorFeedbackState() override = default;
+
+  T* mut_residual() { return residual_.data(); }
+  std::vector<int32_t>* mut_order() { return &order_; }
+
+ private:
+  std::vector<T> residual_;
+  std::vector<int32_t> order_;
+};
+
+template<typename T>
+std::shared_ptr<user_op::OpKernelState> CreateErrorFeedbackState(
+    user_op::KernelInitContext* ctx) {
+  return std::make_shared<ErrorFeedbackState<T>>(
+      ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape().elem_cnt());
+}
+
+}  // namespace
+
+template<typename T>
+class TopKGradientCompressKernel final : public user_op::OpKernel {
+ public:
+  TopKGradientCompressKernel() = default;
+  ~TopKGradientCompressKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return CreateErrorFeedbackState<T>(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    auto* error_feedback = dynamic_cast<ErrorFeedbackState<T>*>(state);
+    CHECK_NOTNULL(error_feedback);
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* values = ctx->Tensor4ArgNameAndIndex("values", 0);
+    user_op::Tensor* indices = ctx->Tensor4ArgNameAndIndex("indices", 0);
+    const int32_t elem_cnt = in->shape().elem_cnt();
+    const int32_t k = values->shape().elem_cnt();
+    const T* in_ptr = in->dptr<T>();
+    T* residual = error_feedback->mut_residual();
+    FOR_RANGE(int32_t, i, 0, elem_cnt) { residual[i] += in_ptr[i]; }
+    std::vector<int32_t>* order = error_feedback->mut_order();
+    order->resize(elem_cnt);
+    std::iota(order->begin(), order->end(), 0);
+    std::nth_element(order->begin(), order->begin() + (k - 1), order->end(),
+                     [residual](int32_t lhs, int32_t rhs) {
+                       return std::abs(residual[lhs]) > std::abs(residual[rhs]);
+                     });
+    // Sorted indices keep the scatter of the decompression going forward through the memory.
+    std::sort(order->begin(), order->begin() + k);
+    T* values_ptr = values->mut_dptr<T>();
+    int32_t* indices_ptr = indices->mut_dptr<int32_t>();
+    FOR_RANGE(int32_t, i, 0, k) {
+      const int32_t index = order->at(i);
+      values_ptr[i] = residual[index];
+      indices_ptr[i] = index;
+      residual[index] = 0;
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class TopKGradientDecompressKernel final : public user_op::OpKernel {
+ public:
+  TopKGradientDecompressKernel() = default;
+  ~TopKGradientDecompressKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* values = ctx->Tensor4ArgNameAndIndex("values", 0);
+    const user_op::Tensor* indices = ctx->Tensor4ArgNameAndIndex("indices", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int64_t elem_cnt = out->shape().elem_cnt();
+    const T* values_ptr = values->dptr<T>();
+    const int32_t* indices_ptr = indices->dptr<int32_t>();
+    T* out_ptr = out->mut_dptr<T>();
+    std::fill(out_ptr, out_ptr + elem_cnt, static_cast<T>(0));
+    FOR_RANGE(int64_t, i, 0, values->shape().elem_cnt()) {
+      const int32_t index = indices_ptr[i];
+      CHECK_GE(index, 0);
+      CHECK_LT(index, elem_cnt);
+      out_ptr[index] += values_ptr[i];
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class OneBitGradientCompressKernel final : public user_op::OpKernel {
+ public:
+  OneBitGradientCompressKernel() = default;
+  ~OneBitGradientCompressKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return CreateErrorFeedbackState<T>(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    auto* error_feedback = dynamic_cast<ErrorFeedbackState<T>*>(state);
+    CHECK_NOTNULL(error_feedback);
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* bits = ctx->Tensor4ArgNameAndIndex("bits", 0);
+    user_op::Tensor* scale = ctx->Tensor4ArgNameAndIndex("scale", 0);
+    const int64_t elem_cnt = in->shape().elem_cnt();
+    const T* in_ptr = in->dptr<T>();
+    T* residual = error_feedback->mut_residual();
+    T abs_sum = 0;
+    FOR_RANGE(int64_t, i, 0, elem_cnt) {
+      residual[i] += in_ptr[i];
+      abs_sum += std::abs(residual[i]);
+    }
+    // Every element is sent as +scale or -scale, the mean magnitude keeps the l1 norm.
+    const T mean = abs_sum / elem_cnt;
+    uint8_t* bits_ptr = reinterpret_cast<uint8_t*>(bits->mut_dptr<int8_t>());
+    std::memset(bits_ptr, 0, bits->shape().elem_cnt());
+    FOR_RANGE(int64_t, i, 0, elem_cnt) {
+      if (residual[i] >= 0) {
+        bits_ptr[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+        residual[i] -= mean;
+      } else {
+        residual[i] += mean;
+      }
+    }
+    *scale->mut_dptr<T>() = mean;
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class OneBitGradientDecompressKernel final : public user_op::OpKernel {
+ public:
+  OneBitGradientDecompressKernel() = default;
+  ~OneBitGradientDecompressKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* bits = ctx->Tensor4ArgNameAndIndex("bits", 0);
+    const user_op::Tensor* scale = ctx->Tensor4ArgNameAndIndex("scale", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int64_t elem_cnt = out->shape().elem_cnt();
+    const int64_t num_pieces = scale->shape().elem_cnt();
+    const int64_t piece_size = bits->shape().elem_cnt() / num_pieces;
+    const uint8_t* bits_ptr = reinterpret_cast<const uint8_t*>(bits->dptr<int8_t>());
+    const T* scale_ptr = scale->dptr<T>();
+    T* out_ptr = out->mut_dptr<T>();
+    std::fill(out_ptr, out_ptr + elem_cnt, static_cast<T>(0));
+    FOR_RANGE(int64_t, piece, 0, num_pieces) {
+      const uint8_t* piece_bits = bits_ptr + piece * piece_size;
+      const T piece_scale = scale_ptr[piece];
+      FOR_RANGE(int64_t, i, 0, elem_cnt) {
+        out_ptr[i] += ((piece_bits[i / 8] >> (i % 8)) & 1) ? piece_scale : -piece_scale;
+      }
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_GRADIENT_COMPRESSION_KERNELS(dtype, dtype_proto)                  \
+  REGISTER_USER_KERNEL("top_k_gradient_compress")                                  \
+      .SetCreateFn<TopKGradientCompressKernel<dtype>>()                            \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                          \
+                       & (user_op::HobDataType("in", 0) == dtype_proto));          \
+  REGISTER_USER_KERNEL("top_k_gradient_decompress")                                \
+      .SetCreateFn<TopKGradientDecompressKernel<dtype>>()                          \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                          \
+                       & (user_op::HobDataType("out", 0) == dtype_proto));         \
+  REGISTER_USER_KERNEL("one_bit_gradient_compress")                                \
+      .SetCreateFn<OneBitGradientCompressKernel<dtype>>()                          \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                          \
+                       & (user_op::HobDataType("in", 0) == dtype_proto));          \
+  REGISTER_USER_KERNEL("one_bit_gradient_decompress")                              \
+      .SetCreateFn<OneBitGradientDecompressKernel<dtype>>()                        \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                          \
+                       & (user_op::HobDataType("out", 0) == dtype_proto));
+
+OF_PP_FOR_EACH_TUPLE(REGISTER_GRADIENT_COMPRESSION_KERNELS, FLOATING_DATA_TYPE_SEQ)
+
+}  // namespace oneflow
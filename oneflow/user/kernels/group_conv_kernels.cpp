@@ -0,0 +1,301 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace {
+
+// Grouped and depthwise conv2d for channels_first, computed directly plane by plane. Every group
+// only has a few channels, the im2col + gemm of the groups one by one spends more time on the
+// col_buf than on the gemms.
+struct GroupConv2dDesc final {
+  GroupConv2dDesc(const ShapeView& x_shape, const ShapeView& y_shape, const ShapeView& w_shape,
+                  int32_t groups, const std::vector<int32_t>& strides,
+                  const std::vector<int32_t>& dilation_rate,
+                  const std::vector<int32_t>& padding_before)
+      : n(x_shape.At(0)),
+        ci(x_shape.At(1)),
+        ih(x_shape.At(2)),
+        iw(x_shape.At(3)),
+        co(y_shape.At(1)),
+        oh(y_shape.At(2)),
+        ow(y_shape.At(3)),
+        kh(w_shape.At(2)),
+        kw(w_shape.At(3)),
+        ci_per_group(ci / groups),
+        co_per_group(co / groups),
+        stride_h(strides.at(0)),
+        stride_w(strides.at(1)),
+        dilation_h(dilation_rate.at(0)),
+        dilation_w(dilation_rate.at(1)),
+        pad_h(padding_before.at(0)),
+        pad_w(padding_before.at(1)) {
+    CHECK_EQ(w_shape.At(1), ci_per_group);
+  }
+
+  int64_t n;
+  int64_t ci;
+  int64_t ih;
+  int64_t iw;
+  int64_t co;
+  int64_t oh;
+  int64_t ow;
+  int64_t kh;
+  int64_t kw;
+  int64_t ci_per_group;
+  int64_t co_per_group;
+  int64_t stride_h;
+  int64_t stride_w;
+  int64_t dilation_h;
+  int64_t dilation_w;
+  int64_t pad_h;
+  int64_t pad_w;
+};
+
+// The outputs [begin, end) reading the input o * stride + offset inside [0, in_size).
+void GetValidOutRange(int64_t offset, int64_t stride, int64_t in_size, int64_t out_size,
+                      int64_t* begin, int64_t* end) {
+  *begin = offset >= 0 ? 0 : (-offset + stride - 1) / stride;
+  *end = offset >= in_size ? 0 : std::min(out_size, (in_size - 1 - offset) / stride + 1);
+  *end = std::max(*begin, *end);
+}
+
+// Calls Handler(oh, ih, ow_begin, ow_end, iw_begin) for the output rows of the kernel tap
+// (kh, kw) and their input rows, the outputs [ow_begin, ow_end) of a row read the inputs from
+// iw_begin on with a step of stride_w.
+template<typename HandlerT>
+void ForEachValidRow(const GroupConv2dDesc& desc, int64_t kh, int64_t kw,
+                     const HandlerT& Handler) {
+  const int64_t h_offset = kh * desc.dilation_h - desc.pad_h;
+  const int64_t w_offset = kw * desc.dilation_w - desc.pad_w;
+  int64_t oh_begin = 0;
+  int64_t oh_end = 0;
+  int64_t ow_begin = 0;
+  int64_t ow_end = 0;
+  GetValidOutRange(h_offset, desc.stride_h, desc.ih, desc.oh, &oh_begin, &oh_end);
+  GetValidOutRange(w_offset, desc.stride_w, desc.iw, desc.ow, &ow_begin, &ow_end);
+  if (ow_begin == ow_end) { return; }
+  FOR_RANGE(int64_t, oh, oh_begin, oh_end) {
+    Handler(oh, oh * desc.stride_h + h_offset, ow_begin, ow_end,
+            ow_begin * desc.stride_w + w_offset);
+  }
+}
+
+template<typename T>
+class GroupConv2dCpuKernel final : public user_op::OpKernel {
+ public:
+  GroupConv2dCpuKernel() = default;
+  ~GroupConv2dCpuKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const GroupConv2dDesc desc(in->shape(), out->shape(), weight->shape(),
+                               ctx->Attr<int32_t>("groups"),
+                               ctx->Attr<std::vector<int32_t>>("strides"),
+                               ctx->Attr<std::vector<int32_t>>("dilation_rate"),
+                               ctx->Attr<std::vector<int32_t>>("padding_before"));
+    const T* x = in->dptr<T>();
+    const T* w = weight->dptr<T>();
+    const T* b = bias == nullptr ? nullptr : bias->dptr<T>();
+    T* y = out->mut_dptr<T>();
+    const int64_t num_planes = desc.n * desc.co;
+    const int64_t plane_work = desc.oh * desc.ow * desc.ci_per_group * desc.kh * desc.kw;
+    MultiThreadLoopInRanges(
+        num_planes, GetNumThreadRanges(num_planes, plane_work),
+        [&](int64_t range_id, int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, plane, begin, end) {
+            const int64_t oc = plane % desc.co;
+            const int64_t ic_begin = oc / desc.co_per_group * desc.ci_per_group;
+            T* y_plane = y + plane * desc.oh * desc.ow;
+            std::fill(y_plane, y_plane + desc.oh * desc.ow,
+                      b == nullptr ? static_cast<T>(0) : b[oc]);
+            FOR_RANGE(int64_t, c, 0, desc.ci_per_group) {
+              const T* x_plane =
+                  x + ((plane / desc.co) * desc.ci + ic_begin + c) * desc.ih * desc.iw;
+              const T* w_taps = w + (oc * desc.ci_per_group + c) * desc.kh * desc.kw;
+              FOR_RANGE(int64_t, kh, 0, desc.kh) {
+                FOR_RANGE(int64_t, kw, 0, desc.kw) {
+                  const T tap = w_taps[kh * desc.kw + kw];
+                  ForEachValidRow(desc, kh, kw, [&](int64_t oh, int64_t ih, int64_t ow_begin,
+                                                    int64_t ow_end, int64_t iw_begin) {
+                    T* y_row = y_plane + oh * desc.ow;
+                    const T* x_row = x_plane + ih * desc.iw + iw_begin;
+                    FOR_RANGE(int64_t, ow, ow_begin, ow_end) {
+                      y_row[ow] += tap * x_row[(ow - ow_begin) * desc.stride_w];
+                    }
+                  });
+                }
+              }
+            }
+          }
+        });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+// Every thread owns the planes of dx it accumulates into.
+template<typename T>
+class GroupConv2dDataGradCpuKernel final : public user_op::OpKernel {
+ public:
+  GroupConv2dDataGradCpuKernel() = default;
+  ~GroupConv2dDataGradCpuKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const user_op::Tensor* filter = ctx->Tensor4ArgNameAndIndex("filter", 0);
+    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const GroupConv2dDesc desc(dx->shape(), dy->shape(), filter->shape(),
+                               ctx->Attr<int32_t>("groups"),
+                               ctx->Attr<std::vector<int32_t>>("strides"),
+                               ctx->Attr<std::vector<int32_t>>("dilation_rate"),
+                               ctx->Attr<std::vector<int32_t>>("padding_before"));
+    const T* dy_dptr = dy->dptr<T>();
+    const T* w = filter->dptr<T>();
+    const T* add_to_output = nullptr;
+    if (ctx->has_input("_add_to_output", 0)) {
+      const user_op::Tensor* add_to_output_tensor =
+          ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+      CHECK_EQ(add_to_output_tensor->data_type(), dx->data_type());
+      CHECK_EQ(add_to_output_tensor->shape(), dx->shape());
+      add_to_output = add_to_output_tensor->dptr<T>();
+    }
+    T* dx_dptr = dx->mut_dptr<T>();
+    const int64_t num_planes = desc.n * desc.ci;
+    const int64_t plane_work = desc.oh * desc.ow * desc.co_per_group * desc.kh * desc.kw;
+    MultiThreadLoopInRanges(
+        num_planes, GetNumThreadRanges(num_planes, plane_work),
+        [&](int64_t range_id, int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, plane, begin, end) {
+            const int64_t ic = plane % desc.ci;
+            const int64_t c = ic % desc.ci_per_group;
+            const int64_t oc_begin = ic / desc.ci_per_group * desc.co_per_group;
+            const int64_t plane_size = desc.ih * desc.iw;
+            T* dx_plane = dx_dptr + plane * plane_size;
+            if (add_to_output == nullptr) {
+              std::fill(dx_plane, dx_plane + plane_size, static_cast<T>(0));
+            } else {
+              std::copy(add_to_output + plane * plane_size,
+                        add_to_output + (plane + 1) * plane_size, dx_plane);
+            }
+            FOR_RANGE(int64_t, oc, oc_begin, oc_begin + desc.co_per_group) {
+              const T* dy_plane =
+                  dy_dptr + ((plane / desc.ci) * desc.co + oc) * desc.oh * desc.ow;
+              const T* w_taps = w + (oc * desc.ci_per_group + c) * desc.kh * desc.kw;
+              FOR_RANGE(int64_t, kh, 0, desc.kh) {
+                FOR_RANGE(int64_t, kw, 0, desc.kw) {
+                  const T tap = w_taps[kh * desc.kw + kw];
+                  ForEachValidRow(desc, kh, kw, [&](int64_t oh, int64_t ih, int64_t ow_begin,
+                                                    int64_t ow_end, int64_t iw_begin) {
+                    const T* dy_row = dy_plane + oh * desc.ow;
+                    T* dx_row = dx_plane + ih * desc.iw + iw_begin;
+                    FOR_RANGE(int64_t, ow, ow_begin, ow_end) {
+                      dx_row[(ow - ow_begin) * desc.stride_w] += tap * dy_row[ow];
+                    }
+                  });
+                }
+              }
+            }
+          }
+        });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+// Every thread owns the filters of a range of output channels and reduces them over the batch.
+template<typename T>
+class GroupConv2dFilterGradCpuKernel final : public user_op::OpKernel {
+ public:
+  GroupConv2dFilterGradCpuKernel() = default;
+  ~GroupConv2dFilterGradCpuKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* filter_diff = ctx->Tensor4ArgNameAndIndex("filter_diff", 0);
+    const GroupConv2dDesc desc(x->shape(), dy->shape(), filter_diff->shape(),
+                               ctx->Attr<int32_t>("groups"),
+                               ctx->Attr<std::vector<int32_t>>("strides"),
+                               ctx->Attr<std::vector<int32_t>>("dilation_rate"),
+                               ctx->Attr<std::vector<int32_t>>("padding_before"));
+    const T* dy_dptr = dy->dptr<T>();
+    const T* x_dptr = x->dptr<T>();
+    T* dw = filter_diff->mut_dptr<T>();
+    const int64_t filter_work =
+        desc.n * desc.oh * desc.ow * desc.ci_per_group * desc.kh * desc.kw;
+    MultiThreadLoopInRanges(
+        desc.co, GetNumThreadRanges(desc.co, filter_work),
+        [&](int64_t range_id, int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, oc, begin, end) {
+            const int64_t ic_begin = oc / desc.co_per_group * desc.ci_per_group;
+            FOR_RANGE(int64_t, c, 0, desc.ci_per_group) {
+              T* dw_taps = dw + (oc * desc.ci_per_group + c) * desc.kh * desc.kw;
+              FOR_RANGE(int64_t, kh, 0, desc.kh) {
+                FOR_RANGE(int64_t, kw, 0, desc.kw) {
+                  T sum = 0;
+                  FOR_RANGE(int64_t, i, 0, desc.n) {
+                    const T* dy_plane = dy_dptr + (i * desc.co + oc) * desc.oh * desc.ow;
+                    const T* x_plane = x_dptr + (i * desc.ci + ic_begin + c) * desc.ih * desc.iw;
+                    ForEachValidRow(desc, kh, kw, [&](int64_t oh, int64_t ih, int64_t ow_begin,
+                                                      int64_t ow_end, int64_t iw_begin) {
+                      const T* dy_row = dy_plane + oh * desc.ow;
+                      const T* x_row = x_plane + ih * desc.iw + iw_begin;
+                      FOR_RANGE(int64_t, ow, ow_begin, ow_end) {
+                        sum += dy_row[ow] * x_row[(ow - ow_begin) * desc.stride_w];
+                      }
+                    });
+                  }
+                  dw_taps[kh * desc.kw + kw] = sum;
+                }
+              }
+            }
+          }
+        });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+}  // namespace
+
+#define GROUP_CONV2D_CPU_HOB(dtype_arg_name, dtype)                                     \
+  (user_op::HobDeviceTag() == "cpu") & (user_op::HobAttr<int32_t>("groups") > 1)        \
+      & (user_op::HobAttr<std::string>("data_format") == std::string("channels_first")) \
+      & (user_op::HobDataType(dtype_arg_name, 0) == GetDataType<dtype>::value)
+
+#define REGISTER_GROUP_CONV2D_CPU_KERNELS(dtype)                                \
+  REGISTER_USER_KERNEL("conv2d")                                                \
+      .SetCreateFn<GroupConv2dCpuKernel<dtype>>()                               \
+      .SetIsMatchedHob(GROUP_CONV2D_CPU_HOB("in", dtype));                      \
+  REGISTER_USER_KERNEL("conv_data_grad")                                        \
+      .SetCreateFn<GroupConv2dDataGradCpuKernel<dtype>>()                       \
+      .SetIsMatchedHob(GROUP_CONV2D_CPU_HOB("dy", dtype)                        \
+                       & (user_op::HobAttr<int32_t>("num_spatial_dims") == 2)); \
+  REGISTER_USER_KERNEL("conv_filter_grad")                                      \
+      .SetCreateFn<GroupConv2dFilterGradCpuKernel<dtype>>()                     \
+      .SetIsMatchedHob(GROUP_CONV2D_CPU_HOB("dy", dtype)                        \
+                       & (user_op::HobAttr<int32_t>("num_spatial_dims") == 2));
+
+REGISTER_GROUP_CONV2D_CPU_KERNELS(float)
+REGISTER_GROUP_CONV2D_CPU_KERNELS(double)
+
+}  // namespace oneflow
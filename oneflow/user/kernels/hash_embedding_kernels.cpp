@@ -0,0 +1,154 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/embedding/cpu_embedding_table.h"
+#include "oneflow/core/kernel/new_kernel_util.h"
+#include "oneflow/user/kernels/op_kernel_state_wrapper.h"
+
+namespace oneflow {
+
+namespace {
+
+CpuEmbeddingCombiner GetCpuEmbeddingCombiner(const std::string& combiner) {
+  if (combiner == "none") {
+    return CpuEmbeddingCombiner::kNone;
+  } else if (combiner == "sum") {
+    return CpuEmbeddingCombiner::kSum;
+  } else if (combiner == "mean") {
+    return CpuEmbeddingCombiner::kMean;
+  } else {
+    UNIMPLEMENTED();
+  }
+  return CpuEmbeddingCombiner::kNone;
+}
+
+CpuEmbeddingOptimizer GetCpuEmbeddingOptimizer(const std::string& optimizer) {
+  if (optimizer == "sgd") {
+    return CpuEmbeddingOptimizer::kSgd;
+  } else if (optimizer == "adagrad") {
+    return CpuEmbeddingOptimizer::kAdagrad;
+  } else {
+    UNIMPLEMENTED();
+  }
+  return CpuEmbeddingOptimizer::kSgd;
+}
+
+// The lookup and the update of an embedding get the same table of the session, the devices of a
+// process share it. A table does not span processes, so the placement must be on a single machine.
+std::shared_ptr<user_op::OpKernelState> CreateCpuEmbeddingTableState(
+    user_op::KernelInitContext* ctx) {
+  CHECK_EQ(ctx->parallel_desc().sorted_machine_ids().size(), 1)
+      << "the hash embedding table is not split across machines";
+  CHECK_NOTNULL(Global<CpuEmbeddingTableManager>::Get());
+  CpuEmbeddingTableConf conf;
+  conf.embedding_dim = ctx->Attr<int64_t>("embedding_dim");
+  conf.optimizer = GetCpuEmbeddingOptimizer(ctx->Attr<std::string>("optimizer"));
+  conf.epsilon = ctx->Attr<float>("epsilon");
+  conf.init_min = ctx->Attr<float>("init_min");
+  conf.init_max = ctx->Attr<float>("init_max");
+  conf.seed = ctx->Attr<int64_t>("seed");
+  conf.ttl = ctx->Attr<int64_t>("ttl");
+  CpuEmbeddingTable* table = Global<CpuEmbeddingTableManager>::Get()->GetOrCreateTable(
+      ctx->Attr<std::string>("embedding_name"), conf);
+  return std::make_shared<OpKernelStateWrapper<CpuEmbeddingTable*>>(table);
+}
+
+CpuEmbeddingTable* GetCpuEmbeddingTable(user_op::OpKernelState* state) {
+  auto* table_state = dynamic_cast<OpKernelStateWrapper<CpuEmbeddingTable*>*>(state);
+  CHECK_NOTNULL(table_state);
+  return table_state->Get();
+}
+
+}  // namespace
+
+template<typename K>
+class HashEmbeddingLookupCpuKernel final : public user_op::OpKernel {
+ public:
+  HashEmbeddingLookupCpuKernel() = default;
+  ~HashEmbeddingLookupCpuKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return CreateCpuEmbeddingTableState(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* ids = ctx->Tensor4ArgNameAndIndex("ids", 0);
+    user_op::Tensor* embeddings = ctx->Tensor4ArgNameAndIndex("embeddings", 0);
+    const int64_t num_ids = ids->shape().elem_cnt();
+    if (num_ids == 0) { return; }
+    GetCpuEmbeddingTable(state)->Lookup<K>(
+        num_ids, ids->dptr<K>(), ids->shape().At(ids->shape().NumAxes() - 1),
+        GetCpuEmbeddingCombiner(ctx->Attr<std::string>("combiner")),
+        embeddings->mut_dptr<float>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename K>
+class HashEmbeddingUpdateCpuKernel final : public user_op::OpKernel {
+ public:
+  HashEmbeddingUpdateCpuKernel() = default;
+  ~HashEmbeddingUpdateCpuKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return CreateCpuEmbeddingTableState(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* ids = ctx->Tensor4ArgNameAndIndex("ids", 0);
+    const user_op::Tensor* embedding_diff = ctx->Tensor4ArgNameAndIndex("embedding_diff", 0);
+    user_op::Tensor* shadow_diff = ctx->Tensor4ArgNameAndIndex("shadow_diff", 0);
+    Memset<DeviceType::kCPU>(ctx->device_ctx(), shadow_diff->mut_dptr(), 0,
+                             shadow_diff->shape().elem_cnt()
+                                 * GetSizeOfDataType(shadow_diff->data_type()));
+    int64_t num_ids = ids->shape().elem_cnt();
+    // A scaled loss may overflow, the rows are not updated with the inf or nan diffs of that step
+    // as they would never recover.
+    const float* diff_ptr = embedding_diff->dptr<float>();
+    const int64_t diff_cnt = embedding_diff->shape().elem_cnt();
+    if (!std::all_of(diff_ptr, diff_ptr + diff_cnt, [](float x) { return std::isfinite(x); })) {
+      LOG(WARNING) << "skips the update of hash_embedding "
+                   << ctx->Attr<std::string>("embedding_name")
+                   << " with a diff which is not finite";
+      num_ids = 0;
+    }
+    // an empty batch still counts as a step of the ttl
+    GetCpuEmbeddingTable(state)->Update<K>(
+        num_ids, ids->dptr<K>(), num_ids == 0 ? 1 : ids->shape().At(ids->shape().NumAxes() - 1),
+        GetCpuEmbeddingCombiner(ctx->Attr<std::string>("combiner")), diff_ptr,
+        1.0f / ctx->Attr<float>("loss_scale"), ctx->Attr<float>("learning_rate"));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+#define REGISTER_HASH_EMBEDDING_CPU_KERNELS(ids_cpp_type, ids_proto_type)               \
+  REGISTER_USER_KERNEL("hash_embedding_lookup")                                         \
+      .SetCreateFn<HashEmbeddingLookupCpuKernel<ids_cpp_type>>()                        \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                               \
+                       & (user_op::HobDataType("ids", 0) == ids_proto_type));           \
+  REGISTER_USER_KERNEL("hash_embedding_update")                                         \
+      .SetCreateFn<HashEmbeddingUpdateCpuKernel<ids_cpp_type>>()                        \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                               \
+                       & (user_op::HobDataType("ids", 0) == ids_proto_type));
+
+REGISTER_HASH_EMBEDDING_CPU_KERNELS(int32_t, DataType::kInt32)
+REGISTER_HASH_EMBEDDING_CPU_KERNELS(int64_t, DataType::kInt64)
+
+}  // namespace oneflow
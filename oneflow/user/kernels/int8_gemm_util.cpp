@@ -0,0 +1,207 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/int8_gemm_util.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "oneflow/core/kernel/util/host_isa_util.h"
+
+namespace oneflow {
+
+namespace int8_gemm {
+
+namespace {
+
+using host_isa::Isa;
+using host_isa::kDotNumCols;
+
+int32_t QuantizeOne(float x, float scale, int32_t zero_point, int32_t quant_min,
+                    int32_t quant_max) {
+  const float q = std::nearbyint(x / scale) + static_cast<float>(zero_point);
+  return static_cast<int32_t>(
+      std::min(std::max(q, static_cast<float>(quant_min)), static_cast<float>(quant_max)));
+}
+
+void DotScalar(int64_t k, const uint8_t* a, const int8_t* b, int64_t ldb, int64_t num_cols,
+               int32_t* c) {
+  for (int64_t j = 0; j < num_cols; ++j) {
+    const int8_t* b_j = b + j * ldb;
+    int32_t sum = 0;
+    for (int64_t p = 0; p < k; ++p) { sum += static_cast<int32_t>(a[p]) * b_j[p]; }
+    c[j] = sum;
+  }
+}
+
+#ifdef OF_HOST_ISA_WITH_AVX2
+
+__attribute__((target("avx2"))) int32_t HorizontalSum(__m256i v) {
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(sum);
+}
+
+// The bytes are widened to int16 and multiplied with madd, which can't saturate unlike maddubs.
+__attribute__((target("avx2"))) void DotAvx2(int64_t k, const uint8_t* a, const int8_t* b,
+                                             int64_t ldb, int64_t num_cols, int32_t* c) {
+  if (num_cols != kDotNumCols) { return DotScalar(k, a, b, ldb, num_cols, c); }
+  __m256i acc[kDotNumCols];
+  for (int64_t j = 0; j < kDotNumCols; ++j) { acc[j] = _mm256_setzero_si256(); }
+  int64_t p = 0;
+  for (; p + 16 <= k; p += 16) {
+    const __m256i a16 =
+        _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + p)));
+    for (int64_t j = 0; j < kDotNumCols; ++j) {
+      const __m256i b16 = _mm256_cvtepi8_epi16(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j * ldb + p)));
+      acc[j] = _mm256_add_epi32(acc[j], _mm256_madd_epi16(a16, b16));
+    }
+  }
+  for (int64_t j = 0; j < kDotNumCols; ++j) {
+    int32_t sum = HorizontalSum(acc[j]);
+    const int8_t* b_j = b + j * ldb;
+    for (int64_t q = p; q < k; ++q) { sum += static_cast<int32_t>(a[q]) * b_j[q]; }
+    c[j] = sum;
+  }
+}
+
+__attribute__((target("avx2"))) void QuantizeToUint8Avx2(const float* in, int64_t n, float scale,
+                                                         int32_t zero_point, int32_t quant_min,
+                                                         int32_t quant_max, uint8_t* out) {
+  const __m256 inv_scale = _mm256_set1_ps(1.0f / scale);
+  const __m256 zp = _mm256_set1_ps(static_cast<float>(zero_point));
+  const __m256 lo = _mm256_set1_ps(static_cast<float>(quant_min));
+  const __m256 hi = _mm256_set1_ps(static_cast<float>(quant_max));
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 x = _mm256_mul_ps(_mm256_loadu_ps(in + i), inv_scale);
+    x = _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(x, zp), lo), hi);
+    const __m256i q32 = _mm256_cvtps_epi32(x);
+    // 8 int32 in [0, 255] -> 8 bytes
+    const __m128i q16 =
+        _mm_packus_epi32(_mm256_castsi256_si128(q32), _mm256_extracti128_si256(q32, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(q16, q16));
+  }
+  for (; i < n; ++i) { out[i] = QuantizeOne(in[i], scale, zero_point, quant_min, quant_max); }
+}
+
+#endif  // OF_HOST_ISA_WITH_AVX2
+
+#ifdef OF_HOST_ISA_WITH_AVX512_VNNI
+
+__attribute__((target("avx512f,avx512bw,avx512vnni"))) void DotVnni(int64_t k, const uint8_t* a,
+                                                                   const int8_t* b, int64_t ldb,
+                                                                   int64_t num_cols, int32_t* c) {
+  if (num_cols != kDotNumCols) { return DotScalar(k, a, b, ldb, num_cols, c); }
+  __m512i acc[kDotNumCols];
+  for (int64_t j = 0; j < kDotNumCols; ++j) { acc[j] = _mm512_setzero_si512(); }
+  int64_t p = 0;
+  for (; p + 64 <= k; p += 64) {
+    const __m512i a8 = _mm512_loadu_si512(a + p);
+    for (int64_t j = 0; j < kDotNumCols; ++j) {
+      acc[j] = _mm512_dpbusd_epi32(acc[j], a8, _mm512_loadu_si512(b + j * ldb + p));
+    }
+  }
+  if (p < k) {
+    const __mmask64 mask = (~0ULL) >> (64 - (k - p));
+    const __m512i a8 = _mm512_maskz_loadu_epi8(mask, a + p);
+    for (int64_t j = 0; j < kDotNumCols; ++j) {
+      acc[j] = _mm512_dpbusd_epi32(acc[j], a8, _mm512_maskz_loadu_epi8(mask, b + j * ldb + p));
+    }
+  }
+  for (int64_t j = 0; j < kDotNumCols; ++j) {
+    int32_t lanes[16];
+    _mm512_storeu_si512(lanes, acc[j]);
+    int32_t sum = 0;
+    for (int32_t lane = 0; lane < 16; ++lane) { sum += lanes[lane]; }
+    c[j] = sum;
+  }
+}
+
+#endif  // OF_HOST_ISA_WITH_AVX512_VNNI
+
+using DotFn = void (*)(int64_t, const uint8_t*, const int8_t*, int64_t, int64_t, int32_t*);
+
+std::pair<Isa, DotFn> GetDot() {
+  static const std::pair<Isa, DotFn> dot = host_isa::Dispatch<DotFn>({
+#ifdef OF_HOST_ISA_WITH_AVX512_VNNI
+      {Isa::kAvx512Vnni, &DotVnni},
+#endif
+#ifdef OF_HOST_ISA_WITH_AVX2
+      {Isa::kAvx2, &DotAvx2},
+#endif
+      {Isa::kScalar, &DotScalar},
+  });
+  return dot;
+}
+
+Isa GetIsa() { return GetDot().first; }
+
+}  // namespace
+
+void QuantizeToUint8(const float* in, int64_t n, float scale, int32_t zero_point,
+                     int32_t quant_min, int32_t quant_max, uint8_t* out) {
+#ifdef OF_HOST_ISA_WITH_AVX2
+  if (GetIsa() != Isa::kScalar) {
+    return QuantizeToUint8Avx2(in, n, scale, zero_point, quant_min, quant_max, out);
+  }
+#endif
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = QuantizeOne(in[i], scale, zero_point, quant_min, quant_max);
+  }
+}
+
+void QuantizeToInt8(const float* in, int64_t n, float scale, int32_t zero_point,
+                    int32_t quant_min, int32_t quant_max, int32_t offset, int8_t* out) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = static_cast<int8_t>(QuantizeOne(in[i], scale, zero_point, quant_min, quant_max)
+                                 - offset);
+  }
+}
+
+void Gemm(int64_t row_begin, int64_t row_end, int64_t n, int64_t k, const uint8_t* a,
+          const int8_t* b, int32_t* c) {
+  const DotFn Dot = GetDot().second;
+  for (int64_t i = row_begin; i < row_end; ++i) {
+    for (int64_t j = 0; j < n; j += kDotNumCols) {
+      Dot(k, a + i * k, b + j * k, k, std::min(kDotNumCols, n - j), c + i * n + j);
+    }
+  }
+}
+
+void RowSum(int64_t rows, int64_t k, const uint8_t* a, int32_t* sum) {
+  for (int64_t i = 0; i < rows; ++i) {
+    int32_t s = 0;
+    for (int64_t p = 0; p < k; ++p) { s += a[i * k + p]; }
+    sum[i] = s;
+  }
+}
+
+void RowSum(int64_t rows, int64_t k, const int8_t* b, int32_t* sum) {
+  for (int64_t i = 0; i < rows; ++i) {
+    int32_t s = 0;
+    for (int64_t p = 0; p < k; ++p) { s += b[i * k + p]; }
+    sum[i] = s;
+  }
+}
+
+const char* IsaName() { return host_isa::IsaName(GetIsa()); }
+
+}  // namespace int8_gemm
+
+}  // namespace oneflow
@@ -0,0 +1,50 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_INT8_GEMM_UTIL_H_
+#define ONEFLOW_USER_KERNELS_INT8_GEMM_UTIL_H_
+
+#include <cstdint>
+
+namespace oneflow {
+
+namespace int8_gemm {
+
+// q = clamp(round(x / scale) + zero_point, quant_min, quant_max) within [0, 255]
+void QuantizeToUint8(const float* in, int64_t n, float scale, int32_t zero_point,
+                     int32_t quant_min, int32_t quant_max, uint8_t* out);
+
+// q = clamp(round(x / scale) + zero_point, quant_min, quant_max) - offset, the offset moves an
+// unsigned affine range into int8.
+void QuantizeToInt8(const float* in, int64_t n, float scale, int32_t zero_point,
+                    int32_t quant_min, int32_t quant_max, int32_t offset, int8_t* out);
+
+// c[i * n + j] = sum_p a[i * k + p] * b[j * k + p] for the rows i in [row_begin, row_end), that is
+// a (m, k) uint8 matrix times the transpose of a (n, k) int8 matrix accumulated in int32. The
+// products are exact, VNNI or AVX2 is used when the cpu has it.
+void Gemm(int64_t row_begin, int64_t row_end, int64_t n, int64_t k, const uint8_t* a,
+          const int8_t* b, int32_t* c);
+
+// Sums of the rows of a (rows, k) matrix, for the zero point corrections.
+void RowSum(int64_t rows, int64_t k, const uint8_t* a, int32_t* sum);
+void RowSum(int64_t rows, int64_t k, const int8_t* b, int32_t* sum);
+
+const char* IsaName();
+
+}  // namespace int8_gemm
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_INT8_GEMM_UTIL_H_
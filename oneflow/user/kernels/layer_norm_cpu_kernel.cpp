@@ -14,9 +14,122 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/kernels/welford_util.h"
 
 namespace oneflow {
 
+namespace {
+
+template<typename T, bool scale, bool center>
+void NormalizeRow(const int64_t n, const T* x, const T mean, const T inv_variance, const T* gamma,
+                  const T* beta, T* normalized, T* y) {
+  for (int64_t i = 0; i < n; ++i) {
+    const T normalized_i = (x[i] - mean) * inv_variance;
+    if (scale) { normalized[i] = normalized_i; }
+    T y_i = normalized_i;
+    if (scale) { y_i *= gamma[i]; }
+    if (center) { y_i += beta[i]; }
+    y[i] = y_i;
+  }
+}
+
+template<typename T, bool scale, bool center>
+void LayerNormForward(const int64_t num_instances, const int64_t norm_size, const double epsilon,
+                      const T* x, const T* gamma, const T* beta, T* normalized, T* y, T* mean,
+                      T* inv_variance) {
+  MultiThreadLoopInRanges(
+      num_instances, GetNumThreadRanges(num_instances, norm_size),
+      [&](int64_t, int64_t row_begin, int64_t row_end) {
+        FOR_RANGE(int64_t, row, row_begin, row_end) {
+          const int64_t offset = row * norm_size;
+          const WelfordStat<T> stat = WelfordReduce(norm_size, x + offset);
+          const T row_variance = stat.m2 / static_cast<T>(norm_size);
+          mean[row] = stat.mean;
+          inv_variance[row] = static_cast<T>(1) / std::sqrt(row_variance + static_cast<T>(epsilon));
+          NormalizeRow<T, scale, center>(norm_size, x + offset, mean[row], inv_variance[row], gamma,
+                                         beta, normalized + offset, y + offset);
+        }
+      });
+}
+
+template<typename T>
+void InstanceScaleCenter(const int64_t batch_size, const int64_t instance_size, const T* in,
+                         const T* gamma, const T* beta, T* out) {
+  MultiThreadLoopInRanges(batch_size, GetNumThreadRanges(batch_size, instance_size),
+                          [&](int64_t, int64_t row_begin, int64_t row_end) {
+                            FOR_RANGE(int64_t, row, row_begin, row_end) {
+                              const int64_t offset = row * instance_size;
+                              for (int64_t i = 0; i < instance_size; ++i) {
+                                T out_i = in[offset + i];
+                                if (gamma != nullptr) { out_i *= gamma[i]; }
+                                if (beta != nullptr) { out_i += beta[i]; }
+                                out[offset + i] = out_i;
+                              }
+                            }
+                          });
+}
+
+// dx = inv_variance * (dy - mean(dy) - normalized * mean(dy * normalized)), where normalized is
+// recomputed from x, mean and inv_variance.
+template<typename T>
+void LayerNormBackward(const int64_t num_instances, const int64_t norm_size, const T* dy,
+                       const T* x, const T* mean, const T* inv_variance, const T* add_to_output,
+                       T* dx) {
+  MultiThreadLoopInRanges(
+      num_instances, GetNumThreadRanges(num_instances, norm_size),
+      [&](int64_t, int64_t row_begin, int64_t row_end) {
+        FOR_RANGE(int64_t, row, row_begin, row_end) {
+          const int64_t offset = row * norm_size;
+          const T* dy_row = dy + offset;
+          const T* x_row = x + offset;
+          const T row_mean = mean[row];
+          const T row_inv_variance = inv_variance[row];
+          T lane_sum_dy[kNumWelfordLanes] = {0};
+          T lane_sum_dy_normalized[kNumWelfordLanes] = {0};
+          const int64_t num_steps = norm_size / kNumWelfordLanes;
+          for (int64_t step = 0; step < num_steps; ++step) {
+            const int64_t i = step * kNumWelfordLanes;
+            for (int64_t l = 0; l < kNumWelfordLanes; ++l) {
+              lane_sum_dy[l] += dy_row[i + l];
+              lane_sum_dy_normalized[l] +=
+                  dy_row[i + l] * (x_row[i + l] - row_mean) * row_inv_variance;
+            }
+          }
+          T sum_dy = 0;
+          T sum_dy_normalized = 0;
+          for (int64_t l = 0; l < kNumWelfordLanes; ++l) {
+            sum_dy += lane_sum_dy[l];
+            sum_dy_normalized += lane_sum_dy_normalized[l];
+          }
+          for (int64_t i = num_steps * kNumWelfordLanes; i < norm_size; ++i) {
+            sum_dy += dy_row[i];
+            sum_dy_normalized += dy_row[i] * (x_row[i] - row_mean) * row_inv_variance;
+          }
+          const T mean_dy = sum_dy / static_cast<T>(norm_size);
+          const T mean_dy_normalized = sum_dy_normalized / static_cast<T>(norm_size);
+          T* dx_row = dx + offset;
+          if (add_to_output != nullptr) {
+            const T* add_to_output_row = add_to_output + offset;
+            for (int64_t i = 0; i < norm_size; ++i) {
+              const T normalized_i = (x_row[i] - row_mean) * row_inv_variance;
+              dx_row[i] =
+                  add_to_output_row[i]
+                  + row_inv_variance * (dy_row[i] - mean_dy - normalized_i * mean_dy_normalized);
+            }
+          } else {
+            for (int64_t i = 0; i < norm_size; ++i) {
+              const T normalized_i = (x_row[i] - row_mean) * row_inv_variance;
+              dx_row[i] =
+                  row_inv_variance * (dy_row[i] - mean_dy - normalized_i * mean_dy_normalized);
+            }
+          }
+        }
+      });
+}
+
+}  // namespace
+
 template<typename T>
 class LayerNormCpuKernel final : public user_op::OpKernel {
  public:
@@ -25,7 +138,63 @@ class LayerNormCpuKernel final : public user_op::OpKernel {
 
  private:
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    user_op::Tensor* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    const bool scale = ctx->Attr<bool>("scale");
+    const bool center = ctx->Attr<bool>("center");
+    user_op::Tensor* normalized = scale ? ctx->Tensor4ArgNameAndIndex("normalized", 0) : y;
+    const double epsilon = ctx->Attr<double>("epsilon");
+    const int64_t num_instances = mean->shape().elem_cnt();
+    if (num_instances == 0) { return; }
+    const int64_t norm_size = x->shape().elem_cnt() / num_instances;
+    int64_t instance_size = 0;
+    const T* gamma_ptr = nullptr;
+    const T* beta_ptr = nullptr;
+    if (scale) {
+      const user_op::Tensor* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+      instance_size = gamma->shape().elem_cnt();
+      gamma_ptr = gamma->dptr<T>();
+    }
+    if (center) {
+      const user_op::Tensor* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+      if (gamma_ptr) {
+        CHECK_EQ(beta->shape().elem_cnt(), instance_size);
+      } else {
+        instance_size = beta->shape().elem_cnt();
+      }
+      beta_ptr = beta->dptr<T>();
+    }
+    if (scale || center) { CHECK_EQ(y->shape().elem_cnt() % instance_size, 0); }
+    T* mean_ptr = mean->mut_dptr<T>();
+    T* inv_variance_ptr = inv_variance->mut_dptr<T>();
+    if (instance_size == norm_size) {
+      if (scale && center) {
+        LayerNormForward<T, true, true>(num_instances, norm_size, epsilon, x->dptr<T>(), gamma_ptr,
+                                        beta_ptr, normalized->mut_dptr<T>(), y->mut_dptr<T>(),
+                                        mean_ptr, inv_variance_ptr);
+      } else if (scale) {
+        LayerNormForward<T, true, false>(num_instances, norm_size, epsilon, x->dptr<T>(),
+                                         gamma_ptr, beta_ptr, normalized->mut_dptr<T>(),
+                                         y->mut_dptr<T>(), mean_ptr, inv_variance_ptr);
+      } else {
+        LayerNormForward<T, false, true>(num_instances, norm_size, epsilon, x->dptr<T>(),
+                                         gamma_ptr, beta_ptr, normalized->mut_dptr<T>(),
+                                         y->mut_dptr<T>(), mean_ptr, inv_variance_ptr);
+      }
+    } else {
+      LayerNormForward<T, false, false>(num_instances, norm_size, epsilon, x->dptr<T>(), nullptr,
+                                        nullptr, nullptr, normalized->mut_dptr<T>(), mean_ptr,
+                                        inv_variance_ptr);
+      if (scale || center) {
+        const int64_t batch_size = y->shape().elem_cnt() / instance_size;
+        InstanceScaleCenter<T>(batch_size, instance_size, normalized->dptr<T>(), gamma_ptr,
+                               beta_ptr, y->mut_dptr<T>());
+      }
+    }
+  };
 };
 
 #define REGISTER_LAYER_NORM_CPU_KERNEL(dtype)             \
@@ -45,14 +214,39 @@ class LayerNormGradCpuKernel final : public user_op::OpKernel {
 
  private:
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    const user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const user_op::Tensor* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const T* add_to_output_ptr = nullptr;
+    if (ctx->has_input("_add_to_output", 0)) {
+      const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+      CHECK_EQ(add_to_output->data_type(), dx->data_type());
+      CHECK_EQ(add_to_output->shape(), dx->shape());
+      add_to_output_ptr = add_to_output->dptr<T>();
+    }
+    const int64_t num_instances = mean->shape().elem_cnt();
+    if (num_instances == 0) { return; }
+    const int64_t norm_size = x->shape().elem_cnt() / num_instances;
+    LayerNormBackward<T>(num_instances, norm_size, dy->dptr<T>(), x->dptr<T>(), mean->dptr<T>(),
+                         inv_variance->dptr<T>(), add_to_output_ptr, dx->mut_dptr<T>());
+  };
 };
 
-#define REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(dtype)        \
-  REGISTER_USER_KERNEL("layer_norm_grad")                 \
-      .SetCreateFn<LayerNormGradCpuKernel<dtype>>()       \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu") \
-                       & (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value));
+#define REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(dtype)                                              \
+  REGISTER_USER_KERNEL("layer_norm_grad")                                                       \
+      .SetCreateFn<LayerNormGradCpuKernel<dtype>>()                                             \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                       \
+                       & (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value))          \
+      .SetInplaceProposalFn([](const user_op::InferContext& ctx,                                \
+                               user_op::AddInplaceArgPair AddInplaceArgPairFn) -> Maybe<void> { \
+        if (ctx.has_input("_add_to_output", 0)) {                                               \
+          OF_RETURN_IF_ERROR(AddInplaceArgPairFn("dx", 0, "_add_to_output", 0, true));          \
+        }                                                                                       \
+        return Maybe<void>::Ok();                                                               \
+      });
 
 REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(float)
 REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(double)
@@ -65,7 +259,94 @@ class LayerNormParamGradCpuKernel final : public user_op::OpKernel {
 
  private:
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    user_op::Tensor* beta_diff = ctx->Tensor4ArgNameAndIndex("beta_diff", 0);
+    user_op::Tensor* gamma_diff = ctx->Tensor4ArgNameAndIndex("gamma_diff", 0);
+    user_op::Tensor* normalized_diff = ctx->Tensor4ArgNameAndIndex("normalized_diff", 0);
+    const user_op::Tensor* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const int64_t begin_params_axis = ctx->Attr<int64_t>("begin_params_axis");
+    const int64_t m = dy->shape().Count(begin_params_axis);
+    CHECK_EQ(dy->shape().elem_cnt() % m, 0);
+    const int64_t n = dy->shape().elem_cnt() / m;
+    const T* dy_ptr = dy->dptr<T>();
+    const T* normalized_ptr = nullptr;
+    const T* gamma_ptr = nullptr;
+    T* gamma_diff_ptr = nullptr;
+    T* beta_diff_ptr = nullptr;
+    T* normalized_diff_ptr = nullptr;
+    if (gamma_diff != nullptr) {
+      CHECK_EQ(m, gamma_diff->shape().elem_cnt());
+      normalized_ptr = ctx->Tensor4ArgNameAndIndex("normalized", 0)->dptr<T>();
+      gamma_diff_ptr = gamma_diff->mut_dptr<T>();
+      std::fill(gamma_diff_ptr, gamma_diff_ptr + m, static_cast<T>(0));
+    }
+    if (beta_diff != nullptr) {
+      CHECK_EQ(m, beta_diff->shape().elem_cnt());
+      beta_diff_ptr = beta_diff->mut_dptr<T>();
+      std::fill(beta_diff_ptr, beta_diff_ptr + m, static_cast<T>(0));
+    }
+    if (normalized_diff != nullptr) {
+      if (gamma != nullptr) {
+        CHECK_EQ(m, gamma->shape().elem_cnt());
+        gamma_ptr = gamma->dptr<T>();
+      }
+      normalized_diff_ptr = normalized_diff->mut_dptr<T>();
+    }
+    if (n == 0) { return; }
+    // Every row range sums its partial gamma_diff and beta_diff into two rows of reduce_buf, which
+    // has the shape of dy, so there are at most n / 2 ranges when the param diffs are needed.
+    const bool has_param_diff = gamma_diff_ptr != nullptr || beta_diff_ptr != nullptr;
+    int64_t num_ranges = GetNumThreadRanges(n, m);
+    if (has_param_diff) { num_ranges = std::max<int64_t>(std::min(num_ranges, n / 2), 1); }
+    T* reduce_buf_ptr =
+        has_param_diff ? ctx->Tensor4ArgNameAndIndex("reduce_buf", 0)->mut_dptr<T>() : nullptr;
+    MultiThreadLoopInRanges(
+        n, num_ranges, [&](int64_t range_id, int64_t row_begin, int64_t row_end) {
+          T* partial_gamma_diff = gamma_diff_ptr;
+          T* partial_beta_diff = beta_diff_ptr;
+          if (num_ranges > 1 && has_param_diff) {
+            partial_gamma_diff = reduce_buf_ptr + 2 * range_id * m;
+            partial_beta_diff = partial_gamma_diff + m;
+            std::fill(partial_gamma_diff, partial_gamma_diff + 2 * m, static_cast<T>(0));
+          }
+          FOR_RANGE(int64_t, row, row_begin, row_end) {
+            const int64_t offset = row * m;
+            const T* dy_row = dy_ptr + offset;
+            if (gamma_diff_ptr != nullptr) {
+              const T* normalized_row = normalized_ptr + offset;
+              for (int64_t i = 0; i < m; ++i) {
+                partial_gamma_diff[i] += dy_row[i] * normalized_row[i];
+              }
+            }
+            if (beta_diff_ptr != nullptr) {
+              for (int64_t i = 0; i < m; ++i) { partial_beta_diff[i] += dy_row[i]; }
+            }
+            if (normalized_diff_ptr != nullptr) {
+              T* normalized_diff_row = normalized_diff_ptr + offset;
+              if (gamma_ptr != nullptr) {
+                for (int64_t i = 0; i < m; ++i) {
+                  normalized_diff_row[i] = dy_row[i] * gamma_ptr[i];
+                }
+              } else {
+                std::copy(dy_row, dy_row + m, normalized_diff_row);
+              }
+            }
+          }
+        });
+    if (num_ranges > 1 && has_param_diff) {
+      FOR_RANGE(int64_t, range_id, 0, num_ranges) {
+        const T* partial_gamma_diff = reduce_buf_ptr + 2 * range_id * m;
+        const T* partial_beta_diff = partial_gamma_diff + m;
+        if (gamma_diff_ptr != nullptr) {
+          for (int64_t i = 0; i < m; ++i) { gamma_diff_ptr[i] += partial_gamma_diff[i]; }
+        }
+        if (beta_diff_ptr != nullptr) {
+          for (int64_t i = 0; i < m; ++i) { beta_diff_ptr[i] += partial_beta_diff[i]; }
+        }
+      }
+    }
+  };
 };
 
 #define REGISTER_LAYER_NORM_PARAM_GRAD_CPU_KERNEL(dtype)  \
@@ -0,0 +1,541 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/kernels/welford_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// The relu mask of normalization_add_relu keeps bit i % 32 of word i / 32 for the element i, like
+// the gpu kernels do, so the elementwise loops split the elements at multiples of 32.
+constexpr int64_t kMaskWordBits = 32;
+constexpr int64_t kElemCntPerBlock = 4096;
+
+// x viewed as (outer, channels, inner), inner is 1 for the channel last layout.
+struct ChannelView {
+  ChannelView(const ShapeView& shape, int32_t axis)
+      : outer(shape.Count(0, axis)), channels(shape.At(axis)), inner(shape.Count(axis + 1)) {}
+  int64_t elem_cnt() const { return outer * channels * inner; }
+  int64_t outer;
+  int64_t channels;
+  int64_t inner;
+};
+
+// Calls Handler(begin, end) for blocks of at most kElemCntPerBlock elements, parallel over ranges
+// of the elements starting at multiples of kMaskWordBits.
+template<typename HandlerT>
+void ForEachElemBlock(const int64_t elem_cnt, const HandlerT& Handler) {
+  const int64_t num_words = RoundUp(elem_cnt, kMaskWordBits) / kMaskWordBits;
+  MultiThreadLoopInRanges(num_words, GetNumThreadRanges(num_words, kMaskWordBits),
+                          [&](int64_t, int64_t word_begin, int64_t word_end) {
+                            const int64_t end = std::min(word_end * kMaskWordBits, elem_cnt);
+                            for (int64_t begin = word_begin * kMaskWordBits; begin < end;
+                                 begin += kElemCntPerBlock) {
+                              Handler(begin, std::min(begin + kElemCntPerBlock, end));
+                            }
+                          });
+}
+
+// Calls Handler(offset, len, channel) for the runs of [begin, end) whose element i + k belongs to
+// channel + k for the channel last layout, and to channel for the channel first layout.
+template<typename HandlerT>
+void ForEachChannelRun(const ChannelView& view, const int64_t begin, const int64_t end,
+                       const HandlerT& Handler) {
+  int64_t offset = begin;
+  while (offset < end) {
+    int64_t channel = 0;
+    int64_t len = 0;
+    if (view.inner == 1) {
+      channel = offset % view.channels;
+      len = std::min(end - offset, view.channels - channel);
+    } else {
+      channel = (offset / view.inner) % view.channels;
+      len = std::min(end - offset, view.inner - offset % view.inner);
+    }
+    Handler(offset, len, channel);
+    offset += len;
+  }
+}
+
+// y = x * scale[c] + shift[c] + add, where add is _add_to_output or addend and may alias y.
+template<typename T>
+void ChannelAffine(const ChannelView& view, const int64_t begin, const int64_t end, const T* x,
+                   const T* scale, const T* shift, const T* add, T* y) {
+  ForEachChannelRun(view, begin, end, [&](int64_t offset, int64_t len, int64_t channel) {
+    const T* x_run = x + offset;
+    T* y_run = y + offset;
+    if (view.inner == 1) {
+      const T* scale_run = scale + channel;
+      const T* shift_run = shift + channel;
+      if (add != nullptr) {
+        const T* add_run = add + offset;
+        for (int64_t i = 0; i < len; ++i) {
+          y_run[i] = x_run[i] * scale_run[i] + shift_run[i] + add_run[i];
+        }
+      } else {
+        for (int64_t i = 0; i < len; ++i) { y_run[i] = x_run[i] * scale_run[i] + shift_run[i]; }
+      }
+    } else {
+      const T channel_scale = scale[channel];
+      const T channel_shift = shift[channel];
+      if (add != nullptr) {
+        const T* add_run = add + offset;
+        for (int64_t i = 0; i < len; ++i) {
+          y_run[i] = x_run[i] * channel_scale + channel_shift + add_run[i];
+        }
+      } else {
+        for (int64_t i = 0; i < len; ++i) { y_run[i] = x_run[i] * channel_scale + channel_shift; }
+      }
+    }
+  });
+}
+
+// dx = dy * dy_coeff[c] + x * x_coeff[c] + bias[c].
+template<typename T>
+void ChannelGradAffine(const ChannelView& view, const int64_t begin, const int64_t end, const T* x,
+                       const T* dy, const T* dy_coeff, const T* x_coeff, const T* bias, T* dx) {
+  ForEachChannelRun(view, begin, end, [&](int64_t offset, int64_t len, int64_t channel) {
+    const T* x_run = x + offset;
+    const T* dy_run = dy + offset;
+    T* dx_run = dx + offset;
+    if (view.inner == 1) {
+      const T* dy_coeff_run = dy_coeff + channel;
+      const T* x_coeff_run = x_coeff + channel;
+      const T* bias_run = bias + channel;
+      for (int64_t i = 0; i < len; ++i) {
+        dx_run[i] = dy_run[i] * dy_coeff_run[i] + x_run[i] * x_coeff_run[i] + bias_run[i];
+      }
+    } else {
+      const T channel_dy_coeff = dy_coeff[channel];
+      const T channel_x_coeff = x_coeff[channel];
+      const T channel_bias = bias[channel];
+      for (int64_t i = 0; i < len; ++i) {
+        dx_run[i] = dy_run[i] * channel_dy_coeff + x_run[i] * channel_x_coeff + channel_bias;
+      }
+    }
+  });
+}
+
+template<typename T>
+void ReluWithMask(const int64_t begin, const int64_t end, T* y, int32_t* mask) {
+  for (int64_t i = begin; i < end; ++i) { y[i] = y[i] > static_cast<T>(0) ? y[i] : 0; }
+  for (int64_t word_begin = begin; word_begin < end; word_begin += kMaskWordBits) {
+    const int64_t word_len = std::min(kMaskWordBits, end - word_begin);
+    uint32_t word = 0;
+    for (int64_t k = 0; k < word_len; ++k) {
+      word |= static_cast<uint32_t>(y[word_begin + k] > static_cast<T>(0)) << k;
+    }
+    mask[word_begin / kMaskWordBits] = static_cast<int32_t>(word);
+  }
+}
+
+// The mean and the biased variance of every channel in a single Welford pass over x, parallel
+// over the channels. The channel last layout runs the recurrence of a slice of channels row by
+// row, which the compiler vectorizes along the channels.
+template<typename T>
+void ComputeChannelMeanAndVariance(const ChannelView& view, const T* x, T* mean, T* variance) {
+  const int64_t num_per_channel = view.outer * view.inner;
+  MultiThreadLoopInRanges(
+      view.channels, GetNumThreadRanges(view.channels, num_per_channel),
+      [&](int64_t, int64_t channel_begin, int64_t channel_end) {
+        if (view.inner == 1) {
+          const int64_t len = channel_end - channel_begin;
+          T* slice_mean = mean + channel_begin;
+          T* slice_m2 = variance + channel_begin;
+          std::fill(slice_mean, slice_mean + len, static_cast<T>(0));
+          std::fill(slice_m2, slice_m2 + len, static_cast<T>(0));
+          FOR_RANGE(int64_t, row, 0, view.outer) {
+            const T* x_slice = x + row * view.channels + channel_begin;
+            const T inv_count = static_cast<T>(1) / static_cast<T>(row + 1);
+            for (int64_t i = 0; i < len; ++i) {
+              const T delta = x_slice[i] - slice_mean[i];
+              slice_mean[i] += delta * inv_count;
+              slice_m2[i] += delta * (x_slice[i] - slice_mean[i]);
+            }
+          }
+          for (int64_t i = 0; i < len; ++i) {
+            slice_m2[i] /= static_cast<T>(num_per_channel);
+          }
+        } else {
+          FOR_RANGE(int64_t, channel, channel_begin, channel_end) {
+            WelfordStat<T> stat{0, 0, 0};
+            FOR_RANGE(int64_t, n, 0, view.outer) {
+              const T* x_block = x + (n * view.channels + channel) * view.inner;
+              WelfordMerge(WelfordReduce(view.inner, x_block), &stat);
+            }
+            mean[channel] = stat.mean;
+            variance[channel] = stat.m2 / static_cast<T>(num_per_channel);
+          }
+        }
+      });
+}
+
+// The sums of dy and of dy * (x - mean) of every channel, parallel over the channels.
+template<typename T>
+void ComputeChannelGradSums(const ChannelView& view, const T* x, const T* dy, const T* mean,
+                            T* sum_dy, T* sum_dy_x_centered) {
+  MultiThreadLoopInRanges(
+      view.channels, GetNumThreadRanges(view.channels, view.outer * view.inner),
+      [&](int64_t, int64_t channel_begin, int64_t channel_end) {
+        if (view.inner == 1) {
+          const int64_t len = channel_end - channel_begin;
+          const T* slice_mean = mean + channel_begin;
+          T* slice_sum_dy = sum_dy + channel_begin;
+          T* slice_sum_dy_x_centered = sum_dy_x_centered + channel_begin;
+          std::fill(slice_sum_dy, slice_sum_dy + len, static_cast<T>(0));
+          std::fill(slice_sum_dy_x_centered, slice_sum_dy_x_centered + len, static_cast<T>(0));
+          FOR_RANGE(int64_t, row, 0, view.outer) {
+            const int64_t offset = row * view.channels + channel_begin;
+            const T* x_slice = x + offset;
+            const T* dy_slice = dy + offset;
+            for (int64_t i = 0; i < len; ++i) {
+              slice_sum_dy[i] += dy_slice[i];
+              slice_sum_dy_x_centered[i] += dy_slice[i] * (x_slice[i] - slice_mean[i]);
+            }
+          }
+        } else {
+          FOR_RANGE(int64_t, channel, channel_begin, channel_end) {
+            const T channel_mean = mean[channel];
+            T lane_sum_dy[kNumWelfordLanes] = {0};
+            T lane_sum_dy_x_centered[kNumWelfordLanes] = {0};
+            T channel_sum_dy = 0;
+            T channel_sum_dy_x_centered = 0;
+            const int64_t num_steps = view.inner / kNumWelfordLanes;
+            FOR_RANGE(int64_t, n, 0, view.outer) {
+              const int64_t offset = (n * view.channels + channel) * view.inner;
+              const T* x_block = x + offset;
+              const T* dy_block = dy + offset;
+              for (int64_t step = 0; step < num_steps; ++step) {
+                const int64_t i = step * kNumWelfordLanes;
+                for (int64_t l = 0; l < kNumWelfordLanes; ++l) {
+                  lane_sum_dy[l] += dy_block[i + l];
+                  lane_sum_dy_x_centered[l] += dy_block[i + l] * (x_block[i + l] - channel_mean);
+                }
+              }
+              for (int64_t i = num_steps * kNumWelfordLanes; i < view.inner; ++i) {
+                channel_sum_dy += dy_block[i];
+                channel_sum_dy_x_centered += dy_block[i] * (x_block[i] - channel_mean);
+              }
+            }
+            for (int64_t l = 0; l < kNumWelfordLanes; ++l) {
+              channel_sum_dy += lane_sum_dy[l];
+              channel_sum_dy_x_centered += lane_sum_dy_x_centered[l];
+            }
+            sum_dy[channel] = channel_sum_dy;
+            sum_dy_x_centered[channel] = channel_sum_dy_x_centered;
+          }
+        }
+      });
+}
+
+// The tmp_buffer keeps num_params per channel arrays of the data type of x.
+size_t GetChannelParamsSize(int64_t channels, int64_t num_params, DataType data_type) {
+  return GetCudaAlignedSize(num_params * channels * GetSizeOfDataType(data_type));
+}
+
+size_t InferChannelParamsTmpSize(user_op::InferContext* ctx, int64_t num_params) {
+  const auto* x = ctx->TensorDesc4ArgNameAndIndex("x", 0);
+  return GetChannelParamsSize(x->shape().At(ctx->Attr<int32_t>("axis")), num_params,
+                              x->data_type());
+}
+
+}  // namespace
+
+template<typename T>
+class NormalizationInferenceCpuKernel final : public user_op::OpKernel {
+ public:
+  NormalizationInferenceCpuKernel() = default;
+  ~NormalizationInferenceCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    CHECK(!ctx->Attr<bool>("training"));
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const auto* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+    const auto* moving_mean = ctx->Tensor4ArgNameAndIndex("moving_mean", 0);
+    const auto* moving_variance = ctx->Tensor4ArgNameAndIndex("moving_variance", 0);
+    auto* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const auto axis = ctx->Attr<int32_t>("axis");
+    const auto epsilon = ctx->Attr<float>("epsilon");
+    CHECK_EQ(x->shape(), y->shape());
+    CHECK_GE(axis, 0);
+    CHECK_LT(axis, x->shape().NumAxes());
+    const ChannelView view(x->shape(), axis);
+    const T* add_to_output_ptr = nullptr;
+    if (ctx->has_input("_add_to_output", 0)) {
+      const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+      CHECK_EQ(add_to_output->data_type(), y->data_type());
+      CHECK_EQ(add_to_output->shape(), y->shape());
+      add_to_output_ptr = add_to_output->dptr<T>();
+    }
+    T* scale = tmp_buffer->mut_dptr<T>();
+    T* shift = scale + view.channels;
+    FOR_RANGE(int64_t, c, 0, view.channels) {
+      scale[c] = gamma->dptr<T>()[c]
+                 / std::sqrt(moving_variance->dptr<T>()[c] + static_cast<T>(epsilon));
+      shift[c] = beta->dptr<T>()[c] - moving_mean->dptr<T>()[c] * scale[c];
+    }
+    ForEachElemBlock(view.elem_cnt(), [&](int64_t begin, int64_t end) {
+      ChannelAffine(view, begin, end, x->dptr<T>(), scale, shift, add_to_output_ptr,
+                    y->mut_dptr<T>());
+    });
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BN_INFERENCE_CPU_KERNEL(dtype)                                                 \
+  REGISTER_USER_KERNEL("normalization")                                                         \
+      .SetCreateFn<NormalizationInferenceCpuKernel<dtype>>()                                    \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                       \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)            \
+                       & (user_op::HobAttr<bool>("training") == false))                         \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                                       \
+        return InferChannelParamsTmpSize(ctx, 2);                                               \
+      })                                                                                        \
+      .SetInplaceProposalFn([](const user_op::InferContext& ctx,                                \
+                               user_op::AddInplaceArgPair AddInplaceArgPairFn) -> Maybe<void> { \
+        if (ctx.has_input("_add_to_output", 0)) {                                               \
+          OF_RETURN_IF_ERROR(AddInplaceArgPairFn("y", 0, "_add_to_output", 0, true));           \
+        }                                                                                       \
+        return Maybe<void>::Ok();                                                               \
+      });
+
+REGISTER_BN_INFERENCE_CPU_KERNEL(float)
+REGISTER_BN_INFERENCE_CPU_KERNEL(double)
+
+#undef REGISTER_BN_INFERENCE_CPU_KERNEL
+
+template<typename T>
+class NormalizationTrainCpuKernel final : public user_op::OpKernel {
+ public:
+  NormalizationTrainCpuKernel() = default;
+  ~NormalizationTrainCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    if (ctx->op_type_name() == "normalization") { CHECK(ctx->Attr<bool>("training")); }
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const auto* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+    auto* moving_mean = ctx->Tensor4ArgNameAndIndex("moving_mean", 0);
+    auto* moving_variance = ctx->Tensor4ArgNameAndIndex("moving_variance", 0);
+    auto* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    auto* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    auto* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const auto axis = ctx->Attr<int32_t>("axis");
+    const auto epsilon = ctx->Attr<float>("epsilon");
+    const auto momentum = ctx->Attr<float>("momentum");
+    CHECK_EQ(x->shape(), y->shape());
+    CHECK_GE(axis, 0);
+    CHECK_LT(axis, x->shape().NumAxes());
+    const ChannelView view(x->shape(), axis);
+    const T* add_ptr = nullptr;
+    if (ctx->has_input("_add_to_output", 0)) {
+      const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+      CHECK_EQ(add_to_output->data_type(), y->data_type());
+      CHECK_EQ(add_to_output->shape(), y->shape());
+      add_ptr = add_to_output->dptr<T>();
+    }
+    int32_t* mask_ptr = nullptr;
+    if (ctx->op_type_name() == "normalization_add_relu") {
+      CHECK(!ctx->has_input("_add_to_output", 0));
+      if (ctx->has_input("addend", 0)) {
+        add_ptr = ctx->Tensor4ArgNameAndIndex("addend", 0)->dptr<T>();
+      }
+      mask_ptr = ctx->Tensor4ArgNameAndIndex("reserve_space", 0)->mut_dptr<int32_t>();
+    }
+
+    T* mean_ptr = mean->mut_dptr<T>();
+    T* inv_variance_ptr = inv_variance->mut_dptr<T>();
+    ComputeChannelMeanAndVariance(view, x->dptr<T>(), mean_ptr, inv_variance_ptr);
+    const int64_t num_per_channel = view.outer * view.inner;
+    const T unbias_factor =
+        num_per_channel > 1
+            ? static_cast<T>(num_per_channel) / static_cast<T>(num_per_channel - 1)
+            : static_cast<T>(1);
+    T* scale = tmp_buffer->mut_dptr<T>();
+    T* shift = scale + view.channels;
+    T* moving_mean_ptr = moving_mean->mut_dptr<T>();
+    T* moving_variance_ptr = moving_variance->mut_dptr<T>();
+    FOR_RANGE(int64_t, c, 0, view.channels) {
+      const T variance = inv_variance_ptr[c];
+      moving_mean_ptr[c] = moving_mean_ptr[c] * momentum + mean_ptr[c] * (1 - momentum);
+      moving_variance_ptr[c] =
+          moving_variance_ptr[c] * momentum + variance * unbias_factor * (1 - momentum);
+      inv_variance_ptr[c] = static_cast<T>(1) / std::sqrt(variance + static_cast<T>(epsilon));
+      scale[c] = gamma->dptr<T>()[c] * inv_variance_ptr[c];
+      shift[c] = beta->dptr<T>()[c] - mean_ptr[c] * scale[c];
+    }
+    ForEachElemBlock(view.elem_cnt(), [&](int64_t begin, int64_t end) {
+      ChannelAffine(view, begin, end, x->dptr<T>(), scale, shift, add_ptr, y->mut_dptr<T>());
+      if (mask_ptr != nullptr) { ReluWithMask(begin, end, y->mut_dptr<T>(), mask_ptr); }
+    });
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BN_TRAIN_CPU_KERNEL(dtype)                                                     \
+  REGISTER_USER_KERNEL("normalization")                                                         \
+      .SetCreateFn<NormalizationTrainCpuKernel<dtype>>()                                        \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                       \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)            \
+                       & (user_op::HobAttr<bool>("training") == true))                          \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                                       \
+        return InferChannelParamsTmpSize(ctx, 2);                                               \
+      })                                                                                        \
+      .SetInplaceProposalFn([](const user_op::InferContext& ctx,                                \
+                               user_op::AddInplaceArgPair AddInplaceArgPairFn) -> Maybe<void> { \
+        if (ctx.has_input("_add_to_output", 0)) {                                               \
+          OF_RETURN_IF_ERROR(AddInplaceArgPairFn("y", 0, "_add_to_output", 0, true));           \
+        }                                                                                       \
+        return Maybe<void>::Ok();                                                               \
+      });
+
+REGISTER_BN_TRAIN_CPU_KERNEL(float)
+REGISTER_BN_TRAIN_CPU_KERNEL(double)
+
+#undef REGISTER_BN_TRAIN_CPU_KERNEL
+
+#define REGISTER_BN_ADD_RELU_CPU_KERNEL(dtype)                                        \
+  REGISTER_USER_KERNEL("normalization_add_relu")                                      \
+      .SetCreateFn<NormalizationTrainCpuKernel<dtype>>()                              \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                             \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                             \
+        return InferChannelParamsTmpSize(ctx, 2);                                     \
+      });
+
+REGISTER_BN_ADD_RELU_CPU_KERNEL(float)
+REGISTER_BN_ADD_RELU_CPU_KERNEL(double)
+
+#undef REGISTER_BN_ADD_RELU_CPU_KERNEL
+
+template<typename T>
+class NormalizationGradCpuKernel final : public user_op::OpKernel {
+ public:
+  NormalizationGradCpuKernel() = default;
+  ~NormalizationGradCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const auto* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    auto* gamma_diff = ctx->Tensor4ArgNameAndIndex("gamma_diff", 0);
+    auto* beta_diff = ctx->Tensor4ArgNameAndIndex("beta_diff", 0);
+    const auto* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const auto* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    auto* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const auto axis = ctx->Attr<int32_t>("axis");
+    CHECK_EQ(dy->shape(), x->shape());
+    CHECK_EQ(dx->shape(), x->shape());
+    CHECK_GE(axis, 0);
+    CHECK_LT(axis, x->shape().NumAxes());
+    const ChannelView view(x->shape(), axis);
+    const int64_t elem_cnt = view.elem_cnt();
+
+    // The coefficients of dx = dy_coeff[c] * dy + x_coeff[c] * x + bias[c] come first in
+    // tmp_buffer, then the relu masked dy of normalization_add_relu_grad if there is no
+    // addend_diff to hold it.
+    T* dy_coeff = tmp_buffer->mut_dptr<T>();
+    T* x_coeff = dy_coeff + view.channels;
+    T* bias = x_coeff + view.channels;
+    const T* bn_dy_ptr = dy->dptr<T>();
+    if (ctx->op_type_name() == "normalization_add_relu_grad") {
+      const int32_t* mask = ctx->Tensor4ArgNameAndIndex("reserve_space", 0)->dptr<int32_t>();
+      T* relu_dy = nullptr;
+      if (ctx->has_output("addend_diff", 0)) {
+        relu_dy = ctx->Tensor4ArgNameAndIndex("addend_diff", 0)->mut_dptr<T>();
+      } else {
+        relu_dy = reinterpret_cast<T*>(tmp_buffer->mut_dptr<char>()
+                                       + GetChannelParamsSize(view.channels, 3, x->data_type()));
+      }
+      ForEachElemBlock(elem_cnt, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          const bool is_positive = (mask[i / kMaskWordBits] >> (i % kMaskWordBits)) & 1;
+          relu_dy[i] = is_positive ? dy->dptr<T>()[i] : static_cast<T>(0);
+        }
+      });
+      bn_dy_ptr = relu_dy;
+    } else {
+      CHECK_EQ(ctx->op_type_name(), "normalization_grad");
+    }
+
+    T* gamma_diff_ptr = gamma_diff->mut_dptr<T>();
+    T* beta_diff_ptr = beta_diff->mut_dptr<T>();
+    ComputeChannelGradSums(view, x->dptr<T>(), bn_dy_ptr, mean->dptr<T>(), beta_diff_ptr,
+                           gamma_diff_ptr);
+    const T inv_num_per_channel = static_cast<T>(1) / static_cast<T>(view.outer * view.inner);
+    FOR_RANGE(int64_t, c, 0, view.channels) {
+      const T channel_inv_variance = inv_variance->dptr<T>()[c];
+      gamma_diff_ptr[c] *= channel_inv_variance;
+      const T scale = gamma->dptr<T>()[c] * channel_inv_variance;
+      dy_coeff[c] = scale;
+      x_coeff[c] = -scale * channel_inv_variance * gamma_diff_ptr[c] * inv_num_per_channel;
+      bias[c] = -scale * beta_diff_ptr[c] * inv_num_per_channel
+                - x_coeff[c] * mean->dptr<T>()[c];
+    }
+    ForEachElemBlock(elem_cnt, [&](int64_t begin, int64_t end) {
+      ChannelGradAffine(view, begin, end, x->dptr<T>(), bn_dy_ptr, dy_coeff, x_coeff, bias,
+                        dx->mut_dptr<T>());
+    });
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BN_GRAD_CPU_KERNEL(dtype)                                             \
+  REGISTER_USER_KERNEL("normalization_grad")                                           \
+      .SetCreateFn<NormalizationGradCpuKernel<dtype>>()                                \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                              \
+        return InferChannelParamsTmpSize(ctx, 3);                                      \
+      });
+
+REGISTER_BN_GRAD_CPU_KERNEL(float)
+REGISTER_BN_GRAD_CPU_KERNEL(double)
+
+#undef REGISTER_BN_GRAD_CPU_KERNEL
+
+#define REGISTER_BN_ADD_RELU_GRAD_CPU_KERNEL(dtype)                                    \
+  REGISTER_USER_KERNEL("normalization_add_relu_grad")                                  \
+      .SetCreateFn<NormalizationGradCpuKernel<dtype>>()                                \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                              \
+        size_t tmp_size = InferChannelParamsTmpSize(ctx, 3);                           \
+        if (!ctx->has_output("addend_diff", 0)) {                                      \
+          const auto* dy = ctx->TensorDesc4ArgNameAndIndex("dy", 0);                   \
+          tmp_size += GetCudaAlignedSize(dy->shape().elem_cnt() * sizeof(dtype));      \
+        }                                                                              \
+        return tmp_size;                                                               \
+      });
+
+REGISTER_BN_ADD_RELU_GRAD_CPU_KERNEL(float)
+REGISTER_BN_ADD_RELU_GRAD_CPU_KERNEL(double)
+
+#undef REGISTER_BN_ADD_RELU_GRAD_CPU_KERNEL
+
+}  // namespace oneflow
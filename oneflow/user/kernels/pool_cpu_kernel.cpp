@@ -16,7 +16,7 @@ limitations under the License.
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/user/kernels/op_kernel_state_wrapper.h"
 #include "oneflow/user/utils/pool_util.h"
-#include "oneflow/core/common/eigen_util.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
@@ -33,314 +33,377 @@ struct PoolOpKernelState final : public user_op::OpKernelState {
   }
 };
 
-template<typename T>
-struct PoolCpuKernelUtil {
- public:
-  typedef std::function<T()> ForwardInitialize;
-  typedef std::function<void(const T& lhs, T& rhs)> CFirstProcess;
-  typedef std::function<void(const int64_t in_col, const int64_t out_col,
-                             ConstEigenMatrixMap<T>& in_mat, EigenMatrixMap<T>& out_mat)>
-      CLastProcess;
-  typedef std::function<void(const int64_t size, T& out)> CFirstFinalize;
-  typedef std::function<void(const int64_t size, const int64_t col, EigenMatrixMap<T>& out_mat)>
-      CLastFinalize;
-  typedef std::function<void(const T& in, const T& out, const T& out_diff, const int64_t size,
-                             T& in_diff)>
-      CFirstProcessGrad;
-  typedef std::function<void(const int64_t out_col, const int64_t in_col, const int64_t size,
-                             ConstEigenArrayMap<T>& out_arr, ConstEigenArrayMap<T>& in_arr,
-                             ConstEigenArrayMap<T>& out_diff_arr, EigenArrayMap<T>& in_diff_arr)>
-      CLastProcessGrad;
-
-  static void CFirstForward(const Params3D& params_3d, const user_op::Tensor* in_blob,
-                            user_op::Tensor* out_blob, const ForwardInitialize& initialize,
-                            const CFirstProcess& process, const CFirstFinalize& finalize) {
-    const Shape& in = params_3d.GetXShape5D();
-    const Shape& out = params_3d.GetYShape5D();
-    const std::vector<int32_t>& pool_size = params_3d.pool_size_3d();
-    const std::vector<int32_t>& strides = params_3d.strides_3d();
-    const std::vector<int32_t>& padding_before = params_3d.padding_before_3d();
-
-    const T* input = in_blob->dptr<T>();
-    T* output = out_blob->mut_dptr<T>();
-    FOR_RANGE(int64_t, n, 0, in.At(0)) {
-      FOR_RANGE(int64_t, c, 0, in.At(1)) {
-        FOR_RANGE(int64_t, pd, 0, out.At(2)) {
-          int64_t dstart = pd * strides.at(0) - padding_before.at(0);
-          int64_t dend = std::min(dstart + pool_size.at(0), in.At(2));
-          dstart = std::max(dstart, static_cast<int64_t>(0));
-          FOR_RANGE(int64_t, ph, 0, out.At(3)) {
-            int64_t hstart = ph * strides.at(1) - padding_before.at(1);
-            int64_t hend = std::min(hstart + pool_size.at(1), in.At(3));
-            hstart = std::max(hstart, static_cast<int64_t>(0));
-            FOR_RANGE(int64_t, pw, 0, out.At(4)) {
-              int64_t wstart = pw * strides.at(2) - padding_before.at(2);
-              int64_t wend = std::min(wstart + pool_size.at(2), in.At(4));
-              wstart = std::max(wstart, static_cast<int64_t>(0));
-
-              const int64_t pool_index = pd * out.Count(3) + ph * out.At(4) + pw;
-              T res = initialize();
-              FOR_RANGE(int64_t, d, dstart, dend) {
-                FOR_RANGE(int64_t, h, hstart, hend) {
-                  FOR_RANGE(int64_t, w, wstart, wend) {
-                    const int64_t input_index = d * in.Count(3) + h * in.At(4) + w;
-                    process(input[input_index], res);
-                  }
-                }
-              }
-              finalize((dend - dstart) * (hend - hstart) * (wend - wstart), res);
-              output[pool_index] = res;
-            }
+// The channels of a plane of channels_last x are scattered to by the backward in blocks of this
+// many channels, so that the images of a small batch are still split among the threads.
+constexpr int64_t kPoolChannelBlockSize = 64;
+
+// The sizes of the pooling with the spatial dims padded to 3d, x and y are (n, c, d, h, w) or
+// (n, d, h, w, c). A plane is an image and channel of channels_first x, or an image of
+// channels_last x, the spatial positions of which hold all its channels.
+struct CpuPoolShape final {
+  explicit CpuPoolShape(const Params3D& params_3d) {
+    const Shape x_shape = params_3d.GetXShape5D();
+    const Shape y_shape = params_3d.GetYShape5D();
+    num_batches = x_shape.At(0);
+    num_channels = x_shape.At(1);
+    FOR_RANGE(int32_t, i, 0, 3) {
+      x_dims[i] = x_shape.At(2 + i);
+      y_dims[i] = y_shape.At(2 + i);
+      pool_size[i] = params_3d.pool_size_3d().at(i);
+      strides[i] = params_3d.strides_3d().at(i);
+      padding_before[i] = params_3d.padding_before_3d().at(i);
+    }
+    x_spatial_size = x_shape.Count(2);
+    y_spatial_size = y_shape.Count(2);
+  }
+
+  // [*start, *end) is the window of the output index out_index of the spatial dim i, clipped to x.
+  void GetWindow(int32_t i, int64_t out_index, int64_t* start, int64_t* end) const {
+    const int64_t begin = out_index * strides[i] - padding_before[i];
+    *start = std::max<int64_t>(begin, 0);
+    *end = std::min(begin + pool_size[i], x_dims[i]);
+  }
+  int64_t PoolVolume() const { return pool_size[0] * pool_size[1] * pool_size[2]; }
+
+  int64_t num_batches;
+  int64_t num_channels;
+  int64_t x_dims[3];
+  int64_t y_dims[3];
+  int64_t pool_size[3];
+  int64_t strides[3];
+  int64_t padding_before[3];
+  int64_t x_spatial_size;
+  int64_t y_spatial_size;
+};
+
+struct CpuPoolWindow final {
+  int64_t start[3];
+  int64_t end[3];
+
+  int64_t Size() const {
+    int64_t size = 1;
+    FOR_RANGE(int32_t, i, 0, 3) { size *= std::max<int64_t>(end[i] - start[i], 0); }
+    return size;
+  }
+};
+
+// Pools the window of the plane x into y. channels_last pools num_channels channels, which are
+// contiguous, at once, channels_first has a single one, which is kept in registers. The argmax is
+// the first position of the max as the offset into the spatial dims. The comparisons are kept free
+// of branches, which the random order of the values would mispredict, so a NaN is only the max
+// when it is the first of its window.
+template<typename T, bool channels_last, bool with_indice>
+void MaxPoolWindow(const CpuPoolShape& shape, const CpuPoolWindow& window, const T* x,
+                   const int64_t num_channels, T* y, int32_t* indice) {
+  const int64_t n = channels_last ? num_channels : 1;
+  const int64_t pos_stride = channels_last ? shape.num_channels : 1;
+  const int64_t height = shape.x_dims[1];
+  const int64_t width = shape.x_dims[2];
+  if (window.Size() == 0) {
+    std::fill_n(y, n, GetMinVal<T>());
+    if (with_indice) { std::fill_n(indice, n, -1); }
+    return;
+  }
+  const int64_t first = (window.start[0] * height + window.start[1]) * width + window.start[2];
+  if (!channels_last) {
+    T window_max = x[first];
+    int32_t argmax = static_cast<int32_t>(first);
+    FOR_RANGE(int64_t, d, window.start[0], window.end[0]) {
+      FOR_RANGE(int64_t, h, window.start[1], window.end[1]) {
+        const int64_t row = (d * height + h) * width;
+        FOR_RANGE(int64_t, w, window.start[2], window.end[2]) {
+          const T value = x[row + w];
+          const bool is_max = value > window_max;
+          window_max = is_max ? value : window_max;
+          if (with_indice) {
+            const int32_t mask = -static_cast<int32_t>(is_max);
+            argmax = (static_cast<int32_t>(row + w) & mask) | (argmax & ~mask);
           }
         }
-        input += in.Count(2);
-        output += out.Count(2);
       }
     }
+    *y = window_max;
+    if (with_indice) { *indice = argmax; }
+    return;
   }
-
-  static void CFirstBackward(const Params3D& params_3d, const user_op::Tensor* out_diff_blob,
-                             const user_op::Tensor* out_blob, const user_op::Tensor* in_blob,
-                             user_op::Tensor* in_diff_blob, const CFirstProcessGrad& process) {
-    const Shape& in = params_3d.GetXShape5D();
-    const Shape& out = params_3d.GetYShape5D();
-    const std::vector<int32_t>& pool_size = params_3d.pool_size_3d();
-    const std::vector<int32_t>& strides = params_3d.strides_3d();
-    const std::vector<int32_t>& padding_before = params_3d.padding_before_3d();
-
-    const T* output_diff = out_diff_blob->dptr<T>();
-    const T* output = out_blob->dptr<T>();
-    const T* input = in_blob->dptr<T>();
-    std::memset(in_diff_blob->mut_dptr<T>(), T(0), in.elem_cnt() * sizeof(T));
-    T* input_diff = in_diff_blob->mut_dptr<T>();
-    FOR_RANGE(int64_t, n, 0, in.At(0)) {
-      FOR_RANGE(int64_t, c, 0, in.At(1)) {
-        FOR_RANGE(int64_t, pd, 0, out.At(2)) {
-          int64_t dstart = pd * strides.at(0) - padding_before.at(0);
-          int64_t dend = std::min(dstart + pool_size.at(0), in.At(2));
-          dstart = std::max(dstart, static_cast<int64_t>(0));
-          FOR_RANGE(int64_t, ph, 0, out.At(3)) {
-            int64_t hstart = ph * strides.at(1) - padding_before.at(1);
-            int64_t hend = std::min(hstart + pool_size.at(1), in.At(3));
-            hstart = std::max(hstart, static_cast<int64_t>(0));
-            FOR_RANGE(int64_t, pw, 0, out.At(4)) {
-              int64_t wstart = pw * strides.at(2) - padding_before.at(2);
-              int64_t wend = std::min(wstart + pool_size.at(2), in.At(4));
-              wstart = std::max(wstart, static_cast<int64_t>(0));
-
-              const int64_t size = (dend - dstart) * (hend - hstart) * (wend - wstart);
-              const int64_t pool_index = pd * out.Count(3) + ph * out.At(4) + pw;
-              FOR_RANGE(int64_t, d, dstart, dend) {
-                FOR_RANGE(int64_t, h, hstart, hend) {
-                  FOR_RANGE(int64_t, w, wstart, wend) {
-                    const int64_t index = d * in.Count(3) + h * in.At(4) + w;
-                    process(input[index], output[pool_index], output_diff[pool_index], size,
-                            input_diff[index]);
-                  }
-                }
-              }
-            }
+  std::copy_n(x + first * pos_stride, n, y);
+  if (with_indice) { std::fill_n(indice, n, static_cast<int32_t>(first)); }
+  FOR_RANGE(int64_t, d, window.start[0], window.end[0]) {
+    FOR_RANGE(int64_t, h, window.start[1], window.end[1]) {
+      const int64_t row = (d * height + h) * width;
+      FOR_RANGE(int64_t, w, window.start[2], window.end[2]) {
+        const T* x_pos = x + (row + w) * pos_stride;
+        const int32_t pos = static_cast<int32_t>(row + w);
+        for (int64_t c = 0; c < n; ++c) {
+          const T value = x_pos[c];
+          const T window_max = y[c];
+          y[c] = value > window_max ? value : window_max;
+          if (with_indice) {
+            const int32_t mask = -static_cast<int32_t>(value > window_max);
+            indice[c] = (pos & mask) | (indice[c] & ~mask);
           }
         }
-        // offset
-        input += in.Count(2);
-        input_diff += in.Count(2);
-        output += out.Count(2);
-        output_diff += out.Count(2);
       }
     }
   }
+}
 
-  static void CLastForward(const Params3D& params_3d, const user_op::Tensor* in_blob,
-                           user_op::Tensor* out_blob, const ForwardInitialize& forward_initialize,
-                           const CLastProcess& process, const CLastFinalize& finalize) {
-    const Shape& in = params_3d.GetXShape5D();
-    const Shape& out = params_3d.GetYShape5D();
-    const std::vector<int32_t>& pool_size = params_3d.pool_size_3d();
-    const std::vector<int32_t>& strides = params_3d.strides_3d();
-    const std::vector<int32_t>& padding_before = params_3d.padding_before_3d();
-
-    ConstEigenMatrixMap<T> in_mat(in_blob->dptr<T>(), in.At(1), in.elem_cnt() / in.At(1));
-    EigenMatrixMap<T> out_mat(out_blob->mut_dptr<T>(), out.At(1), out.elem_cnt() / out.At(1));
-    FOR_RANGE(int64_t, n, 0, in.At(0)) {
-      FOR_RANGE(int64_t, pd, 0, out.At(2)) {
-        int64_t dstart = pd * strides.at(0) - padding_before.at(0);
-        int64_t dend = std::min(dstart + pool_size.at(0), in.At(2));
-        dstart = std::max(dstart, static_cast<int64_t>(0));
-        FOR_RANGE(int64_t, ph, 0, out.At(3)) {
-          int64_t hstart = ph * strides.at(1) - padding_before.at(1);
-          int64_t hend = std::min(hstart + pool_size.at(1), in.At(3));
-          hstart = std::max(hstart, static_cast<int64_t>(0));
-          FOR_RANGE(int64_t, pw, 0, out.At(4)) {
-            int64_t wstart = pw * strides.at(2) - padding_before.at(2);
-            int64_t wend = std::min(wstart + pool_size.at(2), in.At(4));
-            wstart = std::max(wstart, static_cast<int64_t>(0));
-            const int out_col = ((n * out.At(2) + pd) * out.At(3) + ph) * out.At(4) + pw;
-            out_mat.col(out_col).setConstant(forward_initialize());
-            FOR_RANGE(int64_t, d, dstart, dend) {
-              FOR_RANGE(int64_t, h, hstart, hend) {
-                FOR_RANGE(int64_t, w, wstart, wend) {
-                  const int in_col = ((n * in.At(2) + d) * in.At(3) + h) * in.At(4) + w;
-                  process(in_col, out_col, in_mat, out_mat);
-                }
-              }
-            }
-            finalize((hend - hstart) * (wend - wstart) * (dend - dstart), out_col, out_mat);
-          }
-        }
+template<typename T, bool channels_last>
+void AvgPoolWindow(const CpuPoolShape& shape, const CpuPoolWindow& window, const T* x,
+                   const int64_t num_channels, T* y) {
+  const int64_t n = channels_last ? num_channels : 1;
+  const int64_t pos_stride = channels_last ? shape.num_channels : 1;
+  const int64_t height = shape.x_dims[1];
+  const int64_t width = shape.x_dims[2];
+  std::fill_n(y, n, GetZeroVal<T>());
+  FOR_RANGE(int64_t, d, window.start[0], window.end[0]) {
+    FOR_RANGE(int64_t, h, window.start[1], window.end[1]) {
+      const int64_t row = (d * height + h) * width;
+      FOR_RANGE(int64_t, w, window.start[2], window.end[2]) {
+        const T* x_pos = x + (row + w) * pos_stride;
+        for (int64_t c = 0; c < n; ++c) { y[c] += x_pos[c]; }
       }
     }
   }
+  const int64_t size = window.Size();
+  if (size > 0) {
+    for (int64_t c = 0; c < n; ++c) { y[c] /= static_cast<T>(size); }
+  }
+}
 
-  static void CLastBackward(const Params3D& params_3d, const user_op::Tensor* out_diff_blob,
-                            const user_op::Tensor* out_blob, const user_op::Tensor* in_blob,
-                            user_op::Tensor* in_diff_blob, const CLastProcessGrad& process) {
-    const Shape& in = params_3d.GetXShape5D();
-    const Shape& out = params_3d.GetYShape5D();
-    const std::vector<int32_t>& pool_size = params_3d.pool_size_3d();
-    const std::vector<int32_t>& strides = params_3d.strides_3d();
-    const std::vector<int32_t>& padding_before = params_3d.padding_before_3d();
-
-    // caffe2 implementation: need check
-    ConstEigenArrayMap<T> out_mat(out_blob->dptr<T>(), out.At(1), out.elem_cnt() / out.At(1));
-    ConstEigenArrayMap<T> in_mat(in_blob->dptr<T>(), in.At(1), in.elem_cnt() / in.At(1));
-    ConstEigenArrayMap<T> out_diff_mat(out_diff_blob->dptr<T>(), out.At(1),
-                                       out.elem_cnt() / out.At(1));
-    std::memset(in_diff_blob->mut_dptr<T>(), T(0), in.elem_cnt() * sizeof(T));
-    EigenArrayMap<T> in_diff_mat(in_diff_blob->mut_dptr<T>(), in.At(1), in.elem_cnt() / in.At(1));
-    FOR_RANGE(int64_t, n, 0, in.At(0)) {
-      FOR_RANGE(int64_t, pd, 0, out.At(2)) {
-        int64_t dstart = pd * strides.at(0) - padding_before.at(0);
-        int64_t dend = std::min(dstart + pool_size.at(0), in.At(2));
-        dstart = std::max(dstart, static_cast<int64_t>(0));
-        FOR_RANGE(int64_t, ph, 0, out.At(3)) {
-          int64_t hstart = ph * strides.at(1) - padding_before.at(1);
-          int64_t hend = std::min(hstart + pool_size.at(1), in.At(3));
-          hstart = std::max(hstart, static_cast<int64_t>(0));
-          FOR_RANGE(int64_t, pw, 0, out.At(4)) {
-            int64_t wstart = pw * strides.at(2) - padding_before.at(2);
-            int64_t wend = std::min(wstart + pool_size.at(2), in.At(4));
-            wstart = std::max(wstart, static_cast<int64_t>(0));
-            const int64_t pool_index = ((n * out.At(2) + pd) * out.At(3) + ph) * out.At(4) + pw;
-            const int64_t size = (dend - dstart) * (hend - hstart) * (wend - wstart);
-            FOR_RANGE(int64_t, d, dstart, dend) {
-              FOR_RANGE(int64_t, h, hstart, hend) {
-                FOR_RANGE(int64_t, w, wstart, wend) {
-                  const int64_t input_index = ((n * in.At(2) + d) * in.At(3) + h) * in.At(4) + w;
-                  process(pool_index, input_index, size, out_mat, in_mat, out_diff_mat,
-                          in_diff_mat);
-                }
+// Calls Pool(window, x_offset, y_offset) for every output position, where x_offset is the offset
+// of its plane in x and y_offset its own offset in y. The rows of output positions, which share
+// the plane, depth and height, are split among the threads.
+template<bool channels_last, typename PoolFn>
+void ForEachPoolOutputInRows(const CpuPoolShape& shape, const PoolFn& Pool) {
+  const int64_t num_planes =
+      channels_last ? shape.num_batches : shape.num_batches * shape.num_channels;
+  const int64_t pos_stride = channels_last ? shape.num_channels : 1;
+  const int64_t num_rows_per_plane = shape.y_dims[0] * shape.y_dims[1];
+  const int64_t num_rows = num_planes * num_rows_per_plane;
+  const int64_t row_size = shape.y_dims[2] * pos_stride * shape.PoolVolume();
+  MultiThreadLoopInRanges(
+      num_rows, GetNumThreadRanges(num_rows, row_size),
+      [&](int64_t range_id, int64_t begin, int64_t end) {
+        CpuPoolWindow window;
+        FOR_RANGE(int64_t, row, begin, end) {
+          const int64_t plane = row / num_rows_per_plane;
+          const int64_t plane_row = row % num_rows_per_plane;
+          shape.GetWindow(0, plane_row / shape.y_dims[1], &window.start[0], &window.end[0]);
+          shape.GetWindow(1, plane_row % shape.y_dims[1], &window.start[1], &window.end[1]);
+          const int64_t x_offset = plane * shape.x_spatial_size * pos_stride;
+          const int64_t y_offset =
+              (plane * shape.y_spatial_size + plane_row * shape.y_dims[2]) * pos_stride;
+          FOR_RANGE(int64_t, ow, 0, shape.y_dims[2]) {
+            shape.GetWindow(2, ow, &window.start[2], &window.end[2]);
+            Pool(window, x_offset, y_offset + ow * pos_stride);
+          }
+        }
+      });
+}
+
+// Zeroes dx and calls Scatter(window, x_offset, y_offset, num_channels) for every output position
+// of every block of a plane, where x_offset is the offset of the block in dx and y_offset the
+// offset of the position and block in y. The windows overlap, so the blocks rather than the rows
+// are split among the threads, a block is a whole channels_first plane, or kPoolChannelBlockSize
+// channels of a channels_last one.
+template<typename T, bool channels_last, typename ScatterFn>
+void ForEachPoolOutputInBlocks(const CpuPoolShape& shape, T* dx, const ScatterFn& Scatter) {
+  const int64_t num_planes =
+      channels_last ? shape.num_batches : shape.num_batches * shape.num_channels;
+  const int64_t pos_stride = channels_last ? shape.num_channels : 1;
+  const int64_t num_blocks_per_plane =
+      channels_last ? (shape.num_channels + kPoolChannelBlockSize - 1) / kPoolChannelBlockSize
+                    : 1;
+  const int64_t num_blocks = num_planes * num_blocks_per_plane;
+  const int64_t block_size = shape.y_spatial_size * shape.PoolVolume()
+                             * std::min<int64_t>(pos_stride, kPoolChannelBlockSize);
+  MultiThreadLoopInRanges(
+      num_blocks, GetNumThreadRanges(num_blocks, block_size),
+      [&](int64_t range_id, int64_t begin, int64_t end) {
+        CpuPoolWindow window;
+        FOR_RANGE(int64_t, block, begin, end) {
+          const int64_t plane = block / num_blocks_per_plane;
+          const int64_t channel_begin = block % num_blocks_per_plane * kPoolChannelBlockSize;
+          const int64_t num_channels =
+              channels_last ? std::min(kPoolChannelBlockSize, shape.num_channels - channel_begin)
+                            : 1;
+          const int64_t x_offset = plane * shape.x_spatial_size * pos_stride + channel_begin;
+          const int64_t y_offset = plane * shape.y_spatial_size * pos_stride + channel_begin;
+          if (channels_last) {
+            FOR_RANGE(int64_t, pos, 0, shape.x_spatial_size) {
+              std::fill_n(dx + x_offset + pos * pos_stride, num_channels, GetZeroVal<T>());
+            }
+          } else {
+            std::fill_n(dx + x_offset, shape.x_spatial_size, GetZeroVal<T>());
+          }
+          int64_t y_pos = 0;
+          FOR_RANGE(int64_t, od, 0, shape.y_dims[0]) {
+            shape.GetWindow(0, od, &window.start[0], &window.end[0]);
+            FOR_RANGE(int64_t, oh, 0, shape.y_dims[1]) {
+              shape.GetWindow(1, oh, &window.start[1], &window.end[1]);
+              FOR_RANGE(int64_t, ow, 0, shape.y_dims[2]) {
+                shape.GetWindow(2, ow, &window.start[2], &window.end[2]);
+                Scatter(window, x_offset, y_offset + y_pos * pos_stride, num_channels);
+                y_pos += 1;
               }
             }
           }
         }
-      }
-    }
+      });
+}
+
+template<typename T, bool channels_last>
+void AvgPoolForward(const CpuPoolShape& shape, const T* x, T* y) {
+  ForEachPoolOutputInRows<channels_last>(
+      shape, [&](const CpuPoolWindow& window, int64_t x_offset, int64_t y_offset) {
+        AvgPoolWindow<T, channels_last>(shape, window, x + x_offset, shape.num_channels,
+                                        y + y_offset);
+      });
+}
+
+template<typename T, bool channels_last>
+void AvgPoolBackward(const CpuPoolShape& shape, const T* dy, T* dx) {
+  const int64_t pos_stride = channels_last ? shape.num_channels : 1;
+  const int64_t height = shape.x_dims[1];
+  const int64_t width = shape.x_dims[2];
+  ForEachPoolOutputInBlocks<T, channels_last>(
+      shape, dx,
+      [&](const CpuPoolWindow& window, int64_t x_offset, int64_t y_offset, int64_t num_channels) {
+        const int64_t size = window.Size();
+        if (size == 0) { return; }
+        T dy_avg[kPoolChannelBlockSize];
+        FOR_RANGE(int64_t, c, 0, num_channels) {
+          dy_avg[c] = dy[y_offset + c] / static_cast<T>(size);
+        }
+        FOR_RANGE(int64_t, d, window.start[0], window.end[0]) {
+          FOR_RANGE(int64_t, h, window.start[1], window.end[1]) {
+            const int64_t row = (d * height + h) * width;
+            FOR_RANGE(int64_t, w, window.start[2], window.end[2]) {
+              T* dx_pos = dx + x_offset + (row + w) * pos_stride;
+              for (int64_t c = 0; c < num_channels; ++c) { dx_pos[c] += dy_avg[c]; }
+            }
+          }
+        }
+      });
+}
+
+// indice is nullptr unless the op has the indice output.
+template<typename T, bool channels_last>
+void MaxPoolForward(const CpuPoolShape& shape, const T* x, T* y, int32_t* indice) {
+  if (indice == nullptr) {
+    ForEachPoolOutputInRows<channels_last>(
+        shape, [&](const CpuPoolWindow& window, int64_t x_offset, int64_t y_offset) {
+          MaxPoolWindow<T, channels_last, false>(shape, window, x + x_offset, shape.num_channels,
+                                                 y + y_offset, nullptr);
+        });
+  } else {
+    ForEachPoolOutputInRows<channels_last>(
+        shape, [&](const CpuPoolWindow& window, int64_t x_offset, int64_t y_offset) {
+          MaxPoolWindow<T, channels_last, true>(shape, window, x + x_offset, shape.num_channels,
+                                                y + y_offset, indice + y_offset);
+        });
   }
+}
+
+// The argmaxes are taken from indice, the argmaxes of the forward, unless it is nullptr, in which
+// case the windows of x are pooled again.
+template<typename T, bool channels_last>
+void MaxPoolBackward(const CpuPoolShape& shape, const T* x, const int32_t* indice, const T* dy,
+                     T* dx) {
+  const int64_t pos_stride = channels_last ? shape.num_channels : 1;
+  ForEachPoolOutputInBlocks<T, channels_last>(
+      shape, dx,
+      [&](const CpuPoolWindow& window, int64_t x_offset, int64_t y_offset, int64_t num_channels) {
+        T window_max[kPoolChannelBlockSize];
+        int32_t argmax[kPoolChannelBlockSize];
+        const int32_t* window_indice = argmax;
+        if (indice != nullptr) {
+          window_indice = indice + y_offset;
+        } else {
+          MaxPoolWindow<T, channels_last, true>(shape, window, x + x_offset, num_channels,
+                                                window_max, argmax);
+        }
+        FOR_RANGE(int64_t, c, 0, num_channels) {
+          if (window_indice[c] < 0) { continue; }
+          dx[x_offset + window_indice[c] * pos_stride + c] += dy[y_offset + c];
+        }
+      });
+}
+
+bool IsChannelsLast(user_op::KernelComputeContext* ctx) {
+  const std::string& data_format = ctx->Attr<std::string>("data_format");
+  if (data_format == "channels_last") { return true; }
+  CHECK_EQ(data_format, "channels_first");
+  return false;
+}
 
+template<typename T>
+struct PoolCpuKernelUtil {
+ public:
   static void AvgFWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
     const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
     user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
     auto* pool_state = dynamic_cast<PoolOpKernelState*>(state);
     CHECK(pool_state != nullptr);
     pool_state->Update(x->shape());
-    const std::string& data_format = ctx->Attr<std::string>("data_format");
-    if (data_format == "channels_first") {
-      CFirstForward(
-          pool_state->GetParams3D(), x, y, GetZeroVal<T>, [](const T& lhs, T& rhs) { rhs += lhs; },
-          [](const int64_t size, T& out) { out /= size; });
-    } else if (data_format == "channels_last") {
-      CLastForward(
-          pool_state->GetParams3D(), x, y, GetZeroVal<T>,
-          [](const int64_t in_col, const int64_t out_col, ConstEigenMatrixMap<T>& in_mat,
-             EigenMatrixMap<T>& out_mat) { out_mat.col(out_col) += in_mat.col(in_col); },
-          [](const int64_t size, const int64_t col, EigenMatrixMap<T>& out_mat) {
-            out_mat.col(col) /= size;
-          });
+    const CpuPoolShape shape(pool_state->GetParams3D());
+    if (IsChannelsLast(ctx)) {
+      AvgPoolForward<T, true>(shape, x->dptr<T>(), y->mut_dptr<T>());
     } else {
-      UNIMPLEMENTED();
+      AvgPoolForward<T, false>(shape, x->dptr<T>(), y->mut_dptr<T>());
     }
   }
 
   static void AvgBWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
     const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
     const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
-    const user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
     user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
     auto* pool_state = dynamic_cast<PoolOpKernelState*>(state);
     CHECK(pool_state != nullptr);
     pool_state->Update(x->shape());
-    const std::string& data_format = ctx->Attr<std::string>("data_format");
-    if (data_format == "channels_first") {
-      CFirstBackward(pool_state->GetParams3D(), dy, y, x, dx,
-                     [](const T& in, const T& out, const T& out_diff, const int64_t size,
-                        T& in_diff) { in_diff += (out_diff / static_cast<T>(size)); });
-    } else if (data_format == "channels_last") {
-      CLastBackward(pool_state->GetParams3D(), dy, y, x, dx,
-                    [](const int64_t out_col, const int64_t in_col, const int64_t size,
-                       ConstEigenArrayMap<T>& out_arr, ConstEigenArrayMap<T>& in_arr,
-                       ConstEigenArrayMap<T>& out_diff_arr, EigenArrayMap<T>& in_diff_arr) {
-                      in_diff_arr.col(in_col) += out_diff_arr.col(out_col) / static_cast<T>(size);
-                    });
+    const CpuPoolShape shape(pool_state->GetParams3D());
+    if (IsChannelsLast(ctx)) {
+      AvgPoolBackward<T, true>(shape, dy->dptr<T>(), dx->mut_dptr<T>());
     } else {
-      UNIMPLEMENTED();
+      AvgPoolBackward<T, false>(shape, dy->dptr<T>(), dx->mut_dptr<T>());
     }
   }
 
   static void MaxFWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
     const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
     user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    int32_t* indice = nullptr;
+    if (ctx->has_output("indice", 0)) {
+      indice = ctx->Tensor4ArgNameAndIndex("indice", 0)->mut_dptr<int32_t>();
+    }
     auto* pool_state = dynamic_cast<PoolOpKernelState*>(state);
     CHECK(pool_state != nullptr);
     pool_state->Update(x->shape());
-    const std::string& data_format = ctx->Attr<std::string>("data_format");
-    if (data_format == "channels_first") {
-      CFirstForward(
-          pool_state->GetParams3D(), x, y, GetMinVal<T>,
-          [](const T& lhs, T& rhs) {
-            if (lhs > rhs) { rhs = lhs; }
-          },
-          [](const int64_t size, T& out) {});
-    } else if (data_format == "channels_last") {
-      CLastForward(
-          pool_state->GetParams3D(), x, y, GetMinVal<T>,
-          [](const int64_t in_col, const int64_t out_col, ConstEigenMatrixMap<T>& in_mat,
-             EigenMatrixMap<T>& out_mat) {
-            out_mat.col(out_col) = out_mat.col(out_col).cwiseMax(in_mat.col(in_col));
-          },
-          [](const int64_t size, const int64_t col, EigenMatrixMap<T>& out_mat) {});
+    const CpuPoolShape shape(pool_state->GetParams3D());
+    if (IsChannelsLast(ctx)) {
+      MaxPoolForward<T, true>(shape, x->dptr<T>(), y->mut_dptr<T>(), indice);
     } else {
-      UNIMPLEMENTED();
+      MaxPoolForward<T, false>(shape, x->dptr<T>(), y->mut_dptr<T>(), indice);
     }
   }
 
   static void MaxBWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
     const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
     const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
-    const user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
     user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const int32_t* indice = nullptr;
+    if (ctx->has_input("indice", 0)) {
+      indice = ctx->Tensor4ArgNameAndIndex("indice", 0)->dptr<int32_t>();
+    }
     auto* pool_state = dynamic_cast<PoolOpKernelState*>(state);
     CHECK(pool_state != nullptr);
     pool_state->Update(x->shape());
-    const std::string& data_format = ctx->Attr<std::string>("data_format");
-    if (data_format == "channels_first") {
-      CFirstBackward(
-          pool_state->GetParams3D(), dy, y, x, dx,
-          [](const T& in, const T& out, const T& out_diff, const int64_t size, T& in_diff) {
-            if (in == out) { in_diff += out_diff; }
-          });
-    } else if (data_format == "channels_last") {
-      CLastBackward(
-          pool_state->GetParams3D(), dy, y, x, dx,
-          [](const int64_t out_col, const int64_t in_col, const int64_t size,
-             ConstEigenArrayMap<T>& out_arr, ConstEigenArrayMap<T>& in_arr,
-             ConstEigenArrayMap<T>& out_diff_arr, EigenArrayMap<T>& in_diff_arr) {
-            in_diff_arr.col(in_col) +=
-                out_diff_arr.col(out_col)
-                * (in_arr.col(in_col).cwiseEqual(out_arr.col(out_col)).template cast<T>());
-          });
+    const CpuPoolShape shape(pool_state->GetParams3D());
+    if (IsChannelsLast(ctx)) {
+      MaxPoolBackward<T, true>(shape, x->dptr<T>(), indice, dy->dptr<T>(), dx->mut_dptr<T>());
     } else {
-      UNIMPLEMENTED();
+      MaxPoolBackward<T, false>(shape, x->dptr<T>(), indice, dy->dptr<T>(), dx->mut_dptr<T>());
     }
   }
 };
@@ -580,7 +643,22 @@ class MaxPool3DGradCpuKernel final : public user_op::OpKernel {
   };
 };
 
+#define REGISTER_MAX_POOL_CPU_KERNEL(dtype)                                            \
+  REGISTER_USER_KERNEL("max_pool_1d")                                                  \
+      .SetCreateFn<MaxPool1DCpuKernel<dtype>>()                                        \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobDataType("x", 0) == GetDataType<dtype>::value)); \
+  REGISTER_USER_KERNEL("max_pool_2d")                                                  \
+      .SetCreateFn<MaxPool2DCpuKernel<dtype>>()                                        \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobDataType("x", 0) == GetDataType<dtype>::value)); \
+  REGISTER_USER_KERNEL("max_pool_3d")                                                  \
+      .SetCreateFn<MaxPool3DCpuKernel<dtype>>()                                        \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobDataType("x", 0) == GetDataType<dtype>::value));
+
 #define REGISTER_POOL_CPU_KERNEL(dtype)                                                \
+  REGISTER_MAX_POOL_CPU_KERNEL(dtype)                                                  \
   REGISTER_USER_KERNEL("avg_pool_1d")                                                  \
       .SetCreateFn<AvgPool1DCpuKernel<dtype>>()                                        \
       .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
@@ -605,26 +683,14 @@ class MaxPool3DGradCpuKernel final : public user_op::OpKernel {
       .SetCreateFn<AvgPool3DGradCpuKernel<dtype>>()                                    \
       .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
                        & (user_op::HobDataType("x", 0) == GetDataType<dtype>::value)); \
-  REGISTER_USER_KERNEL("max_pool_1d")                                                  \
-      .SetCreateFn<MaxPool1DCpuKernel<dtype>>()                                        \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
-                       & (user_op::HobDataType("x", 0) == GetDataType<dtype>::value)); \
   REGISTER_USER_KERNEL("max_pool_1d_grad")                                             \
       .SetCreateFn<MaxPool1DGradCpuKernel<dtype>>()                                    \
       .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
                        & (user_op::HobDataType("x", 0) == GetDataType<dtype>::value)); \
-  REGISTER_USER_KERNEL("max_pool_2d")                                                  \
-      .SetCreateFn<MaxPool2DCpuKernel<dtype>>()                                        \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
-                       & (user_op::HobDataType("x", 0) == GetDataType<dtype>::value)); \
   REGISTER_USER_KERNEL("max_pool_2d_grad")                                             \
       .SetCreateFn<MaxPool2DGradCpuKernel<dtype>>()                                    \
       .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
                        & (user_op::HobDataType("x", 0) == GetDataType<dtype>::value)); \
-  REGISTER_USER_KERNEL("max_pool_3d")                                                  \
-      .SetCreateFn<MaxPool3DCpuKernel<dtype>>()                                        \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
-                       & (user_op::HobDataType("x", 0) == GetDataType<dtype>::value)); \
   REGISTER_USER_KERNEL("max_pool_3d_grad")                                             \
       .SetCreateFn<MaxPool3DGradCpuKernel<dtype>>()                                    \
       .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
@@ -632,5 +698,9 @@ class MaxPool3DGradCpuKernel final : public user_op::OpKernel {
 
 REGISTER_POOL_CPU_KERNEL(float)
 REGISTER_POOL_CPU_KERNEL(double)
+REGISTER_MAX_POOL_CPU_KERNEL(int8_t)
+REGISTER_MAX_POOL_CPU_KERNEL(uint8_t)
+REGISTER_MAX_POOL_CPU_KERNEL(int32_t)
+REGISTER_MAX_POOL_CPU_KERNEL(int64_t)
 
 }  // namespace oneflow
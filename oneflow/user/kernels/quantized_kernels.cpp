@@ -0,0 +1,368 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cstring>
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/kernels/int8_gemm_util.h"
+#include "oneflow/user/ops/nn_util.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kBlockRows = 32;
+
+struct InputQuantization {
+  float scale;
+  int32_t zero_point;
+  int32_t quant_min;
+  int32_t quant_max;
+};
+
+// Activations are quantized to uint8, a symmetric int8 value q is stored as q + 128.
+InputQuantization GetInputQuantization(const std::string& quantization_scheme,
+                                       const user_op::Tensor* scale,
+                                       const user_op::Tensor* zero_point) {
+  InputQuantization quant;
+  quant.scale = *scale->dptr<float>();
+  if (quantization_scheme == "symmetric") {
+    quant.zero_point = 128;
+    quant.quant_min = 1;
+    quant.quant_max = 255;
+  } else {
+    quant.zero_point = static_cast<int32_t>(std::round(*zero_point->dptr<float>()));
+    quant.quant_min = 0;
+    quant.quant_max = 255;
+  }
+  return quant;
+}
+
+class QuantizedKernelState final : public user_op::OpKernelState {
+ public:
+  QuantizedKernelState() = default;
+  ~QuantizedKernelState() override = default;
+
+  uint8_t* MutInput(int64_t size) {
+    input_.resize(size);
+    return input_.data();
+  }
+  float* MutWeightRows(int64_t size) {
+    weight_rows_.resize(size);
+    return weight_rows_.data();
+  }
+
+  // The quantized weight is kept across the iterations and only quantized again when the float
+  // weight or its scales change, e.g. after the variables are loaded or assigned.
+  bool NeedQuantizeWeight(const float* weight, int64_t weight_cnt, const user_op::Tensor* scale,
+                          const user_op::Tensor* zero_point, const InputQuantization& in_quant,
+                          float alpha) {
+    const int64_t num_scales = scale->shape().elem_cnt();
+    std::vector<float> key(scale->dptr<float>(), scale->dptr<float>() + num_scales);
+    key.insert(key.end(), zero_point->dptr<float>(), zero_point->dptr<float>() + num_scales);
+    key.push_back(in_quant.scale);
+    key.push_back(static_cast<float>(in_quant.zero_point));
+    key.push_back(alpha);
+    const bool same_weight =
+        weight_cnt == static_cast<int64_t>(quantized_float_weight_.size())
+        && std::memcmp(weight, quantized_float_weight_.data(), weight_cnt * sizeof(float)) == 0;
+    if (!weight_.empty() && same_weight && key == weight_quant_key_) { return false; }
+    weight_quant_key_.swap(key);
+    quantized_float_weight_.assign(weight, weight + weight_cnt);
+    return true;
+  }
+
+  // Quantizes the (n, k) float rows of the weight to int8, an affine uint8 value q is stored as
+  // q - 128, and folds everything of the dequantization that only depends on the output channel.
+  void QuantizeWeight(const float* rows, int64_t n, int64_t k,
+                      const std::string& quantization_scheme, const user_op::Tensor* scale,
+                      const user_op::Tensor* zero_point, const InputQuantization& in_quant,
+                      float alpha) {
+    const bool per_channel = scale->shape().elem_cnt() > 1;
+    const float* scale_ptr = scale->dptr<float>();
+    const float* zero_point_ptr = zero_point->dptr<float>();
+    weight_.resize(n * k);
+    weight_zero_point_.resize(n);
+    multiplier_.resize(n);
+    offset_.resize(n);
+    std::vector<int32_t> row_sum(n);
+    FOR_RANGE(int64_t, j, 0, n) {
+      const int64_t c = per_channel ? j : 0;
+      if (quantization_scheme == "symmetric") {
+        int8_gemm::QuantizeToInt8(rows + j * k, k, scale_ptr[c], 0, -127, 127, 0,
+                                  weight_.data() + j * k);
+        weight_zero_point_[j] = 0;
+      } else {
+        const int32_t zp = static_cast<int32_t>(std::round(zero_point_ptr[c]));
+        int8_gemm::QuantizeToInt8(rows + j * k, k, scale_ptr[c], zp, 0, 255, 128,
+                                  weight_.data() + j * k);
+        weight_zero_point_[j] = zp - 128;
+      }
+      multiplier_[j] = in_quant.scale * scale_ptr[c] * alpha;
+    }
+    int8_gemm::RowSum(n, k, weight_.data(), row_sum.data());
+    FOR_RANGE(int64_t, j, 0, n) {
+      offset_[j] = static_cast<int32_t>(k) * in_quant.zero_point * weight_zero_point_[j]
+                   - in_quant.zero_point * row_sum[j];
+    }
+  }
+
+  const int8_t* weight() const { return weight_.data(); }
+
+  // (a - za) . (b - zb) = a . b - zb * sum(a) - za * sum(b) + k * za * zb
+  void Dequantize(int64_t rows, int64_t n, const int32_t* dot, const int32_t* a_row_sum,
+                  const float* bias, float* out, int64_t row_stride, int64_t col_stride) const {
+    FOR_RANGE(int64_t, i, 0, rows) {
+      const int32_t* dot_i = dot + i * n;
+      float* out_i = out + i * row_stride;
+      FOR_RANGE(int64_t, j, 0, n) {
+        const int32_t acc = dot_i[j] - weight_zero_point_[j] * a_row_sum[i] + offset_[j];
+        const float y = multiplier_[j] * static_cast<float>(acc);
+        out_i[j * col_stride] = bias == nullptr ? y : y + bias[j];
+      }
+    }
+  }
+
+ private:
+  std::vector<uint8_t> input_;
+  std::vector<float> weight_rows_;
+  std::vector<int8_t> weight_;
+  std::vector<int32_t> weight_zero_point_;
+  std::vector<float> multiplier_;
+  std::vector<int32_t> offset_;
+  std::vector<float> weight_quant_key_;
+  std::vector<float> quantized_float_weight_;
+};
+
+// Gathers the rows [p_begin, p_end) of the (out_h * out_w, k) patch matrix of a quantized sample,
+// the padding is filled with the zero point so that it dequantizes to zero.
+struct Im2RowParams {
+  bool channels_first;
+  int64_t channels;
+  int64_t in_h;
+  int64_t in_w;
+  int64_t out_w;
+  std::vector<int32_t> kernel_size;
+  std::vector<int32_t> strides;
+  std::vector<int32_t> padding_before;
+  std::vector<int32_t> dilation_rate;
+};
+
+void Im2Row(const Im2RowParams& params, const uint8_t* in, int64_t p_begin, int64_t p_end,
+            uint8_t pad, uint8_t* rows) {
+  const int64_t kernel_h = params.kernel_size.at(0);
+  const int64_t kernel_w = params.kernel_size.at(1);
+  const int64_t k = params.channels * kernel_h * kernel_w;
+  FOR_RANGE(int64_t, p, p_begin, p_end) {
+    const int64_t y0 = (p / params.out_w) * params.strides.at(0) - params.padding_before.at(0);
+    const int64_t x0 = (p % params.out_w) * params.strides.at(1) - params.padding_before.at(1);
+    uint8_t* row = rows + (p - p_begin) * k;
+    if (params.channels_first) {
+      FOR_RANGE(int64_t, c, 0, params.channels) {
+        const uint8_t* plane = in + c * params.in_h * params.in_w;
+        FOR_RANGE(int64_t, ky, 0, kernel_h) {
+          const int64_t y = y0 + ky * params.dilation_rate.at(0);
+          FOR_RANGE(int64_t, kx, 0, kernel_w) {
+            const int64_t x = x0 + kx * params.dilation_rate.at(1);
+            const bool inside = y >= 0 && y < params.in_h && x >= 0 && x < params.in_w;
+            *row++ = inside ? plane[y * params.in_w + x] : pad;
+          }
+        }
+      }
+    } else {
+      FOR_RANGE(int64_t, ky, 0, kernel_h) {
+        const int64_t y = y0 + ky * params.dilation_rate.at(0);
+        FOR_RANGE(int64_t, kx, 0, kernel_w) {
+          const int64_t x = x0 + kx * params.dilation_rate.at(1);
+          if (y >= 0 && y < params.in_h && x >= 0 && x < params.in_w) {
+            std::memcpy(row, in + (y * params.in_w + x) * params.channels, params.channels);
+          } else {
+            std::memset(row, pad, params.channels);
+          }
+          row += params.channels;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+class QuantizedConv2dCpuKernel final : public user_op::OpKernel {
+ public:
+  QuantizedConv2dCpuKernel() = default;
+  ~QuantizedConv2dCpuKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<QuantizedKernelState>();
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    auto* quantized_state = dynamic_cast<QuantizedKernelState*>(state);
+    CHECK_NOTNULL(quantized_state);
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const std::string& quantization_scheme = ctx->Attr<std::string>("quantization_scheme");
+    const std::string& data_format = ctx->Attr<std::string>("data_format");
+
+    Im2RowParams params;
+    params.channels_first = data_format == "channels_first";
+    const size_t idx_offset = IdxOffset(data_format);
+    params.channels = in->shape().At(params.channels_first ? 1 : 3);
+    params.in_h = in->shape().At(idx_offset);
+    params.in_w = in->shape().At(idx_offset + 1);
+    params.out_w = out->shape().At(idx_offset + 1);
+    params.kernel_size = ctx->Attr<std::vector<int32_t>>("kernel_size");
+    params.strides = ctx->Attr<std::vector<int32_t>>("strides");
+    params.padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
+    params.dilation_rate = ctx->Attr<std::vector<int32_t>>("dilation_rate");
+    const int64_t batch = in->shape().At(0);
+    const int64_t filters = weight->shape().At(0);
+    const int64_t k = weight->shape().Count(1);
+    const int64_t in_size = in->shape().Count(1);
+    const int64_t num_rows = out->shape().At(idx_offset) * params.out_w;
+
+    const InputQuantization in_quant =
+        GetInputQuantization(quantization_scheme, ctx->Tensor4ArgNameAndIndex("in_scale", 0),
+                             ctx->Tensor4ArgNameAndIndex("in_zero_point", 0));
+    const user_op::Tensor* weight_scale = ctx->Tensor4ArgNameAndIndex("weight_scale", 0);
+    const user_op::Tensor* weight_zero_point = ctx->Tensor4ArgNameAndIndex("weight_zero_point", 0);
+    if (quantized_state->NeedQuantizeWeight(weight->dptr<float>(), filters * k, weight_scale,
+                                            weight_zero_point, in_quant, 1.0f)) {
+      quantized_state->QuantizeWeight(weight->dptr<float>(), filters, k, quantization_scheme,
+                                      weight_scale, weight_zero_point, in_quant, 1.0f);
+    }
+    uint8_t* quantized_in = quantized_state->MutInput(batch * in_size);
+    int8_gemm::QuantizeToUint8(in->dptr<float>(), batch * in_size, in_quant.scale,
+                               in_quant.zero_point, in_quant.quant_min, in_quant.quant_max,
+                               quantized_in);
+
+    // The blocks don't cross the samples so that the output of a block is strided the same way.
+    const int64_t blocks_per_sample = RoundUp(num_rows, kBlockRows) / kBlockRows;
+    const float* bias_ptr = bias == nullptr ? nullptr : bias->dptr<float>();
+    float* out_ptr = out->mut_dptr<float>();
+    MultiThreadLoop(batch * blocks_per_sample, [&](size_t block) {
+      const int64_t sample = block / blocks_per_sample;
+      const int64_t p_begin = (block % blocks_per_sample) * kBlockRows;
+      const int64_t rows = std::min(kBlockRows, num_rows - p_begin);
+      std::vector<uint8_t> patches(rows * k);
+      std::vector<int32_t> patch_sum(rows);
+      std::vector<int32_t> dot(rows * filters);
+      Im2Row(params, quantized_in + sample * in_size, p_begin, p_begin + rows,
+             static_cast<uint8_t>(in_quant.zero_point), patches.data());
+      int8_gemm::RowSum(rows, k, patches.data(), patch_sum.data());
+      int8_gemm::Gemm(0, rows, filters, k, patches.data(), quantized_state->weight(), dot.data());
+      float* sample_out = out_ptr + sample * filters * num_rows;
+      if (params.channels_first) {
+        quantized_state->Dequantize(rows, filters, dot.data(), patch_sum.data(), bias_ptr,
+                                    sample_out + p_begin, 1, num_rows);
+      } else {
+        quantized_state->Dequantize(rows, filters, dot.data(), patch_sum.data(), bias_ptr,
+                                    sample_out + p_begin * filters, filters, 1);
+      }
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("quantized_conv2d")
+    .SetCreateFn<QuantizedConv2dCpuKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")
+                     & (user_op::HobDataType("in", 0) == DataType::kFloat));
+
+class QuantizedMatmulCpuKernel final : public user_op::OpKernel {
+ public:
+  QuantizedMatmulCpuKernel() = default;
+  ~QuantizedMatmulCpuKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<QuantizedKernelState>();
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    auto* quantized_state = dynamic_cast<QuantizedKernelState*>(state);
+    CHECK_NOTNULL(quantized_state);
+    const user_op::Tensor* a = ctx->Tensor4ArgNameAndIndex("a", 0);
+    const user_op::Tensor* b = ctx->Tensor4ArgNameAndIndex("b", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const std::string& quantization_scheme = ctx->Attr<std::string>("quantization_scheme");
+    const bool transpose_a = ctx->Attr<bool>("transpose_a");
+    const bool transpose_b = ctx->Attr<bool>("transpose_b");
+    const int64_t m = out->shape().At(0);
+    const int64_t n = out->shape().At(1);
+    const int64_t k = transpose_a ? a->shape().At(0) : a->shape().At(1);
+
+    const InputQuantization in_quant =
+        GetInputQuantization(quantization_scheme, ctx->Tensor4ArgNameAndIndex("in_scale", 0),
+                             ctx->Tensor4ArgNameAndIndex("in_zero_point", 0));
+    const user_op::Tensor* weight_scale = ctx->Tensor4ArgNameAndIndex("weight_scale", 0);
+    const user_op::Tensor* weight_zero_point = ctx->Tensor4ArgNameAndIndex("weight_zero_point", 0);
+    const float alpha = static_cast<float>(ctx->Attr<double>("alpha"));
+    if (quantized_state->NeedQuantizeWeight(b->dptr<float>(), n * k, weight_scale,
+                                            weight_zero_point, in_quant, alpha)) {
+      const float* b_rows = b->dptr<float>();
+      if (!transpose_b) {
+        float* transposed = quantized_state->MutWeightRows(n * k);
+        FOR_RANGE(int64_t, p, 0, k) {
+          FOR_RANGE(int64_t, j, 0, n) { transposed[j * k + p] = b_rows[p * n + j]; }
+        }
+        b_rows = transposed;
+      }
+      quantized_state->QuantizeWeight(b_rows, n, k, quantization_scheme, weight_scale,
+                                      weight_zero_point, in_quant, alpha);
+    }
+    uint8_t* quantized_a = quantized_state->MutInput(2 * m * k);
+    if (transpose_a) {
+      uint8_t* quantized_a_t = quantized_a + m * k;
+      int8_gemm::QuantizeToUint8(a->dptr<float>(), m * k, in_quant.scale, in_quant.zero_point,
+                                 in_quant.quant_min, in_quant.quant_max, quantized_a_t);
+      FOR_RANGE(int64_t, p, 0, k) {
+        FOR_RANGE(int64_t, i, 0, m) { quantized_a[i * k + p] = quantized_a_t[p * m + i]; }
+      }
+    } else {
+      int8_gemm::QuantizeToUint8(a->dptr<float>(), m * k, in_quant.scale, in_quant.zero_point,
+                                 in_quant.quant_min, in_quant.quant_max, quantized_a);
+    }
+
+    const float* bias_ptr = bias == nullptr ? nullptr : bias->dptr<float>();
+    float* out_ptr = out->mut_dptr<float>();
+    MultiThreadLoop(RoundUp(m, kBlockRows) / kBlockRows, [&](size_t block) {
+      const int64_t row_begin = block * kBlockRows;
+      const int64_t rows = std::min(kBlockRows, m - row_begin);
+      const uint8_t* block_a = quantized_a + row_begin * k;
+      std::vector<int32_t> a_row_sum(rows);
+      std::vector<int32_t> dot(rows * n);
+      int8_gemm::RowSum(rows, k, block_a, a_row_sum.data());
+      int8_gemm::Gemm(0, rows, n, k, block_a, quantized_state->weight(), dot.data());
+      quantized_state->Dequantize(rows, n, dot.data(), a_row_sum.data(), bias_ptr,
+                                  out_ptr + row_begin * n, n, 1);
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("quantized_matmul")
+    .SetCreateFn<QuantizedMatmulCpuKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")
+                     & (user_op::HobDataType("a", 0) == DataType::kFloat));
+
+}  // namespace oneflow
@@ -16,6 +16,7 @@ limitations under the License.
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/ndarray/ndarray_util.h"
 #include "oneflow/core/ndarray/xpu_var_ndarray.h"
+#include "oneflow/core/kernel/util/host_bfloat16_util.h"
 
 namespace oneflow {
 
@@ -73,6 +74,47 @@ REGISTER_REDUCE_ARITHMETIC_KERNELS_BY_DEVICE(DeviceType::kCPU)
 REGISTER_REDUCE_ARITHMETIC_KERNELS_BY_DEVICE(DeviceType::kGPU)
 #endif
 
+// The bfloat16 input is widened to float, so that the sum is accumulated in float and rounded once.
+class ReduceSumCpuBFloat16Kernel final : public user_op::OpKernel {
+ public:
+  ReduceSumCpuBFloat16Kernel() = default;
+  ~ReduceSumCpuBFloat16Kernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* input_tensor = ctx->Tensor4ArgNameAndIndex("input_tensor", 0);
+    user_op::Tensor* output_tensor = ctx->Tensor4ArgNameAndIndex("output_tensor", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const auto& axis = ctx->Attr<std::vector<int32_t>>("axis");
+    const ShapeView& in_shape = input_tensor->shape();
+    const Shape& reduced_shape = CreateReducedShape(in_shape, {axis.begin(), axis.end()});
+    float* in_tmp_buffer = tmp_buffer->mut_dptr<float>();
+    float* reduce_tmp_buffer = in_tmp_buffer + in_shape.elem_cnt();
+    float* out_tmp_buffer = reduce_tmp_buffer + in_shape.elem_cnt();
+    CHECK_LE((2 * in_shape.elem_cnt() + reduced_shape.elem_cnt()) * sizeof(float),
+             tmp_buffer->shape().elem_cnt());
+    host_bfloat16::BFloat16ToFloat(input_tensor->dptr<bfloat16>(), in_shape.elem_cnt(),
+                                   in_tmp_buffer);
+    NdarrayReduce<DeviceType::kCPU, float, BinaryFuncSum>::Reduce(
+        ctx->device_ctx(), XpuVarNdarray<float>(reduced_shape, out_tmp_buffer),
+        XpuVarNdarray<const float>(in_shape, in_tmp_buffer),
+        XpuVarNdarray<float>(in_shape, reduce_tmp_buffer));
+    host_bfloat16::FloatToBFloat16(out_tmp_buffer, output_tensor->shape().elem_cnt(),
+                                   output_tensor->mut_dptr<bfloat16>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("reduce_sum")
+    .SetCreateFn<ReduceSumCpuBFloat16Kernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")
+                     & (user_op::HobDataType("output_tensor", 0) == GetDataType<bfloat16>::value))
+    .SetInferTmpSizeFn([](user_op::InferContext* ctx) {
+      const Shape& in_shape = ctx->TensorDesc4ArgNameAndIndex("input_tensor", 0)->shape();
+      const Shape& out_shape = ctx->TensorDesc4ArgNameAndIndex("output_tensor", 0)->shape();
+      return (2 * in_shape.elem_cnt() + out_shape.elem_cnt()) * sizeof(float);
+    });
+
 #define REGISTER_REDUCE_LOGICAL_KERNELS(device)                           \
   REGISTER_REDUCE_XPU_KERNEL("reduce_any", BinaryFuncAny, device, int8_t) \
   REGISTER_REDUCE_XPU_KERNEL("reduce_all", BinaryFuncAll, device, int8_t)
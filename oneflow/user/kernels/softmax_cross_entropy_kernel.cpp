@@ -14,39 +14,99 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/user/kernels/softmax_cross_entropy_kernel.h"
-#include "oneflow/core/kernel/kernel_util.cuh"
+#include "oneflow/user/kernels/cpu_softmax_util.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 namespace user_op {
 
+namespace {
+
+// Writes the softmax of a row to prob and returns -Sum_j(label[j] * log(max(prob[j], 1e-20))),
+// taking log(prob[j]) as the log-softmax x[j] - max - log(sum) instead of a log per element.
 template<typename T>
-struct CrossEntropyKernelUtil<DeviceType::kCPU, T> {
-  static void ComputeEntropy(DeviceCtx* ctx, const int64_t num_instances, const int64_t num_classes,
-                             const T* x, const T* labels, T* y) {
-    FOR_RANGE(int64_t, i, 0, num_instances) {
-      T tmp = 0;
-      FOR_RANGE(int64_t, j, 0, num_classes) {
-        T label = labels[i * num_classes + j];
-        T prob = x[i * num_classes + j];
-        // tmp -= label * SafeLog(prob);
-        tmp -= label * logf((prob > 1e-20) ? prob : 1e-20);
-      }
-      y[i] = tmp;
+T ComputeSoftmaxCrossEntropyRow(const int64_t n, const T* x, const T* label, T* prob) {
+  const SoftmaxRowStat<T> stat = ComputeSoftmaxRow(n, x, prob);
+  const T log_normalizer = stat.max + std::log(stat.sum);
+  const T min_log_prob = std::log(static_cast<T>(1e-20));
+  T lane_entropy[kNumSoftmaxLanes] = {0};
+  const int64_t num_steps = n / kNumSoftmaxLanes;
+  for (int64_t step = 0; step < num_steps; ++step) {
+    const int64_t i = step * kNumSoftmaxLanes;
+    for (int64_t l = 0; l < kNumSoftmaxLanes; ++l) {
+      const T log_prob = std::max(x[i + l] - log_normalizer, min_log_prob);
+      lane_entropy[l] -= label[i + l] * log_prob;
     }
   }
+  T entropy = 0;
+  for (int64_t l = 0; l < kNumSoftmaxLanes; ++l) { entropy += lane_entropy[l]; }
+  for (int64_t i = num_steps * kNumSoftmaxLanes; i < n; ++i) {
+    entropy -= label[i] * std::max(x[i] - log_normalizer, min_log_prob);
+  }
+  return entropy;
+}
+
+}  // namespace
+
+template<typename T>
+class SoftmaxCrossEntropyCpuKernel final : public user_op::OpKernel {
+ public:
+  SoftmaxCrossEntropyCpuKernel() = default;
+  ~SoftmaxCrossEntropyCpuKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* prediction = ctx->Tensor4ArgNameAndIndex("prediction", 0);
+    const user_op::Tensor* label = ctx->Tensor4ArgNameAndIndex("label", 0);
+    user_op::Tensor* prob = ctx->Tensor4ArgNameAndIndex("prob", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const auto num_axes = label->shape().NumAxes();
+    const int64_t num_instances = label->shape().Count(0, num_axes - 1);
+    const int64_t num_classes = label->shape().At(num_axes - 1);
+    if (num_classes == 0) { return; }
+    const T* prediction_ptr = prediction->dptr<T>();
+    const T* label_ptr = label->dptr<T>();
+    T* prob_ptr = prob->mut_dptr<T>();
+    T* out_ptr = out->mut_dptr<T>();
+    MultiThreadLoopInRanges(
+        num_instances, GetNumThreadRanges(num_instances, num_classes),
+        [&](int64_t range_id, int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, i, begin, end) {
+            const int64_t offset = i * num_classes;
+            out_ptr[i] = ComputeSoftmaxCrossEntropyRow(num_classes, prediction_ptr + offset,
+                                                       label_ptr + offset, prob_ptr + offset);
+          }
+        });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
 
+template<typename T>
+struct CrossEntropyKernelUtil<DeviceType::kCPU, T> {
   static void ComputeDiffWithSoftmax(DeviceCtx* ctx, const int64_t elem_cnt,
                                      const int64_t num_classes, const T* prob, const T* labels,
                                      const T* dy, T* dx) {
-    FOR_RANGE(int64_t, i, 0, elem_cnt) {
-      const int32_t row_id = i / num_classes;
-      dx[i] = dy[row_id] * (prob[i] - labels[i]);
-    }
+    const int64_t num_instances = elem_cnt / num_classes;
+    MultiThreadLoopInRanges(num_instances, GetNumThreadRanges(num_instances, num_classes),
+                            [&](int64_t range_id, int64_t begin, int64_t end) {
+                              FOR_RANGE(int64_t, i, begin, end) {
+                                const int64_t offset = i * num_classes;
+                                FOR_RANGE(int64_t, j, offset, offset + num_classes) {
+                                  dx[j] = dy[i] * (prob[j] - labels[j]);
+                                }
+                              }
+                            });
   }
 };
 
-OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(REGISTER_SOFTMAX_CROSS_ENTROPY_KERNEL,
-                                 OF_PP_MAKE_TUPLE_SEQ(DeviceType::kCPU), FLOATING_DATA_TYPE_SEQ)
+#define REGISTER_SOFTMAX_CROSS_ENTROPY_CPU_KERNEL(dtype_pair)                                 \
+  REGISTER_USER_KERNEL("softmax_cross_entropy")                                               \
+      .SetCreateFn<SoftmaxCrossEntropyCpuKernel<OF_PP_PAIR_FIRST(dtype_pair)>>()              \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)                          \
+                       & (user_op::HobDataType("label", 0) == OF_PP_PAIR_SECOND(dtype_pair))  \
+                       & (user_op::HobDataType("out", 0) == OF_PP_PAIR_SECOND(dtype_pair)));
+
+OF_PP_FOR_EACH_TUPLE(REGISTER_SOFTMAX_CROSS_ENTROPY_CPU_KERNEL, FLOATING_DATA_TYPE_SEQ)
 
 OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(REGISTER_SOFTMAX_CROSS_ENTROPY_GRAD_KERNEL,
                                  OF_PP_MAKE_TUPLE_SEQ(DeviceType::kCPU), FLOATING_DATA_TYPE_SEQ)
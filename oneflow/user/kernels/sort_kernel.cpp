@@ -15,9 +15,38 @@ limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/kernel/new_kernel_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/kernels/cpu_sort_util.h"
 
 namespace oneflow {
 
+namespace {
+
+// The keys of a descending sort are flipped, so that the radix sort always is ascending.
+template<typename T>
+void SortRowByRadix(const T* in_ptr, int32_t instance_size, bool is_ascending,
+                    typename RadixSortKey<T>::Key* keys, typename RadixSortKey<T>::Key* keys_tmp,
+                    T* out_ptr) {
+  using Key = typename RadixSortKey<T>::Key;
+  const Key flip = is_ascending ? 0 : static_cast<Key>(~Key(0));
+  FOR_RANGE(int32_t, j, 0, instance_size) {
+    keys[j] = static_cast<Key>(RadixSortKey<T>::Encode(in_ptr[j]) ^ flip);
+  }
+  RadixSortPairs<Key, int32_t>(instance_size, keys, keys_tmp, nullptr, nullptr);
+  FOR_RANGE(int32_t, j, 0, instance_size) {
+    out_ptr[j] = RadixSortKey<T>::Decode(static_cast<Key>(keys[j] ^ flip));
+  }
+}
+
+template<typename T>
+size_t InferSortTmpSize(user_op::InferContext* ctx) {
+  const Shape* in_shape = ctx->Shape4ArgNameAndIndex("in", 0);
+  if (in_shape->dim_vec().back() < kCpuRadixSortMinSize) { return 0; }
+  return 2 * GetCudaAlignedSize(in_shape->elem_cnt() * sizeof(T));
+}
+
+}  // namespace
+
 template<typename T>
 class CpuSortKernel final : public user_op::OpKernel {
  public:
@@ -26,37 +55,60 @@ class CpuSortKernel final : public user_op::OpKernel {
 
  private:
   void Compute(user_op::KernelComputeContext* ctx) const override {
+    using Key = typename RadixSortKey<T>::Key;
     const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
     user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
 
-    Memcpy<DeviceType::kCPU>(ctx->device_ctx(), out->mut_dptr<T>(), in->dptr<T>(),
-                             in->shape().elem_cnt() * sizeof(T));
     const int32_t instance_size = in->shape().At(in->shape().NumAxes() - 1);
     const int32_t instance_num = in->shape().elem_cnt() / instance_size;
     const std::string& direction = ctx->Attr<std::string>("direction");
+    CHECK(direction == "ASCENDING" || direction == "DESCENDING");
     const bool is_ascending = direction == "ASCENDING";
-    const bool is_descending = direction == "DESCENDING";
-    FOR_RANGE(int32_t, i, 0, instance_num) {
-      T* out_ptr_i = out->mut_dptr<T>() + i * instance_size;
-      if (is_ascending) {
-        std::sort(out_ptr_i, out_ptr_i + instance_size, std::less<T>());
-      } else if (is_descending) {
-        std::sort(out_ptr_i, out_ptr_i + instance_size, std::greater<T>());
-      } else {
-        UNIMPLEMENTED();
-      }
+    const bool use_radix = instance_size >= kCpuRadixSortMinSize;
+    Key* keys = nullptr;
+    Key* keys_tmp = nullptr;
+    if (use_radix) {
+      char* tmp_ptr = tmp_buffer->mut_dptr<char>();
+      keys = reinterpret_cast<Key*>(tmp_ptr);
+      keys_tmp = reinterpret_cast<Key*>(
+          tmp_ptr + GetCudaAlignedSize(in->shape().elem_cnt() * sizeof(T)));
     }
+    MultiThreadLoopInRanges(
+        instance_num, GetNumThreadRanges(instance_num, instance_size),
+        [&](int64_t, int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, i, begin, end) {
+            const int64_t offset = i * instance_size;
+            const T* in_ptr_i = in->dptr<T>() + offset;
+            T* out_ptr_i = out->mut_dptr<T>() + offset;
+            if (use_radix) {
+              SortRowByRadix(in_ptr_i, instance_size, is_ascending, keys + offset,
+                             keys_tmp + offset, out_ptr_i);
+            } else {
+              std::copy(in_ptr_i, in_ptr_i + instance_size, out_ptr_i);
+              if (is_ascending) {
+                std::sort(out_ptr_i, out_ptr_i + instance_size, std::less<T>());
+              } else {
+                std::sort(out_ptr_i, out_ptr_i + instance_size, std::greater<T>());
+              }
+            }
+          }
+        });
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
 
-#define REGISTER_CPU_SORT_KERNEL(dtype)                                             \
-  REGISTER_USER_KERNEL("sort").SetCreateFn<CpuSortKernel<dtype>>().SetIsMatchedHob( \
-      (user_op::HobDeviceTag() == "cpu")                                            \
-      & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value));
+#define REGISTER_CPU_SORT_KERNEL(dtype)                                                 \
+  REGISTER_USER_KERNEL("sort")                                                          \
+      .SetCreateFn<CpuSortKernel<dtype>>()                                              \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                               \
+                       & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn(InferSortTmpSize<dtype>);
 
 REGISTER_CPU_SORT_KERNEL(float)
 REGISTER_CPU_SORT_KERNEL(double)
+REGISTER_CPU_SORT_KERNEL(int8_t)
+REGISTER_CPU_SORT_KERNEL(uint8_t)
 REGISTER_CPU_SORT_KERNEL(int32_t)
 REGISTER_CPU_SORT_KERNEL(int64_t)
 
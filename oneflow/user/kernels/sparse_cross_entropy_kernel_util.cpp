@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/user/kernels/sparse_cross_entropy_kernel_util.h"
 #include "oneflow/core/kernel/kernel_util.cuh"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 namespace user_op {
@@ -49,19 +50,22 @@ struct SparseCrossEntropyKernelUtil<DeviceType::kCPU, T, K> {
                                      const int64_t num_classes, const int64_t depth,
                                      const int64_t lower_bound, const T* prob, const K* labels,
                                      const T* dy, T* dx) {
-    FOR_RANGE(int64_t, i, 0, elem_cnt) {
-      const int32_t row_id = i / num_classes;
-      const int32_t col_id = i - row_id * num_classes;
-      CHECK_GE(labels[row_id], 0);
-      CHECK_LT(labels[row_id], depth);
-      K label = labels[row_id] - lower_bound;
-
-      if (label == col_id) {
-        dx[i] = dy[row_id] * (prob[i] - 1);
-      } else {
-        dx[i] = dy[row_id] * prob[i];
-      }
-    }
+    const int64_t num_instances = elem_cnt / num_classes;
+    MultiThreadLoopInRanges(num_instances, GetNumThreadRanges(num_instances, num_classes),
+                            [&](int64_t range_id, int64_t begin, int64_t end) {
+                              FOR_RANGE(int64_t, i, begin, end) {
+                                CHECK_GE(labels[i], 0);
+                                CHECK_LT(labels[i], depth);
+                                const int64_t offset = i * num_classes;
+                                FOR_RANGE(int64_t, j, offset, offset + num_classes) {
+                                  dx[j] = dy[i] * prob[j];
+                                }
+                                const K label = labels[i] - lower_bound;
+                                if (label >= 0 && label < num_classes) {
+                                  dx[offset + label] -= dy[i];
+                                }
+                              }
+                            });
   }
 };
 
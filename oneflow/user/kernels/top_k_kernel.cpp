@@ -21,6 +21,12 @@ namespace oneflow {
 
 namespace {
 
+// A heap of the k best values is kept when k is at most kTopKHeapMaxK and the row at least
+// kTopKHeapMinRatio times longer, most of the row is then skipped by one comparison with the
+// smallest value of the heap. Otherwise the indices of the row are partitioned by nth_element.
+constexpr int32_t kTopKHeapMaxK = 256;
+constexpr int32_t kTopKHeapMinRatio = 32;
+
 template<typename T>
 void ComputeTopOne(const T* in_ptr, const Range& range, int32_t instance_size, int32_t* out_ptr) {
   FOR_RANGE(int32_t, i, range.begin(), range.end()) {
@@ -52,24 +58,69 @@ void ComputeTopK(const T* in_ptr, int32_t* indices_ptr, const Range& range, int3
   }
 }
 
+// The k largest values of a row, for k much smaller than the row, kept in a min-heap of the best
+// ones seen so far. The row is scanned by increasing index, so a value equal to the smallest
+// of the heap never replaces it, and ties go to the smaller index as in ComputeTopK.
+template<typename T>
+void ComputeTopKByHeap(const T* in_ptr, const Range& range, int32_t instance_size, int32_t k,
+                       bool sorted, int32_t* out_ptr) {
+  std::vector<std::pair<T, int32_t>> heap(k);
+  // The heap is ordered by "better than", so that its front is the worst of the k.
+  auto better = [](const std::pair<T, int32_t>& lhs, const std::pair<T, int32_t>& rhs) {
+    if (lhs.first == rhs.first) {
+      return lhs.second < rhs.second;
+    } else {
+      return lhs.first > rhs.first;
+    }
+  };
+  FOR_RANGE(int32_t, i, range.begin(), range.end()) {
+    const T* in_ptr_i = in_ptr + static_cast<int64_t>(i) * instance_size;
+    FOR_RANGE(int32_t, j, 0, k) { heap[j] = std::make_pair(in_ptr_i[j], j); }
+    std::make_heap(heap.begin(), heap.end(), better);
+    FOR_RANGE(int32_t, j, k, instance_size) {
+      if (!(in_ptr_i[j] > heap.front().first)) { continue; }
+      std::pop_heap(heap.begin(), heap.end(), better);
+      heap.back() = std::make_pair(in_ptr_i[j], j);
+      std::push_heap(heap.begin(), heap.end(), better);
+    }
+    if (sorted) { std::sort_heap(heap.begin(), heap.end(), better); }
+    int32_t* out_ptr_i = out_ptr + static_cast<int64_t>(i) * k;
+    FOR_RANGE(int32_t, j, 0, k) { out_ptr_i[j] = heap[j].second; }
+  }
+}
+
+bool IsTopKByHeap(int32_t instance_size, int32_t k) {
+  return k <= kTopKHeapMaxK && k * kTopKHeapMinRatio <= instance_size;
+}
+
 template<typename T>
 void CpuTopK(DeviceCtx* ctx, const T* in_ptr, int32_t* indices_ptr, int32_t instance_num,
              int32_t instance_size, int32_t k, bool sorted, int32_t* out_ptr) {
-  const int32_t num_thread = std::min(instance_num, Global<ThreadPool>::Get()->thread_num());
-  const BalancedSplitter bs(instance_num, num_thread);
-  BlockingCounter bc(num_thread);
-  FOR_RANGE(int32_t, thread_id, 0, num_thread) {
-    const Range range = bs.At(thread_id);
-    Global<ThreadPool>::Get()->AddWork([=, &bc]() {
-      if (k == 1) {
-        ComputeTopOne(in_ptr, range, instance_size, out_ptr);
-      } else {
-        ComputeTopK(in_ptr, indices_ptr, range, instance_size, k, sorted, out_ptr);
-      }
-      bc.Decrease();
-    });
+  MultiThreadLoopInRanges(
+      instance_num, GetNumThreadRanges(instance_num, instance_size),
+      [&](int64_t, int64_t begin, int64_t end) {
+        const Range range(begin, end);
+        if (k == 1) {
+          ComputeTopOne(in_ptr, range, instance_size, out_ptr);
+        } else if (IsTopKByHeap(instance_size, k)) {
+          ComputeTopKByHeap(in_ptr, range, instance_size, k, sorted, out_ptr);
+        } else {
+          ComputeTopK(in_ptr, indices_ptr, range, instance_size, k, sorted, out_ptr);
+        }
+      });
+}
+
+size_t InferTopKTmpSize(user_op::InferContext* ctx) {
+  const Shape* in_shape = ctx->Shape4ArgNameAndIndex("in", 0);
+  const int32_t instance_size = in_shape->dim_vec().back();
+  const int32_t k = std::min(ctx->Attr<int32_t>("k"), instance_size);
+  if (k == 1) { return 0; }
+  // The rows of a dynamic input may be too short for the heap at runtime, CpuTopK then
+  // partitions their indices.
+  if (IsTopKByHeap(instance_size, k) && !ctx->TensorDesc4ArgNameAndIndex("in", 0)->is_dynamic()) {
+    return 0;
   }
-  bc.WaitUntilCntEqualZero();
+  return in_shape->elem_cnt() * sizeof(int32_t);
 }
 
 }  // namespace
@@ -96,18 +147,17 @@ class TopKCpuKernel final : public user_op::OpKernel {
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
 
-#define REGISTER_CPU_TOP_K_KERNEL(dtype)                                                 \
-  REGISTER_USER_KERNEL("top_k")                                                          \
-      .SetCreateFn<TopKCpuKernel<dtype>>()                                               \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                \
-                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value))   \
-      .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                                \
-        const Shape* in_shape = ctx->Shape4ArgNameAndIndex("in", 0);                     \
-        return ctx->Attr<int32_t>("k") > 1 ? in_shape->elem_cnt() * sizeof(int32_t) : 0; \
-      });
+#define REGISTER_CPU_TOP_K_KERNEL(dtype)                                               \
+  REGISTER_USER_KERNEL("top_k")                                                        \
+      .SetCreateFn<TopKCpuKernel<dtype>>()                                             \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn(InferTopKTmpSize);
 
 REGISTER_CPU_TOP_K_KERNEL(float)
 REGISTER_CPU_TOP_K_KERNEL(double)
+REGISTER_CPU_TOP_K_KERNEL(int8_t)
+REGISTER_CPU_TOP_K_KERNEL(uint8_t)
 REGISTER_CPU_TOP_K_KERNEL(int32_t)
 REGISTER_CPU_TOP_K_KERNEL(int64_t)
 
@@ -60,4 +60,50 @@ REGISTER_CPU_TRIL_KERNEL(int8_t)
 REGISTER_CPU_TRIL_KERNEL(int32_t)
 REGISTER_CPU_TRIL_KERNEL(int64_t)
 
+template<typename T>
+class CpuFusedScaleTrilKernel final : public user_op::OpKernel {
+ public:
+  CpuFusedScaleTrilKernel() = default;
+  ~CpuFusedScaleTrilKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("in", 0);
+    const auto shape = x->shape();
+    const auto diagonal = ctx->Attr<int64_t>("diagonal");
+    const int64_t num_rows = shape.At(shape.NumAxes() - 2);
+    const int64_t num_cols = shape.At(shape.NumAxes() - 1);
+    user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("out", 0);
+    T* y_dptr = y->mut_dptr<T>();
+    const T* x_dptr = x->dptr<T>();
+    const T fill = ctx->Attr<bool>("is_floating_fill_value")
+                       ? static_cast<T>(ctx->Attr<double>("floating_fill_value"))
+                       : static_cast<T>(ctx->Attr<int64_t>("integer_fill_value"));
+    const T scale = ctx->Attr<bool>("is_floating_scale_value")
+                        ? static_cast<T>(ctx->Attr<double>("floating_scale_value"))
+                        : static_cast<T>(ctx->Attr<int64_t>("integer_scale_value"));
+    const int64_t total_rows = shape.elem_cnt() / num_cols;
+    FOR_RANGE(int64_t, row, 0, total_rows) {
+      const int64_t i = row % num_rows;
+      const int64_t num_tril_cols = std::min(std::max<int64_t>(i + diagonal + 1, 0), num_cols);
+      const int64_t offset = row * num_cols;
+      FOR_RANGE(int64_t, j, 0, num_tril_cols) { y_dptr[offset + j] = x_dptr[offset + j] * scale; }
+      std::fill(y_dptr + offset + num_tril_cols, y_dptr + offset + num_cols, fill);
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_CPU_FUSED_SCALE_TRIL_KERNEL(dtype)       \
+  REGISTER_USER_KERNEL("fused_scale_tril")                \
+      .SetCreateFn<CpuFusedScaleTrilKernel<dtype>>()      \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu") \
+                       & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value));
+
+REGISTER_CPU_FUSED_SCALE_TRIL_KERNEL(float)
+REGISTER_CPU_FUSED_SCALE_TRIL_KERNEL(double)
+REGISTER_CPU_FUSED_SCALE_TRIL_KERNEL(int8_t)
+REGISTER_CPU_FUSED_SCALE_TRIL_KERNEL(int32_t)
+REGISTER_CPU_FUSED_SCALE_TRIL_KERNEL(int64_t)
+
 }  // namespace oneflow
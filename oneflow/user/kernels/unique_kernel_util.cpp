@@ -14,9 +14,170 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/user/kernels/unique_kernel_util.h"
+#include "oneflow/user/kernels/cpu_hash_table_util.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
+namespace {
+
+// The keys are split into partitions by the top bits of their hashes, each partition has its own
+// table and is filled by a single thread.
+constexpr int64_t kNumUniquePartitionBits = 6;
+constexpr int64_t kNumUniquePartitions = 1 << kNumUniquePartitionBits;
+constexpr size_t kUniqueWorkspaceAlignSize = 64;
+
+int64_t GetUniquePartition(const uint64_t hash) {
+  return static_cast<int64_t>(hash >> (64 - kNumUniquePartitionBits));
+}
+
+// The total capacity of the tables, that of a single table for all the keys or the sum of those
+// of the partitions.
+template<typename KEY, typename IDX>
+int64_t GetUniqueMaxTableCapacity(int64_t n) {
+  return kNumUniquePartitions * CpuFlatHashTable<KEY, IDX>::kGroupSize + 4 * n;
+}
+
+size_t GetUniqueBufferSize(int64_t elem_cnt, size_t elem_size) {
+  return RoundUp(elem_cnt * elem_size, kUniqueWorkspaceAlignSize);
+}
+
+template<typename T>
+T* CarveUniqueBuffer(int64_t elem_cnt, char** ptr) {
+  T* buf = reinterpret_cast<T*>(*ptr);
+  *ptr += GetUniqueBufferSize(elem_cnt, sizeof(T));
+  return buf;
+}
+
+template<typename KEY, typename IDX>
+int64_t GetUniqueWorkspaceSize(int64_t n) {
+  const int64_t capacity = GetUniqueMaxTableCapacity<KEY, IDX>(n);
+  // the control bytes, keys and values of the tables, then the partitioned keys, their positions
+  // and slots, the first occurrence flags and slots, the counts and ids of the slots
+  return GetUniqueBufferSize(capacity, 1) + GetUniqueBufferSize(capacity, sizeof(KEY))
+         + GetUniqueBufferSize(capacity, sizeof(IDX)) + GetUniqueBufferSize(n, sizeof(KEY))
+         + GetUniqueBufferSize(n, 1) + 5 * GetUniqueBufferSize(n, sizeof(IDX));
+}
+
+// Ids in the order of the first occurrences of the keys with one table.
+template<typename KEY, typename IDX>
+void UniqueSerially(int64_t n, const KEY* in, IDX* num_unique, KEY* unique_out, IDX* idx_out,
+                    IDX* count, uint8_t* ctrl, KEY* keys, IDX* values) {
+  CpuFlatHashTable<KEY, IDX> table(CpuFlatHashTable<KEY, IDX>::GetCapacity(n), ctrl, keys,
+                                   values);
+  IDX num = 0;
+  FOR_RANGE(int64_t, i, 0, n) {
+    const KEY key = in[i];
+    bool inserted = false;
+    const IDX idx = table.FindOrInsert(key, HashCpuTableKey(key), num, &inserted);
+    if (inserted) {
+      unique_out[num] = key;
+      if (count != nullptr) { count[num] = 0; }
+      num += 1;
+    }
+    if (count != nullptr) { count[idx] += 1; }
+    idx_out[i] = idx;
+  }
+  *num_unique = num;
+}
+
+// The same ids as UniqueSerially, computed by partitions in the thread pool:
+// 1. the keys of every range of the input are counted by partition,
+// 2. the keys and their positions are scattered into the order of the partitions,
+// 3. every partition inserts its keys in the order of the input into its own table, the slot of
+//    a key is the offset of its partition plus its id in the partition, the first occurrences
+//    are flagged at their positions,
+// 4. the first occurrences are numbered in the order of the input,
+// 5. the ids of the slots are scattered back into idx_out.
+template<typename KEY, typename IDX>
+void UniqueByPartitions(int64_t n, int64_t num_ranges, const KEY* in, IDX* num_unique,
+                        KEY* unique_out, IDX* idx_out, IDX* count, uint8_t* ctrl, KEY* keys,
+                        IDX* values, KEY* partitioned_in, IDX* order, IDX* slot_of,
+                        uint8_t* is_first, IDX* first_slot, IDX* slot_count, IDX* id_of) {
+  std::vector<int64_t> range_offset(num_ranges * kNumUniquePartitions, 0);
+  MultiThreadLoopInRanges(n, num_ranges, [&](int64_t range_id, int64_t begin, int64_t end) {
+    int64_t* partition_cnt = range_offset.data() + range_id * kNumUniquePartitions;
+    FOR_RANGE(int64_t, i, begin, end) {
+      partition_cnt[GetUniquePartition(HashCpuTableKey(in[i]))] += 1;
+    }
+    std::memset(is_first + begin, 0, end - begin);
+  });
+  std::vector<int64_t> partition_begin(kNumUniquePartitions + 1, 0);
+  std::vector<int64_t> table_begin(kNumUniquePartitions + 1, 0);
+  int64_t offset = 0;
+  FOR_RANGE(int64_t, p, 0, kNumUniquePartitions) {
+    partition_begin[p] = offset;
+    FOR_RANGE(int64_t, range_id, 0, num_ranges) {
+      int64_t* cnt = range_offset.data() + range_id * kNumUniquePartitions + p;
+      const int64_t range_partition_cnt = *cnt;
+      *cnt = offset;
+      offset += range_partition_cnt;
+    }
+    table_begin[p + 1] =
+        table_begin[p] + CpuFlatHashTable<KEY, IDX>::GetCapacity(offset - partition_begin[p]);
+  }
+  partition_begin[kNumUniquePartitions] = offset;
+  CHECK_EQ(offset, n);
+  CHECK_LE(table_begin[kNumUniquePartitions], GetUniqueMaxTableCapacity<KEY, IDX>(n));
+  MultiThreadLoopInRanges(n, num_ranges, [&](int64_t range_id, int64_t begin, int64_t end) {
+    int64_t* partition_offset = range_offset.data() + range_id * kNumUniquePartitions;
+    FOR_RANGE(int64_t, i, begin, end) {
+      const int64_t j = partition_offset[GetUniquePartition(HashCpuTableKey(in[i]))]++;
+      partitioned_in[j] = in[i];
+      order[j] = i;
+    }
+  });
+  MultiThreadLoopInRanges(
+      kNumUniquePartitions, num_ranges, [&](int64_t, int64_t p_begin, int64_t p_end) {
+        FOR_RANGE(int64_t, p, p_begin, p_end) {
+          const int64_t t = table_begin[p];
+          CpuFlatHashTable<KEY, IDX> table(table_begin[p + 1] - t, ctrl + t, keys + t, values + t);
+          const int64_t base = partition_begin[p];
+          IDX num = 0;
+          FOR_RANGE(int64_t, j, base, partition_begin[p + 1]) {
+            const KEY key = partitioned_in[j];
+            bool inserted = false;
+            const IDX local_id = table.FindOrInsert(key, HashCpuTableKey(key), num, &inserted);
+            const IDX slot = base + local_id;
+            if (inserted) {
+              is_first[order[j]] = 1;
+              first_slot[order[j]] = slot;
+              slot_count[slot] = 0;
+              num += 1;
+            }
+            slot_count[slot] += 1;
+            slot_of[j] = slot;
+          }
+        }
+      });
+  std::vector<int64_t> range_first_id(num_ranges + 1, 0);
+  MultiThreadLoopInRanges(n, num_ranges, [&](int64_t range_id, int64_t begin, int64_t end) {
+    int64_t num = 0;
+    FOR_RANGE(int64_t, i, begin, end) { num += is_first[i]; }
+    range_first_id[range_id + 1] = num;
+  });
+  FOR_RANGE(int64_t, range_id, 0, num_ranges) {
+    range_first_id[range_id + 1] += range_first_id[range_id];
+  }
+  MultiThreadLoopInRanges(n, num_ranges, [&](int64_t range_id, int64_t begin, int64_t end) {
+    IDX id = range_first_id[range_id];
+    FOR_RANGE(int64_t, i, begin, end) {
+      if (is_first[i] == 0) { continue; }
+      const IDX slot = first_slot[i];
+      id_of[slot] = id;
+      unique_out[id] = in[i];
+      if (count != nullptr) { count[id] = slot_count[slot]; }
+      id += 1;
+    }
+  });
+  MultiThreadLoopInRanges(n, num_ranges, [&](int64_t, int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, j, begin, end) { idx_out[order[j]] = id_of[slot_of[j]]; }
+  });
+  *num_unique = range_first_id[num_ranges];
+}
+
+}  // namespace
+
 template<typename KEY, typename IDX>
 struct UniqueKernelUtil<DeviceType::kCPU, KEY, IDX> {
   static void Unique(DeviceCtx* ctx, int64_t n, const KEY* in, IDX* num_unique, KEY* unique_out,
@@ -27,31 +188,35 @@ struct UniqueKernelUtil<DeviceType::kCPU, KEY, IDX> {
   static void UniqueWithCounts(DeviceCtx* ctx, int64_t n, const KEY* in, IDX* num_unique,
                                KEY* unique_out, IDX* idx_out, IDX* count, void* workspace,
                                int64_t workspace_size_in_bytes) {
-    HashMap<KEY, IDX> map;
-    FOR_RANGE(int64_t, i, 0, n) {
-      KEY in_i = in[i];
-      auto it = map.find(in_i);
-      if (it == map.end()) {
-        IDX idx = map.size();
-        if (count != nullptr) { count[idx] = 1; }
-        idx_out[i] = idx;
-        unique_out[idx] = in_i;
-        map[in_i] = idx;
-      } else {
-        IDX idx = it->second;
-        if (count != nullptr) { count[idx] += 1; }
-        idx_out[i] = idx;
-      }
+    CHECK_LE(GetUniqueWorkspaceSize<KEY, IDX>(n), workspace_size_in_bytes);
+    const int64_t capacity = GetUniqueMaxTableCapacity<KEY, IDX>(n);
+    char* ptr = reinterpret_cast<char*>(workspace);
+    uint8_t* ctrl = CarveUniqueBuffer<uint8_t>(capacity, &ptr);
+    KEY* keys = CarveUniqueBuffer<KEY>(capacity, &ptr);
+    IDX* values = CarveUniqueBuffer<IDX>(capacity, &ptr);
+    const int64_t num_ranges = GetNumThreadRanges(n, 1);
+    if (num_ranges <= 1) {
+      UniqueSerially(n, in, num_unique, unique_out, idx_out, count, ctrl, keys, values);
+      return;
     }
-    *num_unique = map.size();
+    KEY* partitioned_in = CarveUniqueBuffer<KEY>(n, &ptr);
+    IDX* order = CarveUniqueBuffer<IDX>(n, &ptr);
+    IDX* slot_of = CarveUniqueBuffer<IDX>(n, &ptr);
+    uint8_t* is_first = CarveUniqueBuffer<uint8_t>(n, &ptr);
+    IDX* first_slot = CarveUniqueBuffer<IDX>(n, &ptr);
+    IDX* slot_count = CarveUniqueBuffer<IDX>(n, &ptr);
+    IDX* id_of = CarveUniqueBuffer<IDX>(n, &ptr);
+    UniqueByPartitions(n, num_ranges, in, num_unique, unique_out, idx_out, count, ctrl, keys,
+                       values, partitioned_in, order, slot_of, is_first, first_slot, slot_count,
+                       id_of);
   }
   static void GetUniqueWorkspaceSizeInBytes(DeviceCtx* ctx, int64_t n,
                                             int64_t* workspace_size_in_bytes) {
-    *workspace_size_in_bytes = 1;
+    *workspace_size_in_bytes = GetUniqueWorkspaceSize<KEY, IDX>(n);
   }
   static void GetUniqueWithCountsWorkspaceSizeInBytes(DeviceCtx* ctx, int64_t n,
                                                       int64_t* workspace_size_in_bytes) {
-    *workspace_size_in_bytes = 1;
+    *workspace_size_in_bytes = GetUniqueWorkspaceSize<KEY, IDX>(n);
   }
 };
 
@@ -0,0 +1,424 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/kernel/new_kernel_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/kernels/upsample_kernel.h"
+
+namespace oneflow {
+
+namespace {
+
+// The sizes of an upsample, in is x or dx and out is y or dy. A channels_last blob is NHWC, the
+// channels of a pixel are contiguous and the inner loops run over them.
+struct UpsampleDims {
+  UpsampleDims(const ShapeView& in_shape, const ShapeView& out_shape,
+               const std::string& data_format)
+      : channels_last(data_format == "channels_last"),
+        batch(in_shape.At(0)),
+        channels(in_shape.At(channels_last ? 3 : 1)),
+        in_height(in_shape.At(channels_last ? 1 : 2)),
+        in_width(in_shape.At(channels_last ? 2 : 3)),
+        out_height(out_shape.At(channels_last ? 1 : 2)),
+        out_width(out_shape.At(channels_last ? 2 : 3)) {}
+
+  bool channels_last;
+  int64_t batch;
+  int64_t channels;
+  int64_t in_height;
+  int64_t in_width;
+  int64_t out_height;
+  int64_t out_width;
+};
+
+// The same coordinate mappings as the gpu kernels, the tables below hold them for every output
+// row and column so that the inner loops only load indices and weights.
+int64_t GetNearestInputIndex(const int64_t out_dim_idx, const float scale,
+                             const int64_t in_dim_size) {
+  return std::max(
+      std::min(static_cast<int64_t>(std::floor((static_cast<float>(out_dim_idx) + 0.5f) * scale)),
+               in_dim_size - 1),
+      static_cast<int64_t>(0));
+}
+
+std::vector<int64_t> GetNearestIndexTable(const int64_t in_size, const int64_t out_size,
+                                          const float scale) {
+  std::vector<int64_t> table(out_size);
+  FOR_RANGE(int64_t, i, 0, out_size) { table[i] = GetNearestInputIndex(i, 1.f / scale, in_size); }
+  return table;
+}
+
+// An output coordinate interpolates the input coordinates lo and hi, by lerp towards hi.
+template<typename T>
+struct LinearTap {
+  int64_t lo;
+  int64_t hi;
+  T lerp;
+};
+
+template<typename T>
+std::vector<LinearTap<T>> GetLinearTapTable(const int64_t in_size, const int64_t out_size,
+                                            const bool align_corners, const float scale) {
+  const T area_scale =
+      GetAreaPixelScale(in_size, out_size, align_corners, static_cast<T>(scale));
+  std::vector<LinearTap<T>> table(out_size);
+  FOR_RANGE(int64_t, i, 0, out_size) {
+    const T src = GetAreaPixelSourceIndex(area_scale, i, align_corners);
+    table[i].lo = src > 0 ? static_cast<int64_t>(std::floor(src)) : 0;
+    table[i].hi = src < in_size - 1 ? static_cast<int64_t>(std::ceil(src)) : in_size - 1;
+    table[i].lerp = src - std::floor(src);
+  }
+  return table;
+}
+
+// Calls Visit(n, c_begin, c_end) on ranges of the channels of every image, the ranges of different
+// threads never write the same element of a channels_last blob.
+template<typename Visitor>
+void ForEachBatchChannelRange(const UpsampleDims& dims, const int64_t item_size,
+                              const Visitor& Visit) {
+  const int64_t num = dims.batch * dims.channels;
+  MultiThreadLoopInRanges(
+      num, GetNumThreadRanges(num, item_size), [&](int64_t range_id, int64_t begin, int64_t end) {
+        for (int64_t n = begin / dims.channels; n * dims.channels < end; ++n) {
+          const int64_t c_begin = std::max(begin, n * dims.channels) - n * dims.channels;
+          const int64_t c_end = std::min(end, (n + 1) * dims.channels) - n * dims.channels;
+          Visit(n, c_begin, c_end);
+        }
+      });
+}
+
+template<typename T>
+void UpsampleNearestForward(const UpsampleDims& dims, const std::vector<int64_t>& h_table,
+                            const std::vector<int64_t>& w_table, const T* x, T* y) {
+  const int64_t c = dims.channels;
+  if (dims.channels_last) {
+    const int64_t rows = dims.batch * dims.out_height;
+    MultiThreadLoopInRanges(
+        rows, GetNumThreadRanges(rows, dims.out_width * c),
+        [&](int64_t range_id, int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, row, begin, end) {
+            const int64_t n = row / dims.out_height;
+            const int64_t in_h = h_table[row % dims.out_height];
+            const T* x_row = x + (n * dims.in_height + in_h) * dims.in_width * c;
+            T* y_row = y + row * dims.out_width * c;
+            FOR_RANGE(int64_t, w, 0, dims.out_width) {
+              std::copy(x_row + w_table[w] * c, x_row + (w_table[w] + 1) * c, y_row + w * c);
+            }
+          }
+        });
+  } else {
+    const int64_t planes = dims.batch * c;
+    const int64_t in_plane_size = dims.in_height * dims.in_width;
+    const int64_t out_plane_size = dims.out_height * dims.out_width;
+    MultiThreadLoopInRanges(
+        planes, GetNumThreadRanges(planes, out_plane_size),
+        [&](int64_t range_id, int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, plane, begin, end) {
+            FOR_RANGE(int64_t, h, 0, dims.out_height) {
+              const T* x_row = x + plane * in_plane_size + h_table[h] * dims.in_width;
+              T* y_row = y + plane * out_plane_size + h * dims.out_width;
+              FOR_RANGE(int64_t, w, 0, dims.out_width) { y_row[w] = x_row[w_table[w]]; }
+            }
+          }
+        });
+  }
+}
+
+// The backward functions get dx zeroed, each thread accumulates into its own planes or
+// channel ranges.
+template<typename T>
+void UpsampleNearestBackward(const UpsampleDims& dims, const std::vector<int64_t>& h_table,
+                             const std::vector<int64_t>& w_table, const T* dy, T* dx) {
+  const int64_t c = dims.channels;
+  const int64_t in_plane_size = dims.in_height * dims.in_width;
+  const int64_t out_plane_size = dims.out_height * dims.out_width;
+  if (dims.channels_last) {
+    ForEachBatchChannelRange(dims, out_plane_size, [&](int64_t n, int64_t c_begin, int64_t c_end) {
+      const T* dy_image = dy + n * out_plane_size * c;
+      T* dx_image = dx + n * in_plane_size * c;
+      FOR_RANGE(int64_t, h, 0, dims.out_height) {
+        T* dx_row = dx_image + h_table[h] * dims.in_width * c;
+        FOR_RANGE(int64_t, w, 0, dims.out_width) {
+          const T* dy_pixel = dy_image + (h * dims.out_width + w) * c;
+          T* dx_pixel = dx_row + w_table[w] * c;
+          FOR_RANGE(int64_t, ch, c_begin, c_end) { dx_pixel[ch] += dy_pixel[ch]; }
+        }
+      }
+    });
+  } else {
+    const int64_t planes = dims.batch * c;
+    MultiThreadLoopInRanges(
+        planes, GetNumThreadRanges(planes, out_plane_size),
+        [&](int64_t range_id, int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, plane, begin, end) {
+            FOR_RANGE(int64_t, h, 0, dims.out_height) {
+              const T* dy_row = dy + plane * out_plane_size + h * dims.out_width;
+              T* dx_row = dx + plane * in_plane_size + h_table[h] * dims.in_width;
+              FOR_RANGE(int64_t, w, 0, dims.out_width) { dx_row[w_table[w]] += dy_row[w]; }
+            }
+          }
+        });
+  }
+}
+
+template<typename T>
+void UpsampleBilinearForward(const UpsampleDims& dims, const std::vector<LinearTap<T>>& h_table,
+                             const std::vector<LinearTap<T>>& w_table, const T* x, T* y) {
+  const int64_t c = dims.channels;
+  if (dims.channels_last) {
+    const int64_t rows = dims.batch * dims.out_height;
+    MultiThreadLoopInRanges(
+        rows, GetNumThreadRanges(rows, dims.out_width * c),
+        [&](int64_t range_id, int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, row, begin, end) {
+            const T* x_image = x + (row / dims.out_height) * dims.in_height * dims.in_width * c;
+            const LinearTap<T>& h_tap = h_table[row % dims.out_height];
+            const T* top_row = x_image + h_tap.lo * dims.in_width * c;
+            const T* bottom_row = x_image + h_tap.hi * dims.in_width * c;
+            T* y_row = y + row * dims.out_width * c;
+            FOR_RANGE(int64_t, w, 0, dims.out_width) {
+              const LinearTap<T>& w_tap = w_table[w];
+              const T* top_left = top_row + w_tap.lo * c;
+              const T* top_right = top_row + w_tap.hi * c;
+              const T* bottom_left = bottom_row + w_tap.lo * c;
+              const T* bottom_right = bottom_row + w_tap.hi * c;
+              T* y_pixel = y_row + w * c;
+              FOR_RANGE(int64_t, ch, 0, c) {
+                const T top = top_left[ch] + (top_right[ch] - top_left[ch]) * w_tap.lerp;
+                const T bottom =
+                    bottom_left[ch] + (bottom_right[ch] - bottom_left[ch]) * w_tap.lerp;
+                y_pixel[ch] = top + (bottom - top) * h_tap.lerp;
+              }
+            }
+          }
+        });
+  } else {
+    const int64_t planes = dims.batch * c;
+    const int64_t in_plane_size = dims.in_height * dims.in_width;
+    const int64_t out_plane_size = dims.out_height * dims.out_width;
+    MultiThreadLoopInRanges(
+        planes, GetNumThreadRanges(planes, out_plane_size),
+        [&](int64_t range_id, int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, plane, begin, end) {
+            FOR_RANGE(int64_t, h, 0, dims.out_height) {
+              const LinearTap<T>& h_tap = h_table[h];
+              const T* top_row = x + plane * in_plane_size + h_tap.lo * dims.in_width;
+              const T* bottom_row = x + plane * in_plane_size + h_tap.hi * dims.in_width;
+              T* y_row = y + plane * out_plane_size + h * dims.out_width;
+              FOR_RANGE(int64_t, w, 0, dims.out_width) {
+                const LinearTap<T>& w_tap = w_table[w];
+                const T top_left = top_row[w_tap.lo];
+                const T bottom_left = bottom_row[w_tap.lo];
+                const T top = top_left + (top_row[w_tap.hi] - top_left) * w_tap.lerp;
+                const T bottom = bottom_left + (bottom_row[w_tap.hi] - bottom_left) * w_tap.lerp;
+                y_row[w] = top + (bottom - top) * h_tap.lerp;
+              }
+            }
+          }
+        });
+  }
+}
+
+template<typename T>
+void UpsampleBilinearBackward(const UpsampleDims& dims, const std::vector<LinearTap<T>>& h_table,
+                              const std::vector<LinearTap<T>>& w_table, const T* dy, T* dx) {
+  const int64_t c = dims.channels;
+  const int64_t in_plane_size = dims.in_height * dims.in_width;
+  const int64_t out_plane_size = dims.out_height * dims.out_width;
+  if (dims.channels_last) {
+    ForEachBatchChannelRange(dims, out_plane_size, [&](int64_t n, int64_t c_begin, int64_t c_end) {
+      const T* dy_image = dy + n * out_plane_size * c;
+      T* dx_image = dx + n * in_plane_size * c;
+      FOR_RANGE(int64_t, h, 0, dims.out_height) {
+        const LinearTap<T>& h_tap = h_table[h];
+        T* top_row = dx_image + h_tap.lo * dims.in_width * c;
+        T* bottom_row = dx_image + h_tap.hi * dims.in_width * c;
+        FOR_RANGE(int64_t, w, 0, dims.out_width) {
+          const LinearTap<T>& w_tap = w_table[w];
+          const T* dy_pixel = dy_image + (h * dims.out_width + w) * c;
+          T* top_left = top_row + w_tap.lo * c;
+          T* top_right = top_row + w_tap.hi * c;
+          T* bottom_left = bottom_row + w_tap.lo * c;
+          T* bottom_right = bottom_row + w_tap.hi * c;
+          // The four taps may be the same pixel at the borders, so they are updated one by one.
+          FOR_RANGE(int64_t, ch, c_begin, c_end) {
+            const T dbottom = h_tap.lerp * dy_pixel[ch];
+            const T dtop = dy_pixel[ch] - dbottom;
+            top_left[ch] += (1 - w_tap.lerp) * dtop;
+            top_right[ch] += w_tap.lerp * dtop;
+            bottom_left[ch] += (1 - w_tap.lerp) * dbottom;
+            bottom_right[ch] += w_tap.lerp * dbottom;
+          }
+        }
+      }
+    });
+  } else {
+    const int64_t planes = dims.batch * c;
+    MultiThreadLoopInRanges(
+        planes, GetNumThreadRanges(planes, out_plane_size),
+        [&](int64_t range_id, int64_t begin, int64_t end) {
+          FOR_RANGE(int64_t, plane, begin, end) {
+            FOR_RANGE(int64_t, h, 0, dims.out_height) {
+              const LinearTap<T>& h_tap = h_table[h];
+              const T* dy_row = dy + plane * out_plane_size + h * dims.out_width;
+              T* top_row = dx + plane * in_plane_size + h_tap.lo * dims.in_width;
+              T* bottom_row = dx + plane * in_plane_size + h_tap.hi * dims.in_width;
+              FOR_RANGE(int64_t, w, 0, dims.out_width) {
+                const LinearTap<T>& w_tap = w_table[w];
+                const T dbottom = h_tap.lerp * dy_row[w];
+                const T dtop = dy_row[w] - dbottom;
+                top_row[w_tap.lo] += (1 - w_tap.lerp) * dtop;
+                top_row[w_tap.hi] += w_tap.lerp * dtop;
+                bottom_row[w_tap.lo] += (1 - w_tap.lerp) * dbottom;
+                bottom_row[w_tap.hi] += w_tap.lerp * dbottom;
+              }
+            }
+          }
+        });
+  }
+}
+
+}  // namespace
+
+template<typename T>
+class UpsampleNearestCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleNearestCPUKernel() = default;
+  ~UpsampleNearestCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x_blob = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* y_blob = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const UpsampleDims dims(x_blob->shape(), y_blob->shape(),
+                            ctx->Attr<std::string>("data_format"));
+    const std::vector<int64_t> h_table =
+        GetNearestIndexTable(dims.in_height, dims.out_height, ctx->Attr<float>("height_scale"));
+    const std::vector<int64_t> w_table =
+        GetNearestIndexTable(dims.in_width, dims.out_width, ctx->Attr<float>("width_scale"));
+    UpsampleNearestForward<T>(dims, h_table, w_table, x_blob->dptr<T>(), y_blob->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class UpsampleNearestGradCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleNearestGradCPUKernel() = default;
+  ~UpsampleNearestGradCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    user_op::Tensor* dx_blob = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    if (dx_blob == nullptr) { return; }
+    Memset<DeviceType::kCPU>(ctx->device_ctx(), dx_blob->mut_dptr<T>(), 0,
+                             dx_blob->shape().elem_cnt() * sizeof(T));
+    const user_op::Tensor* dy_blob = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const UpsampleDims dims(dx_blob->shape(), dy_blob->shape(),
+                            ctx->Attr<std::string>("data_format"));
+    const std::vector<int64_t> h_table =
+        GetNearestIndexTable(dims.in_height, dims.out_height, ctx->Attr<float>("height_scale"));
+    const std::vector<int64_t> w_table =
+        GetNearestIndexTable(dims.in_width, dims.out_width, ctx->Attr<float>("width_scale"));
+    UpsampleNearestBackward<T>(dims, h_table, w_table, dy_blob->dptr<T>(),
+                               dx_blob->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_UPSAMPLE_NEAREST_CPU_KERNEL(dtype)                                      \
+  REGISTER_USER_KERNEL("upsample")                                                       \
+      .SetCreateFn<UpsampleNearestCPUKernel<dtype>>()                                    \
+      .SetIsMatchedHob(                                                                  \
+          (user_op::HobDeviceTag() == "cpu")                                             \
+          & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)                  \
+          & (user_op::HobAttr<std::string>("interpolation") == std::string("nearest"))); \
+  REGISTER_USER_KERNEL("upsample_grad")                                                  \
+      .SetCreateFn<UpsampleNearestGradCPUKernel<dtype>>()                                \
+      .SetIsMatchedHob(                                                                  \
+          (user_op::HobDeviceTag() == "cpu")                                             \
+          & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value)                 \
+          & (user_op::HobAttr<std::string>("interpolation") == std::string("nearest")));
+
+REGISTER_UPSAMPLE_NEAREST_CPU_KERNEL(float)
+REGISTER_UPSAMPLE_NEAREST_CPU_KERNEL(double)
+
+template<typename T>
+class UpsampleBilinearCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleBilinearCPUKernel() = default;
+  ~UpsampleBilinearCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x_blob = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* y_blob = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const bool align_corners = ctx->Attr<bool>("align_corners");
+    const UpsampleDims dims(x_blob->shape(), y_blob->shape(),
+                            ctx->Attr<std::string>("data_format"));
+    const std::vector<LinearTap<T>> h_table = GetLinearTapTable<T>(
+        dims.in_height, dims.out_height, align_corners, ctx->Attr<float>("height_scale"));
+    const std::vector<LinearTap<T>> w_table = GetLinearTapTable<T>(
+        dims.in_width, dims.out_width, align_corners, ctx->Attr<float>("width_scale"));
+    UpsampleBilinearForward<T>(dims, h_table, w_table, x_blob->dptr<T>(), y_blob->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class UpsampleBilinearGradCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleBilinearGradCPUKernel() = default;
+  ~UpsampleBilinearGradCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    user_op::Tensor* dx_blob = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    if (dx_blob == nullptr) { return; }
+    Memset<DeviceType::kCPU>(ctx->device_ctx(), dx_blob->mut_dptr<T>(), 0,
+                             dx_blob->shape().elem_cnt() * sizeof(T));
+    const user_op::Tensor* dy_blob = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const bool align_corners = ctx->Attr<bool>("align_corners");
+    const UpsampleDims dims(dx_blob->shape(), dy_blob->shape(),
+                            ctx->Attr<std::string>("data_format"));
+    const std::vector<LinearTap<T>> h_table = GetLinearTapTable<T>(
+        dims.in_height, dims.out_height, align_corners, ctx->Attr<float>("height_scale"));
+    const std::vector<LinearTap<T>> w_table = GetLinearTapTable<T>(
+        dims.in_width, dims.out_width, align_corners, ctx->Attr<float>("width_scale"));
+    UpsampleBilinearBackward<T>(dims, h_table, w_table, dy_blob->dptr<T>(),
+                                dx_blob->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_UPSAMPLE_BILINEAR_CPU_KERNEL(dtype)                                      \
+  REGISTER_USER_KERNEL("upsample")                                                        \
+      .SetCreateFn<UpsampleBilinearCPUKernel<dtype>>()                                    \
+      .SetIsMatchedHob(                                                                   \
+          (user_op::HobDeviceTag() == "cpu")                                              \
+          & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)                   \
+          & (user_op::HobAttr<std::string>("interpolation") == std::string("bilinear"))); \
+  REGISTER_USER_KERNEL("upsample_grad")                                                   \
+      .SetCreateFn<UpsampleBilinearGradCPUKernel<dtype>>()                                \
+      .SetIsMatchedHob(                                                                   \
+          (user_op::HobDeviceTag() == "cpu")                                              \
+          & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value)                  \
+          & (user_op::HobAttr<std::string>("interpolation") == std::string("bilinear")));
+
+REGISTER_UPSAMPLE_BILINEAR_CPU_KERNEL(float)
+REGISTER_UPSAMPLE_BILINEAR_CPU_KERNEL(double)
+
+}  // namespace oneflow
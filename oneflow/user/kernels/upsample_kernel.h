@@ -0,0 +1,43 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_UPSAMPLE_KERNEL_H_
+#define ONEFLOW_USER_KERNELS_UPSAMPLE_KERNEL_H_
+
+#include "oneflow/core/common/data_type.h"
+
+namespace oneflow {
+
+template<typename T>
+OF_DEVICE_FUNC T GetAreaPixelScale(const int64_t input_size, const int64_t output_size,
+                                   bool align_corners, const T scale) {
+  return align_corners ? static_cast<T>(input_size - 1) / (output_size - 1)
+                       : (scale > 0. ? 1.0 / scale : static_cast<T>(input_size) / output_size);
+}
+
+template<typename T>
+OF_DEVICE_FUNC T GetAreaPixelSourceIndex(const T scale, const int64_t dst_index,
+                                         bool align_corners) {
+  if (align_corners) {
+    return scale * static_cast<T>(dst_index);
+  } else {
+    T src_index = (static_cast<T>(dst_index) + 0.5f) * scale - 0.5f;
+    return (src_index < 0) ? 0 : src_index;
+  }
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_UPSAMPLE_KERNEL_H_
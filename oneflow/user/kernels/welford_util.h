@@ -0,0 +1,82 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_WELFORD_UTIL_H_
+#define ONEFLOW_USER_KERNELS_WELFORD_UTIL_H_
+
+#include <cstdint>
+
+namespace oneflow {
+
+// Independent accumulators of a reduction, which the compiler vectorizes as they are.
+constexpr int64_t kNumWelfordLanes = 8;
+
+template<typename T>
+struct WelfordStat {
+  T mean;
+  T m2;
+  int64_t count;
+};
+
+// Merges other into stat with Chan's formula.
+template<typename T>
+inline void WelfordMerge(const WelfordStat<T>& other, WelfordStat<T>* stat) {
+  if (other.count == 0) { return; }
+  if (stat->count == 0) {
+    *stat = other;
+    return;
+  }
+  const int64_t count = stat->count + other.count;
+  const T delta = other.mean - stat->mean;
+  const T ratio = static_cast<T>(other.count) / static_cast<T>(count);
+  stat->mean += delta * ratio;
+  stat->m2 += other.m2 + delta * delta * static_cast<T>(stat->count) * ratio;
+  stat->count = count;
+}
+
+// Welford's single pass mean and m2, the sum of squared deviations, of n contiguous elements.
+// Each lane runs its own recurrence over a strided slice, the lanes are then merged.
+template<typename T>
+inline WelfordStat<T> WelfordReduce(const int64_t n, const T* x) {
+  T lane_mean[kNumWelfordLanes] = {0};
+  T lane_m2[kNumWelfordLanes] = {0};
+  const int64_t num_steps = n / kNumWelfordLanes;
+  for (int64_t step = 0; step < num_steps; ++step) {
+    const T* x_step = x + step * kNumWelfordLanes;
+    const T inv_count = static_cast<T>(1) / static_cast<T>(step + 1);
+    for (int64_t l = 0; l < kNumWelfordLanes; ++l) {
+      const T delta = x_step[l] - lane_mean[l];
+      lane_mean[l] += delta * inv_count;
+      lane_m2[l] += delta * (x_step[l] - lane_mean[l]);
+    }
+  }
+  WelfordStat<T> stat{0, 0, 0};
+  if (num_steps > 0) {
+    for (int64_t l = 0; l < kNumWelfordLanes; ++l) {
+      WelfordMerge(WelfordStat<T>{lane_mean[l], lane_m2[l], num_steps}, &stat);
+    }
+  }
+  for (int64_t i = num_steps * kNumWelfordLanes; i < n; ++i) {
+    stat.count += 1;
+    const T delta = x[i] - stat.mean;
+    stat.mean += delta / static_cast<T>(stat.count);
+    stat.m2 += delta * (x[i] - stat.mean);
+  }
+  return stat;
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_WELFORD_UTIL_H_
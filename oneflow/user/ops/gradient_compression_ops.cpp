@@ -0,0 +1,129 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+// The compress ops take the partial sum of a gradient and give one compressed piece per rank,
+// the pieces are gathered by the boxing into every rank and summed up by the decompress ops.
+Maybe<void> GetCompressSbpSignatures(user_op::SbpContext* ctx) {
+  ctx->NewBuilder().PartialSum(ctx->inputs()).Split(ctx->outputs(), 0).Build();
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> GetDecompressSbpSignatures(user_op::SbpContext* ctx) {
+  ctx->NewBuilder().Broadcast(ctx->inputs()).Broadcast(ctx->outputs()).Build();
+  return Maybe<void>::Ok();
+}
+
+int64_t NumOneBitBytes(int64_t elem_cnt) { return RoundUp(elem_cnt, 8) / 8; }
+
+}  // namespace
+
+REGISTER_USER_OP("top_k_gradient_compress")
+    .Input("in")
+    .Output("values")
+    .Output("indices")
+    .Attr<int64_t>("k")
+    .SetLogicalTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const int64_t elem_cnt = ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape().elem_cnt();
+      const int64_t k = ctx->Attr<int64_t>("k");
+      CHECK_GT_OR_RETURN(k, 0);
+      CHECK_LE_OR_RETURN(k, elem_cnt);
+      CHECK_LE_OR_RETURN(elem_cnt, GetMaxVal<int32_t>());
+      *ctx->Shape4ArgNameAndIndex("values", 0) = Shape({ctx->parallel_num() * k});
+      *ctx->Shape4ArgNameAndIndex("indices", 0) = Shape({ctx->parallel_num() * k});
+      return Maybe<void>::Ok();
+    })
+    .SetPhysicalTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const int64_t k = ctx->Attr<int64_t>("k");
+      *ctx->Shape4ArgNameAndIndex("values", 0) = Shape({k});
+      *ctx->Shape4ArgNameAndIndex("indices", 0) = Shape({k});
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn(GetCompressSbpSignatures)
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      *ctx->Dtype4ArgNameAndIndex("values", 0) = *ctx->Dtype4ArgNameAndIndex("in", 0);
+      *ctx->Dtype4ArgNameAndIndex("indices", 0) = DataType::kInt32;
+      return Maybe<void>::Ok();
+    });
+
+REGISTER_USER_OP("top_k_gradient_decompress")
+    .Input("values")
+    .Input("indices")
+    .Output("out")
+    .Attr<Shape>("shape")
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const Shape& values_shape = ctx->TensorDesc4ArgNameAndIndex("values", 0)->shape();
+      CHECK_EQ_OR_RETURN(values_shape.NumAxes(), 1);
+      CHECK_EQ_OR_RETURN(ctx->TensorDesc4ArgNameAndIndex("indices", 0)->shape(), values_shape);
+      *ctx->Shape4ArgNameAndIndex("out", 0) = ctx->Attr<Shape>("shape");
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn(GetDecompressSbpSignatures)
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      CHECK_EQ_OR_RETURN(*ctx->Dtype4ArgNameAndIndex("indices", 0), DataType::kInt32);
+      *ctx->Dtype4ArgNameAndIndex("out", 0) = *ctx->Dtype4ArgNameAndIndex("values", 0);
+      return Maybe<void>::Ok();
+    });
+
+REGISTER_USER_OP("one_bit_gradient_compress")
+    .Input("in")
+    .Output("bits")
+    .Output("scale")
+    .SetLogicalTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const int64_t elem_cnt = ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape().elem_cnt();
+      *ctx->Shape4ArgNameAndIndex("bits", 0) =
+          Shape({ctx->parallel_num() * NumOneBitBytes(elem_cnt)});
+      *ctx->Shape4ArgNameAndIndex("scale", 0) = Shape({ctx->parallel_num()});
+      return Maybe<void>::Ok();
+    })
+    .SetPhysicalTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const int64_t elem_cnt = ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape().elem_cnt();
+      *ctx->Shape4ArgNameAndIndex("bits", 0) = Shape({NumOneBitBytes(elem_cnt)});
+      *ctx->Shape4ArgNameAndIndex("scale", 0) = Shape({1});
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn(GetCompressSbpSignatures)
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      *ctx->Dtype4ArgNameAndIndex("bits", 0) = DataType::kInt8;
+      *ctx->Dtype4ArgNameAndIndex("scale", 0) = *ctx->Dtype4ArgNameAndIndex("in", 0);
+      return Maybe<void>::Ok();
+    });
+
+REGISTER_USER_OP("one_bit_gradient_decompress")
+    .Input("bits")
+    .Input("scale")
+    .Output("out")
+    .Attr<Shape>("shape")
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const Shape& shape = ctx->Attr<Shape>("shape");
+      const int64_t num_pieces = ctx->TensorDesc4ArgNameAndIndex("scale", 0)->shape().elem_cnt();
+      CHECK_EQ_OR_RETURN(ctx->TensorDesc4ArgNameAndIndex("bits", 0)->shape().elem_cnt(),
+                         num_pieces * NumOneBitBytes(shape.elem_cnt()));
+      *ctx->Shape4ArgNameAndIndex("out", 0) = shape;
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn(GetDecompressSbpSignatures)
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      CHECK_EQ_OR_RETURN(*ctx->Dtype4ArgNameAndIndex("bits", 0), DataType::kInt8);
+      *ctx->Dtype4ArgNameAndIndex("out", 0) = *ctx->Dtype4ArgNameAndIndex("scale", 0);
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
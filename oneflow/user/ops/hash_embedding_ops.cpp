@@ -0,0 +1,192 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/job/job_desc.h"
+
+namespace oneflow {
+
+namespace {
+
+Maybe<void> CheckHashEmbeddingAttrs(const user_op::UserOpDefWrapper& def,
+                                    const user_op::UserOpConfWrapper& conf) {
+  CHECK_OR_RETURN(!conf.attr<std::string>("embedding_name").empty());
+  CHECK_GT_OR_RETURN(conf.attr<int64_t>("embedding_dim"), 0);
+  const std::string& combiner = conf.attr<std::string>("combiner");
+  CHECK_OR_RETURN(combiner == "none" || combiner == "sum" || combiner == "mean")
+      << "combiner must be one of none, sum and mean, but got " << combiner;
+  const std::string& optimizer = conf.attr<std::string>("optimizer");
+  CHECK_OR_RETURN(optimizer == "sgd" || optimizer == "adagrad")
+      << "optimizer must be one of sgd and adagrad, but got " << optimizer;
+  CHECK_LE_OR_RETURN(conf.attr<float>("init_min"), conf.attr<float>("init_max"));
+  CHECK_GE_OR_RETURN(conf.attr<int64_t>("ttl"), 0);
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> CheckHashEmbeddingUpdateAttrs(const user_op::UserOpDefWrapper& def,
+                                          const user_op::UserOpConfWrapper& conf) {
+  JUST(CheckHashEmbeddingAttrs(def, conf));
+  CHECK_GT_OR_RETURN(conf.attr<float>("loss_scale"), 0);
+  return Maybe<void>::Ok();
+}
+
+// The embeddings of ids of shape (N, ..., L) are of shape (N, ..., L, embedding_dim), or
+// (N, ..., embedding_dim) if the L ids of a bag are combined.
+Maybe<void> InferEmbeddingsShape(user_op::InferContext* ctx, const Shape& ids_shape,
+                                 Shape* embeddings_shape) {
+  DimVector dim_vec = ids_shape.dim_vec();
+  if (ctx->Attr<std::string>("combiner") != "none") {
+    CHECK_GE_OR_RETURN(ids_shape.NumAxes(), 2);
+    dim_vec.pop_back();
+  }
+  dim_vec.push_back(ctx->Attr<int64_t>("embedding_dim"));
+  *embeddings_shape = Shape(dim_vec);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+// Looks the ids up in the hash embedding table embedding_name, missing ids are inserted. The table
+// lives outside of the job, shadow is a variable of a single element which is only there to have
+// the backward built and to order the update of an iteration before the lookup of the next.
+REGISTER_USER_OP("hash_embedding_lookup")
+    .Input("ids")
+    .Input("shadow")
+    .Output("embeddings")
+    .Attr<std::string>("embedding_name")
+    .Attr<int64_t>("embedding_dim")
+    .Attr<std::string>("combiner", "none")
+    .Attr<std::string>("optimizer", "sgd")
+    .Attr<float>("learning_rate", 0.01)
+    .Attr<float>("epsilon", 1e-8)
+    .Attr<float>("init_min", -0.05)
+    .Attr<float>("init_max", 0.05)
+    .Attr<int64_t>("seed", 0)
+    .Attr<int64_t>("ttl", 0)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* ids = ctx->TensorDesc4ArgNameAndIndex("ids", 0);
+      CHECK_GT_OR_RETURN(ids->shape().NumAxes(), 0);
+      CHECK_EQ_OR_RETURN(ctx->TensorDesc4ArgNameAndIndex("shadow", 0)->shape().elem_cnt(), 1);
+      user_op::TensorDesc* embeddings = ctx->TensorDesc4ArgNameAndIndex("embeddings", 0);
+      JUST(InferEmbeddingsShape(ctx, ids->shape(), embeddings->mut_shape()));
+      embeddings->set_is_dynamic(ids->is_dynamic());
+      return Maybe<void>::Ok();
+    })
+    .SetInputArgModifyFn([](user_op::GetInputArgModifier GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper&) {
+      user_op::InputArgModifier* ids_modifier = GetInputArgModifierFn("ids", 0);
+      CHECK(ids_modifier != nullptr);
+      ids_modifier->set_requires_grad(false);
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder()
+          .Split(user_op::OpArg("ids", 0), 0)
+          .Broadcast(user_op::OpArg("shadow", 0))
+          .Split(user_op::OpArg("embeddings", 0), 0)
+          .Build();
+      return Maybe<void>::Ok();
+    })
+    .SetCheckAttrFn(CheckHashEmbeddingAttrs)
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      CHECK_OR_RETURN(IsIndexDataType(*ctx->Dtype4ArgNameAndIndex("ids", 0)));
+      CHECK_EQ_OR_RETURN(*ctx->Dtype4ArgNameAndIndex("shadow", 0), DataType::kFloat);
+      *ctx->Dtype4ArgNameAndIndex("embeddings", 0) = DataType::kFloat;
+      return Maybe<void>::Ok();
+    });
+
+// Applies embedding_diff divided by loss_scale to the rows of the ids in the table, shadow_diff is
+// all zeros.
+REGISTER_USER_OP("hash_embedding_update")
+    .Input("ids")
+    .Input("embedding_diff")
+    .Input("shadow")
+    .Output("shadow_diff")
+    .Attr<std::string>("embedding_name")
+    .Attr<int64_t>("embedding_dim")
+    .Attr<std::string>("combiner", "none")
+    .Attr<std::string>("optimizer", "sgd")
+    .Attr<float>("learning_rate", 0.01)
+    .Attr<float>("epsilon", 1e-8)
+    .Attr<float>("init_min", -0.05)
+    .Attr<float>("init_max", 0.05)
+    .Attr<int64_t>("seed", 0)
+    .Attr<int64_t>("ttl", 0)
+    .Attr<float>("loss_scale", 1)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      Shape embeddings_shape;
+      JUST(InferEmbeddingsShape(ctx, *ctx->Shape4ArgNameAndIndex("ids", 0), &embeddings_shape));
+      CHECK_EQ_OR_RETURN(*ctx->Shape4ArgNameAndIndex("embedding_diff", 0), embeddings_shape);
+      *ctx->TensorDesc4ArgNameAndIndex("shadow_diff", 0) =
+          *ctx->TensorDesc4ArgNameAndIndex("shadow", 0);
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder()
+          .Split(user_op::OpArg("ids", 0), 0)
+          .Split(user_op::OpArg("embedding_diff", 0), 0)
+          .Broadcast(user_op::OpArg("shadow", 0))
+          .PartialSum(user_op::OpArg("shadow_diff", 0))
+          .Build();
+      return Maybe<void>::Ok();
+    })
+    .SetCheckAttrFn(CheckHashEmbeddingUpdateAttrs)
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      CHECK_OR_RETURN(IsIndexDataType(*ctx->Dtype4ArgNameAndIndex("ids", 0)));
+      CHECK_EQ_OR_RETURN(*ctx->Dtype4ArgNameAndIndex("embedding_diff", 0), DataType::kFloat);
+      *ctx->Dtype4ArgNameAndIndex("shadow_diff", 0) = *ctx->Dtype4ArgNameAndIndex("shadow", 0);
+      return Maybe<void>::Ok();
+    });
+
+REGISTER_USER_OP_GRAD("hash_embedding_lookup")
+    .SetGenBackwardOpConfFn([](const user_op::UserOpWrapper& op, user_op::AddOpFn AddOp) {
+      if (op.NeedGenGradTensor4OpInput("shadow", 0)) {
+        // The table is updated here rather than by the optimizer, so the loss scale is undone
+        // by the update itself. The dynamic loss scale is only known when the variables are
+        // updated, and the table can't hold the diffs of the accumulated micro batches.
+        const JobConfigProto& job_conf = GlobalJobDesc().job_conf();
+        const TrainConf& train_conf = job_conf.train_conf();
+        CHECK(!train_conf.has_dynamic_loss_scale_policy())
+            << "hash_embedding " << op.attr<std::string>("embedding_name")
+            << " can't be trained with a dynamic loss scale";
+        CHECK_LE(job_conf.num_gradient_accumulation_steps(), 1)
+            << "hash_embedding " << op.attr<std::string>("embedding_name")
+            << " can't be trained with gradient accumulation";
+        const float loss_scale =
+            train_conf.has_loss_scale_factor() ? train_conf.loss_scale_factor() : 1.0f;
+        user_op::UserOpConfWrapperBuilder builder(op.op_name() + "_update");
+        user_op::UserOpConfWrapper update_op =
+            builder.Op("hash_embedding_update")
+                .Input("ids", op.input("ids", 0))
+                .Input("embedding_diff", op.GetGradTensorWithOpOutput("embeddings", 0))
+                .Input("shadow", op.input("shadow", 0))
+                .Output("shadow_diff")
+                .Attr("embedding_name", op.attr<std::string>("embedding_name"))
+                .Attr("embedding_dim", op.attr<int64_t>("embedding_dim"))
+                .Attr("combiner", op.attr<std::string>("combiner"))
+                .Attr("optimizer", op.attr<std::string>("optimizer"))
+                .Attr("learning_rate", op.attr<float>("learning_rate"))
+                .Attr("epsilon", op.attr<float>("epsilon"))
+                .Attr("init_min", op.attr<float>("init_min"))
+                .Attr("init_max", op.attr<float>("init_max"))
+                .Attr("seed", op.attr<int64_t>("seed"))
+                .Attr("ttl", op.attr<int64_t>("ttl"))
+                .Attr("loss_scale", loss_scale)
+                .Build();
+        op.BindGradTensorWithOpInput(update_op.output("shadow_diff", 0), "shadow", 0);
+        AddOp(update_op);
+      }
+    });
+
+}  // namespace oneflow
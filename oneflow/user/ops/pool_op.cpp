@@ -45,11 +45,21 @@ TensorDescInferFn MakeFwTensorDescInferFn(const int32_t dim) {
     user_op::TensorDesc* y_desc = ctx->TensorDesc4ArgNameAndIndex("y", 0);
     *y_desc->mut_shape() = params_3d.GetYShape();
     *y_desc->mut_is_dynamic() = *ctx->IsDynamic4ArgNameAndIndex("x", 0);
+    if (ctx->has_output("indice", 0)) {
+      // the argmax of every window as the offset into the spatial dims of its image and channel
+      const Shape x_shape_5d = params_3d.GetXShape5D();
+      CHECK_LE_OR_RETURN(x_shape_5d.Count(2), GetMaxVal<int32_t>());
+      *ctx->TensorDesc4ArgNameAndIndex("indice", 0) = *y_desc;
+    }
     return Maybe<void>::Ok();
   };
 }
 
 Maybe<void> BwTensorDescInferFn(user_op::InferContext* ctx) {
+  if (ctx->has_input("indice", 0)) {
+    CHECK_EQ_OR_RETURN(*ctx->Shape4ArgNameAndIndex("indice", 0),
+                       *ctx->Shape4ArgNameAndIndex("y", 0));
+  }
   *ctx->Shape4ArgNameAndIndex("dx", 0) = *ctx->Shape4ArgNameAndIndex("x", 0);
   *ctx->IsDynamic4ArgNameAndIndex("dx", 0) = *ctx->IsDynamic4ArgNameAndIndex("x", 0);
   return Maybe<void>::Ok();
@@ -57,10 +67,14 @@ Maybe<void> BwTensorDescInferFn(user_op::InferContext* ctx) {
 
 Maybe<void> FwInferDataType(user_op::InferContext* ctx) {
   *ctx->Dtype4ArgNameAndIndex("y", 0) = *ctx->Dtype4ArgNameAndIndex("x", 0);
+  if (ctx->has_output("indice", 0)) { *ctx->Dtype4ArgNameAndIndex("indice", 0) = DataType::kInt32; }
   return Maybe<void>::Ok();
 }
 
 Maybe<void> BwInferDataType(user_op::InferContext* ctx) {
+  if (ctx->has_input("indice", 0)) {
+    CHECK_EQ_OR_RETURN(*ctx->Dtype4ArgNameAndIndex("indice", 0), DataType::kInt32);
+  }
   *ctx->Dtype4ArgNameAndIndex("dx", 0) = *ctx->Dtype4ArgNameAndIndex("x", 0);
   return Maybe<void>::Ok();
 }
@@ -68,7 +82,7 @@ Maybe<void> BwInferDataType(user_op::InferContext* ctx) {
 Maybe<void> FwGetSbpFn(user_op::SbpContext* ctx) {
   const user_op::TensorDesc& tensor = ctx->LogicalTensorDesc4InputArgNameAndIndex("x", 0);
   FOR_RANGE(int64_t, i, 0, tensor.shape().NumAxes()) {
-    ctx->NewBuilder().Split(user_op::OpArg("x", 0), i).Split(user_op::OpArg("y", 0), i).Build();
+    ctx->NewBuilder().Split(ctx->inputs(), i).Split(ctx->outputs(), i).Build();
   }
   return Maybe<void>::Ok();
 }
@@ -76,12 +90,7 @@ Maybe<void> FwGetSbpFn(user_op::SbpContext* ctx) {
 Maybe<void> BwGetSbpFn(user_op::SbpContext* ctx) {
   const user_op::TensorDesc& tensor = ctx->LogicalTensorDesc4InputArgNameAndIndex("x", 0);
   FOR_RANGE(int64_t, i, 0, tensor.shape().NumAxes()) {
-    ctx->NewBuilder()
-        .Split(user_op::OpArg("x", 0), i)
-        .Split(user_op::OpArg("y", 0), i)
-        .Split(user_op::OpArg("dy", 0), i)
-        .Split(user_op::OpArg("dx", 0), i)
-        .Build();
+    ctx->NewBuilder().Split(ctx->inputs(), i).Split(ctx->outputs(), i).Build();
   }
   return Maybe<void>::Ok();
 }
@@ -90,9 +99,12 @@ GenBackwardOpConfFn MakeGenBackwardOpConfFn(const std::string& mode, const int32
   return [mode, dim](const user_op::UserOpWrapper& op, user_op::AddOpFn AddOp) {
     if (op.NeedGenGradTensor4OpInput("x", 0)) {
       user_op::UserOpConfWrapperBuilder builder(op.op_name() + "_grad");
+      builder.Op(mode + "_pool_" + std::to_string(dim) + "d_grad");
+      if (op.user_op_conf().has_output("indice", 0)) {
+        builder.Input("indice", op.output("indice", 0));
+      }
       user_op::UserOpConfWrapper grad_op =
-          builder.Op(mode + "_pool_" + std::to_string(dim) + "d_grad")
-              .Input("x", op.input("x", 0))
+          builder.Input("x", op.input("x", 0))
               .Input("y", op.output("y", 0))
               .Input("dy", op.GetGradTensorWithOpOutput("y", 0))
               .Output("dx")
@@ -211,6 +223,7 @@ REGISTER_USER_OP_GRAD("avg_pool_3d").SetGenBackwardOpConfFn(MakeGenBackwardOpCon
 REGISTER_USER_OP("max_pool_1d")
     .Input("x")
     .Output("y")
+    .OptionalOutput("indice")
     .Attr<std::string>("padding")
     .Attr<std::vector<int32_t>>("padding_before")
     .Attr<std::vector<int32_t>>("padding_after")
@@ -226,6 +239,7 @@ REGISTER_USER_OP("max_pool_1d_grad")
     .Input("x")
     .Input("y")
     .Input("dy")
+    .OptionalInput("indice")
     .Output("dx")
     .Attr<std::string>("padding")
     .Attr<std::vector<int32_t>>("padding_before")
@@ -243,6 +257,7 @@ REGISTER_USER_OP_GRAD("max_pool_1d").SetGenBackwardOpConfFn(MakeGenBackwardOpCon
 REGISTER_USER_OP("max_pool_2d")
     .Input("x")
     .Output("y")
+    .OptionalOutput("indice")
     .Attr<std::string>("padding")
     .Attr<std::vector<int32_t>>("padding_before")
     .Attr<std::vector<int32_t>>("padding_after")
@@ -258,6 +273,7 @@ REGISTER_USER_OP("max_pool_2d_grad")
     .Input("x")
     .Input("y")
     .Input("dy")
+    .OptionalInput("indice")
     .Output("dx")
     .Attr<std::string>("padding")
     .Attr<std::vector<int32_t>>("padding_before")
@@ -275,6 +291,7 @@ REGISTER_USER_OP_GRAD("max_pool_2d").SetGenBackwardOpConfFn(MakeGenBackwardOpCon
 REGISTER_USER_OP("max_pool_3d")
     .Input("x")
     .Output("y")
+    .OptionalOutput("indice")
     .Attr<std::string>("padding")
     .Attr<std::vector<int32_t>>("padding_before")
     .Attr<std::vector<int32_t>>("padding_after")
@@ -290,6 +307,7 @@ REGISTER_USER_OP("max_pool_3d_grad")
     .Input("x")
     .Input("y")
     .Input("dy")
+    .OptionalInput("indice")
     .Output("dx")
     .Attr<std::string>("padding")
     .Attr<std::vector<int32_t>>("padding_before")
@@ -0,0 +1,178 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/ops/nn_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// The float inputs are quantized by the kernels with the scales and zero points of the observers
+// of quantization aware training, the result is dequantized to float.
+Maybe<void> CheckQuantizationParams(user_op::InferContext* ctx, int64_t num_channels) {
+  const Shape* in_scale_shape = ctx->Shape4ArgNameAndIndex("in_scale", 0);
+  const Shape* in_zero_point_shape = ctx->Shape4ArgNameAndIndex("in_zero_point", 0);
+  CHECK_EQ_OR_RETURN(in_scale_shape->elem_cnt(), 1);
+  CHECK_EQ_OR_RETURN(in_zero_point_shape->elem_cnt(), 1);
+  const Shape* weight_scale_shape = ctx->Shape4ArgNameAndIndex("weight_scale", 0);
+  const Shape* weight_zero_point_shape = ctx->Shape4ArgNameAndIndex("weight_zero_point", 0);
+  CHECK_OR_RETURN(weight_scale_shape->elem_cnt() == 1
+                  || weight_scale_shape->elem_cnt() == num_channels);
+  CHECK_EQ_OR_RETURN(weight_zero_point_shape->elem_cnt(), weight_scale_shape->elem_cnt());
+  if (ctx->has_input("bias", 0)) {
+    CHECK_EQ_OR_RETURN(*ctx->Shape4ArgNameAndIndex("bias", 0), Shape({num_channels}));
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> CheckQuantizationAttr(const user_op::UserOpDefWrapper& def,
+                                  const user_op::UserOpConfWrapper& conf) {
+  CHECK_EQ_OR_RETURN(conf.attr<int32_t>("quantization_bit"), 8);
+  const std::string& quantization_scheme = conf.attr<std::string>("quantization_scheme");
+  CHECK_OR_RETURN(quantization_scheme == "symmetric" || quantization_scheme == "affine");
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferQuantizedConv2dTensorDesc(user_op::InferContext* ctx) {
+  const Shape* in_shape = ctx->Shape4ArgNameAndIndex("in", 0);
+  const Shape* weight_shape = ctx->Shape4ArgNameAndIndex("weight", 0);
+  CHECK_EQ_OR_RETURN(in_shape->NumAxes(), 4);
+  CHECK_EQ_OR_RETURN(weight_shape->NumAxes(), 4);
+  const std::string& data_format = ctx->Attr<std::string>("data_format");
+  const auto& kernel_size = ctx->Attr<std::vector<int32_t>>("kernel_size");
+  const auto& padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
+  const auto& strides = ctx->Attr<std::vector<int32_t>>("strides");
+  const auto& dilation_rate = ctx->Attr<std::vector<int32_t>>("dilation_rate");
+  const int32_t filters = ctx->Attr<int32_t>("filters");
+  CHECK_EQ_OR_RETURN(kernel_size.size(), 2);
+  CHECK_EQ_OR_RETURN(padding_before.size(), 2);
+  CHECK_EQ_OR_RETURN(strides.size(), 2);
+  CHECK_EQ_OR_RETURN(dilation_rate.size(), 2);
+  const size_t idx_offset = IdxOffset(data_format);
+  const size_t c_dim = data_format == "channels_first" ? 1 : 3;
+  DimVector weight_dim_vec(in_shape->dim_vec());
+  weight_dim_vec.at(0) = filters;
+  FOR_RANGE(size_t, i, 0, 2) { weight_dim_vec.at(idx_offset + i) = kernel_size.at(i); }
+  CHECK_EQ_OR_RETURN(*weight_shape, Shape(weight_dim_vec));
+  DimVector out_dim_vec(4);
+  out_dim_vec.at(0) = in_shape->At(0);
+  out_dim_vec.at(c_dim) = filters;
+  FOR_RANGE(size_t, i, 0, 2) {
+    CalcConvOut(in_shape->At(idx_offset + i), kernel_size.at(i), dilation_rate.at(i),
+                strides.at(i), padding_before.at(i), &out_dim_vec.at(idx_offset + i));
+  }
+  JUST(CheckQuantizationParams(ctx, filters));
+  *ctx->Shape4ArgNameAndIndex("out", 0) = Shape(out_dim_vec);
+  *ctx->IsDynamic4ArgNameAndIndex("out", 0) = *ctx->IsDynamic4ArgNameAndIndex("in", 0);
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferQuantizedMatmulTensorDesc(user_op::InferContext* ctx) {
+  const Shape* a_shape = ctx->Shape4ArgNameAndIndex("a", 0);
+  const Shape* b_shape = ctx->Shape4ArgNameAndIndex("b", 0);
+  CHECK_EQ_OR_RETURN(a_shape->NumAxes(), 2);
+  CHECK_EQ_OR_RETURN(b_shape->NumAxes(), 2);
+  const bool transpose_a = ctx->Attr<bool>("transpose_a");
+  const bool transpose_b = ctx->Attr<bool>("transpose_b");
+  const int64_t m = transpose_a ? a_shape->At(1) : a_shape->At(0);
+  const int64_t k = transpose_a ? a_shape->At(0) : a_shape->At(1);
+  CHECK_EQ_OR_RETURN(k, transpose_b ? b_shape->At(1) : b_shape->At(0));
+  const int64_t n = transpose_b ? b_shape->At(0) : b_shape->At(1);
+  // Per-channel weight scales are along the first axis of b, which has to be the output channels.
+  const Shape* weight_scale_shape = ctx->Shape4ArgNameAndIndex("weight_scale", 0);
+  CHECK_OR_RETURN(weight_scale_shape->elem_cnt() == 1 || transpose_b);
+  JUST(CheckQuantizationParams(ctx, n));
+  *ctx->Shape4ArgNameAndIndex("out", 0) = Shape({m, n});
+  *ctx->IsDynamic4ArgNameAndIndex("out", 0) = *ctx->IsDynamic4ArgNameAndIndex("a", 0);
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> GetQuantizedSbpSignatures(user_op::SbpContext* ctx, const std::string& data_ibn,
+                                      int64_t data_split_axis) {
+  std::vector<std::pair<std::string, int32_t>> broadcast_args;
+  for (const auto& pair : ctx->inputs()) {
+    if (pair.first != data_ibn) { broadcast_args.push_back(pair); }
+  }
+  ctx->NewBuilder()
+      .Split(user_op::OpArg(data_ibn, 0), data_split_axis)
+      .Broadcast(broadcast_args)
+      .Split(user_op::OpArg("out", 0), 0)
+      .Build();
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferQuantizedDataType(user_op::InferContext* ctx, const std::string& data_ibn) {
+  const DataType data_type = *ctx->Dtype4ArgNameAndIndex(data_ibn, 0);
+  CHECK_EQ_OR_RETURN(data_type, DataType::kFloat);
+  for (const auto& ibn : {"in_scale", "in_zero_point", "weight_scale", "weight_zero_point"}) {
+    CHECK_EQ_OR_RETURN(*ctx->Dtype4ArgNameAndIndex(ibn, 0), data_type);
+  }
+  *ctx->Dtype4ArgNameAndIndex("out", 0) = data_type;
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_USER_OP("quantized_conv2d")
+    .Input("in")
+    .Input("weight")
+    .Input("in_scale")
+    .Input("in_zero_point")
+    .Input("weight_scale")
+    .Input("weight_zero_point")
+    .OptionalInput("bias")
+    .Output("out")
+    .Attr<int32_t>("filters")
+    .Attr<std::vector<int32_t>>("padding_before")
+    .Attr<std::string>("data_format")
+    .Attr<std::vector<int32_t>>("kernel_size")
+    .Attr<std::vector<int32_t>>("strides")
+    .Attr<std::vector<int32_t>>("dilation_rate")
+    .Attr<int32_t>("quantization_bit", 8)
+    .Attr<std::string>("quantization_scheme", "symmetric")
+    .SetCheckAttrFn(CheckQuantizationAttr)
+    .SetTensorDescInferFn(InferQuantizedConv2dTensorDesc)
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      return GetQuantizedSbpSignatures(ctx, "in", 0);
+    })
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferQuantizedDataType(ctx, "in");
+    });
+
+REGISTER_USER_OP("quantized_matmul")
+    .Input("a")
+    .Input("b")
+    .Input("in_scale")
+    .Input("in_zero_point")
+    .Input("weight_scale")
+    .Input("weight_zero_point")
+    .OptionalInput("bias")
+    .Output("out")
+    .Attr<bool>("transpose_a", false)
+    .Attr<bool>("transpose_b", false)
+    .Attr<double>("alpha", 1.0)
+    .Attr<int32_t>("quantization_bit", 8)
+    .Attr<std::string>("quantization_scheme", "symmetric")
+    .SetCheckAttrFn(CheckQuantizationAttr)
+    .SetTensorDescInferFn(InferQuantizedMatmulTensorDesc)
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      return GetQuantizedSbpSignatures(ctx, "a", ctx->Attr<bool>("transpose_a") ? 1 : 0);
+    })
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferQuantizedDataType(ctx, "a");
+    });
+
+}  // namespace oneflow
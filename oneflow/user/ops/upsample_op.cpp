@@ -17,6 +17,24 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+// The axes of the height and the width of an upsample blob, which is NCHW for "channels_first" and
+// NHWC for "channels_last".
+std::pair<int64_t, int64_t> GetUpsampleHeightWidthAxes(const std::string& data_format,
+                                                       const int64_t num_axes) {
+  if ((data_format != "channels_first" && data_format != "channels_last") || num_axes != 4) {
+    LOG(FATAL) << "upsample only supports NCHW and NHWC";
+  }
+  if (data_format == "channels_first") {
+    return std::make_pair(2, 3);
+  } else {
+    return std::make_pair(1, 2);
+  }
+}
+
+}  // namespace
+
 REGISTER_USER_OP("upsample")
     .Input("x")
     .Output("y")
@@ -30,13 +48,14 @@ REGISTER_USER_OP("upsample")
       user_op::TensorDesc* y_desc = ctx->TensorDesc4ArgNameAndIndex("y", 0);
       const float height_scale = ctx->Attr<float>("height_scale");
       const float width_scale = ctx->Attr<float>("width_scale");
-      if (ctx->Attr<std::string>("data_format") != "channels_first"
-          || x_desc->shape().NumAxes() != 4) {
-        LOG(FATAL) << "upsample only supports NCHW";
-      }
-      *y_desc->mut_shape() = Shape({x_desc->shape().At(0), x_desc->shape().At(1),
-                                    static_cast<int32_t>(height_scale * x_desc->shape().At(2)),
-                                    static_cast<int32_t>(width_scale * x_desc->shape().At(3))});
+      const auto h_w_axes = GetUpsampleHeightWidthAxes(ctx->Attr<std::string>("data_format"),
+                                                       x_desc->shape().NumAxes());
+      Shape y_shape = x_desc->shape();
+      y_shape.Set(h_w_axes.first,
+                  static_cast<int32_t>(height_scale * x_desc->shape().At(h_w_axes.first)));
+      y_shape.Set(h_w_axes.second,
+                  static_cast<int32_t>(width_scale * x_desc->shape().At(h_w_axes.second)));
+      *y_desc->mut_shape() = y_shape;
       return Maybe<void>::Ok();
     })
     .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
@@ -61,12 +80,13 @@ REGISTER_USER_OP("upsample_grad")
       Shape* dx_shape = ctx->Shape4ArgNameAndIndex("dx", 0);
       const float height_scale = ctx->Attr<float>("height_scale");
       const float width_scale = ctx->Attr<float>("width_scale");
-      if (ctx->Attr<std::string>("data_format") != "channels_first" || dy_shape->NumAxes() != 4) {
-        LOG(FATAL) << "upsample_nearest only supports NCHW";
-      }
-      *dx_shape = Shape({dy_shape->At(0), dy_shape->At(1),
-                         static_cast<int32_t>(dy_shape->At(2) / height_scale),
-                         static_cast<int32_t>(dy_shape->At(3) / width_scale)});
+      const auto h_w_axes =
+          GetUpsampleHeightWidthAxes(ctx->Attr<std::string>("data_format"), dy_shape->NumAxes());
+      *dx_shape = *dy_shape;
+      dx_shape->Set(h_w_axes.first,
+                    static_cast<int32_t>(dy_shape->At(h_w_axes.first) / height_scale));
+      dx_shape->Set(h_w_axes.second,
+                    static_cast<int32_t>(dy_shape->At(h_w_axes.second) / width_scale));
       return Maybe<void>::Ok();
     })
     .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
@@ -41,6 +41,8 @@ DEFINE_bool(strict_clustering, EnvToBool(FLAGS_strict_clustering, true),
 //               "valid, Default means using no engine.");
 DEFINE_bool(use_xla_jit, EnvToBool(FLAGS_use_xla_jit, false), "It's optional to use xla jit.");
 DEFINE_bool(use_tensorrt, EnvToBool(FLAGS_use_tensorrt, false), "It's optional to use tensorrt.");
+DEFINE_bool(use_cpu_fusion, EnvToBool(FLAGS_use_cpu_fusion, false),
+            "It's optional to use the native cpu fusion engine.");
 
 DEFINE_bool(tensorrt_fp16, EnvToBool(FLAGS_tensorrt_fp16, false),
             "Enable fp16 precision for TENSORRT engine.");
@@ -76,6 +78,9 @@ static std::unordered_map<std::string, std::string> user_op_type_name2string_map
     {"broadcast_mul", "BcastMul"},
     {"broadcast_div", "BcastDiv"},
     {"broadcast_min", "BcastMin"},
+    {"broadcast_minimum", "BcastMin"},
+    {"broadcast_maximum", "BcastMax"},
+    {"broadcast_sub", "BcastSub"},
     {"cast", "Cast"},
     {"concat", "Concat"},
     {"conv2d", "Conv2D"},
@@ -86,6 +91,7 @@ static std::unordered_map<std::string, std::string> user_op_type_name2string_map
     {"avg_pool_2d", "AveragePooling2D"},
     {"reduce_sum", "ReduceSum"},
     {"reduce_mean", "ReduceMean"},
+    {"reduce_max", "ReduceMax"},
     {"reshape", "Reshape"},
     {"reshape_like", "ReshapeLike"},
     {"softmax", "Softmax"},
@@ -102,6 +108,13 @@ static std::unordered_map<std::string, std::string> user_op_type_name2string_map
     {"leaky_relu", "LeakyRelu"},
     {"adam_update", "AdamOptimizer"},
     {"rsqrt", "Rsqrt"},
+    {"sqrt", "Sqrt"},
+    {"square", "Square"},
+    {"exp", "Exp"},
+    {"log", "Log"},
+    {"abs", "Abs"},
+    {"negative", "Negative"},
+    {"dropout", "Dropout"},
     {"square_sum", "SquareSum"},
 };
 
@@ -157,6 +170,8 @@ XrtEngine StringToXrtEngine(const std::string& engine) {
     return xrt::XrtEngine::XLA;
   } else if (engine == "TENSORRT") {
     return xrt::XrtEngine::TENSORRT;
+  } else if (engine == "FUSION") {
+    return xrt::XrtEngine::FUSION;
   } else {
     LOG(FATAL) << "Unknown engine: " << engine;
   }
@@ -190,6 +205,7 @@ std::shared_ptr<XrtGraph> BuildXrtGraph(const XrtLaunchOpConf::Function& functio
 void InitXrtConfigurations(const XrtConfig& config) {
   if (config.has_use_xla_jit()) { FLAGS_use_xla_jit = config.use_xla_jit(); }
   if (config.has_use_tensorrt()) { FLAGS_use_tensorrt = config.use_tensorrt(); }
+  if (config.has_use_cpu_fusion()) { FLAGS_use_cpu_fusion = config.use_cpu_fusion(); }
   // Set xla configurations.
   if (config.has_tensorrt_config()) {
     const XrtConfig::TensorRTConfig& trt_config = config.tensorrt_config();
@@ -203,7 +219,9 @@ void InitXrtConfigurations(const XrtConfig& config) {
   }
 }
 
-bool XrtCompilationEnabled() { return FLAGS_use_xla_jit || FLAGS_use_tensorrt; }
+bool XrtCompilationEnabled() {
+  return FLAGS_use_xla_jit || FLAGS_use_tensorrt || FLAGS_use_cpu_fusion;
+}
 
 XrtPassOptions CreateDefaultXrtPassOptions(bool train_phase) {
   ClusteringOptions options;
@@ -216,6 +234,7 @@ XrtPassOptions CreateDefaultXrtPassOptions(bool train_phase) {
   options.engine = (1U << XrtEngineOptionBit::kUseDefault);
   if (FLAGS_use_xla_jit) { options.engine |= (1U << XrtEngineOptionBit::kUseXlaJit); }
   if (FLAGS_use_tensorrt) { options.engine |= (1U << XrtEngineOptionBit::kUseTensorRT); }
+  if (FLAGS_use_cpu_fusion) { options.engine |= (1U << XrtEngineOptionBit::kUseFusion); }
 
   XrtPassOptions xrt_options;
   xrt_options.clustering_options = options;
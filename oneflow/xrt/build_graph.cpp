@@ -37,6 +37,12 @@ const SbpParallel& BlobSbpPolicy(const OpNode* op_node, const std::string& name)
   return op_node->SbpParallel4Lbi(lbi);
 }
 
+DataType BlobDataType(const OpNode* op_node, const std::string& name) {
+  CHECK_NOTNULL(op_node);
+  LogicalBlobId lbi = BlobNameToId(name);
+  return op_node->LogicalBlobDesc4Lbi(lbi).data_type();
+}
+
 GraphBuilder::GraphBuilder(const OpGraph* op_graph) : graph_(std::make_shared<XrtGraph>()) {
   op_graph->TopoForEachNode([&](const OpNode* op_node) {
     const Operator* op = &op_node->op();
@@ -131,6 +137,8 @@ void GraphBuilder::SetupGraphEdges() {
     sbp_policy.push_back(BlobSbpPolicy(src, name));
     sbp_policy.push_back(BlobSbpPolicy(dst, name));
     edge->Attr("sbp_policy", sbp_policy);
+    // Set data type
+    edge->Attr("data_type", BlobDataType(src, name));
   }
 }
 
@@ -13,7 +13,19 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#include <algorithm>
+#include <sstream>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+
 #include "oneflow/xrt/compilation_cache.h"
+#include "oneflow/xrt/utility/env.h"
+
+DEFINE_int64(xrt_compilation_cache_capacity, EnvToInt64(FLAGS_xrt_compilation_cache_capacity, 64),
+             "Maximum number of executables cached for each launch op, 0 means unlimited.");
+DEFINE_int64(xrt_compilation_cache_shards, EnvToInt64(FLAGS_xrt_compilation_cache_shards, 4),
+             "Number of independently locked shards of the compilation cache.");
 
 namespace oneflow {
 namespace xrt {
@@ -26,7 +38,11 @@ bool operator==(const Signature& lhs, const Signature& rhs) {
 size_t SignatureHash::operator()(const Signature& signature) const {
   size_t hash_val =
       std::hash<std::string>()(signature.builder_name) ^ std::hash<int>()(signature.device_ordinal);
-  for (const auto& shape : signature.entry_shapes) { hash_val ^= std::hash<Shape>()(shape); }
+  // Combine the shape hashes in order, the entries often share the same shape and would cancel
+  // each other out if they were simply xor-ed.
+  for (const auto& shape : signature.entry_shapes) {
+    hash_val ^= std::hash<Shape>()(shape) + 0x9e3779b9 + (hash_val << 6) + (hash_val >> 2);
+  }
   return hash_val;
 }
 
@@ -42,25 +58,89 @@ Signature ComputeSignature(const std::string& name, const int device_ordinal,
   return std::move(signature);
 }
 
-Executable* CompilationCache::GetRecord(const Signature& signature) const {
-  Executable* record = nullptr;
-  // std::shared_lock<std::shared_mutex> lock(mutex_);
-  std::lock_guard<std::mutex> lock(mutex_);
-  const auto& it = records_.find(signature);
-  if (it != records_.end()) { record = it->second.get(); }
-  return record;
+std::string CompilationCacheStats::ToString() const {
+  std::ostringstream ss;
+  ss << "hits: " << hits << ", misses: " << misses << ", evictions: " << evictions
+     << ", compilations: " << compilations << ", compile time: " << compile_time_us << "us";
+  return ss.str();
+}
+
+CompilationCache::CompilationCache()
+    : CompilationCache(FLAGS_xrt_compilation_cache_capacity, FLAGS_xrt_compilation_cache_shards) {}
+
+CompilationCache::CompilationCache(int64_t capacity, int64_t num_shards)
+    : shards_(std::max<int64_t>(num_shards, 1)) {
+  CHECK_GE(capacity, 0);
+  int64_t shard_num = shards_.size();
+  shard_capacity_ = capacity > 0 ? std::max<int64_t>((capacity + shard_num - 1) / shard_num, 1) : 0;
+}
+
+std::shared_ptr<Executable> CompilationCache::GetRecord(const Signature& signature,
+                                                        std::vector<Shape>* return_shapes) {
+  Shard* shard = ShardFor(signature);
+  std::lock_guard<std::mutex> lock(shard->mutex);
+  const auto& it = shard->records.find(signature);
+  if (it == shard->records.end()) {
+    ++shard->stats.misses;
+    return nullptr;
+  }
+  ++shard->stats.hits;
+  // Move the record to the front of the LRU list.
+  shard->lru.splice(shard->lru.begin(), shard->lru, it->second);
+  if (return_shapes != nullptr) { *return_shapes = it->second->return_shapes; }
+  return it->second->executable;
 }
 
 void CompilationCache::Record(const Signature& signature,
-                              const std::shared_ptr<Executable>& result) {
-  // std::unique_lock<std::shared_mutex> lock(mutex_);
-  std::lock_guard<std::mutex> lock(mutex_);
-  records_.emplace(signature, result);
+                              const std::shared_ptr<Executable>& result,
+                              int64_t compile_time_us, const std::vector<Shape>& return_shapes) {
+  Shard* shard = ShardFor(signature);
+  std::lock_guard<std::mutex> lock(shard->mutex);
+  ++shard->stats.compilations;
+  shard->stats.compile_time_us += compile_time_us;
+  const auto& it = shard->records.find(signature);
+  if (it != shard->records.end()) {
+    // Another thread compiled the same signature concurrently, keep the first record.
+    shard->lru.splice(shard->lru.begin(), shard->lru, it->second);
+    return;
+  }
+  shard->lru.push_front(CacheRecord{signature, result, return_shapes});
+  shard->records.emplace(signature, shard->lru.begin());
+  while (shard_capacity_ > 0 && static_cast<int64_t>(shard->lru.size()) > shard_capacity_) {
+    shard->records.erase(shard->lru.back().signature);
+    shard->lru.pop_back();
+    ++shard->stats.evictions;
+  }
+}
+
+int64_t CompilationCache::size() const {
+  int64_t size = 0;
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    size += shard.lru.size();
+  }
+  return size;
+}
+
+CompilationCacheStats CompilationCache::stats() const {
+  CompilationCacheStats stats;
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    stats.hits += shard.stats.hits;
+    stats.misses += shard.stats.misses;
+    stats.evictions += shard.stats.evictions;
+    stats.compilations += shard.stats.compilations;
+    stats.compile_time_us += shard.stats.compile_time_us;
+  }
+  return stats;
 }
 
 void CompilationCache::Release() {
-  util::Map<Signature, std::shared_ptr<Executable>, SignatureHash> empty_records;
-  records_.swap(empty_records);
+  for (Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.records.clear();
+    shard.lru.clear();
+  }
 }
 
 }  // namespace xrt
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef ONEFLOW_XRT_COMPILATION_CACHE_H_
 #define ONEFLOW_XRT_COMPILATION_CACHE_H_
 
+#include <list>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -49,18 +50,67 @@ struct SignatureHash {
 Signature ComputeSignature(const std::string& name, const int device_ordinal,
                            const std::vector<xrt::Parameter>& entry_params);
 
+struct CompilationCacheStats {
+  int64_t hits = 0;
+  int64_t misses = 0;
+  int64_t evictions = 0;
+  int64_t compilations = 0;
+  // Accumulated wall time of the compilations recorded in the cache.
+  int64_t compile_time_us = 0;
+
+  std::string ToString() const;
+};
+
+// Caches the executables of a launch op by signature. The records are split into shards by the
+// hash of the signature, and each shard has its own lock and is evicted in least recently used
+// order once it holds more than `capacity / num_shards` records, so the eviction order is only
+// approximately LRU across the whole cache.
 class CompilationCache {
  public:
-  Executable* GetRecord(const Signature& signature) const;
+  // Capacity and number of shards are read from `FLAGS_xrt_compilation_cache_capacity` and
+  // `FLAGS_xrt_compilation_cache_shards`. A capacity of 0 means unlimited.
+  CompilationCache();
+  CompilationCache(int64_t capacity, int64_t num_shards);
+
+  // Returns nullptr if no executable has been recorded for `signature`. The returned executable
+  // stays valid even if it is evicted while in use. The return shapes recorded with it are copied
+  // to `return_shapes` if it is not nullptr.
+  std::shared_ptr<Executable> GetRecord(const Signature& signature,
+                                        std::vector<Shape>* return_shapes = nullptr);
+
+  // `return_shapes` are the shapes inferred for the returns of the padded entry shapes of a
+  // bucketed signature, they are evicted together with the executable.
+  void Record(const Signature& signature, const std::shared_ptr<Executable>& result,
+              int64_t compile_time_us = 0, const std::vector<Shape>& return_shapes = {});
+
+  int64_t size() const;
 
-  void Record(const Signature& signature, const std::shared_ptr<Executable>& result);
+  CompilationCacheStats stats() const;
 
   void Release();
 
  private:
-  // static std::shared_mutex mutex_;
-  mutable std::mutex mutex_;
-  util::Map<Signature, std::shared_ptr<Executable>, SignatureHash> records_;
+  struct CacheRecord {
+    Signature signature;
+    std::shared_ptr<Executable> executable;
+    std::vector<Shape> return_shapes;
+  };
+  typedef std::list<CacheRecord> LruList;
+
+  struct Shard {
+    // std::shared_mutex is not available in C++11, lookups have to update the LRU order anyway.
+    mutable std::mutex mutex;
+    LruList lru;
+    util::Map<Signature, LruList::iterator, SignatureHash> records;
+    CompilationCacheStats stats;
+  };
+
+  Shard* ShardFor(const Signature& signature) {
+    return &shards_[SignatureHash()(signature) % shards_.size()];
+  }
+
+  int64_t shard_capacity_;
+  std::vector<Shard> shards_;
 };
 
 }  // namespace xrt
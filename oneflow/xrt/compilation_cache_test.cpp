@@ -0,0 +1,143 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <atomic>
+#include <thread>
+
+#include "oneflow/xrt/compilation_cache.h"
+
+namespace oneflow {
+namespace xrt {
+
+namespace {
+
+class FakeExecutable final : public Executable {
+ public:
+  explicit FakeExecutable(const std::string& name) : Executable(name, XrtEngine::XLA) {}
+
+  bool Run(const std::vector<Parameter>& inputs, const ExecutableRunOptions& run_options,
+           bool block_until_done) override {
+    return true;
+  }
+};
+
+Signature MakeSignature(int64_t batch) {
+  Signature signature;
+  signature.builder_name = "launch";
+  signature.device_ordinal = 0;
+  signature.entry_shapes = {Shape({batch, 16}), Shape({16})};
+  return signature;
+}
+
+std::shared_ptr<Executable> MakeExecutable(int64_t batch) {
+  return std::make_shared<FakeExecutable>("launch_" + std::to_string(batch));
+}
+
+}  // namespace
+
+TEST(CompilationCache, evict_least_recently_used) {
+  CompilationCache cache(2, 1);
+  cache.Record(MakeSignature(1), MakeExecutable(1));
+  cache.Record(MakeSignature(2), MakeExecutable(2));
+  // batch 1 is used again, so batch 2 is the one evicted for batch 3
+  ASSERT_EQ(cache.GetRecord(MakeSignature(1))->name(), "launch_1");
+  cache.Record(MakeSignature(3), MakeExecutable(3));
+  ASSERT_EQ(cache.size(), 2);
+  ASSERT_EQ(cache.GetRecord(MakeSignature(2)), nullptr);
+  ASSERT_EQ(cache.GetRecord(MakeSignature(1))->name(), "launch_1");
+  ASSERT_EQ(cache.GetRecord(MakeSignature(3))->name(), "launch_3");
+  const CompilationCacheStats stats = cache.stats();
+  ASSERT_EQ(stats.hits, 3);
+  ASSERT_EQ(stats.misses, 1);
+  ASSERT_EQ(stats.evictions, 1);
+  ASSERT_EQ(stats.compilations, 3);
+}
+
+TEST(CompilationCache, unlimited_capacity) {
+  CompilationCache cache(0, 4);
+  for (int64_t batch = 1; batch <= 100; ++batch) {
+    cache.Record(MakeSignature(batch), MakeExecutable(batch));
+  }
+  ASSERT_EQ(cache.size(), 100);
+  ASSERT_EQ(cache.stats().evictions, 0);
+  cache.Release();
+  ASSERT_EQ(cache.size(), 0);
+}
+
+TEST(CompilationCache, evict_return_shapes_with_executable) {
+  CompilationCache cache(1, 1);
+  const std::vector<Shape> bucket_return_shapes = {Shape({8, 4})};
+  cache.Record(MakeSignature(8), MakeExecutable(8), 0, bucket_return_shapes);
+  std::vector<Shape> return_shapes;
+  ASSERT_NE(cache.GetRecord(MakeSignature(8), &return_shapes), nullptr);
+  ASSERT_EQ(return_shapes, bucket_return_shapes);
+  cache.Record(MakeSignature(5), MakeExecutable(5));
+  ASSERT_EQ(cache.GetRecord(MakeSignature(8), &return_shapes), nullptr);
+  // the signature recompiled without bucketing must not get the shapes of the evicted record
+  cache.Record(MakeSignature(8), MakeExecutable(8));
+  ASSERT_NE(cache.GetRecord(MakeSignature(8), &return_shapes), nullptr);
+  ASSERT_TRUE(return_shapes.empty());
+}
+
+TEST(CompilationCache, keep_first_record_of_same_signature) {
+  CompilationCache cache(4, 1);
+  const std::shared_ptr<Executable> first = MakeExecutable(1);
+  cache.Record(MakeSignature(1), first, 0, {Shape({1, 4})});
+  cache.Record(MakeSignature(1), MakeExecutable(1), 0, {Shape({2, 4})});
+  std::vector<Shape> return_shapes;
+  ASSERT_EQ(cache.GetRecord(MakeSignature(1), &return_shapes), first);
+  ASSERT_EQ(return_shapes, std::vector<Shape>({Shape({1, 4})}));
+  ASSERT_EQ(cache.stats().compilations, 2);
+}
+
+TEST(CompilationCache, concurrent_shards) {
+  const int64_t capacity = 8;
+  const int64_t num_shards = 4;
+  const int64_t num_batches = 32;
+  const int num_threads = 8;
+  const int num_iters = 2000;
+  CompilationCache cache(capacity, num_shards);
+  std::atomic<int64_t> num_wrong(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < num_iters; ++i) {
+        const int64_t batch = (t * 7 + i * 13) % num_batches + 1;
+        const Signature signature = MakeSignature(batch);
+        std::vector<Shape> return_shapes;
+        std::shared_ptr<Executable> executable = cache.GetRecord(signature, &return_shapes);
+        if (executable == nullptr) {
+          cache.Record(signature, MakeExecutable(batch), 1, {Shape({batch, 4})});
+        } else if (executable->name() != "launch_" + std::to_string(batch)
+                   || return_shapes != std::vector<Shape>({Shape({batch, 4})})) {
+          ++num_wrong;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) { thread.join(); }
+  ASSERT_EQ(num_wrong, 0);
+  // every shard holds at most capacity / num_shards records
+  ASSERT_LE(cache.size(), capacity);
+  const CompilationCacheStats stats = cache.stats();
+  ASSERT_EQ(stats.hits + stats.misses, num_threads * num_iters);
+  ASSERT_EQ(stats.compilations, stats.misses);
+  ASSERT_EQ(stats.compile_time_us, stats.compilations);
+  // the records of a signature compiled by two threads at once are only kept once
+  ASSERT_LE(cache.size(), stats.compilations - stats.evictions);
+}
+
+}  // namespace xrt
+}  // namespace oneflow
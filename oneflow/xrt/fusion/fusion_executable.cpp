@@ -0,0 +1,612 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/fusion/fusion_executable.h"
+
+#include <cmath>
+
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/common/shape_view.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/xrt/utility/stl.h"
+
+namespace oneflow {
+namespace xrt {
+namespace fusion {
+
+namespace {
+
+// Number of elements computed by every node of a stage at once, the intermediate values of a
+// tile stay in the L1 cache.
+constexpr int64_t kFusionTileSize = 1024;
+// Stages with fewer elements run on the calling thread.
+constexpr int64_t kFusionMinParallelElemCnt = 1 << 15;
+// Temporary buffers start on their own cache line.
+constexpr int64_t kFusionTempAlignSize = 64;
+
+bool IsLeafOpCode(FusionOpCode opcode) {
+  return opcode == FusionOpCode::kParameter || opcode == FusionOpCode::kConstant
+         || opcode == FusionOpCode::kReshape;
+}
+
+bool IsSupportedDataType(DataType data_type) {
+  switch (data_type) {
+    case DataType::kChar:
+    case DataType::kInt8:
+    case DataType::kUInt8:
+    case DataType::kInt32:
+    case DataType::kInt64:
+    case DataType::kFloat:
+    case DataType::kDouble: return true;
+    default: return false;
+  }
+}
+
+FusionAccess MakeAccess(int64_t node, const Shape& shape, const Shape& domain) {
+  CHECK_LE(shape.NumAxes(), domain.NumAxes());
+  Shape extended = CreateLeftExtendedShape(ShapeView(shape), domain.NumAxes());
+  FusionAccess access;
+  access.node = node;
+  access.contiguous = (shape.elem_cnt() == domain.elem_cnt());
+  access.strides.resize(domain.NumAxes());
+  int64_t stride = 1;
+  for (int64_t i = domain.NumAxes() - 1; i >= 0; --i) {
+    if (extended.At(i) == domain.At(i)) {
+      access.strides[i] = stride;
+    } else {
+      CHECK_EQ(extended.At(i), 1) << "Shape " << shape.ToString() << " can not be broadcasted to "
+                                  << domain.ToString();
+      access.strides[i] = 0;
+    }
+    stride *= extended.At(i);
+  }
+  return access;
+}
+
+// Visit the elements [start, start + len) of `domain` as runs along the last axis. The callback
+// gets the position of the run in the tile, its length, and the offset and the stride of the
+// run in the accessed buffer.
+template<typename F>
+void ForEachRun(const Shape& domain, const std::vector<int64_t>& strides, int64_t start,
+                int64_t len, const F& DoEachRun) {
+  const int64_t num_axes = domain.NumAxes();
+  const int64_t last = num_axes - 1;
+  int64_t dims[SHAPE_MAX_AXIS_SIZE];
+  int64_t index[SHAPE_MAX_AXIS_SIZE];
+  int64_t offset = 0;
+  int64_t remaining = start;
+  for (int64_t i = last; i >= 0; --i) {
+    dims[i] = domain.At(i);
+    index[i] = remaining % dims[i];
+    remaining /= dims[i];
+    offset += index[i] * strides[i];
+  }
+  const int64_t inner_stride = strides[last];
+  int64_t pos = 0;
+  while (pos < len) {
+    int64_t run = std::min(dims[last] - index[last], len - pos);
+    DoEachRun(pos, run, offset, inner_stride);
+    pos += run;
+    index[last] += run;
+    offset += run * inner_stride;
+    for (int64_t i = last; i > 0 && index[i] == dims[i]; --i) {
+      offset -= index[i] * strides[i];
+      index[i] = 0;
+      index[i - 1] += 1;
+      offset += strides[i - 1];
+    }
+  }
+}
+
+template<typename T, typename U>
+void LoadRuns(const U* src, const Shape& domain, const FusionAccess& access, int64_t start,
+              int64_t len, T* dst) {
+  ForEachRun(domain, access.strides, start, len,
+             [&](int64_t pos, int64_t run, int64_t offset, int64_t stride) {
+               if (stride == 0) {
+                 std::fill(dst + pos, dst + pos + run, static_cast<T>(src[offset]));
+               } else {
+                 for (int64_t i = 0; i < run; ++i) {
+                   dst[pos + i] = static_cast<T>(src[offset + i * stride]);
+                 }
+               }
+             });
+}
+
+template<typename T>
+void LoadTile(const void* src, DataType src_type, const Shape& domain, const FusionAccess& access,
+              int64_t start, int64_t len, T* dst) {
+  switch (src_type) {
+#define LOAD_CASE(cpp_type, of_data_type)                                                    \
+  case of_data_type:                                                                          \
+    LoadRuns<T, cpp_type>(static_cast<const cpp_type*>(src), domain, access, start, len, dst); \
+    break;
+    OF_PP_FOR_EACH_TUPLE(LOAD_CASE, POD_DATA_TYPE_SEQ)
+#undef LOAD_CASE
+    default: LOG(FATAL) << "Unsupported data type " << src_type;
+  }
+}
+
+template<typename T>
+void StoreTile(const T* src, int64_t len, DataType dst_type, void* dst) {
+  switch (dst_type) {
+#define STORE_CASE(cpp_type, of_data_type)                                               \
+  case of_data_type: {                                                                    \
+    cpp_type* typed_dst = static_cast<cpp_type*>(dst);                                    \
+    for (int64_t i = 0; i < len; ++i) { typed_dst[i] = static_cast<cpp_type>(src[i]); } \
+    break;                                                                                \
+  }
+    OF_PP_FOR_EACH_TUPLE(STORE_CASE, POD_DATA_TYPE_SEQ)
+#undef STORE_CASE
+    default: LOG(FATAL) << "Unsupported data type " << dst_type;
+  }
+}
+
+template<typename T>
+void CastValues(DataType dst_type, const T* x, T* y, int64_t n) {
+  // Values are kept in the compute type, so only round them as the destination type would.
+  switch (dst_type) {
+#define CAST_CASE(cpp_type, of_data_type)                                                  \
+  case of_data_type:                                                                        \
+    for (int64_t i = 0; i < n; ++i) { y[i] = static_cast<T>(static_cast<cpp_type>(x[i])); } \
+    break;
+    OF_PP_FOR_EACH_TUPLE(CAST_CASE, POD_DATA_TYPE_SEQ)
+#undef CAST_CASE
+    default: LOG(FATAL) << "Unsupported data type " << dst_type;
+  }
+}
+
+template<typename T>
+void ComputeUnary(const FusionNode& node, const T* x, T* y, int64_t n) {
+  switch (node.opcode) {
+    case FusionOpCode::kIdentity: {
+      if (x != y) { std::copy(x, x + n, y); }
+      break;
+    }
+    case FusionOpCode::kCast: CastValues(node.data_type, x, y, n); break;
+    case FusionOpCode::kNegative: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = -x[i]; }
+      break;
+    }
+    case FusionOpCode::kAbs: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = std::abs(x[i]); }
+      break;
+    }
+    case FusionOpCode::kExp: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = std::exp(x[i]); }
+      break;
+    }
+    case FusionOpCode::kLog: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = std::log(x[i]); }
+      break;
+    }
+    case FusionOpCode::kSqrt: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = std::sqrt(x[i]); }
+      break;
+    }
+    case FusionOpCode::kRsqrt: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = static_cast<T>(1) / std::sqrt(x[i]); }
+      break;
+    }
+    case FusionOpCode::kSquare: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = x[i] * x[i]; }
+      break;
+    }
+    case FusionOpCode::kRelu: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = std::max(x[i], static_cast<T>(0)); }
+      break;
+    }
+    case FusionOpCode::kSigmoid: {
+      for (int64_t i = 0; i < n; ++i) {
+        y[i] = static_cast<T>(1) / (static_cast<T>(1) + std::exp(-x[i]));
+      }
+      break;
+    }
+    case FusionOpCode::kTanh: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = std::tanh(x[i]); }
+      break;
+    }
+    case FusionOpCode::kGelu: {
+      const T inv_sqrt2 = std::sqrt(static_cast<T>(0.5));
+      for (int64_t i = 0; i < n; ++i) {
+        y[i] = static_cast<T>(0.5) * x[i] * (static_cast<T>(1) + std::erf(inv_sqrt2 * x[i]));
+      }
+      break;
+    }
+    default: LOG(FATAL) << "Not an unary opcode " << static_cast<int>(node.opcode);
+  }
+}
+
+template<typename T>
+void ComputeBinary(const FusionNode& node, const T* a, const T* b, T* y, int64_t n) {
+  switch (node.opcode) {
+    case FusionOpCode::kAdd: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = a[i] + b[i]; }
+      break;
+    }
+    case FusionOpCode::kSub: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = a[i] - b[i]; }
+      break;
+    }
+    case FusionOpCode::kMul: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = a[i] * b[i]; }
+      break;
+    }
+    case FusionOpCode::kDiv: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = a[i] / b[i]; }
+      break;
+    }
+    case FusionOpCode::kMin: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = std::min(a[i], b[i]); }
+      break;
+    }
+    case FusionOpCode::kMax: {
+      for (int64_t i = 0; i < n; ++i) { y[i] = std::max(a[i], b[i]); }
+      break;
+    }
+    default: LOG(FATAL) << "Not a binary opcode " << static_cast<int>(node.opcode);
+  }
+}
+
+template<typename T>
+T ReduceInitValue(FusionOpCode opcode) {
+  return opcode == FusionOpCode::kReduceMax ? GetMinVal<T>() : static_cast<T>(0);
+}
+
+template<typename T>
+void Accumulate(FusionOpCode opcode, const T* x, const Shape& domain, const FusionAccess& access,
+                int64_t start, int64_t len, T* acc) {
+  const bool is_max = (opcode == FusionOpCode::kReduceMax);
+  ForEachRun(domain, access.strides, start, len,
+             [&](int64_t pos, int64_t run, int64_t offset, int64_t stride) {
+               const T* run_x = x + pos;
+               if (stride == 0) {
+                 T value = acc[offset];
+                 if (is_max) {
+                   for (int64_t i = 0; i < run; ++i) { value = std::max(value, run_x[i]); }
+                 } else {
+                   for (int64_t i = 0; i < run; ++i) { value += run_x[i]; }
+                 }
+                 acc[offset] = value;
+               } else {
+                 T* run_acc = acc + offset;
+                 if (is_max) {
+                   for (int64_t i = 0; i < run; ++i) {
+                     run_acc[i * stride] = std::max(run_acc[i * stride], run_x[i]);
+                   }
+                 } else {
+                   for (int64_t i = 0; i < run; ++i) { run_acc[i * stride] += run_x[i]; }
+                 }
+               }
+             });
+}
+
+}  // namespace
+
+template<typename T>
+class FusionRunner final {
+ public:
+  FusionRunner(FusionExecutable* executable, const std::vector<Parameter>& inputs,
+               const std::vector<Parameter>& outputs, char* temp_storage)
+      : executable_(executable), program_(*executable->program_) {
+    const int64_t num_nodes = program_.size();
+    dptrs_.resize(num_nodes, nullptr);
+    data_types_.resize(num_nodes, DataType::kInvalidDataType);
+    // Views share the buffer of their root, which is always placed before them.
+    for (int64_t id = 0; id < num_nodes; ++id) {
+      const FusionBuffer& buffer = executable->buffers_[id];
+      if (buffer.kind == FusionBuffer::kEntry) {
+        dptrs_[id] = inputs.at(buffer.index).data();
+        data_types_[id] = inputs.at(buffer.index).data_type();
+      } else if (buffer.kind == FusionBuffer::kReturn) {
+        dptrs_[id] = outputs.at(buffer.index).data();
+        data_types_[id] = outputs.at(buffer.index).data_type();
+      } else if (buffer.kind == FusionBuffer::kTemp) {
+        dptrs_[id] = temp_storage + executable->temp_offsets_.at(buffer.index);
+        data_types_[id] = GetDataType<T>::value;
+      } else if (program_.node(id).opcode == FusionOpCode::kReshape) {
+        int64_t operand = program_.node(id).operands.front();
+        dptrs_[id] = dptrs_[operand];
+        data_types_[id] = data_types_[operand];
+      }
+    }
+  }
+
+  void Run() {
+    for (const FusionStage& stage : executable_->stages_) { RunStage(stage); }
+  }
+
+ private:
+  void RunStage(const FusionStage& stage) {
+    const int64_t elem_cnt = stage.domain.elem_cnt();
+    const int64_t num_tiles = (elem_cnt + kFusionTileSize - 1) / kFusionTileSize;
+    int64_t num_chunks = 1;
+    if (elem_cnt >= kFusionMinParallelElemCnt) {
+      num_chunks = std::min<int64_t>(Global<ThreadPool>::Get()->thread_num(), num_tiles);
+    }
+    // Every chunk accumulates into its own partial results, which is only worth it if they are
+    // much smaller than the reduced values.
+    int64_t reduce_elem_cnt = 0;
+    for (int64_t i = 0; i < stage.nodes.size(); ++i) {
+      if (IsReduceOpCode(program_.node(stage.nodes[i]).opcode)) {
+        reduce_elem_cnt += program_.node(stage.nodes[i]).shape.elem_cnt();
+      }
+    }
+    if (reduce_elem_cnt * num_chunks > elem_cnt) { num_chunks = 1; }
+
+    std::vector<std::vector<T>> partials(num_chunks * stage.num_reductions);
+    const int64_t tiles_per_chunk = (num_tiles + num_chunks - 1) / num_chunks;
+    auto RunChunk = [&](size_t chunk) {
+      int64_t tile_begin = chunk * tiles_per_chunk;
+      int64_t tile_end = std::min(num_tiles, tile_begin + tiles_per_chunk);
+      RunTiles(stage, tile_begin, tile_end, partials.data() + chunk * stage.num_reductions);
+    };
+    if (num_chunks == 1) {
+      RunChunk(0);
+    } else {
+      MultiThreadLoop(num_chunks, RunChunk);
+    }
+    if (stage.num_reductions > 0) { FinalizeReductions(stage, num_chunks, &partials); }
+  }
+
+  void RunTiles(const FusionStage& stage, int64_t tile_begin, int64_t tile_end,
+                std::vector<T>* partials) {
+    const int64_t elem_cnt = stage.domain.elem_cnt();
+    // One register per load and per node of the stage.
+    std::vector<T> registers((stage.loads.size() + stage.nodes.size()) * kFusionTileSize);
+    std::vector<const T*> values(program_.size(), nullptr);
+    auto Register = [&](int64_t i) { return registers.data() + i * kFusionTileSize; };
+
+    for (int64_t i = 0; i < stage.loads.size(); ++i) {
+      const FusionNode& node = program_.node(stage.loads[i].node);
+      if (node.opcode == FusionOpCode::kConstant) {
+        std::fill(Register(i), Register(i) + kFusionTileSize, static_cast<T>(node.scalar));
+        values[stage.loads[i].node] = Register(i);
+      }
+    }
+    int64_t reduction_index = 0;
+    for (int64_t i = 0; i < stage.nodes.size(); ++i) {
+      const FusionNode& node = program_.node(stage.nodes[i]);
+      if (IsReduceOpCode(node.opcode)) {
+        partials[reduction_index++].assign(node.shape.elem_cnt(),
+                                           ReduceInitValue<T>(node.opcode));
+      }
+    }
+
+    for (int64_t tile = tile_begin; tile < tile_end; ++tile) {
+      const int64_t start = tile * kFusionTileSize;
+      const int64_t len = std::min(kFusionTileSize, elem_cnt - start);
+      for (int64_t i = 0; i < stage.loads.size(); ++i) {
+        const FusionAccess& access = stage.loads[i];
+        if (program_.node(access.node).opcode == FusionOpCode::kConstant) { continue; }
+        const void* dptr = dptrs_[access.node];
+        const DataType data_type = data_types_[access.node];
+        if (access.contiguous && data_type == GetDataType<T>::value) {
+          values[access.node] = static_cast<const T*>(dptr) + start;
+        } else {
+          LoadTile<T>(dptr, data_type, stage.domain, access, start, len, Register(i));
+          values[access.node] = Register(i);
+        }
+      }
+      reduction_index = 0;
+      for (int64_t i = 0; i < stage.nodes.size(); ++i) {
+        const int64_t id = stage.nodes[i];
+        const FusionNode& node = program_.node(id);
+        const T* x = values[node.operands.front()];
+        if (IsReduceOpCode(node.opcode)) {
+          Accumulate(node.opcode, x, stage.domain, stage.reduce_outputs[i], start, len,
+                     partials[reduction_index++].data());
+          continue;
+        }
+        // Write the values to be materialized straight into their buffer if possible.
+        const bool materialized = (executable_->buffers_[id].kind != FusionBuffer::kNone);
+        const bool store_in_place = materialized && data_types_[id] == GetDataType<T>::value;
+        T* y = store_in_place ? static_cast<T*>(dptrs_[id]) + start
+                              : Register(stage.loads.size() + i);
+        if (IsBinaryOpCode(node.opcode)) {
+          ComputeBinary(node, x, values[node.operands.back()], y, len);
+        } else {
+          ComputeUnary(node, x, y, len);
+        }
+        values[id] = y;
+        if (materialized && !store_in_place) {
+          StoreTile(y, len, data_types_[id],
+                    static_cast<char*>(dptrs_[id]) + start * GetSizeOfDataType(data_types_[id]));
+        }
+      }
+    }
+  }
+
+  void FinalizeReductions(const FusionStage& stage, int64_t num_chunks,
+                          std::vector<std::vector<T>>* partials) {
+    const int64_t num_reductions = stage.num_reductions;
+    int64_t reduction_index = 0;
+    for (int64_t i = 0; i < stage.nodes.size(); ++i) {
+      const int64_t id = stage.nodes[i];
+      const FusionNode& node = program_.node(id);
+      if (!IsReduceOpCode(node.opcode)) { continue; }
+      std::vector<T>& result = partials->at(reduction_index);
+      for (int64_t chunk = 1; chunk < num_chunks; ++chunk) {
+        const std::vector<T>& partial = partials->at(chunk * num_reductions + reduction_index);
+        for (int64_t j = 0; j < result.size(); ++j) {
+          result[j] = node.opcode == FusionOpCode::kReduceMax ? std::max(result[j], partial[j])
+                                                              : result[j] + partial[j];
+        }
+      }
+      if (node.opcode == FusionOpCode::kReduceMean) {
+        const T count = static_cast<T>(stage.domain.elem_cnt() / node.shape.elem_cnt());
+        for (T& value : result) { value /= count; }
+      }
+      StoreTile(result.data(), result.size(), data_types_[id], dptrs_[id]);
+      ++reduction_index;
+    }
+  }
+
+  FusionExecutable* executable_;
+  const FusionProgram& program_;
+  std::vector<void*> dptrs_;
+  std::vector<DataType> data_types_;
+};
+
+FusionExecutable::FusionExecutable(const std::string& name,
+                                   const std::shared_ptr<FusionProgram>& program,
+                                   const std::vector<int64_t>& return_values)
+    : Executable(name, XrtEngine::FUSION), program_(program), return_values_(return_values) {}
+
+int64_t FusionExecutable::Root(int64_t node) const {
+  while (program_->node(node).opcode == FusionOpCode::kReshape) {
+    node = program_->node(node).operands.front();
+  }
+  return node;
+}
+
+void FusionExecutable::AddLoad(int64_t node, FusionStage* stage) {
+  for (const FusionAccess& access : stage->loads) {
+    if (access.node == node) { return; }
+  }
+  stage->loads.push_back(MakeAccess(node, program_->node(node).shape, stage->domain));
+}
+
+Maybe<void> FusionExecutable::Lower() {
+  // Every return value has to be computed by a stage and owns its buffer, so copy the ones
+  // which are leaves or returned more than once.
+  util::Set<int64_t> returned;
+  for (int64_t& value : return_values_) {
+    if (IsLeafOpCode(program_->node(value).opcode) || returned.count(value) > 0) {
+      value = program_->Unary(FusionOpCode::kIdentity, value);
+    }
+    returned.insert(value);
+  }
+  const int64_t num_nodes = program_->size();
+  compute_type_ = DataType::kFloat;
+  for (const FusionNode& node : program_->nodes()) {
+    CHECK_OR_RETURN(IsSupportedDataType(node.data_type))
+        << "Data type " << node.data_type << " is not supported by the fusion engine.";
+    if (node.data_type == DataType::kDouble) { compute_type_ = DataType::kDouble; }
+    // Integers are only loaded to be cast to a floating point type and stored after being cast
+    // from one, the arithmetic in the compute type would not be exact for them.
+    if (IsLeafOpCode(node.opcode)) { continue; }
+    if (!IsFloatingDataType(node.data_type)) {
+      CHECK_OR_RETURN(node.opcode == FusionOpCode::kCast
+                      && IsFloatingDataType(program_->node(node.operands.front()).data_type))
+          << "Integer arithmetic is not supported by the fusion engine.";
+    }
+    for (int64_t operand : node.operands) {
+      if (!IsFloatingDataType(program_->node(operand).data_type)) {
+        CHECK_OR_RETURN(node.opcode == FusionOpCode::kCast && IsFloatingDataType(node.data_type))
+            << "Integer arithmetic is not supported by the fusion engine.";
+      }
+    }
+  }
+
+  buffers_.resize(num_nodes);
+  for (int64_t i = 0; i < return_values_.size(); ++i) {
+    buffers_[return_values_[i]] = FusionBuffer(FusionBuffer::kReturn, i);
+  }
+  for (int64_t id = 0; id < num_nodes; ++id) {
+    const FusionNode& node = program_->node(id);
+    if (node.opcode == FusionOpCode::kParameter) {
+      buffers_[id] = FusionBuffer(FusionBuffer::kEntry, node.param_index);
+    }
+  }
+
+  // Greedily append the nodes to the last stage while they iterate over the same domain and do
+  // not read a value that is not complete before the loop ends.
+  std::vector<int64_t> stage_of_node(num_nodes, -1);
+  for (int64_t id = 0; id < num_nodes; ++id) {
+    const FusionNode& node = program_->node(id);
+    if (IsLeafOpCode(node.opcode)) { continue; }
+    const Shape& domain =
+        IsReduceOpCode(node.opcode) ? program_->node(node.operands.front()).shape : node.shape;
+    bool fusible = !stages_.empty() && stages_.back().domain == domain;
+    for (int64_t operand : node.operands) {
+      if (!fusible) { break; }
+      int64_t root = Root(operand);
+      if (stage_of_node[root] == stages_.size() - 1
+          && (root != operand || IsReduceOpCode(program_->node(root).opcode))) {
+        fusible = false;
+      }
+    }
+    if (!fusible) {
+      stages_.emplace_back();
+      stages_.back().domain = domain;
+    }
+    stage_of_node[id] = stages_.size() - 1;
+    stages_.back().nodes.push_back(id);
+  }
+
+  // Materialize the values read by other stages, broadcasted or viewed with another shape.
+  std::vector<bool> materialized(num_nodes, false);
+  for (int64_t s = 0; s < stages_.size(); ++s) {
+    FusionStage* stage = &stages_[s];
+    stage->reduce_outputs.resize(stage->nodes.size());
+    for (int64_t i = 0; i < stage->nodes.size(); ++i) {
+      const int64_t id = stage->nodes[i];
+      const FusionNode& node = program_->node(id);
+      for (int64_t operand : node.operands) {
+        int64_t root = Root(operand);
+        FusionOpCode root_opcode = program_->node(root).opcode;
+        if (root_opcode == FusionOpCode::kParameter || root_opcode == FusionOpCode::kConstant) {
+          AddLoad(operand, stage);
+        } else if (stage_of_node[root] != s || root != operand) {
+          materialized[root] = true;
+          AddLoad(operand, stage);
+        }
+      }
+      if (IsReduceOpCode(node.opcode)) {
+        materialized[id] = true;
+        stage->reduce_outputs[i] = MakeAccess(id, node.keep_dims_shape, stage->domain);
+        stage->num_reductions += 1;
+      }
+    }
+  }
+  for (int64_t id = 0; id < num_nodes; ++id) {
+    if (materialized[id] && buffers_[id].kind == FusionBuffer::kNone) {
+      buffers_[id] = FusionBuffer(FusionBuffer::kTemp, temp_elem_cnts_.size());
+      temp_elem_cnts_.push_back(program_->node(id).shape.elem_cnt());
+    }
+  }
+  temp_offsets_.resize(temp_elem_cnts_.size());
+  for (int64_t i = 0; i < temp_elem_cnts_.size(); ++i) {
+    temp_offsets_[i] = temp_storage_size_;
+    temp_storage_size_ +=
+        RoundUp(temp_elem_cnts_[i] * GetSizeOfDataType(compute_type_), kFusionTempAlignSize);
+  }
+  VLOG(2) << "Fusion executable " << name_ << " runs " << num_nodes << " nodes in "
+          << stages_.size() << " loops with " << temp_elem_cnts_.size() << " temporary buffers.";
+  return Maybe<void>::Ok();
+}
+
+bool FusionExecutable::Run(const std::vector<Parameter>& inputs,
+                           const ExecutableRunOptions& run_options, bool block_until_done) {
+  const std::vector<Parameter>& outputs = run_options.return_params;
+  CHECK_EQ(outputs.size(), return_values_.size());
+  // Runs are synchronous, so the storage of the thread is free again when the next one starts.
+  thread_local std::vector<char> temp_storage;
+  if (temp_storage.size() < temp_storage_size_) { temp_storage.resize(temp_storage_size_); }
+  if (compute_type_ == DataType::kDouble) {
+    FusionRunner<double>(this, inputs, outputs, temp_storage.data()).Run();
+  } else {
+    FusionRunner<float>(this, inputs, outputs, temp_storage.data()).Run();
+  }
+  // The results are written to the storage of the return parameters in place.
+  results_ = outputs;
+  return true;
+}
+
+}  // namespace fusion
+}  // namespace xrt
+}  // namespace oneflow
@@ -0,0 +1,102 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_FUSION_FUSION_EXECUTABLE_H_
+#define ONEFLOW_XRT_FUSION_FUSION_EXECUTABLE_H_
+
+#include <vector>
+
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/xrt/executable.h"
+#include "oneflow/xrt/fusion/fusion_program.h"
+#include "oneflow/xrt/parameter.h"
+
+namespace oneflow {
+namespace xrt {
+namespace fusion {
+
+// Where the value of a node lives while running. Values which are only used inside the loop
+// computing them are never written to memory.
+struct FusionBuffer {
+  enum Kind { kNone = 0, kEntry, kReturn, kTemp };
+  FusionBuffer() = default;
+  FusionBuffer(Kind kind, int64_t index) : kind(kind), index(index) {}
+
+  Kind kind = kNone;
+  // Index of the entry or return parameter, or of the temporary buffer.
+  int64_t index = -1;
+};
+
+// Strided view of a materialized node in the index space of a stage, the strides of the
+// broadcasted axes are 0.
+struct FusionAccess {
+  int64_t node = -1;
+  bool contiguous = false;
+  std::vector<int64_t> strides;
+};
+
+// A single loop over every element of `domain`. Elementwise nodes of the stage are computed
+// tile by tile in registers, and reductions accumulate their operand along the way.
+struct FusionStage {
+  Shape domain;
+  std::vector<FusionAccess> loads;
+  std::vector<int64_t> nodes;
+  // Accesses of the outputs of the reductions, indexed as `nodes`.
+  std::vector<FusionAccess> reduce_outputs;
+  int64_t num_reductions = 0;
+};
+
+class FusionExecutable : public Executable {
+ public:
+  FusionExecutable(const std::string& name, const std::shared_ptr<FusionProgram>& program,
+                   const std::vector<int64_t>& return_values);
+
+  virtual ~FusionExecutable() = default;
+
+  bool Run(const std::vector<Parameter>& inputs, const ExecutableRunOptions& run_options,
+           bool block_until_done = true) override;
+
+  // Split the program into stages and decide which values have to be materialized, fails if the
+  // program does arithmetic the engine does not support.
+  Maybe<void> Lower();
+
+  const std::vector<FusionStage>& stages() const { return stages_; }
+
+ private:
+  template<typename T>
+  friend class FusionRunner;
+
+  void AddLoad(int64_t node, FusionStage* stage);
+  int64_t Root(int64_t node) const;
+
+  std::shared_ptr<FusionProgram> program_;
+  std::vector<int64_t> return_values_;
+  // Data type all the arithmetic is done in, kDouble if any value is double, otherwise kFloat.
+  DataType compute_type_;
+
+  std::vector<FusionBuffer> buffers_;
+  std::vector<int64_t> temp_elem_cnts_;
+  // Offsets of the temporary buffers in the storage of a run. The executable is shared by the
+  // kernels of the compilation cache, so every thread running it has its own storage.
+  std::vector<int64_t> temp_offsets_;
+  int64_t temp_storage_size_ = 0;
+  std::vector<FusionStage> stages_;
+};
+
+}  // namespace fusion
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_FUSION_FUSION_EXECUTABLE_H_
@@ -0,0 +1,112 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/fusion/fusion_graph_compiler.h"
+#include "oneflow/xrt/fusion/ops/op_kernel.h"
+#include "oneflow/xrt/node_util.h"
+
+namespace oneflow {
+namespace xrt {
+namespace fusion {
+
+void FusionGraphCompiler::PopulateEntryParams(const std::vector<Parameter>& entry_params) {
+  for (int i = 0; i < entry_params.size(); ++i) {
+    const Parameter& param = entry_params[i];
+    operands_[ArgFromParameter(param)] =
+        program_->Parameter(i, param.shape(), param.data_type());
+  }
+}
+
+Argument FusionGraphCompiler::ArgFromParameter(const Parameter& param) {
+  return Argument(param.name(), param.shape(), param.data_type());
+}
+
+void FusionGraphCompiler::SetupKernelContextParam(const XrtNode* node,
+                                                  FusionOpContext::Param* context_param) {
+  util::Map<Argument, int64_t> input_ops;
+  util::Map<std::string /* produce/consume key */, Argument> input_output_args;
+  std::vector<std::string> output_names;
+  for (const XrtEdge* edge : node->in_edges()) {
+    if (!edge->IsControlEdge()) {
+      const Argument& arg = edge->argument();
+      CHECK_GT(operands_.count(arg), 0);
+      input_ops.emplace(arg, operands_.at(arg));
+      const std::string& k = arg.meta_data().consume_key;
+      input_output_args.emplace(k, arg);
+    }
+  }
+  for (const XrtEdge* edge : node->out_edges()) {
+    if (!edge->IsControlEdge()) {
+      const Argument& arg = edge->argument();
+      const std::string& k = arg.meta_data().produce_key;
+      input_output_args.emplace(k, arg);
+      output_names.push_back(k);
+    }
+  }
+
+  size_t num_outputs = input_output_args.size() - input_ops.size();
+  CHECK_GE(num_outputs, 0) << "Outputs number should >= 0.";
+  context_param->program = program_.get();
+  context_param->device = node->device();
+  context_param->message = OpMessage(node);
+  context_param->arguments = std::move(input_output_args);
+  context_param->inputs = std::move(input_ops);
+  context_param->output_names = std::move(output_names);
+  context_param->num_outputs = num_outputs;
+}
+
+std::shared_ptr<Executable> FusionGraphCompiler::Compile(
+    const XrtGraph* graph, const std::vector<Parameter>& entry_params,
+    const std::vector<Parameter>& return_params, const std::vector<InputOutputAlias>& aliases) {
+  // None of the fusion op kernels mutates its inputs.
+  CHECK(aliases.empty()) << "Input output aliases are not supported by the fusion engine.";
+  PopulateEntryParams(entry_params);
+
+  algorithm::TopologyVisit(*graph, [&](const XrtNode* node) {
+    FusionOpContext::Param param;
+    SetupKernelContextParam(node, &param);
+    FusionOpContext op_context(param);
+    // Do compile, append the operator computation to the program.
+    auto op_kernel = BuildOpKernel(node->type());
+    op_kernel->Compile(&op_context);
+
+    // Always insert the new output into `operands_`.
+    const auto& outputs = op_context.outputs();
+    for (auto it = outputs.begin(); it != outputs.end(); ++it) {
+      operands_[it->first] = it->second;
+    }
+  });
+
+  std::vector<int64_t> return_values(return_params.size());
+  for (int i = 0; i < return_params.size(); ++i) {
+    Argument arg = ArgFromParameter(return_params[i]);
+    CHECK_GT(operands_.count(arg), 0) << "Return value " << arg.name() << " is not computed.";
+    return_values[i] = operands_.at(arg);
+  }
+  auto executable = std::make_shared<FusionExecutable>(name_, program_, return_values);
+  Maybe<void> lowered = executable->Lower();
+  if (!lowered.IsOk()) {
+    LOG(ERROR) << "Fusion engine can not compile " << name_ << ": "
+               << lowered.GetSerializedError();
+    return nullptr;
+  }
+  return executable;
+}
+
+REGISTER_GRAPH_COMPILER(XrtEngine::FUSION, FusionGraphCompiler);
+
+}  // namespace fusion
+}  // namespace xrt
+}  // namespace oneflow
@@ -0,0 +1,59 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_FUSION_FUSION_GRAPH_COMPILER_H_
+#define ONEFLOW_XRT_FUSION_FUSION_GRAPH_COMPILER_H_
+
+#include "oneflow/xrt/fusion/fusion_executable.h"
+#include "oneflow/xrt/fusion/fusion_program.h"
+#include "oneflow/xrt/fusion/ops/op_context.h"
+#include "oneflow/xrt/graph_compiler.h"
+
+namespace oneflow {
+namespace xrt {
+namespace fusion {
+
+// Lowers the elementwise, broadcast and reduce ops of a cluster to a FusionProgram, and builds
+// an executable running the program in as few passes over the tensors as possible.
+class FusionGraphCompiler : public GraphCompiler::Impl {
+ public:
+  explicit FusionGraphCompiler(const std::string& name)
+      : GraphCompiler::Impl(name), program_(std::make_shared<FusionProgram>()) {}
+
+  virtual ~FusionGraphCompiler() = default;
+
+  std::shared_ptr<Executable> Compile(const XrtGraph* graph,
+                                      const std::vector<Parameter>& entry_params,
+                                      const std::vector<Parameter>& return_params,
+                                      const std::vector<InputOutputAlias>& aliases) override;
+
+ private:
+  void SetupKernelContextParam(const XrtNode* node, FusionOpContext::Param* context_param);
+
+  void PopulateEntryParams(const std::vector<Parameter>& entry_params);
+
+  Argument ArgFromParameter(const Parameter& param);
+
+ private:
+  std::shared_ptr<FusionProgram> program_;
+
+  util::Map<Argument, int64_t> operands_;
+};
+
+}  // namespace fusion
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_FUSION_FUSION_GRAPH_COMPILER_H_
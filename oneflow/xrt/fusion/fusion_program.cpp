@@ -0,0 +1,132 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/fusion/fusion_program.h"
+#include "oneflow/core/common/shape_view.h"
+
+#include "glog/logging.h"
+
+namespace oneflow {
+namespace xrt {
+namespace fusion {
+
+namespace {
+
+Shape BroadcastShape(const Shape& a, const Shape& b) {
+  int num_axes = std::max(a.NumAxes(), b.NumAxes());
+  Shape extended_a = CreateLeftExtendedShape(ShapeView(a), num_axes);
+  Shape extended_b = CreateLeftExtendedShape(ShapeView(b), num_axes);
+  DimVector dim_vec(num_axes);
+  for (int i = 0; i < num_axes; ++i) {
+    int64_t dim_a = extended_a.At(i);
+    int64_t dim_b = extended_b.At(i);
+    CHECK(dim_a == dim_b || dim_a == 1 || dim_b == 1)
+        << "Shapes " << a.ToString() << " and " << b.ToString() << " can not be broadcasted.";
+    dim_vec[i] = std::max(dim_a, dim_b);
+  }
+  return Shape(dim_vec);
+}
+
+}  // namespace
+
+int64_t FusionProgram::AddNode(FusionNode&& node) {
+  nodes_.push_back(std::move(node));
+  return nodes_.size() - 1;
+}
+
+int64_t FusionProgram::Parameter(int64_t param_index, const Shape& shape,
+                                 const DataType& data_type) {
+  FusionNode node;
+  node.opcode = FusionOpCode::kParameter;
+  node.shape = shape;
+  node.data_type = data_type;
+  node.param_index = param_index;
+  return AddNode(std::move(node));
+}
+
+int64_t FusionProgram::Constant(double value, const DataType& data_type) {
+  FusionNode node;
+  node.opcode = FusionOpCode::kConstant;
+  node.shape = Shape({1});
+  node.data_type = data_type;
+  node.scalar = value;
+  return AddNode(std::move(node));
+}
+
+int64_t FusionProgram::Reshape(int64_t x, const Shape& shape) {
+  CHECK_EQ(node(x).shape.elem_cnt(), shape.elem_cnt());
+  FusionNode node;
+  node.opcode = FusionOpCode::kReshape;
+  node.operands = {x};
+  node.shape = shape;
+  node.data_type = this->node(x).data_type;
+  return AddNode(std::move(node));
+}
+
+int64_t FusionProgram::Unary(FusionOpCode opcode, int64_t x) {
+  CHECK(IsUnaryOpCode(opcode) && opcode != FusionOpCode::kCast);
+  FusionNode node;
+  node.opcode = opcode;
+  node.operands = {x};
+  node.shape = this->node(x).shape;
+  node.data_type = this->node(x).data_type;
+  return AddNode(std::move(node));
+}
+
+int64_t FusionProgram::Cast(int64_t x, const DataType& data_type) {
+  FusionNode node;
+  node.opcode = FusionOpCode::kCast;
+  node.operands = {x};
+  node.shape = this->node(x).shape;
+  node.data_type = data_type;
+  return AddNode(std::move(node));
+}
+
+int64_t FusionProgram::Binary(FusionOpCode opcode, int64_t a, int64_t b) {
+  CHECK(IsBinaryOpCode(opcode));
+  FusionNode node;
+  node.opcode = opcode;
+  node.operands = {a, b};
+  node.shape = BroadcastShape(this->node(a).shape, this->node(b).shape);
+  node.data_type = this->node(a).data_type;
+  return AddNode(std::move(node));
+}
+
+int64_t FusionProgram::Reduce(FusionOpCode opcode, int64_t x, const std::vector<int32_t>& axis,
+                              const Shape& out_shape) {
+  CHECK(IsReduceOpCode(opcode));
+  const Shape& in_shape = node(x).shape;
+  Shape keep_dims_shape = in_shape;
+  if (axis.empty()) {
+    for (int i = 0; i < in_shape.NumAxes(); ++i) { keep_dims_shape.Set(i, 1); }
+  }
+  for (int32_t i : axis) {
+    if (i < 0) { i += in_shape.NumAxes(); }
+    CHECK(i >= 0 && i < in_shape.NumAxes());
+    keep_dims_shape.Set(i, 1);
+  }
+  CHECK_EQ(keep_dims_shape.elem_cnt(), out_shape.elem_cnt());
+  FusionNode node;
+  node.opcode = opcode;
+  node.operands = {x};
+  node.shape = out_shape;
+  node.data_type = this->node(x).data_type;
+  node.keep_dims_shape = keep_dims_shape;
+  return AddNode(std::move(node));
+}
+
+}  // namespace fusion
+}  // namespace xrt
+}  // namespace oneflow
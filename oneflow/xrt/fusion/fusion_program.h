@@ -0,0 +1,116 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_FUSION_FUSION_PROGRAM_H_
+#define ONEFLOW_XRT_FUSION_FUSION_PROGRAM_H_
+
+#include <vector>
+
+#include "oneflow/core/common/data_type.pb.h"
+#include "oneflow/core/common/shape.h"
+
+namespace oneflow {
+namespace xrt {
+namespace fusion {
+
+enum class FusionOpCode : int32_t {
+  // Leaf nodes.
+  kParameter = 0,
+  kConstant,
+  // A view of the operand with another shape of the same element count.
+  kReshape,
+  // Unary elementwise.
+  kIdentity,
+  kCast,
+  kNegative,
+  kAbs,
+  kExp,
+  kLog,
+  kSqrt,
+  kRsqrt,
+  kSquare,
+  kRelu,
+  kSigmoid,
+  kTanh,
+  kGelu,
+  // Binary elementwise with numpy style broadcasting.
+  kAdd,
+  kSub,
+  kMul,
+  kDiv,
+  kMin,
+  kMax,
+  // Reductions.
+  kReduceSum,
+  kReduceMean,
+  kReduceMax,
+};
+
+inline bool IsUnaryOpCode(FusionOpCode opcode) {
+  return opcode >= FusionOpCode::kIdentity && opcode <= FusionOpCode::kGelu;
+}
+
+inline bool IsBinaryOpCode(FusionOpCode opcode) {
+  return opcode >= FusionOpCode::kAdd && opcode <= FusionOpCode::kMax;
+}
+
+inline bool IsReduceOpCode(FusionOpCode opcode) {
+  return opcode >= FusionOpCode::kReduceSum && opcode <= FusionOpCode::kReduceMax;
+}
+
+struct FusionNode {
+  FusionOpCode opcode;
+  std::vector<int64_t> operands;
+  Shape shape;
+  DataType data_type;
+  // Index of the entry parameter for kParameter.
+  int64_t param_index = -1;
+  // Value of kConstant.
+  double scalar = 0.0;
+  // Shape of the operand with the reduced axes set to 1 for reductions.
+  Shape keep_dims_shape;
+};
+
+// Expression dag built by the fusion op kernels. Nodes are only appended, so the node list is
+// always in topological order, and every node is identified by its index.
+class FusionProgram {
+ public:
+  FusionProgram() = default;
+  virtual ~FusionProgram() = default;
+
+  int64_t Parameter(int64_t param_index, const Shape& shape, const DataType& data_type);
+  int64_t Constant(double value, const DataType& data_type);
+  int64_t Reshape(int64_t x, const Shape& shape);
+  int64_t Unary(FusionOpCode opcode, int64_t x);
+  int64_t Cast(int64_t x, const DataType& data_type);
+  int64_t Binary(FusionOpCode opcode, int64_t a, int64_t b);
+  int64_t Reduce(FusionOpCode opcode, int64_t x, const std::vector<int32_t>& axis,
+                 const Shape& out_shape);
+
+  const FusionNode& node(int64_t id) const { return nodes_.at(id); }
+  const std::vector<FusionNode>& nodes() const { return nodes_; }
+  int64_t size() const { return nodes_.size(); }
+
+ private:
+  int64_t AddNode(FusionNode&& node);
+
+  std::vector<FusionNode> nodes_;
+};
+
+}  // namespace fusion
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_FUSION_FUSION_PROGRAM_H_
@@ -0,0 +1,133 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "absl/strings/str_cat.h"
+#include "oneflow/xrt/fusion/ops/op_context.h"
+#include "oneflow/xrt/fusion/ops/op_kernel.h"
+
+namespace oneflow {
+namespace xrt {
+namespace fusion {
+
+template<FusionOpCode opcode>
+class BcastBinaryOp : public FusionOpKernel {
+ public:
+  void Compile(FusionOpContext* ctx) override {
+    ctx->SetOutput("z_0", ctx->program()->Binary(opcode, ctx->Input("x_0"), ctx->Input("y_0")));
+  }
+};
+
+REGISTER_FUSION_OP_KERNEL(BcastAdd, BcastBinaryOp<FusionOpCode::kAdd>).Finalize();
+REGISTER_FUSION_OP_KERNEL(BcastSub, BcastBinaryOp<FusionOpCode::kSub>).Finalize();
+REGISTER_FUSION_OP_KERNEL(BcastMul, BcastBinaryOp<FusionOpCode::kMul>).Finalize();
+REGISTER_FUSION_OP_KERNEL(BcastDiv, BcastBinaryOp<FusionOpCode::kDiv>).Finalize();
+REGISTER_FUSION_OP_KERNEL(BcastMin, BcastBinaryOp<FusionOpCode::kMin>).Finalize();
+REGISTER_FUSION_OP_KERNEL(BcastMax, BcastBinaryOp<FusionOpCode::kMax>).Finalize();
+
+class MultiplyOp : public FusionOpKernel {
+ public:
+  void Compile(FusionOpContext* ctx) override {
+    CHECK_EQ(ctx->InputShape("x_0"), ctx->InputShape("y_0"));
+    ctx->SetOutput("out_0", ctx->program()->Binary(FusionOpCode::kMul, ctx->Input("x_0"),
+                                                   ctx->Input("y_0")));
+  }
+};
+
+REGISTER_FUSION_OP_KERNEL(Multiply, MultiplyOp).Finalize();
+
+class AddOp : public FusionOpKernel {
+ public:
+  void Compile(FusionOpContext* ctx) override {
+    int num_inputs = ctx->num_inputs();
+    CHECK_GT(num_inputs, 0);
+    Shape shape = ctx->InputShape("in_0");
+    int64_t sum = ctx->Input("in_0");
+    for (int i = 1; i < num_inputs; ++i) {
+      std::string name = absl::StrCat("in_", i);
+      CHECK_EQ(shape, ctx->InputShape(name));
+      sum = ctx->program()->Binary(FusionOpCode::kAdd, sum, ctx->Input(name));
+    }
+    if (num_inputs == 1) { sum = ctx->program()->Unary(FusionOpCode::kIdentity, sum); }
+    ctx->SetSoleOutput(sum);
+  }
+};
+
+REGISTER_FUSION_OP_KERNEL(Add, AddOp).Finalize();
+
+class BiasAddOp : public FusionOpKernel {
+ public:
+  void Compile(FusionOpContext* ctx) override {
+    Shape in_shape = ctx->InputShape("a_0");
+    Shape bias_shape = ctx->InputShape("b_0");
+    CHECK_EQ(bias_shape.NumAxes(), 1);
+    CHECK_EQ(ctx->InputType("a_0"), ctx->InputType("b_0"));
+    int32_t axis = ctx->Attr<int32_t>("axis");
+    CHECK_EQ(in_shape.At(axis), bias_shape.At(0));
+
+    // View the bias as [1, ..., C, ..., 1] so that it broadcasts along the other axes.
+    DimVector dim_vec(in_shape.NumAxes(), 1);
+    dim_vec[axis] = bias_shape.At(0);
+    FusionProgram* program = ctx->program();
+    int64_t bias = program->Reshape(ctx->Input("b_0"), Shape(dim_vec));
+    ctx->SetOutput("out_0", program->Binary(FusionOpCode::kAdd, ctx->Input("a_0"), bias));
+  }
+};
+
+REGISTER_FUSION_OP_KERNEL(BiasAdd, BiasAddOp).Finalize();
+
+template<FusionOpCode opcode>
+class ScalarBinaryOp : public FusionOpKernel {
+ public:
+  void Compile(FusionOpContext* ctx) override {
+    DataType data_type = ctx->SoleInputType();
+    double value = 0.0;
+    if (ctx->Attr<bool>("has_int_operand")) {
+      value = static_cast<double>(ctx->Attr<int64_t>("int_operand"));
+    } else if (ctx->Attr<bool>("has_float_operand")) {
+      value = ctx->Attr<double>("float_operand");
+    } else {
+      LOG(FATAL) << "Scalar operand is not set.";
+    }
+    FusionProgram* program = ctx->program();
+    int64_t scalar = program->Constant(value, data_type);
+    ctx->SetSoleOutput(program->Binary(opcode, ctx->SoleInput(), scalar));
+  }
+};
+
+REGISTER_FUSION_OP_KERNEL(ScalarAdd, ScalarBinaryOp<FusionOpCode::kAdd>).Finalize();
+REGISTER_FUSION_OP_KERNEL(ScalarMul, ScalarBinaryOp<FusionOpCode::kMul>).Finalize();
+
+class DropoutOp : public FusionOpKernel {
+ public:
+  void Compile(FusionOpContext* ctx) override {
+    FusionProgram* program = ctx->program();
+    DataType data_type = ctx->InputType("in_0");
+    // out = in * mask * scale (+ _add_to_output)
+    int64_t mask = program->Cast(ctx->Input("mask_0"), data_type);
+    int64_t scale = program->Constant(ctx->Attr<float>("scale"), data_type);
+    int64_t out = program->Binary(FusionOpCode::kMul, ctx->Input("in_0"), mask);
+    out = program->Binary(FusionOpCode::kMul, out, scale);
+    if (ctx->HasInput("_add_to_output_0")) {
+      out = program->Binary(FusionOpCode::kAdd, out, ctx->Input("_add_to_output_0"));
+    }
+    ctx->SetOutput("out_0", out);
+  }
+};
+
+REGISTER_FUSION_OP_KERNEL(Dropout, DropoutOp).SetConvertedArguments({"mask_0"}).Finalize();
+
+}  // namespace fusion
+}  // namespace xrt
+}  // namespace oneflow
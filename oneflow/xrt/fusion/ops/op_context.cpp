@@ -0,0 +1,93 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/fusion/ops/op_context.h"
+
+namespace oneflow {
+namespace xrt {
+namespace fusion {
+
+const std::string& FusionOpContext::SoleOutputName() const {
+  CHECK_EQ(num_outputs(), 1);
+  return param_.output_names.front();
+}
+
+bool FusionOpContext::HasInput(const std::string& name) const {
+  return param_.arguments.count(name) > 0 && param_.inputs.count(ArgumentFromKey(name)) > 0;
+}
+
+int64_t FusionOpContext::Input(const std::string& name) const {
+  Argument arg = ArgumentFromKey(name);
+  CHECK_GT(param_.inputs.count(arg), 0);
+  return param_.inputs.at(arg);
+}
+
+int64_t FusionOpContext::SoleInput() const {
+  CHECK_EQ(num_inputs(), 1);
+  return param_.inputs.begin()->second;
+}
+
+void FusionOpContext::SetOutput(const std::string& name, int64_t value) {
+  Argument arg = ArgumentFromKey(name);
+  CHECK_EQ(program()->node(value).data_type, arg.data_type());
+  // Values may only differ from the argument in the number of axes, e.g. reductions which
+  // produce a 1-d array for scalars, so insert a reshape for them.
+  if (program()->node(value).shape != arg.shape()) {
+    value = program()->Reshape(value, arg.shape());
+  }
+  outputs_[arg] = value;
+}
+
+void FusionOpContext::SetSoleOutput(int64_t value) {
+  CHECK_EQ(outputs_.size(), 0);
+  SetOutput(SoleOutputName(), value);
+}
+
+Shape FusionOpContext::InputShape(const std::string& name) const {
+  return ArgumentFromKey(name).shape();
+}
+
+Shape FusionOpContext::SoleInputShape() const {
+  CHECK_EQ(num_inputs(), 1);
+  return param_.inputs.begin()->first.shape();
+}
+
+Shape FusionOpContext::OutputShape(const std::string& name) const {
+  return ArgumentFromKey(name).shape();
+}
+
+Shape FusionOpContext::SoleOutputShape() const { return ArgumentFromKey(SoleOutputName()).shape(); }
+
+DataType FusionOpContext::InputType(const std::string& name) const {
+  return ArgumentFromKey(name).data_type();
+}
+
+DataType FusionOpContext::SoleInputType() const {
+  CHECK_EQ(num_inputs(), 1);
+  return param_.inputs.begin()->first.data_type();
+}
+
+DataType FusionOpContext::SoleOutputType() const {
+  return ArgumentFromKey(SoleOutputName()).data_type();
+}
+
+Argument FusionOpContext::ArgumentFromKey(const std::string& key) const {
+  CHECK_GT(param_.arguments.count(key), 0);
+  return param_.arguments.at(key);
+}
+
+}  // namespace fusion
+}  // namespace xrt
+}  // namespace oneflow
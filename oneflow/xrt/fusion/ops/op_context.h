@@ -0,0 +1,92 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_FUSION_OPS_OP_CONTEXT_H_
+#define ONEFLOW_XRT_FUSION_OPS_OP_CONTEXT_H_
+
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/common/protobuf.h"
+#include "oneflow/core/common/shape.h"
+#include "oneflow/xrt/argument.h"
+#include "oneflow/xrt/fusion/fusion_program.h"
+#include "oneflow/xrt/kernel/op_context.h"
+#include "oneflow/xrt/types.h"
+#include "oneflow/xrt/utility/stl.h"
+
+namespace oneflow {
+namespace xrt {
+namespace fusion {
+
+class FusionOpContext : public OpContext {
+ public:
+  struct Param {
+    // Program that the op kernels append their nodes to
+    FusionProgram* program;
+
+    XrtDevice device;
+    // Config proto related to the operator
+    const PbMessage* message;
+    // Input operands, the values are node ids of the program
+    util::Map<Argument, int64_t> inputs;
+    std::vector<std::string> output_names;
+    int num_outputs;
+
+    util::Map<std::string, Argument> arguments;
+  };
+
+  explicit FusionOpContext(const Param& param) : OpContext(*param.message), param_(param) {}
+
+  virtual ~FusionOpContext() = default;
+
+  const XrtDevice& device() const { return param_.device; }
+  FusionProgram* program() const { return param_.program; }
+
+  const std::string& SoleOutputName() const;
+
+  // Return input named `name` as a node of the program
+  int64_t Input(const std::string& name) const;
+  int64_t SoleInput() const;
+
+  int num_inputs() const { return param_.inputs.size(); }
+  int num_outputs() const { return param_.num_outputs; }
+  const util::Map<Argument, int64_t>& outputs() const { return outputs_; }
+
+  bool HasInput(const std::string& name) const;
+  // Setup the output `name` with a node of the program
+  void SetOutput(const std::string& name, int64_t value);
+  void SetSoleOutput(int64_t value);
+
+  Shape InputShape(const std::string& name) const;
+  Shape SoleInputShape() const;
+  Shape OutputShape(const std::string& name) const;
+  Shape SoleOutputShape() const;
+
+  DataType InputType(const std::string& name) const;
+  DataType SoleInputType() const;
+  DataType SoleOutputType() const;
+
+ private:
+  FusionOpContext() = delete;
+  Argument ArgumentFromKey(const std::string& key) const;
+
+  Param param_;
+  util::Map<Argument, int64_t> outputs_;
+};
+
+}  // namespace fusion
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_FUSION_OPS_OP_CONTEXT_H_
@@ -0,0 +1,59 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_FUSION_OPS_OP_KERNEL_H_
+#define ONEFLOW_XRT_FUSION_OPS_OP_KERNEL_H_
+
+#include "oneflow/xrt/fusion/ops/op_context.h"
+#include "oneflow/xrt/kernel/op_kernel.h"
+#include "oneflow/xrt/types.h"
+#include "oneflow/xrt/utility/registry.h"
+#include "oneflow/xrt/utility/stl.h"
+
+namespace oneflow {
+namespace xrt {
+namespace fusion {
+
+class FusionOpKernel : public OpKernel<FusionOpContext> {
+ public:
+  virtual void Compile(FusionOpContext* ctx) = 0;
+
+  FusionOpKernel() = default;
+  virtual ~FusionOpKernel() = default;
+};
+
+using FusionOpKernelPtr = std::shared_ptr<OpKernel<FusionOpContext>>;
+
+#define REGISTER_FUSION_OP_KERNEL(OpName, KernelType)                                 \
+  static OpKernelRegistrar<FusionOpContext> _fusion_op_kernel_##OpName##_             \
+      __attribute__((unused)) = OpKernelRegistrar<FusionOpContext>(#OpName)           \
+                                    .SetField(XrtEngine::FUSION)                      \
+                                    .SetDevice({XrtDevice::CPU_X86})                  \
+                                    .EnableTrainPhase()                               \
+                                    .ComputeInFloatingPoint()                         \
+                                    .SetFactory([]() -> OpKernel<FusionOpContext>* { \
+                                      return new KernelType;                          \
+                                    })
+
+inline FusionOpKernelPtr BuildOpKernel(const std::string& op_name) {
+  auto field = MakeXrtField(XrtDevice::CPU_X86, XrtEngine::FUSION);
+  return FusionOpKernelPtr(OpKernelBuilder<FusionOpContext>()(field, op_name));
+}
+
+}  // namespace fusion
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_FUSION_OPS_OP_KERNEL_H_
@@ -0,0 +1,39 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/fusion/ops/op_context.h"
+#include "oneflow/xrt/fusion/ops/op_kernel.h"
+
+namespace oneflow {
+namespace xrt {
+namespace fusion {
+
+template<FusionOpCode opcode>
+class ReduceOp : public FusionOpKernel {
+ public:
+  void Compile(FusionOpContext* ctx) override {
+    std::vector<int32_t> axis = ctx->Attr<std::vector<int32_t>>("axis");
+    int64_t out = ctx->program()->Reduce(opcode, ctx->SoleInput(), axis, ctx->SoleOutputShape());
+    ctx->SetSoleOutput(out);
+  }
+};
+
+REGISTER_FUSION_OP_KERNEL(ReduceSum, ReduceOp<FusionOpCode::kReduceSum>).Finalize();
+REGISTER_FUSION_OP_KERNEL(ReduceMean, ReduceOp<FusionOpCode::kReduceMean>).Finalize();
+REGISTER_FUSION_OP_KERNEL(ReduceMax, ReduceOp<FusionOpCode::kReduceMax>).Finalize();
+
+}  // namespace fusion
+}  // namespace xrt
+}  // namespace oneflow
@@ -0,0 +1,63 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/fusion/ops/op_context.h"
+#include "oneflow/xrt/fusion/ops/op_kernel.h"
+
+namespace oneflow {
+namespace xrt {
+namespace fusion {
+
+class ArgumentOp : public FusionOpKernel {
+ public:
+  void Compile(FusionOpContext* ctx) override {}
+};
+
+REGISTER_FUSION_OP_KERNEL(Argument, ArgumentOp).Finalize();
+
+template<FusionOpCode opcode>
+class ApplyUnaryOp : public FusionOpKernel {
+ public:
+  void Compile(FusionOpContext* ctx) override {
+    ctx->SetSoleOutput(ctx->program()->Unary(opcode, ctx->SoleInput()));
+  }
+};
+
+REGISTER_FUSION_OP_KERNEL(Identity, ApplyUnaryOp<FusionOpCode::kIdentity>).Finalize();
+REGISTER_FUSION_OP_KERNEL(Negative, ApplyUnaryOp<FusionOpCode::kNegative>).Finalize();
+REGISTER_FUSION_OP_KERNEL(Abs, ApplyUnaryOp<FusionOpCode::kAbs>).Finalize();
+REGISTER_FUSION_OP_KERNEL(Exp, ApplyUnaryOp<FusionOpCode::kExp>).Finalize();
+REGISTER_FUSION_OP_KERNEL(Log, ApplyUnaryOp<FusionOpCode::kLog>).Finalize();
+REGISTER_FUSION_OP_KERNEL(Sqrt, ApplyUnaryOp<FusionOpCode::kSqrt>).Finalize();
+REGISTER_FUSION_OP_KERNEL(Rsqrt, ApplyUnaryOp<FusionOpCode::kRsqrt>).Finalize();
+REGISTER_FUSION_OP_KERNEL(Square, ApplyUnaryOp<FusionOpCode::kSquare>).Finalize();
+REGISTER_FUSION_OP_KERNEL(Relu, ApplyUnaryOp<FusionOpCode::kRelu>).Finalize();
+REGISTER_FUSION_OP_KERNEL(Sigmoid, ApplyUnaryOp<FusionOpCode::kSigmoid>).Finalize();
+REGISTER_FUSION_OP_KERNEL(Tanh, ApplyUnaryOp<FusionOpCode::kTanh>).Finalize();
+REGISTER_FUSION_OP_KERNEL(Gelu, ApplyUnaryOp<FusionOpCode::kGelu>).Finalize();
+
+class CastOp : public FusionOpKernel {
+ public:
+  void Compile(FusionOpContext* ctx) override {
+    DataType dest_dtype = ctx->Attr<DataType>("dtype");
+    ctx->SetSoleOutput(ctx->program()->Cast(ctx->SoleInput(), dest_dtype));
+  }
+};
+
+REGISTER_FUSION_OP_KERNEL(Cast, CastOp).SetConvertedArguments({"in_0", "out_0"}).Finalize();
+
+}  // namespace fusion
+}  // namespace xrt
+}  // namespace oneflow
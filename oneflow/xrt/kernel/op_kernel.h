@@ -46,6 +46,8 @@ class OpKernelRegistrar {
   // Attributes releated to the op kernel.
   bool train_phase_enabled_ = false;
   bool is_optimizer_op_ = false;
+  bool compute_in_floating_point_ = false;
+  util::Set<std::string> converted_arguments_ = {};
   util::Set<std::string> mutable_variables_ = {};
 
  public:
@@ -87,11 +89,26 @@ class OpKernelRegistrar {
     return *this;
   }
 
+  // The kernel computes integers in float or double, which is exact only up to 2^24 or 2^53.
+  OpKernelRegistrar& ComputeInFloatingPoint() {
+    compute_in_floating_point_ = true;
+    return *this;
+  }
+
+  // Inputs and outputs which may be integers because the kernel only converts them from or to a
+  // floating point type, keyed by their consume or produce keys.
+  OpKernelRegistrar& SetConvertedArguments(const util::Set<std::string>& arguments) {
+    converted_arguments_ = arguments;
+    return *this;
+  }
+
   OpKernelRegistrar& Finalize() {
     util::Map<std::string, Any> attributes;
     attributes[TrainPhaseEnabledAttrName] = train_phase_enabled_;
     attributes[IsOptimizerOpAttrName] = is_optimizer_op_;
     attributes[MutableVariablesAttrName] = mutable_variables_;
+    attributes[ComputeInFloatingPointAttrName] = compute_in_floating_point_;
+    attributes[ConvertedArgumentsAttrName] = converted_arguments_;
 
     for (const auto& device : device_) {
       XrtField field = MakeXrtField(device, engine_field_);
@@ -142,6 +159,15 @@ inline const bool& IsOptimizerOp(const std::string& op_type, const XrtField& fie
   return LookupOpKernelAttr<bool>(op_type, field, IsOptimizerOpAttrName);
 }
 
+inline const bool& ComputeInFloatingPoint(const std::string& op_type, const XrtField& field) {
+  return LookupOpKernelAttr<bool>(op_type, field, ComputeInFloatingPointAttrName);
+}
+
+inline const util::Set<std::string>& ConvertedArguments(const std::string& op_type,
+                                                        const XrtField& field) {
+  return LookupOpKernelAttr<util::Set<std::string>>(op_type, field, ConvertedArgumentsAttrName);
+}
+
 }  // namespace xrt
 }  // namespace oneflow
 
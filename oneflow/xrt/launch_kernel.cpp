@@ -13,7 +13,12 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#include <algorithm>
+#include <chrono>
+
 #include "oneflow/xrt/launch_kernel.h"
+#include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/user/kernels/slice_util.h"
 #include "oneflow/xrt/api.h"
 #include "oneflow/xrt/compilation_cache.h"
 #include "oneflow/xrt/executable.h"
@@ -21,9 +26,19 @@ limitations under the License.
 #include "oneflow/xrt/platform.h"
 #include "oneflow/xrt/utility/env.h"
 
+#include "absl/strings/str_split.h"
+
 // General executable setup.
 DEFINE_int64(max_workspace_bytes, EnvToInt64(FLAGS_max_workspace_bytes, -1),
              "Maximum temporary workspace bytes.");
+// Shape bucketing setup.
+DEFINE_bool(xrt_shape_bucketing, EnvToBool(FLAGS_xrt_shape_bucketing, false),
+            "Pad the dynamic inputs of the launch ops to bucket shapes, so that inputs with "
+            "different lengths share the same executable. The padded elements are filled with "
+            "zeros, it is only valid if they do not change the valid elements of the outputs.");
+DEFINE_string(xrt_shape_buckets, EnvToString(FLAGS_xrt_shape_buckets, ""),
+              "Comma separated sizes the dynamic dimensions are rounded up to, the next power of "
+              "two is used if empty.");
 // TENSORRT executable setup.
 DEFINE_int32(max_batch_size, EnvToInt(FLAGS_max_batch_size, 1),
              "Maximum batch size for builder of TENSORRT engine.");
@@ -38,8 +53,104 @@ static Parameter BuildParameter(const Blob& blob, const std::string& name) {
   const auto& desc = blob.blob_desc();
   return Parameter(name, const_cast<void*>(blob.dptr<void>()), desc.shape(), desc.data_type());
 }
+
+static const std::vector<int64_t>& ShapeBuckets() {
+  static std::vector<int64_t> buckets = []() {
+    std::vector<int64_t> buckets;
+    for (absl::string_view bucket :
+         absl::StrSplit(FLAGS_xrt_shape_buckets, ',', absl::SkipWhitespace())) {
+      buckets.push_back(std::stoll(std::string(bucket)));
+      CHECK_GT(buckets.back(), 0) << "Invalid shape bucket " << bucket;
+    }
+    std::sort(buckets.begin(), buckets.end());
+    return buckets;
+  }();
+  return buckets;
+}
+
+// Rounds `dim` up to the nearest bucket, but never beyond the static dimension.
+static int64_t BucketDim(int64_t dim, int64_t static_dim) {
+  if (dim >= static_dim) { return static_dim; }
+  const auto& buckets = ShapeBuckets();
+  int64_t bucket = static_dim;
+  if (buckets.empty()) {
+    bucket = 1;
+    while (bucket < dim) { bucket <<= 1; }
+  } else {
+    auto it = std::lower_bound(buckets.begin(), buckets.end(), dim);
+    if (it != buckets.end()) { bucket = *it; }
+  }
+  return std::min(bucket, static_dim);
+}
+
+static Shape BucketShape(const Shape& shape, const Shape& static_shape) {
+  CHECK_EQ(shape.NumAxes(), static_shape.NumAxes());
+  DimVector dim_vec(shape.NumAxes());
+  for (int i = 0; i < shape.NumAxes(); ++i) {
+    dim_vec[i] = BucketDim(shape.At(i), static_shape.At(i));
+  }
+  return Shape(dim_vec);
+}
+
+template<DeviceType device_type, typename T>
+static void CopyBucketCornerAs(DeviceCtx* ctx, const Shape& bucket_shape, const Shape& shape,
+                               int64_t elem_bytes, bool to_bucket, const void* src, void* dst) {
+  CHECK_EQ(elem_bytes % sizeof(T), 0);
+  SliceParams params;
+  std::memset(&params, 0, sizeof(SliceParams));
+  params.ndim = shape.NumAxes();
+  CHECK_LE(params.ndim, kSliceMaxDims);
+  for (int i = 0; i < params.ndim; ++i) {
+    params.dims[i] = bucket_shape.At(i);
+    params.step[i] = 1;
+    params.size[i] = shape.At(i);
+  }
+  params.dims[params.ndim - 1] *= elem_bytes / sizeof(T);
+  params.size[params.ndim - 1] *= elem_bytes / sizeof(T);
+  if (to_bucket) {
+    SliceKernelUtil<device_type, T>::Backward(ctx, params, reinterpret_cast<const T*>(src),
+                                              reinterpret_cast<T*>(dst));
+  } else {
+    SliceKernelUtil<device_type, T>::Forward(ctx, params, reinterpret_cast<const T*>(src),
+                                             reinterpret_cast<T*>(dst));
+  }
+}
+
+// Copies between a dense tensor of `shape` and the leading corner of a dense tensor of
+// `bucket_shape`. The elements are copied as raw words, so any data type is supported.
+template<DeviceType device_type>
+static void CopyBucketCorner(DeviceCtx* ctx, const Shape& bucket_shape, const Shape& shape,
+                             DataType data_type, bool to_bucket, const void* src, void* dst) {
+  int64_t elem_bytes = SizeOf(data_type);
+  if (elem_bytes % sizeof(int64_t) == 0) {
+    CopyBucketCornerAs<device_type, int64_t>(ctx, bucket_shape, shape, elem_bytes, to_bucket,
+                                             src, dst);
+  } else if (elem_bytes % sizeof(int32_t) == 0) {
+    CopyBucketCornerAs<device_type, int32_t>(ctx, bucket_shape, shape, elem_bytes, to_bucket,
+                                             src, dst);
+  } else {
+    CopyBucketCornerAs<device_type, int8_t>(ctx, bucket_shape, shape, elem_bytes, to_bucket,
+                                            src, dst);
+  }
+}
+
+static void* ReserveBucketBuffer(Blob* bucket_buf, int64_t size, int64_t* offset) {
+  CHECK_NOTNULL(bucket_buf);
+  char* ptr = bucket_buf->mut_dptr<char>() + *offset;
+  *offset += GetCudaAlignedSize(size);
+  CHECK_LE(*offset, bucket_buf->static_shape().elem_cnt()) << "Bucket buffer is too small.";
+  return ptr;
+}
 }  // namespace xrt
 
+template<DeviceType device_type>
+XrtLaunchKernel<device_type>::~XrtLaunchKernel() {
+  if (compilation_cache_) {
+    VLOG(1) << "Compilation cache of launch op " << this->op_conf().name() << ", "
+            << compilation_cache_->stats().ToString();
+  }
+}
+
 template<DeviceType device_type>
 void BlobDescGetter<device_type>::DumpEntryBlobDescTo(
     std::unordered_map<std::string, BlobDesc>* entry_blob_desc) const {
@@ -56,20 +167,29 @@ void BlobDescGetter<device_type>::DumpEntryBlobDescTo(
 }
 
 template<DeviceType device_type>
-xrt::Executable* XrtLaunchKernel<device_type>::BuildExecutable(
-    const std::vector<xrt::Parameter>& entry_params,
-    const std::vector<xrt::Parameter>& return_params,
-    const std::vector<xrt::InputOutputAlias>& aliases, const int device_ordinal) const {
+std::shared_ptr<xrt::Executable> XrtLaunchKernel<device_type>::BuildExecutable(
+    const std::vector<xrt::Parameter>& entry_params, std::vector<xrt::Parameter>* return_params,
+    const std::vector<xrt::InputOutputAlias>& aliases, const int device_ordinal,
+    bool infer_return_shapes) const {
   if (!compilation_cache_) { compilation_cache_.reset(new xrt::CompilationCache); }
 
-  xrt::Executable* executable = nullptr;
+  std::shared_ptr<xrt::Executable> executable;
   xrt::Signature signature =
       xrt::ComputeSignature(this->op_conf().name(), device_ordinal, entry_params);
   bool force_compile = false;
-  if (!force_compile) { executable = compilation_cache_->GetRecord(signature); }
+  // Return shapes inferred for the bucketed entry shapes.
+  std::vector<Shape> return_shapes;
+  if (!force_compile) { executable = compilation_cache_->GetRecord(signature, &return_shapes); }
 
-  if (!executable) {
+  if (executable) {
+    if (infer_return_shapes && !return_shapes.empty()) {
+      for (int i = 0; i < return_params->size(); ++i) {
+        return_params->at(i).set_shape(return_shapes[i]);
+      }
+    }
+  } else {
     VLOG(2) << "Build executable for launch op " << this->op_conf().name();
+    auto start_time = std::chrono::steady_clock::now();
     const auto& launch_conf = this->op_conf().xrt_launch_conf();
     auto graph = xrt::BuildXrtGraph(launch_conf.function(), device_type, this->job_desc());
     {
@@ -85,24 +205,112 @@ xrt::Executable* XrtLaunchKernel<device_type>::BuildExecutable(
 
       std::unordered_map<std::string, BlobDesc> entry_blob_descs;
       desc_getter_.DumpEntryBlobDescTo(&entry_blob_descs);
+      // The entries may have been padded to bucket shapes.
+      for (const xrt::Parameter& param : entry_params) {
+        entry_blob_descs.at(param.name()).set_shape(param.shape());
+      }
       auto options = xrt::CreateDefaultXrtPassOptions();
       xrt::RunXrtPass("InferShape", graph.get(), options, &this->job_desc(), &parallel_ctx,
                       &parallel_desc, &sbp_signatures, &lbn2logical_blob_desc, &entry_blob_descs);
       // Update argument meta data
       // xrt::RunXrtPass("UpdateArgMetaData", graph.get(), options,
       //                 &this->job_desc());
+      if (infer_return_shapes) {
+        for (xrt::Parameter& param : *return_params) {
+          param.set_shape(entry_blob_descs.at(param.name()).shape());
+          return_shapes.push_back(param.shape());
+        }
+      }
     }
     xrt::XrtEngine engine = xrt::StringToXrtEngine(launch_conf.engine());
     xrt::XrtDevice device = xrt::DeviceTypeToXrtDevice(device_type);
     xrt::GraphCompiler compiler(this->op_conf().name(), engine, device, device_ordinal);
-    auto result = compiler.Compile(graph.get(), entry_params, return_params, aliases);
+    executable = compiler.Compile(graph.get(), entry_params, *return_params, aliases);
+    int64_t compile_time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                  std::chrono::steady_clock::now() - start_time)
+                                  .count();
     // Record new compilation result
-    compilation_cache_->Record(signature, result);
-    // Get compilation result from cache
-    executable = compilation_cache_->GetRecord(signature);
+    compilation_cache_->Record(signature, executable, compile_time_us, return_shapes);
+    VLOG(1) << "Compiled launch op " << this->op_conf().name() << " in " << compile_time_us
+            << "us, " << compilation_cache_->stats().ToString();
   }
+  return executable;
+}
 
-  return std::move(executable);
+template<DeviceType device_type>
+bool XrtLaunchKernel<device_type>::UseShapeBucketing(
+    std::function<Blob*(const std::string&)> BnInOp2Blob,
+    const std::vector<xrt::InputOutputAlias>& aliases) const {
+  // Only the elementwise functions are allowed to be bucketed when the launch op is built.
+  if (!FLAGS_xrt_shape_bucketing || !this->op_conf().xrt_launch_conf().shape_bucketing()) {
+    return false;
+  }
+  // Mutable inputs are updated in place, they can not be padded to a copy.
+  if (!aliases.empty()) { return false; }
+  bool has_dynamic_blob = false;
+  bool can_bucket = true;
+  auto CheckDynamicBlobs = [&](const PbRpf<std::string>& bns) {
+    for (const std::string& bn : bns) {
+      const Blob* blob = BnInOp2Blob(bn);
+      if (!blob->blob_desc().is_dynamic()) { continue; }
+      has_dynamic_blob = true;
+      if (blob->static_shape().NumAxes() > kSliceMaxDims) { can_bucket = false; }
+    }
+  };
+  CheckDynamicBlobs(this->op_attribute().input_bns());
+  CheckDynamicBlobs(this->op_attribute().output_bns());
+  return has_dynamic_blob && can_bucket;
+}
+
+template<DeviceType device_type>
+void XrtLaunchKernel<device_type>::PadEntryParams(
+    const KernelCtx& ctx, std::function<Blob*(const std::string&)> BnInOp2Blob,
+    std::vector<xrt::Parameter>* entry_params, int64_t* buf_offset) const {
+  const auto& input_bns = this->op_attribute().input_bns();
+  CHECK_EQ(input_bns.size(), entry_params->size());
+  for (int i = 0; i < input_bns.size(); ++i) {
+    const Blob* blob = BnInOp2Blob(input_bns[i]);
+    if (!blob->blob_desc().is_dynamic()) { continue; }
+    xrt::Parameter& param = entry_params->at(i);
+    Shape shape;
+    blob->shape().ToShape(&shape);
+    Shape bucket_shape = xrt::BucketShape(shape, blob->static_shape());
+    void* data = const_cast<void*>(blob->dptr<void>());
+    if (bucket_shape != shape) {
+      int64_t size = bucket_shape.elem_cnt() * xrt::SizeOf(param.data_type());
+      data = xrt::ReserveBucketBuffer(BnInOp2Blob("bucket_buf"), size, buf_offset);
+      Memset<device_type>(ctx.device_ctx, data, 0, size);
+      xrt::CopyBucketCorner<device_type>(ctx.device_ctx, bucket_shape, shape, param.data_type(),
+                                         /*to_bucket=*/true, blob->dptr<void>(), data);
+    }
+    param = xrt::Parameter(param.name(), data, bucket_shape, param.data_type());
+  }
+}
+
+template<DeviceType device_type>
+std::vector<int> XrtLaunchKernel<device_type>::RedirectReturnParams(
+    std::function<Blob*(const std::string&)> BnInOp2Blob,
+    std::vector<xrt::Parameter>* return_params, int64_t* buf_offset) const {
+  std::vector<int> redirected;
+  const auto& output_bns = this->op_attribute().output_bns();
+  CHECK_EQ(output_bns.size(), return_params->size());
+  for (int i = 0; i < output_bns.size(); ++i) {
+    Blob* blob = BnInOp2Blob(output_bns[i]);
+    xrt::Parameter& param = return_params->at(i);
+    Shape shape;
+    blob->shape().ToShape(&shape);
+    void* data = blob->mut_dptr<void>();
+    if (param.shape() != shape) {
+      CHECK(blob->blob_desc().is_dynamic())
+          << "Static output " << param.name() << " is inferred as " << param.shape().ToString()
+          << " for the bucket shapes.";
+      int64_t size = param.shape().elem_cnt() * xrt::SizeOf(param.data_type());
+      data = xrt::ReserveBucketBuffer(BnInOp2Blob("bucket_buf"), size, buf_offset);
+      redirected.push_back(i);
+    }
+    param = xrt::Parameter(param.name(), data, param.shape(), param.data_type());
+  }
+  return redirected;
 }
 
 template<DeviceType device_type>
@@ -164,9 +372,19 @@ void XrtLaunchKernel<device_type>::ForwardDataContent(
   MakeInputOutputAlias(entry_params, &return_params, &aliases);
   // Mapping parameter names to function input and output names.
   MappingParamsToFunctionNames(&entry_params, &return_params);
+  // Pad the dynamic entries to bucket shapes, so that the executable can be reused by the entries
+  // whose dynamic dimensions fall into the same buckets.
+  bool bucketing = UseShapeBucketing(BnInOp2Blob, aliases);
+  int64_t buf_offset = 0;
+  if (bucketing) { PadEntryParams(ctx, BnInOp2Blob, &entry_params, &buf_offset); }
   // Build executable.
-  auto executable = BuildExecutable(entry_params, return_params, aliases, device_ordinal);
+  auto executable =
+      BuildExecutable(entry_params, &return_params, aliases, device_ordinal, bucketing);
   if (!executable) { LOG(FATAL) << "Executable is built failed."; }
+  std::vector<int> redirected_returns;
+  if (bucketing) {
+    redirected_returns = RedirectReturnParams(BnInOp2Blob, &return_params, &buf_offset);
+  }
   // Run executable.
   xrt::ExecutableRunOptions run_options;
   run_options.device_ordinal = device_ordinal;
@@ -190,6 +408,15 @@ void XrtLaunchKernel<device_type>::ForwardDataContent(
   const std::vector<xrt::Parameter>& results = executable->Results();
   CHECK_EQ(results.size(), return_params.size());
   for (int i = 0; i < results.size(); ++i) { CHECK_EQ(results[i].data(), return_params[i].data()); }
+  // Mask the padded elements out of the redirected returns.
+  for (int i : redirected_returns) {
+    Blob* blob = BnInOp2Blob(this->op_attribute().output_bns(i));
+    Shape shape;
+    blob->shape().ToShape(&shape);
+    xrt::CopyBucketCorner<device_type>(ctx.device_ctx, return_params[i].shape(), shape,
+                                       return_params[i].data_type(), /*to_bucket=*/false,
+                                       return_params[i].data(), blob->mut_dptr<void>());
+  }
 }
 
 // ADD_DEFAULT_KERNEL_CREATOR(OperatorConf::kXrtLaunchConf, XrtLaunchKernel,
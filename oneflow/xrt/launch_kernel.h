@@ -46,16 +46,32 @@ template<DeviceType device_type>
 class XrtLaunchKernel : public KernelIf<device_type> {
  public:
   XrtLaunchKernel() = default;
-  virtual ~XrtLaunchKernel() {}
+  virtual ~XrtLaunchKernel();
 
  private:
   void ForwardDataContent(const KernelCtx& ctx,
                           std::function<Blob*(const std::string&)> BnInOp2Blob) const override;
 
-  xrt::Executable* BuildExecutable(const std::vector<xrt::Parameter>& entry_params,
-                                   const std::vector<xrt::Parameter>& return_params,
-                                   const std::vector<xrt::InputOutputAlias>& aliases,
-                                   const int device_ordinal) const;
+  // Returns the cached executable for the shapes of `entry_params`, or compiles a new one. The
+  // shapes of `return_params` are replaced by the inferred ones if `infer_return_shapes` is true.
+  std::shared_ptr<xrt::Executable> BuildExecutable(
+      const std::vector<xrt::Parameter>& entry_params, std::vector<xrt::Parameter>* return_params,
+      const std::vector<xrt::InputOutputAlias>& aliases, const int device_ordinal,
+      bool infer_return_shapes) const;
+
+  // Whether the dynamic entries should be padded to the bucket shapes for this run.
+  bool UseShapeBucketing(std::function<Blob*(const std::string&)> BnInOp2Blob,
+                         const std::vector<xrt::InputOutputAlias>& aliases) const;
+
+  // Pads the dynamic entries to their bucket shapes in the `bucket_buf` blob.
+  void PadEntryParams(const KernelCtx& ctx, std::function<Blob*(const std::string&)> BnInOp2Blob,
+                      std::vector<xrt::Parameter>* entry_params, int64_t* buf_offset) const;
+
+  // Redirects the returns whose bucket shapes differ from the runtime shapes of the output blobs
+  // to the `bucket_buf` blob, and returns their indices.
+  std::vector<int> RedirectReturnParams(std::function<Blob*(const std::string&)> BnInOp2Blob,
+                                        std::vector<xrt::Parameter>* return_params,
+                                        int64_t* buf_offset) const;
 
   void MakeInputOutputAlias(                            // NOLINT
       const std::vector<xrt::Parameter>& entry_params,  // NOLINT
@@ -21,6 +21,8 @@ limitations under the License.
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 
+DECLARE_bool(xrt_shape_bucketing);
+
 namespace oneflow {
 
 void XrtLaunchOp::InitFromOpConf() {
@@ -37,6 +39,8 @@ void XrtLaunchOp::InitFromOpConf() {
     EnrollInputBn(absl::StrCat("in_", i))->set_is_mutable(mutability);
   }
   if (outputs_num > 0) { EnrollRepeatedOutputBn("out"); }
+  // Holds the dynamic inputs and outputs padded to the bucket shapes.
+  if (FLAGS_xrt_shape_bucketing && launch_conf.shape_bucketing()) { EnrollTmpBn("bucket_buf"); }
 }
 
 Maybe<void> XrtLaunchOp::InferLogicalOutBlobDescs(
@@ -107,6 +111,30 @@ Maybe<void> XrtLaunchOp::InferOutBlobDescs(
   return Maybe<void>::Ok();
 }
 
+Maybe<void> XrtLaunchOp::InferInternalBlobDescs(
+    const std::function<BlobDesc*(const std::string&)>& GetBlobDesc4BnInOp,
+    const ParallelContext* parallel_ctx, const JobDesc* job_desc) const {
+  if (!FLAGS_xrt_shape_bucketing || !op_conf().xrt_launch_conf().shape_bucketing()) {
+    return Maybe<void>::Ok();
+  }
+  // A bucket shape is never larger than the static shape.
+  int64_t buf_size = 0;
+  auto AddDynamicBlobSize = [&](const PbRpf<std::string>& bns) {
+    for (const std::string& bn : bns) {
+      const BlobDesc* blob_desc = GetBlobDesc4BnInOp(bn);
+      if (blob_desc->is_dynamic()) {
+        buf_size += GetCudaAlignedSize(blob_desc->ByteSizeOfBlobBody());
+      }
+    }
+  };
+  AddDynamicBlobSize(this->input_bns());
+  AddDynamicBlobSize(this->output_bns());
+  BlobDesc* bucket_buf = GetBlobDesc4BnInOp("bucket_buf");
+  bucket_buf->mut_shape() = Shape({buf_size});
+  bucket_buf->set_data_type(DataType::kChar);
+  return Maybe<void>::Ok();
+}
+
 Maybe<void> XrtLaunchOp::InferSbpSignature(
     SbpSignature* sbp_signature, const SbpSignature& sbp_sig_conf,
     const std::function<int32_t(const SbpSignature&)>& CalcOrderValue4SbpSig,
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/xrt/node_util.h"
+#include "oneflow/core/common/data_type.h"
 #include "oneflow/xrt/kernel/op_kernel.h"
 #include "oneflow/xrt/types.h"
 #include "oneflow/xrt/utility/message_attr.h"
@@ -31,10 +32,46 @@ const PbMessage* OpMessage(const XrtNode* node) {
   return message;
 }
 
+namespace {
+
+// A kernel computing in floating point only takes the integer values it converts from or to a
+// floating point one, so it never does integer arithmetic, which is not exact above 2^24.
+bool IsComputedInFloatingPoint(const XrtNode* node, const util::Set<std::string>& converted) {
+  bool reads_integral = false;
+  bool writes_integral = false;
+  for (const XrtEdge* edge : node->in_edges()) {
+    if (edge->IsControlEdge() || !edge->HasAttr("data_type")) { continue; }
+    if (IsFloatingDataType(edge->Attr<DataType>("data_type"))) { continue; }
+    if (converted.count(edge->argument().meta_data().consume_key) == 0) { return false; }
+    reads_integral = true;
+  }
+  for (const XrtEdge* edge : node->out_edges()) {
+    if (edge->IsControlEdge() || !edge->HasAttr("data_type")) { continue; }
+    if (IsFloatingDataType(edge->Attr<DataType>("data_type"))) { continue; }
+    if (converted.count(edge->argument().meta_data().produce_key) == 0) { return false; }
+    writes_integral = true;
+  }
+  // Converting an integer to an integer would go through the floating point type.
+  return !(reads_integral && writes_integral);
+}
+
+const util::Set<std::string>& ElementwiseOpTypes() {
+  // Broadcast ops are left out, since their static operands can not follow the padded shapes.
+  static util::Set<std::string> op_types = {
+      "Identity", "Cast",  "Tanh",     "TanhGrad",  "Gelu",      "GeluGrad", "Sigmoid",
+      "Relu",     "Rsqrt", "Sqrt",     "Square",    "Exp",       "Log",      "Abs",
+      "Negative", "Add",   "Multiply", "ScalarAdd", "ScalarMul", "LeakyRelu"};
+  return op_types;
+}
+
+}  // namespace
+
 bool IsCompiledNode(const XrtNode* node, const XrtEngine& engine, const bool train_phase) {
   auto field = MakeXrtField(node->device(), engine);
   return OpKernelRegistered(node->type(), field)
-         && (!train_phase || TrainPhaseEnabled(node->type(), field));
+         && (!train_phase || TrainPhaseEnabled(node->type(), field))
+         && (!ComputeInFloatingPoint(node->type(), field)
+             || IsComputedInFloatingPoint(node, ConvertedArguments(node->type(), field)));
 }
 
 bool IsOptimizerNode(const XrtNode* node, const XrtEngine& engine) {
@@ -42,6 +79,10 @@ bool IsOptimizerNode(const XrtNode* node, const XrtEngine& engine) {
   return IsOptimizerOp(node->type(), field);
 }
 
+bool IsElementwiseNode(const XrtNode* node) {
+  return ElementwiseOpTypes().count(node->type()) > 0;
+}
+
 bool IsNodeInput(const XrtNode* node, const Argument& argument) {
   for (XrtEdge* edge : node->in_edges()) {
     if (edge->argument() == argument) { return true; }
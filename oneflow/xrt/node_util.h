@@ -27,6 +27,9 @@ const PbMessage* OpMessage(const XrtNode* node);
 
 bool IsCompiledNode(const XrtNode* node, const XrtEngine& engine, const bool train_phase);
 bool IsOptimizerNode(const XrtNode* node, const XrtEngine& engine);
+// Whether each output element of the node only depends on the input elements at the same index,
+// so that padding the inputs along any axis leaves the unpadded part of the outputs unchanged.
+bool IsElementwiseNode(const XrtNode* node);
 
 bool IsNodeInput(const XrtNode* node, const Argument& argument);
 bool IsNodeOutput(const XrtNode* node, const Argument& argument);
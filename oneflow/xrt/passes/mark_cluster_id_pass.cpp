@@ -203,6 +203,8 @@ void MarkClusterIdPass::Run(XrtGraph* graph, const XrtPassOptions& options) {
     ClusteringSubgraphs(clustering_options, XrtEngine::TENSORRT);
     ClusteringSubgraphs(clustering_options, XrtEngine::XLA);
   }
+  // The fusion engine only takes the nodes left over by the third party engines.
+  ClusteringSubgraphs(clustering_options, XrtEngine::FUSION);
 
   RemoveInvalidClusterNodes(clustering_options);
   RerankClusterIds();
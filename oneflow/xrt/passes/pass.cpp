@@ -23,6 +23,7 @@ bool CheckUseXrtEngine(const ClusteringOptions& options, const XrtEngine& engine
     switch (engine) {
       case XrtEngine::XLA: return XrtEngineOptionBit::kUseXlaJit;
       case XrtEngine::TENSORRT: return XrtEngineOptionBit::kUseTensorRT;
+      case XrtEngine::FUSION: return XrtEngineOptionBit::kUseFusion;
       default: return XrtEngineOptionBit::kUseDefault;
     }
   }();
@@ -29,6 +29,7 @@ limitations under the License.
 #include "absl/strings/str_split.h"
 #include "glog/logging.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -234,6 +235,7 @@ void FoldSubgraphBuilder::BuildXrtLaunchOps() {
       switch (engine) {
         case XrtEngine::XLA: return "XLA";
         case XrtEngine::TENSORRT: return "TENSORRT";
+        case XrtEngine::FUSION: return "FUSION";
         default: LOG(FATAL) << "Not supported engine " << engine; return "";
       }
     }());
@@ -245,6 +247,12 @@ void FoldSubgraphBuilder::BuildXrtLaunchOps() {
                   launch_conf->mutable_function());
     // Mark the launch op whether it is model update op or not.
     launch_conf->set_model_update(is_model_update);
+    // Padding the dynamic inputs with zeros would change the results of the reductions,
+    // normalizations and the like over the padded axes, so only elementwise functions are
+    // bucketed.
+    launch_conf->set_shape_bucketing(std::all_of(
+        folded_nodes_[i].begin(), folded_nodes_[i].end(),
+        [](const XrtNode* sub_node) { return IsElementwiseNode(sub_node); }));
 
     for (const auto& arg_proto : launch_conf->function().argument()) {
       std::string arg_value = arg_proto.value();